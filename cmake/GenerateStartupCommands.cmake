@@ -7,6 +7,9 @@ set(EXTENSIONS
     command_logger
     js_command_wrappers
     mcp_server
+    memory_tools
+    native_visualizers
+    sampling_profiler
     step_through_mojo
 )
 
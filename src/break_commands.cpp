@@ -7,6 +7,7 @@
 #include <vector>
 
 #include "debug_event_callbacks.h"
+#include "trace.h"
 #include "utils.h"
 
 utils::DebugInterfaces g_debug;
@@ -29,6 +30,7 @@ class BreakEventHandler : public DebugEventCallbacks {
       if (argument == DEBUG_STATUS_BREAK && !g_commands.empty()) {
         // Execute all registered commands
         for (const auto& cmd : g_commands) {
+          TRACE_SPAN("Break command", cmd);
           g_debug.control->Execute(DEBUG_OUTPUT_NORMAL, cmd.c_str(),
                                    DEBUG_EXECUTE_DEFAULT);
         }
@@ -4,7 +4,7 @@
 #include "breakpoint.h"
 
 #include <regex>
-#include "utils.h"
+#include "string_utils.h"
 
 Breakpoint::Breakpoint(const std::string& breakpoint_string) {
   ParseBreakpointString(breakpoint_string);
@@ -3,10 +3,11 @@
 
 #include "breakpoint_list.h"
 
+#include <fstream>
 #include <set>
 #include <sstream>
 
-#include "utils.h"
+#include "string_utils.h"
 
 BreakpointList::BreakpointList(const std::string& delimited_breakpoints,
                                const std::string& default_module_name,
@@ -258,6 +259,39 @@ BreakpointList BreakpointList::FromJson(const JSON& json) {
   return breakpoint_list;
 }
 
+std::vector<BreakpointList> BreakpointList::ReadFromFile(
+    const std::string& path) {
+  std::vector<BreakpointList> lists;
+  std::ifstream file(path);
+  if (!file.is_open()) {
+    return lists;
+  }
+
+  JSON json;
+  file >> json;
+  if (json.is_array()) {
+    for (const auto& item : json) {
+      lists.push_back(FromJson(item));
+    }
+  }
+  return lists;
+}
+
+bool BreakpointList::WriteToFile(const std::vector<BreakpointList>& lists,
+                                 const std::string& path) {
+  JSON json = JSON::array();
+  for (const auto& list : lists) {
+    json.push_back(list.ToJson());
+  }
+
+  std::ofstream file(path);
+  if (!file.is_open()) {
+    return false;
+  }
+  file << json.dump(4);
+  return true;
+}
+
 BreakpointList BreakpointList::CombineBreakpointLists(
     const BreakpointList& list1,
     const BreakpointList& list2) {
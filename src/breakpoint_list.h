@@ -54,6 +54,13 @@ class BreakpointList {
   JSON ToJson() const;
   static BreakpointList FromJson(const JSON& json);
 
+  // The breakpoint history file is a JSON array of lists. A file which
+  // doesn't exist has no lists. Throws if the file isn't valid JSON.
+  static std::vector<BreakpointList> ReadFromFile(const std::string& path);
+  // Returns false if the file can't be opened for writing.
+  static bool WriteToFile(const std::vector<BreakpointList>& lists,
+                          const std::string& path);
+
   static BreakpointList CombineBreakpointLists(const BreakpointList& list1,
                                                const BreakpointList& list2);
 
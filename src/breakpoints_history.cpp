@@ -4,15 +4,16 @@
 #include <dbgeng.h>
 #include <windows.h>
 #include <algorithm>
-#include <fstream>
 #include <regex>
 #include <set>
+#include <sstream>
 #include <string>
 #include <vector>
 
 #include "breakpoint_list.h"
 #include "debug_event_callbacks.h"
 #include "json.hpp"
+#include "source_search.h"
 #include "utils.h"
 
 using JSON = nlohmann::json;
@@ -89,24 +90,10 @@ void InitializeBreakpoints() {
         utils::GetCurrentExtensionDir() + "\\breakpoints_history.json";
   }
 
-  std::ifstream file(g_breakpoint_lists_file);
-  if (file.is_open()) {
-    try {
-      JSON json;
-      file >> json;
-      file.close();
-
-      g_breakpoint_lists.clear();
-      if (json.is_array()) {
-        for (const auto& item : json) {
-          g_breakpoint_lists.push_back(BreakpointList::FromJson(item));
-        }
-      }
-    } catch (const std::exception& e) {
-      DERROR("Error loading breakpoint history: %s\n", e.what());
-      g_breakpoint_lists.clear();
-    }
-  } else {
+  try {
+    g_breakpoint_lists = BreakpointList::ReadFromFile(g_breakpoint_lists_file);
+  } catch (const std::exception& e) {
+    DERROR("Error loading breakpoint history: %s\n", e.what());
     g_breakpoint_lists.clear();
   }
 }
@@ -118,16 +105,8 @@ void WriteBreakpointsToFile() {
   }
 
   try {
-    JSON json = JSON::array();
-    for (const auto& bp_list : g_breakpoint_lists) {
-      json.push_back(bp_list.ToJson());
-    }
-
-    std::ofstream file(g_breakpoint_lists_file);
-    if (file.is_open()) {
-      file << json.dump(4);
-      file.close();
-    } else {
+    if (!BreakpointList::WriteToFile(g_breakpoint_lists,
+                                     g_breakpoint_lists_file)) {
       DERROR("Error: Cannot open file for writing: %s\n",
              g_breakpoint_lists_file.c_str());
     }
@@ -520,6 +499,23 @@ BreakpointList GetBreakpointListFromArgs(const std::string input_str,
   return breakpoint_list;
 }
 
+// Moves the breakpoint list to the top of the history,
+// removing any identical list, and saves the history.
+void AddToBreakpointsHistory(const BreakpointList& breakpoint_list) {
+  // Remove any identical breakpoint list
+  std::vector<BreakpointList> new_list;
+  for (const auto& bl : g_breakpoint_lists) {
+    if (!bl.IsEqualTo(breakpoint_list)) {
+      new_list.push_back(bl);
+    }
+  }
+
+  // Add the current list to the top
+  new_list.insert(new_list.begin(), breakpoint_list);
+  g_breakpoint_lists = new_list;
+  WriteBreakpointsToFile();
+}
+
 void SetBreakpointsInternal(const std::string& breakpoints_delimited,
                             const std::string& new_module_name,
                             const std::string& new_tag,
@@ -534,19 +530,7 @@ void SetBreakpointsInternal(const std::string& breakpoints_delimited,
   }
 
   if (run_commands) {
-    // Update the history
-    // Remove any identical breakpoint list
-    std::vector<BreakpointList> new_list;
-    for (const auto& bl : g_breakpoint_lists) {
-      if (!bl.IsEqualTo(breakpoint_list)) {
-        new_list.push_back(bl);
-      }
-    }
-
-    // Add the current list to the top
-    new_list.insert(new_list.begin(), breakpoint_list);
-    g_breakpoint_lists = new_list;
-    WriteBreakpointsToFile();
+    AddToBreakpointsHistory(breakpoint_list);
   }
 
   if (all_processes) {
@@ -1329,6 +1313,166 @@ Notes:
   return S_OK;
 }
 
+HRESULT CALLBACK BreakOnPatternInternal(IDebugClient* client,
+                                        const char* args) {
+  if (args && strcmp(args, "?") == 0) {
+    const char* help_text = R"(
+BreakOnPattern Usage:
+
+Searches the source files under a directory for lines matching a regular
+expression and adds a source line breakpoint for every matching line to
+the breakpoint history as a single breakpoint list.
+
+Parameters:
+- /m module: The module to set the breakpoints in (default: chrome.dll)
+- /t tag: The tag of the breakpoint list (default: the regular expression)
+- /x extensions: Comma separated file extensions to search
+                 (default: .c,.cc,.cpp,.cxx,.h,.hh,.hpp,.hxx,.inc,.inl,.ipp,.m,.mm)
+- /n count: The maximum number of breakpoints (default: 100)
+- /s: Set the breakpoints in the current process after adding them to history
+- directory: The root of the source tree to search (e.g. D:\cs\src\media)
+- regex: An ECMAScript regular expression matched against each line
+
+Note: If an input argument contains a space then it needs to be
+      enclosed in single quotes.
+
+Examples:
+- !BreakOnPattern D:\cs\src\media 'void \w+::OnError\('
+    - Add breakpoints on the definitions of all of the OnError methods
+- !BreakOnPattern /s /m media.dll D:\cs\src\media\gpu NOTREACHED
+    - Add breakpoints on every NOTREACHED in media\gpu and set them
+- !BreakOnPattern /x .mojom,.cc /n 20 D:\cs\src\content Bind\w+Receiver
+    - Limit the search to .mojom and .cc files and at most 20 breakpoints
+
+Notes:
+- Directories starting with '.' (e.g. .git) are skipped
+- The breakpoints can be set later with !SetBreakpoints <index>
+)";
+    DOUT("%s\n", help_text);
+    return S_OK;
+  }
+
+  std::vector<std::string> parsed_args = utils::ParseCommandLine(args);
+
+  std::string module_name;
+  std::string tag;
+  std::string directory;
+  std::string pattern;
+  bool set_breakpoints = false;
+  source_search::SearchOptions options;
+  options.max_matches = 100;
+
+  for (size_t i = 0; i < parsed_args.size(); i++) {
+    const std::string& arg = parsed_args[i];
+    bool has_value = i + 1 < parsed_args.size();
+
+    if (arg == "/m" && has_value) {
+      module_name = parsed_args[++i];
+    } else if (arg == "/t" && has_value) {
+      tag = parsed_args[++i];
+    } else if (arg == "/x" && has_value) {
+      std::string extensions = parsed_args[++i];
+      std::replace(extensions.begin(), extensions.end(), ',', ' ');
+      std::istringstream stream(extensions);
+      options.extensions.clear();
+      for (std::string extension; stream >> extension;) {
+        options.extensions.push_back(extension[0] == '.' ? extension
+                                                         : "." + extension);
+      }
+    } else if (arg == "/n" && has_value) {
+      const std::string& value = parsed_args[++i];
+      unsigned long count = 0;
+      try {
+        if (utils::IsWholeNumber(value)) {
+          count = std::stoul(value);
+        }
+      } catch (const std::exception&) {
+        count = 0;
+      }
+      if (count == 0) {
+        DERROR("Error: Invalid count: %s\n", value.c_str());
+        return E_INVALIDARG;
+      }
+      options.max_matches = count;
+    } else if (arg == "/s") {
+      set_breakpoints = true;
+    } else if (directory.empty()) {
+      directory = arg;
+    } else if (pattern.empty()) {
+      pattern = arg;
+    } else {
+      DERROR("Error: Unexpected argument: %s. Use !BreakOnPattern ? for help.\n",
+             arg.c_str());
+      return E_INVALIDARG;
+    }
+  }
+
+  if (directory.empty() || pattern.empty()) {
+    DERROR("Error: A directory and a regular expression are required.\n");
+    return E_INVALIDARG;
+  }
+
+  if (module_name.empty()) {
+    module_name = "chrome.dll";
+    DERROR("No module name provided. Using the default: \"chrome.dll\"\n");
+  }
+
+  DOUT("Searching %s for '%s'...\n", directory.c_str(), pattern.c_str());
+
+  source_search::SearchResult result =
+      source_search::Search(directory, pattern, options);
+  if (!result.error.empty()) {
+    DERROR("Error: %s\n", result.error.c_str());
+    return E_FAIL;
+  }
+
+  DOUT("Searched %u files (%u KB).\n",
+       static_cast<ULONG>(result.files_searched),
+       static_cast<ULONG>(result.bytes_searched / 1024));
+
+  if (result.matches.empty()) {
+    DOUT("No matching lines found.\n");
+    return S_OK;
+  }
+
+  BreakpointList breakpoint_list;
+  breakpoint_list.SetTag(tag.empty() ? pattern : tag);
+
+  DOUT("\nMatching lines:\n");
+  for (const source_search::SourceMatch& match : result.matches) {
+    DOUT("\t%s:%d: %s\n", match.path.c_str(), match.line,
+         utils::Trim(match.text).c_str());
+
+    Breakpoint breakpoint(match.path + ":" + std::to_string(match.line),
+                          module_name);
+    if (!breakpoint.IsValid()) {
+      DERROR("Error: Unable to create a breakpoint for %s:%d\n",
+             match.path.c_str(), match.line);
+      return E_FAIL;
+    }
+    breakpoint_list.AddBreakpoint(breakpoint);
+  }
+
+  if (result.truncated) {
+    DERROR(
+        "\nWarning: Stopped after %u matches. Use /n to allow more "
+        "breakpoints.\n",
+        static_cast<ULONG>(options.max_matches));
+  }
+
+  AddToBreakpointsHistory(breakpoint_list);
+  DOUT("\nAdded %u breakpoint(s) to history as index 0.\n",
+       static_cast<ULONG>(breakpoint_list.GetBreakpointsCount()));
+
+  if (set_breakpoints) {
+    SetBreakpointsInternal("0", "", "", false);
+  } else {
+    DOUT("Use !SetBreakpoints 0 to set them.\n");
+  }
+
+  return S_OK;
+}
+
 // Initialize the extension
 HRESULT CALLBACK DebugExtensionInitializeInternal(PULONG version,
                                                   PULONG flags) {
@@ -1398,4 +1542,9 @@ __declspec(dllexport) HRESULT CALLBACK
 SetBreakpointListsFile(IDebugClient* client, const char* args) {
   return SetBreakpointListsFileInternal(client, args);
 }
+
+__declspec(dllexport) HRESULT CALLBACK BreakOnPattern(IDebugClient* client,
+                                                      const char* args) {
+  return BreakOnPatternInternal(client, args);
+}
 }
@@ -0,0 +1,188 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "call_tree.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+
+#include "json.hpp"
+
+using JSON = nlohmann::json;
+
+namespace stack_sampler {
+
+namespace {
+
+// A call tree keyed by name which is built from one or more address
+// keyed call trees when formatting the output.
+struct NamedNode {
+  ULONG64 value = 0;
+  std::map<std::string, std::unique_ptr<NamedNode>> children;
+
+  NamedNode* GetChild(const std::string& name) {
+    std::unique_ptr<NamedNode>& child = children[name];
+    if (!child) {
+      child = std::make_unique<NamedNode>();
+    }
+    return child.get();
+  }
+};
+
+void BuildNamedTree(const std::vector<LabeledTree>& trees,
+                    const Symbolizer& symbolizer,
+                    NamedNode& root) {
+  for (const auto& [label, tree] : trees) {
+    tree->ForEachStack(
+        [&](const std::vector<ULONG64>& frames, ULONG64 count) {
+          root.value += count;
+          NamedNode* node = &root;
+          if (!label.empty()) {
+            node = node->GetChild(label);
+            node->value += count;
+          }
+          for (ULONG64 address : frames) {
+            node = node->GetChild(symbolizer(address));
+            node->value += count;
+          }
+        });
+  }
+}
+
+JSON NamedNodeToJson(const std::string& name, const NamedNode& node) {
+  JSON children = JSON::array();
+  for (const auto& [child_name, child] : node.children) {
+    children.push_back(NamedNodeToJson(child_name, *child));
+  }
+  return JSON{{"name", name}, {"value", node.value}, {"children", children}};
+}
+
+}  // namespace
+
+CallTree::CallTree() : nodes_(1) {}
+
+void CallTree::AddStack(const std::vector<ULONG64>& frames, ULONG64 count) {
+  size_t index = 0;
+  nodes_[0].total_count += count;
+
+  for (ULONG64 address : frames) {
+    auto it = nodes_[index].children.find(address);
+    size_t child_index = 0;
+    if (it != nodes_[index].children.end()) {
+      child_index = it->second;
+    } else {
+      child_index = nodes_.size();
+      nodes_[index].children.emplace(address, child_index);
+
+      // This can reallocate nodes_ so don't hold
+      // on to any references to the nodes.
+      Node node;
+      node.address = address;
+      node.parent = index;
+      nodes_.push_back(std::move(node));
+    }
+
+    index = child_index;
+    nodes_[index].total_count += count;
+  }
+
+  nodes_[index].self_count += count;
+}
+
+std::vector<ULONG64> CallTree::GetAddresses() const {
+  std::vector<ULONG64> addresses;
+  addresses.reserve(nodes_.size() - 1);
+  for (size_t i = 1; i < nodes_.size(); i++) {
+    addresses.push_back(nodes_[i].address);
+  }
+
+  std::sort(addresses.begin(), addresses.end());
+  addresses.erase(std::unique(addresses.begin(), addresses.end()),
+                  addresses.end());
+  return addresses;
+}
+
+void CallTree::ForEachStack(
+    const std::function<void(const std::vector<ULONG64>& frames,
+                             ULONG64 count)>& visitor) const {
+  std::vector<ULONG64> frames;
+  for (size_t i = 1; i < nodes_.size(); i++) {
+    if (nodes_[i].self_count == 0) {
+      continue;
+    }
+
+    // Walk up to the root to reconstruct the stack.
+    frames.clear();
+    for (size_t index = i; index != 0; index = nodes_[index].parent) {
+      frames.push_back(nodes_[index].address);
+    }
+    std::reverse(frames.begin(), frames.end());
+    visitor(frames, nodes_[i].self_count);
+  }
+}
+
+void CallTree::Clear() {
+  nodes_.clear();
+  nodes_.resize(1);
+}
+
+std::string FormatFoldedStacks(const std::vector<LabeledTree>& trees,
+                               const Symbolizer& symbolizer) {
+  // Stacks which only differ by the offsets within
+  // the functions are merged once they are named.
+  std::map<std::string, ULONG64> folded;
+  for (const auto& [label, tree] : trees) {
+    tree->ForEachStack(
+        [&](const std::vector<ULONG64>& frames, ULONG64 count) {
+          std::string line = label;
+          for (ULONG64 address : frames) {
+            if (!line.empty()) {
+              line += ';';
+            }
+            line += symbolizer(address);
+          }
+          folded[line] += count;
+        });
+  }
+
+  std::string output;
+  for (const auto& [line, count] : folded) {
+    output += line + " " + std::to_string(count) + "\n";
+  }
+  return output;
+}
+
+std::string FormatFlameGraphJson(const std::vector<LabeledTree>& trees,
+                                 const Symbolizer& symbolizer) {
+  NamedNode root;
+  BuildNamedTree(trees, symbolizer, root);
+  return NamedNodeToJson("all", root).dump();
+}
+
+std::vector<std::pair<std::string, ULONG64>> GetTopFunctions(
+    const std::vector<LabeledTree>& trees,
+    const Symbolizer& symbolizer,
+    size_t n) {
+  std::map<std::string, ULONG64> counts;
+  for (const auto& [label, tree] : trees) {
+    tree->ForEachStack(
+        [&](const std::vector<ULONG64>& frames, ULONG64 count) {
+          if (!frames.empty()) {
+            counts[symbolizer(frames.back())] += count;
+          }
+        });
+  }
+
+  std::vector<std::pair<std::string, ULONG64>> top(counts.begin(),
+                                                   counts.end());
+  std::stable_sort(
+      top.begin(), top.end(),
+      [](const auto& a, const auto& b) { return a.second > b.second; });
+  if (top.size() > n) {
+    top.resize(n);
+  }
+  return top;
+}
+
+}  // namespace stack_sampler
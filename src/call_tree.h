@@ -0,0 +1,89 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef CALL_TREE_H_
+#define CALL_TREE_H_
+
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "dbgeng_shim.h"
+
+// The aggregation and output formats of the stack sampler. This
+// doesn't use the debugger engine so it is part of the portable
+// core library.
+namespace stack_sampler {
+
+// A trie of call stacks keyed by instruction address. Each node counts
+// the number of stacks which pass through it (total) and the number of
+// stacks which end at it (self).
+class CallTree {
+ public:
+  struct Node {
+    ULONG64 address = 0;
+    ULONG64 self_count = 0;
+    ULONG64 total_count = 0;
+    size_t parent = 0;
+    std::unordered_map<ULONG64, size_t> children;
+  };
+
+  CallTree();
+
+  // Adds a stack. frames[0] is the outermost caller and
+  // frames.back() is the frame which was executing.
+  void AddStack(const std::vector<ULONG64>& frames, ULONG64 count = 1);
+
+  ULONG64 GetTotalCount() const { return nodes_[0].total_count; }
+
+  // The number of nodes not including the root.
+  size_t GetNodeCount() const { return nodes_.size() - 1; }
+
+  // Returns the unique addresses in the tree (sorted).
+  std::vector<ULONG64> GetAddresses() const;
+
+  // Calls visitor for every distinct stack with its count. The frames
+  // are passed outermost caller first.
+  void ForEachStack(
+      const std::function<void(const std::vector<ULONG64>& frames,
+                               ULONG64 count)>& visitor) const;
+
+  void Clear();
+
+ private:
+  // nodes_[0] is the root which has no address.
+  std::vector<Node> nodes_;
+};
+
+// Maps an address to the name used in the output. Addresses which map
+// to the same name (e.g. different offsets within the same function)
+// are merged.
+using Symbolizer = std::function<std::string(ULONG64 address)>;
+
+// A call tree with an optional label which is output as the outermost
+// frame (e.g. the thread when the samples are grouped by thread).
+using LabeledTree = std::pair<std::string, const CallTree*>;
+
+// Formats the trees in the folded stacks format used by flamegraph.pl
+// and speedscope ("frame;frame;frame count" per line, outermost first).
+std::string FormatFoldedStacks(const std::vector<LabeledTree>& trees,
+                               const Symbolizer& symbolizer);
+
+// Formats the trees as nested flame graph JSON nodes
+// ({"name": ..., "value": ..., "children": [...]}) as used by
+// d3-flame-graph. The root node is named "all".
+std::string FormatFlameGraphJson(const std::vector<LabeledTree>& trees,
+                                 const Symbolizer& symbolizer);
+
+// Returns the n names with the most samples where they were
+// the executing frame, sorted by count.
+std::vector<std::pair<std::string, ULONG64>> GetTopFunctions(
+    const std::vector<LabeledTree>& trees,
+    const Symbolizer& symbolizer,
+    size_t n);
+
+}  // namespace stack_sampler
+
+#endif  // CALL_TREE_H_
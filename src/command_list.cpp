@@ -3,7 +3,7 @@
 
 #include "command_list.h"
 
-#include "utils.h"
+#include "string_utils.h"
 
 CommandList::CommandList(std::vector<std::string> commands,
                          int source_line,
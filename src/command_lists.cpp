@@ -13,6 +13,7 @@
 
 #include "command_list.h"
 #include "json.hpp"
+#include "trace.h"
 #include "utils.h"
 
 using JSON = nlohmann::json;
@@ -243,6 +244,7 @@ CommandList* FindCommandList(const std::string& name_or_line) {
 }
 
 bool RunCommandList(const CommandList* cmd_list) {
+  TRACE_SPAN("RunCommandList", cmd_list->GetName());
   g_enable_break_event_handler_output = false;
   bool error = false;
   std::string last_command;
@@ -265,6 +267,7 @@ bool RunCommandList(const CommandList* cmd_list) {
       DOUT("Executing command: %s\n", command_to_execute.c_str());
     }
 
+    TRACE_SPAN("Command list command", command_to_execute);
     HRESULT hr = g_debug.control->Execute(DEBUG_OUTCTL_ALL_CLIENTS,
                                           command_to_execute.c_str(),
                                           DEBUG_EXECUTE_DEFAULT);
@@ -7,6 +7,7 @@
 #include <regex>
 #include <string>
 
+#include "trace.h"
 #include "utils.h"
 
 utils::DebugInterfaces g_debug;
@@ -212,6 +213,89 @@ HRESULT CALLBACK StopCommandLoggingInternal(IDebugClient* client,
   return S_OK;
 }
 
+HRESULT CALLBACK StartTraceInternal(IDebugClient* client, const char* args) {
+  if (args && args[0] == '?' && args[1] == '\0') {
+    DOUT(
+        "StartTrace - Begin recording trace spans in all extensions\n\n"
+        "Usage: !StartTrace\n\n"
+        "This command takes no parameters.\n"
+        "Previously recorded spans are dropped. The spans of the last %zu\n"
+        "events of each thread are kept.\n"
+        "Use !StopTrace to stop recording and !ExportTrace to save the trace.\n\n",
+        trace::kEventsPerThread);
+    return S_OK;
+  }
+
+  trace::ClearAllModules();
+  trace::SetEnabledInAllModules(true);
+
+  DOUT("Tracing started.\n");
+  return S_OK;
+}
+
+HRESULT CALLBACK StopTraceInternal(IDebugClient* client, const char* args) {
+  if (args && args[0] == '?' && args[1] == '\0') {
+    DOUT(
+        "StopTrace - Stop recording trace spans in all extensions\n\n"
+        "Usage: !StopTrace\n\n"
+        "This command takes no parameters.\n"
+        "The recorded spans are kept until the next !StartTrace.\n\n");
+    return S_OK;
+  }
+
+  trace::SetEnabledInAllModules(false);
+
+  trace::TraceStats stats = trace::GetStatsOfAllModules();
+  DOUT("Tracing stopped. %llu events on %zu threads (%llu dropped).\n",
+       stats.events, stats.threads, stats.dropped);
+  return S_OK;
+}
+
+HRESULT CALLBACK ExportTraceInternal(IDebugClient* client, const char* args) {
+  if (args && args[0] == '?' && args[1] == '\0') {
+    DOUT(
+        "ExportTrace - Save the recorded trace spans to a file\n\n"
+        "Usage: !ExportTrace <filename>\n\n"
+        "  <filename> - Path to the trace file (required)\n\n"
+        "Examples:\n"
+        "  !ExportTrace c:\\temp\\windbg_trace.json\n\n"
+        "The file is in the Chrome trace event format and can be opened\n"
+        "in chrome://tracing or https://ui.perfetto.dev.\n\n");
+    return S_OK;
+  }
+
+  std::string trace_file_path;
+  if (args && *args) {
+    trace_file_path = utils::Trim(args);
+  }
+
+  if (trace_file_path.empty()) {
+    DERROR("Invalid filename provided.\n");
+    return E_FAIL;
+  }
+
+  std::ofstream trace_file(trace_file_path);
+  if (!trace_file.is_open()) {
+    DERROR("Failed to open trace file: %s\n", trace_file_path.c_str());
+    return E_FAIL;
+  }
+
+  size_t event_count = 0;
+  try {
+    JSON events = trace::GetEventsOfAllModules();
+    event_count = events.size();
+    trace_file << trace::ToChromeTrace(events).dump(
+        -1, ' ', false, JSON::error_handler_t::replace);
+  } catch (const std::exception& e) {
+    DERROR("Failed to export the trace: %s\n", e.what());
+    return E_FAIL;
+  }
+
+  DOUT("Saved %zu trace events to %s\n", event_count,
+       trace_file_path.c_str());
+  return S_OK;
+}
+
 // Required export functions
 extern "C" {
 __declspec(dllexport) HRESULT CALLBACK DebugExtensionInitialize(PULONG version,
@@ -232,4 +316,19 @@ __declspec(dllexport) HRESULT CALLBACK StopCommandLogging(IDebugClient* client,
                                                           const char* args) {
   return StopCommandLoggingInternal(client, args);
 }
+
+__declspec(dllexport) HRESULT CALLBACK StartTrace(IDebugClient* client,
+                                                  const char* args) {
+  return StartTraceInternal(client, args);
+}
+
+__declspec(dllexport) HRESULT CALLBACK StopTrace(IDebugClient* client,
+                                                 const char* args) {
+  return StopTraceInternal(client, args);
+}
+
+__declspec(dllexport) HRESULT CALLBACK ExportTrace(IDebugClient* client,
+                                                   const char* args) {
+  return ExportTraceInternal(client, args);
+}
 }
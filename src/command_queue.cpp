@@ -0,0 +1,452 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "command_queue.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "trace.h"
+
+namespace command_queue {
+
+const char* GetPriorityName(Priority priority) {
+  return priority == Priority::kInteractive ? "interactive" : "normal";
+}
+
+void CommandQueue::Start() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (running_) {
+    return;
+  }
+  running_ = true;
+  drain_error_.clear();
+  thread_exited_ = false;
+  thread_ = std::thread(&CommandQueue::ProcessorThread, this);
+}
+
+void CommandQueue::Stop() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  commands_available_.notify_all();
+
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+
+  // Process any remaining commands
+  ProcessQueue();
+}
+
+bool CommandQueue::Stop(std::chrono::milliseconds timeout) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    running_ = false;
+  }
+  commands_available_.notify_all();
+  CancelQueued("The command queue was stopped");
+
+  bool exited = false;
+  {
+    std::unique_lock<std::mutex> lock(mutex_);
+    exited = idle_.wait_for(lock, timeout, [this] {
+      return thread_exited_ || !thread_.joinable();
+    });
+  }
+
+  if (thread_.joinable()) {
+    if (exited) {
+      thread_.join();
+    } else {
+      thread_.detach();
+    }
+  }
+  return exited;
+}
+
+void CommandQueue::StartDrain(const std::string& error) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  drain_error_ = error;
+}
+
+bool CommandQueue::WaitForIdle(std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  return idle_.wait_for(lock, timeout, [this] {
+    return depth_ == 0 && running_operations_ == 0;
+  });
+}
+
+size_t CommandQueue::CancelQueued(const std::string& error) {
+  std::vector<std::unique_ptr<Command>> cancelled;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& [id, session] : sessions_) {
+      for (std::unique_ptr<Command>& command : session.commands) {
+        cancelled.push_back(std::move(command));
+      }
+      session.commands.clear();
+      session.active = false;
+    }
+    for (std::deque<SessionId>& active : active_) {
+      active.clear();
+    }
+    for (auto it = sessions_.begin(); it != sessions_.end();) {
+      const Session& session = it->second;
+      it = session.removed && session.running == 0 ? sessions_.erase(it)
+                                                   : std::next(it);
+    }
+    depth_ = 0;
+  }
+  idle_.notify_all();
+
+  // The waiters are woken up without the lock held.
+  for (std::unique_ptr<Command>& command : cancelled) {
+    if (command->has_waiter) {
+      command->result.set_value(JSON{{"error", error}});
+    }
+  }
+  return cancelled.size();
+}
+
+bool CommandQueue::IsRunning() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return running_;
+}
+
+JSON CommandQueue::Execute(Operation operation, SessionId session) {
+  auto command = std::make_unique<Command>();
+  command->operation = std::move(operation);
+  command->has_waiter = true;
+  command->session = session;
+  auto future = command->result.get_future();
+
+  std::string error = Push(std::move(command));
+  if (!error.empty()) {
+    return JSON{{"error", error}};
+  }
+
+  // Blocks until the processor thread has run the operation.
+  return future.get();
+}
+
+void CommandQueue::Post(Operation operation, SessionId session) {
+  auto command = std::make_unique<Command>();
+  command->operation = std::move(operation);
+  command->session = session;
+  Push(std::move(command));
+}
+
+QueueStats CommandQueue::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  QueueStats stats = stats_;
+  stats.depth = depth_;
+  return stats;
+}
+
+void CommandQueue::SetDefaultSessionOptions(const SessionOptions& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  default_options_ = options;
+}
+
+SessionOptions CommandQueue::GetDefaultSessionOptions() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return default_options_;
+}
+
+void CommandQueue::SetSessionOptions(SessionId id,
+                                     const SessionOptions& options) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  Session& session = GetSession(id);
+
+  // An active session moves to the end of the turns of its new priority.
+  if (session.active && session.options.priority != options.priority) {
+    std::deque<SessionId>& old_active =
+        active_[static_cast<int>(session.options.priority)];
+    auto it = std::find(old_active.begin(), old_active.end(), id);
+    if (it != old_active.end()) {
+      old_active.erase(it);
+    }
+    active_[static_cast<int>(options.priority)].push_back(id);
+  }
+  session.options = options;
+}
+
+SessionOptions CommandQueue::GetSessionOptions(SessionId id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = sessions_.find(id);
+  return it != sessions_.end() && !it->second.removed ? it->second.options
+                                                      : default_options_;
+}
+
+void CommandQueue::RemoveSession(SessionId id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = sessions_.find(id);
+  if (it != sessions_.end()) {
+    it->second.removed = true;
+    EraseIfUnused(id);
+  }
+}
+
+std::vector<SessionStats> CommandQueue::GetSessionStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<SessionStats> sessions;
+  for (const auto& [id, session] : sessions_) {
+    if (session.removed) {
+      continue;
+    }
+    SessionStats stats = session.stats;
+    stats.session = id;
+    stats.priority = session.options.priority;
+    stats.depth = session.commands.size();
+    stats.deficit_us = session.deficit_us;
+    sessions.push_back(stats);
+  }
+  return sessions;
+}
+
+std::string CommandQueue::Push(std::unique_ptr<Command> command) {
+  Clock::time_point now = Clock::now();
+  command->queued_time = now;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_) {
+      return "The command queue is not running";
+    }
+    if (!drain_error_.empty()) {
+      return drain_error_;
+    }
+
+    // The operations of the default session (e.g. the snapshots which
+    // the MCP server queues at each break) aren't limited.
+    Session& session = GetSession(command->session);
+    command->generation = session.generation;
+    const SessionOptions& options = session.options;
+    bool limited = command->session != kDefaultSession;
+    if (limited && options.max_concurrent > 0 &&
+        session.commands.size() + session.running >= options.max_concurrent) {
+      session.stats.rejected++;
+      return "Too many commands in progress for this client (limit " +
+             std::to_string(options.max_concurrent) + ")";
+    }
+
+    if (limited && options.rate_limit > 0) {
+      double elapsed =
+          std::chrono::duration<double>(now - session.refill_time).count();
+      session.tokens = std::min(std::max(options.burst, 1.0),
+                                session.tokens + elapsed * options.rate_limit);
+      session.refill_time = now;
+      if (session.tokens < 1) {
+        session.stats.rejected++;
+        char rate[32];
+        snprintf(rate, sizeof(rate), "%g", options.rate_limit);
+        return std::string("Rate limit exceeded for this client (") + rate +
+               " commands per second)";
+      }
+      session.tokens -= 1;
+    }
+
+    if (!session.active) {
+      // The time the session was idle pays off its debt but doesn't
+      // add up to more than one turn.
+      if (session.commands.empty() && session.running == 0) {
+        int64_t idle_us = std::chrono::duration_cast<std::chrono::microseconds>(
+                              now - session.idle_time)
+                              .count();
+        session.deficit_us =
+            std::min(session.deficit_us + idle_us, kQuantumUs);
+      }
+      active_[static_cast<int>(options.priority)].push_back(command->session);
+      session.active = true;
+    }
+
+    session.commands.push_back(std::move(command));
+    depth_++;
+    stats_.max_depth = std::max<uint64_t>(stats_.max_depth, depth_);
+  }
+  commands_available_.notify_one();
+  return "";
+}
+
+void CommandQueue::Run(Command& command) {
+  Clock::time_point start = Clock::now();
+  auto wait = std::chrono::duration_cast<std::chrono::microseconds>(
+                  start - command.queued_time)
+                  .count();
+  if (trace::IsEnabled()) {
+    // trace::NowNs uses the same clock as queued_time.
+    trace::Record("Queue wait", nullptr,
+                  std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      command.queued_time.time_since_epoch())
+                      .count(),
+                  trace::NowNs());
+  }
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stats_.executed++;
+    stats_.total_wait_us += wait;
+    stats_.max_wait_us = std::max<uint64_t>(stats_.max_wait_us, wait);
+
+    // The session can't be erased while its operation runs.
+    SessionStats& stats = sessions_[command.session].stats;
+    stats.executed++;
+    stats.total_wait_us += wait;
+    stats.max_wait_us = std::max<uint64_t>(stats.max_wait_us, wait);
+  }
+
+  JSON result;
+  std::exception_ptr exception;
+  {
+    TRACE_SPAN("Run command");
+    try {
+      result = command.operation();
+    } catch (...) {
+      exception = std::current_exception();
+    }
+  }
+
+  // The session is charged before the waiter is woken up so that its
+  // next operation sees this one as finished.
+  Clock::time_point end = Clock::now();
+  int64_t run_us =
+      std::chrono::duration_cast<std::chrono::microseconds>(end - start)
+          .count();
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Session& session = sessions_[command.session];
+    session.running--;
+    running_operations_--;
+    if (command.generation == session.generation) {
+      session.deficit_us = std::max(session.deficit_us - run_us, -kMaxDebtUs);
+      session.stats.total_run_us += run_us;
+    }
+    if (session.commands.empty() && session.running == 0) {
+      session.idle_time = end;
+    }
+    EraseIfUnused(command.session);
+    if (depth_ == 0) {
+      idle_.notify_all();
+    }
+  }
+
+  // Exceptions are passed on to the caller of Execute.
+  if (command.has_waiter) {
+    if (exception) {
+      command.result.set_exception(exception);
+    } else {
+      command.result.set_value(std::move(result));
+    }
+  }
+}
+
+void CommandQueue::ProcessQueue() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  while (std::unique_ptr<Command> command = NextCommand()) {
+    lock.unlock();
+
+    Run(*command);
+
+    lock.lock();
+  }
+}
+
+CommandQueue::Session& CommandQueue::GetSession(SessionId id) {
+  auto [it, inserted] = sessions_.try_emplace(id);
+  Session& session = it->second;
+  if (inserted || session.removed) {
+    // A new client can get the id of one which disconnected while its
+    // operations were still running. The turns of the queued operations
+    // of the old one move to the default priority with the options.
+    if (session.active &&
+        session.options.priority != default_options_.priority) {
+      std::deque<SessionId>& old_active =
+          active_[static_cast<int>(session.options.priority)];
+      auto it = std::find(old_active.begin(), old_active.end(), id);
+      if (it != old_active.end()) {
+        old_active.erase(it);
+      }
+      active_[static_cast<int>(default_options_.priority)].push_back(id);
+    }
+    session.options = default_options_;
+    session.removed = false;
+    session.generation++;
+    session.deficit_us = kQuantumUs;
+    session.tokens = std::max(default_options_.burst, 1.0);
+    session.refill_time = Clock::now();
+    session.idle_time = session.refill_time;
+    session.stats = SessionStats();
+  }
+  return session;
+}
+
+std::unique_ptr<CommandQueue::Command> CommandQueue::NextCommand() {
+  for (Priority priority : {Priority::kInteractive, Priority::kNormal}) {
+    std::deque<SessionId>& active = active_[static_cast<int>(priority)];
+    while (!active.empty()) {
+      SessionId id = active.front();
+      Session& session = sessions_[id];
+      if (session.commands.empty()) {
+        active.pop_front();
+        session.active = false;
+        EraseIfUnused(id);
+        continue;
+      }
+
+      // A session in debt skips its turn and gets a quantum instead,
+      // until the debt is paid off.
+      active.pop_front();
+      if (session.deficit_us <= 0) {
+        session.deficit_us += kQuantumUs;
+        active.push_back(id);
+        continue;
+      }
+
+      // One operation per turn so that the short operations of the
+      // other sessions don't wait for a whole quantum.
+      std::unique_ptr<Command> command = std::move(session.commands.front());
+      session.commands.pop_front();
+      session.running++;
+      running_operations_++;
+      depth_--;
+      if (session.commands.empty()) {
+        session.active = false;
+      } else {
+        active.push_back(id);
+      }
+      return command;
+    }
+  }
+  return nullptr;
+}
+
+void CommandQueue::EraseIfUnused(SessionId id) {
+  auto it = sessions_.find(id);
+  if (it != sessions_.end() && it->second.removed && !it->second.active &&
+      it->second.commands.empty() && it->second.running == 0) {
+    sessions_.erase(it);
+  }
+}
+
+void CommandQueue::ProcessorThread() {
+  trace::SetThreadName("Command queue");
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      commands_available_.wait(lock,
+                               [this] { return depth_ > 0 || !running_; });
+      if (!running_) {
+        break;
+      }
+    }
+
+    ProcessQueue();
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  thread_exited_ = true;
+  idle_.notify_all();
+}
+
+}  // namespace command_queue
@@ -0,0 +1,227 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef COMMAND_QUEUE_H_
+#define COMMAND_QUEUE_H_
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "json.hpp"
+
+using JSON = nlohmann::json;
+
+namespace command_queue {
+
+using Operation = std::function<JSON()>;
+
+// Identifies the client which queued an operation. The MCP server
+// uses the id of the connection. The rate limit and concurrency cap
+// don't apply to kDefaultSession.
+using SessionId = uint64_t;
+constexpr SessionId kDefaultSession = 0;
+
+// Interactive sessions (e.g. a person driving an agent) are always
+// served before normal sessions.
+enum class Priority {
+  kNormal,
+  kInteractive,
+};
+
+struct SessionOptions {
+  Priority priority = Priority::kNormal;
+  // Operations per second which the session may queue. Operations
+  // above the rate are rejected. 0 is unlimited.
+  double rate_limit = 0;
+  // Operations which may be queued at once before the rate applies.
+  double burst = 10;
+  // Operations of the session which may be queued or running at
+  // once. 0 is unlimited.
+  uint32_t max_concurrent = 0;
+};
+
+struct SessionStats {
+  SessionId session = kDefaultSession;
+  Priority priority = Priority::kNormal;
+  uint64_t executed = 0;
+  // Operations rejected by the rate limit or the concurrency cap.
+  uint64_t rejected = 0;
+  // The number of operations which are waiting to run.
+  uint64_t depth = 0;
+  uint64_t total_wait_us = 0;
+  uint64_t max_wait_us = 0;
+  // Time the operations of the session ran on the queue's thread.
+  uint64_t total_run_us = 0;
+  // Negative while the session has used more than its share of the
+  // thread.
+  int64_t deficit_us = 0;
+};
+
+const char* GetPriorityName(Priority priority);
+
+struct QueueStats {
+  uint64_t executed = 0;
+  // The number of operations which are waiting to run.
+  uint64_t depth = 0;
+  uint64_t max_depth = 0;
+  // Time between queueing an operation and starting to run it.
+  uint64_t total_wait_us = 0;
+  uint64_t max_wait_us = 0;
+};
+
+// Runs operations one at a time on a single thread. The debugger
+// engine must only be called from one thread so every tool of the MCP
+// server which uses the engine goes through this queue.
+//
+// Each session has its own queue whose operations run in the order
+// they were queued. The sessions of a priority share the thread with
+// deficit round robin: the time each operation runs is subtracted from
+// its session's credit, and a session in debt skips its turns, getting
+// a quantum of credit for each one, until the debt is paid off. A
+// client which runs long commands waits while the others catch up
+// instead of starving them. A session runs one operation per turn and
+// one which is idle pays off its debt with the time it didn't use the
+// thread.
+class CommandQueue {
+ public:
+  CommandQueue() = default;
+  CommandQueue(const CommandQueue&) = delete;
+  CommandQueue& operator=(const CommandQueue&) = delete;
+  ~CommandQueue() { Stop(); }
+
+  void Start();
+
+  // Runs the operations which are still queued and joins the thread.
+  void Stop();
+
+  // Fails the operations which are still queued with an error and
+  // waits up to timeout for the running operation to finish. Returns
+  // false if it didn't, in which case the thread is detached and the
+  // queue must outlive it.
+  bool Stop(std::chrono::milliseconds timeout);
+
+  // Rejects new operations with error while the queued and running
+  // ones finish. Used to drain the queue before stopping it.
+  void StartDrain(const std::string& error);
+
+  // Waits up to timeout until no operation is queued or running.
+  bool WaitForIdle(std::chrono::milliseconds timeout);
+
+  // Fails the queued operations with error (Execute returns an object
+  // with an "error" member and posted operations are dropped). The
+  // running operation isn't affected. Returns the number of failed
+  // operations.
+  size_t CancelQueued(const std::string& error);
+
+  bool IsRunning() const;
+
+  // Queues operation and blocks until it has run. Returns an object
+  // with an "error" member if the queue is not running or the session
+  // is over its rate limit or concurrency cap.
+  JSON Execute(Operation operation, SessionId session = kDefaultSession);
+
+  // Queues operation without waiting for it to run. Dropped if the
+  // queue is not running or the session is over its limits.
+  void Post(Operation operation, SessionId session = kDefaultSession);
+
+  QueueStats GetStats() const;
+
+  // The options of sessions which haven't been given their own.
+  void SetDefaultSessionOptions(const SessionOptions& options);
+  SessionOptions GetDefaultSessionOptions() const;
+
+  void SetSessionOptions(SessionId session, const SessionOptions& options);
+  // Returns the default options if the session doesn't exist.
+  SessionOptions GetSessionOptions(SessionId session) const;
+
+  // Forgets the options and stats of a session (e.g. when a client
+  // disconnects). Operations which are still queued run.
+  void RemoveSession(SessionId session);
+
+  std::vector<SessionStats> GetSessionStats() const;
+
+  // The credit a session in debt gets for each turn it skips.
+  static constexpr int64_t kQuantumUs = 1000;
+  // The most debt a session carries. Bounds how long one very long
+  // command delays the next operation of its session.
+  static constexpr int64_t kMaxDebtUs = 1000000;
+
+ private:
+  using Clock = std::chrono::steady_clock;
+
+  struct Command {
+    Operation operation;
+    std::promise<JSON> result;
+    bool has_waiter = false;
+    SessionId session = kDefaultSession;
+    // The generation of the session when the command was queued.
+    uint64_t generation = 0;
+    Clock::time_point queued_time;
+  };
+
+  struct Session {
+    SessionOptions options;
+    std::deque<std::unique_ptr<Command>> commands;
+    // Operations which have been taken off the queue but not finished.
+    uint32_t running = 0;
+    // True while the session is in active_.
+    bool active = false;
+    // Set by RemoveSession. Erased once nothing is queued or running.
+    bool removed = false;
+    // Incremented when the id is reused by a new client so that the
+    // operations of the old one aren't charged to it.
+    uint64_t generation = 0;
+    int64_t deficit_us = kQuantumUs;
+    // Token bucket of the rate limit.
+    double tokens = 0;
+    Clock::time_point refill_time;
+    // When the last operation finished with nothing else queued.
+    Clock::time_point idle_time;
+    SessionStats stats;
+  };
+
+  // Returns an empty string if the command was queued or why not.
+  std::string Push(std::unique_ptr<Command> command);
+  void Run(Command& command);
+  void ProcessQueue();
+  void ProcessorThread();
+
+  // Must be called with mutex_ held.
+  Session& GetSession(SessionId id);
+  std::unique_ptr<Command> NextCommand();
+  void EraseIfUnused(SessionId id);
+
+  std::map<SessionId, Session> sessions_;
+  // The sessions with queued operations of each priority in the
+  // order of their turns.
+  std::deque<SessionId> active_[2];
+  SessionOptions default_options_;
+  // The number of queued operations of all of the sessions.
+  uint64_t depth_ = 0;
+  // The number of operations which are running (at most one).
+  uint64_t running_operations_ = 0;
+  // Set by StartDrain.
+  std::string drain_error_;
+  // Notified when the queue becomes idle and when the thread exits.
+  std::condition_variable idle_;
+  bool thread_exited_ = false;
+  mutable std::mutex mutex_;
+  std::condition_variable commands_available_;
+  std::thread thread_;
+  bool running_ = false;
+  QueueStats stats_;
+};
+
+}  // namespace command_queue
+
+#endif  // COMMAND_QUEUE_H_
@@ -0,0 +1,63 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef DBGENG_SHIM_H_
+#define DBGENG_SHIM_H_
+
+// On Windows this includes the real dbgeng and windows headers. On
+// other platforms it declares just enough of the dbgeng types for the
+// headers shared with the portable core library (windbg_ext_core) to
+// compile. Nothing on these platforms can call into the engine, only
+// the engine independent code is built there.
+
+#ifdef _WIN32
+
+#include <dbgeng.h>
+#include <windows.h>
+
+#else
+
+#include <cstdint>
+
+typedef int32_t HRESULT;
+typedef int32_t LONG;
+typedef uint32_t ULONG;
+typedef uint64_t ULONG64;
+typedef ULONG* PULONG;
+typedef ULONG64* PULONG64;
+typedef uint8_t BYTE;
+typedef int BOOL;
+typedef void* PVOID;
+typedef char* PSTR;
+typedef const char* PCSTR;
+
+#define S_OK ((HRESULT)0)
+#define S_FALSE ((HRESULT)1)
+#define E_NOTIMPL ((HRESULT)0x80004001)
+#define E_NOINTERFACE ((HRESULT)0x80004002)
+#define E_POINTER ((HRESULT)0x80004003)
+#define E_FAIL ((HRESULT)0x80004005)
+#define E_OUTOFMEMORY ((HRESULT)0x8007000E)
+#define E_INVALIDARG ((HRESULT)0x80070057)
+
+#define SUCCEEDED(hr) (((HRESULT)(hr)) >= 0)
+#define FAILED(hr) (((HRESULT)(hr)) < 0)
+
+#ifndef MAX_PATH
+#define MAX_PATH 260
+#endif
+
+#define DEBUG_OUTPUT_NORMAL 0x00000001
+#define DEBUG_OUTPUT_ERROR 0x00000002
+#define DEBUG_OUTPUT_WARNING 0x00000004
+
+struct IDebugClient;
+struct IDebugControl;
+struct IDebugSymbols;
+struct IDebugDataSpaces4;
+struct IDebugSystemObjects;
+struct IDebugRegisters;
+
+#endif  // _WIN32
+
+#endif  // DBGENG_SHIM_H_
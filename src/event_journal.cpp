@@ -0,0 +1,265 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "event_journal.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <map>
+
+namespace event_journal {
+
+namespace {
+
+const char* const kEventTypeNames[] = {
+    "Breakpoint",    "Exception",   "CreateThread", "ExitThread",
+    "CreateProcess", "ExitProcess", "LoadModule",   "UnloadModule",
+};
+
+std::string ToLower(std::string value) {
+  std::transform(value.begin(), value.end(), value.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return value;
+}
+
+}  // namespace
+
+const char* GetEventTypeName(EventType type) {
+  size_t index = static_cast<size_t>(type);
+  return index < static_cast<size_t>(EventType::kCount) ? kEventTypeNames[index]
+                                                        : "Unknown";
+}
+
+bool ParseEventType(const std::string& name, EventType& type) {
+  std::string lower_name = ToLower(name);
+  for (size_t i = 0; i < static_cast<size_t>(EventType::kCount); i++) {
+    if (ToLower(kEventTypeNames[i]) == lower_name) {
+      type = static_cast<EventType>(i);
+      return true;
+    }
+  }
+  return false;
+}
+
+StringTable::StringTable() {
+  strings_.push_back("");
+  ids_[""] = 0;
+}
+
+uint32_t StringTable::Intern(const std::string& value) {
+  if (value.empty()) {
+    return 0;
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = ids_.find(value);
+  if (it != ids_.end()) {
+    return it->second;
+  }
+
+  uint32_t id = static_cast<uint32_t>(strings_.size());
+  strings_.push_back(value);
+  ids_[value] = id;
+  return id;
+}
+
+std::string StringTable::Get(uint32_t id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return id < strings_.size() ? strings_[id] : "";
+}
+
+size_t StringTable::GetSize() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return strings_.size();
+}
+
+EventJournal::EventJournal(size_t capacity)
+    : slots_(new Slot[std::max<size_t>(capacity, 1)]),
+      capacity_(std::max<size_t>(capacity, 1)),
+      start_time_(std::chrono::steady_clock::now()) {
+  for (size_t i = 0; i < capacity_; i++) {
+    for (size_t j = 0; j < kWords; j++) {
+      slots_[i].words[j].store(0, std::memory_order_relaxed);
+    }
+  }
+}
+
+void EventJournal::Append(EventType type,
+                          uint32_t process_id,
+                          uint32_t thread_id,
+                          uint64_t address,
+                          uint64_t argument,
+                          const std::string& module,
+                          bool first_chance) {
+  uint64_t module_id = strings_.Intern(module);
+  uint64_t time_us = GetTimeUs();
+
+  uint64_t sequence = next_sequence_.fetch_add(1, std::memory_order_relaxed);
+  Slot& slot = slots_[sequence % capacity_];
+
+  slot.version.store(2 * sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+
+  slot.words[0].store(time_us, std::memory_order_relaxed);
+  slot.words[1].store((static_cast<uint64_t>(process_id) << 32) | thread_id,
+                      std::memory_order_relaxed);
+  slot.words[2].store(address, std::memory_order_relaxed);
+  slot.words[3].store(argument, std::memory_order_relaxed);
+  slot.words[4].store((module_id << 32) | (first_chance ? 0x100 : 0) |
+                          static_cast<uint64_t>(type),
+                      std::memory_order_relaxed);
+
+  slot.version.store(2 * sequence + 2, std::memory_order_release);
+}
+
+bool EventJournal::ReadSlot(uint64_t sequence,
+                            Event& event,
+                            uint32_t& module_id) const {
+  const Slot& slot = slots_[sequence % capacity_];
+  uint64_t expected_version = 2 * sequence + 2;
+
+  if (slot.version.load(std::memory_order_acquire) != expected_version) {
+    return false;
+  }
+
+  uint64_t words[kWords];
+  for (size_t i = 0; i < kWords; i++) {
+    words[i] = slot.words[i].load(std::memory_order_relaxed);
+  }
+
+  // The record was overwritten while it was copied.
+  std::atomic_thread_fence(std::memory_order_acquire);
+  if (slot.version.load(std::memory_order_relaxed) != expected_version) {
+    return false;
+  }
+
+  event.sequence = sequence;
+  event.time_us = words[0];
+  event.process_id = static_cast<uint32_t>(words[1] >> 32);
+  event.thread_id = static_cast<uint32_t>(words[1]);
+  event.address = words[2];
+  event.argument = words[3];
+  event.type = static_cast<EventType>(words[4] & 0xff);
+  event.first_chance = (words[4] & 0x100) != 0;
+  module_id = static_cast<uint32_t>(words[4] >> 32);
+  return true;
+}
+
+std::vector<Event> EventJournal::Find(const Query& query) const {
+  std::vector<Event> events;
+  if (query.limit == 0) {
+    return events;
+  }
+
+  uint64_t newest = next_sequence_.load(std::memory_order_acquire) - 1;
+  uint64_t oldest = newest >= capacity_ ? newest - capacity_ + 1 : 1;
+  oldest = std::max(oldest, query.after_sequence + 1);
+
+  std::string module_filter = ToLower(query.module);
+  std::map<uint32_t, std::string> module_names;
+  std::map<uint32_t, bool> module_matches;
+
+  // Newest first so that the query can stop at the limit.
+  for (uint64_t sequence = newest; sequence >= oldest && sequence > 0;
+       sequence--) {
+    Event event;
+    uint32_t module_id = 0;
+    if (!ReadSlot(sequence, event, module_id)) {
+      continue;
+    }
+
+    if (event.time_us < query.start_time_us) {
+      break;
+    }
+    if (event.time_us > query.end_time_us ||
+        (query.type_mask & (1u << static_cast<uint32_t>(event.type))) == 0 ||
+        (query.has_process_id && event.process_id != query.process_id)) {
+      continue;
+    }
+
+    auto name = module_names.find(module_id);
+    if (name == module_names.end()) {
+      name = module_names.emplace(module_id, strings_.Get(module_id)).first;
+      module_matches[module_id] =
+          module_filter.empty() ||
+          ToLower(name->second).find(module_filter) != std::string::npos;
+    }
+    if (!module_matches[module_id]) {
+      continue;
+    }
+
+    event.module = name->second;
+    events.push_back(std::move(event));
+    if (events.size() == query.limit) {
+      break;
+    }
+  }
+
+  std::reverse(events.begin(), events.end());
+  return events;
+}
+
+JournalStats EventJournal::GetStats() const {
+  JournalStats stats;
+  stats.capacity = capacity_;
+  stats.appended = next_sequence_.load(std::memory_order_relaxed) - 1;
+  stats.overwritten =
+      stats.appended > capacity_ ? stats.appended - capacity_ : 0;
+  stats.interned_strings = strings_.GetSize() - 1;
+  return stats;
+}
+
+uint64_t EventJournal::GetTimeUs() const {
+  return std::chrono::duration_cast<std::chrono::microseconds>(
+             std::chrono::steady_clock::now() - start_time_)
+      .count();
+}
+
+std::string FormatEvent(const Event& event) {
+  char buffer[256];
+  int length = snprintf(buffer, sizeof(buffer),
+                        "#%-5llu %4llu.%03llus %-13s pid 0x%x tid 0x%x",
+                        static_cast<unsigned long long>(event.sequence),
+                        static_cast<unsigned long long>(event.time_us / 1000000),
+                        static_cast<unsigned long long>(
+                            (event.time_us / 1000) % 1000),
+                        GetEventTypeName(event.type), event.process_id,
+                        event.thread_id);
+  std::string result(buffer, length);
+
+  if (!event.module.empty()) {
+    result += " " + event.module;
+  }
+
+  unsigned long long address = event.address;
+  unsigned long long argument = event.argument;
+  switch (event.type) {
+    case EventType::kBreakpoint:
+      snprintf(buffer, sizeof(buffer), " 0x%llx bp %llu", address, argument);
+      break;
+    case EventType::kException:
+      snprintf(buffer, sizeof(buffer), " 0x%llx code 0x%llx %s", address,
+               argument, event.first_chance ? "first chance" : "second chance");
+      break;
+    case EventType::kCreateThread:
+    case EventType::kCreateProcess:
+    case EventType::kUnloadModule:
+      snprintf(buffer, sizeof(buffer), " 0x%llx", address);
+      break;
+    case EventType::kExitThread:
+    case EventType::kExitProcess:
+      snprintf(buffer, sizeof(buffer), " exit code 0x%llx", argument);
+      break;
+    case EventType::kLoadModule:
+      snprintf(buffer, sizeof(buffer), " 0x%llx size 0x%llx", address,
+               argument);
+      break;
+    default:
+      buffer[0] = '\0';
+      break;
+  }
+  return result + buffer;
+}
+
+}  // namespace event_journal
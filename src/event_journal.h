@@ -0,0 +1,159 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef EVENT_JOURNAL_H_
+#define EVENT_JOURNAL_H_
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace event_journal {
+
+enum class EventType : uint8_t {
+  kBreakpoint = 0,
+  kException,
+  kCreateThread,
+  kExitThread,
+  kCreateProcess,
+  kExitProcess,
+  kLoadModule,
+  kUnloadModule,
+  kCount
+};
+
+// Returns the name of the type (e.g. "LoadModule").
+const char* GetEventTypeName(EventType type);
+
+// Parses a type name (case insensitive). Returns false if the
+// name is not the name of a type.
+bool ParseEventType(const std::string& name, EventType& type);
+
+// A decoded journal record.
+//
+// address and argument depend on the type:
+//   kBreakpoint    - address of the breakpoint, breakpoint id
+//   kException     - exception address, exception code
+//   kCreateThread  - start address, 0
+//   kExitThread    - 0, exit code
+//   kCreateProcess - image base, 0
+//   kExitProcess   - 0, exit code
+//   kLoadModule    - module base, module size
+//   kUnloadModule  - module base, 0
+struct Event {
+  uint64_t sequence = 0;
+  // Microseconds since the journal was created.
+  uint64_t time_us = 0;
+  EventType type = EventType::kBreakpoint;
+  // Set for first chance exceptions.
+  bool first_chance = false;
+  uint32_t process_id = 0;
+  uint32_t thread_id = 0;
+  uint64_t address = 0;
+  uint64_t argument = 0;
+  // The module name (e.g. "chrome") or empty.
+  std::string module;
+};
+
+struct Query {
+  // Bit (1 << type) for each type to include.
+  uint32_t type_mask = (1u << static_cast<uint32_t>(EventType::kCount)) - 1;
+  bool has_process_id = false;
+  uint32_t process_id = 0;
+  // Case insensitive substring of the module name. Empty for all events.
+  std::string module;
+  uint64_t start_time_us = 0;
+  uint64_t end_time_us = UINT64_MAX;
+  // Only events with a larger sequence number. Used to poll for
+  // the events which were added since the last query.
+  uint64_t after_sequence = 0;
+  // The newest matching events are returned (oldest first).
+  size_t limit = 100;
+};
+
+struct JournalStats {
+  uint64_t capacity = 0;
+  // The total number of events appended and the number which
+  // were overwritten because the journal was full.
+  uint64_t appended = 0;
+  uint64_t overwritten = 0;
+  uint64_t interned_strings = 0;
+};
+
+// Assigns small ids to strings so that records only store a 32 bit id.
+// Ids are never reused so a record can always be resolved. Id 0 is
+// the empty string.
+class StringTable {
+ public:
+  StringTable();
+
+  uint32_t Intern(const std::string& value);
+
+  // Returns an empty string for unknown ids.
+  std::string Get(uint32_t id) const;
+
+  size_t GetSize() const;
+
+ private:
+  std::unordered_map<std::string, uint32_t> ids_;
+  std::vector<std::string> strings_;
+  mutable std::mutex mutex_;
+};
+
+// A fixed capacity ring of debug events. Appending an event without
+// a module is lock free and events with a module only take the string
+// table lock. Readers copy the records out with a per slot sequence
+// lock and skip records which are overwritten while they are read.
+class EventJournal {
+ public:
+  explicit EventJournal(size_t capacity = 4096);
+
+  void Append(EventType type,
+              uint32_t process_id,
+              uint32_t thread_id,
+              uint64_t address,
+              uint64_t argument,
+              const std::string& module = "",
+              bool first_chance = false);
+
+  std::vector<Event> Find(const Query& query) const;
+
+  JournalStats GetStats() const;
+
+  // Microseconds since the journal was created.
+  uint64_t GetTimeUs() const;
+
+ private:
+  // A record packed into 5 words. Each word is atomic so
+  // that reading a slot while it is written is not a race.
+  static constexpr size_t kWords = 5;
+  struct Slot {
+    // 2 * sequence + 1 while the slot is written and
+    // 2 * sequence + 2 once the record is complete.
+    std::atomic<uint64_t> version{0};
+    std::atomic<uint64_t> words[kWords];
+  };
+
+  bool ReadSlot(uint64_t sequence, Event& event, uint32_t& module_id) const;
+
+  std::unique_ptr<Slot[]> slots_;
+  size_t capacity_;
+  std::atomic<uint64_t> next_sequence_{1};
+  StringTable strings_;
+  std::chrono::steady_clock::time_point start_time_;
+};
+
+// One line per event:
+//
+//    #12       3.512s LoadModule    pid 0x3c4 tid 0x1a30 chrome 0x7ff9a2f00000 size 0x98a1000
+//
+std::string FormatEvent(const Event& event);
+
+}  // namespace event_journal
+
+#endif  // EVENT_JOURNAL_H_
@@ -0,0 +1,280 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "execution_context.h"
+
+#include <set>
+#include <sstream>
+
+namespace execution_context {
+
+namespace {
+
+// Add 4 spaces to the front of all of the lines.
+std::string IndentLines(const std::vector<std::string>& lines) {
+  std::string result;
+  for (const std::string& line : lines) {
+    result += "    " + line + "\n";
+  }
+  return result;
+}
+
+std::vector<std::string> SplitLines(const std::string& text) {
+  std::vector<std::string> lines;
+  std::istringstream stream(text);
+  std::string line;
+  while (std::getline(stream, line)) {
+    lines.push_back(line);
+  }
+  return lines;
+}
+
+// The current line of "lsa ." starts with ">". Without the marker a
+// line can be matched with the same line of the previous window.
+std::string RemoveCurrentLineMarker(const std::string& line) {
+  if (!line.empty() && line[0] == '>') {
+    return " " + line.substr(1);
+  }
+  return line;
+}
+
+std::string FormatCallStack(const std::vector<std::string>& call_stack) {
+  std::string result = "  Call Stack (top 5):\n";
+  for (size_t i = 0; i < call_stack.size(); i++) {
+    result += "    [" + std::to_string(i) + "] " + call_stack[i] + "\n";
+  }
+  return result;
+}
+
+}  // namespace
+
+std::string Format(const ExecutionContext& context) {
+  std::string result = "Current Execution Context:\n";
+  result += "  Process: " + std::to_string(context.process_id) + "\n";
+  result += "  Process Command Line: " + context.command_line + "\n";
+  result += "  Thread: " + std::to_string(context.thread_id) + "\n";
+
+  if (!context.source_file.empty()) {
+    result += "  Source File: " + context.source_file + "\n";
+    result += "  Source Line: " + std::to_string(context.source_line) + "\n";
+  }
+  if (!context.source_context.empty()) {
+    result += "  Source Context (current line starts with \">\"):\n" +
+              IndentLines(SplitLines(context.source_context));
+  }
+
+  result += FormatCallStack(context.call_stack);
+
+  if (!context.extra.empty()) {
+    result += "\n" + context.extra;
+  }
+  return result;
+}
+
+std::string FormatDelta(const ExecutionContext& context,
+                        const ExecutionContext& previous) {
+  // The command line and everything else belong to a different process.
+  if (context.process_id != previous.process_id) {
+    return Format(context);
+  }
+
+  std::string changes;
+  std::vector<std::string> unchanged = {"Process", "Process Command Line"};
+
+  if (context.thread_id != previous.thread_id) {
+    changes += "  Thread: " + std::to_string(context.thread_id) + "\n";
+  } else {
+    unchanged.push_back("Thread");
+  }
+
+  bool same_file = context.source_file == previous.source_file;
+  if (!same_file) {
+    changes += "  Source File: " +
+               (context.source_file.empty() ? "(none)" : context.source_file) +
+               "\n";
+  } else if (!context.source_file.empty()) {
+    unchanged.push_back("Source File");
+  }
+
+  if (!context.source_file.empty() &&
+      (!same_file || context.source_line != previous.source_line)) {
+    changes +=
+        "  Source Line: " + std::to_string(context.source_line) + "\n";
+  } else if (!context.source_file.empty()) {
+    unchanged.push_back("Source Line");
+  }
+
+  if (context.source_context != previous.source_context) {
+    std::vector<std::string> lines = SplitLines(context.source_context);
+    if (same_file && !previous.source_context.empty()) {
+      // Only the lines which scrolled into the window and the
+      // current line. The other lines were already sent.
+      std::set<std::string> previous_lines;
+      for (const std::string& line : SplitLines(previous.source_context)) {
+        previous_lines.insert(RemoveCurrentLineMarker(line));
+      }
+
+      std::vector<std::string> new_lines;
+      for (const std::string& line : lines) {
+        if ((!line.empty() && line[0] == '>') ||
+            previous_lines.count(RemoveCurrentLineMarker(line)) == 0) {
+          new_lines.push_back(line);
+        }
+      }
+
+      changes +=
+          "  Source Context (new lines only, current line starts with "
+          "\">\"):\n" +
+          IndentLines(new_lines);
+    } else if (!lines.empty()) {
+      changes += "  Source Context (current line starts with \">\"):\n" +
+                 IndentLines(lines);
+    }
+  } else if (!context.source_context.empty()) {
+    unchanged.push_back("Source Context");
+  }
+
+  if (context.call_stack != previous.call_stack) {
+    changes += FormatCallStack(context.call_stack);
+  } else {
+    unchanged.push_back("Call Stack");
+  }
+
+  std::string result;
+  if (changes.empty()) {
+    result = "Current Execution Context: unchanged since the last response\n";
+  } else {
+    result = "Current Execution Context (changes since the last response):\n" +
+             changes;
+    std::string names;
+    for (const std::string& name : unchanged) {
+      names += (names.empty() ? "" : ", ") + name;
+    }
+    result += "  Unchanged: " + names + "\n";
+  }
+
+  if (!context.extra.empty() && context.extra != previous.extra) {
+    result += "\n" + context.extra;
+  }
+  return result;
+}
+
+std::string ContextCache::FormatForClient(uint64_t client_id,
+                                          const ExecutionContext& context,
+                                          bool full) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  std::string result;
+  auto it = contexts_.find(client_id);
+  if (full || it == contexts_.end()) {
+    result = Format(context);
+    stats_.full_responses++;
+  } else {
+    result = FormatDelta(context, it->second);
+    stats_.delta_responses++;
+    stats_.full_bytes += Format(context).size();
+    stats_.sent_bytes += result.size();
+  }
+
+  contexts_[client_id] = context;
+  return result;
+}
+
+bool ContextCache::GetLastContext(uint64_t client_id,
+                                  ExecutionContext& context) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto it = contexts_.find(client_id);
+  if (it == contexts_.end()) {
+    return false;
+  }
+  context = it->second;
+  return true;
+}
+
+void ContextCache::RemoveClient(uint64_t client_id) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  contexts_.erase(client_id);
+}
+
+ContextCacheStats ContextCache::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+ExecutionContext Capture(const utils::DebugInterfaces* interfaces,
+                         const ExecutionContext* previous) {
+  ExecutionContext context;
+  ULONG current_process_id = 0;
+  ULONG current_thread_id = 0;
+  static const ULONG INVALID_PROCESS_OR_THREAD_ID = static_cast<ULONG>(-1);
+
+  HRESULT hr = interfaces->system_objects->GetCurrentProcessId(&current_process_id);
+  if (FAILED(hr)) {
+    current_process_id = INVALID_PROCESS_OR_THREAD_ID;
+  }
+
+  hr = interfaces->system_objects->GetCurrentThreadId(&current_thread_id);
+  if (FAILED(hr)) {
+    current_thread_id = INVALID_PROCESS_OR_THREAD_ID;
+  }
+
+  context.process_id = current_process_id;
+  context.thread_id = current_thread_id;
+
+  if (previous && previous->process_id == context.process_id &&
+      context.process_id != INVALID_PROCESS_OR_THREAD_ID) {
+    context.command_line = previous->command_line;
+  } else {
+    auto command_line = utils::ExecuteCommand(
+        interfaces,
+        "dx -r0 @$curprocess.Environment.EnvironmentBlock.ProcessParameters->CommandLine.Buffer");
+    size_t start_pos = command_line.find('"');
+    size_t end_pos = command_line.rfind('"');
+    if (start_pos != std::string::npos && end_pos != std::string::npos &&
+        start_pos < end_pos) {
+      // Extract the command line string
+      command_line = command_line.substr(start_pos + 1, end_pos - start_pos - 1);
+    } else {
+      // If no quotes found, just use the whole line
+      command_line = utils::Trim(command_line);
+    }
+    context.command_line = command_line;
+  }
+
+  // Get current source info
+  utils::SourceInfo source_info = utils::GetCurrentSourceInfo(interfaces);
+  if (source_info.is_valid) {
+    if (!source_info.file_path.empty()) {
+      context.source_file = source_info.full_path;
+      context.source_line = source_info.line;
+    }
+    context.source_context = source_info.source_context;
+  }
+
+  context.call_stack = utils::GetTopOfCallStack(interfaces);
+
+  ULONG num_processes = 0;
+  interfaces->system_objects->GetNumberProcesses(&num_processes);
+
+  if (!context.call_stack.empty() &&
+      context.call_stack[0].find("ntdll!LdrpDoDebuggerBreak") !=
+          std::string::npos &&
+      num_processes == 1) {
+    context.extra =
+        "Extra Context:\n"
+        "This is a new debugging session and no commands have been executed yet.\n"
+        "If you need to set breakpoints for child processes, use something\n"
+        "similar to the following commands:\n"
+        "\n"
+        "    .childdbg 1; sxn ibp; sxn epr; sxe -c \"bp module_name!namespace_name::class_name::method_name; [...optionally more breakpoints if needed]; gc\" ld:module_name.dll; g\n"
+        "\n"
+        "    .childdbg 1; sxn ibp; sxn epr; sxe -c \"bp `module_name!D:\\\\path\\\\to\\\\file\\\\source_file.cc:42`; gc\" ld:module_name.dll; g\n"
+        "\n"
+        "This will set breakpoints in the child process for the specified module\n"
+        "and start execution of the target. These commands should only be used\n"
+        "for the initial breakpoints in a new debugging session.\n";
+  }
+  return context;
+}
+
+}  // namespace execution_context
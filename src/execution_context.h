@@ -0,0 +1,100 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef EXECUTION_CONTEXT_H_
+#define EXECUTION_CONTEXT_H_
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "utils.h"
+
+namespace execution_context {
+
+// The execution context which is added to the output of the
+// continuation commands (g, gu, p, t) and when a breakpoint is hit.
+struct ExecutionContext {
+  uint32_t process_id = 0;
+  std::string command_line;
+  uint32_t thread_id = 0;
+
+  // Empty if there is no source information for the current frame.
+  std::string source_file;
+  uint32_t source_line = 0;
+  // The output of "lsa ." where the current line starts with ">".
+  std::string source_context;
+
+  std::vector<std::string> call_stack;
+
+  // Hints which are added for special states (e.g. the initial break).
+  std::string extra;
+};
+
+// The full context:
+//
+//    Current Execution Context:
+//      Process: 6
+//      Process Command Line: "D:\cs\src\out\release_x64\chrome.exe" --type=u...
+//      Thread: 92
+//      Source File: D:\cs\src\media\mojo\services\media_foundation_service.cc
+//      Source Line: 520
+//      Source Context (current line starts with ">"):
+//          516: }
+//          ...
+//      Call Stack (top 5):
+//        [0] chrome!media::MediaFoundationService::IsKeySystemSupported
+//        ...
+//
+std::string Format(const ExecutionContext& context);
+
+// Only the fields which differ from the previous context followed by
+// a line which lists the fields that are unchanged. Within the same
+// source file only the lines of the source window which were not in
+// the previous window and the current line are included.
+std::string FormatDelta(const ExecutionContext& context,
+                        const ExecutionContext& previous);
+
+// Reads the current execution context from the engine. The command
+// line is only read again if the process changed since previous
+// because it requires evaluating a dx expression.
+ExecutionContext Capture(const utils::DebugInterfaces* interfaces,
+                         const ExecutionContext* previous = nullptr);
+
+struct ContextCacheStats {
+  uint64_t full_responses = 0;
+  uint64_t delta_responses = 0;
+  // The size of the full contexts of the delta responses
+  // and the size of what was actually sent.
+  uint64_t full_bytes = 0;
+  uint64_t sent_bytes = 0;
+};
+
+// Remembers the last context which was sent to each client so that
+// later responses to the same client only include what changed.
+class ContextCache {
+ public:
+  // Returns the full context for the first response to a client or if
+  // full is true and the delta from the last context otherwise.
+  std::string FormatForClient(uint64_t client_id,
+                              const ExecutionContext& context,
+                              bool full = false);
+
+  // Returns false if no context has been sent to the client.
+  bool GetLastContext(uint64_t client_id, ExecutionContext& context) const;
+
+  void RemoveClient(uint64_t client_id);
+
+  ContextCacheStats GetStats() const;
+
+ private:
+  std::map<uint64_t, ExecutionContext> contexts_;
+  ContextCacheStats stats_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace execution_context
+
+#endif  // EXECUTION_CONTEXT_H_
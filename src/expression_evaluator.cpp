@@ -0,0 +1,266 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "expression_evaluator.h"
+
+#include <cstdio>
+
+namespace expression_evaluator {
+
+namespace {
+
+const char kDxPrefix[] = "dx ";
+const char kDxTypeMarker[] = "[Type: ";
+
+std::string FormatHex(ULONG64 value) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "0x%llx", value);
+  return buffer;
+}
+
+void FormatInteger(ULONG64 value,
+                   LONG64 signed_value,
+                   const char* type,
+                   EvaluationResult& result) {
+  result.type = type;
+  result.value = FormatHex(value);
+  result.decimal = std::to_string(signed_value);
+}
+
+std::string FormatFloat(double value) {
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "%.17g", value);
+  return buffer;
+}
+
+std::string FormatBytes(const UCHAR* bytes, size_t size) {
+  // Displayed most significant byte first like the vector registers.
+  static const char kHexDigits[] = "0123456789abcdef";
+  std::string text = "0x";
+  for (size_t i = size; i > 0; i--) {
+    text += kHexDigits[bytes[i - 1] >> 4];
+    text += kHexDigits[bytes[i - 1] & 0x0F];
+  }
+  return text;
+}
+
+// Evaluate the expression with IDebugControl::Evaluate and keep the
+// natural type of the result.
+bool EvaluateWithEngine(const utils::DebugInterfaces* interfaces,
+                        const std::string& expression,
+                        const char* source,
+                        EvaluationResult& result) {
+  DEBUG_VALUE value = {};
+  ULONG remainder_index = 0;
+  HRESULT hr = interfaces->control->Evaluate(
+      expression.c_str(), DEBUG_VALUE_INVALID, &value, &remainder_index);
+  if (FAILED(hr)) {
+    result.error = "Unable to evaluate expression";
+    return false;
+  }
+
+  // Evaluate stops at the first character it can't parse
+  // which usually means that the expression is not MASM.
+  if (remainder_index < expression.size() &&
+      !utils::Trim(expression.substr(remainder_index)).empty()) {
+    result.error = "Unexpected text in expression: " +
+                   expression.substr(remainder_index);
+    return false;
+  }
+
+  // Values which don't have a direct representation are converted.
+  if (value.Type == DEBUG_VALUE_FLOAT80 || value.Type == DEBUG_VALUE_FLOAT82 ||
+      value.Type == DEBUG_VALUE_FLOAT128) {
+    DEBUG_VALUE converted = {};
+    hr = interfaces->control->CoerceValue(&value, DEBUG_VALUE_FLOAT64,
+                                          &converted);
+    if (FAILED(hr)) {
+      result.error = "Unable to convert the value to a double";
+      return false;
+    }
+    value = converted;
+  }
+
+  if (!FormatDebugValue(value, result)) {
+    result.error = "Unsupported value type: " + std::to_string(value.Type);
+    return false;
+  }
+
+  result.source = source;
+  result.success = true;
+  return true;
+}
+
+bool EvaluateWithDx(const utils::DebugInterfaces* interfaces,
+                    const std::string& expression,
+                    EvaluationResult& result) {
+  // The expression is run as a command line, where ";" and line breaks
+  // start another command (e.g. "x; g" would resume the target).
+  if (expression.find_first_of(";\r\n") != std::string::npos) {
+    result.error = "dx expressions can't contain ';' or line breaks";
+    return false;
+  }
+
+  std::string output = utils::ExecuteCommand(interfaces, kDxPrefix + expression);
+  if (!ParseDxOutput(output, result)) {
+    return false;
+  }
+
+  result.source = "dx";
+  result.success = true;
+  return true;
+}
+
+}  // namespace
+
+bool ParseExpressionSyntax(const std::string& name, ExpressionSyntax& syntax) {
+  if (name.empty() || name == "auto") {
+    syntax = ExpressionSyntax::kAuto;
+  } else if (name == "masm") {
+    syntax = ExpressionSyntax::kMasm;
+  } else if (name == "c++") {
+    syntax = ExpressionSyntax::kCpp;
+  } else if (name == "dx") {
+    syntax = ExpressionSyntax::kDx;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+EvaluationResult EvaluateExpression(const utils::DebugInterfaces* interfaces,
+                                    const std::string& expression,
+                                    ExpressionSyntax syntax) {
+  EvaluationResult result;
+  std::string text = utils::Trim(expression);
+
+  // Allow "dx foo" to select the data model in auto mode.
+  if (syntax == ExpressionSyntax::kAuto &&
+      text.compare(0, sizeof(kDxPrefix) - 1, kDxPrefix) == 0) {
+    syntax = ExpressionSyntax::kDx;
+    text = utils::Trim(text.substr(sizeof(kDxPrefix) - 1));
+  }
+
+  if (text.empty()) {
+    result.error = "Empty expression";
+    return result;
+  }
+
+  switch (syntax) {
+    case ExpressionSyntax::kMasm:
+      EvaluateWithEngine(interfaces, text, "masm", result);
+      break;
+    case ExpressionSyntax::kCpp:
+      EvaluateWithEngine(interfaces, "@@c++(" + text + ")", "c++", result);
+      break;
+    case ExpressionSyntax::kDx:
+      EvaluateWithDx(interfaces, text, result);
+      break;
+    case ExpressionSyntax::kAuto: {
+      // Evaluate is much cheaper than dx so it is tried first. The
+      // error from the first attempt is the most useful one to report
+      // if nothing succeeds.
+      if (EvaluateWithEngine(interfaces, text, "masm", result)) {
+        break;
+      }
+      std::string masm_error = result.error;
+
+      result = EvaluationResult();
+      if (EvaluateWithEngine(interfaces, "@@c++(" + text + ")", "c++",
+                             result)) {
+        break;
+      }
+
+      result = EvaluationResult();
+      if (!EvaluateWithDx(interfaces, text, result)) {
+        result.error = masm_error + "; dx: " + result.error;
+      }
+      break;
+    }
+  }
+
+  return result;
+}
+
+bool FormatDebugValue(const DEBUG_VALUE& value, EvaluationResult& result) {
+  switch (value.Type) {
+    case DEBUG_VALUE_INT8:
+      FormatInteger(value.I8, static_cast<signed char>(value.I8), "int8",
+                    result);
+      return true;
+    case DEBUG_VALUE_INT16:
+      FormatInteger(value.I16, static_cast<short>(value.I16), "int16",
+                    result);
+      return true;
+    case DEBUG_VALUE_INT32:
+      FormatInteger(value.I32, static_cast<LONG>(value.I32), "int32", result);
+      return true;
+    case DEBUG_VALUE_INT64:
+      FormatInteger(value.I64, static_cast<LONG64>(value.I64), "int64",
+                    result);
+      return true;
+    case DEBUG_VALUE_FLOAT32:
+      result.type = "float32";
+      result.value = FormatFloat(value.F32);
+      return true;
+    case DEBUG_VALUE_FLOAT64:
+      result.type = "float64";
+      result.value = FormatFloat(value.F64);
+      return true;
+    case DEBUG_VALUE_VECTOR64:
+      result.type = "vector64";
+      result.value = FormatBytes(value.RawBytes, 8);
+      return true;
+    case DEBUG_VALUE_VECTOR128:
+      result.type = "vector128";
+      result.value = FormatBytes(value.RawBytes, 16);
+      return true;
+    default:
+      return false;
+  }
+}
+
+bool ParseDxOutput(const std::string& output, EvaluationResult& result) {
+  std::string text = utils::Trim(output);
+  if (text.empty()) {
+    result.error = "dx did not produce any output";
+    return false;
+  }
+
+  size_t line_end = text.find('\n');
+  std::string first_line = utils::Trim(text.substr(0, line_end));
+  std::string rest =
+      (line_end == std::string::npos) ? "" : utils::Trim(text.substr(line_end));
+
+  if (first_line.compare(0, 6, "Error:") == 0) {
+    result.error = utils::Trim(first_line.substr(6));
+    return false;
+  }
+
+  // The type is at the end of the line: "name : value [Type: T]"
+  std::string value_part = first_line;
+  size_t type_start = first_line.rfind(kDxTypeMarker);
+  if (type_start != std::string::npos) {
+    size_t type_end = first_line.rfind(']');
+    if (type_end != std::string::npos && type_end > type_start) {
+      size_t name_start = type_start + sizeof(kDxTypeMarker) - 1;
+      result.type = first_line.substr(name_start, type_end - name_start);
+    }
+    value_part = first_line.substr(0, type_start);
+  }
+
+  size_t separator = value_part.find(" : ");
+  if (separator != std::string::npos) {
+    result.value = utils::Trim(value_part.substr(separator + 3));
+  } else if (type_start == std::string::npos) {
+    result.error = "Unable to parse dx output: " + first_line;
+    return false;
+  } else {
+    // Objects only display their members on the following lines.
+    result.value = rest;
+  }
+
+  return true;
+}
+
+}  // namespace expression_evaluator
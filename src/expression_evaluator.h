@@ -0,0 +1,67 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef EXPRESSION_EVALUATOR_H_
+#define EXPRESSION_EVALUATOR_H_
+
+#include <dbgeng.h>
+#include <windows.h>
+#include <string>
+
+#include "utils.h"
+
+namespace expression_evaluator {
+
+enum class ExpressionSyntax {
+  // Try MASM, then C++ and then fall back to dx.
+  kAuto,
+  kMasm,
+  kCpp,
+  // Evaluate with the data model (dx).
+  kDx,
+};
+
+struct EvaluationResult {
+  bool success = false;
+  std::string error;
+
+  // How the value was produced ("masm", "c++" or "dx").
+  std::string source;
+
+  // The value type. One of "int8", "int16", "int32", "int64",
+  // "float32", "float64" for values from IDebugControl::Evaluate
+  // or the type name reported by dx.
+  std::string type;
+
+  // Integers are formatted as hex ("0x1234"), floats with %g and dx
+  // values as displayed by dx.
+  std::string value;
+
+  // The signed decimal value for integers.
+  std::string decimal;
+};
+
+// Parse the syntax names used by the evaluate MCP tool
+// ("auto", "masm", "c++" or "dx").
+bool ParseExpressionSyntax(const std::string& name, ExpressionSyntax& syntax);
+
+// Evaluate a single expression. Must be called on the
+// thread which owns the debugger engine.
+EvaluationResult EvaluateExpression(const utils::DebugInterfaces* interfaces,
+                                    const std::string& expression,
+                                    ExpressionSyntax syntax);
+
+// Convert a DEBUG_VALUE returned by IDebugControl::Evaluate.
+// Returns false if the value type is not supported.
+bool FormatDebugValue(const DEBUG_VALUE& value, EvaluationResult& result);
+
+// Parse the first line of dx output such as
+//   "this->size_      : 0x5 [Type: unsigned __int64]"
+// into the value and the type. For objects without a value on the
+// first line (e.g. "foo [Type: Foo]") the value is the list of
+// members which dx displays on the following lines.
+bool ParseDxOutput(const std::string& output, EvaluationResult& result);
+
+}  // namespace expression_evaluator
+
+#endif  // EXPRESSION_EVALUATOR_H_
@@ -0,0 +1,262 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "json_writer.h"
+
+#include <algorithm>
+#include <charconv>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define JSON_WRITER_USE_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace json_writer {
+
+namespace {
+
+const char kReplacementCharacter[] = "\xEF\xBF\xBD";
+
+#if defined(JSON_WRITER_USE_SSE2)
+unsigned CountTrailingZeros(unsigned value) {
+#if defined(_MSC_VER)
+  unsigned long index = 0;
+  _BitScanForward(&index, value);
+  return index;
+#else
+  return __builtin_ctz(value);
+#endif
+}
+
+// A bit per byte of the 16 bytes at data which can't be copied as
+// is: quotes, backslashes, control characters and non-ASCII bytes
+// (which are checked for valid UTF-8). The signed comparison with
+// 0x20 covers both the control characters and the bytes >= 0x80.
+unsigned SpecialBytes(const char* data) {
+  __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data));
+  __m128i special =
+      _mm_or_si128(_mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')),
+                                _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))),
+                   _mm_cmplt_epi8(chunk, _mm_set1_epi8(0x20)));
+  return static_cast<unsigned>(_mm_movemask_epi8(special));
+}
+#endif
+
+bool IsSpecial(unsigned char c) {
+  return c < 0x20 || c >= 0x80 || c == '"' || c == '\\';
+}
+
+// The length of the valid UTF-8 sequence which starts at data or 0
+// if it isn't valid (overlong encodings, surrogates and code points
+// above U+10FFFF are invalid).
+size_t Utf8SequenceLength(const unsigned char* data, size_t size) {
+  unsigned char lead = data[0];
+  size_t length = 0;
+  unsigned char min = 0x80;
+  unsigned char max = 0xBF;
+
+  if (lead >= 0xC2 && lead <= 0xDF) {
+    length = 2;
+  } else if (lead >= 0xE0 && lead <= 0xEF) {
+    length = 3;
+    if (lead == 0xE0) {
+      min = 0xA0;
+    } else if (lead == 0xED) {
+      max = 0x9F;
+    }
+  } else if (lead >= 0xF0 && lead <= 0xF4) {
+    length = 4;
+    if (lead == 0xF0) {
+      min = 0x90;
+    } else if (lead == 0xF4) {
+      max = 0x8F;
+    }
+  } else {
+    return 0;
+  }
+
+  if (length > size || data[1] < min || data[1] > max) {
+    return 0;
+  }
+  for (size_t i = 2; i < length; i++) {
+    if (data[i] < 0x80 || data[i] > 0xBF) {
+      return 0;
+    }
+  }
+  return length;
+}
+
+// Escapes the same way as JSON::dump().
+void AppendEscaped(std::string& output, unsigned char c) {
+  switch (c) {
+    case '"':
+      output += "\\\"";
+      break;
+    case '\\':
+      output += "\\\\";
+      break;
+    case '\b':
+      output += "\\b";
+      break;
+    case '\f':
+      output += "\\f";
+      break;
+    case '\n':
+      output += "\\n";
+      break;
+    case '\r':
+      output += "\\r";
+      break;
+    case '\t':
+      output += "\\t";
+      break;
+    default: {
+      const char kHexDigits[] = "0123456789abcdef";
+      char escape[] = {'\\', 'u', '0', '0', kHexDigits[c >> 4],
+                       kHexDigits[c & 0xF]};
+      output.append(escape, sizeof(escape));
+      break;
+    }
+  }
+}
+
+template <typename T>
+void AppendInteger(std::string& output, T value) {
+  char buffer[24];
+  auto result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+  output.append(buffer, result.ptr);
+}
+
+}  // namespace
+
+void AppendString(std::string& output, std::string_view text) {
+  const char* data = text.data();
+  size_t size = text.size();
+
+  // Grows geometrically so that many small strings don't reallocate
+  // for each string.
+  size_t needed = output.size() + size + 2;
+  if (needed > output.capacity()) {
+    output.reserve(std::max(needed, output.capacity() * 2));
+  }
+  output += '"';
+
+  // Bytes which don't need escaping are copied in runs.
+  size_t run_start = 0;
+  size_t i = 0;
+  while (i < size) {
+#if defined(JSON_WRITER_USE_SSE2)
+    if (i + 16 <= size) {
+      unsigned special = SpecialBytes(data + i);
+      if (special == 0) {
+        i += 16;
+        continue;
+      }
+      i += CountTrailingZeros(special);
+    } else if (!IsSpecial(data[i])) {
+      i++;
+      continue;
+    }
+#else
+    if (!IsSpecial(data[i])) {
+      i++;
+      continue;
+    }
+#endif
+
+    unsigned char c = static_cast<unsigned char>(data[i]);
+    if (c >= 0x80) {
+      size_t length = Utf8SequenceLength(
+          reinterpret_cast<const unsigned char*>(data + i), size - i);
+      if (length > 0) {
+        // Valid UTF-8 is copied as is.
+        i += length;
+        continue;
+      }
+      output.append(data + run_start, i - run_start);
+      output += kReplacementCharacter;
+    } else {
+      output.append(data + run_start, i - run_start);
+      AppendEscaped(output, c);
+    }
+    i++;
+    run_start = i;
+  }
+
+  output.append(data + run_start, size - run_start);
+  output += '"';
+}
+
+void AppendJson(std::string& output, const JSON& value) {
+  switch (value.type()) {
+    case JSON::value_t::object: {
+      output += '{';
+      bool first = true;
+      for (auto member = value.begin(); member != value.end(); ++member) {
+        if (!first) {
+          output += ',';
+        }
+        first = false;
+        AppendString(output, member.key());
+        output += ':';
+        AppendJson(output, member.value());
+      }
+      output += '}';
+      break;
+    }
+    case JSON::value_t::array: {
+      output += '[';
+      bool first = true;
+      for (const JSON& element : value) {
+        if (!first) {
+          output += ',';
+        }
+        first = false;
+        AppendJson(output, element);
+      }
+      output += ']';
+      break;
+    }
+    case JSON::value_t::string:
+      AppendString(output, value.get_ref<const std::string&>());
+      break;
+    case JSON::value_t::boolean:
+      output += value.get<bool>() ? "true" : "false";
+      break;
+    case JSON::value_t::number_integer:
+      AppendInteger(output, value.get<int64_t>());
+      break;
+    case JSON::value_t::number_unsigned:
+      AppendInteger(output, value.get<uint64_t>());
+      break;
+    case JSON::value_t::null:
+      output += "null";
+      break;
+    case JSON::value_t::binary: {
+      const JSON::binary_t& binary = value.get_binary();
+      if (binary.has_subtype() && binary.subtype() == kRawSubtype) {
+        output.append(reinterpret_cast<const char*>(binary.data()),
+                      binary.size());
+      } else {
+        output += value.dump();
+      }
+      break;
+    }
+    default:
+      // Floating point numbers.
+      output += value.dump();
+      break;
+  }
+}
+
+JSON MakeRaw(std::string_view serialized) {
+  const uint8_t* data = reinterpret_cast<const uint8_t*>(serialized.data());
+  return JSON::binary(
+      JSON::binary_t::container_type(data, data + serialized.size()),
+      kRawSubtype);
+}
+
+}  // namespace json_writer
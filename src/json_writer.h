@@ -0,0 +1,44 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef JSON_WRITER_H_
+#define JSON_WRITER_H_
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+#include "json.hpp"
+
+using JSON = nlohmann::json;
+
+// Serializes JSON values by appending to an existing buffer. The
+// output is the same as JSON::dump() but strings are escaped 16 bytes
+// at a time (SSE2) and copied in runs, which matters for the large
+// text results of tools like executeCommand. Floating point numbers
+// are still written by nlohmann.
+//
+// Unlike JSON::dump(), which throws on invalid UTF-8, each invalid
+// byte is written as U+FFFD so that the output of a command which
+// prints raw memory still gets to the client.
+namespace json_writer {
+
+// Appends text as a quoted and escaped JSON string.
+void AppendString(std::string& output, std::string_view text);
+
+// The binary subtype of the values returned by MakeRaw.
+constexpr std::uint8_t kRawSubtype = 0x52;
+
+// Appends the compact serialization of value.
+void AppendJson(std::string& output, const JSON& value);
+
+// Returns a value which AppendJson writes as is. serialized must be
+// valid JSON. This lets results which rarely change (e.g. tools/list)
+// be serialized once and copied into each response. JSON::dump()
+// writes the value as a binary value so it must only be serialized
+// with AppendJson.
+JSON MakeRaw(std::string_view serialized);
+
+}  // namespace json_writer
+
+#endif  // JSON_WRITER_H_
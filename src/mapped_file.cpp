@@ -0,0 +1,103 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "mapped_file.h"
+
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace mapped_file {
+
+bool MappedFile::Open(const std::filesystem::path& path) {
+  Close();
+
+#if defined(_WIN32)
+  file_ = CreateFileW(path.c_str(), GENERIC_READ,
+                      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                      nullptr, OPEN_EXISTING,
+                      FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN,
+                      nullptr);
+  if (file_ == INVALID_HANDLE_VALUE) {
+    return false;
+  }
+
+  LARGE_INTEGER file_size = {};
+  if (!GetFileSizeEx(file_, &file_size)) {
+    Close();
+    return false;
+  }
+
+  size_ = static_cast<size_t>(file_size.QuadPart);
+  if (size_ > 0) {
+    mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!mapping_) {
+      Close();
+      return false;
+    }
+
+    data_ = static_cast<const char*>(
+        MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (!data_) {
+      Close();
+      return false;
+    }
+  }
+#else
+  fd_ = open(path.c_str(), O_RDONLY);
+  if (fd_ < 0) {
+    return false;
+  }
+
+  struct stat file_stat = {};
+  if (fstat(fd_, &file_stat) != 0) {
+    Close();
+    return false;
+  }
+
+  size_ = static_cast<size_t>(file_stat.st_size);
+  if (size_ > 0) {
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+    if (data == MAP_FAILED) {
+      Close();
+      return false;
+    }
+    data_ = static_cast<const char*>(data);
+  }
+#endif
+
+  open_ = true;
+  return true;
+}
+
+void MappedFile::Close() {
+#if defined(_WIN32)
+  if (data_) {
+    UnmapViewOfFile(data_);
+  }
+  if (mapping_) {
+    CloseHandle(mapping_);
+    mapping_ = nullptr;
+  }
+  if (file_ != INVALID_HANDLE_VALUE) {
+    CloseHandle(file_);
+    file_ = INVALID_HANDLE_VALUE;
+  }
+#else
+  if (data_) {
+    munmap(const_cast<char*>(data_), size_);
+  }
+  if (fd_ >= 0) {
+    close(fd_);
+    fd_ = -1;
+  }
+#endif
+  data_ = nullptr;
+  size_ = 0;
+  open_ = false;
+}
+
+}  // namespace mapped_file
@@ -0,0 +1,49 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef MAPPED_FILE_H_
+#define MAPPED_FILE_H_
+
+#include <cstddef>
+#include <filesystem>
+
+#if defined(_WIN32)
+#include <windows.h>
+#endif
+
+namespace mapped_file {
+
+// Maps a whole file read only into memory. Uses CreateFileMapping on
+// Windows and mmap everywhere else so that the code which parses files
+// can also be built and tested on Linux.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+  ~MappedFile() { Close(); }
+
+  // Returns false if the file can't be opened or mapped. An empty file
+  // is opened successfully but data() is nullptr.
+  bool Open(const std::filesystem::path& path);
+  void Close();
+
+  bool IsOpen() const { return open_; }
+  const char* data() const { return data_; }
+  size_t size() const { return size_; }
+
+ private:
+#if defined(_WIN32)
+  HANDLE file_ = INVALID_HANDLE_VALUE;
+  HANDLE mapping_ = nullptr;
+#else
+  int fd_ = -1;
+#endif
+  const char* data_ = nullptr;
+  size_t size_ = 0;
+  bool open_ = false;
+};
+
+}  // namespace mapped_file
+
+#endif  // MAPPED_FILE_H_
@@ -0,0 +1,316 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "mcp_protocol.h"
+
+#include <utility>
+#include <vector>
+
+#include "json_writer.h"
+
+namespace mcp_protocol {
+
+namespace {
+
+// Builds a Request from the SAX events of a message. An event returns
+// false, which stops the parse, when the message has a shape which
+// isn't handled here (or isn't valid JSON) so that it is decoded from
+// a DOM instead.
+class RequestSaxHandler final : public nlohmann::json_sax<JSON> {
+ public:
+  explicit RequestSaxHandler(Request& request) : request_(request) {}
+
+  bool null() override { return Value(JSON()); }
+  bool boolean(bool value) override { return Value(JSON(value)); }
+  bool number_integer(number_integer_t value) override {
+    return Value(JSON(value));
+  }
+  bool number_unsigned(number_unsigned_t value) override {
+    return Value(JSON(value));
+  }
+  bool number_float(number_float_t value, const string_t&) override {
+    return Value(JSON(value));
+  }
+  bool string(string_t& value) override { return Value(JSON(std::move(value))); }
+  bool binary(binary_t&) override { return false; }
+
+  bool key(string_t& key) override {
+    key_ = std::move(key);
+    return true;
+  }
+
+  bool start_object(std::size_t) override {
+    return StartContainer(JSON::object());
+  }
+  bool start_array(std::size_t) override {
+    return StartContainer(JSON::array());
+  }
+  bool end_object() override { return EndContainer(); }
+  bool end_array() override { return EndContainer(); }
+
+  bool parse_error(std::size_t,
+                   const std::string&,
+                   const nlohmann::detail::exception&) override {
+    return false;
+  }
+
+ private:
+  // The levels of the message which are decoded here. Everything
+  // below them is built as JSON.
+  enum Depth { kBeforeMessage = 0, kMessage = 1, kParams = 2 };
+
+  bool Value(JSON&& value) {
+    if (skip_depth_ > 0) {
+      return true;
+    }
+    if (!building_.empty()) {
+      Add(std::move(value));
+      return true;
+    }
+
+    if (depth_ == kMessage) {
+      if (key_ == "id") {
+        request_.id = std::move(value);
+      } else if (key_ == "method") {
+        if (!value.is_string()) {
+          return false;
+        }
+        request_.method = std::move(value.get_ref<std::string&>());
+      } else if (key_ == "params") {
+        return false;
+      }
+      // Other members (e.g. jsonrpc) aren't used.
+      return true;
+    }
+
+    if (depth_ == kParams) {
+      if (key_ == "arguments") {
+        return false;
+      }
+      if (key_ == "name" && value.is_string()) {
+        request_.tool_name = value.get_ref<const std::string&>();
+      }
+      request_.params[key_] = std::move(value);
+      return true;
+    }
+
+    // The message isn't an object.
+    return false;
+  }
+
+  bool StartContainer(JSON&& container) {
+    if (skip_depth_ > 0) {
+      skip_depth_++;
+      return true;
+    }
+    if (!building_.empty()) {
+      building_.push_back(Add(std::move(container)));
+      return true;
+    }
+
+    if (depth_ == kBeforeMessage) {
+      if (!container.is_object()) {
+        return false;
+      }
+      depth_ = kMessage;
+      return true;
+    }
+
+    if (depth_ == kMessage) {
+      if (key_ == "params" && container.is_object()) {
+        request_.params = JSON::object();
+        request_.tool_name.clear();
+        request_.arguments = JSON::object();
+        depth_ = kParams;
+        return true;
+      } else if (key_ == "id" || key_ == "method" || key_ == "params") {
+        return false;
+      }
+      // An unused member.
+      skip_depth_ = 1;
+      return true;
+    }
+
+    if (key_ == "arguments") {
+      if (!container.is_object()) {
+        return false;
+      }
+      request_.arguments = JSON::object();
+      building_.push_back(&request_.arguments);
+      return true;
+    }
+    JSON& member = request_.params[key_];
+    member = std::move(container);
+    building_.push_back(&member);
+    return true;
+  }
+
+  bool EndContainer() {
+    if (skip_depth_ > 0) {
+      skip_depth_--;
+    } else if (!building_.empty()) {
+      building_.pop_back();
+    } else {
+      depth_--;
+    }
+    return true;
+  }
+
+  // Adds value to the container which is being built and returns
+  // the added value. Only the last value of an array is added to
+  // after it is returned so the pointer stays valid.
+  JSON* Add(JSON&& value) {
+    JSON& container = *building_.back();
+    if (container.is_object()) {
+      JSON& member = container[key_];
+      member = std::move(value);
+      return &member;
+    }
+    container.push_back(std::move(value));
+    return &container.back();
+  }
+
+  Request& request_;
+  int depth_ = kBeforeMessage;
+  // The nesting depth inside an unused member.
+  int skip_depth_ = 0;
+  // The containers of the params member or arguments which is built.
+  std::vector<JSON*> building_;
+  std::string key_;
+};
+
+}  // namespace
+
+JSON CreateResponse(const JSON& id, JSON result) {
+  JSON response = {{"jsonrpc", "2.0"}};
+  response["result"] = std::move(result);
+  if (!id.is_null()) {
+    response["id"] = id;
+  }
+  return response;
+}
+
+JSON CreateError(const JSON& id, int code, const std::string& message) {
+  JSON response = {{"jsonrpc", "2.0"},
+                   {"error", {{"code", code}, {"message", message}}}};
+  if (!id.is_null()) {
+    response["id"] = id;
+  }
+  return response;
+}
+
+JSON CreateNotification(const std::string& method, const JSON& params) {
+  return JSON{{"jsonrpc", "2.0"}, {"method", method}, {"params", params}};
+}
+
+JSON CreateToolResult(JSON result) {
+  if (result.is_object() && result.contains("error")) {
+    // Error case
+    return JSON{
+        {"content",
+         JSON::array({{{"type", "text"},
+                       {"text", "Error: " + result["error"].get<std::string>()}}})},
+        {"isError", true}};
+  }
+
+  // The output of a command can be megabytes so it is moved into
+  // the content instead of being copied.
+  JSON content = {{"type", "text"}};
+  content["text"] = std::move(result.get_ref<std::string&>());
+  JSON tool_result = JSON::object();
+  tool_result["content"] = JSON::array();
+  tool_result["content"].push_back(std::move(content));
+  return tool_result;
+}
+
+void MessageFramer::Append(const char* data, size_t size) {
+  if (start_ > 0 && start_ == buffer_.size()) {
+    buffer_.clear();
+    start_ = 0;
+    scan_ = 0;
+  } else if (start_ > 0) {
+    buffer_.erase(0, start_);
+    scan_ -= start_;
+    start_ = 0;
+  }
+  buffer_.append(data, size);
+}
+
+bool MessageFramer::Next(std::string& message) {
+  size_t pos = buffer_.find('\n', scan_);
+  if (pos == std::string::npos) {
+    scan_ = buffer_.size();
+    return false;
+  }
+
+  message.assign(buffer_, start_, pos - start_);
+  start_ = pos + 1;
+  scan_ = start_;
+  return true;
+}
+
+Request DecodeRequest(const std::string& message) {
+  Request request;
+  RequestSaxHandler handler(request);
+  if (JSON::sax_parse(message, &handler)) {
+    return request;
+  }
+
+  // Throws the parse error if the message isn't valid JSON.
+  return RequestFromJson(JSON::parse(message));
+}
+
+Request RequestFromJson(JSON message) {
+  Request request;
+  if (!message.is_object()) {
+    return request;
+  }
+
+  if (message.contains("id")) {
+    request.id = std::move(message["id"]);
+  }
+  if (message.contains("method") && message["method"].is_string()) {
+    request.method = std::move(message["method"].get_ref<std::string&>());
+  }
+  if (!message.contains("params")) {
+    return request;
+  }
+
+  request.params = std::move(message["params"]);
+  if (request.params.is_object()) {
+    auto name = request.params.find("name");
+    if (name != request.params.end() && name->is_string()) {
+      request.tool_name = name->get<std::string>();
+    }
+    auto arguments = request.params.find("arguments");
+    if (arguments != request.params.end() && arguments->is_object()) {
+      request.arguments = std::move(*arguments);
+      request.params.erase(arguments);
+    }
+  }
+  return request;
+}
+
+void ProcessMessage(const std::string& message,
+                    const RequestHandler& handler,
+                    std::string& output) {
+  size_t start = output.size();
+  try {
+    json_writer::AppendJson(output, handler(DecodeRequest(message)));
+  } catch (const std::exception& e) {
+    output.resize(start);
+    json_writer::AppendJson(
+        output, CreateError("", kParseError,
+                            std::string("Parse error: ") + e.what()));
+  }
+  output += '\n';
+}
+
+std::string ProcessMessage(const std::string& message,
+                           const RequestHandler& handler) {
+  std::string output;
+  ProcessMessage(message, handler, output);
+  return output;
+}
+
+}  // namespace mcp_protocol
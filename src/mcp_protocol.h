@@ -0,0 +1,97 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef MCP_PROTOCOL_H_
+#define MCP_PROTOCOL_H_
+
+#include <functional>
+#include <string>
+
+#include "json.hpp"
+
+using JSON = nlohmann::json;
+
+namespace mcp_protocol {
+
+// JSON-RPC error codes
+constexpr int kParseError = -32700;
+constexpr int kInvalidParams = -32602;
+constexpr int kMethodNotFound = -32601;
+constexpr int kInternalError = -32603;
+
+// The result is taken by value so that large results which are
+// passed as temporaries are moved instead of copied.
+JSON CreateResponse(const JSON& id, JSON result);
+JSON CreateError(const JSON& id, int code, const std::string& message);
+JSON CreateNotification(const std::string& method, const JSON& params);
+
+// Wrap the result of a tool handler in the MCP tool result format.
+// Handlers return either a string containing the output or an
+// object with an "error" member.
+JSON CreateToolResult(JSON result);
+
+// Splits the bytes received from a client into newline terminated
+// messages. Consumed messages are only removed from the buffer once
+// all of the complete messages of a receive have been read so that
+// pipelined requests don't move the rest of the buffer per message.
+class MessageFramer {
+ public:
+  void Append(const char* data, size_t size);
+
+  // Returns false if there is no complete message.
+  bool Next(std::string& message);
+
+  // The number of bytes of the incomplete message.
+  size_t GetBufferedSize() const { return buffer_.size() - start_; }
+
+ private:
+  std::string buffer_;
+  size_t start_ = 0;
+  // Where to continue looking for the newline.
+  size_t scan_ = 0;
+};
+
+// A decoded JSON-RPC request. The members of params which are used by
+// tools/call are taken out of params.
+struct Request {
+  // Null if the request has no id (a notification).
+  JSON id;
+  std::string method;
+  // params without "arguments" if the arguments are an object.
+  JSON params = JSON::object();
+  // params.name if it is a string.
+  std::string tool_name;
+  // params.arguments if it is an object.
+  JSON arguments = JSON::object();
+};
+
+// Decodes a message with nlohmann's SAX interface. The values are
+// built directly in the Request instead of parsing the whole message
+// and copying params and arguments out of it. Messages which aren't
+// an object with a scalar id, string method and object params and
+// arguments are decoded with RequestFromJson. Throws JSON::parse_error
+// if the message isn't valid JSON.
+Request DecodeRequest(const std::string& message);
+
+// Decodes a parsed message. A message which isn't an object or whose
+// method isn't a string has an empty method.
+Request RequestFromJson(JSON message);
+
+using RequestHandler = std::function<JSON(const Request& request)>;
+
+// Decodes a message, passes the request to handler and appends the
+// serialized response followed by a newline to output. Messages which
+// can't be parsed and handlers which throw result in a parse error
+// response. The response is serialized with json_writer so output can
+// be a buffer which is reused for every message of a connection.
+void ProcessMessage(const std::string& message,
+                    const RequestHandler& handler,
+                    std::string& output);
+
+// The same as above but returns the response.
+std::string ProcessMessage(const std::string& message,
+                           const RequestHandler& handler);
+
+}  // namespace mcp_protocol
+
+#endif  // MCP_PROTOCOL_H_
@@ -1,352 +1,479 @@
 // Copyright (c) 2025 Piet Hein Schouten
 // SPDX-License-Identifier: MIT
 
-// Prevent windows.h from including winsock.h to avoid
-// duplicate definition errors when including winsock2.h
-#define WIN32_LEAN_AND_MEAN
-#include <winsock2.h>
-#include <ws2tcpip.h>
-
 #include <dbgeng.h>
 #include <windows.h>
 #include <atomic>
 #include <chrono>
-#include <condition_variable>
-#include <future>
+#include <cstdint>
 #include <map>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <regex>
 #include <set>
 #include <string>
 #include <thread>
 
+#include "command_queue.h"
+#include "debug_event_callbacks.h"
+#include "event_journal.h"
+#include "execution_context.h"
+#include "expression_evaluator.h"
 #include "json.hpp"
+#include "json_writer.h"
+#include "mcp_protocol.h"
+#include "mcp_transport.h"
+#include "memory_dump.h"
+#include "memory_search.h"
+#include "minidump_tools.h"
+#include "output_compactor.h"
+#include "server_shutdown.h"
+#include "stack_sampler.h"
+#include "state_snapshot.h"
+#include "step_tracer.h"
+#include "symbol_cache.h"
+#include "symbol_index.h"
+#include "tool_registry.h"
+#include "trace.h"
 #include "utils.h"
 
-// Include Ws2_32.lib for socket functions when linking
-#pragma comment(lib, "Ws2_32.lib")
-
 using JSON = nlohmann::json;
+using mcp_protocol::CreateError;
+using mcp_protocol::CreateResponse;
+using mcp_protocol::CreateToolResult;
+using mcp_protocol::Request;
+using mcp_transport::ClientId;
 
 class MCPServer;
 MCPServer* g_mcp_server = nullptr;
 
+// The client whose request is handled on the current thread. The
+// engine operations of the request are queued in its session of the
+// command queue.
+thread_local ClientId g_request_client = command_queue::kDefaultSession;
+
+class ServerEventCallbacks;
+
 utils::DebugInterfaces g_debug;
 
+// Set when a server was stopped with a thread still running. That
+// thread keeps using g_debug and the code of this module.
+bool g_threads_left_running = false;
+
 class MCPServer {
  public:
-  MCPServer() : running_(false), server_socket_(INVALID_SOCKET), port_(0) {}
+  MCPServer() : running_(false), port_(0) {
+    output_compactor_.AddDefaultPasses();
+    for (JSON& tool : GetToolDefinitions()) {
+      tools_.Register(std::move(tool));
+    }
+  }
   ~MCPServer() { Stop(); }
 
   HRESULT Start(int port);
+  // Drains the requests in progress and breaks into the engine if they
+  // don't finish in time. Returns HRESULT_FROM_WIN32(ERROR_TIMEOUT) if
+  // a thread is still running after that, in which case the server
+  // must not be deleted (see HasStopTimedOut) and the module is pinned.
   HRESULT Stop();
   bool IsRunning() const { return running_; }
+  bool HasStopTimedOut() const { return stop_timed_out_; }
   int GetPort() const { return port_; }
 
- private:
-  // Server management
-  void ServerThread();
-  void ClientHandler(SOCKET client_socket);
+  // Called by the event callbacks when the target breaks. Queues a
+  // snapshot of the state for diffState. Only one snapshot is queued
+  // at a time.
+  void OnBreak();
 
+  // Called by the event callbacks when symbols are loaded or unloaded
+  // (e.g. by .reload) so that the cached symbols aren't served.
+  void OnChangeSymbolState(ULONG flags, ULONG64 argument) {
+    symbol_cache_.OnChangeSymbolState(flags, argument);
+  }
+
+  // The debug events recorded by the event callbacks. Used by
+  // getEvents and !Events.
+  event_journal::EventJournal& GetEventJournal() { return event_journal_; }
+
+  // The tools which are listed by tools/list. Used by !MCPServerTools
+  // to enable and disable tools.
+  tool_registry::ToolRegistry& GetToolRegistry() { return tools_; }
+
+  // Each client has a session in the command queue. Used by
+  // !MCPServerSessions to show and change the sessions.
+  command_queue::CommandQueue& GetCommandQueue() { return command_queue_; }
+
+ private:
   // MCP protocol handlers
-  JSON HandleRequest(const JSON& request);
-  JSON CreateResponse(const JSON& id, const JSON& result);
-  JSON CreateError(const JSON& id, int code, const std::string& message);
-  JSON HandleInitialize(const JSON& params);
+  JSON HandleRequest(const Request& request, ClientId client);
+  JSON HandleInitialize(const JSON& params, ClientId client);
   JSON HandleToolsList(const JSON& params);
-  JSON HandleToolsCall(const JSON& params);
+  static JSON GetToolDefinitions();
+  JSON HandleToolsCall(const Request& request, ClientId client);
+  void SendNotification(ClientId client,
+                        const std::string& method,
+                        const JSON& params);
 
   // WinDbg command handlers
-  JSON ExecuteCommand(const JSON& params);
-  JSON GetDebuggerState(const JSON& params);
-
-  // Process all WinDbg commands on
-  // the same thread sequentially
-  void ProcessCommandQueue();
-  void CommandProcessorThread();
+  JSON ExecuteCommand(const JSON& params, ClientId client);
+  JSON GetDebuggerState(const JSON& params, ClientId client);
+  JSON SearchMemory(const JSON& params);
+  JSON Evaluate(const JSON& params);
+  JSON SampleStacks(const JSON& params);
+  JSON TraceSteps(const JSON& params);
+  JSON GetTrace(const JSON& params);
+  JSON Symbolize(const JSON& params);
+  JSON FindSymbols(const JSON& params);
+  JSON DiffState(const JSON& params);
+  JSON GetEvents(const JSON& params);
+  JSON DumpMemory(const JSON& params,
+                  ClientId client,
+                  const JSON& progress_token);
 
   // Thread-safe wrapper for debug operations
   JSON ExecuteOnMainThread(std::function<JSON()> operation);
 
+  // Queues an operation on the command processor
+  // thread without waiting for the result.
+  void PostToMainThread(std::function<JSON()> operation);
+
+  // Captures the current state into snapshots_ if the target is
+  // broken in. Must be run on the command processor thread.
+  void CaptureSnapshot();
+
   // Member variables
   std::atomic<bool> running_;
-  SOCKET server_socket_;
   int port_;
-  std::thread server_thread_;
-
-  // Add thread tracking for client socket handlers
-  std::mutex clients_mutex_;
-  std::set<std::thread::id> active_clients_;
-  std::condition_variable clients_cv_;
-
-  // Member variables to track client sockets
-  std::set<SOCKET> client_sockets_;
-  std::mutex client_sockets_mutex_;
-
-  // Command queue for thread-safe operations
-  struct DebugCommand {
-    std::function<JSON()> operation;
-    std::promise<JSON> result;
-  };
-
-  // Command queue which is used to process
-  // all commands on a single thread.
-  std::queue<std::unique_ptr<DebugCommand>> command_queue_;
-  std::mutex queue_mutex_;
-  std::condition_variable queue_cv_;
-  std::thread command_processor_thread_;
+  bool stop_timed_out_ = false;
+
+  // Accepts the clients and reads their requests.
+  mcp_transport::SocketServer transport_;
+
+  // Command queue which is used to process all commands on a single
+  // thread. Each client has its own session so that one client can't
+  // starve the others.
+  command_queue::CommandQueue command_queue_;
+
+  // The most recent traces recorded by traceSteps.
+  step_tracer::TraceStore traces_{16};
+
+  // Shared by all of the tools which return symbols.
+  // Only used on the command processor thread.
+  symbol_cache::SymbolCache symbol_cache_{&g_debug};
+
+  // Symbol name indexes used by findSymbols. The indexes are
+  // saved next to the extension so they are only built once
+  // for each build of a module.
+  symbol_index::SymbolIndexStore symbol_indexes_{
+      &g_debug, utils::GetCurrentExtensionDir() + "\\symbol_index"};
+
+  // The last execution context sent to each client so that
+  // executeCommand only returns the parts which changed.
+  execution_context::ContextCache context_cache_;
+
+  // The definitions and compiled input schemas of the tools. The
+  // arguments of every tools/call are validated against the schemas.
+  tool_registry::ToolRegistry tools_;
+
+  // Removes the redundancy of large outputs (e.g. identical thread
+  // stacks) before they are returned by executeCommand.
+  output_compactor::Compactor output_compactor_;
+
+  // Snapshots of the state at each break which are compared by
+  // diffState. Only used on the command processor thread.
+  state_snapshot::SnapshotStore snapshots_{64};
+  state_snapshot::SnapshotCapturer snapshot_capturer_{
+      &g_debug, [this](ULONG64 address) {
+        return symbol_cache_.Symbolize(address).ToString();
+      }};
+  std::atomic<bool> snapshot_pending_{false};
+  // Breaks are not captured while a tool steps or samples the target
+  // since that breaks in many times. The tool captures the final state.
+  std::atomic<int> snapshots_paused_{0};
+  ServerEventCallbacks* event_callbacks_ = nullptr;
+
+  // Written by the event callbacks on the engine thread and read
+  // by getEvents without going through the command queue.
+  event_journal::EventJournal event_journal_{4096};
+
+  // The minidump tools don't use the debugger engine so they run
+  // on their own thread pool instead of the command queue.
+  minidump::MinidumpTools minidump_tools_;
 };
 
-HRESULT MCPServer::Start(int port) {
-  if (running_) {
-    return E_FAIL;
-  }
-
-  // Initialize Winsock
-  WSADATA wsa_data;
-  if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
-    return E_FAIL;
+// Snapshots the state at every break and records the debug events
+// in the event journal. The event methods only record the event and
+// don't change how the engine handles it.
+class ServerEventCallbacks : public DebugEventCallbacks {
+ public:
+  explicit ServerEventCallbacks(MCPServer* server)
+      : DebugEventCallbacks(
+            DEBUG_EVENT_CHANGE_ENGINE_STATE | DEBUG_EVENT_BREAKPOINT |
+            DEBUG_EVENT_EXCEPTION | DEBUG_EVENT_CREATE_THREAD |
+            DEBUG_EVENT_EXIT_THREAD | DEBUG_EVENT_CREATE_PROCESS |
+            DEBUG_EVENT_EXIT_PROCESS | DEBUG_EVENT_LOAD_MODULE |
+            DEBUG_EVENT_UNLOAD_MODULE | DEBUG_EVENT_CHANGE_SYMBOL_STATE),
+        server_(server) {}
+
+  STDMETHOD(ChangeEngineState)(ULONG flags, ULONG64 argument) {
+    if ((flags & DEBUG_CES_EXECUTION_STATUS) &&
+        (argument & DEBUG_STATUS_INSIDE_WAIT) == 0 &&
+        (argument & DEBUG_STATUS_MASK) == DEBUG_STATUS_BREAK) {
+      server_->OnBreak();
+    }
+    return S_OK;
   }
 
-  // Create socket
-  server_socket_ = socket(AF_INET, SOCK_STREAM, 0);
-  if (server_socket_ == INVALID_SOCKET) {
-    WSACleanup();
-    return E_FAIL;
+  STDMETHOD(ChangeSymbolState)(ULONG flags, ULONG64 argument) {
+    server_->OnChangeSymbolState(flags, argument);
+    return S_OK;
   }
 
-  // Bind socket
-  sockaddr_in server_addr = {};
-  server_addr.sin_family = AF_INET;
-  server_addr.sin_addr.s_addr = INADDR_ANY;
-  server_addr.sin_port = htons(port);
-
-  if (bind(server_socket_, (sockaddr*)&server_addr, sizeof(server_addr)) ==
-      SOCKET_ERROR) {
-    closesocket(server_socket_);
-    WSACleanup();
-    return E_FAIL;
+  STDMETHOD(Breakpoint)(PDEBUG_BREAKPOINT bp) {
+    ULONG id = 0;
+    ULONG64 offset = 0;
+    bp->GetId(&id);
+    bp->GetOffset(&offset);
+    Record(event_journal::EventType::kBreakpoint, offset, id);
+    return DEBUG_STATUS_NO_CHANGE;
   }
 
-  // Listen
-  if (listen(server_socket_, SOMAXCONN) == SOCKET_ERROR) {
-    closesocket(server_socket_);
-    WSACleanup();
-    return E_FAIL;
+  STDMETHOD(Exception)(PEXCEPTION_RECORD64 exception, ULONG first_chance) {
+    Record(event_journal::EventType::kException, exception->ExceptionAddress,
+           exception->ExceptionCode, "", first_chance != 0);
+    return DEBUG_STATUS_NO_CHANGE;
   }
 
-  // Get actual port if 0 was specified
-  int addr_len = sizeof(server_addr);
-  if (getsockname(server_socket_, (sockaddr*)&server_addr, &addr_len) == 0) {
-    port_ = ntohs(server_addr.sin_port);
-  } else {
-    port_ = port;
+  STDMETHOD(CreateThread)(ULONG64 handle,
+                          ULONG64 data_offset,
+                          ULONG64 start_offset) {
+    Record(event_journal::EventType::kCreateThread, start_offset, 0);
+    return DEBUG_STATUS_NO_CHANGE;
   }
 
-  // Start server thread
-  running_ = true;
-  server_thread_ = std::thread(&MCPServer::ServerThread, this);
-
-  // Start command processor thread
-  command_processor_thread_ =
-      std::thread(&MCPServer::CommandProcessorThread, this);
-
-  return S_OK;
-}
-
-HRESULT MCPServer::Stop() {
-  if (!running_) {
-    return S_OK;
+  STDMETHOD(ExitThread)(ULONG exit_code) {
+    Record(event_journal::EventType::kExitThread, 0, exit_code);
+    return DEBUG_STATUS_NO_CHANGE;
   }
 
-  running_ = false;
-  queue_cv_.notify_all();  // Wake up command processor
-
-  // Close server socket to unblock accept()
-  if (server_socket_ != INVALID_SOCKET) {
-    closesocket(server_socket_);
-    server_socket_ = INVALID_SOCKET;
+  STDMETHOD(CreateProcess)(ULONG64 image_file_handle,
+                           ULONG64 handle,
+                           ULONG64 base_offset,
+                           ULONG module_size,
+                           PCSTR module_name,
+                           PCSTR image_name,
+                           ULONG check_sum,
+                           ULONG time_date_stamp,
+                           ULONG64 initial_thread_handle,
+                           ULONG64 thread_data_offset,
+                           ULONG64 start_offset) {
+    Record(event_journal::EventType::kCreateProcess, base_offset, 0,
+           module_name ? module_name : "");
+    return DEBUG_STATUS_NO_CHANGE;
   }
 
-  // Wait for server thread
-  if (server_thread_.joinable()) {
-    server_thread_.join();
+  STDMETHOD(ExitProcess)(ULONG exit_code) {
+    Record(event_journal::EventType::kExitProcess, 0, exit_code);
+    return DEBUG_STATUS_NO_CHANGE;
   }
 
-  // Wait for command processor thread
-  if (command_processor_thread_.joinable()) {
-    command_processor_thread_.join();
+  STDMETHOD(LoadModule)(ULONG64 image_file_handle,
+                        ULONG64 base_offset,
+                        ULONG module_size,
+                        PCSTR module_name,
+                        PCSTR image_name,
+                        ULONG check_sum,
+                        ULONG time_date_stamp) {
+    // module_name: "chrome"
+    Record(event_journal::EventType::kLoadModule, base_offset, module_size,
+           module_name ? module_name : "");
+    return DEBUG_STATUS_NO_CHANGE;
   }
 
-  // Process any remaining commands
-  ProcessCommandQueue();
-
-  // Force close all client sockets to unblock recv() calls
-  {
-    std::lock_guard<std::mutex> lock(client_sockets_mutex_);
-    for (SOCKET sock : client_sockets_) {
-      shutdown(sock, SD_BOTH);
-      closesocket(sock);
+  STDMETHOD(UnloadModule)(PCSTR image_base_name, ULONG64 base_offset) {
+    // image_base_name: "chrome.dll". Remove the extension so
+    // that the name matches the name of the load event.
+    std::string name = image_base_name ? image_base_name : "";
+    size_t extension = name.rfind('.');
+    if (extension != std::string::npos) {
+      name.erase(extension);
     }
+    Record(event_journal::EventType::kUnloadModule, base_offset, 0, name);
+    return DEBUG_STATUS_NO_CHANGE;
   }
 
-  // Wait for all client threads to finish
-  {
-    std::unique_lock<std::mutex> lock(clients_mutex_);
-    clients_cv_.wait(lock, [this] { return active_clients_.empty(); });
+ private:
+  // The current process and thread are the ones of the event.
+  void Record(event_journal::EventType type,
+              ULONG64 address,
+              ULONG64 argument,
+              const std::string& module = "",
+              bool first_chance = false) {
+    ULONG process_id = 0;
+    ULONG thread_id = 0;
+    g_debug.system_objects->GetCurrentProcessSystemId(&process_id);
+    g_debug.system_objects->GetCurrentThreadSystemId(&thread_id);
+    server_->GetEventJournal().Append(type, process_id, thread_id, address,
+                                      argument, module, first_chance);
   }
 
-  WSACleanup();
-  return S_OK;
-}
-
-void MCPServer::ServerThread() {
-  while (running_) {
-    sockaddr_in client_addr = {};
-    int client_len = sizeof(client_addr);
+  MCPServer* server_;
+};
 
-    SOCKET client_socket =
-        accept(server_socket_, (sockaddr*)&client_addr, &client_len);
-    if (client_socket == INVALID_SOCKET) {
-      if (running_) {
-        // Real error, not shutdown
-        Sleep(100);
-      }
-      continue;
-    }
+HRESULT MCPServer::Start(int port) {
+  if (running_) {
+    return E_FAIL;
+  }
 
-    // Handle client in separate thread, but track it
-    std::thread client_thread([this, client_socket]() {
-      // Register this thread and socket
-      {
-        std::lock_guard<std::mutex> lock(clients_mutex_);
-        active_clients_.insert(std::this_thread::get_id());
-      }
-      {
-        std::lock_guard<std::mutex> lock(client_sockets_mutex_);
-        client_sockets_.insert(client_socket);
-      }
+  // Start command processor thread
+  snapshot_pending_ = false;
+  command_queue_.Start();
 
-      ClientHandler(client_socket);
+  auto handler = [this](const Request& request, ClientId client) {
+    return HandleRequest(request, client);
+  };
+  auto on_disconnect = [this](ClientId client) {
+    context_cache_.RemoveClient(client);
+    command_queue_.RemoveSession(client);
+  };
 
-      // Unregister this thread and socket
-      {
-        std::lock_guard<std::mutex> lock(client_sockets_mutex_);
-        client_sockets_.erase(client_socket);
-      }
-      {
-        std::lock_guard<std::mutex> lock(clients_mutex_);
-        active_clients_.erase(std::this_thread::get_id());
-        clients_cv_.notify_all();
-      }
-    });
-    client_thread.detach();
+  // Clients which cache the tools are told when they change.
+  tools_.SetChangedCallback([this](uint64_t version) {
+    transport_.Broadcast(mcp_protocol::CreateNotification(
+                             "notifications/tools/list_changed",
+                             JSON::object())
+                             .dump() +
+                         "\n");
+  });
+  if (!transport_.Start(port, handler, on_disconnect)) {
+    command_queue_.Stop();
+    return E_FAIL;
   }
-}
+  port_ = transport_.GetPort();
+  running_ = true;
 
-void MCPServer::ClientHandler(SOCKET client_socket) {
-  char buffer[4096];
-  std::string message_buffer;
+  // Snapshot the state at every break and record the debug events.
+  // The server still works without them if the callbacks can't be set.
+  event_callbacks_ = new ServerEventCallbacks(this);
+  if (FAILED(g_debug.client->SetEventCallbacks(event_callbacks_))) {
+    event_callbacks_->Release();
+    event_callbacks_ = nullptr;
+  }
 
-  while (running_) {
-    int bytes_received = recv(client_socket, buffer, sizeof(buffer), 0);
-    if (bytes_received <= 0) {
-      break;
-    }
+  // The state when the server starts is the first snapshot.
+  OnBreak();
 
-    message_buffer.append(buffer, bytes_received);
+  return S_OK;
+}
 
-    // Simple message framing: messages end with \n
-    size_t pos;
-    while ((pos = message_buffer.find('\n')) != std::string::npos) {
-      std::string message = message_buffer.substr(0, pos);
-      message_buffer.erase(0, pos + 1);
+HRESULT MCPServer::Stop() {
+  if (!running_) {
+    return S_OK;
+  }
 
-      try {
-        JSON request = JSON::parse(message);
-        JSON response = HandleRequest(request);
-
-        std::string response_str = response.dump() + "\n";
-        send(client_socket, response_str.c_str(), (int)response_str.length(),
-             0);
-      } catch (const std::exception& e) {
-        JSON error =
-            // JSON-RPC error response
-            // -32700 - Parse error: Invalid JSON was received by the server
-            CreateError("", -32700, std::string("Parse error: ") + e.what());
-        std::string error_str = error.dump() + "\n";
-        send(client_socket, error_str.c_str(), (int)error_str.length(), 0);
-      }
-    }
+  if (event_callbacks_) {
+    g_debug.client->SetEventCallbacks(nullptr);
+    event_callbacks_->Release();
+    event_callbacks_ = nullptr;
   }
 
-  closesocket(client_socket);
+  running_ = false;
+  tools_.SetChangedCallback(nullptr);
+
+  // A "g" run by executeCommand only returns when the target breaks
+  // so the engine is interrupted if the requests don't finish.
+  server_shutdown::Options options;
+  options.interrupt = []() {
+    g_debug.control->SetInterrupt(DEBUG_INTERRUPT_ACTIVE);
+  };
+  server_shutdown::Result result =
+      server_shutdown::Shutdown(transport_, command_queue_, options);
+  if (!result.completed) {
+    // Unloading the extension would unmap the code which the threads
+    // still run, so the module is pinned until the process exits.
+    HMODULE module = nullptr;
+    GetModuleHandleEx(
+        GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_PIN,
+        (LPCSTR)&g_debug, &module);
+    g_threads_left_running = true;
+    stop_timed_out_ = true;
+    return HRESULT_FROM_WIN32(ERROR_TIMEOUT);
+  }
+  return S_OK;
 }
 
 // This method is run from one of the client handler threads
-JSON MCPServer::HandleRequest(const JSON& request) {
+JSON MCPServer::HandleRequest(const Request& request, ClientId client) {
+  g_request_client = client;
   try {
-    std::string method = request.value("method", "");
-    JSON params = request.value("params", JSON::object());
+    const std::string& method = request.method;
+    const JSON& params = request.params;
 
-    // Handle id as JSON value (can be string, number, or null)
-    JSON id = nullptr;
-    if (request.contains("id")) {
-      id = request["id"];
-    }
+    // The id can be a string, number, or null
+    const JSON& id = request.id;
 
     // MCP Protocol methods
     if (method == "initialize") {
-      return CreateResponse(id, HandleInitialize(params));
+      return CreateResponse(id, HandleInitialize(params, client));
     } else if (method == "initialized") {
       // This is a notification, no response needed
       return JSON::object();
     } else if (method == "tools/list") {
       return CreateResponse(id, HandleToolsList(params));
     } else if (method == "tools/call") {
-      return CreateResponse(id, HandleToolsCall(params));
+      if (params.contains("arguments")) {
+        return CreateError(id, mcp_protocol::kInvalidParams,
+                           "The arguments must be an object");
+      }
+      std::string error = tools_.Validate(request.tool_name, request.arguments);
+      if (!error.empty()) {
+        return CreateError(
+            id, mcp_protocol::kInvalidParams,
+            "Invalid arguments for " + request.tool_name + ": " + error);
+      }
+      return CreateResponse(id, HandleToolsCall(request, client));
     } else {
-      return CreateError(id, -32601, "Method not found: " + method);
+      return CreateError(id, mcp_protocol::kMethodNotFound,
+                         "Method not found: " + method);
     }
   } catch (const std::exception& e) {
-    return CreateError(nullptr, -32603,
+    return CreateError(nullptr, mcp_protocol::kInternalError,
                        std::string("Internal error: ") + e.what());
   }
 }
 
-JSON MCPServer::CreateResponse(const JSON& id, const JSON& result) {
-  JSON response = {{"jsonrpc", "2.0"}, {"result", result}};
-  if (!id.is_null()) {
-    response["id"] = id;
+JSON MCPServer::HandleInitialize(const JSON& params, ClientId client) {
+  // Clients with a person in the loop can ask to be served before
+  // the agents with "_meta": {"priority": "interactive"}.
+  if (params.contains("_meta") && params["_meta"].is_object() &&
+      params["_meta"].contains("priority")) {
+    const JSON& priority = params["_meta"]["priority"];
+    command_queue::SessionOptions options =
+        command_queue_.GetSessionOptions(client);
+    options.priority = priority == "interactive"
+                           ? command_queue::Priority::kInteractive
+                           : command_queue::Priority::kNormal;
+    command_queue_.SetSessionOptions(client, options);
   }
-  return response;
-}
-
-JSON MCPServer::CreateError(const JSON& id,
-                            int code,
-                            const std::string& message) {
-  JSON response = {{"jsonrpc", "2.0"},
-                   {"error", {{"code", code}, {"message", message}}}};
-  if (!id.is_null()) {
-    response["id"] = id;
-  }
-  return response;
-}
 
-JSON MCPServer::HandleInitialize(const JSON& params) {
-  // MCP initialization response
-  return JSON{
+  // MCP initialization response. It never changes so it is
+  // only serialized once.
+  static const std::string result = JSON{
       {"protocolVersion", "0.1.0"},
       {"capabilities", {{"tools", {{"listChanged", true}}}, {"prompts", {}}}},
-      {"serverInfo", {{"name", "windbg-mcp-server"}, {"version", "1.0.0"}}}};
+      {"serverInfo", {{"name", "windbg-mcp-server"}, {"version", "1.0.0"}}}}
+                                        .dump();
+  return json_writer::MakeRaw(result);
 }
 
 JSON MCPServer::HandleToolsList(const JSON& params) {
-  // Return list of available tools in MCP format
-  return JSON{
-      {"tools",
+  // The registry caches the serialized list until the tools change
+  return json_writer::MakeRaw(*tools_.GetToolsList());
+}
+
+JSON MCPServer::GetToolDefinitions() {
+  // The definitions of the tools in MCP format
+  JSON tools =
        JSON::array({{{"name", "executeCommand"},
                      {"description", "Execute a WinDbg command"},
                      {"inputSchema",
@@ -354,7 +481,20 @@ JSON MCPServer::HandleToolsList(const JSON& params) {
                        {"properties",
                         {{"command",
                           {{"type", "string"},
-                           {"description", "The WinDbg command to execute"}}}}},
+                           {"description", "The WinDbg command to execute"}}},
+                         {"fullContext",
+                          {{"type", "boolean"},
+                           {"description",
+                            "Return the full execution context after g, gu, "
+                            "p and t instead of only the parts which changed "
+                            "since the last response (default: false)"}}},
+                         {"raw",
+                          {{"type", "boolean"},
+                           {"description",
+                            "Return the command output exactly as printed "
+                            "instead of folding repeated lines, identical "
+                            "thread stacks and zero filled memory rows "
+                            "(default: false)"}}}}},
                        {"required", JSON::array({"command"})}}}},
                     {{"name", "getDebuggerState"},
                      {"description", "Get the current debugger state"},
@@ -363,151 +503,374 @@ JSON MCPServer::HandleToolsList(const JSON& params) {
                           {"type", "object"},
                           {"properties", JSON::object()}  // Explicitly create
                                                           // empty JSON object
-                      }}}})}};
+                      }}},
+                    {{"name", "searchMemory"},
+                     {"description",
+                      "Search the committed memory of the current process "
+                      "for bytes, strings or pointer values"},
+                     {"inputSchema",
+                      {{"type", "object"},
+                       {"properties",
+                        {{"type",
+                          {{"type", "string"},
+                           {"enum",
+                            JSON::array({"bytes", "ascii", "utf16", "pointer"})},
+                           {"description", "The kind of pattern to search for"}}},
+                         {"pattern",
+                          {{"type", "string"},
+                           {"description",
+                            "Hex bytes (e.g. \"48 8b 05\") for bytes searches "
+                            "or the text for ascii and utf16 searches"}}},
+                         {"minValue",
+                          {{"type", "string"},
+                           {"description",
+                            "Lowest pointer value (expression) for pointer "
+                            "searches"}}},
+                         {"maxValue",
+                          {{"type", "string"},
+                           {"description",
+                            "Highest pointer value (expression) for pointer "
+                            "searches"}}},
+                         {"start",
+                          {{"type", "string"},
+                           {"description",
+                            "Start address expression (default: 0)"}}},
+                         {"end",
+                          {{"type", "string"},
+                           {"description",
+                            "End address expression, exclusive (default: end "
+                            "of the address space)"}}},
+                         {"maxHits",
+                          {{"type", "integer"},
+                           {"description", "Maximum hits to return (default: "
+                                           "100, max: 10000)"}}},
+                         {"contextBytes",
+                          {{"type", "integer"},
+                           {"description", "Bytes to return for each hit "
+                                           "(default: 16, max: 256)"}}},
+                         {"continuationToken",
+                          {{"type", "string"},
+                           {"description",
+                            "Token from a previous incomplete search to "
+                            "continue from"}}}}},
+                       {"required", JSON::array({"type"})}}}},
+                    {{"name", "dumpMemory"},
+                     {"description",
+                      "Write a range of virtual memory to a local file"},
+                     {"inputSchema",
+                      {{"type", "object"},
+                       {"properties",
+                        {{"address",
+                          {{"type", "string"},
+                           {"description", "Start address expression"}}},
+                         {"size",
+                          {{"type", "string"},
+                           {"description", "Size expression in bytes"}}},
+                         {"path",
+                          {{"type", "string"},
+                           {"description", "The file to write to"}}},
+                         {"offset",
+                          {{"type", "integer"},
+                           {"description",
+                            "Resume a previous dump at this offset within "
+                            "the range (use nextOffset from the previous "
+                            "result)"}}},
+                         {"hash",
+                          {{"type", "boolean"},
+                           {"description",
+                            "Return the SHA-256 of the file (default: "
+                            "false)"}}}}},
+                       {"required",
+                        JSON::array({"address", "size", "path"})}}}},
+                    {{"name", "evaluate"},
+                     {"description",
+                      "Evaluate a batch of MASM, C++ or dx expressions and "
+                      "return their typed values"},
+                     {"inputSchema",
+                      {{"type", "object"},
+                       {"properties",
+                        {{"expressions",
+                          {{"type", "array"},
+                           {"description",
+                            "The expressions to evaluate. Each item is either "
+                            "an expression string or an object with "
+                            "\"expression\" and \"syntax\" members"},
+                           {"items",
+                            {{"anyOf",
+                              JSON::array(
+                                  {{{"type", "string"}},
+                                   {{"type", "object"},
+                                    {"properties",
+                                     {{"expression", {{"type", "string"}}},
+                                      {"syntax", {{"type", "string"}}}}},
+                                    {"required",
+                                     JSON::array({"expression"})}}})}}}}},
+                         {"syntax",
+                          {{"type", "string"},
+                           {"enum", JSON::array({"auto", "masm", "c++", "dx"})},
+                           {"description",
+                            "Default syntax for the expressions (default: "
+                            "auto which tries MASM, then C++ and then dx)"}}}}},
+                       {"required", JSON::array({"expressions"})}}}},
+                    {{"name", "sampleStacks"},
+                     {"description",
+                      "Profile the running target by repeatedly breaking in "
+                      "and capturing the stacks of all threads"},
+                     {"inputSchema",
+                      {{"type", "object"},
+                       {"properties",
+                        {{"intervalMs",
+                          {{"type", "integer"},
+                           {"description",
+                            "Time the target runs between samples (default: "
+                            "10)"}}},
+                         {"durationMs",
+                          {{"type", "integer"},
+                           {"description",
+                            "Total time to sample for (default: 1000, max: "
+                            "60000)"}}},
+                         {"threads",
+                          {{"type", "array"},
+                           {"items", {{"type", "integer"}}},
+                           {"description",
+                            "Engine thread ids to sample (default: all)"}}},
+                         {"maxDepth",
+                          {{"type", "integer"},
+                           {"description",
+                            "Maximum stack depth (default: 64)"}}},
+                         {"groupByThread",
+                          {{"type", "boolean"},
+                           {"description",
+                            "Keep the stacks of each thread separate "
+                            "(default: false)"}}},
+                         {"format",
+                          {{"type", "string"},
+                           {"enum", JSON::array({"folded", "flamegraph"})},
+                           {"description",
+                            "Format of the aggregated stacks (default: "
+                            "folded)"}}}}}}}},
+                    {{"name", "traceSteps"},
+                     {"description",
+                      "Step the current thread N times or until a condition "
+                      "is met and record the instruction pointer after each "
+                      "step. Returns a summary and a traceId for getTrace"},
+                     {"inputSchema",
+                      {{"type", "object"},
+                       {"properties",
+                        {{"count",
+                          {{"type", "integer"},
+                           {"description",
+                            "Maximum number of steps (default: 100, max: "
+                            "100000)"}}},
+                         {"kind",
+                          {{"type", "string"},
+                           {"enum", JSON::array({"over", "into", "branch"})},
+                           {"description",
+                            "Step over (p), into (t) or to the next branch "
+                            "(tb) (default: over)"}}},
+                         {"until",
+                          {{"type", "string"},
+                           {"description",
+                            "MASM expression evaluated after each step. "
+                            "Tracing stops when it is non-zero"}}}}}}}},
+                    {{"name", "getTrace"},
+                     {"description",
+                      "Get a range of the steps recorded by traceSteps"},
+                     {"inputSchema",
+                      {{"type", "object"},
+                       {"properties",
+                        {{"traceId",
+                          {{"type", "integer"},
+                           {"description", "The traceId from traceSteps"}}},
+                         {"start",
+                          {{"type", "integer"},
+                           {"description",
+                            "Index of the first step (default: 0)"}}},
+                         {"count",
+                          {{"type", "integer"},
+                           {"description",
+                            "Number of steps (default: 100, max: 1000)"}}},
+                         {"symbolize",
+                          {{"type", "boolean"},
+                           {"description",
+                            "Include the symbol of each address (default: "
+                            "true)"}}}}},
+                       {"required", JSON::array({"traceId"})}}}},
+                    {{"name", "symbolize"},
+                     {"description",
+                      "Resolve a batch of addresses to module!symbol+offset"},
+                     {"inputSchema",
+                      {{"type", "object"},
+                       {"properties",
+                        {{"addresses",
+                          {{"type", "array"},
+                           {"items", {{"type", "string"}}},
+                           {"description",
+                            "Addresses (hex numbers or expressions such as "
+                            "\"@rip\")"}}}}},
+                       {"required", JSON::array({"addresses"})}}}},
+                    {{"name", "findSymbols"},
+                     {"description",
+                      "Find the symbols of a module by name using a "
+                      "prebuilt index. Much faster than x module!*name*"},
+                     {"inputSchema",
+                      {{"type", "object"},
+                       {"properties",
+                        {{"pattern",
+                          {{"type", "string"},
+                           {"description",
+                            "Name to search for. Supports * and ? wildcards. "
+                            "Without wildcards any name containing the "
+                            "pattern matches. May start with module!"}}},
+                         {"module",
+                          {{"type", "string"},
+                           {"description",
+                            "Module to search if the pattern does not "
+                            "start with module!"}}},
+                         {"limit",
+                          {{"type", "integer"},
+                           {"description",
+                            "Maximum number of results (default: 50, max: "
+                            "1000)"}}}}},
+                       {"required", JSON::array({"pattern"})}}}},
+                    {{"name", "diffState"},
+                     {"description",
+                      "Get what changed between the states of two breaks. "
+                      "A snapshot of the registers, top stack frames and "
+                      "locals is captured each time the target breaks. "
+                      "Without since the latest snapshot is returned in "
+                      "full together with its id"},
+                     {"inputSchema",
+                      {{"type", "object"},
+                       {"properties",
+                        {{"since",
+                          {{"type", "integer"},
+                           {"description",
+                            "The id of the earlier snapshot"}}},
+                         {"to",
+                          {{"type", "integer"},
+                           {"description",
+                            "The id of the later snapshot (default: the "
+                            "latest)"}}}}}}}},
+                    {{"name", "getEvents"},
+                     {"description",
+                      "Query the journal of debug events (module loads and "
+                      "unloads, thread and process creation and exit, "
+                      "exceptions and breakpoints) recorded since the "
+                      "server started. Works while the target is running"},
+                     {"inputSchema",
+                      {{"type", "object"},
+                       {"properties",
+                        {{"types",
+                          {{"type", "array"},
+                           {"items", {{"type", "string"}}},
+                           {"description",
+                            "Event types to include: Breakpoint, Exception, "
+                            "CreateThread, ExitThread, CreateProcess, "
+                            "ExitProcess, LoadModule, UnloadModule (default: "
+                            "all)"}}},
+                         {"processId",
+                          {{"type", "integer"},
+                           {"description", "Only events of this process"}}},
+                         {"module",
+                          {{"type", "string"},
+                           {"description",
+                            "Only events whose module name contains this "
+                            "text (case insensitive)"}}},
+                         {"startTime",
+                          {{"type", "number"},
+                           {"description",
+                            "Only events at or after this time in seconds "
+                            "since the journal started"}}},
+                         {"endTime",
+                          {{"type", "number"},
+                           {"description",
+                            "Only events at or before this time in seconds "
+                            "since the journal started"}}},
+                         {"afterSequence",
+                          {{"type", "integer"},
+                           {"description",
+                            "Only events with a larger sequence number. Pass "
+                            "the latestSequence of the previous call to get "
+                            "the new events"}}},
+                         {"limit",
+                          {{"type", "integer"},
+                           {"description",
+                            "Maximum number of events. The newest events are "
+                            "returned (default: 100, max: 1000)"}}}}}}}}});
+
+  for (const JSON& tool : minidump::MinidumpTools::GetToolDefinitions()) {
+    tools.push_back(tool);
+  }
+
+  return tools;
+}
+
+JSON CreateUnknownToolResult(const std::string& tool_name) {
+  return JSON{
+      {"content", JSON::array({{{"type", "text"},
+                                {"text", "Unknown tool: " + tool_name}}})},
+      {"isError", true}};
 }
 
-JSON MCPServer::HandleToolsCall(const JSON& params) {
-  std::string tool_name = params.value("name", "");
-  JSON arguments = params.value("arguments", JSON::object());
+JSON MCPServer::HandleToolsCall(const Request& request, ClientId client) {
+  const std::string& tool_name = request.tool_name;
+  const JSON& arguments = request.arguments;
+  const JSON& params = request.params;
+  TRACE_SPAN("tools/call", tool_name);
 
-  if (tool_name == "executeCommand") {
+  if (!tools_.IsAvailable(tool_name)) {
+    // Includes the tools which were disabled with !MCPServerTools
+    return CreateUnknownToolResult(tool_name);
+  } else if (tool_name == "executeCommand") {
     // Map to existing ExecuteCommand but wrap response in MCP format
-    JSON result = ExecuteCommand(arguments);
-
-    if (result.contains("error")) {
-      // Error case
-      return JSON{
-          {"content",
-           JSON::array(
-               {{{"type", "text"},
-                 {"text", "Error: " + result["error"].get<std::string>()}}})},
-          {"isError", true}};
-    } else {
-      // Result is now just a string containing the output
-      return JSON{
-          {"content", JSON::array({{{"type", "text"},
-                                    {"text", result.get<std::string>()}}})}};
-    }
+    return CreateToolResult(ExecuteCommand(arguments, client));
   } else if (tool_name == "getDebuggerState") {
-    JSON result = GetDebuggerState(arguments);
-
-    if (result.contains("error")) {
-      // Error case
-      return JSON{
-          {"content",
-           JSON::array(
-               {{{"type", "text"},
-                 {"text", "Error: " + result["error"].get<std::string>()}}})},
-          {"isError", true}};
-    } else {
-      // Result is now just a string containing the output
-      return JSON{
-          {"content", JSON::array({{{"type", "text"},
-                                    {"text", result.get<std::string>()}}})}};
+    return CreateToolResult(GetDebuggerState(arguments, client));
+  } else if (tool_name == "searchMemory") {
+    return CreateToolResult(SearchMemory(arguments));
+  } else if (tool_name == "evaluate") {
+    return CreateToolResult(Evaluate(arguments));
+  } else if (tool_name == "sampleStacks") {
+    return CreateToolResult(SampleStacks(arguments));
+  } else if (tool_name == "traceSteps") {
+    return CreateToolResult(TraceSteps(arguments));
+  } else if (tool_name == "getTrace") {
+    return CreateToolResult(GetTrace(arguments));
+  } else if (tool_name == "symbolize") {
+    return CreateToolResult(Symbolize(arguments));
+  } else if (tool_name == "findSymbols") {
+    return CreateToolResult(FindSymbols(arguments));
+  } else if (tool_name == "diffState") {
+    return CreateToolResult(DiffState(arguments));
+  } else if (tool_name == "getEvents") {
+    return CreateToolResult(GetEvents(arguments));
+  } else if (minidump::MinidumpTools::IsMinidumpTool(tool_name)) {
+    return CreateToolResult(minidump_tools_.CallTool(tool_name, arguments));
+  } else if (tool_name == "dumpMemory") {
+    // Progress notifications are only sent if the client asked for them
+    JSON progress_token = nullptr;
+    if (params.contains("_meta") && params["_meta"].is_object()) {
+      progress_token = params["_meta"].value("progressToken", JSON());
     }
+    return CreateToolResult(
+        DumpMemory(arguments, client, progress_token));
   } else {
-    return JSON{
-        {"content", JSON::array({{{"type", "text"},
-                                  {"text", "Unknown tool: " + tool_name}}})},
-        {"isError", true}};
+    return CreateUnknownToolResult(tool_name);
   }
 }
 
-std::string GetCurrentContext() {
-  std::string context_info;
-  ULONG current_process_id = 0;
-  ULONG current_thread_id = 0;
-  static const ULONG INVALID_PROCESS_OR_THREAD_ID = static_cast<ULONG>(-1);
-
-  HRESULT hr = g_debug.system_objects->GetCurrentProcessId(&current_process_id);
-  if (FAILED(hr)) {
-    current_process_id = INVALID_PROCESS_OR_THREAD_ID;
-  }
-
-  hr = g_debug.system_objects->GetCurrentThreadId(&current_thread_id);
-  if (FAILED(hr)) {
-    current_thread_id = INVALID_PROCESS_OR_THREAD_ID;
-  }
-
-  context_info += "Current Execution Context:\n";
-  context_info += "  Process: " + std::to_string(current_process_id) + "\n";
-
-  auto command_line = utils::ExecuteCommand(
-      &g_debug,
-      "dx -r0 @$curprocess.Environment.EnvironmentBlock.ProcessParameters->CommandLine.Buffer");
-  size_t start_pos = command_line.find('"');
-  size_t end_pos = command_line.rfind('"');
-  if (start_pos != std::string::npos && end_pos != std::string::npos &&
-      start_pos < end_pos) {
-    // Extract the command line string
-    command_line = command_line.substr(start_pos + 1, end_pos - start_pos - 1);
-  } else {
-    // If no quotes found, just use the whole line
-    command_line = utils::Trim(command_line);
-  }
-  context_info += "  Process Command Line: " + command_line + "\n";
-
-  context_info += "  Thread: " + std::to_string(current_thread_id) + "\n";
-
-  // Get current source info
-  utils::SourceInfo source_info = utils::GetCurrentSourceInfo(&g_debug);
-  if (source_info.is_valid) {
-    if (!source_info.file_path.empty()) {
-      context_info += "  Source File: " + source_info.full_path + "\n";
-      context_info +=
-          "  Source Line: " + std::to_string(source_info.line) + "\n";
-    }
-
-    // Add source context if available
-    if (!source_info.source_context.empty()) {
-      // Add 4 spaces to the front of all lines in source_context
-      std::string indented_context;
-      std::istringstream stream(source_info.source_context);
-      std::string line;
-      bool first_line = true;
-
-      while (std::getline(stream, line)) {
-        if (!first_line) {
-          indented_context += "\n";
-        }
-        indented_context += "    " + line;
-        first_line = false;
-      }
-
-      context_info += "  Source Context (current line starts with \">\"):\n" +
-                      indented_context + "\n";
-    }
-  }
-
-  auto stack_trace = utils::GetTopOfCallStack(&g_debug);
-  context_info += "  Call Stack (top 5):\n";
-  // Add each stack frame from the vector
-  for (size_t i = 0; i < stack_trace.size(); i++) {
-    context_info += "    [" + std::to_string(i) + "] " + stack_trace[i] + "\n";
-  }
-
-  ULONG num_processes;
-  g_debug.system_objects->GetNumberProcesses(&num_processes);
+// Send a JSON-RPC notification to the client. The transport
+// serializes it with the responses written by the client's thread.
+void MCPServer::SendNotification(ClientId client,
+                                 const std::string& method,
+                                 const JSON& params) {
+  JSON notification = mcp_protocol::CreateNotification(method, params);
+  transport_.Send(client, notification.dump() + "\n");
+}
 
-  if (!stack_trace.empty() &&
-      stack_trace[0].find("ntdll!LdrpDoDebuggerBreak") != std::string::npos &&
-      num_processes == 1) {
-    context_info +=
-        "\n"
-        "Extra Context:\n"
-        "This is a new debugging session and no commands have been executed yet.\n"
-        "If you need to set breakpoints for child processes, use something\n"
-        "similar to the following commands:\n"
-        "\n"
-        "    .childdbg 1; sxn ibp; sxn epr; sxe -c \"bp module_name!namespace_name::class_name::method_name; [...optionally more breakpoints if needed]; gc\" ld:module_name.dll; g\n"
-        "\n"
-        "    .childdbg 1; sxn ibp; sxn epr; sxe -c \"bp `module_name!D:\\\\path\\\\to\\\\file\\\\source_file.cc:42`; gc\" ld:module_name.dll; g\n"
-        "\n"
-        "This will set breakpoints in the child process for the specified module\n"
-        "and start execution of the target. These commands should only be used\n"
-        "for the initial breakpoints in a new debugging session.\n";
-  }
-  return context_info;
+std::string GetCurrentContext() {
+  return execution_context::Format(execution_context::Capture(&g_debug));
 }
 
 std::string GetPromptString() {
@@ -572,7 +935,14 @@ std::string GetPromptString() {
 //
 //    5:096>
 //
-std::string ExecuteWinDbgCommand(const std::string& command) {
+// get_context returns the context to add. By default it is the full
+// context but executeCommand only adds what changed since the last
+// response to the same client. If compactor is not null the command
+// output is compacted before the context is added.
+std::string ExecuteWinDbgCommand(
+    const std::string& command,
+    const std::function<std::string()>& get_context = GetCurrentContext,
+    output_compactor::Compactor* compactor = nullptr) {
   std::string output;
 
   std::string prompt = GetPromptString();
@@ -604,7 +974,7 @@ std::string ExecuteWinDbgCommand(const std::string& command) {
     result = filtered_result;
   }
 
-  output += result;
+  output += compactor ? compactor->Compact(result) : result;
 
   // Only add execution context when there is a possiblity that
   // the execution context has changed. This can happen for
@@ -620,27 +990,44 @@ std::string ExecuteWinDbgCommand(const std::string& command) {
   }
 
   if (should_add_context) {
-    output += "\n\n" + GetCurrentContext();
+    output += "\n\n" + get_context();
   }
 
   output += "\n" + GetPromptString();
   return output;
 }
 
-JSON MCPServer::ExecuteCommand(const JSON& params) {
+JSON MCPServer::ExecuteCommand(const JSON& params, ClientId client) {
   std::string command = params.value("command", "");
   if (command.empty()) {
     return JSON{{"error", "No command specified"}};
   }
 
-  return ExecuteOnMainThread([this, command]() {
-    std::string output = ExecuteWinDbgCommand(command);
-    return JSON(output);
+  bool full_context = params.value("fullContext", false);
+  bool raw = params.value("raw", false);
+  uint64_t client_id = client;
+
+  return ExecuteOnMainThread([this, command, full_context, raw, client_id]() {
+    std::string output = ExecuteWinDbgCommand(
+        command,
+        [&]() {
+          execution_context::ExecutionContext previous;
+          bool has_previous =
+              context_cache_.GetLastContext(client_id, previous);
+          return context_cache_.FormatForClient(
+              client_id,
+              execution_context::Capture(&g_debug,
+                                         has_previous ? &previous : nullptr),
+              full_context);
+        },
+        raw ? nullptr : &output_compactor_);
+    return JSON(std::move(output));
   });
 }
 
-JSON MCPServer::GetDebuggerState(const JSON& params) {
-  return ExecuteOnMainThread([this]() {
+JSON MCPServer::GetDebuggerState(const JSON& params, ClientId client) {
+  uint64_t client_id = client;
+  return ExecuteOnMainThread([this, client_id]() {
     ULONG status = 0;
     HRESULT hr = g_debug.control->GetExecutionStatus(&status);
 
@@ -671,118 +1058,1071 @@ JSON MCPServer::GetDebuggerState(const JSON& params) {
         break;
     }
 
+    // The full context is always returned and becomes the
+    // baseline for the next executeCommand of the client.
     std::string output = "Debugger State: " + state + "\n\n";
-    output += GetCurrentContext() + "\n";
+    output += context_cache_.FormatForClient(
+                  client_id, execution_context::Capture(&g_debug), true) +
+              "\n";
     output += GetPromptString();
     return JSON(output);
   });
 }
 
-JSON MCPServer::ExecuteOnMainThread(std::function<JSON()> operation) {
-  auto cmd = std::make_unique<DebugCommand>();
-  cmd->operation = operation;
-  auto future = cmd->result.get_future();
+namespace {
 
-  {
-    std::lock_guard<std::mutex> lock(queue_mutex_);
-    command_queue_.push(std::move(cmd));
-  }
-  // Wake up the command processor
-  // thread to process the command
-  queue_cv_.notify_one();
+// The maximum values for the searchMemory arguments.
+constexpr size_t kMaxSearchHits = 10000;
+constexpr ULONG kMaxSearchContextBytes = 256;
 
-  // Retrieves the result of the asynchronous operation. This method blocks the
-  // calling thread until the result is available.
-  return future.get();
-}
+// The maximum number of expressions in a single evaluate call.
+constexpr size_t kMaxEvaluateExpressions = 256;
+
+// Limits for the sampleStacks arguments.
+constexpr ULONG kMaxSampleDurationMs = 60000;
+constexpr ULONG kMaxSampleStackDepth = 1024;
+constexpr size_t kSampleTopFunctionCount = 20;
+
+// Limits for the traceSteps and getTrace arguments.
+constexpr ULONG kMaxTraceSteps = 100000;
+constexpr size_t kMaxTraceEntriesPerCall = 1000;
+
+// The maximum number of addresses in a single symbolize call.
+constexpr size_t kMaxSymbolizeAddresses = 10000;
 
-void MCPServer::ProcessCommandQueue() {
-  std::unique_lock<std::mutex> lock(queue_mutex_);
-  while (!command_queue_.empty()) {
-    auto cmd = std::move(command_queue_.front());
-    command_queue_.pop();
-    lock.unlock();
+// The default and maximum number of findSymbols results.
+constexpr size_t kDefaultFindSymbolsLimit = 50;
+constexpr size_t kMaxFindSymbolsLimit = 1000;
 
-    // Execute on main thread
-    // Setting the value will unblock the future
-    JSON result = cmd->operation();
-    cmd->result.set_value(result);
+// The default and maximum number of getEvents results.
+constexpr size_t kDefaultEventsLimit = 100;
+constexpr size_t kMaxEventsLimit = 1000;
 
-    lock.lock();
+// The maximum number of bytes written by a single dumpMemory call
+// and how often progress notifications are sent while dumping.
+constexpr ULONG64 kMaxDumpBytesPerCall = 1024ULL * 1024 * 1024;
+constexpr auto kDumpProgressInterval = std::chrono::milliseconds(250);
+
+// Evaluate a MASM expression (e.g. "@rsp", "0x1234" or "chrome")
+// and return the resulting value. Must be run on the main thread.
+bool EvaluateValue(const std::string& expression, ULONG64& value) {
+  DEBUG_VALUE result = {};
+  HRESULT hr = g_debug.control->Evaluate(expression.c_str(), DEBUG_VALUE_INT64,
+                                         &result, nullptr);
+  if (FAILED(hr)) {
+    return false;
   }
-}
 
-void MCPServer::CommandProcessorThread() {
-  while (running_) {
-    std::unique_lock<std::mutex> lock(queue_mutex_);
-    queue_cv_.wait_for(lock, std::chrono::milliseconds(100),
-                       [this] { return !command_queue_.empty() || !running_; });
+  value = result.I64;
+  return true;
+}
 
-    if (!running_) {
-      break;
-    }
+// Addresses are returned as strings because JSON numbers
+// can not represent all 64-bit values in most clients.
+std::string FormatAddress(ULONG64 address) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "0x%llx", address);
+  return buffer;
+}
 
-    lock.unlock();
-    ProcessCommandQueue();
+// Gets an unsigned integer argument which fits in a ULONG. Larger
+// values are rejected rather than truncated.
+bool GetULongArgument(const JSON& argument, ULONG& value) {
+  if (!argument.is_number_unsigned() ||
+      argument.get<uint64_t>() > UINT32_MAX) {
+    return false;
   }
+  value = argument.get<ULONG>();
+  return true;
 }
 
-HRESULT CALLBACK StartMCPServerInternal(IDebugClient* client,
-                                        const char* args) {
-  if (args && args[0] == '?' && args[1] == '\0') {
-    DOUT(
-        "EXPERIMENTAL.\n"
-        "StartMCPServer - Start an MCP (Model Context Protocol) server\n\n"
-        "Usage: !StartMCPServer [port]\n\n"
-        "  port - TCP port to listen on (default: 0 for automatic)\n\n"
-        "The MCP server allows AI assistants and other tools to interact\n"
-        "with WinDbg through a JSON-RPC protocol.\n\n"
-        "Available MCP tools:\n"
-        "  executeCommand     - Execute a debugger command\n"
-        "  getDebuggerState   - Get debugger state\n\n"
-        "Examples:\n"
-        "  !StartMCPServer        - Start on automatic port\n"
-        "  !StartMCPServer 8080   - Start on port 8080\n"
-        "  !StartMCPServer ?      - Show this help\n\n");
-    return S_OK;
+// Gets an optional unsigned integer argument or default_value if it
+// isn't given. Negative values are rejected rather than converted to
+// huge sizes.
+bool GetSizeArgument(const JSON& params,
+                     const char* name,
+                     size_t default_value,
+                     size_t& value) {
+  if (!params.contains(name)) {
+    value = default_value;
+    return true;
   }
+  if (!params[name].is_number_unsigned()) {
+    return false;
+  }
+  value = params[name].get<size_t>();
+  return true;
+}
 
-  if (g_mcp_server && g_mcp_server->IsRunning()) {
-    DOUT("MCP server is already running on port %d\n", g_mcp_server->GetPort());
-    return S_OK;
+// Pauses the break snapshots while a tool runs the target itself.
+class ScopedSnapshotPause {
+ public:
+  explicit ScopedSnapshotPause(std::atomic<int>& count) : count_(count) {
+    count_++;
   }
+  ~ScopedSnapshotPause() { count_--; }
 
-  int port = 0;
-  if (args && *args) {
-    std::vector<std::string> parsed_args = utils::ParseCommandLine(args);
+ private:
+  std::atomic<int>& count_;
+};
 
-    if (!parsed_args.empty()) {
-      if (parsed_args.size() > 1) {
-        DERROR("Error: Too many arguments. Expected 0 or 1 argument.\n");
-        return E_INVALIDARG;
-      }
+}  // namespace
 
-      std::string port_str = utils::Trim(parsed_args[0]);
+JSON MCPServer::SearchMemory(const JSON& params) {
+  std::string type = params.value("type", "");
+  std::string pattern = params.value("pattern", "");
 
-      if (!utils::IsWholeNumber(port_str)) {
-        DERROR("Error: Port must be a valid number.\n");
-        return E_INVALIDARG;
-      }
+  memory_search::SearchOptions options;
+  if (type == "bytes") {
+    options.type = memory_search::PatternType::kBytes;
+    if (!memory_search::ParseHexBytes(pattern, options.pattern)) {
+      return JSON{{"error", "Invalid hex byte pattern: " + pattern}};
+    }
+  } else if (type == "ascii") {
+    options.type = memory_search::PatternType::kAscii;
+    options.pattern.assign(pattern.begin(), pattern.end());
+  } else if (type == "utf16") {
+    options.type = memory_search::PatternType::kUtf16;
+    options.pattern = memory_search::EncodeUtf16(pattern);
+  } else if (type == "pointer") {
+    options.type = memory_search::PatternType::kPointer;
+  } else {
+    return JSON{{"error", "Unknown search type: " + type}};
+  }
 
-      port = std::stoi(port_str);
-      if (port < 0 || port > 65535) {
-        DERROR("Invalid port number: %s. Port must be between 0 and 65535.\n",
-               port_str.c_str());
-        return E_INVALIDARG;
-      }
+  if (options.type != memory_search::PatternType::kPointer &&
+      options.pattern.empty()) {
+    return JSON{{"error", "No pattern specified"}};
+  }
+
+  if (params.contains("maxHits")) {
+    if (!params["maxHits"].is_number_integer() ||
+        params["maxHits"].get<int64_t>() <= 0) {
+      return JSON{{"error", "maxHits must be a positive integer"}};
     }
+    options.max_hits = static_cast<size_t>(
+        std::min<int64_t>(params["maxHits"].get<int64_t>(), kMaxSearchHits));
   }
 
-  if (!g_mcp_server) {
-    g_mcp_server = new MCPServer();
+  if (params.contains("contextBytes")) {
+    if (!params["contextBytes"].is_number_integer() ||
+        params["contextBytes"].get<int64_t>() < 0) {
+      return JSON{{"error", "contextBytes must be a non-negative integer"}};
+    }
+    options.context_bytes = static_cast<ULONG>(std::min<int64_t>(
+        params["contextBytes"].get<int64_t>(), kMaxSearchContextBytes));
   }
 
-  HRESULT hr = g_mcp_server->Start(port);
+  ULONG64 continuation_address = 0;
+  std::string token = params.value("continuationToken", "");
+  bool has_token = !token.empty();
+  if (has_token &&
+      !memory_search::DecodeContinuationToken(token, continuation_address)) {
+    return JSON{{"error", "Invalid continuation token"}};
+  }
+
+  std::string start = params.value("start", "");
+  std::string end = params.value("end", "");
+  std::string min_value = params.value("minValue", "");
+  std::string max_value = params.value("maxValue", "");
+
+  return ExecuteOnMainThread([=]() mutable {
+    // The expressions are evaluated on the main thread
+    // since they can refer to registers and symbols.
+    const std::pair<const std::string*, ULONG64*> expressions[] = {
+        {&start, &options.start},
+        {&end, &options.end},
+        {&min_value, &options.min_value},
+        {&max_value, &options.max_value}};
+
+    for (const auto& [expression, value] : expressions) {
+      if (!expression->empty() && !EvaluateValue(*expression, *value)) {
+        return JSON{{"error", "Unable to evaluate expression: " + *expression}};
+      }
+    }
+
+    if (options.type == memory_search::PatternType::kPointer) {
+      if (min_value.empty() || max_value.empty()) {
+        return JSON{{"error", "Pointer searches require minValue and maxValue"}};
+      }
+      if (options.max_value < options.min_value) {
+        return JSON{{"error", "maxValue must not be less than minValue"}};
+      }
+    }
+
+    if (has_token) {
+      options.start = std::max(options.start, continuation_address);
+    }
+
+    memory_search::MemorySearcher searcher(&g_debug);
+    memory_search::SearchResult result = searcher.Search(options);
+
+    JSON hits = JSON::array();
+    for (const auto& hit : result.hits) {
+      JSON entry = {{"address", FormatAddress(hit.address)},
+                    {"regionBase", FormatAddress(hit.region_base)},
+                    {"context", memory_search::FormatHexBytes(hit.context)}};
+      if (options.type == memory_search::PatternType::kPointer) {
+        entry["value"] = FormatAddress(hit.value);
+      }
+      hits.push_back(entry);
+    }
+
+    JSON output = {{"hits", hits},
+                   {"hitCount", result.hits.size()},
+                   {"complete", result.complete},
+                   {"bytesScanned", result.bytes_scanned},
+                   {"regionsScanned", result.regions_scanned}};
+    if (!result.complete) {
+      output["continuationToken"] =
+          memory_search::EncodeContinuationToken(result.next_address);
+    }
+
+    return JSON(output.dump(2));
+  });
+}
+
+JSON MCPServer::Evaluate(const JSON& params) {
+  using expression_evaluator::ExpressionSyntax;
+
+  ExpressionSyntax default_syntax = ExpressionSyntax::kAuto;
+  std::string syntax_name = params.value("syntax", "");
+  if (!expression_evaluator::ParseExpressionSyntax(syntax_name,
+                                                   default_syntax)) {
+    return JSON{{"error", "Unknown syntax: " + syntax_name}};
+  }
+
+  if (!params.contains("expressions") || !params["expressions"].is_array() ||
+      params["expressions"].empty()) {
+    return JSON{{"error", "expressions must be a non-empty array"}};
+  }
+
+  if (params["expressions"].size() > kMaxEvaluateExpressions) {
+    return JSON{{"error", "Too many expressions. At most " +
+                              std::to_string(kMaxEvaluateExpressions) +
+                              " can be evaluated at once"}};
+  }
+
+  // Validate everything up front so that a malformed item
+  // doesn't waste a slot in the command queue.
+  std::vector<std::pair<std::string, ExpressionSyntax>> expressions;
+  for (const auto& item : params["expressions"]) {
+    ExpressionSyntax syntax = default_syntax;
+    std::string expression;
+    if (item.is_string()) {
+      expression = item.get<std::string>();
+    } else if (item.is_object() && item.contains("expression") &&
+               item["expression"].is_string()) {
+      expression = item["expression"].get<std::string>();
+      std::string item_syntax = item.value("syntax", syntax_name);
+      if (!expression_evaluator::ParseExpressionSyntax(item_syntax, syntax)) {
+        return JSON{{"error", "Unknown syntax: " + item_syntax}};
+      }
+    } else {
+      return JSON{{"error",
+                   "Each expression must be a string or an object with an "
+                   "expression member"}};
+    }
+    expressions.emplace_back(expression, syntax);
+  }
+
+  // All of the expressions are evaluated in a single queue slot.
+  return ExecuteOnMainThread([expressions]() {
+    JSON results = JSON::array();
+    for (const auto& [expression, syntax] : expressions) {
+      expression_evaluator::EvaluationResult result =
+          expression_evaluator::EvaluateExpression(&g_debug, expression,
+                                                   syntax);
+
+      JSON entry = {{"expression", expression}};
+      if (result.success) {
+        entry["source"] = result.source;
+        entry["type"] = result.type;
+        entry["value"] = result.value;
+        if (!result.decimal.empty()) {
+          entry["decimal"] = result.decimal;
+        }
+      } else {
+        entry["error"] = result.error;
+      }
+      results.push_back(entry);
+    }
+
+    return JSON(JSON{{"results", results}}.dump(2));
+  });
+}
+
+JSON MCPServer::SampleStacks(const JSON& params) {
+  stack_sampler::SamplerOptions options;
+
+  const std::pair<const char*, ULONG*> numbers[] = {
+      {"intervalMs", &options.interval_ms},
+      {"durationMs", &options.duration_ms},
+      {"maxDepth", &options.max_depth}};
+  for (const auto& [name, value] : numbers) {
+    if (params.contains(name) &&
+        (!GetULongArgument(params[name], *value) || *value == 0)) {
+      return JSON{{"error", std::string(name) + " must be a positive integer"}};
+    }
+  }
+  options.duration_ms = std::min(options.duration_ms, kMaxSampleDurationMs);
+  options.max_depth = std::min(options.max_depth, kMaxSampleStackDepth);
+
+  if (params.contains("threads")) {
+    if (!params["threads"].is_array()) {
+      return JSON{{"error", "threads must be an array of thread ids"}};
+    }
+    for (const auto& id : params["threads"]) {
+      ULONG thread_id = 0;
+      if (!GetULongArgument(id, thread_id)) {
+        return JSON{{"error", "threads must be an array of thread ids"}};
+      }
+      options.thread_ids.insert(thread_id);
+    }
+  }
+
+  options.group_by_thread = params.value("groupByThread", false);
+
+  std::string format = params.value("format", "folded");
+  if (format != "folded" && format != "flamegraph") {
+    return JSON{{"error", "Unknown format: " + format}};
+  }
+
+  return ExecuteOnMainThread([options, format, this]() {
+    ScopedSnapshotPause pause(snapshots_paused_);
+    stack_sampler::StackSampler sampler(&g_debug);
+    stack_sampler::SamplerResult result =
+        sampler.Run(options, [this] { return !running_; });
+    CaptureSnapshot();
+    if (!result.success) {
+      return JSON{{"error", result.error}};
+    }
+
+    std::vector<stack_sampler::LabeledTree> trees = result.GetLabeledTrees();
+    stack_sampler::Symbolizer symbolizer =
+        stack_sampler::CreateEngineSymbolizer(&g_debug);
+
+    JSON top_functions = JSON::array();
+    for (const auto& [name, count] : stack_sampler::GetTopFunctions(
+             trees, symbolizer, kSampleTopFunctionCount)) {
+      top_functions.push_back({{"name", name}, {"samples", count}});
+    }
+
+    JSON output = {{"samples", result.samples},
+                   {"stacks", result.stacks},
+                   {"elapsedMs", result.elapsed_ms},
+                   {"topFunctions", top_functions}};
+    if (!result.stop_reason.empty()) {
+      output["stopReason"] = result.stop_reason;
+    }
+
+    if (format == "flamegraph") {
+      output["flameGraph"] = JSON::parse(
+          stack_sampler::FormatFlameGraphJson(trees, symbolizer));
+    } else {
+      output["folded"] = stack_sampler::FormatFoldedStacks(trees, symbolizer);
+    }
+
+    return JSON(output.dump(2));
+  });
+}
+
+JSON MCPServer::TraceSteps(const JSON& params) {
+  step_tracer::TraceOptions options;
+
+  if (params.contains("count")) {
+    ULONG count = 0;
+    if (!GetULongArgument(params["count"], count) || count == 0) {
+      return JSON{{"error", "count must be a positive integer"}};
+    }
+    options.max_steps = std::min(count, kMaxTraceSteps);
+  }
+
+  std::string kind = params.value("kind", "");
+  if (!step_tracer::ParseStepKind(kind, options.kind)) {
+    return JSON{{"error", "Unknown step kind: " + kind}};
+  }
+
+  options.until = utils::Trim(params.value("until", ""));
+
+  return ExecuteOnMainThread([options, this]() {
+    ScopedSnapshotPause pause(snapshots_paused_);
+    step_tracer::StepTracer tracer(&g_debug);
+    std::unique_ptr<step_tracer::StepTrace> trace =
+        tracer.Run(options, [this] { return !running_; });
+    CaptureSnapshot();
+    if (!trace->success) {
+      return JSON{{"error", trace->error}};
+    }
+
+    step_tracer::TraceSummary summary = Summarize(trace->buffer);
+
+    JSON threads = JSON::array();
+    for (const auto& [thread_id, steps] : summary.thread_steps) {
+      threads.push_back({{"threadId", thread_id},
+                         {"steps", steps}});
+    }
+
+    JSON output = {{"steps", summary.steps},
+                   {"traceBytes", summary.size_bytes},
+                   {"uniqueAddresses", summary.unique_addresses},
+                   {"threads", threads},
+                   {"conditionMet", trace->condition_met}};
+    if (!trace->stop_reason.empty()) {
+      output["stopReason"] = trace->stop_reason;
+    }
+    if (summary.steps > 0) {
+      std::vector<symbol_cache::SymbolInfo> symbols =
+          symbol_cache_.Symbolize({summary.first_ip, summary.last_ip});
+      output["first"] = {{"ip", FormatAddress(summary.first_ip)},
+                         {"symbol", symbols[0].ToString()}};
+      output["last"] = {{"ip", FormatAddress(summary.last_ip)},
+                        {"symbol", symbols[1].ToString()}};
+      output["range"] = {FormatAddress(summary.min_ip),
+                         FormatAddress(summary.max_ip)};
+    }
+
+    output["traceId"] = traces_.Add(std::move(trace));
+    output["context"] = GetCurrentContext();
+    return JSON(output.dump(2));
+  });
+}
+
+JSON MCPServer::GetTrace(const JSON& params) {
+  ULONG trace_id = 0;
+  if (!params.contains("traceId") ||
+      !GetULongArgument(params["traceId"], trace_id)) {
+    return JSON{{"error", "traceId is required"}};
+  }
+
+  std::shared_ptr<const step_tracer::StepTrace> trace = traces_.Get(trace_id);
+  if (!trace) {
+    return JSON{{"error", "Unknown or expired traceId"}};
+  }
+
+  size_t start = 0;
+  size_t count = 0;
+  if (!GetSizeArgument(params, "start", 0, start)) {
+    return JSON{{"error", "start must be a non-negative integer"}};
+  }
+  if (!GetSizeArgument(params, "count", 100, count)) {
+    return JSON{{"error", "count must be a non-negative integer"}};
+  }
+  count = std::min(count, kMaxTraceEntriesPerCall);
+  bool symbolize = params.value("symbolize", true);
+
+  std::vector<step_tracer::TraceEntry> entries =
+      trace->buffer.Decode(start, count);
+
+  return ExecuteOnMainThread([=, this]() {
+    std::vector<symbol_cache::SymbolInfo> symbols;
+    if (symbolize) {
+      std::vector<ULONG64> addresses;
+      addresses.reserve(entries.size());
+      for (const step_tracer::TraceEntry& entry : entries) {
+        addresses.push_back(entry.ip);
+      }
+      symbols = symbol_cache_.Symbolize(addresses);
+    }
+
+    JSON steps = JSON::array();
+    for (size_t i = 0; i < entries.size(); i++) {
+      const step_tracer::TraceEntry& entry = entries[i];
+      JSON step = {{"index", start + i},
+                   {"ip", FormatAddress(entry.ip)},
+                   {"threadId", entry.thread_id},
+                   {"kind", step_tracer::GetStepKindName(entry.kind)}};
+      if (symbolize) {
+        step["symbol"] = symbols[i].ToString();
+      }
+      steps.push_back(step);
+    }
+
+    JSON output = {{"totalSteps", trace->buffer.GetCount()},
+                   {"steps", steps}};
+    if (start + entries.size() < trace->buffer.GetCount()) {
+      output["nextStart"] = start + entries.size();
+    }
+    return JSON(output.dump(2));
+  });
+}
+
+JSON MCPServer::Symbolize(const JSON& params) {
+  if (!params.contains("addresses") || !params["addresses"].is_array() ||
+      params["addresses"].empty()) {
+    return JSON{{"error", "addresses must be a non-empty array"}};
+  }
+
+  const JSON& addresses = params["addresses"];
+  if (addresses.size() > kMaxSymbolizeAddresses) {
+    return JSON{{"error", "Too many addresses. The maximum is " +
+                              std::to_string(kMaxSymbolizeAddresses)}};
+  }
+
+  return ExecuteOnMainThread([addresses, this]() {
+    // Hex numbers are parsed directly. Anything
+    // else is evaluated as a MASM expression.
+    std::vector<ULONG64> values;
+    values.reserve(addresses.size());
+    for (const auto& address : addresses) {
+      ULONG64 value = 0;
+      if (address.is_number_unsigned()) {
+        value = address.get<ULONG64>();
+      } else if (address.is_string()) {
+        std::string text = address.get<std::string>();
+        text.erase(std::remove(text.begin(), text.end(), '`'), text.end());
+        char* end = nullptr;
+        value = strtoull(text.c_str(), &end, 16);
+        if (text.empty() || *end != '\0') {
+          if (!EvaluateValue(address.get<std::string>(), value)) {
+            return JSON{{"error", "Unable to evaluate address: " +
+                                      address.get<std::string>()}};
+          }
+        }
+      } else {
+        return JSON{{"error", "Addresses must be strings or unsigned numbers"}};
+      }
+      values.push_back(value);
+    }
+
+    JSON results = JSON::array();
+    for (const symbol_cache::SymbolInfo& info : symbol_cache_.Symbolize(values)) {
+      JSON result = {{"address", FormatAddress(info.address)},
+                     {"symbol", info.ToString()}};
+      if (!info.module.empty()) {
+        result["module"] = info.module;
+      }
+      if (info.found) {
+        result["name"] = info.name;
+        result["displacement"] = FormatAddress(info.displacement);
+      }
+      results.push_back(result);
+    }
+
+    const symbol_cache::SymbolCacheStats& stats = symbol_cache_.GetStats();
+    JSON output = {{"symbols", results},
+                   {"cache",
+                    {{"lookups", stats.lookups},
+                     {"hits", stats.hits},
+                     {"misses", stats.misses}}}};
+    return JSON(output.dump(2));
+  });
+}
+
+JSON MCPServer::FindSymbols(const JSON& params) {
+  std::string pattern = utils::Trim(params.value("pattern", ""));
+  std::string module = utils::Trim(params.value("module", ""));
+
+  size_t separator = pattern.find('!');
+  if (separator != std::string::npos) {
+    module = pattern.substr(0, separator);
+    pattern = pattern.substr(separator + 1);
+  }
+
+  if (pattern.empty()) {
+    return JSON{{"error", "pattern is required"}};
+  }
+  if (module.empty() || module.find_first_of("*?") != std::string::npos) {
+    return JSON{{"error",
+                 "A single module is required (e.g. \"chrome!*Foo*\")"}};
+  }
+
+  size_t limit = 0;
+  if (!GetSizeArgument(params, "limit", kDefaultFindSymbolsLimit, limit)) {
+    return JSON{{"error", "limit must be a non-negative integer"}};
+  }
+  limit = std::min(limit, kMaxFindSymbolsLimit);
+
+  return ExecuteOnMainThread([=, this]() {
+    auto start = std::chrono::steady_clock::now();
+    symbol_index::SymbolIndexStore::Lookup lookup =
+        symbol_indexes_.GetIndex(module);
+    if (!lookup.index) {
+      return JSON{{"error", lookup.error}};
+    }
+
+    auto search_start = std::chrono::steady_clock::now();
+    symbol_index::FindResult found = lookup.index->Find(pattern, limit);
+    auto end = std::chrono::steady_clock::now();
+
+    JSON symbols = JSON::array();
+    for (const symbol_index::SymbolMatch& match : found.matches) {
+      symbols.push_back({{"name", module + "!" + match.name},
+                         {"address", FormatAddress(lookup.base + match.rva)}});
+    }
+
+    JSON output = {
+        {"module", module},
+        {"symbols", symbols},
+        {"totalMatches", found.total_matches},
+        {"truncated", found.total_matches > found.matches.size()},
+        {"index",
+         {{"source", lookup.source},
+          {"symbols", lookup.index->GetSymbolCount()},
+          {"loadMs", std::chrono::duration_cast<std::chrono::milliseconds>(
+                         search_start - start)
+                         .count()}}},
+        {"searchMs",
+         std::chrono::duration_cast<std::chrono::milliseconds>(end -
+                                                               search_start)
+             .count()}};
+    if (!lookup.warning.empty()) {
+      output["warning"] = lookup.warning;
+    }
+    return JSON(output.dump(2));
+  });
+}
+
+namespace {
+
+JSON FramesToJson(const std::vector<state_snapshot::Frame>& frames) {
+  JSON result = JSON::array();
+  for (const state_snapshot::Frame& frame : frames) {
+    result.push_back({{"ip", FormatAddress(frame.instruction_offset)},
+                      {"sp", FormatAddress(frame.stack_offset)},
+                      {"symbol", frame.symbol}});
+  }
+  return result;
+}
+
+JSON VariableToJson(const state_snapshot::Variable& variable) {
+  JSON result = {{"name", variable.name},
+                 {"type", variable.type},
+                 {"value", variable.value}};
+  if (variable.is_argument) {
+    result["argument"] = true;
+  }
+  return result;
+}
+
+}  // namespace
+
+JSON MCPServer::DiffState(const JSON& params) {
+  const char* const ids[] = {"since", "to"};
+  for (const char* name : ids) {
+    ULONG id = 0;
+    if (params.contains(name) &&
+        (!GetULongArgument(params[name], id) || id == 0)) {
+      return JSON{{"error", std::string(name) + " must be a snapshot id"}};
+    }
+  }
+
+  // Run on the command processor thread so that the
+  // snapshots of earlier breaks have been captured.
+  return ExecuteOnMainThread([params, this]() {
+    ULONG latest_id = snapshots_.GetLatestId();
+    if (latest_id == 0) {
+      return JSON{{"error",
+                   "No snapshots have been captured. A snapshot is captured "
+                   "each time the target breaks"}};
+    }
+
+    ULONG to_id = params.value("to", latest_id);
+    state_snapshot::Snapshot to;
+    if (!snapshots_.Get(to_id, to)) {
+      return JSON{{"error", "Unknown snapshot id: " + std::to_string(to_id) +
+                                ". The available snapshots are " +
+                                std::to_string(snapshots_.GetOldestId()) +
+                                " to " + std::to_string(latest_id)}};
+    }
+
+    // Without since the full snapshot is returned as a baseline.
+    if (!params.contains("since")) {
+      JSON registers = JSON::object();
+      for (const auto& [name, value] : to.registers) {
+        registers[name] = FormatAddress(value);
+      }
+      JSON locals = JSON::array();
+      for (const state_snapshot::Variable& variable : to.locals) {
+        locals.push_back(VariableToJson(variable));
+      }
+
+      JSON output = {{"snapshotId", to.id},
+                     {"threadId", to.thread_id},
+                     {"registers", registers},
+                     {"frames", FramesToJson(to.frames)},
+                     {"locals", locals}};
+      return JSON(output.dump(2));
+    }
+
+    ULONG from_id = params["since"].get<ULONG>();
+    state_snapshot::Snapshot from;
+    if (!snapshots_.Get(from_id, from)) {
+      return JSON{{"error", "Unknown snapshot id: " + std::to_string(from_id) +
+                                ". The available snapshots are " +
+                                std::to_string(snapshots_.GetOldestId()) +
+                                " to " + std::to_string(latest_id)}};
+    }
+
+    state_snapshot::StateDiff diff = state_snapshot::Diff(from, to);
+    JSON output = {{"from", diff.from_id},
+                   {"to", diff.to_id},
+                   {"unchanged", diff.IsEmpty()}};
+
+    if (diff.thread_changed) {
+      output["thread"] = {{"from", diff.from_thread_id},
+                          {"to", diff.to_thread_id}};
+    }
+
+    if (!diff.registers.empty()) {
+      JSON registers = JSON::object();
+      for (const auto& change : diff.registers) {
+        registers[change.name] = {FormatAddress(change.old_value),
+                                  FormatAddress(change.new_value)};
+      }
+      output["registers"] = registers;
+    }
+
+    if (diff.frames_changed) {
+      output["frames"] = FramesToJson(diff.frames);
+    }
+    if (diff.scope_changed) {
+      output["scopeChanged"] = true;
+    }
+
+    JSON locals = JSON::object();
+    if (!diff.changed_locals.empty()) {
+      JSON changed = JSON::array();
+      for (const auto& change : diff.changed_locals) {
+        changed.push_back({{"name", change.name},
+                           {"type", change.type},
+                           {"old", change.old_value},
+                           {"new", change.new_value}});
+      }
+      locals["changed"] = changed;
+    }
+    if (!diff.added_locals.empty()) {
+      JSON added = JSON::array();
+      for (const state_snapshot::Variable& variable : diff.added_locals) {
+        added.push_back(VariableToJson(variable));
+      }
+      locals["added"] = added;
+    }
+    if (!diff.removed_locals.empty()) {
+      locals["removed"] = diff.removed_locals;
+    }
+    if (!locals.empty()) {
+      output["locals"] = locals;
+    }
+
+    return JSON(output.dump(2));
+  });
+}
+
+namespace {
+
+JSON EventToJson(const event_journal::Event& event) {
+  using event_journal::EventType;
+
+  JSON entry = {{"sequence", event.sequence},
+                {"time", event.time_us / 1000000.0},
+                {"type", event_journal::GetEventTypeName(event.type)},
+                {"processId", event.process_id},
+                {"threadId", event.thread_id}};
+  if (!event.module.empty()) {
+    entry["module"] = event.module;
+  }
+
+  switch (event.type) {
+    case EventType::kBreakpoint:
+      entry["address"] = FormatAddress(event.address);
+      entry["breakpointId"] = event.argument;
+      break;
+    case EventType::kException:
+      entry["address"] = FormatAddress(event.address);
+      entry["code"] = FormatAddress(event.argument);
+      entry["firstChance"] = event.first_chance;
+      break;
+    case EventType::kCreateThread:
+    case EventType::kCreateProcess:
+    case EventType::kUnloadModule:
+      entry["address"] = FormatAddress(event.address);
+      break;
+    case EventType::kExitThread:
+    case EventType::kExitProcess:
+      entry["exitCode"] = FormatAddress(event.argument);
+      break;
+    case EventType::kLoadModule:
+      entry["address"] = FormatAddress(event.address);
+      entry["size"] = FormatAddress(event.argument);
+      break;
+    default:
+      break;
+  }
+  return entry;
+}
+
+}  // namespace
+
+JSON MCPServer::GetEvents(const JSON& params) {
+  event_journal::Query query;
+
+  if (params.contains("types")) {
+    JSON types = params["types"];
+    if (types.is_string()) {
+      types = JSON::array({types});
+    }
+    if (!types.is_array()) {
+      return JSON{{"error", "types must be an array of event types"}};
+    }
+
+    query.type_mask = 0;
+    for (const JSON& name : types) {
+      event_journal::EventType type;
+      if (!name.is_string() ||
+          !event_journal::ParseEventType(name.get<std::string>(), type)) {
+        return JSON{{"error", "Unknown event type: " + name.dump()}};
+      }
+      query.type_mask |= 1u << static_cast<uint32_t>(type);
+    }
+  }
+
+  if (params.contains("processId")) {
+    ULONG process_id = 0;
+    if (!GetULongArgument(params["processId"], process_id)) {
+      return JSON{{"error", "processId must be a process id"}};
+    }
+    query.has_process_id = true;
+    query.process_id = process_id;
+  }
+
+  query.module = utils::Trim(params.value("module", ""));
+
+  const char* const times[] = {"startTime", "endTime"};
+  for (const char* name : times) {
+    if (params.contains(name) &&
+        (!params[name].is_number() || params[name].get<double>() < 0)) {
+      return JSON{{"error", std::string(name) + " must be a number of seconds"}};
+    }
+  }
+  // Times past the range of the journal's clock are clamped to it.
+  auto to_microseconds = [](const JSON& seconds) {
+    double us = seconds.get<double>() * 1000000;
+    return us >= 18446744073709551616.0 ? UINT64_MAX
+                                        : static_cast<uint64_t>(us);
+  };
+  if (params.contains("startTime")) {
+    query.start_time_us = to_microseconds(params["startTime"]);
+  }
+  if (params.contains("endTime")) {
+    query.end_time_us = to_microseconds(params["endTime"]);
+  }
+
+  if (params.contains("afterSequence")) {
+    if (!params["afterSequence"].is_number_integer() ||
+        params["afterSequence"].get<int64_t>() < 0) {
+      return JSON{{"error", "afterSequence must be a sequence number"}};
+    }
+    query.after_sequence = params["afterSequence"].get<uint64_t>();
+  }
+
+  size_t limit = 0;
+  if (!GetSizeArgument(params, "limit", kDefaultEventsLimit, limit)) {
+    return JSON{{"error", "limit must be a non-negative integer"}};
+  }
+  query.limit = std::min(limit, kMaxEventsLimit);
+
+  // The journal is safe to read from any thread so
+  // this does not wait for the command queue.
+  std::vector<event_journal::Event> events = event_journal_.Find(query);
+  event_journal::JournalStats stats = event_journal_.GetStats();
+
+  JSON entries = JSON::array();
+  for (const event_journal::Event& event : events) {
+    entries.push_back(EventToJson(event));
+  }
+
+  JSON output = {{"events", entries},
+                 {"latestSequence", stats.appended},
+                 {"overwritten", stats.overwritten},
+                 {"time", event_journal_.GetTimeUs() / 1000000.0}};
+  return JSON(output.dump(2));
+}
+
+JSON MCPServer::DumpMemory(const JSON& params,
+                           ClientId client,
+                           const JSON& progress_token) {
+  std::string address = params.value("address", "");
+  std::string size = params.value("size", "");
+
+  memory_dump::DumpOptions options;
+  options.file_path = params.value("path", "");
+  if (address.empty() || size.empty() || options.file_path.empty()) {
+    return JSON{{"error", "address, size and path are required"}};
+  }
+
+  if (params.contains("offset")) {
+    if (!params["offset"].is_number_unsigned()) {
+      return JSON{{"error", "offset must be a non-negative integer"}};
+    }
+    options.offset = params["offset"].get<ULONG64>();
+  }
+
+  if (params.contains("hash")) {
+    if (!params["hash"].is_boolean()) {
+      return JSON{{"error", "hash must be a boolean"}};
+    }
+    options.hash = params["hash"].get<bool>();
+  }
+
+  // The queue is blocked while the dump is running so large
+  // dumps are split over multiple calls using the offset.
+  options.max_bytes = kMaxDumpBytesPerCall;
+
+  return ExecuteOnMainThread([=, this]() mutable {
+    if (!EvaluateValue(address, options.address)) {
+      return JSON{{"error", "Unable to evaluate expression: " + address}};
+    }
+    if (!EvaluateValue(size, options.size)) {
+      return JSON{{"error", "Unable to evaluate expression: " + size}};
+    }
+
+    // Limit the progress notifications to a few per second.
+    auto last_progress = std::chrono::steady_clock::now();
+    auto progress = [&](ULONG64 offset, ULONG64 total_size) {
+      auto now = std::chrono::steady_clock::now();
+      if (!progress_token.is_null() &&
+          now - last_progress >= kDumpProgressInterval) {
+        last_progress = now;
+        SendNotification(client, "notifications/progress",
+                         {{"progressToken", progress_token},
+                          {"progress", offset},
+                          {"total", total_size}});
+      }
+      return running_.load();
+    };
+
+    memory_dump::MemoryDumper dumper(&g_debug);
+    memory_dump::DumpResult result = dumper.Dump(options, progress);
+    if (!result.success) {
+      return JSON{{"error", result.error}};
+    }
+
+    JSON output = {{"path", options.file_path},
+                   {"address", FormatAddress(options.address)},
+                   {"size", options.size},
+                   {"bytesWritten", result.bytes_written},
+                   {"unreadableBytes", result.unreadable_bytes},
+                   {"complete", result.complete},
+                   {"nextOffset", result.next_offset}};
+    if (options.hash) {
+      output["sha256"] = result.sha256;
+    }
+
+    return JSON(output.dump(2));
+  });
+}
+
+JSON MCPServer::ExecuteOnMainThread(std::function<JSON()> operation) {
+  return command_queue_.Execute(std::move(operation), g_request_client);
+}
+
+void MCPServer::PostToMainThread(std::function<JSON()> operation) {
+  command_queue_.Post(std::move(operation));
+}
+
+void MCPServer::OnBreak() {
+  if (!running_ || snapshots_paused_ > 0 || snapshot_pending_.exchange(true)) {
+    return;
+  }
+
+  PostToMainThread([this]() {
+    snapshot_pending_ = false;
+    CaptureSnapshot();
+    return JSON();
+  });
+}
+
+void MCPServer::CaptureSnapshot() {
+  // The target may have been resumed before the capture was processed.
+  ULONG status = 0;
+  if (FAILED(g_debug.control->GetExecutionStatus(&status)) ||
+      status != DEBUG_STATUS_BREAK) {
+    return;
+  }
+
+  state_snapshot::Snapshot snapshot;
+  std::string error;
+  if (snapshot_capturer_.Capture(state_snapshot::CaptureOptions(), snapshot,
+                                 error)) {
+    snapshots_.Add(std::move(snapshot));
+  }
+}
+
+HRESULT CALLBACK StartMCPServerInternal(IDebugClient* client,
+                                        const char* args) {
+  if (args && args[0] == '?' && args[1] == '\0') {
+    DOUT(
+        "EXPERIMENTAL.\n"
+        "StartMCPServer - Start an MCP (Model Context Protocol) server\n\n"
+        "Usage: !StartMCPServer [port]\n\n"
+        "  port - TCP port to listen on (default: 0 for automatic)\n\n"
+        "The MCP server allows AI assistants and other tools to interact\n"
+        "with WinDbg through a JSON-RPC protocol.\n\n"
+        "Available MCP tools:\n"
+        "  executeCommand     - Execute a debugger command\n"
+        "  getDebuggerState   - Get debugger state\n"
+        "  evaluate           - Evaluate a batch of expressions\n"
+        "  sampleStacks       - Profile the target by sampling stacks\n"
+        "  traceSteps         - Record a trace of N steps\n"
+        "  getTrace           - Get the steps of a recorded trace\n"
+        "  symbolize          - Resolve a batch of addresses to symbols\n"
+        "  findSymbols        - Find symbols by name using an index\n"
+        "  diffState          - Get what changed between two breaks\n"
+        "  getEvents          - Query the journal of debug events\n"
+        "  searchMemory       - Search process memory for a pattern\n"
+        "  dumpMemory         - Write a range of memory to a file\n"
+        "  openMinidump       - Open a minidump file for analysis\n"
+        "  closeMinidump      - Close an open minidump\n"
+        "  minidumpModules    - List the modules of a minidump\n"
+        "  minidumpThreads    - List the threads of a minidump\n"
+        "  minidumpThreadContext - Get the registers of a thread\n"
+        "  minidumpReadMemory - Read memory saved in a minidump\n"
+        "  minidumpStack      - Read the raw stack of a thread\n\n"
+        "Examples:\n"
+        "  !StartMCPServer        - Start on automatic port\n"
+        "  !StartMCPServer 8080   - Start on port 8080\n"
+        "  !StartMCPServer ?      - Show this help\n\n");
+    return S_OK;
+  }
+
+  if (g_mcp_server && g_mcp_server->IsRunning()) {
+    DOUT("MCP server is already running on port %d\n", g_mcp_server->GetPort());
+    return S_OK;
+  }
+
+  int port = 0;
+  if (args && *args) {
+    std::vector<std::string> parsed_args = utils::ParseCommandLine(args);
+
+    if (!parsed_args.empty()) {
+      if (parsed_args.size() > 1) {
+        DERROR("Error: Too many arguments. Expected 0 or 1 argument.\n");
+        return E_INVALIDARG;
+      }
+
+      std::string port_str = utils::Trim(parsed_args[0]);
+
+      if (!utils::IsWholeNumber(port_str)) {
+        DERROR("Error: Port must be a valid number.\n");
+        return E_INVALIDARG;
+      }
+
+      port = std::stoi(port_str);
+      if (port < 0 || port > 65535) {
+        DERROR("Invalid port number: %s. Port must be between 0 and 65535.\n",
+               port_str.c_str());
+        return E_INVALIDARG;
+      }
+    }
+  }
+
+  // A server whose threads didn't stop is left alone.
+  if (!g_mcp_server || g_mcp_server->HasStopTimedOut()) {
+    g_mcp_server = new MCPServer();
+  }
+
+  HRESULT hr = g_mcp_server->Start(port);
   if (SUCCEEDED(hr)) {
     DOUT("MCP server started on port %d\n", g_mcp_server->GetPort());
     DOUT("Connect using: tcp://localhost:%d\n", g_mcp_server->GetPort());
@@ -798,7 +2138,10 @@ HRESULT CALLBACK StopMCPServerInternal(IDebugClient* client, const char* args) {
     DOUT(
         "StopMCPServer - Stop the MCP server\n\n"
         "Usage: !StopMCPServer\n\n"
-        "This command stops the running MCP server.\n\n");
+        "This command stops the running MCP server. New connections and\n"
+        "commands are refused and the requests in progress get 2 seconds\n"
+        "to finish. After that the queued commands fail and the debugger\n"
+        "is interrupted (e.g. to stop a 'g' which doesn't return).\n\n");
     return S_OK;
   }
 
@@ -810,6 +2153,10 @@ HRESULT CALLBACK StopMCPServerInternal(IDebugClient* client, const char* args) {
   HRESULT hr = g_mcp_server->Stop();
   if (SUCCEEDED(hr)) {
     DOUT("MCP server stopped\n");
+  } else if (hr == HRESULT_FROM_WIN32(ERROR_TIMEOUT)) {
+    DERROR(
+        "MCP server stopped but a debugger command didn't finish. The\n"
+        "extension stays loaded until the debugger exits.\n");
   } else {
     DERROR("Failed to stop MCP server\n");
   }
@@ -839,6 +2186,271 @@ HRESULT CALLBACK MCPServerStatusInternal(IDebugClient* client,
   return S_OK;
 }
 
+HRESULT CALLBACK MCPServerToolsInternal(IDebugClient* client,
+                                        const char* args) {
+  if (args && args[0] == '?' && args[1] == '\0') {
+    DOUT(
+        "MCPServerTools - List, enable or disable the MCP server tools\n\n"
+        "Usage: !MCPServerTools [enable|disable <tool>]\n\n"
+        "  enable <tool>  - Add a disabled tool back to tools/list\n"
+        "  disable <tool> - Remove a tool from tools/list and reject calls\n"
+        "                   to it\n\n"
+        "Without arguments the tools are listed. Connected clients are sent\n"
+        "notifications/tools/list_changed when the tools change.\n\n"
+        "Examples:\n"
+        "  !MCPServerTools                      - List the tools\n"
+        "  !MCPServerTools disable dumpMemory   - Disable dumpMemory\n\n");
+    return S_OK;
+  }
+
+  if (!g_mcp_server) {
+    g_mcp_server = new MCPServer();
+  }
+  tool_registry::ToolRegistry& tools = g_mcp_server->GetToolRegistry();
+
+  std::vector<std::string> parsed_args = utils::ParseCommandLine(args);
+  if (!parsed_args.empty()) {
+    if (parsed_args.size() != 2 ||
+        (parsed_args[0] != "enable" && parsed_args[0] != "disable")) {
+      DERROR("Error: Expected enable or disable and a tool name.\n");
+      return E_INVALIDARG;
+    }
+
+    bool enable = parsed_args[0] == "enable";
+    if (!tools.SetEnabled(parsed_args[1], enable)) {
+      DERROR("Error: Unknown tool: %s\n", parsed_args[1].c_str());
+      return E_INVALIDARG;
+    }
+    DOUT("%s %s\n", parsed_args[1].c_str(), enable ? "enabled" : "disabled");
+    return S_OK;
+  }
+
+  for (const tool_registry::ToolInfo& tool : tools.GetTools()) {
+    DOUT("  %-22s %s\n", tool.name.c_str(),
+         tool.enabled ? "enabled" : "disabled");
+  }
+  DOUT("Tools version %llu\n",
+       static_cast<unsigned long long>(tools.GetVersion()));
+  return S_OK;
+}
+
+HRESULT CALLBACK MCPServerSessionsInternal(IDebugClient* client,
+                                           const char* args) {
+  if (args && strcmp(args, "?") == 0) {
+    const char* help_text = R"(
+MCPServerSessions Usage:
+
+Lists the sessions of the MCP server's command queue or changes their options.
+Each client has a session. The sessions share the engine thread with deficit
+round robin so that a client which runs long commands doesn't starve the
+others. Interactive sessions are served before normal sessions.
+
+Usage: !MCPServerSessions [<session>|default <option> <value>]
+
+Options:
+- priority interactive|normal: The priority class of the session
+- rate <n>: Commands per second the session may queue (0: unlimited)
+- concurrency <n>: Commands of the session which may be queued or running at
+                   once (0: unlimited)
+
+default changes the options of the clients which connect afterwards.
+
+Examples:
+- !MCPServerSessions
+    - List the sessions with their stats
+- !MCPServerSessions 0x2a4 priority interactive
+    - Serve session 0x2a4 before the others
+- !MCPServerSessions default rate 20
+    - Limit new clients to 20 commands per second
+)";
+    DOUT("%s\n", help_text);
+    return S_OK;
+  }
+
+  if (!g_mcp_server) {
+    DOUT("MCP server has not been initialized\n");
+    return S_OK;
+  }
+  command_queue::CommandQueue& queue = g_mcp_server->GetCommandQueue();
+
+  std::vector<std::string> parsed_args = utils::ParseCommandLine(args);
+  if (parsed_args.empty()) {
+    for (const command_queue::SessionStats& stats : queue.GetSessionStats()) {
+      command_queue::SessionOptions options =
+          queue.GetSessionOptions(stats.session);
+      DOUT(
+          "Session 0x%llx (%s): %llu executed, %llu rejected, %llu queued, "
+          "wait avg %llu us max %llu us, ran %llu ms, deficit %lld us, "
+          "rate %g/s, concurrency %u\n",
+          static_cast<unsigned long long>(stats.session),
+          command_queue::GetPriorityName(stats.priority),
+          static_cast<unsigned long long>(stats.executed),
+          static_cast<unsigned long long>(stats.rejected),
+          static_cast<unsigned long long>(stats.depth),
+          static_cast<unsigned long long>(
+              stats.executed ? stats.total_wait_us / stats.executed : 0),
+          static_cast<unsigned long long>(stats.max_wait_us),
+          static_cast<unsigned long long>(stats.total_run_us / 1000),
+          static_cast<long long>(stats.deficit_us), options.rate_limit,
+          options.max_concurrent);
+    }
+    return S_OK;
+  }
+
+  if (parsed_args.size() != 3) {
+    DERROR("Error: Expected a session, an option and a value. "
+           "Use !MCPServerSessions ? for help.\n");
+    return E_INVALIDARG;
+  }
+
+  bool is_default = parsed_args[0] == "default";
+  command_queue::SessionId session = command_queue::kDefaultSession;
+  command_queue::SessionOptions options;
+  try {
+    if (is_default) {
+      options = queue.GetDefaultSessionOptions();
+    } else {
+      session = std::stoull(parsed_args[0], nullptr, 0);
+      options = queue.GetSessionOptions(session);
+    }
+
+    const std::string& option = parsed_args[1];
+    const std::string& value = parsed_args[2];
+    if (option == "priority" && (value == "interactive" || value == "normal")) {
+      options.priority = value == "interactive"
+                             ? command_queue::Priority::kInteractive
+                             : command_queue::Priority::kNormal;
+    } else if (option == "rate") {
+      options.rate_limit = std::max(std::stod(value), 0.0);
+    } else if (option == "concurrency" && utils::IsWholeNumber(value)) {
+      options.max_concurrent = std::stoul(value);
+    } else {
+      DERROR("Error: Invalid option: %s %s\n", option.c_str(), value.c_str());
+      return E_INVALIDARG;
+    }
+  } catch (const std::exception&) {
+    DERROR("Error: Invalid number in: %s %s %s\n", parsed_args[0].c_str(),
+           parsed_args[1].c_str(), parsed_args[2].c_str());
+    return E_INVALIDARG;
+  }
+
+  if (is_default) {
+    queue.SetDefaultSessionOptions(options);
+    DOUT("Default session options set\n");
+  } else {
+    queue.SetSessionOptions(session, options);
+    DOUT("Options of session 0x%llx set\n",
+         static_cast<unsigned long long>(session));
+  }
+  return S_OK;
+}
+
+HRESULT CALLBACK EventsInternal(IDebugClient* client, const char* args) {
+  if (args && strcmp(args, "?") == 0) {
+    const char* help_text = R"(
+Events Usage:
+
+Lists the debug events which were recorded while the MCP server was running.
+The journal keeps the last 4096 events (module loads and unloads, thread and
+process creation and exit, exceptions and breakpoints).
+
+Parameters:
+- /t types: Comma separated event types (default: all). One of Breakpoint,
+            Exception, CreateThread, ExitThread, CreateProcess, ExitProcess,
+            LoadModule or UnloadModule
+- /p pid: Only the events of this process (e.g. 0x3c4)
+- /m module: Only the events whose module name contains this text
+- /s seconds: Only the events of the last number of seconds
+- /n count: The maximum number of events (default: 50). The newest events
+            are listed
+
+Examples:
+- !Events
+    - List the last 50 events
+- !Events /t LoadModule,UnloadModule /m chrome
+    - List the loads and unloads of the chrome modules
+- !Events /t Exception /p 0x3c4 /s 10
+    - List the exceptions of process 0x3c4 in the last 10 seconds
+)";
+    DOUT("%s\n", help_text);
+    return S_OK;
+  }
+
+  if (!g_mcp_server) {
+    DOUT(
+        "No events have been recorded. The events are recorded while the MCP "
+        "server is running (!StartMCPServer).\n");
+    return S_OK;
+  }
+
+  event_journal::EventJournal& journal = g_mcp_server->GetEventJournal();
+  std::vector<std::string> parsed_args = utils::ParseCommandLine(args);
+
+  event_journal::Query query;
+  query.limit = 50;
+
+  for (size_t i = 0; i < parsed_args.size(); i++) {
+    const std::string& arg = parsed_args[i];
+    bool has_value = i + 1 < parsed_args.size();
+
+    if (arg == "/t" && has_value) {
+      query.type_mask = 0;
+      for (const std::string& name : utils::SplitString(parsed_args[++i], ",")) {
+        event_journal::EventType type;
+        if (!event_journal::ParseEventType(utils::Trim(name), type)) {
+          DERROR("Error: Unknown event type: %s\n", name.c_str());
+          return E_INVALIDARG;
+        }
+        query.type_mask |= 1u << static_cast<uint32_t>(type);
+      }
+    } else if (arg == "/p" && has_value) {
+      try {
+        query.process_id = std::stoul(parsed_args[++i], nullptr, 0);
+        query.has_process_id = true;
+      } catch (const std::exception&) {
+        DERROR("Error: Invalid process id: %s\n", parsed_args[i].c_str());
+        return E_INVALIDARG;
+      }
+    } else if (arg == "/m" && has_value) {
+      query.module = parsed_args[++i];
+    } else if ((arg == "/s" || arg == "/n") && has_value) {
+      if (!utils::IsWholeNumber(parsed_args[i + 1])) {
+        DERROR("Error: Invalid number: %s\n", parsed_args[i + 1].c_str());
+        return E_INVALIDARG;
+      }
+      uint64_t value = 0;
+      try {
+        value = std::stoull(parsed_args[++i]);
+      } catch (const std::exception&) {
+        DERROR("Error: Invalid number: %s\n", parsed_args[i].c_str());
+        return E_INVALIDARG;
+      }
+      if (arg == "/n") {
+        query.limit = value;
+      } else {
+        uint64_t now = journal.GetTimeUs();
+        query.start_time_us =
+            value > now / 1000000 ? 0 : now - value * 1000000;
+      }
+    } else {
+      DERROR("Error: Unexpected argument: %s. Use !Events ? for help.\n",
+             arg.c_str());
+      return E_INVALIDARG;
+    }
+  }
+
+  std::vector<event_journal::Event> events = journal.Find(query);
+  for (const event_journal::Event& event : events) {
+    DOUT("%s\n", event_journal::FormatEvent(event).c_str());
+  }
+
+  event_journal::JournalStats stats = journal.GetStats();
+  DOUT("%zu events listed. %llu events recorded, %llu overwritten.\n",
+       events.size(), static_cast<unsigned long long>(stats.appended),
+       static_cast<unsigned long long>(stats.overwritten));
+  return S_OK;
+}
+
 HRESULT CALLBACK DebugExtensionInitializeInternal(PULONG version,
                                                   PULONG flags) {
   *version = DEBUG_EXTENSION_VERSION(1, 0);
@@ -848,11 +2460,20 @@ HRESULT CALLBACK DebugExtensionInitializeInternal(PULONG version,
 
 HRESULT CALLBACK DebugExtensionUninitializeInternal() {
   if (g_mcp_server) {
-    g_mcp_server->Stop();
-    delete g_mcp_server;
+    // The threads of a server which didn't stop in time still use it
+    // so it is leaked rather than deleted.
+    HRESULT hr = g_mcp_server->Stop();
+    if (SUCCEEDED(hr) && !g_mcp_server->HasStopTimedOut()) {
+      delete g_mcp_server;
+    }
     g_mcp_server = nullptr;
   }
 
+  // A thread which was left running keeps the module loaded (see
+  // MCPServer::Stop) and still uses the interfaces, so they are kept.
+  if (g_threads_left_running) {
+    return S_OK;
+  }
   return utils::UninitializeDebugInterfaces(&g_debug);
 }
 
@@ -880,4 +2501,19 @@ __declspec(dllexport) HRESULT CALLBACK MCPServerStatus(IDebugClient* client,
                                                        const char* args) {
   return MCPServerStatusInternal(client, args);
 }
+
+__declspec(dllexport) HRESULT CALLBACK MCPServerTools(IDebugClient* client,
+                                                      const char* args) {
+  return MCPServerToolsInternal(client, args);
+}
+
+__declspec(dllexport) HRESULT CALLBACK MCPServerSessions(IDebugClient* client,
+                                                         const char* args) {
+  return MCPServerSessionsInternal(client, args);
+}
+
+__declspec(dllexport) HRESULT CALLBACK Events(IDebugClient* client,
+                                              const char* args) {
+  return EventsInternal(client, args);
+}
 }
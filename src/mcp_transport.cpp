@@ -0,0 +1,332 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifdef _WIN32
+// Prevent windows.h from including winsock.h to avoid
+// duplicate definition errors when including winsock2.h
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include "mcp_transport.h"
+
+#include <chrono>
+#include <vector>
+
+#include "mcp_protocol.h"
+#include "trace.h"
+
+#ifdef _WIN32
+// Include Ws2_32.lib for socket functions when linking
+#pragma comment(lib, "Ws2_32.lib")
+
+using AddressLength = int;
+constexpr int kSendFlags = 0;
+#else
+using AddressLength = socklen_t;
+using SOCKET = int;
+constexpr SOCKET INVALID_SOCKET = -1;
+constexpr int SOCKET_ERROR = -1;
+constexpr int SD_BOTH = SHUT_RDWR;
+// Writing to a closed connection must not raise SIGPIPE.
+constexpr int kSendFlags = MSG_NOSIGNAL;
+
+namespace {
+
+int closesocket(SOCKET socket) {
+  return close(socket);
+}
+
+}  // namespace
+#endif
+
+namespace mcp_transport {
+
+namespace {
+
+SOCKET ToSocket(uint64_t handle) {
+  return static_cast<SOCKET>(handle);
+}
+
+uint64_t FromSocket(SOCKET socket) {
+  return static_cast<uint64_t>(socket);
+}
+
+bool SendAll(SOCKET socket, const std::string& data) {
+  size_t sent = 0;
+  while (sent < data.size()) {
+    int result = send(socket, data.data() + sent,
+                      static_cast<int>(data.size() - sent), kSendFlags);
+    if (result <= 0) {
+      return false;
+    }
+    sent += result;
+  }
+  return true;
+}
+
+void CleanupSockets() {
+#ifdef _WIN32
+  WSACleanup();
+#endif
+}
+
+}  // namespace
+
+bool SocketServer::Start(int port,
+                         RequestHandler handler,
+                         DisconnectHandler on_disconnect) {
+  if (running_) {
+    return false;
+  }
+
+#ifdef _WIN32
+  // Initialize Winsock
+  WSADATA wsa_data;
+  if (WSAStartup(MAKEWORD(2, 2), &wsa_data) != 0) {
+    return false;
+  }
+#endif
+
+  // Create socket
+  SOCKET listen_socket = socket(AF_INET, SOCK_STREAM, 0);
+  if (listen_socket == INVALID_SOCKET) {
+    CleanupSockets();
+    return false;
+  }
+
+  // Bind socket
+  sockaddr_in server_addr = {};
+  server_addr.sin_family = AF_INET;
+  server_addr.sin_addr.s_addr = INADDR_ANY;
+  server_addr.sin_port = htons(port);
+
+  if (bind(listen_socket, (sockaddr*)&server_addr, sizeof(server_addr)) ==
+          SOCKET_ERROR ||
+      listen(listen_socket, SOMAXCONN) == SOCKET_ERROR) {
+    closesocket(listen_socket);
+    CleanupSockets();
+    return false;
+  }
+
+  // Get actual port if 0 was specified
+  AddressLength addr_len = sizeof(server_addr);
+  if (getsockname(listen_socket, (sockaddr*)&server_addr, &addr_len) == 0) {
+    port_ = ntohs(server_addr.sin_port);
+  } else {
+    port_ = port;
+  }
+
+  listen_socket_ = FromSocket(listen_socket);
+  handler_ = std::move(handler);
+  on_disconnect_ = std::move(on_disconnect);
+  running_ = true;
+  accepting_ = true;
+  accept_thread_ = std::thread(&SocketServer::AcceptThread, this);
+  return true;
+}
+
+void SocketServer::Stop() {
+  if (!running_) {
+    return;
+  }
+
+  std::unique_lock<std::mutex> lock = CloseClients();
+  clients_cv_.wait(lock, [this] { return clients_.empty(); });
+  lock.unlock();
+
+  CleanupSockets();
+}
+
+bool SocketServer::Stop(std::chrono::milliseconds timeout) {
+  if (!running_) {
+    return true;
+  }
+
+  std::unique_lock<std::mutex> lock = CloseClients();
+  if (!clients_cv_.wait_for(lock, timeout,
+                            [this] { return clients_.empty(); })) {
+    // A client thread is stuck in the request handler. Winsock stays
+    // initialized because the thread still owns a socket.
+    return false;
+  }
+  lock.unlock();
+
+  CleanupSockets();
+  return true;
+}
+
+void SocketServer::StopAccepting() {
+  if (!accepting_.exchange(false)) {
+    return;
+  }
+
+  // Close the listen socket to unblock accept(). Closing alone
+  // doesn't unblock it with BSD sockets so shut it down first.
+  SOCKET listen_socket = ToSocket(listen_socket_);
+  shutdown(listen_socket, SD_BOTH);
+  closesocket(listen_socket);
+
+  if (accept_thread_.joinable()) {
+    accept_thread_.join();
+  }
+  listen_socket_ = ~0ull;
+}
+
+bool SocketServer::WaitForRequests(std::chrono::milliseconds timeout) {
+  std::unique_lock<std::mutex> lock(clients_mutex_);
+  return clients_cv_.wait_for(
+      lock, timeout, [this] { return requests_in_progress_ == 0; });
+}
+
+std::unique_lock<std::mutex> SocketServer::CloseClients() {
+  StopAccepting();
+  running_ = false;
+
+  // Force close all client sockets to unblock recv() calls.
+  std::unique_lock<std::mutex> lock(clients_mutex_);
+  for (const auto& [client, connection] : clients_) {
+    shutdown(ToSocket(client), SD_BOTH);
+  }
+  return lock;
+}
+
+size_t SocketServer::GetClientCount() {
+  std::lock_guard<std::mutex> lock(clients_mutex_);
+  return clients_.size();
+}
+
+bool SocketServer::Send(ClientId client, const std::string& data) {
+  std::shared_ptr<Connection> connection;
+  {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    auto it = clients_.find(client);
+    if (it == clients_.end()) {
+      return false;
+    }
+    connection = it->second;
+  }
+
+  std::lock_guard<std::mutex> lock(connection->send_mutex);
+  return !connection->closed && SendAll(ToSocket(client), data);
+}
+
+size_t SocketServer::Broadcast(const std::string& data) {
+  std::vector<ClientId> clients;
+  {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    for (const auto& [client, connection] : clients_) {
+      clients.push_back(client);
+    }
+  }
+
+  size_t sent = 0;
+  for (ClientId client : clients) {
+    if (Send(client, data)) {
+      sent++;
+    }
+  }
+  return sent;
+}
+
+void SocketServer::AcceptThread() {
+  while (accepting_) {
+    sockaddr_in client_addr = {};
+    AddressLength client_len = sizeof(client_addr);
+
+    SOCKET client_socket =
+        accept(ToSocket(listen_socket_), (sockaddr*)&client_addr, &client_len);
+    if (client_socket == INVALID_SOCKET) {
+      if (accepting_) {
+        // Real error, not shutdown
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+      }
+      continue;
+    }
+
+    // Register the client before its thread starts so that
+    // Stop always sees the sockets which it has to close.
+    ClientId client = FromSocket(client_socket);
+    {
+      std::lock_guard<std::mutex> lock(clients_mutex_);
+      if (!accepting_) {
+        closesocket(client_socket);
+        break;
+      }
+      clients_[client] = std::make_shared<Connection>();
+    }
+
+    std::thread(&SocketServer::ClientThread, this, client).detach();
+  }
+}
+
+void SocketServer::ClientThread(ClientId client) {
+  char buffer[4096];
+  mcp_protocol::MessageFramer framer;
+  std::string message;
+  // Reused for the responses so that it only grows to the size of
+  // the largest response of the connection.
+  std::string output;
+
+  auto handler = [this, client](const mcp_protocol::Request& request) {
+    return handler_(request, client);
+  };
+
+  trace::SetThreadName("MCP client " + std::to_string(client));
+
+  while (running_) {
+    int bytes_received = 0;
+    {
+      TRACE_SPAN("Socket receive");
+      bytes_received = recv(ToSocket(client), buffer, sizeof(buffer), 0);
+    }
+    if (bytes_received <= 0) {
+      break;
+    }
+
+    // Simple message framing: messages end with \n
+    framer.Append(buffer, bytes_received);
+    while (framer.Next(message)) {
+      TRACE_SPAN("Handle message");
+      requests_in_progress_++;
+      output.clear();
+      mcp_protocol::ProcessMessage(message, handler, output);
+      Send(client, output);
+
+      // Taking the lock makes sure that WaitForRequests either sees
+      // the new count or is waiting when it is notified.
+      if (--requests_in_progress_ == 0) {
+        std::lock_guard<std::mutex> lock(clients_mutex_);
+        clients_cv_.notify_all();
+      }
+    }
+  }
+
+  if (on_disconnect_) {
+    on_disconnect_(client);
+  }
+
+  // Wait for a Send from another thread to finish and make any later
+  // one fail. The socket is closed under clients_mutex_ so that its
+  // handle can't be reused by a new client while it is still listed.
+  std::shared_ptr<Connection> connection;
+  {
+    std::lock_guard<std::mutex> lock(clients_mutex_);
+    connection = clients_[client];
+  }
+  std::lock_guard<std::mutex> send_lock(connection->send_mutex);
+  connection->closed = true;
+
+  std::lock_guard<std::mutex> lock(clients_mutex_);
+  closesocket(ToSocket(client));
+  clients_.erase(client);
+  clients_cv_.notify_all();
+}
+
+}  // namespace mcp_transport
@@ -0,0 +1,114 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef MCP_TRANSPORT_H_
+#define MCP_TRANSPORT_H_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "json.hpp"
+#include "mcp_protocol.h"
+
+using JSON = nlohmann::json;
+
+namespace mcp_transport {
+
+// Identifies a connected client. This is the socket handle of the
+// client so it is unique while the client is connected.
+using ClientId = uint64_t;
+
+using RequestHandler =
+    std::function<JSON(const mcp_protocol::Request& request, ClientId client)>;
+using DisconnectHandler = std::function<void(ClientId client)>;
+
+// The TCP side of the MCP server. Each client is handled on its own
+// thread which reads newline terminated JSON-RPC messages, passes them
+// to the request handler and writes back the responses in order. Works
+// with Winsock and with BSD sockets.
+class SocketServer {
+ public:
+  SocketServer() = default;
+  SocketServer(const SocketServer&) = delete;
+  SocketServer& operator=(const SocketServer&) = delete;
+  ~SocketServer() { Stop(); }
+
+  // Listens on port (0 picks a free port) of all interfaces.
+  // on_disconnect is optional.
+  bool Start(int port,
+             RequestHandler handler,
+             DisconnectHandler on_disconnect = nullptr);
+
+  // Stops accepting, closes the client connections and waits for
+  // the client threads to finish.
+  void Stop();
+
+  // Same as Stop but waits at most timeout for the client threads.
+  // Returns false if they didn't finish, in which case the server
+  // must not be destroyed.
+  bool Stop(std::chrono::milliseconds timeout);
+
+  // Closes the listen socket. The connected clients are still served
+  // so that their requests can finish before Stop is called.
+  void StopAccepting();
+
+  // Waits up to timeout until no request is being handled.
+  bool WaitForRequests(std::chrono::milliseconds timeout);
+
+  bool IsRunning() const { return running_; }
+  int GetPort() const { return port_; }
+  size_t GetClientCount();
+
+  // Writes data to a client. Can be called from any thread. Writes
+  // to the same client are serialized so a message is never
+  // interleaved with a response. Returns false if the client has
+  // disconnected.
+  bool Send(ClientId client, const std::string& data);
+
+  // Writes data to every connected client (e.g. a notification).
+  // Returns the number of clients it was written to.
+  size_t Broadcast(const std::string& data);
+
+ private:
+  void AcceptThread();
+  void ClientThread(ClientId client);
+  // Stops accepting and shuts down the client sockets. Returns with
+  // clients_mutex_ locked.
+  std::unique_lock<std::mutex> CloseClients();
+
+  std::atomic<bool> running_{false};
+  std::atomic<bool> accepting_{false};
+  // The number of requests which are being handled or written.
+  std::atomic<uint32_t> requests_in_progress_{0};
+  uint64_t listen_socket_ = ~0ull;
+  int port_ = 0;
+  std::thread accept_thread_;
+  RequestHandler handler_;
+  DisconnectHandler on_disconnect_;
+
+  struct Connection {
+    // Held while writing to the socket.
+    std::mutex send_mutex;
+    // Set before the socket is closed.
+    bool closed = false;
+  };
+
+  // The connected clients. The client threads are detached
+  // so Stop waits for this to be empty. clients_cv_ is also
+  // notified when requests_in_progress_ drops to 0.
+  std::map<ClientId, std::shared_ptr<Connection>> clients_;
+  std::mutex clients_mutex_;
+  std::condition_variable clients_cv_;
+};
+
+}  // namespace mcp_transport
+
+#endif  // MCP_TRANSPORT_H_
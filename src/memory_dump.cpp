@@ -0,0 +1,333 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "memory_dump.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <future>
+#include <vector>
+
+namespace memory_dump {
+
+namespace {
+
+constexpr ULONG64 kPageSize = 0x1000;
+
+const ULONG kSha256RoundConstants[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1,
+    0x923f82a4, 0xab1c5ed5, 0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3,
+    0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174, 0xe49b69c1, 0xefbe4786,
+    0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147,
+    0x06ca6351, 0x14292967, 0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13,
+    0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85, 0xa2bfe8a1, 0xa81a664b,
+    0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a,
+    0x5b9cca4f, 0x682e6ff3, 0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208,
+    0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2};
+
+inline ULONG RotateRight(ULONG value, int count) {
+  return (value >> count) | (value << (32 - count));
+}
+
+bool IsReadableRegion(const MEMORY_BASIC_INFORMATION64& info) {
+  return info.State == MEM_COMMIT &&
+         (info.Protect & (PAGE_NOACCESS | PAGE_GUARD)) == 0;
+}
+
+}  // namespace
+
+Sha256::Sha256()
+    : state_{0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f,
+             0x9b05688c, 0x1f83d9ab, 0x5be0cd19},
+      block_{} {}
+
+void Sha256::Update(const BYTE* data, size_t size) {
+  total_size_ += size;
+
+  if (block_size_ > 0) {
+    size_t count = std::min(size, sizeof(block_) - block_size_);
+    memcpy(block_ + block_size_, data, count);
+    block_size_ += count;
+    data += count;
+    size -= count;
+
+    if (block_size_ < sizeof(block_)) {
+      return;
+    }
+    ProcessBlock(block_);
+    block_size_ = 0;
+  }
+
+  // Process whole blocks straight out of the input.
+  while (size >= sizeof(block_)) {
+    ProcessBlock(data);
+    data += sizeof(block_);
+    size -= sizeof(block_);
+  }
+
+  memcpy(block_, data, size);
+  block_size_ = size;
+}
+
+std::string Sha256::FinalHex() {
+  ULONG64 total_bits = total_size_ * 8;
+
+  // Append the 0x80 terminator, pad with zeros up to 56 bytes
+  // within the block and then append the big endian bit length.
+  BYTE padding[72] = {0x80};
+  size_t padding_size =
+      (block_size_ < 56) ? (56 - block_size_) : (120 - block_size_);
+  for (int i = 0; i < 8; i++) {
+    padding[padding_size + i] =
+        static_cast<BYTE>(total_bits >> (56 - i * 8));
+  }
+  Update(padding, padding_size + 8);
+
+  static const char kHexDigits[] = "0123456789abcdef";
+  std::string digest;
+  digest.reserve(64);
+  for (ULONG word : state_) {
+    for (int shift = 28; shift >= 0; shift -= 4) {
+      digest += kHexDigits[(word >> shift) & 0xF];
+    }
+  }
+  return digest;
+}
+
+void Sha256::ProcessBlock(const BYTE* block) {
+  ULONG w[64];
+  for (int i = 0; i < 16; i++) {
+    w[i] = (static_cast<ULONG>(block[i * 4]) << 24) |
+           (static_cast<ULONG>(block[i * 4 + 1]) << 16) |
+           (static_cast<ULONG>(block[i * 4 + 2]) << 8) |
+           static_cast<ULONG>(block[i * 4 + 3]);
+  }
+  for (int i = 16; i < 64; i++) {
+    ULONG s0 = RotateRight(w[i - 15], 7) ^ RotateRight(w[i - 15], 18) ^
+               (w[i - 15] >> 3);
+    ULONG s1 = RotateRight(w[i - 2], 17) ^ RotateRight(w[i - 2], 19) ^
+               (w[i - 2] >> 10);
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+
+  ULONG a = state_[0];
+  ULONG b = state_[1];
+  ULONG c = state_[2];
+  ULONG d = state_[3];
+  ULONG e = state_[4];
+  ULONG f = state_[5];
+  ULONG g = state_[6];
+  ULONG h = state_[7];
+
+  for (int i = 0; i < 64; i++) {
+    ULONG s1 = RotateRight(e, 6) ^ RotateRight(e, 11) ^ RotateRight(e, 25);
+    ULONG ch = (e & f) ^ (~e & g);
+    ULONG temp1 = h + s1 + ch + kSha256RoundConstants[i] + w[i];
+    ULONG s0 = RotateRight(a, 2) ^ RotateRight(a, 13) ^ RotateRight(a, 22);
+    ULONG maj = (a & b) ^ (a & c) ^ (b & c);
+    ULONG temp2 = s0 + maj;
+
+    h = g;
+    g = f;
+    f = e;
+    e = d + temp1;
+    d = c;
+    c = b;
+    b = a;
+    a = temp1 + temp2;
+  }
+
+  state_[0] += a;
+  state_[1] += b;
+  state_[2] += c;
+  state_[3] += d;
+  state_[4] += e;
+  state_[5] += f;
+  state_[6] += g;
+  state_[7] += h;
+}
+
+MemoryDumper::MemoryDumper(const utils::DebugInterfaces* interfaces)
+    : interfaces_(interfaces) {}
+
+DumpResult MemoryDumper::Dump(const DumpOptions& options,
+                              const ProgressCallback& progress) {
+  DumpResult result;
+  result.next_offset = options.offset;
+
+  if (options.file_path.empty()) {
+    result.error = "No file specified";
+    return result;
+  }
+  if (options.size == 0 || options.chunk_size == 0) {
+    result.error = "The size must be greater than zero";
+    return result;
+  }
+  if (options.offset > options.size) {
+    result.error = "The offset is past the end of the range";
+    return result;
+  }
+  if (options.address + options.size < options.address) {
+    result.error = "The range wraps around the end of the address space";
+    return result;
+  }
+
+  Sha256 sha256;
+  std::error_code ec;
+
+  if (options.offset == 0) {
+    std::ofstream create(options.file_path,
+                         std::ios::binary | std::ios::trunc);
+    if (!create) {
+      result.error = "Unable to create file: " + options.file_path;
+      return result;
+    }
+  } else {
+    // Drop anything past the offset (e.g. a partially written chunk).
+    uintmax_t existing_size =
+        std::filesystem::file_size(options.file_path, ec);
+    if (ec || existing_size < options.offset) {
+      result.error = "Unable to resume, the file does not contain " +
+                     std::to_string(options.offset) + " bytes";
+      return result;
+    }
+
+    std::filesystem::resize_file(options.file_path, options.offset, ec);
+    if (ec) {
+      result.error = "Unable to truncate file: " + options.file_path;
+      return result;
+    }
+
+    // The hash covers the whole file so include the part which
+    // was written before.
+    if (options.hash) {
+      std::ifstream existing(options.file_path, std::ios::binary);
+      std::vector<BYTE> buffer(options.chunk_size);
+      while (existing) {
+        existing.read(reinterpret_cast<char*>(buffer.data()), buffer.size());
+        sha256.Update(buffer.data(), static_cast<size_t>(existing.gcount()));
+      }
+    }
+  }
+
+  std::ofstream file(options.file_path, std::ios::binary | std::ios::app);
+  if (!file) {
+    result.error = "Unable to open file: " + options.file_path;
+    return result;
+  }
+
+  auto write_chunk = [&file, &sha256, &options](const BYTE* data,
+                                                 size_t size) {
+    file.write(reinterpret_cast<const char*>(data), size);
+    if (options.hash) {
+      sha256.Update(data, size);
+    }
+    return file.good();
+  };
+
+  const ULONG64 end =
+      options.offset + std::min(options.max_bytes, options.size - options.offset);
+
+  std::vector<BYTE> read_buffer(options.chunk_size);
+  std::vector<BYTE> write_buffer(options.chunk_size);
+  std::future<bool> pending_write;
+  ULONG64 pending_size = 0;
+  ULONG64 offset = options.offset;
+  bool write_failed = false;
+
+  while (offset < end) {
+    ULONG size =
+        static_cast<ULONG>(std::min<ULONG64>(options.chunk_size, end - offset));
+    result.unreadable_bytes +=
+        ReadChunk(options.address + offset, read_buffer.data(), size);
+
+    // Wait for the previous chunk to be written before its
+    // buffer is reused for the chunk which was just read.
+    if (pending_write.valid()) {
+      if (!pending_write.get()) {
+        write_failed = true;
+        break;
+      }
+      result.next_offset += pending_size;
+      result.bytes_written += pending_size;
+    }
+
+    std::swap(read_buffer, write_buffer);
+    pending_write = std::async(std::launch::async, write_chunk,
+                               write_buffer.data(), size);
+    pending_size = size;
+    offset += size;
+
+    if (progress && !progress(offset, options.size)) {
+      break;
+    }
+  }
+
+  if (pending_write.valid()) {
+    if (pending_write.get()) {
+      result.next_offset += pending_size;
+      result.bytes_written += pending_size;
+    } else {
+      write_failed = true;
+    }
+  }
+
+  file.close();
+  if (write_failed || file.fail()) {
+    result.error = "Unable to write to file: " + options.file_path;
+    return result;
+  }
+
+  result.success = true;
+  result.complete = result.next_offset == options.size;
+  if (options.hash) {
+    result.sha256 = sha256.FinalHex();
+  }
+  return result;
+}
+
+ULONG64 MemoryDumper::ReadChunk(ULONG64 address, BYTE* buffer, ULONG size) {
+  ULONG64 unreadable_bytes = 0;
+  ULONG position = 0;
+
+  while (position < size) {
+    ULONG bytes_read = 0;
+    HRESULT hr = interfaces_->data_spaces->ReadVirtual(
+        address + position, buffer + position, size - position, &bytes_read);
+    if (FAILED(hr)) {
+      bytes_read = 0;
+    }
+
+    position += std::min(bytes_read, size - position);
+    if (position >= size) {
+      break;
+    }
+
+    // Zero fill up to the next page. If the address is not in a readable
+    // region then skip the rest of the region instead of trying each page.
+    ULONG64 failed_address = address + position;
+    ULONG64 fill_end = (failed_address & ~(kPageSize - 1)) + kPageSize;
+
+    MEMORY_BASIC_INFORMATION64 info = {};
+    if (SUCCEEDED(interfaces_->data_spaces->QueryVirtual(failed_address,
+                                                         &info)) &&
+        !IsReadableRegion(info) &&
+        info.BaseAddress + info.RegionSize > fill_end) {
+      fill_end = info.BaseAddress + info.RegionSize;
+    }
+
+    ULONG fill_size = static_cast<ULONG>(
+        std::min<ULONG64>(fill_end - failed_address, size - position));
+    memset(buffer + position, 0, fill_size);
+    unreadable_bytes += fill_size;
+    position += fill_size;
+  }
+
+  return unreadable_bytes;
+}
+
+}  // namespace memory_dump
@@ -0,0 +1,108 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef MEMORY_DUMP_H_
+#define MEMORY_DUMP_H_
+
+#include <dbgeng.h>
+#include <windows.h>
+#include <functional>
+#include <string>
+
+#include "utils.h"
+
+namespace memory_dump {
+
+// Incremental SHA-256 (FIPS 180-4).
+class Sha256 {
+ public:
+  Sha256();
+
+  void Update(const BYTE* data, size_t size);
+
+  // Returns the digest as a lowercase hex string. No
+  // more data can be added after this is called.
+  std::string FinalHex();
+
+ private:
+  void ProcessBlock(const BYTE* block);
+
+  ULONG state_[8];
+  BYTE block_[64];
+  size_t block_size_ = 0;
+  ULONG64 total_size_ = 0;
+};
+
+struct DumpOptions {
+  // The virtual address range to dump.
+  ULONG64 address = 0;
+  ULONG64 size = 0;
+
+  std::string file_path;
+
+  // Offset within the range to start dumping at. The file must already
+  // contain at least this many bytes. It is truncated to this size and
+  // the rest of the range is appended to it. Zero creates a new file.
+  ULONG64 offset = 0;
+
+  // Compute the SHA-256 of the whole file (including
+  // the part which was written by a previous call).
+  bool hash = false;
+
+  // Stop after this many bytes have been written so that a single call
+  // does not block the debugger for too long. The dump can be resumed
+  // from DumpResult::next_offset.
+  ULONG64 max_bytes = ~0ULL;
+
+  ULONG chunk_size = 1024 * 1024;
+};
+
+struct DumpResult {
+  bool success = false;
+  std::string error;
+
+  // True if the whole range has been written to the file. If false
+  // then the dump can be resumed by setting DumpOptions::offset to
+  // next_offset.
+  bool complete = false;
+  ULONG64 next_offset = 0;
+
+  // The number of bytes written by this call.
+  ULONG64 bytes_written = 0;
+
+  // Pages which could not be read are written as zeros.
+  ULONG64 unreadable_bytes = 0;
+
+  // The SHA-256 of the file contents if DumpOptions::hash was set.
+  std::string sha256;
+};
+
+// Called after each chunk with the offset within the range which has
+// been reached and the total size of the range. Returning false stops
+// the dump early (it can be resumed later).
+using ProgressCallback =
+    std::function<bool(ULONG64 offset, ULONG64 total_size)>;
+
+class MemoryDumper {
+ public:
+  explicit MemoryDumper(const utils::DebugInterfaces* interfaces);
+
+  // Reads the range from the target in chunks and writes it to the file.
+  // Each chunk is written (and hashed) on a background thread while the
+  // next chunk is read from the target so the data never has to be
+  // formatted as text. Must be called on the thread which owns the
+  // debugger engine.
+  DumpResult Dump(const DumpOptions& options,
+                  const ProgressCallback& progress = nullptr);
+
+ private:
+  // Reads size bytes at address into buffer. Pages which can't
+  // be read are zero filled. Returns the number of zero filled bytes.
+  ULONG64 ReadChunk(ULONG64 address, BYTE* buffer, ULONG size);
+
+  const utils::DebugInterfaces* interfaces_;
+};
+
+}  // namespace memory_dump
+
+#endif  // MEMORY_DUMP_H_
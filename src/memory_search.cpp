@@ -0,0 +1,421 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "memory_search.h"
+
+#include <algorithm>
+#include <cstring>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define MEMORY_SEARCH_USE_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
+
+namespace memory_search {
+
+namespace {
+
+constexpr size_t kPointerSize = sizeof(ULONG64);
+
+const char kContinuationTokenPrefix[] = "ms1:";
+
+#if defined(_WIN32)
+// Regions are read and scanned in chunks of this size.
+constexpr ULONG kChunkSize = 1024 * 1024;
+
+constexpr ULONG64 kPageSize = 0x1000;
+
+bool IsSearchableRegion(const MEMORY_BASIC_INFORMATION64& info) {
+  if (info.State != MEM_COMMIT) {
+    return false;
+  }
+  return (info.Protect & (PAGE_NOACCESS | PAGE_GUARD)) == 0;
+}
+#endif
+
+#if defined(MEMORY_SEARCH_USE_SSE2)
+unsigned CountTrailingZeros(unsigned value) {
+#if defined(_MSC_VER)
+  unsigned long index = 0;
+  _BitScanForward(&index, value);
+  return index;
+#else
+  return __builtin_ctz(value);
+#endif
+}
+#endif
+
+int HexDigitValue(char c) {
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  return -1;
+}
+
+void AppendUtf16(std::vector<BYTE>& bytes, ULONG code_unit) {
+  bytes.push_back(static_cast<BYTE>(code_unit & 0xFF));
+  bytes.push_back(static_cast<BYTE>((code_unit >> 8) & 0xFF));
+}
+
+}  // namespace
+
+void FindPattern(const BYTE* data,
+                 size_t size,
+                 const BYTE* pattern,
+                 size_t pattern_size,
+                 const std::function<bool(size_t offset)>& on_match) {
+  if (pattern_size == 0 || size < pattern_size) {
+    return;
+  }
+
+  const size_t last_start = size - pattern_size;
+  size_t i = 0;
+
+#if defined(MEMORY_SEARCH_USE_SSE2)
+  // Compare 16 candidate positions at a time against the first and the
+  // last byte of the pattern. Only the positions where both match are
+  // compared in full.
+  const __m128i first_byte = _mm_set1_epi8(static_cast<char>(pattern[0]));
+  const __m128i last_byte =
+      _mm_set1_epi8(static_cast<char>(pattern[pattern_size - 1]));
+
+  for (; i + 16 <= last_start + 1; i += 16) {
+    __m128i block_first =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+    __m128i block_last = _mm_loadu_si128(
+        reinterpret_cast<const __m128i*>(data + i + pattern_size - 1));
+
+    unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(block_first, first_byte),
+                      _mm_cmpeq_epi8(block_last, last_byte))));
+
+    while (mask != 0) {
+      size_t offset = i + CountTrailingZeros(mask);
+      if (pattern_size <= 2 ||
+          memcmp(data + offset + 1, pattern + 1, pattern_size - 2) == 0) {
+        if (!on_match(offset)) {
+          return;
+        }
+      }
+      mask &= mask - 1;
+    }
+  }
+#endif
+
+  for (; i <= last_start; i++) {
+    if (data[i] == pattern[0] &&
+        memcmp(data + i, pattern, pattern_size) == 0) {
+      if (!on_match(i)) {
+        return;
+      }
+    }
+  }
+}
+
+void FindPointers(const BYTE* data,
+                  size_t size,
+                  ULONG64 base_address,
+                  ULONG64 min_value,
+                  ULONG64 max_value,
+                  const std::function<bool(size_t offset)>& on_match) {
+  if (max_value < min_value) {
+    return;
+  }
+
+  // A single unsigned comparison checks both ends of the range.
+  const ULONG64 range = max_value - min_value;
+  size_t offset = static_cast<size_t>((kPointerSize - (base_address & 7)) & 7);
+
+  for (; offset + kPointerSize <= size; offset += kPointerSize) {
+    ULONG64 value = 0;
+    memcpy(&value, data + offset, kPointerSize);
+    if (value - min_value <= range) {
+      if (!on_match(offset)) {
+        return;
+      }
+    }
+  }
+}
+
+bool ParseHexBytes(const std::string& text, std::vector<BYTE>& bytes) {
+  bytes.clear();
+
+  std::string normalized = text;
+  std::replace(normalized.begin(), normalized.end(), ',', ' ');
+
+  for (std::string token : utils::SplitString(normalized, " ")) {
+    token = utils::Trim(token);
+    if (token.size() > 2 && token[0] == '0' &&
+        (token[1] == 'x' || token[1] == 'X')) {
+      token = token.substr(2);
+    }
+
+    if (token.empty()) {
+      continue;
+    }
+
+    // A single digit is a whole byte (e.g. "a" is 0x0a)
+    if (token.size() == 1) {
+      token = "0" + token;
+    }
+
+    if (token.size() % 2 != 0) {
+      return false;
+    }
+
+    for (size_t i = 0; i < token.size(); i += 2) {
+      int high = HexDigitValue(token[i]);
+      int low = HexDigitValue(token[i + 1]);
+      if (high < 0 || low < 0) {
+        return false;
+      }
+      bytes.push_back(static_cast<BYTE>((high << 4) | low));
+    }
+  }
+
+  return !bytes.empty();
+}
+
+std::vector<BYTE> EncodeUtf16(const std::string& text) {
+  std::vector<BYTE> bytes;
+  bytes.reserve(text.size() * 2);
+
+  size_t i = 0;
+  while (i < text.size()) {
+    BYTE lead = static_cast<BYTE>(text[i]);
+    ULONG code_point = 0xFFFD;
+    size_t length = 1;
+
+    if (lead < 0x80) {
+      code_point = lead;
+    } else if ((lead & 0xE0) == 0xC0) {
+      code_point = lead & 0x1F;
+      length = 2;
+    } else if ((lead & 0xF0) == 0xE0) {
+      code_point = lead & 0x0F;
+      length = 3;
+    } else if ((lead & 0xF8) == 0xF0) {
+      code_point = lead & 0x07;
+      length = 4;
+    }
+
+    if (length > 1) {
+      if (i + length > text.size()) {
+        code_point = 0xFFFD;
+        length = 1;
+      } else {
+        for (size_t j = 1; j < length; j++) {
+          BYTE continuation = static_cast<BYTE>(text[i + j]);
+          if ((continuation & 0xC0) != 0x80) {
+            code_point = 0xFFFD;
+            length = j;
+            break;
+          }
+          code_point = (code_point << 6) | (continuation & 0x3F);
+        }
+      }
+    }
+
+    if (code_point >= 0x10000) {
+      code_point -= 0x10000;
+      AppendUtf16(bytes, 0xD800 + (code_point >> 10));
+      AppendUtf16(bytes, 0xDC00 + (code_point & 0x3FF));
+    } else {
+      AppendUtf16(bytes, code_point);
+    }
+
+    i += length;
+  }
+
+  return bytes;
+}
+
+std::string FormatHexBytes(const std::vector<BYTE>& bytes) {
+  static const char kHexDigits[] = "0123456789abcdef";
+
+  std::string text;
+  text.reserve(bytes.size() * 3);
+  for (size_t i = 0; i < bytes.size(); i++) {
+    if (i > 0) {
+      text += ' ';
+    }
+    text += kHexDigits[bytes[i] >> 4];
+    text += kHexDigits[bytes[i] & 0x0F];
+  }
+  return text;
+}
+
+std::string EncodeContinuationToken(ULONG64 next_address) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%s%llx", kContinuationTokenPrefix,
+           static_cast<unsigned long long>(next_address));
+  return buffer;
+}
+
+bool DecodeContinuationToken(const std::string& token, ULONG64& next_address) {
+  const size_t prefix_length = sizeof(kContinuationTokenPrefix) - 1;
+  if (token.size() <= prefix_length ||
+      token.compare(0, prefix_length, kContinuationTokenPrefix) != 0) {
+    return false;
+  }
+
+  ULONG64 value = 0;
+  for (size_t i = prefix_length; i < token.size(); i++) {
+    int digit = HexDigitValue(token[i]);
+    if (digit < 0 || value > (~0ULL >> 4)) {
+      return false;
+    }
+    value = (value << 4) | digit;
+  }
+
+  next_address = value;
+  return true;
+}
+
+// The searcher reads the target through the engine. The scanning
+// functions above are also built on other platforms for source_search.
+#if defined(_WIN32)
+MemorySearcher::MemorySearcher(const utils::DebugInterfaces* interfaces)
+    : interfaces_(interfaces) {}
+
+SearchResult MemorySearcher::Search(const SearchOptions& options) {
+  SearchResult result;
+
+  const bool is_pointer_search = options.type == PatternType::kPointer;
+  const size_t pattern_size =
+      is_pointer_search ? kPointerSize : options.pattern.size();
+
+  // Pointer searches only look at pointer aligned addresses.
+  ULONG64 address = options.start;
+  if (is_pointer_search && (address & 7) != 0) {
+    address = (address | 7) + 1;
+  }
+
+  if (pattern_size == 0 || options.max_hits == 0 || address < options.start) {
+    result.complete = true;
+    result.next_address = options.end;
+    return result;
+  }
+
+  std::vector<BYTE> buffer;
+
+  while (address < options.end) {
+    MEMORY_BASIC_INFORMATION64 info = {};
+    if (FAILED(interfaces_->data_spaces->QueryVirtual(address, &info))) {
+      // There are no more regions in the address space.
+      break;
+    }
+
+    ULONG64 region_end = info.BaseAddress + info.RegionSize;
+    if (region_end <= address) {
+      break;
+    }
+
+    if (!IsSearchableRegion(info)) {
+      address = region_end;
+      continue;
+    }
+
+    result.regions_scanned++;
+    const ULONG64 scan_end = std::min(region_end, options.end);
+
+    while (address < scan_end) {
+      if (result.bytes_scanned >= options.max_bytes_scanned) {
+        result.next_address = address;
+        return result;
+      }
+
+      // Read a few extra bytes past the end of the chunk so that matches
+      // which start in this chunk and end in the next one are found.
+      const ULONG64 chunk_size =
+          std::min<ULONG64>(kChunkSize, scan_end - address);
+      const ULONG64 read_size = std::min<ULONG64>(
+          chunk_size + pattern_size - 1, region_end - address);
+
+      buffer.resize(static_cast<size_t>(read_size));
+      ULONG bytes_read = 0;
+      HRESULT hr = interfaces_->data_spaces->ReadVirtual(
+          address, buffer.data(), static_cast<ULONG>(read_size), &bytes_read);
+      if (FAILED(hr)) {
+        bytes_read = 0;
+      }
+
+      bool reached_max_hits = false;
+      auto on_match = [&](size_t offset) {
+        // This match belongs to the next chunk.
+        if (offset >= chunk_size) {
+          return false;
+        }
+
+        SearchHit hit;
+        hit.address = address + offset;
+        hit.region_base = info.BaseAddress;
+        if (is_pointer_search) {
+          memcpy(&hit.value, buffer.data() + offset, kPointerSize);
+        }
+
+        size_t available = bytes_read - offset;
+        if (available >= options.context_bytes) {
+          hit.context.assign(buffer.begin() + offset,
+                             buffer.begin() + offset + options.context_bytes);
+        } else {
+          hit.context.resize(options.context_bytes);
+          ULONG context_read = 0;
+          hr = interfaces_->data_spaces->ReadVirtual(
+              hit.address, hit.context.data(), options.context_bytes,
+              &context_read);
+          hit.context.resize(SUCCEEDED(hr) ? context_read : 0);
+        }
+
+        result.hits.push_back(std::move(hit));
+        if (result.hits.size() >= options.max_hits) {
+          reached_max_hits = true;
+          return false;
+        }
+        return true;
+      };
+
+      if (is_pointer_search) {
+        FindPointers(buffer.data(), bytes_read, address, options.min_value,
+                     options.max_value, on_match);
+      } else {
+        FindPattern(buffer.data(), bytes_read, options.pattern.data(),
+                    pattern_size, on_match);
+      }
+
+      if (reached_max_hits) {
+        result.next_address =
+            result.hits.back().address + (is_pointer_search ? kPointerSize : 1);
+        result.bytes_scanned += result.next_address - address;
+        return result;
+      }
+
+      ULONG64 advance = chunk_size;
+      if (bytes_read < chunk_size) {
+        // Skip past the page which could not be read.
+        ULONG64 failed_address = address + bytes_read;
+        ULONG64 next_page = (failed_address & ~(kPageSize - 1)) + kPageSize;
+        advance = std::min(next_page, scan_end) - address;
+      }
+
+      result.bytes_scanned += advance;
+      address += advance;
+    }
+  }
+
+  result.complete = true;
+  result.next_address = std::min(address, options.end);
+  return result;
+}
+#endif  // defined(_WIN32)
+
+}  // namespace memory_search
@@ -0,0 +1,118 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef MEMORY_SEARCH_H_
+#define MEMORY_SEARCH_H_
+
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "dbgeng_shim.h"
+#include "utils.h"
+
+namespace memory_search {
+
+enum class PatternType {
+  kBytes,
+  kAscii,
+  kUtf16,
+  // Aligned 64-bit values within [min_value, max_value].
+  kPointer,
+};
+
+struct SearchOptions {
+  PatternType type = PatternType::kBytes;
+
+  // The bytes to search for. Not used for kPointer searches.
+  std::vector<BYTE> pattern;
+
+  // Inclusive value range for kPointer searches.
+  ULONG64 min_value = 0;
+  ULONG64 max_value = 0;
+
+  // The range of virtual addresses to search [start, end).
+  ULONG64 start = 0;
+  ULONG64 end = ~0ULL;
+
+  // Stop after this many hits.
+  size_t max_hits = 100;
+
+  // Number of bytes to return for each hit starting at the hit address.
+  ULONG context_bytes = 16;
+
+  // Stop after this many bytes have been scanned so that a single search
+  // does not block the debugger for too long. The search can be resumed
+  // from SearchResult::next_address.
+  ULONG64 max_bytes_scanned = 512ULL * 1024 * 1024;
+};
+
+struct SearchHit {
+  ULONG64 address = 0;
+  ULONG64 region_base = 0;
+  // The matching value for kPointer searches.
+  ULONG64 value = 0;
+  std::vector<BYTE> context;
+};
+
+struct SearchResult {
+  std::vector<SearchHit> hits;
+
+  // True if the whole range was searched. If false then the
+  // search can be resumed by starting at next_address.
+  bool complete = false;
+  ULONG64 next_address = 0;
+
+  ULONG64 bytes_scanned = 0;
+  size_t regions_scanned = 0;
+};
+
+// Calls on_match with the offset of every occurrence of pattern in data.
+// Scanning stops early if on_match returns false. Uses SSE2 to find
+// candidate positions where both the first and last bytes of the
+// pattern match and then confirms each candidate with memcmp.
+void FindPattern(const BYTE* data,
+                 size_t size,
+                 const BYTE* pattern,
+                 size_t pattern_size,
+                 const std::function<bool(size_t offset)>& on_match);
+
+// Calls on_match with the offset of every 8 byte aligned value in data
+// which is within [min_value, max_value]. base_address is the address
+// of data[0] and is used to determine the alignment.
+void FindPointers(const BYTE* data,
+                  size_t size,
+                  ULONG64 base_address,
+                  ULONG64 min_value,
+                  ULONG64 max_value,
+                  const std::function<bool(size_t offset)>& on_match);
+
+// Parses hex bytes such as "48 8b 05", "488b05" or "0x48 0x8b".
+bool ParseHexBytes(const std::string& text, std::vector<BYTE>& bytes);
+
+// Converts UTF-8 text to UTF-16LE bytes.
+std::vector<BYTE> EncodeUtf16(const std::string& text);
+
+// Formats bytes as space separated hex pairs.
+std::string FormatHexBytes(const std::vector<BYTE>& bytes);
+
+// The continuation token is an opaque string for callers. It encodes
+// the address where the next search should start.
+std::string EncodeContinuationToken(ULONG64 next_address);
+bool DecodeContinuationToken(const std::string& token, ULONG64& next_address);
+
+class MemorySearcher {
+ public:
+  explicit MemorySearcher(const utils::DebugInterfaces* interfaces);
+
+  // Enumerates the committed and accessible regions in the search
+  // range with QueryVirtual and scans them in large chunks.
+  SearchResult Search(const SearchOptions& options);
+
+ private:
+  const utils::DebugInterfaces* interfaces_;
+};
+
+}  // namespace memory_search
+
+#endif  // MEMORY_SEARCH_H_
@@ -0,0 +1,159 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+// Commands for exporting target memory. Unlike .writemem the dump is
+// streamed to the file in large chunks, unreadable pages are written as
+// zeros instead of failing the whole dump and an interrupted dump can
+// be resumed.
+#include <dbgeng.h>
+#include <windows.h>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "memory_dump.h"
+#include "utils.h"
+
+utils::DebugInterfaces g_debug;
+
+// Evaluate a MASM expression (e.g. "@rcx", "0x1234" or "@@c++(&foo)").
+bool EvaluateValue(const std::string& expression, ULONG64& value) {
+  DEBUG_VALUE result = {};
+  HRESULT hr = g_debug.control->Evaluate(expression.c_str(), DEBUG_VALUE_INT64,
+                                         &result, nullptr);
+  if (FAILED(hr)) {
+    DERROR("Error: Unable to evaluate expression: %s\n", expression.c_str());
+    return false;
+  }
+
+  value = result.I64;
+  return true;
+}
+
+HRESULT CALLBACK DumpMemoryInternal(IDebugClient* client, const char* args) {
+  if (!args || !*args || (args[0] == '?' && args[1] == '\0')) {
+    DOUT(
+        "DumpMemory - Write a range of virtual memory to a file.\n\n"
+        "Usage: !DumpMemory [/h] [/r] <address> <size> <file>\n\n"
+        "  /h         - Display the SHA-256 of the file when done\n"
+        "  /r         - Resume a previous dump of the same range. The dump\n"
+        "               continues from the current size of the file\n"
+        "  <address>  - Start address expression\n"
+        "  <size>     - Size expression in bytes\n"
+        "  <file>     - The file to write to\n\n"
+        "Pages which can not be read are written as zeros. Press Ctrl+Break\n"
+        "to stop the dump. It can be continued later with /r.\n\n"
+        "Examples:\n"
+        "  !DumpMemory @rcx 0x100000 c:\\temp\\frame.bin\n"
+        "  !DumpMemory /h 0x000001a2`00000000 0x40000000 c:\\temp\\heap.bin\n"
+        "  !DumpMemory /r /h 0x000001a2`00000000 0x40000000 c:\\temp\\heap.bin\n\n");
+    return S_OK;
+  }
+
+  std::vector<std::string> parsed_args = utils::ParseCommandLine(args);
+
+  bool hash = false;
+  bool resume = false;
+  size_t arg_index = 0;
+  for (; arg_index < parsed_args.size(); arg_index++) {
+    const std::string& arg = parsed_args[arg_index];
+    if (arg == "/h") {
+      hash = true;
+    } else if (arg == "/r") {
+      resume = true;
+    } else {
+      break;
+    }
+  }
+
+  if (parsed_args.size() - arg_index != 3) {
+    DERROR("Error: Expected 3 arguments. Use !DumpMemory ? for help.\n");
+    return E_INVALIDARG;
+  }
+
+  memory_dump::DumpOptions options;
+  options.hash = hash;
+  options.file_path = parsed_args[arg_index + 2];
+  if (!EvaluateValue(parsed_args[arg_index], options.address) ||
+      !EvaluateValue(parsed_args[arg_index + 1], options.size)) {
+    return E_INVALIDARG;
+  }
+
+  if (resume) {
+    std::error_code ec;
+    uintmax_t file_size = std::filesystem::file_size(options.file_path, ec);
+    if (ec) {
+      DERROR("Error: Unable to resume, %s does not exist.\n",
+             options.file_path.c_str());
+      return E_INVALIDARG;
+    }
+    options.offset = std::min<ULONG64>(file_size, options.size);
+  }
+
+  // Display the progress in 10% steps.
+  ULONG64 next_progress = options.size / 10;
+  bool interrupted = false;
+  auto progress = [&](ULONG64 offset, ULONG64 total_size) {
+    if (g_debug.control->GetInterrupt() == S_OK) {
+      interrupted = true;
+      return false;
+    }
+
+    if (offset >= next_progress && offset < total_size) {
+      DOUT("  %u%%\n", static_cast<ULONG>(offset * 100 / total_size));
+      next_progress = offset + total_size / 10;
+    }
+    return true;
+  };
+
+  memory_dump::MemoryDumper dumper(&g_debug);
+  memory_dump::DumpResult result = dumper.Dump(options, progress);
+  if (!result.success) {
+    DERROR("Error: %s\n", result.error.c_str());
+    return E_FAIL;
+  }
+
+  if (interrupted) {
+    DOUT("Interrupted after 0x%llx of 0x%llx bytes. Use /r to resume.\n",
+         result.next_offset, options.size);
+    return S_OK;
+  }
+
+  DOUT("Wrote 0x%llx bytes to %s\n", result.bytes_written,
+       options.file_path.c_str());
+  if (result.unreadable_bytes > 0) {
+    DOUT("0x%llx bytes could not be read and were written as zeros\n",
+         result.unreadable_bytes);
+  }
+  if (hash) {
+    DOUT("SHA-256: %s\n", result.sha256.c_str());
+  }
+  return S_OK;
+}
+
+HRESULT CALLBACK DebugExtensionInitializeInternal(PULONG version,
+                                                  PULONG flags) {
+  *version = DEBUG_EXTENSION_VERSION(1, 0);
+  *flags = 0;
+  return utils::InitializeDebugInterfaces(&g_debug);
+}
+
+HRESULT CALLBACK DebugExtensionUninitializeInternal() {
+  return utils::UninitializeDebugInterfaces(&g_debug);
+}
+
+extern "C" {
+__declspec(dllexport) HRESULT CALLBACK DebugExtensionInitialize(PULONG version,
+                                                                PULONG flags) {
+  return DebugExtensionInitializeInternal(version, flags);
+}
+
+__declspec(dllexport) HRESULT CALLBACK DebugExtensionUninitialize(void) {
+  return DebugExtensionUninitializeInternal();
+}
+
+__declspec(dllexport) HRESULT CALLBACK DumpMemory(IDebugClient* client,
+                                                  const char* args) {
+  return DumpMemoryInternal(client, args);
+}
+}
@@ -0,0 +1,478 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "minidump_reader.h"
+
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+
+namespace minidump {
+
+namespace {
+
+constexpr uint32_t kSignature = 0x504d444d;  // "MDMP"
+constexpr uint32_t kCodeViewSignature = 0x53445352;  // "RSDS"
+
+// Sizes of the fixed size structures in the file.
+constexpr size_t kHeaderSize = 32;
+constexpr size_t kDirectorySize = 12;
+constexpr size_t kModuleSize = 108;
+constexpr size_t kThreadSize = 48;
+constexpr size_t kMemoryDescriptorSize = 16;
+constexpr size_t kMemoryDescriptor64Size = 16;
+constexpr size_t kExceptionStreamSize = 168;
+constexpr size_t kSystemInfoSize = 56;
+constexpr size_t kMaxExceptionParameters = 15;
+
+struct RegisterOffset {
+  const char* name;
+  uint32_t offset;
+  uint32_t size;
+};
+
+// Offsets of the integer registers in the x64 CONTEXT.
+const RegisterOffset kAmd64Registers[] = {
+    {"rax", 0x78, 8}, {"rbx", 0x90, 8}, {"rcx", 0x80, 8}, {"rdx", 0x88, 8},
+    {"rsi", 0xa8, 8}, {"rdi", 0xb0, 8}, {"rip", 0xf8, 8}, {"rsp", 0x98, 8},
+    {"rbp", 0xa0, 8}, {"r8", 0xb8, 8},  {"r9", 0xc0, 8},  {"r10", 0xc8, 8},
+    {"r11", 0xd0, 8}, {"r12", 0xd8, 8}, {"r13", 0xe0, 8}, {"r14", 0xe8, 8},
+    {"r15", 0xf0, 8}, {"efl", 0x44, 4}};
+
+// Offsets of the integer registers in the x86 CONTEXT.
+const RegisterOffset kIntelRegisters[] = {
+    {"eax", 0xb0, 4}, {"ebx", 0xa4, 4}, {"ecx", 0xac, 4}, {"edx", 0xa8, 4},
+    {"esi", 0xa0, 4}, {"edi", 0x9c, 4}, {"eip", 0xb8, 4}, {"esp", 0xc4, 4},
+    {"ebp", 0xb4, 4}, {"efl", 0xc0, 4}};
+
+// Offsets of the integer registers in the ARM64 CONTEXT.
+const RegisterOffset kArm64Registers[] = {
+    {"x0", 0x08, 8},   {"x1", 0x10, 8},   {"x2", 0x18, 8},   {"x3", 0x20, 8},
+    {"x4", 0x28, 8},   {"x5", 0x30, 8},   {"x6", 0x38, 8},   {"x7", 0x40, 8},
+    {"x8", 0x48, 8},   {"x9", 0x50, 8},   {"x10", 0x58, 8},  {"x11", 0x60, 8},
+    {"x12", 0x68, 8},  {"x13", 0x70, 8},  {"x14", 0x78, 8},  {"x15", 0x80, 8},
+    {"x16", 0x88, 8},  {"x17", 0x90, 8},  {"x18", 0x98, 8},  {"x19", 0xa0, 8},
+    {"x20", 0xa8, 8},  {"x21", 0xb0, 8},  {"x22", 0xb8, 8},  {"x23", 0xc0, 8},
+    {"x24", 0xc8, 8},  {"x25", 0xd0, 8},  {"x26", 0xd8, 8},  {"x27", 0xe0, 8},
+    {"x28", 0xe8, 8},  {"fp", 0xf0, 8},   {"lr", 0xf8, 8},   {"sp", 0x100, 8},
+    {"pc", 0x108, 8},  {"cpsr", 0x04, 4}};
+
+template <typename T>
+T Read(const uint8_t* data) {
+  T value;
+  memcpy(&value, data, sizeof(T));
+  return value;
+}
+
+// Converts UTF-16 to UTF-8.
+std::string ToUtf8(const uint8_t* data, size_t length) {
+  std::string result;
+  result.reserve(length);
+
+  for (size_t i = 0; i < length; i++) {
+    uint32_t c = Read<uint16_t>(data + i * 2);
+    if (c >= 0xd800 && c < 0xdc00 && i + 1 < length) {
+      uint32_t low = Read<uint16_t>(data + (i + 1) * 2);
+      if (low >= 0xdc00 && low < 0xe000) {
+        c = 0x10000 + ((c - 0xd800) << 10) + (low - 0xdc00);
+        i++;
+      }
+    }
+
+    if (c < 0x80) {
+      result += static_cast<char>(c);
+    } else if (c < 0x800) {
+      result += static_cast<char>(0xc0 | (c >> 6));
+      result += static_cast<char>(0x80 | (c & 0x3f));
+    } else if (c < 0x10000) {
+      result += static_cast<char>(0xe0 | (c >> 12));
+      result += static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+      result += static_cast<char>(0x80 | (c & 0x3f));
+    } else {
+      result += static_cast<char>(0xf0 | (c >> 18));
+      result += static_cast<char>(0x80 | ((c >> 12) & 0x3f));
+      result += static_cast<char>(0x80 | ((c >> 6) & 0x3f));
+      result += static_cast<char>(0x80 | (c & 0x3f));
+    }
+  }
+
+  return result;
+}
+
+Location ReadLocation(const uint8_t* data) {
+  return {Read<uint32_t>(data), Read<uint32_t>(data + 4)};
+}
+
+}  // namespace
+
+bool MinidumpReader::Open(const std::string& path, std::string& error) {
+  if (!file_.Open(path)) {
+    error = "Unable to open file: " + path;
+    return false;
+  }
+
+  const uint8_t* header = GetData({kHeaderSize, 0});
+  if (!header || Read<uint32_t>(header) != kSignature) {
+    error = "Not a minidump file: " + path;
+    return false;
+  }
+
+  time_date_stamp_ = Read<uint32_t>(header + 20);
+  uint32_t stream_count = Read<uint32_t>(header + 8);
+  uint32_t directory_rva = Read<uint32_t>(header + 12);
+
+  const uint8_t* directory = GetData(
+      {static_cast<uint64_t>(stream_count) * kDirectorySize, directory_rva});
+  if (!directory) {
+    error = "The stream directory is outside of the file";
+    return false;
+  }
+
+  // The system info is needed to decode the thread contexts
+  // so all of the streams are found before reading them.
+  Location streams[kMemory64ListStream + 1];
+  bool found[kMemory64ListStream + 1] = {};
+  for (uint32_t i = 0; i < stream_count; i++) {
+    const uint8_t* entry = directory + i * kDirectorySize;
+    uint32_t type = Read<uint32_t>(entry);
+    if (type <= kMemory64ListStream && !found[type]) {
+      found[type] = true;
+      streams[type] = ReadLocation(entry + 4);
+    }
+  }
+
+  struct StreamReader {
+    StreamType type;
+    bool (MinidumpReader::*read)(const Location&);
+    const char* name;
+  };
+  const StreamReader readers[] = {
+      {kSystemInfoStream, &MinidumpReader::ReadSystemInfo, "system info"},
+      {kModuleListStream, &MinidumpReader::ReadModuleList, "module list"},
+      {kThreadListStream, &MinidumpReader::ReadThreadList, "thread list"},
+      {kMemoryListStream, &MinidumpReader::ReadMemoryList, "memory list"},
+      {kMemory64ListStream, &MinidumpReader::ReadMemory64List,
+       "memory64 list"},
+      {kExceptionStream, &MinidumpReader::ReadException, "exception"}};
+
+  for (const StreamReader& reader : readers) {
+    if (found[reader.type] && !(this->*reader.read)(streams[reader.type])) {
+      error = std::string("The ") + reader.name + " stream is invalid";
+      return false;
+    }
+  }
+
+  std::sort(modules_.begin(), modules_.end(),
+            [](const Module& a, const Module& b) { return a.base < b.base; });
+  std::sort(memory_ranges_.begin(), memory_ranges_.end(),
+            [](const MemoryRange& a, const MemoryRange& b) {
+              return a.start < b.start;
+            });
+  return true;
+}
+
+const uint8_t* MinidumpReader::GetData(const Location& location) const {
+  if (location.rva > file_.size() ||
+      location.size > file_.size() - location.rva) {
+    return nullptr;
+  }
+  return reinterpret_cast<const uint8_t*>(file_.data()) + location.rva;
+}
+
+std::string MinidumpReader::ReadString(uint32_t rva) const {
+  // MINIDUMP_STRING: the length in bytes followed by UTF-16 characters.
+  const uint8_t* length = GetData({4, rva});
+  if (!length) {
+    return "";
+  }
+
+  uint32_t byte_count = Read<uint32_t>(length);
+  const uint8_t* characters = GetData({byte_count, rva + 4ULL});
+  return characters ? ToUtf8(characters, byte_count / 2) : "";
+}
+
+bool MinidumpReader::ReadSystemInfo(const Location& location) {
+  const uint8_t* data = GetData(location);
+  if (!data || location.size < kSystemInfoSize) {
+    return false;
+  }
+
+  system_info_.processor_architecture = Read<uint16_t>(data);
+  system_info_.processor_count = data[6];
+  system_info_.major_version = Read<uint32_t>(data + 8);
+  system_info_.minor_version = Read<uint32_t>(data + 12);
+  system_info_.build_number = Read<uint32_t>(data + 16);
+  return true;
+}
+
+bool MinidumpReader::ReadModuleList(const Location& location) {
+  const uint8_t* data = GetData(location);
+  if (!data || location.size < 4) {
+    return false;
+  }
+
+  uint32_t count = Read<uint32_t>(data);
+  if ((location.size - 4) / kModuleSize < count) {
+    return false;
+  }
+
+  modules_.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    const uint8_t* entry = data + 4 + i * kModuleSize;
+
+    Module module;
+    module.base = Read<uint64_t>(entry);
+    module.size = Read<uint32_t>(entry + 8);
+    module.checksum = Read<uint32_t>(entry + 12);
+    module.time_date_stamp = Read<uint32_t>(entry + 16);
+    module.name = ReadString(Read<uint32_t>(entry + 20));
+
+    // CV_INFO_PDB70: signature, GUID, age and the PDB file name.
+    Location cv_record = ReadLocation(entry + 76);
+    const uint8_t* cv_data = GetData(cv_record);
+    if (cv_data && cv_record.size > 24 &&
+        Read<uint32_t>(cv_data) == kCodeViewSignature) {
+      const char* name = reinterpret_cast<const char*>(cv_data + 24);
+      module.pdb_name.assign(name, strnlen(name, cv_record.size - 24));
+    }
+
+    modules_.push_back(std::move(module));
+  }
+  return true;
+}
+
+bool MinidumpReader::ReadThreadList(const Location& location) {
+  const uint8_t* data = GetData(location);
+  if (!data || location.size < 4) {
+    return false;
+  }
+
+  uint32_t count = Read<uint32_t>(data);
+  if ((location.size - 4) / kThreadSize < count) {
+    return false;
+  }
+
+  threads_.reserve(count);
+  for (uint32_t i = 0; i < count; i++) {
+    const uint8_t* entry = data + 4 + i * kThreadSize;
+
+    Thread thread;
+    thread.id = Read<uint32_t>(entry);
+    thread.suspend_count = Read<uint32_t>(entry + 4);
+    thread.priority_class = Read<uint32_t>(entry + 8);
+    thread.priority = Read<uint32_t>(entry + 12);
+    thread.teb = Read<uint64_t>(entry + 16);
+    thread.stack_start = Read<uint64_t>(entry + 24);
+    thread.stack = ReadLocation(entry + 32);
+    thread.context = ReadLocation(entry + 40);
+    threads_.push_back(thread);
+  }
+  return true;
+}
+
+bool MinidumpReader::ReadMemoryList(const Location& location) {
+  const uint8_t* data = GetData(location);
+  if (!data || location.size < 4) {
+    return false;
+  }
+
+  uint32_t count = Read<uint32_t>(data);
+  if ((location.size - 4) / kMemoryDescriptorSize < count) {
+    return false;
+  }
+
+  for (uint32_t i = 0; i < count; i++) {
+    const uint8_t* entry = data + 4 + i * kMemoryDescriptorSize;
+    Location memory = ReadLocation(entry + 8);
+    if (GetData(memory)) {
+      memory_ranges_.push_back({Read<uint64_t>(entry), memory.size, memory.rva});
+    }
+  }
+  return true;
+}
+
+bool MinidumpReader::ReadMemory64List(const Location& location) {
+  const uint8_t* data = GetData(location);
+  if (!data || location.size < 16) {
+    return false;
+  }
+
+  // The memory of all of the ranges is stored contiguously from base_rva.
+  uint64_t count = Read<uint64_t>(data);
+  uint64_t rva = Read<uint64_t>(data + 8);
+  if ((location.size - 16) / kMemoryDescriptor64Size < count) {
+    return false;
+  }
+
+  for (uint64_t i = 0; i < count; i++) {
+    const uint8_t* entry = data + 16 + i * kMemoryDescriptor64Size;
+    MemoryRange range = {Read<uint64_t>(entry), Read<uint64_t>(entry + 8), rva};
+    if (!GetData({range.size, range.rva})) {
+      // The rest of the ranges are also truncated.
+      break;
+    }
+
+    memory_ranges_.push_back(range);
+    rva += range.size;
+  }
+  return true;
+}
+
+bool MinidumpReader::ReadException(const Location& location) {
+  const uint8_t* data = GetData(location);
+  if (!data || location.size < kExceptionStreamSize) {
+    return false;
+  }
+
+  has_exception_ = true;
+  exception_.thread_id = Read<uint32_t>(data);
+
+  // MINIDUMP_EXCEPTION starts after the thread id and alignment.
+  const uint8_t* record = data + 8;
+  exception_.code = Read<uint32_t>(record);
+  exception_.flags = Read<uint32_t>(record + 4);
+  exception_.address = Read<uint64_t>(record + 16);
+
+  uint32_t parameter_count = std::min<uint32_t>(
+      Read<uint32_t>(record + 24), static_cast<uint32_t>(kMaxExceptionParameters));
+  for (uint32_t i = 0; i < parameter_count; i++) {
+    exception_.parameters.push_back(Read<uint64_t>(record + 32 + i * 8));
+  }
+
+  exception_.context = ReadLocation(data + 160);
+  return true;
+}
+
+const Thread* MinidumpReader::FindThread(uint32_t thread_id) const {
+  for (const Thread& thread : threads_) {
+    if (thread.id == thread_id) {
+      return &thread;
+    }
+  }
+  return nullptr;
+}
+
+const Module* MinidumpReader::FindModule(uint64_t address) const {
+  auto it = std::upper_bound(
+      modules_.begin(), modules_.end(), address,
+      [](uint64_t value, const Module& module) { return value < module.base; });
+  if (it == modules_.begin()) {
+    return nullptr;
+  }
+
+  --it;
+  return address - it->base < it->size ? &*it : nullptr;
+}
+
+size_t MinidumpReader::ReadMemory(uint64_t address,
+                                  void* buffer,
+                                  size_t size) const {
+  auto it = std::upper_bound(memory_ranges_.begin(), memory_ranges_.end(),
+                             address,
+                             [](uint64_t value, const MemoryRange& range) {
+                               return value < range.start;
+                             });
+  if (it == memory_ranges_.begin()) {
+    return 0;
+  }
+  --it;
+
+  // Continue into the following ranges as long as they are adjacent.
+  size_t copied = 0;
+  uint8_t* output = static_cast<uint8_t*>(buffer);
+  while (copied < size && it != memory_ranges_.end()) {
+    uint64_t current = address + copied;
+    if (current < it->start || current - it->start >= it->size) {
+      break;
+    }
+
+    uint64_t offset = current - it->start;
+    size_t count =
+        static_cast<size_t>(std::min<uint64_t>(size - copied, it->size - offset));
+    memcpy(output + copied, file_.data() + it->rva + offset, count);
+    copied += count;
+    ++it;
+  }
+
+  return copied;
+}
+
+bool MinidumpReader::GetRegisters(const Location& context,
+                                  Registers& registers) const {
+  const RegisterOffset* table = nullptr;
+  size_t count = 0;
+  uint32_t min_size = 0;
+
+  switch (system_info_.processor_architecture) {
+    case kProcessorArchitectureAmd64:
+      table = kAmd64Registers;
+      count = std::size(kAmd64Registers);
+      min_size = 0x100;
+      break;
+    case kProcessorArchitectureIntel:
+      table = kIntelRegisters;
+      count = std::size(kIntelRegisters);
+      min_size = 0xcc;
+      break;
+    case kProcessorArchitectureArm64:
+      table = kArm64Registers;
+      count = std::size(kArm64Registers);
+      min_size = 0x110;
+      break;
+    default:
+      return false;
+  }
+
+  const uint8_t* data = GetData(context);
+  if (!data || context.size < min_size) {
+    return false;
+  }
+
+  registers.clear();
+  for (size_t i = 0; i < count; i++) {
+    uint64_t value = table[i].size == 8
+                         ? Read<uint64_t>(data + table[i].offset)
+                         : Read<uint32_t>(data + table[i].offset);
+    registers.emplace_back(table[i].name, value);
+  }
+  return true;
+}
+
+uint64_t MinidumpReader::GetRegister(const Location& context,
+                                     const char* name) const {
+  Registers registers;
+  if (!GetRegisters(context, registers)) {
+    return 0;
+  }
+
+  for (const auto& [register_name, value] : registers) {
+    if (register_name == name) {
+      return value;
+    }
+  }
+  return 0;
+}
+
+uint64_t MinidumpReader::GetInstructionPointer(const Location& context) const {
+  switch (system_info_.processor_architecture) {
+    case kProcessorArchitectureIntel:
+      return GetRegister(context, "eip");
+    case kProcessorArchitectureArm64:
+      return GetRegister(context, "pc");
+    default:
+      return GetRegister(context, "rip");
+  }
+}
+
+uint64_t MinidumpReader::GetStackPointer(const Location& context) const {
+  switch (system_info_.processor_architecture) {
+    case kProcessorArchitectureIntel:
+      return GetRegister(context, "esp");
+    case kProcessorArchitectureArm64:
+      return GetRegister(context, "sp");
+    default:
+      return GetRegister(context, "rsp");
+  }
+}
+
+}  // namespace minidump
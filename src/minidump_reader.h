@@ -0,0 +1,150 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef MINIDUMP_READER_H_
+#define MINIDUMP_READER_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "mapped_file.h"
+
+namespace minidump {
+
+// Values of the stream types and processor architectures which are
+// used from the MINIDUMP_* structures in minidumpapiset.h. The
+// structures are decoded by offset instead of including dbghelp so
+// that the reader also builds on Linux.
+enum StreamType : uint32_t {
+  kThreadListStream = 3,
+  kModuleListStream = 4,
+  kMemoryListStream = 5,
+  kExceptionStream = 6,
+  kSystemInfoStream = 7,
+  kMemory64ListStream = 9,
+};
+
+constexpr uint16_t kProcessorArchitectureIntel = 0;
+constexpr uint16_t kProcessorArchitectureArm64 = 12;
+constexpr uint16_t kProcessorArchitectureAmd64 = 9;
+
+// The location of a block of data within the file.
+struct Location {
+  uint64_t size = 0;
+  uint64_t rva = 0;
+};
+
+struct Module {
+  uint64_t base = 0;
+  uint32_t size = 0;
+  uint32_t checksum = 0;
+  uint32_t time_date_stamp = 0;
+  std::string name;
+  // The PDB file name from the CodeView (RSDS) record if there is one.
+  std::string pdb_name;
+};
+
+struct Thread {
+  uint32_t id = 0;
+  uint32_t suspend_count = 0;
+  uint32_t priority_class = 0;
+  uint32_t priority = 0;
+  uint64_t teb = 0;
+  uint64_t stack_start = 0;
+  Location stack;
+  Location context;
+};
+
+struct ExceptionInfo {
+  uint32_t thread_id = 0;
+  uint32_t code = 0;
+  uint32_t flags = 0;
+  uint64_t address = 0;
+  std::vector<uint64_t> parameters;
+  Location context;
+};
+
+struct SystemInfo {
+  uint16_t processor_architecture = 0;
+  uint8_t processor_count = 0;
+  uint32_t major_version = 0;
+  uint32_t minor_version = 0;
+  uint32_t build_number = 0;
+};
+
+// A range of the target's memory which is saved in the dump.
+struct MemoryRange {
+  uint64_t start = 0;
+  uint64_t size = 0;
+  uint64_t rva = 0;
+};
+
+// The integer registers of a thread context by name in the order
+// used by the r command ("rax", "rbx", ... "rip", "efl").
+using Registers = std::vector<std::pair<std::string, uint64_t>>;
+
+// Parses a minidump file which is memory mapped for the lifetime of
+// the reader. Only the module, thread, memory, exception and system
+// info streams are used. After Open succeeds all of the methods are
+// const and can be called from multiple threads at once.
+class MinidumpReader {
+ public:
+  bool Open(const std::string& path, std::string& error);
+
+  uint32_t GetTimeDateStamp() const { return time_date_stamp_; }
+  const SystemInfo& GetSystemInfo() const { return system_info_; }
+  const std::vector<Module>& GetModules() const { return modules_; }
+  const std::vector<Thread>& GetThreads() const { return threads_; }
+  const std::vector<MemoryRange>& GetMemoryRanges() const {
+    return memory_ranges_;
+  }
+  bool HasException() const { return has_exception_; }
+  const ExceptionInfo& GetException() const { return exception_; }
+
+  const Thread* FindThread(uint32_t thread_id) const;
+  const Module* FindModule(uint64_t address) const;
+
+  // Copies up to size bytes of the target's memory starting at address
+  // into buffer. Stops at the first byte which isn't in the dump and
+  // returns the number of bytes copied.
+  size_t ReadMemory(uint64_t address, void* buffer, size_t size) const;
+
+  // Returns the bytes of a block of the file or nullptr if
+  // the location is outside of the file.
+  const uint8_t* GetData(const Location& location) const;
+
+  // Decodes the integer registers of a CONTEXT (x64, x86 and ARM64).
+  // Returns false for other architectures or a truncated context.
+  bool GetRegisters(const Location& context, Registers& registers) const;
+
+  // The instruction and stack pointers of a context or 0 if
+  // the registers can't be decoded.
+  uint64_t GetInstructionPointer(const Location& context) const;
+  uint64_t GetStackPointer(const Location& context) const;
+
+ private:
+  bool ReadModuleList(const Location& location);
+  bool ReadThreadList(const Location& location);
+  bool ReadMemoryList(const Location& location);
+  bool ReadMemory64List(const Location& location);
+  bool ReadException(const Location& location);
+  bool ReadSystemInfo(const Location& location);
+  std::string ReadString(uint32_t rva) const;
+
+  uint64_t GetRegister(const Location& context, const char* name) const;
+
+  mapped_file::MappedFile file_;
+  uint32_t time_date_stamp_ = 0;
+  SystemInfo system_info_;
+  std::vector<Module> modules_;
+  std::vector<Thread> threads_;
+  std::vector<MemoryRange> memory_ranges_;
+  bool has_exception_ = false;
+  ExceptionInfo exception_;
+};
+
+}  // namespace minidump
+
+#endif  // MINIDUMP_READER_H_
@@ -0,0 +1,654 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "minidump_tools.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <mutex>
+#include <vector>
+
+namespace minidump {
+
+namespace {
+
+// Limits for the minidumpReadMemory and minidumpStack arguments.
+constexpr size_t kDefaultReadMemoryBytes = 256;
+constexpr size_t kMaxReadMemoryBytes = 64 * 1024;
+constexpr size_t kDefaultStackBytes = 1024;
+constexpr size_t kMaxStackBytes = 64 * 1024;
+
+const char* const kToolNames[] = {
+    "openMinidump",          "closeMinidump",      "minidumpModules",
+    "minidumpThreads",       "minidumpThreadContext", "minidumpReadMemory",
+    "minidumpStack"};
+
+// Addresses are returned as strings because JSON numbers
+// can not represent all 64-bit values in most clients.
+std::string FormatAddress(uint64_t address) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "0x%llx",
+           static_cast<unsigned long long>(address));
+  return buffer;
+}
+
+// Parses an address argument. Strings are hex numbers with an optional
+// 0x prefix and ` separator ("00007ff6`12345678") like the debugger
+// shows them and integers are used as is.
+bool ParseAddress(const JSON& value, uint64_t& address) {
+  if (value.is_number_integer() && value.get<int64_t>() >= 0) {
+    address = value.get<uint64_t>();
+    return true;
+  }
+  if (!value.is_string()) {
+    return false;
+  }
+
+  std::string text = value.get<std::string>();
+  text.erase(std::remove(text.begin(), text.end(), '`'), text.end());
+  if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X')) {
+    text = text.substr(2);
+  }
+  if (text.empty() || text.size() > 16 ||
+      text.find_first_not_of("0123456789abcdefABCDEF") != std::string::npos) {
+    return false;
+  }
+
+  address = std::stoull(text, nullptr, 16);
+  return true;
+}
+
+bool ParseSize(const JSON& arguments,
+               const char* name,
+               size_t default_value,
+               size_t max_value,
+               size_t& size,
+               std::string& error) {
+  size = default_value;
+  if (!arguments.contains(name)) {
+    return true;
+  }
+
+  const JSON& value = arguments[name];
+  if (!value.is_number_integer() || value.get<int64_t>() <= 0) {
+    error = std::string(name) + " must be a positive integer";
+    return false;
+  }
+
+  size = std::min<size_t>(value.get<uint64_t>(), max_value);
+  return true;
+}
+
+// "C:\out\chrome.dll" -> "chrome"
+std::string GetModuleShortName(const std::string& path) {
+  size_t start = path.find_last_of("\\/");
+  start = start == std::string::npos ? 0 : start + 1;
+  size_t end = path.find_last_of('.');
+  if (end == std::string::npos || end < start) {
+    end = path.size();
+  }
+  return path.substr(start, end - start);
+}
+
+// Returns "module+0x1234" if address is within a module.
+std::string FormatModuleOffset(const MinidumpReader& reader, uint64_t address) {
+  const Module* module = reader.FindModule(address);
+  if (!module) {
+    return "";
+  }
+  return GetModuleShortName(module->name) + "+" +
+         FormatAddress(address - module->base);
+}
+
+size_t GetPointerSize(const MinidumpReader& reader) {
+  return reader.GetSystemInfo().processor_architecture ==
+                 kProcessorArchitectureIntel
+             ? 4
+             : 8;
+}
+
+std::string ToHex(const uint8_t* bytes, size_t size) {
+  static const char kDigits[] = "0123456789abcdef";
+  std::string result(size * 2, '0');
+  for (size_t i = 0; i < size; i++) {
+    result[i * 2] = kDigits[bytes[i] >> 4];
+    result[i * 2 + 1] = kDigits[bytes[i] & 0xf];
+  }
+  return result;
+}
+
+// Splits memory into pointer sized values. Values which point into a
+// module (e.g. return addresses on a stack) include the module offset.
+JSON FormatPointers(const MinidumpReader& reader,
+                    uint64_t address,
+                    const std::vector<uint8_t>& bytes) {
+  const size_t pointer_size = GetPointerSize(reader);
+
+  JSON values = JSON::array();
+  for (size_t offset = 0; offset + pointer_size <= bytes.size();
+       offset += pointer_size) {
+    uint64_t value = 0;
+    memcpy(&value, bytes.data() + offset, pointer_size);
+
+    JSON entry = {{"address", FormatAddress(address + offset)},
+                  {"value", FormatAddress(value)}};
+    std::string module_offset = FormatModuleOffset(reader, value);
+    if (!module_offset.empty()) {
+      entry["module"] = module_offset;
+    }
+    values.push_back(std::move(entry));
+  }
+  return values;
+}
+
+JSON GetThreadSummary(const MinidumpReader& reader, const Thread& thread) {
+  uint64_t instruction_pointer = reader.GetInstructionPointer(thread.context);
+  JSON summary = {
+      {"threadId", thread.id},
+      {"teb", FormatAddress(thread.teb)},
+      {"stackStart", FormatAddress(thread.stack_start)},
+      {"stackSize", thread.stack.size},
+      {"suspendCount", thread.suspend_count},
+      {"priority", thread.priority},
+      {"instructionPointer", FormatAddress(instruction_pointer)},
+      {"stackPointer",
+       FormatAddress(reader.GetStackPointer(thread.context))}};
+
+  std::string module_offset = FormatModuleOffset(reader, instruction_pointer);
+  if (!module_offset.empty()) {
+    summary["location"] = module_offset;
+  }
+  if (reader.HasException() &&
+      reader.GetException().thread_id == thread.id) {
+    summary["exception"] = true;
+  }
+  return summary;
+}
+
+// Ids are accepted as any non-negative JSON integer since
+// clients don't distinguish signed and unsigned numbers.
+bool GetId(const JSON& arguments, const char* name, uint32_t& id) {
+  if (!arguments.contains(name) || !arguments[name].is_number_integer() ||
+      arguments[name].get<int64_t>() < 0 ||
+      arguments[name].get<int64_t>() > UINT32_MAX) {
+    return false;
+  }
+  id = arguments[name].get<uint32_t>();
+  return true;
+}
+
+}  // namespace
+
+MinidumpTools::MinidumpTools(size_t thread_count) : pool_(thread_count) {}
+
+JSON MinidumpTools::GetToolDefinitions() {
+  JSON dump_id = {{"type", "integer"},
+                  {"description", "The dumpId returned by openMinidump"}};
+  JSON thread_id = {{"type", "integer"},
+                    {"description", "The system id of the thread"}};
+
+  return JSON::array(
+      {{{"name", "openMinidump"},
+        {"description",
+         "Open a minidump file for post-mortem analysis without loading it "
+         "into the debugger. Returns a dumpId for the other minidump tools "
+         "and a summary of the dump including the exception"},
+        {"inputSchema",
+         {{"type", "object"},
+          {"properties",
+           {{"path",
+             {{"type", "string"},
+              {"description", "The path of the .dmp file"}}}}},
+          {"required", JSON::array({"path"})}}}},
+       {{"name", "closeMinidump"},
+        {"description", "Close a minidump opened with openMinidump"},
+        {"inputSchema",
+         {{"type", "object"},
+          {"properties", {{"dumpId", dump_id}}},
+          {"required", JSON::array({"dumpId"})}}}},
+       {{"name", "minidumpModules"},
+        {"description",
+         "List the modules of a minidump with their address ranges, "
+         "timestamps and PDB names"},
+        {"inputSchema",
+         {{"type", "object"},
+          {"properties",
+           {{"dumpId", dump_id},
+            {"filter",
+             {{"type", "string"},
+              {"description",
+               "Only return modules whose name contains this text (case "
+               "insensitive)"}}}}},
+          {"required", JSON::array({"dumpId"})}}}},
+       {{"name", "minidumpThreads"},
+        {"description",
+         "List the threads of a minidump with their instruction and stack "
+         "pointers"},
+        {"inputSchema",
+         {{"type", "object"},
+          {"properties", {{"dumpId", dump_id}}},
+          {"required", JSON::array({"dumpId"})}}}},
+       {{"name", "minidumpThreadContext"},
+        {"description",
+         "Get the integer registers of a thread or of the exception "
+         "context of a minidump"},
+        {"inputSchema",
+         {{"type", "object"},
+          {"properties",
+           {{"dumpId", dump_id},
+            {"threadId", thread_id},
+            {"exception",
+             {{"type", "boolean"},
+              {"description",
+               "Return the context of the exception record instead of a "
+               "thread (default: false)"}}}}},
+          {"required", JSON::array({"dumpId"})}}}},
+       {{"name", "minidumpReadMemory"},
+        {"description", "Read memory which was saved in a minidump"},
+        {"inputSchema",
+         {{"type", "object"},
+          {"properties",
+           {{"dumpId", dump_id},
+            {"address",
+             {{"type", "string"},
+              {"description", "Hex address (e.g. \"0x7ff6`12345678\")"}}},
+            {"size",
+             {{"type", "integer"},
+              {"description",
+               "Number of bytes (default: 256, max: 65536)"}}},
+            {"format",
+             {{"type", "string"},
+              {"enum", JSON::array({"hex", "pointers"})},
+              {"description",
+               "Return the bytes as a hex string or as pointer sized "
+               "values annotated with their module (default: hex)"}}}}},
+          {"required", JSON::array({"dumpId", "address"})}}}},
+       {{"name", "minidumpStack"},
+        {"description",
+         "Read the raw stack of a thread from the stack pointer up as "
+         "pointer sized values. Values which point into a module (likely "
+         "return addresses) are annotated with module+offset"},
+        {"inputSchema",
+         {{"type", "object"},
+          {"properties",
+           {{"dumpId", dump_id},
+            {"threadId", thread_id},
+            {"maxBytes",
+             {{"type", "integer"},
+              {"description",
+               "Maximum number of stack bytes (default: 1024, max: "
+               "65536)"}}}}},
+          {"required", JSON::array({"dumpId", "threadId"})}}}}});
+}
+
+bool MinidumpTools::IsMinidumpTool(const std::string& name) {
+  return std::find(std::begin(kToolNames), std::end(kToolNames), name) !=
+         std::end(kToolNames);
+}
+
+JSON MinidumpTools::CallTool(const std::string& name, const JSON& arguments) {
+  return pool_.Submit([this, name, arguments]() {
+                return RunTool(name, arguments);
+              })
+      .get();
+}
+
+JSON MinidumpTools::RunTool(const std::string& name, const JSON& arguments) {
+  try {
+    if (name == "openMinidump") {
+      return OpenMinidump(arguments);
+    } else if (name == "closeMinidump") {
+      return CloseMinidump(arguments);
+    } else if (name == "minidumpModules") {
+      return ListModules(arguments);
+    } else if (name == "minidumpThreads") {
+      return ListThreads(arguments);
+    } else if (name == "minidumpThreadContext") {
+      return GetThreadContext(arguments);
+    } else if (name == "minidumpReadMemory") {
+      return ReadMemory(arguments);
+    } else if (name == "minidumpStack") {
+      return ReadStack(arguments);
+    }
+  } catch (const std::exception& e) {
+    return JSON{{"error", std::string("Invalid arguments: ") + e.what()}};
+  }
+
+  return JSON{{"error", "Unknown minidump tool: " + name}};
+}
+
+size_t MinidumpTools::GetOpenDumpCount() const {
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  return dumps_.size();
+}
+
+std::shared_ptr<const MinidumpReader> MinidumpTools::GetDump(
+    const JSON& arguments,
+    std::string& error) const {
+  uint32_t dump_id = 0;
+  if (!GetId(arguments, "dumpId", dump_id)) {
+    error = "dumpId must be a non-negative integer";
+    return nullptr;
+  }
+
+  std::shared_lock<std::shared_mutex> lock(mutex_);
+  auto it = dumps_.find(dump_id);
+  if (it == dumps_.end()) {
+    error = "Unknown dumpId: " + std::to_string(dump_id);
+    return nullptr;
+  }
+  return it->second;
+}
+
+JSON MinidumpTools::OpenMinidump(const JSON& arguments) {
+  std::string path = arguments.value("path", "");
+  if (path.empty()) {
+    return JSON{{"error", "No path specified"}};
+  }
+
+  std::error_code ec;
+  std::string key = std::filesystem::absolute(path, ec).string();
+
+  uint32_t dump_id = 0;
+  std::shared_ptr<const MinidumpReader> dump;
+  {
+    std::shared_lock<std::shared_mutex> lock(mutex_);
+    auto it = dump_ids_by_path_.find(key);
+    if (it != dump_ids_by_path_.end()) {
+      dump_id = it->second;
+      dump = dumps_.at(dump_id);
+    }
+  }
+
+  if (!dump) {
+    // The file is parsed without holding the lock
+    // so other dumps can be used in the meantime.
+    auto reader = std::make_shared<MinidumpReader>();
+    std::string error;
+    if (!reader->Open(path, error)) {
+      return JSON{{"error", error}};
+    }
+
+    std::unique_lock<std::shared_mutex> lock(mutex_);
+    auto it = dump_ids_by_path_.find(key);
+    if (it != dump_ids_by_path_.end()) {
+      dump_id = it->second;
+      dump = dumps_.at(dump_id);
+    } else {
+      dump_id = next_dump_id_++;
+      dump = reader;
+      dumps_[dump_id] = reader;
+      dump_ids_by_path_[key] = dump_id;
+    }
+  }
+
+  const SystemInfo& system_info = dump->GetSystemInfo();
+  uint64_t memory_bytes = 0;
+  for (const MemoryRange& range : dump->GetMemoryRanges()) {
+    memory_bytes += range.size;
+  }
+
+  std::string architecture = "unknown";
+  switch (system_info.processor_architecture) {
+    case kProcessorArchitectureAmd64:
+      architecture = "x64";
+      break;
+    case kProcessorArchitectureIntel:
+      architecture = "x86";
+      break;
+    case kProcessorArchitectureArm64:
+      architecture = "arm64";
+      break;
+  }
+
+  JSON output = {
+      {"dumpId", dump_id},
+      {"path", path},
+      {"timeDateStamp", dump->GetTimeDateStamp()},
+      {"architecture", architecture},
+      {"processorCount", system_info.processor_count},
+      {"osVersion", std::to_string(system_info.major_version) + "." +
+                        std::to_string(system_info.minor_version) + "." +
+                        std::to_string(system_info.build_number)},
+      {"moduleCount", dump->GetModules().size()},
+      {"threadCount", dump->GetThreads().size()},
+      {"memoryRangeCount", dump->GetMemoryRanges().size()},
+      {"memoryBytes", memory_bytes}};
+
+  if (dump->HasException()) {
+    const ExceptionInfo& exception = dump->GetException();
+    char code[16];
+    snprintf(code, sizeof(code), "0x%08x", exception.code);
+
+    JSON parameters = JSON::array();
+    for (uint64_t parameter : exception.parameters) {
+      parameters.push_back(FormatAddress(parameter));
+    }
+
+    output["exception"] = {{"threadId", exception.thread_id},
+                           {"code", code},
+                           {"flags", exception.flags},
+                           {"address", FormatAddress(exception.address)},
+                           {"parameters", parameters}};
+    std::string module_offset = FormatModuleOffset(*dump, exception.address);
+    if (!module_offset.empty()) {
+      output["exception"]["location"] = module_offset;
+    }
+  }
+
+  return JSON(output.dump(2));
+}
+
+JSON MinidumpTools::CloseMinidump(const JSON& arguments) {
+  std::string error;
+  if (!GetDump(arguments, error)) {
+    return JSON{{"error", error}};
+  }
+
+  uint32_t dump_id = arguments["dumpId"].get<uint32_t>();
+  std::unique_lock<std::shared_mutex> lock(mutex_);
+  dumps_.erase(dump_id);
+  for (auto it = dump_ids_by_path_.begin(); it != dump_ids_by_path_.end();
+       ++it) {
+    if (it->second == dump_id) {
+      dump_ids_by_path_.erase(it);
+      break;
+    }
+  }
+
+  return JSON("Closed dump " + std::to_string(dump_id));
+}
+
+JSON MinidumpTools::ListModules(const JSON& arguments) const {
+  std::string error;
+  auto dump = GetDump(arguments, error);
+  if (!dump) {
+    return JSON{{"error", error}};
+  }
+
+  auto to_lower = [](std::string value) {
+    std::transform(value.begin(), value.end(), value.begin(),
+                   [](unsigned char c) { return std::tolower(c); });
+    return value;
+  };
+  std::string filter = to_lower(arguments.value("filter", ""));
+
+  JSON modules = JSON::array();
+  for (const Module& module : dump->GetModules()) {
+    if (!filter.empty() &&
+        to_lower(module.name).find(filter) == std::string::npos) {
+      continue;
+    }
+
+    JSON entry = {{"name", GetModuleShortName(module.name)},
+                  {"path", module.name},
+                  {"base", FormatAddress(module.base)},
+                  {"end", FormatAddress(module.base + module.size)},
+                  {"timeDateStamp", module.time_date_stamp},
+                  {"checksum", module.checksum}};
+    if (!module.pdb_name.empty()) {
+      entry["pdb"] = module.pdb_name;
+    }
+    modules.push_back(std::move(entry));
+  }
+
+  return JSON(JSON{{"modules", modules}}.dump(2));
+}
+
+JSON MinidumpTools::ListThreads(const JSON& arguments) const {
+  std::string error;
+  auto dump = GetDump(arguments, error);
+  if (!dump) {
+    return JSON{{"error", error}};
+  }
+
+  JSON threads = JSON::array();
+  for (const Thread& thread : dump->GetThreads()) {
+    threads.push_back(GetThreadSummary(*dump, thread));
+  }
+
+  return JSON(JSON{{"threads", threads}}.dump(2));
+}
+
+JSON MinidumpTools::GetThreadContext(const JSON& arguments) const {
+  std::string error;
+  auto dump = GetDump(arguments, error);
+  if (!dump) {
+    return JSON{{"error", error}};
+  }
+
+  Location context;
+  JSON output;
+  if (arguments.value("exception", false)) {
+    if (!dump->HasException()) {
+      return JSON{{"error", "The dump does not contain an exception"}};
+    }
+    context = dump->GetException().context;
+    output["threadId"] = dump->GetException().thread_id;
+  } else {
+    uint32_t thread_id = 0;
+    if (!GetId(arguments, "threadId", thread_id)) {
+      return JSON{{"error", "threadId is required unless exception is true"}};
+    }
+
+    const Thread* thread = dump->FindThread(thread_id);
+    if (!thread) {
+      return JSON{{"error", "Unknown threadId: " + std::to_string(thread_id)}};
+    }
+    context = thread->context;
+    output["threadId"] = thread_id;
+  }
+
+  Registers registers;
+  if (!dump->GetRegisters(context, registers)) {
+    return JSON{{"error",
+                 "The thread context can not be decoded for this "
+                 "architecture"}};
+  }
+
+  // An array keeps the registers in the order of the r command.
+  JSON values = JSON::array();
+  for (const auto& [name, value] : registers) {
+    values.push_back(JSON::array({name, FormatAddress(value)}));
+  }
+  output["registers"] = values;
+
+  uint64_t instruction_pointer = dump->GetInstructionPointer(context);
+  std::string module_offset = FormatModuleOffset(*dump, instruction_pointer);
+  if (!module_offset.empty()) {
+    output["location"] = module_offset;
+  }
+
+  return JSON(output.dump(2));
+}
+
+JSON MinidumpTools::ReadMemory(const JSON& arguments) const {
+  std::string error;
+  auto dump = GetDump(arguments, error);
+  if (!dump) {
+    return JSON{{"error", error}};
+  }
+
+  uint64_t address = 0;
+  if (!arguments.contains("address") ||
+      !ParseAddress(arguments["address"], address)) {
+    return JSON{{"error", "address must be a hex address"}};
+  }
+
+  size_t size = 0;
+  if (!ParseSize(arguments, "size", kDefaultReadMemoryBytes,
+                 kMaxReadMemoryBytes, size, error)) {
+    return JSON{{"error", error}};
+  }
+
+  std::string format = arguments.value("format", "hex");
+  if (format != "hex" && format != "pointers") {
+    return JSON{{"error", "Unknown format: " + format}};
+  }
+
+  std::vector<uint8_t> bytes(size);
+  bytes.resize(dump->ReadMemory(address, bytes.data(), size));
+  if (bytes.empty()) {
+    return JSON{{"error", "The memory at " + FormatAddress(address) +
+                              " is not in the dump"}};
+  }
+
+  JSON output = {{"address", FormatAddress(address)},
+                 {"bytesRead", bytes.size()}};
+  if (format == "hex") {
+    output["data"] = ToHex(bytes.data(), bytes.size());
+  } else {
+    output["values"] = FormatPointers(*dump, address, bytes);
+  }
+
+  return JSON(output.dump(2));
+}
+
+JSON MinidumpTools::ReadStack(const JSON& arguments) const {
+  std::string error;
+  auto dump = GetDump(arguments, error);
+  if (!dump) {
+    return JSON{{"error", error}};
+  }
+
+  uint32_t thread_id = 0;
+  if (!GetId(arguments, "threadId", thread_id)) {
+    return JSON{{"error", "threadId must be a non-negative integer"}};
+  }
+
+  const Thread* thread = dump->FindThread(thread_id);
+  if (!thread) {
+    return JSON{{"error", "Unknown threadId: " + std::to_string(thread_id)}};
+  }
+
+  size_t max_bytes = 0;
+  if (!ParseSize(arguments, "maxBytes", kDefaultStackBytes, kMaxStackBytes,
+                 max_bytes, error)) {
+    return JSON{{"error", error}};
+  }
+
+  // The stack is read from the stack pointer up to the end of the
+  // stack memory which was saved for the thread.
+  uint64_t stack_pointer = dump->GetStackPointer(thread->context);
+  uint64_t stack_end = thread->stack_start + thread->stack.size;
+  if (stack_pointer < thread->stack_start || stack_pointer >= stack_end) {
+    stack_pointer = thread->stack_start;
+  }
+  size_t size = static_cast<size_t>(
+      std::min<uint64_t>(max_bytes, stack_end - stack_pointer));
+
+  std::vector<uint8_t> bytes(size);
+  bytes.resize(dump->ReadMemory(stack_pointer, bytes.data(), size));
+
+  JSON output = GetThreadSummary(*dump, *thread);
+  output["stackEnd"] = FormatAddress(stack_end);
+  output["bytesRead"] = bytes.size();
+  output["values"] = FormatPointers(*dump, stack_pointer, bytes);
+  return JSON(output.dump(2));
+}
+
+}  // namespace minidump
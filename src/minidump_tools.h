@@ -0,0 +1,70 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef MINIDUMP_TOOLS_H_
+#define MINIDUMP_TOOLS_H_
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <shared_mutex>
+#include <string>
+
+#include "json.hpp"
+#include "minidump_reader.h"
+#include "thread_pool.h"
+
+using JSON = nlohmann::json;
+
+namespace minidump {
+
+// The MCP tools for post-mortem analysis of minidump files. The dumps
+// are parsed directly instead of being loaded into the debugger engine
+// so the tools don't go through the engine command queue and run
+// concurrently on a pool of worker threads. All of the tools except
+// openMinidump and closeMinidump only read from a dump.
+//
+// Like the other MCP tool handlers the tools return either a string
+// with the output or an object with an "error" member.
+class MinidumpTools {
+ public:
+  // 0 uses the number of hardware threads.
+  explicit MinidumpTools(size_t thread_count = 0);
+
+  // The definitions of the tools for the tools/list response.
+  static JSON GetToolDefinitions();
+  static bool IsMinidumpTool(const std::string& name);
+
+  // Runs the tool on the thread pool and waits for the result.
+  JSON CallTool(const std::string& name, const JSON& arguments);
+
+  // Runs the tool on the calling thread.
+  JSON RunTool(const std::string& name, const JSON& arguments);
+
+  size_t GetOpenDumpCount() const;
+
+ private:
+  JSON OpenMinidump(const JSON& arguments);
+  JSON CloseMinidump(const JSON& arguments);
+  JSON ListModules(const JSON& arguments) const;
+  JSON ListThreads(const JSON& arguments) const;
+  JSON GetThreadContext(const JSON& arguments) const;
+  JSON ReadMemory(const JSON& arguments) const;
+  JSON ReadStack(const JSON& arguments) const;
+
+  // Returns the dump selected by the dumpId argument. The dump stays
+  // valid while the pointer is held even if it is closed meanwhile.
+  std::shared_ptr<const MinidumpReader> GetDump(const JSON& arguments,
+                                                std::string& error) const;
+
+  mutable std::shared_mutex mutex_;
+  std::map<uint32_t, std::shared_ptr<const MinidumpReader>> dumps_;
+  std::map<std::string, uint32_t> dump_ids_by_path_;
+  uint32_t next_dump_id_ = 1;
+
+  thread_pool::ThreadPool pool_;
+};
+
+}  // namespace minidump
+
+#endif  // MINIDUMP_TOOLS_H_
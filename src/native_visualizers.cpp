@@ -0,0 +1,280 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+// This extension renders some of the Chromium types from type_signatures.js
+// natively. The JavaScript visualizers are evaluated through the data model
+// for every value that is displayed which makes large containers of these
+// types very slow to display with dx. The native versions resolve the field
+// offsets of each type once per module and then decode the values straight
+// out of bulk memory reads.
+#include <dbgeng.h>
+#include <windows.h>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "debug_event_callbacks.h"
+#include "utils.h"
+#include "visualizer_engine.h"
+
+utils::DebugInterfaces g_debug;
+
+// Strings and other small pieces of memory that are referenced by the
+// visualized values are read through this cache. It is only valid while
+// the event callbacks below are registered.
+utils::MemoryReadCache g_memory_cache(&g_debug);
+
+std::unique_ptr<visualizers::VisualizerEngine> g_visualizer_engine;
+
+class EventCallbacks : public DebugEventCallbacks {
+ public:
+  EventCallbacks()
+      : DebugEventCallbacks(DEBUG_EVENT_CHANGE_ENGINE_STATE |
+                            DEBUG_EVENT_CHANGE_DEBUGGEE_STATE) {}
+
+  STDMETHOD(ChangeEngineState)(ULONG flags, ULONG64 argument) {
+    g_memory_cache.OnChangeEngineState(flags, argument);
+    return S_OK;
+  }
+
+  STDMETHOD(ChangeDebuggeeState)(ULONG flags, ULONG64 argument) {
+    g_memory_cache.OnChangeDebuggeeState(flags, argument);
+    return S_OK;
+  }
+};
+
+static EventCallbacks* g_event_callbacks = nullptr;
+
+// Register the event callbacks which keep the memory cache up to date.
+HRESULT RegisterEventCallbacks() {
+  if (g_event_callbacks) {
+    return S_OK;
+  }
+
+  // Anything cached before the callbacks were registered may be stale.
+  g_memory_cache.Invalidate();
+
+  g_event_callbacks = new EventCallbacks();
+  HRESULT hr = g_debug.client->SetEventCallbacks(g_event_callbacks);
+  if (FAILED(hr)) {
+    g_event_callbacks->Release();
+    g_event_callbacks = nullptr;
+    DERROR("Failed to set event callbacks: 0x%08X\n", hr);
+  }
+  return hr;
+}
+
+// Evaluate a MASM expression (e.g. "@rcx", "0x1234" or "@@c++(&foo)")
+// and return the resulting address.
+bool EvaluateAddress(const std::string& expression, ULONG64& address) {
+  DEBUG_VALUE value = {};
+  HRESULT hr = g_debug.control->Evaluate(expression.c_str(), DEBUG_VALUE_INT64,
+                                         &value, nullptr);
+  if (FAILED(hr)) {
+    DERROR("Error: Unable to evaluate expression: %s\n", expression.c_str());
+    return false;
+  }
+
+  address = value.I64;
+  return true;
+}
+
+void OutputSupportedTypes() {
+  DOUT("Supported types:\n");
+  for (const auto& visualizer : visualizers::GetBuiltInVisualizers()) {
+    DOUT("  %s\n", visualizer.type_name.c_str());
+  }
+  DOUT("\n");
+}
+
+HRESULT CALLBACK VisualizeInternal(IDebugClient* client, const char* args) {
+  if (!args || !*args || (args[0] == '?' && args[1] == '\0')) {
+    DOUT(
+        "Visualize - Display a value using a native visualizer.\n\n"
+        "Usage: !Visualize <type> <address>\n\n"
+        "  <type>     - Type name with an optional module prefix\n"
+        "  <address>  - Address expression of the value\n\n"
+        "Examples:\n"
+        "  !Visualize media::CdmConfig @rcx\n"
+        "  !Visualize chrome!base::FilePath 0x000000a1`2345f7c0\n"
+        "  !Visualize content::CdmInfo '@@c++(&cdm_info)'\n\n");
+    OutputSupportedTypes();
+    return S_OK;
+  }
+
+  HRESULT hr = RegisterEventCallbacks();
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  std::vector<std::string> parsed_args = utils::ParseCommandLine(args);
+  if (parsed_args.size() != 2) {
+    DERROR("Error: Expected 2 arguments. Use !Visualize ? for help.\n");
+    return E_INVALIDARG;
+  }
+
+  ULONG64 address = 0;
+  if (!EvaluateAddress(parsed_args[1], address)) {
+    return E_INVALIDARG;
+  }
+
+  std::string output;
+  std::string error;
+  if (!g_visualizer_engine->RenderValue(parsed_args[0], address, output,
+                                        error)) {
+    DERROR("Error: %s\n", error.c_str());
+    return E_FAIL;
+  }
+
+  DOUT("%s\n", output.c_str());
+  return S_OK;
+}
+
+HRESULT CALLBACK VisualizeVectorInternal(IDebugClient* client,
+                                         const char* args) {
+  if (!args || !*args || (args[0] == '?' && args[1] == '\0')) {
+    DOUT(
+        "VisualizeVector - Display the elements of a std::vector using a native visualizer.\n\n"
+        "Usage: !VisualizeVector <element_type> <vector_address> [max_count]\n\n"
+        "  <element_type>    - Element type name with an optional module prefix\n"
+        "  <vector_address>  - Address expression of the std::vector\n"
+        "  [max_count]       - Maximum number of elements to display (default: 100, 0 for all)\n\n"
+        "Examples:\n"
+        "  !VisualizeVector media::CdmConfig '@@c++(&configs_)'\n"
+        "  !VisualizeVector content::CdmInfo 0x000000a1`2345f7c0 0\n\n");
+    OutputSupportedTypes();
+    return S_OK;
+  }
+
+  HRESULT hr = RegisterEventCallbacks();
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  std::vector<std::string> parsed_args = utils::ParseCommandLine(args);
+  if (parsed_args.size() < 2 || parsed_args.size() > 3) {
+    DERROR(
+        "Error: Expected 2 or 3 arguments. Use !VisualizeVector ? for help.\n");
+    return E_INVALIDARG;
+  }
+
+  ULONG64 vector_address = 0;
+  if (!EvaluateAddress(parsed_args[1], vector_address)) {
+    return E_INVALIDARG;
+  }
+
+  size_t max_count = 100;
+  if (parsed_args.size() == 3) {
+    bool valid = utils::IsWholeNumber(parsed_args[2]);
+    try {
+      if (valid) {
+        max_count = std::stoul(parsed_args[2]);
+      }
+    } catch (const std::exception&) {
+      valid = false;
+    }
+    if (!valid) {
+      DERROR("Error: max_count must be a whole number.\n");
+      return E_INVALIDARG;
+    }
+  }
+
+  std::vector<std::string> elements;
+  size_t total_count = 0;
+  std::string error;
+  if (!g_visualizer_engine->RenderVector(parsed_args[0], vector_address,
+                                         max_count, elements, total_count,
+                                         error)) {
+    DERROR("Error: %s\n", error.c_str());
+    return E_FAIL;
+  }
+
+  DOUT("{ size=%u }\n", static_cast<ULONG>(total_count));
+  for (size_t i = 0; i < elements.size(); i++) {
+    DOUT("    [%u] %s\n", static_cast<ULONG>(i), elements[i].c_str());
+  }
+
+  if (elements.size() < total_count) {
+    DOUT("    ... and %u more\n",
+         static_cast<ULONG>(total_count - elements.size()));
+  }
+  return S_OK;
+}
+
+HRESULT CALLBACK ClearVisualizerCacheInternal(IDebugClient* client,
+                                              const char* args) {
+  if (args && args[0] == '?' && args[1] == '\0') {
+    DOUT(
+        "ClearVisualizerCache - Clear the cached type layouts used by the native visualizers.\n\n"
+        "Usage: !ClearVisualizerCache\n\n"
+        "Type layouts are resolved once per module and type. Run this command\n"
+        "after reloading symbols so that the layouts are resolved again.\n"
+        "The memory read cache statistics are displayed before clearing.\n\n");
+    return S_OK;
+  }
+
+  const utils::MemoryReadCache::Statistics& stats =
+      g_memory_cache.GetStatistics();
+  DOUT("Memory cache: %u page hits, %u page misses, %u target reads\n",
+       static_cast<ULONG>(stats.hits), static_cast<ULONG>(stats.misses),
+       static_cast<ULONG>(stats.target_reads));
+
+  size_t count = g_visualizer_engine->GetCachedLayoutCount();
+  g_visualizer_engine->ClearCache();
+  g_memory_cache.Invalidate();
+  g_memory_cache.ResetStatistics();
+  DOUT("Cleared %u cached type layout(s).\n", static_cast<ULONG>(count));
+  return S_OK;
+}
+
+HRESULT CALLBACK DebugExtensionInitializeInternal(PULONG version,
+                                                  PULONG flags) {
+  *version = DEBUG_EXTENSION_VERSION(1, 0);
+  *flags = 0;
+
+  HRESULT hr = utils::InitializeDebugInterfaces(&g_debug);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  g_visualizer_engine = std::make_unique<visualizers::VisualizerEngine>(
+      &g_debug, &g_memory_cache);
+  return S_OK;
+}
+
+HRESULT CALLBACK DebugExtensionUninitializeInternal() {
+  if (g_event_callbacks) {
+    g_debug.client->SetEventCallbacks(nullptr);
+    g_event_callbacks->Release();
+    g_event_callbacks = nullptr;
+  }
+
+  g_visualizer_engine.reset();
+  return utils::UninitializeDebugInterfaces(&g_debug);
+}
+
+extern "C" {
+__declspec(dllexport) HRESULT CALLBACK DebugExtensionInitialize(PULONG version,
+                                                                PULONG flags) {
+  return DebugExtensionInitializeInternal(version, flags);
+}
+
+__declspec(dllexport) HRESULT CALLBACK DebugExtensionUninitialize(void) {
+  return DebugExtensionUninitializeInternal();
+}
+
+__declspec(dllexport) HRESULT CALLBACK Visualize(IDebugClient* client,
+                                                 const char* args) {
+  return VisualizeInternal(client, args);
+}
+
+__declspec(dllexport) HRESULT CALLBACK VisualizeVector(IDebugClient* client,
+                                                       const char* args) {
+  return VisualizeVectorInternal(client, args);
+}
+
+__declspec(dllexport) HRESULT CALLBACK
+ClearVisualizerCache(IDebugClient* client, const char* args) {
+  return ClearVisualizerCacheInternal(client, args);
+}
+}
@@ -0,0 +1,362 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "output_compactor.h"
+
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <regex>
+#include <sstream>
+
+namespace output_compactor {
+
+namespace {
+
+const size_t kMinRepeatRun = 3;
+const size_t kMinModuleLoadRun = 3;
+const size_t kMinZeroRowRun = 3;
+
+bool StartsWith(const std::string& line, const std::string& prefix) {
+  return line.compare(0, prefix.size(), prefix) == 0;
+}
+
+std::string TrimLeft(const std::string& line) {
+  size_t start = line.find_first_not_of(" \t");
+  return start == std::string::npos ? "" : line.substr(start);
+}
+
+bool IsModuleLoadLine(const std::string& line) {
+  return StartsWith(TrimLeft(line), "ModLoad:");
+}
+
+// "ModLoad: 00007ffe`c7d00000 00007ffe`c7d99000   C:\Windows\System32\ntdll.dll"
+// is summarized as "ntdll.dll 00007ffe`c7d00000-00007ffe`c7d99000".
+std::string GetModuleSummary(const std::string& line) {
+  std::istringstream stream(TrimLeft(line).substr(sizeof("ModLoad:") - 1));
+  std::string base;
+  std::string end;
+  std::string path;
+  stream >> base >> end >> std::ws;
+  std::getline(stream, path);
+  while (!path.empty() && (path.back() == ' ' || path.back() == '\r')) {
+    path.pop_back();
+  }
+
+  size_t separator = path.find_last_of("\\/");
+  std::string name =
+      separator == std::string::npos ? path : path.substr(separator + 1);
+  return name + " " + base + "-" + end;
+}
+
+// Returns true for memory dump rows where all of the values are zero.
+//
+//    00000031`0b1f8000  00 00 00 00 00 00 00 00-00 00 00 00 00 00 00 00  ................
+//    00000031`0b1f8000  00000000 00000000 00000000 00000000
+//    00000031`0b1f8000  00000000`00000000 00000000`00000000
+//
+bool IsZeroRow(const std::string& line) {
+  // The address is checked by hand rather than with std::regex, which
+  // recurses for each character of the line and overflows the stack
+  // on the very long lines of large dumps.
+  auto is_hex = [&line](size_t start, size_t count) {
+    return start + count <= line.size() &&
+           std::all_of(line.begin() + start, line.begin() + start + count,
+                       [](char c) { return std::isxdigit(
+                                        static_cast<unsigned char>(c)); });
+  };
+  if (!is_hex(0, 8)) {
+    return false;
+  }
+  size_t values_start = 8;
+  if (values_start < line.size() && line[values_start] == '`') {
+    if (!is_hex(values_start + 1, 8)) {
+      return false;
+    }
+    values_start += 9;
+  }
+  if (line.compare(values_start, 2, "  ") != 0) {
+    return false;
+  }
+
+  // The values are followed by the optional character columns
+  // which are not hex digits.
+  size_t value_count = 0;
+  size_t pos = values_start + 2;
+  while (true) {
+    size_t start = line.find_first_not_of(" \t\r", pos);
+    if (start == std::string::npos) {
+      break;
+    }
+    size_t end = line.find_first_of(" \t\r", start);
+    if (end == std::string::npos) {
+      end = line.size();
+    }
+    bool is_value = std::all_of(
+        line.begin() + start, line.begin() + end, [](char c) {
+          return std::isxdigit(static_cast<unsigned char>(c)) || c == '-' ||
+                 c == '`';
+        });
+    if (!is_value) {
+      break;
+    }
+    if (std::any_of(line.begin() + start, line.begin() + end,
+                    [](char c) { return c != '0' && c != '-' && c != '`'; })) {
+      return false;
+    }
+    value_count++;
+    pos = end;
+  }
+  return value_count > 0;
+}
+
+std::string GetRowAddress(const std::string& line) {
+  return line.substr(0, line.find(' '));
+}
+
+struct ThreadBlock {
+  std::string thread;  // e.g. "4 (3c4.1f4)"
+  Lines lines;
+  // The call site columns of the frames. Empty if the
+  // block does not contain a stack.
+  Lines call_sites;
+};
+
+size_t GetLinesSize(const Lines& lines) {
+  size_t size = 0;
+  for (const std::string& line : lines) {
+    size += line.size() + 1;
+  }
+  return size;
+}
+
+}  // namespace
+
+Lines FoldRepeatedLines(const Lines& lines) {
+  Lines result;
+  size_t i = 0;
+  while (i < lines.size()) {
+    size_t end = i + 1;
+    while (end < lines.size() && lines[end] == lines[i]) {
+      end++;
+    }
+
+    size_t run = end - i;
+    if (run >= kMinRepeatRun && !TrimLeft(lines[i]).empty()) {
+      result.push_back(lines[i]);
+      result.push_back("  (previous line repeated " + std::to_string(run - 1) +
+                       " more times)");
+    } else {
+      result.insert(result.end(), lines.begin() + i, lines.begin() + end);
+    }
+    i = end;
+  }
+  return result;
+}
+
+Lines FoldModuleLoads(const Lines& lines) {
+  Lines result;
+  size_t i = 0;
+  while (i < lines.size()) {
+    if (!IsModuleLoadLine(lines[i])) {
+      result.push_back(lines[i++]);
+      continue;
+    }
+
+    size_t end = i;
+    while (end < lines.size() && IsModuleLoadLine(lines[end])) {
+      end++;
+    }
+
+    if (end - i >= kMinModuleLoadRun) {
+      std::string folded =
+          "ModLoad: " + std::to_string(end - i) + " modules: ";
+      for (size_t j = i; j < end; j++) {
+        folded += (j == i ? "" : ", ") + GetModuleSummary(lines[j]);
+      }
+      result.push_back(folded);
+    } else {
+      result.insert(result.end(), lines.begin() + i, lines.begin() + end);
+    }
+    i = end;
+  }
+  return result;
+}
+
+Lines GroupThreadStacks(const Lines& lines) {
+  // ".  0  Id: 3c4.2a8 Suspend: 1 Teb: 00000031`0b1f8000 Unfrozen"
+  // "#" marks the thread of the last event and "." the current thread.
+  static const std::regex thread_regex(
+      R"(^[ .#]\s*(\d+)\s+Id:\s*([0-9a-fA-F]+\.[0-9a-fA-F]+)\s)",
+      std::regex::optimize);
+  static const std::regex frame_regex(R"(^[0-9a-fA-F]{2,}\s)",
+                                      std::regex::optimize);
+
+  Lines result;
+  std::vector<ThreadBlock> blocks;
+  size_t call_site_column = std::string::npos;
+
+  for (const std::string& line : lines) {
+    std::smatch match;
+    if (std::regex_search(line, match, thread_regex)) {
+      ThreadBlock block;
+      block.thread = match[1].str() + " (" + match[2].str() + ")";
+      block.lines.push_back(line);
+      blocks.push_back(std::move(block));
+      call_site_column = std::string::npos;
+      continue;
+    }
+
+    if (blocks.empty()) {
+      result.push_back(line);
+      continue;
+    }
+
+    ThreadBlock& block = blocks.back();
+    block.lines.push_back(line);
+
+    size_t column = line.find("Call Site");
+    if (StartsWith(TrimLeft(line), "# ") && column != std::string::npos) {
+      call_site_column = column;
+    } else if (call_site_column != std::string::npos &&
+               std::regex_search(line, frame_regex)) {
+      block.call_sites.push_back(call_site_column < line.size()
+                                     ? line.substr(call_site_column)
+                                     : "");
+    }
+  }
+
+  if (blocks.size() < 2) {
+    return lines;
+  }
+
+  // Group the blocks by their call sites in the order of first use.
+  std::map<Lines, size_t> first_block;
+  std::vector<std::vector<size_t>> duplicates(blocks.size());
+  std::vector<bool> is_duplicate(blocks.size(), false);
+  for (size_t i = 0; i < blocks.size(); i++) {
+    if (blocks[i].call_sites.empty()) {
+      continue;
+    }
+    auto it = first_block.emplace(blocks[i].call_sites, i).first;
+    if (it->second != i) {
+      duplicates[it->second].push_back(i);
+      is_duplicate[i] = true;
+    }
+  }
+
+  for (size_t i = 0; i < blocks.size(); i++) {
+    if (is_duplicate[i]) {
+      continue;
+    }
+
+    Lines& block_lines = blocks[i].lines;
+    if (duplicates[i].empty()) {
+      result.insert(result.end(), block_lines.begin(), block_lines.end());
+      continue;
+    }
+
+    // Insert the group line before the trailing empty lines.
+    size_t end = block_lines.size();
+    while (end > 1 && TrimLeft(block_lines[end - 1]).empty()) {
+      end--;
+    }
+    result.insert(result.end(), block_lines.begin(), block_lines.begin() + end);
+
+    std::string group = "  (same call stack in " +
+                        std::to_string(duplicates[i].size()) + " other thread" +
+                        (duplicates[i].size() == 1 ? "" : "s") + ": ";
+    for (size_t j = 0; j < duplicates[i].size(); j++) {
+      group += (j == 0 ? "" : ", ") + blocks[duplicates[i][j]].thread;
+    }
+    result.push_back(group + ")");
+    result.insert(result.end(), block_lines.begin() + end, block_lines.end());
+  }
+  return result;
+}
+
+Lines CollapseZeroRows(const Lines& lines) {
+  Lines result;
+  size_t i = 0;
+  while (i < lines.size()) {
+    if (!IsZeroRow(lines[i])) {
+      result.push_back(lines[i++]);
+      continue;
+    }
+
+    size_t end = i;
+    while (end < lines.size() && IsZeroRow(lines[end])) {
+      end++;
+    }
+
+    size_t run = end - i;
+    if (run >= kMinZeroRowRun) {
+      std::string padding(GetRowAddress(lines[i]).size() + 2, ' ');
+      result.push_back(lines[i]);
+      result.push_back(padding + "... " + std::to_string(run - 2) +
+                       " more zero row" + (run == 3 ? "" : "s") + " ...");
+      result.push_back(lines[end - 1]);
+    } else {
+      result.insert(result.end(), lines.begin() + i, lines.begin() + end);
+    }
+    i = end;
+  }
+  return result;
+}
+
+void Compactor::AddPass(const std::string& name, Pass pass) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  passes_.push_back(std::move(pass));
+  PassStats pass_stats;
+  pass_stats.name = name;
+  stats_.passes.push_back(pass_stats);
+}
+
+void Compactor::AddDefaultPasses() {
+  AddPass("module_loads", FoldModuleLoads);
+  AddPass("repeated_lines", FoldRepeatedLines);
+  AddPass("zero_rows", CollapseZeroRows);
+  AddPass("thread_stacks", GroupThreadStacks);
+}
+
+std::string Compactor::Compact(const std::string& output) {
+  Lines lines;
+  std::istringstream stream(output);
+  std::string line;
+  while (std::getline(stream, line)) {
+    lines.push_back(line);
+  }
+
+  std::lock_guard<std::mutex> lock(mutex_);
+  size_t size = GetLinesSize(lines);
+  for (size_t i = 0; i < passes_.size(); i++) {
+    lines = passes_[i](lines);
+
+    size_t new_size = GetLinesSize(lines);
+    if (new_size < size) {
+      stats_.passes[i].applied_count++;
+      stats_.passes[i].bytes_removed += size - new_size;
+    }
+    size = new_size;
+  }
+
+  std::string result;
+  for (size_t i = 0; i < lines.size(); i++) {
+    result += (i == 0 ? "" : "\n") + lines[i];
+  }
+  if (!output.empty() && output.back() == '\n') {
+    result += "\n";
+  }
+
+  stats_.outputs++;
+  stats_.input_bytes += output.size();
+  stats_.output_bytes += result.size();
+  return result;
+}
+
+CompactionStats Compactor::GetStats() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stats_;
+}
+
+}  // namespace output_compactor
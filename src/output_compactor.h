@@ -0,0 +1,89 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef OUTPUT_COMPACTOR_H_
+#define OUTPUT_COMPACTOR_H_
+
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace output_compactor {
+
+using Lines = std::vector<std::string>;
+
+// A compaction pass rewrites the lines of a command output. Passes must
+// leave lines which they don't recognize unchanged.
+using Pass = std::function<Lines(const Lines& lines)>;
+
+// Folds runs of 3 or more identical non-empty lines into the first line
+// followed by "  (previous line repeated N more times)".
+Lines FoldRepeatedLines(const Lines& lines);
+
+// Folds runs of 3 or more "ModLoad:" lines into a single line which
+// lists the file name and address range of each module. Only the
+// directories of the modules are dropped:
+//
+//    ModLoad: 37 modules: ntdll.dll 00007ffe`c7d00000-00007ffe`c7f68000,
+//    KERNEL32.DLL 00007ffe`c6a10000-00007ffe`c6ad9000, ...
+//
+Lines FoldModuleLoads(const Lines& lines);
+
+// Groups the threads of "~*k" style output which have the same call
+// sites. The first thread of a group is output in full followed by the
+// other threads of the group:
+//
+//    .  0  Id: 3c4.2a8 Suspend: 1 Teb: 00000031`0b1f8000 Unfrozen
+//     # Child-SP          RetAddr               Call Site
+//    00 00000031`0b3ff5c8 00007ffe`c7d0e123     ntdll!NtWaitForSingleObject+0x14
+//    ...
+//      (same call stack in 3 other threads: 4 (3c4.1f4), 7 (3c4.2b0), ...)
+//
+// The stack pointers and return addresses of the other threads are not
+// compared and are dropped.
+Lines GroupThreadStacks(const Lines& lines);
+
+// Collapses runs of 3 or more zero filled rows of memory dumps (db, dw,
+// dd, dq, dc, ...) into the first row, a line with the number of
+// omitted rows and the last row.
+Lines CollapseZeroRows(const Lines& lines);
+
+struct PassStats {
+  std::string name;
+  // The number of outputs which the pass made smaller.
+  uint64_t applied_count = 0;
+  uint64_t bytes_removed = 0;
+};
+
+struct CompactionStats {
+  uint64_t outputs = 0;
+  uint64_t input_bytes = 0;
+  uint64_t output_bytes = 0;
+  std::vector<PassStats> passes;
+};
+
+// Runs the command output through a pipeline of passes. Each pass
+// sees the output of the previous pass.
+class Compactor {
+ public:
+  void AddPass(const std::string& name, Pass pass);
+
+  // Adds the passes above in the order module loads, repeated lines,
+  // zero rows and thread stacks.
+  void AddDefaultPasses();
+
+  std::string Compact(const std::string& output);
+
+  CompactionStats GetStats() const;
+
+ private:
+  std::vector<Pass> passes_;
+  CompactionStats stats_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace output_compactor
+
+#endif  // OUTPUT_COMPACTOR_H_
@@ -0,0 +1,186 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+// A sampling profiler for finding out where a busy or hung process is
+// spending its time. The target is repeatedly resumed for a short
+// interval and broken into again. The stacks of all of the threads are
+// captured at every break and aggregated into a call tree which can be
+// written out as folded stacks or flame graph JSON.
+#include <dbgeng.h>
+#include <windows.h>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "stack_sampler.h"
+#include "utils.h"
+
+utils::DebugInterfaces g_debug;
+
+namespace {
+
+// The number of functions displayed in the summary.
+constexpr size_t kTopFunctionCount = 15;
+
+bool ParseNumberArgument(const std::vector<std::string>& args,
+                         size_t& index,
+                         const char* name,
+                         ULONG& value) {
+  uint32_t number = 0;
+  if (index + 1 >= args.size() || !utils::ParseUInt32(args[index + 1], number)) {
+    DERROR("Error: %s requires a number of at most %u.\n", name, UINT32_MAX);
+    return false;
+  }
+  index++;
+  value = number;
+  return true;
+}
+
+}  // namespace
+
+HRESULT CALLBACK SampleStacksInternal(IDebugClient* client, const char* args) {
+  if (args && args[0] == '?' && args[1] == '\0') {
+    DOUT(
+        "SampleStacks - Sample the stacks of all threads while the target runs.\n\n"
+        "Usage: !SampleStacks [/i <ms>] [/d <ms>] [/t <threads>] [/n <depth>] [/g] [/j] [file]\n\n"
+        "  /i <ms>       - Time the target runs between samples (default: 10)\n"
+        "  /d <ms>       - Total time to sample for (default: 1000)\n"
+        "  /t <threads>  - Only sample these threads, e.g. \"0 3-5\" (default: all)\n"
+        "  /n <depth>    - Maximum stack depth (default: 64)\n"
+        "  /g            - Group the stacks by thread\n"
+        "  /j            - Write flame graph JSON instead of folded stacks\n"
+        "  [file]        - Write the aggregated stacks to this file\n\n"
+        "The target is resumed and broken into again for every sample, so\n"
+        "sampling stops early if a breakpoint or other event is hit. Press\n"
+        "Ctrl+Break to stop sampling. The folded stacks can be opened with\n"
+        "flamegraph.pl or https://www.speedscope.app.\n\n"
+        "Examples:\n"
+        "  !SampleStacks\n"
+        "  !SampleStacks /d 5000 c:\\temp\\chrome.folded\n"
+        "  !SampleStacks /i 5 /t \"0 12\" /g /j c:\\temp\\chrome.json\n\n");
+    return S_OK;
+  }
+
+  std::vector<std::string> parsed_args = utils::ParseCommandLine(args);
+
+  stack_sampler::SamplerOptions options;
+  bool write_json = false;
+  std::string file_path;
+
+  for (size_t i = 0; i < parsed_args.size(); i++) {
+    const std::string& arg = parsed_args[i];
+    if (arg == "/i") {
+      if (!ParseNumberArgument(parsed_args, i, "/i", options.interval_ms)) {
+        return E_INVALIDARG;
+      }
+    } else if (arg == "/d") {
+      if (!ParseNumberArgument(parsed_args, i, "/d", options.duration_ms)) {
+        return E_INVALIDARG;
+      }
+    } else if (arg == "/n") {
+      if (!ParseNumberArgument(parsed_args, i, "/n", options.max_depth)) {
+        return E_INVALIDARG;
+      }
+    } else if (arg == "/t") {
+      if (i + 1 >= parsed_args.size()) {
+        DERROR("Error: /t requires a list of threads.\n");
+        return E_INVALIDARG;
+      }
+      std::string threads = parsed_args[++i];
+      std::replace(threads.begin(), threads.end(), ',', ' ');
+      for (size_t id : utils::GetIndicesFromString(threads)) {
+        options.thread_ids.insert(static_cast<ULONG>(id));
+      }
+      if (options.thread_ids.empty()) {
+        DERROR("Error: Invalid thread list: %s\n", parsed_args[i].c_str());
+        return E_INVALIDARG;
+      }
+    } else if (arg == "/g") {
+      options.group_by_thread = true;
+    } else if (arg == "/j") {
+      write_json = true;
+    } else if (file_path.empty() && !arg.empty() && arg[0] != '/') {
+      file_path = arg;
+    } else {
+      DERROR("Error: Unexpected argument: %s. Use !SampleStacks ? for help.\n",
+             arg.c_str());
+      return E_INVALIDARG;
+    }
+  }
+
+  DOUT("Sampling every %u ms for %u ms...\n", options.interval_ms,
+       options.duration_ms);
+
+  stack_sampler::StackSampler sampler(&g_debug);
+  stack_sampler::SamplerResult result = sampler.Run(
+      options, [] { return g_debug.control->GetInterrupt() == S_OK; });
+  if (!result.success) {
+    DERROR("Error: %s\n", result.error.c_str());
+    return E_FAIL;
+  }
+
+  if (!result.stop_reason.empty()) {
+    DOUT("Sampling stopped early: %s\n", result.stop_reason.c_str());
+  }
+
+  DOUT("Collected %u samples (%u stacks) in %u ms\n", result.samples,
+       static_cast<ULONG>(result.stacks), static_cast<ULONG>(result.elapsed_ms));
+  if (result.stacks == 0) {
+    return S_OK;
+  }
+
+  std::vector<stack_sampler::LabeledTree> trees = result.GetLabeledTrees();
+  stack_sampler::Symbolizer symbolizer =
+      stack_sampler::CreateEngineSymbolizer(&g_debug);
+
+  DOUT("\nTop functions (samples where the function was executing):\n");
+  for (const auto& [name, count] :
+       stack_sampler::GetTopFunctions(trees, symbolizer, kTopFunctionCount)) {
+    DOUT("  %6u  %5.1f%%  %s\n", static_cast<ULONG>(count),
+         100.0 * count / result.stacks, name.c_str());
+  }
+
+  if (!file_path.empty()) {
+    std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+    if (!file) {
+      DERROR("Error: Unable to open file: %s\n", file_path.c_str());
+      return E_FAIL;
+    }
+
+    file << (write_json
+                 ? stack_sampler::FormatFlameGraphJson(trees, symbolizer)
+                 : stack_sampler::FormatFoldedStacks(trees, symbolizer));
+    DOUT("\nWrote %s to %s\n", write_json ? "flame graph JSON" : "folded stacks",
+         file_path.c_str());
+  }
+
+  return S_OK;
+}
+
+HRESULT CALLBACK DebugExtensionInitializeInternal(PULONG version,
+                                                  PULONG flags) {
+  *version = DEBUG_EXTENSION_VERSION(1, 0);
+  *flags = 0;
+  return utils::InitializeDebugInterfaces(&g_debug);
+}
+
+HRESULT CALLBACK DebugExtensionUninitializeInternal() {
+  return utils::UninitializeDebugInterfaces(&g_debug);
+}
+
+extern "C" {
+__declspec(dllexport) HRESULT CALLBACK DebugExtensionInitialize(PULONG version,
+                                                                PULONG flags) {
+  return DebugExtensionInitializeInternal(version, flags);
+}
+
+__declspec(dllexport) HRESULT CALLBACK DebugExtensionUninitialize(void) {
+  return DebugExtensionUninitializeInternal();
+}
+
+__declspec(dllexport) HRESULT CALLBACK SampleStacks(IDebugClient* client,
+                                                    const char* args) {
+  return SampleStacksInternal(client, args);
+}
+}
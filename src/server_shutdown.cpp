@@ -0,0 +1,69 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "server_shutdown.h"
+
+#include <algorithm>
+
+#include "mcp_protocol.h"
+#include "trace.h"
+
+namespace server_shutdown {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+std::chrono::milliseconds GetRemaining(Clock::time_point deadline) {
+  return std::max(std::chrono::duration_cast<std::chrono::milliseconds>(
+                      deadline - Clock::now()),
+                  std::chrono::milliseconds(0));
+}
+
+// Waits for the requests in progress first since they wait for the
+// operations which they queued. Posted operations have no request.
+bool WaitForIdle(mcp_transport::SocketServer& transport,
+                 command_queue::CommandQueue& queue,
+                 std::chrono::milliseconds timeout) {
+  Clock::time_point deadline = Clock::now() + timeout;
+  return transport.WaitForRequests(timeout) &&
+         queue.WaitForIdle(GetRemaining(deadline));
+}
+
+}  // namespace
+
+Result Shutdown(mcp_transport::SocketServer& transport,
+                command_queue::CommandQueue& queue,
+                const Options& options) {
+  TRACE_SPAN("Server shutdown");
+  Result result;
+
+  transport.StopAccepting();
+  queue.StartDrain(kShutdownMessage);
+  transport.Broadcast(mcp_protocol::CreateNotification(
+                          "notifications/message",
+                          {{"level", "warning"}, {"data", kShutdownMessage}})
+                          .dump() +
+                      "\n");
+
+  result.drained = WaitForIdle(transport, queue, options.drain_timeout);
+  if (!result.drained) {
+    // The waiting requests get their error response right away.
+    result.cancelled = queue.CancelQueued(kShutdownMessage);
+
+    if (options.interrupt && !queue.WaitForIdle(std::chrono::milliseconds(0))) {
+      options.interrupt();
+      result.interrupted = true;
+    }
+    WaitForIdle(transport, queue, options.interrupt_timeout);
+  }
+
+  // The queue thread gets its own time to exit. Even when it is idle
+  // it has to be woken and scheduled before it can be joined.
+  bool queue_stopped = queue.Stop(options.close_timeout);
+  bool transport_stopped = transport.Stop(options.close_timeout);
+  result.completed = queue_stopped && transport_stopped;
+  return result;
+}
+
+}  // namespace server_shutdown
@@ -0,0 +1,54 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef SERVER_SHUTDOWN_H_
+#define SERVER_SHUTDOWN_H_
+
+#include <chrono>
+#include <cstddef>
+#include <functional>
+
+#include "command_queue.h"
+#include "mcp_transport.h"
+
+// Stops the MCP server in bounded time. New connections and new
+// engine operations are refused and the clients are sent a
+// notifications/message. The requests in progress get drain_timeout
+// to finish. After that the queued operations fail with an error and
+// interrupt is called to break out of the running one (e.g. a "g"
+// which doesn't return), which gets interrupt_timeout. Then the
+// command queue thread is stopped and the connections are closed,
+// each within close_timeout. If the engine ignores the interrupt the
+// threads are left running and completed is false, in which case the
+// queue and the transport must not be destroyed.
+namespace server_shutdown {
+
+// Sent to the clients and used as the error of the operations which
+// are refused or cancelled.
+constexpr const char* kShutdownMessage = "The server is shutting down";
+
+struct Options {
+  std::chrono::milliseconds drain_timeout{2000};
+  std::chrono::milliseconds interrupt_timeout{2000};
+  std::chrono::milliseconds close_timeout{1000};
+  // Breaks into the engine. Optional.
+  std::function<void()> interrupt;
+};
+
+struct Result {
+  // The requests finished before drain_timeout.
+  bool drained = false;
+  bool interrupted = false;
+  // The number of queued operations which were failed.
+  size_t cancelled = 0;
+  // The command queue thread and the client threads finished.
+  bool completed = false;
+};
+
+Result Shutdown(mcp_transport::SocketServer& transport,
+                command_queue::CommandQueue& queue,
+                const Options& options);
+
+}  // namespace server_shutdown
+
+#endif  // SERVER_SHUTDOWN_H_
@@ -0,0 +1,487 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "source_search.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <charconv>
+#include <climits>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <filesystem>
+#include <mutex>
+#include <regex>
+#include <set>
+#include <thread>
+
+#include "mapped_file.h"
+#include "memory_search.h"
+
+namespace source_search {
+
+namespace {
+
+std::string ToLower(std::string value) {
+  std::transform(value.begin(), value.end(), value.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  return value;
+}
+
+// Returns the index just past the ')' which closes the group starting
+// at pattern[start] or npos if the group isn't closed.
+size_t SkipGroup(const std::string& pattern, size_t start) {
+  int depth = 0;
+  bool in_class = false;
+  for (size_t i = start; i < pattern.size(); i++) {
+    char c = pattern[i];
+    if (c == '\\') {
+      i++;
+    } else if (in_class) {
+      in_class = c != ']';
+    } else if (c == '[') {
+      in_class = true;
+      if (i + 1 < pattern.size() && pattern[i + 1] == ']') {
+        i++;
+      }
+    } else if (c == '(') {
+      depth++;
+    } else if (c == ')' && --depth == 0) {
+      return i + 1;
+    }
+  }
+  return std::string::npos;
+}
+
+// Returns the index just past the ']' which closes the character class
+// starting at pattern[start] or npos if the class isn't closed.
+size_t SkipClass(const std::string& pattern, size_t start) {
+  size_t i = start + 1;
+  if (i < pattern.size() && pattern[i] == '^') {
+    i++;
+  }
+  if (i < pattern.size() && pattern[i] == ']') {
+    i++;
+  }
+  for (; i < pattern.size(); i++) {
+    if (pattern[i] == '\\') {
+      i++;
+    } else if (pattern[i] == ']') {
+      return i + 1;
+    }
+  }
+  return std::string::npos;
+}
+
+// Skips the quantifier at pattern[index] if there is one. Returns the
+// minimum number of repetitions of the quantifier or -1 if there is no
+// quantifier.
+int SkipQuantifier(const std::string& pattern, size_t& index) {
+  if (index >= pattern.size()) {
+    return -1;
+  }
+
+  int min_count = -1;
+  char c = pattern[index];
+  if (c == '*' || c == '?') {
+    min_count = 0;
+    index++;
+  } else if (c == '+') {
+    min_count = 1;
+    index++;
+  } else if (c == '{') {
+    size_t digits_end = index + 1;
+    while (digits_end < pattern.size() &&
+           std::isdigit(static_cast<unsigned char>(pattern[digits_end]))) {
+      digits_end++;
+    }
+    size_t close = pattern.find('}', digits_end);
+    if (digits_end == index + 1 || close == std::string::npos) {
+      return -1;
+    }
+    // Counts which don't fit in an int are still valid patterns so
+    // they are clamped rather than rejected.
+    std::from_chars_result parsed = std::from_chars(
+        pattern.data() + index + 1, pattern.data() + digits_end, min_count);
+    if (parsed.ec == std::errc::result_out_of_range) {
+      min_count = INT_MAX;
+    }
+    index = close + 1;
+  } else {
+    return -1;
+  }
+
+  // Lazy quantifier.
+  if (index < pattern.size() && pattern[index] == '?') {
+    index++;
+  }
+  return min_count;
+}
+
+// The state shared by the worker threads of a search.
+struct SearchState {
+  std::regex regex;
+  std::string literal;
+  std::set<std::string> extensions;
+  const SearchOptions* options = nullptr;
+
+  // Directories which still have to be walked.
+  std::mutex mutex;
+  std::condition_variable directories_available;
+  std::deque<std::filesystem::path> directories;
+  // Directories which are queued or being walked.
+  size_t pending_directories = 0;
+
+  std::atomic<size_t> total_matches{0};
+  std::atomic<bool> stop{false};
+  // The first error of a worker, e.g. a std::regex_error thrown by
+  // std::regex_search when a line is too complex for the regex.
+  std::string error;
+
+  std::vector<SourceMatch> matches;
+  size_t files_searched = 0;
+  size_t bytes_searched = 0;
+  size_t lines_checked = 0;
+};
+
+struct WorkerResult {
+  std::vector<SourceMatch> matches;
+  size_t files_searched = 0;
+  size_t bytes_searched = 0;
+  size_t lines_checked = 0;
+};
+
+void SearchBuffer(const char* data,
+                  size_t size,
+                  const std::string& path,
+                  const std::regex& regex,
+                  SearchState& state,
+                  WorkerResult& result) {
+  int line_number = 1;
+  size_t counted = 0;
+
+  auto check_line = [&](size_t start, size_t end) {
+    size_t text_end = end;
+    if (text_end > start && data[text_end - 1] == '\r') {
+      text_end--;
+    }
+
+    result.lines_checked++;
+    if (!std::regex_search(data + start, data + text_end, regex)) {
+      return;
+    }
+
+    line_number += static_cast<int>(
+        std::count(data + counted, data + start, '\n'));
+    counted = start;
+
+    result.matches.push_back(
+        {path, line_number, std::string(data + start, text_end - start)});
+    if (state.total_matches.fetch_add(1) + 1 > state.options->max_matches) {
+      state.stop = true;
+    }
+  };
+
+  auto find_line_end = [&](size_t offset) {
+    const void* newline = memchr(data + offset, '\n', size - offset);
+    return newline ? static_cast<size_t>(static_cast<const char*>(newline) -
+                                         data)
+                   : size;
+  };
+
+  if (state.literal.empty()) {
+    for (size_t start = 0; start < size && !state.stop;) {
+      size_t end = find_line_end(start);
+      check_line(start, end);
+      start = end + 1;
+    }
+    return;
+  }
+
+  // Only the lines which contain the literal can match.
+  size_t next_line = 0;
+  memory_search::FindPattern(
+      reinterpret_cast<const BYTE*>(data), size,
+      reinterpret_cast<const BYTE*>(state.literal.data()),
+      state.literal.size(), [&](size_t offset) {
+        if (offset < next_line) {
+          return true;
+        }
+
+        size_t start = offset;
+        while (start > next_line && data[start - 1] != '\n') {
+          start--;
+        }
+        size_t end = find_line_end(offset);
+
+        check_line(start, end);
+        next_line = end + 1;
+        return !state.stop;
+      });
+}
+
+void SearchFile(const std::filesystem::path& path,
+                const std::regex& regex,
+                SearchState& state,
+                WorkerResult& result) {
+  mapped_file::MappedFile file;
+  if (!file.Open(path) || file.size() == 0) {
+    return;
+  }
+
+  result.files_searched++;
+  result.bytes_searched += file.size();
+  SearchBuffer(file.data(), file.size(), path.string(), regex, state, result);
+}
+
+bool IsSourceFile(const std::filesystem::directory_entry& entry,
+                  const SearchState& state) {
+  std::error_code ec;
+  if (!entry.is_regular_file(ec)) {
+    return false;
+  }
+
+  std::string extension = ToLower(entry.path().extension().string());
+  if (state.extensions.find(extension) == state.extensions.end()) {
+    return false;
+  }
+
+  uintmax_t size = entry.file_size(ec);
+  return !ec && size > 0 && size <= state.options->max_file_size;
+}
+
+void WalkDirectory(const std::filesystem::path& directory,
+                   const std::regex& regex,
+                   SearchState& state,
+                   WorkerResult& result) {
+  std::error_code ec;
+  std::filesystem::directory_iterator it(
+      directory, std::filesystem::directory_options::skip_permission_denied,
+      ec);
+
+  for (; !ec && it != std::filesystem::directory_iterator() && !state.stop;
+       it.increment(ec)) {
+    const std::filesystem::directory_entry& entry = *it;
+
+    std::error_code type_ec;
+    if (entry.is_directory(type_ec) && !entry.is_symlink(type_ec)) {
+      std::string name = entry.path().filename().string();
+      if (!name.empty() && name[0] == '.') {
+        continue;
+      }
+
+      std::lock_guard<std::mutex> lock(state.mutex);
+      state.directories.push_back(entry.path());
+      state.pending_directories++;
+      state.directories_available.notify_one();
+    } else if (IsSourceFile(entry, state)) {
+      SearchFile(entry.path(), regex, state, result);
+    }
+  }
+}
+
+void RunWorker(SearchState& state) {
+  // std::regex isn't guaranteed to be safe to use from multiple
+  // threads at once so every worker uses its own copy.
+  std::regex regex = state.regex;
+  WorkerResult result;
+
+  while (true) {
+    std::filesystem::path directory;
+    {
+      std::unique_lock<std::mutex> lock(state.mutex);
+      state.directories_available.wait(lock, [&] {
+        return !state.directories.empty() || state.pending_directories == 0 ||
+               state.stop;
+      });
+      if (state.directories.empty() || state.stop) {
+        break;
+      }
+
+      directory = std::move(state.directories.front());
+      state.directories.pop_front();
+    }
+
+    std::string error;
+    try {
+      WalkDirectory(directory, regex, state, result);
+    } catch (const std::regex_error& e) {
+      error = std::string("Regular expression error: ") + e.what();
+    }
+
+    std::lock_guard<std::mutex> lock(state.mutex);
+    if (!error.empty()) {
+      if (state.error.empty()) {
+        state.error = error;
+      }
+      state.stop = true;
+    }
+    if (--state.pending_directories == 0 || state.stop) {
+      state.directories_available.notify_all();
+    }
+  }
+
+  std::lock_guard<std::mutex> lock(state.mutex);
+  state.matches.insert(state.matches.end(),
+                       std::make_move_iterator(result.matches.begin()),
+                       std::make_move_iterator(result.matches.end()));
+  state.files_searched += result.files_searched;
+  state.bytes_searched += result.bytes_searched;
+  state.lines_checked += result.lines_checked;
+  state.directories_available.notify_all();
+}
+
+}  // namespace
+
+std::string ExtractRequiredLiteral(const std::string& pattern) {
+  std::string best;
+  std::string current;
+  auto end_run = [&]() {
+    if (current.size() > best.size()) {
+      best = current;
+    }
+    current.clear();
+  };
+
+  size_t i = 0;
+  while (i < pattern.size()) {
+    char c = pattern[i];
+
+    // Any of the alternatives can match so nothing is required.
+    if (c == '|') {
+      return "";
+    }
+
+    // Groups and classes are skipped. Their contents could
+    // still be required but they are never literal runs.
+    if (c == '(' || c == '[') {
+      size_t end = c == '(' ? SkipGroup(pattern, i) : SkipClass(pattern, i);
+      if (end == std::string::npos) {
+        return "";
+      }
+      i = end;
+      end_run();
+      SkipQuantifier(pattern, i);
+      continue;
+    }
+
+    bool literal = true;
+    char value = c;
+    i++;
+
+    if (c == '\\') {
+      if (i >= pattern.size()) {
+        return "";
+      }
+
+      char escaped = pattern[i++];
+      if (std::isalnum(static_cast<unsigned char>(escaped))) {
+        // Character classes (\w, \d), assertions (\b) and
+        // character codes (\n, \x41, \u0041, \cJ).
+        literal = false;
+        if (escaped == 'x') {
+          i += 2;
+        } else if (escaped == 'u') {
+          i += 4;
+        } else if (escaped == 'c') {
+          i += 1;
+        }
+      } else {
+        value = escaped;
+      }
+    } else if (c == '\0' || strchr(".^$*+?{})]", c)) {
+      literal = false;
+    }
+
+    if (!literal) {
+      end_run();
+      SkipQuantifier(pattern, i);
+      continue;
+    }
+
+    int min_count = SkipQuantifier(pattern, i);
+    if (min_count < 0) {
+      current += value;
+    } else if (min_count == 0) {
+      // The character is optional.
+      end_run();
+    } else {
+      // The character is required but what follows
+      // might be another repetition of it.
+      current += value;
+      end_run();
+    }
+  }
+
+  end_run();
+  return best;
+}
+
+SearchResult Search(const std::string& directory,
+                    const std::string& pattern,
+                    const SearchOptions& options) {
+  SearchResult result;
+
+  std::error_code ec;
+  if (!std::filesystem::is_directory(directory, ec)) {
+    result.error = "Directory not found: " + directory;
+    return result;
+  }
+
+  SearchState state;
+  try {
+    state.regex = std::regex(pattern, std::regex::ECMAScript);
+  } catch (const std::regex_error& e) {
+    result.error = std::string("Invalid regular expression: ") + e.what();
+    return result;
+  }
+
+  state.options = &options;
+  state.literal = options.use_prefilter ? ExtractRequiredLiteral(pattern) : "";
+  for (const std::string& extension : options.extensions) {
+    state.extensions.insert(ToLower(extension));
+  }
+
+  state.directories.push_back(std::filesystem::absolute(directory, ec));
+  state.pending_directories = 1;
+
+  size_t thread_count = options.threads;
+  if (thread_count == 0) {
+    thread_count = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  std::vector<std::thread> workers;
+  for (size_t i = 1; i < thread_count; i++) {
+    workers.emplace_back(RunWorker, std::ref(state));
+  }
+  RunWorker(state);
+  for (std::thread& worker : workers) {
+    worker.join();
+  }
+
+  if (!state.error.empty()) {
+    result.error = state.error;
+    return result;
+  }
+
+  std::sort(state.matches.begin(), state.matches.end(),
+            [](const SourceMatch& a, const SourceMatch& b) {
+              return a.path != b.path ? a.path < b.path : a.line < b.line;
+            });
+
+  if (state.matches.size() > options.max_matches) {
+    state.matches.resize(options.max_matches);
+    result.truncated = true;
+  }
+
+  result.matches = std::move(state.matches);
+  result.files_searched = state.files_searched;
+  result.bytes_searched = state.bytes_searched;
+  result.lines_checked = state.lines_checked;
+  result.literal = state.literal;
+  return result;
+}
+
+}  // namespace source_search
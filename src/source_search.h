@@ -0,0 +1,86 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef SOURCE_SEARCH_H_
+#define SOURCE_SEARCH_H_
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace source_search {
+
+struct SearchOptions {
+  // Only files with one of these extensions (case insensitive) are searched.
+  std::vector<std::string> extensions = {".c",  ".cc",  ".cpp", ".cxx",
+                                         ".h",  ".hh",  ".hpp", ".hxx",
+                                         ".inc", ".inl", ".ipp", ".m",
+                                         ".mm"};
+
+  // Stop searching after this many matching lines. Since the files are
+  // searched in parallel, which matches are found first can vary between
+  // runs when the limit is reached.
+  size_t max_matches = 1000;
+
+  // Files larger than this are skipped (generated or binary files).
+  size_t max_file_size = 32 * 1024 * 1024;
+
+  // Number of worker threads. 0 uses the number of hardware threads.
+  size_t threads = 0;
+
+  // Only run the regex on the lines which contain the longest literal
+  // required by the pattern. Disabling this is only useful to measure
+  // the effect of the prefilter.
+  bool use_prefilter = true;
+};
+
+struct SourceMatch {
+  // The path of the file as found while walking the directory.
+  std::string path;
+  // 1-based line number.
+  int line = 0;
+  // The matching line without the line terminator.
+  std::string text;
+};
+
+struct SearchResult {
+  // Sorted by path and then by line.
+  std::vector<SourceMatch> matches;
+
+  // True if the search stopped after max_matches.
+  bool truncated = false;
+
+  size_t files_searched = 0;
+  size_t bytes_searched = 0;
+
+  // The number of lines on which the regex was evaluated.
+  size_t lines_checked = 0;
+
+  // The literal used for the prefilter. Empty if there isn't one.
+  std::string literal;
+
+  // Set if the search could not be run (invalid pattern or directory)
+  // or failed (the regex threw while matching a line). No matches are
+  // returned with an error.
+  std::string error;
+};
+
+// Returns the longest string which every match of the ECMAScript regular
+// expression has to contain (e.g. "OnDataReceived" for
+// "void\s+\w+::OnDataReceived\("). Returns an empty string if there is no
+// such literal, e.g. if the pattern contains a top level alternation.
+std::string ExtractRequiredLiteral(const std::string& pattern);
+
+// Searches the source files under directory for lines matching the
+// ECMAScript regular expression pattern. Subdirectories are walked by a
+// pool of worker threads. Each file is memory mapped and scanned for the
+// required literal of the pattern with SSE2 (see memory_search::FindPattern)
+// and the regex is only run on the lines which contain the literal.
+// Directories starting with '.' (.git, .svn, ...) are skipped.
+SearchResult Search(const std::string& directory,
+                    const std::string& pattern,
+                    const SearchOptions& options = SearchOptions());
+
+}  // namespace source_search
+
+#endif  // SOURCE_SEARCH_H_
@@ -0,0 +1,174 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "stack_sampler.h"
+
+#include <chrono>
+#include <memory>
+
+#include "symbol_cache.h"
+
+namespace stack_sampler {
+
+namespace {
+
+// How long to wait for the target to break in after SetInterrupt.
+constexpr ULONG kBreakInTimeoutMs = 5000;
+
+}  // namespace
+
+std::vector<LabeledTree> SamplerResult::GetLabeledTrees() const {
+  std::vector<LabeledTree> labeled;
+  for (const auto& [system_id, tree] : trees) {
+    std::string label;
+    if (system_id != 0) {
+      char buffer[32];
+      snprintf(buffer, sizeof(buffer), "thread_%x", system_id);
+      label = buffer;
+    }
+    labeled.emplace_back(label, &tree);
+  }
+  return labeled;
+}
+
+Symbolizer CreateEngineSymbolizer(const utils::DebugInterfaces* interfaces) {
+  auto cache = std::make_shared<symbol_cache::SymbolCache>(interfaces);
+
+  return [cache](ULONG64 address) -> std::string {
+    symbol_cache::SymbolInfo info = cache->Symbolize(address);
+    return info.found ? info.name : info.ToString();
+  };
+}
+
+StackSampler::StackSampler(const utils::DebugInterfaces* interfaces)
+    : interfaces_(interfaces) {}
+
+SamplerResult StackSampler::Run(const SamplerOptions& options,
+                                const std::function<bool()>& should_stop) {
+  SamplerResult result;
+
+  if (options.interval_ms == 0 || options.max_depth == 0) {
+    result.error = "The interval and the stack depth must be greater than zero";
+    return result;
+  }
+
+  ULONG status = 0;
+  HRESULT hr = interfaces_->control->GetExecutionStatus(&status);
+  if (FAILED(hr) || status != DEBUG_STATUS_BREAK) {
+    result.error = "The target must be broken in to start sampling";
+    return result;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const auto duration = std::chrono::milliseconds(options.duration_ms);
+
+  while (std::chrono::steady_clock::now() - start < duration) {
+    if (should_stop && should_stop()) {
+      result.stop_reason = "Interrupted";
+      break;
+    }
+
+    hr = interfaces_->control->SetExecutionStatus(DEBUG_STATUS_GO);
+    if (FAILED(hr)) {
+      result.error = "Unable to resume the target";
+      return result;
+    }
+
+    // S_FALSE means that the interval elapsed while the target was
+    // running. Anything else means that the target stopped by itself
+    // (breakpoint, exception, exit, etc.) and sampling can't continue.
+    hr = interfaces_->control->WaitForEvent(DEBUG_WAIT_DEFAULT,
+                                            options.interval_ms);
+    if (hr != S_FALSE) {
+      result.stop_reason = SUCCEEDED(hr)
+                               ? "The target stopped on a debug event"
+                               : "The target is no longer available";
+      break;
+    }
+
+    hr = interfaces_->control->SetInterrupt(DEBUG_INTERRUPT_ACTIVE);
+    if (SUCCEEDED(hr)) {
+      hr = interfaces_->control->WaitForEvent(DEBUG_WAIT_DEFAULT,
+                                              kBreakInTimeoutMs);
+    }
+    if (hr != S_OK) {
+      result.error = "Unable to break into the target";
+      return result;
+    }
+
+    ULONG break_thread_id = static_cast<ULONG>(-1);
+    interfaces_->system_objects->GetEventThread(&break_thread_id);
+
+    CaptureStacks(options, break_thread_id, result);
+    result.samples++;
+  }
+
+  result.elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                          std::chrono::steady_clock::now() - start)
+                          .count();
+  result.success = true;
+  return result;
+}
+
+HRESULT StackSampler::CaptureStacks(const SamplerOptions& options,
+                                    ULONG skip_thread_id,
+                                    SamplerResult& result) {
+  ULONG thread_count = 0;
+  HRESULT hr = interfaces_->system_objects->GetNumberThreads(&thread_count);
+  if (FAILED(hr) || thread_count == 0) {
+    return FAILED(hr) ? hr : S_FALSE;
+  }
+
+  std::vector<ULONG> ids(thread_count);
+  std::vector<ULONG> system_ids(thread_count);
+  hr = interfaces_->system_objects->GetThreadIdsByIndex(
+      0, thread_count, ids.data(), system_ids.data());
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  ULONG original_thread_id = 0;
+  hr = interfaces_->system_objects->GetCurrentThreadId(&original_thread_id);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  std::vector<DEBUG_STACK_FRAME> frames(options.max_depth);
+  std::vector<ULONG64> stack;
+  stack.reserve(options.max_depth);
+
+  for (ULONG i = 0; i < thread_count; i++) {
+    if (ids[i] == skip_thread_id) {
+      continue;
+    }
+    if (!options.thread_ids.empty() && options.thread_ids.count(ids[i]) == 0) {
+      continue;
+    }
+
+    if (FAILED(interfaces_->system_objects->SetCurrentThreadId(ids[i]))) {
+      continue;
+    }
+
+    ULONG frames_filled = 0;
+    hr = interfaces_->control->GetStackTrace(
+        0, 0, 0, frames.data(), options.max_depth, &frames_filled);
+    if (FAILED(hr) || frames_filled == 0) {
+      continue;
+    }
+
+    // GetStackTrace returns the executing frame first.
+    stack.clear();
+    for (ULONG j = frames_filled; j > 0; j--) {
+      stack.push_back(frames[j - 1].InstructionOffset);
+    }
+
+    ULONG key = options.group_by_thread ? system_ids[i] : 0;
+    result.trees[key].AddStack(stack);
+    result.stacks++;
+  }
+
+  interfaces_->system_objects->SetCurrentThreadId(original_thread_id);
+  return S_OK;
+}
+
+}  // namespace stack_sampler
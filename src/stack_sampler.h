@@ -0,0 +1,86 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef STACK_SAMPLER_H_
+#define STACK_SAMPLER_H_
+
+#include <dbgeng.h>
+#include <windows.h>
+#include <functional>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "call_tree.h"
+#include "utils.h"
+
+namespace stack_sampler {
+
+struct SamplerOptions {
+  // Time the target runs between samples.
+  ULONG interval_ms = 10;
+
+  // Total time to sample for.
+  ULONG duration_ms = 1000;
+
+  // Maximum number of frames captured for each stack.
+  ULONG max_depth = 64;
+
+  // Engine thread ids to sample. Empty samples all threads.
+  std::set<ULONG> thread_ids;
+
+  // Keep a separate call tree for each thread.
+  bool group_by_thread = false;
+};
+
+struct SamplerResult {
+  bool success = false;
+  std::string error;
+
+  // Why sampling stopped before the duration
+  // elapsed (e.g. a breakpoint was hit).
+  std::string stop_reason;
+
+  ULONG samples = 0;
+  ULONG64 stacks = 0;
+  ULONG64 elapsed_ms = 0;
+
+  // The call trees keyed by thread system id when grouping by thread.
+  // Otherwise all of the stacks are in the entry with key 0.
+  std::map<ULONG, CallTree> trees;
+
+  // The trees labeled for the Format functions.
+  std::vector<LabeledTree> GetLabeledTrees() const;
+};
+
+// Symbolizes addresses with a symbol_cache::SymbolCache without the
+// displacement so that samples from the same function are merged.
+Symbolizer CreateEngineSymbolizer(const utils::DebugInterfaces* interfaces);
+
+class StackSampler {
+ public:
+  explicit StackSampler(const utils::DebugInterfaces* interfaces);
+
+  // Repeatedly resumes the target, lets it run for interval_ms, breaks
+  // in with SetInterrupt and captures the stack of every thread with
+  // GetStackTrace. The target must be broken in when this is called and
+  // is broken in when it returns. should_stop is checked before each
+  // sample so that a user interrupt can end sampling early.
+  SamplerResult Run(const SamplerOptions& options,
+                    const std::function<bool()>& should_stop = nullptr);
+
+  // Captures the stacks of the threads selected by options while the
+  // target is broken in. skip_thread_id is the thread which the engine
+  // injected to break in (it is not part of the workload).
+  HRESULT CaptureStacks(const SamplerOptions& options,
+                        ULONG skip_thread_id,
+                        SamplerResult& result);
+
+ private:
+  const utils::DebugInterfaces* interfaces_;
+};
+
+}  // namespace stack_sampler
+
+#endif  // STACK_SAMPLER_H_
@@ -0,0 +1,427 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "state_snapshot.h"
+
+#include <algorithm>
+#include <map>
+
+namespace state_snapshot {
+
+namespace {
+
+// The buffer size for local names, types and values.
+constexpr ULONG kMaxTextLength = 1024;
+
+}  // namespace
+
+SnapshotCapturer::SnapshotCapturer(
+    const utils::DebugInterfaces* interfaces,
+    std::function<std::string(ULONG64)> symbolizer)
+    : interfaces_(interfaces), symbolizer_(std::move(symbolizer)) {}
+
+bool SnapshotCapturer::Capture(const CaptureOptions& options,
+                               Snapshot& snapshot,
+                               std::string& error) {
+  snapshot = Snapshot();
+
+  if (FAILED(interfaces_->system_objects->GetCurrentThreadSystemId(
+          &snapshot.thread_id))) {
+    error = "Failed to get the current thread";
+    return false;
+  }
+
+  if (!CaptureRegisters(snapshot, error) ||
+      !CaptureFrames(options, snapshot, error)) {
+    return false;
+  }
+
+  CaptureLocals(options, snapshot);
+  return true;
+}
+
+// Only the full size integer registers are kept. Sub registers (eax,
+// al, ...) are part of their full registers and the floating point and
+// vector registers are rarely useful when comparing states.
+bool SnapshotCapturer::LoadRegisterTable(std::string& error) {
+  ULONG count = 0;
+  if (FAILED(interfaces_->registers->GetNumberRegisters(&count))) {
+    error = "Failed to get the number of registers";
+    return false;
+  }
+
+  register_indices_.clear();
+  register_names_.clear();
+  for (ULONG i = 0; i < count; i++) {
+    char name[64];
+    DEBUG_REGISTER_DESCRIPTION description = {};
+    if (FAILED(interfaces_->registers->GetDescription(
+            i, name, sizeof(name), nullptr, &description))) {
+      continue;
+    }
+    if (description.Flags & DEBUG_REGISTER_SUB_REGISTER) {
+      continue;
+    }
+    if (description.Type != DEBUG_VALUE_INT8 &&
+        description.Type != DEBUG_VALUE_INT16 &&
+        description.Type != DEBUG_VALUE_INT32 &&
+        description.Type != DEBUG_VALUE_INT64) {
+      continue;
+    }
+
+    name[sizeof(name) - 1] = '\0';
+    register_indices_.push_back(i);
+    register_names_.push_back(name);
+  }
+
+  register_count_ = count;
+  return true;
+}
+
+bool SnapshotCapturer::CaptureRegisters(Snapshot& snapshot,
+                                        std::string& error) {
+  // The register table changes with the effective processor type.
+  ULONG count = 0;
+  if (register_indices_.empty() ||
+      FAILED(interfaces_->registers->GetNumberRegisters(&count)) ||
+      count != register_count_) {
+    if (!LoadRegisterTable(error)) {
+      return false;
+    }
+  }
+
+  std::vector<DEBUG_VALUE> values(register_indices_.size());
+  if (values.empty() ||
+      FAILED(interfaces_->registers->GetValues(
+          static_cast<ULONG>(values.size()), register_indices_.data(), 0,
+          values.data()))) {
+    error = "Failed to get the register values";
+    return false;
+  }
+
+  snapshot.registers.reserve(values.size());
+  for (size_t i = 0; i < values.size(); i++) {
+    ULONG64 value = 0;
+    switch (values[i].Type) {
+      case DEBUG_VALUE_INT8:
+        value = values[i].I8;
+        break;
+      case DEBUG_VALUE_INT16:
+        value = values[i].I16;
+        break;
+      case DEBUG_VALUE_INT32:
+        value = values[i].I32;
+        break;
+      default:
+        value = values[i].I64;
+        break;
+    }
+    snapshot.registers.emplace_back(register_names_[i], value);
+  }
+  return true;
+}
+
+bool SnapshotCapturer::CaptureFrames(const CaptureOptions& options,
+                                     Snapshot& snapshot,
+                                     std::string& error) {
+  if (options.max_frames == 0) {
+    return true;
+  }
+
+  std::vector<DEBUG_STACK_FRAME> frames(options.max_frames);
+  ULONG frames_filled = 0;
+  if (FAILED(interfaces_->control->GetStackTrace(
+          0, 0, 0, frames.data(), static_cast<ULONG>(frames.size()),
+          &frames_filled))) {
+    error = "Failed to get the stack trace";
+    return false;
+  }
+
+  snapshot.frames.reserve(frames_filled);
+  for (ULONG i = 0; i < frames_filled; i++) {
+    Frame frame;
+    frame.instruction_offset = frames[i].InstructionOffset;
+    frame.stack_offset = frames[i].StackOffset;
+    frame.symbol = symbolizer_(frame.instruction_offset);
+    snapshot.frames.push_back(std::move(frame));
+  }
+  return true;
+}
+
+void SnapshotCapturer::CaptureLocals(const CaptureOptions& options,
+                                     Snapshot& snapshot) {
+  if (options.max_locals == 0) {
+    return;
+  }
+
+  IDebugSymbolGroup* scope_group = nullptr;
+  if (FAILED(interfaces_->symbols->GetScopeSymbolGroup(
+          DEBUG_SCOPE_GROUP_ALL, nullptr, &scope_group)) ||
+      !scope_group) {
+    return;
+  }
+
+  IDebugSymbolGroup2* group = nullptr;
+  HRESULT hr = scope_group->QueryInterface(__uuidof(IDebugSymbolGroup2),
+                                           reinterpret_cast<void**>(&group));
+  scope_group->Release();
+  if (FAILED(hr) || !group) {
+    return;
+  }
+
+  ULONG count = 0;
+  std::vector<DEBUG_SYMBOL_PARAMETERS> parameters;
+  if (SUCCEEDED(group->GetNumberSymbols(&count)) && count > 0) {
+    parameters.resize(count);
+    if (FAILED(group->GetSymbolParameters(0, count, parameters.data()))) {
+      parameters.clear();
+    }
+  }
+
+  for (ULONG i = 0; i < parameters.size(); i++) {
+    if (snapshot.locals.size() >= options.max_locals) {
+      break;
+    }
+    // Only the top level symbols. Expanded members are not included.
+    if (parameters[i].ParentSymbol != DEBUG_ANY_ID) {
+      continue;
+    }
+
+    Variable variable;
+    char buffer[kMaxTextLength];
+    if (SUCCEEDED(group->GetSymbolName(i, buffer, kMaxTextLength, nullptr))) {
+      variable.name = buffer;
+    }
+    if (SUCCEEDED(
+            group->GetSymbolTypeName(i, buffer, kMaxTextLength, nullptr))) {
+      variable.type = buffer;
+    }
+    if (SUCCEEDED(
+            group->GetSymbolValueText(i, buffer, kMaxTextLength, nullptr))) {
+      variable.value = buffer;
+    }
+    if (variable.value.size() > options.max_value_length) {
+      variable.value.resize(options.max_value_length);
+      variable.value += "...";
+    }
+    variable.is_argument = (parameters[i].Flags & DEBUG_SYMBOL_IS_ARGUMENT) != 0;
+    snapshot.locals.push_back(std::move(variable));
+  }
+
+  group->Release();
+}
+
+bool StateDiff::IsEmpty() const {
+  return !thread_changed && registers.empty() && !frames_changed &&
+         changed_locals.empty() && added_locals.empty() &&
+         removed_locals.empty();
+}
+
+std::string GetFunctionName(const std::string& symbol) {
+  size_t plus = symbol.rfind('+');
+  if (plus == std::string::npos || plus == 0) {
+    return symbol;
+  }
+  return symbol.substr(0, plus);
+}
+
+StateDiff Diff(const Snapshot& from, const Snapshot& to) {
+  StateDiff diff;
+  diff.from_id = from.id;
+  diff.to_id = to.id;
+  diff.from_thread_id = from.thread_id;
+  diff.to_thread_id = to.thread_id;
+  diff.thread_changed = from.thread_id != to.thread_id;
+
+  std::map<std::string, ULONG64> old_registers(from.registers.begin(),
+                                               from.registers.end());
+  for (const auto& [name, value] : to.registers) {
+    auto it = old_registers.find(name);
+    if (it == old_registers.end() || it->second != value) {
+      diff.registers.push_back(
+          {name, it == old_registers.end() ? 0 : it->second, value});
+    }
+  }
+
+  if (from.frames != to.frames) {
+    diff.frames_changed = true;
+    diff.frames = to.frames;
+  }
+
+  std::string from_function =
+      from.frames.empty() ? "" : GetFunctionName(from.frames[0].symbol);
+  std::string to_function =
+      to.frames.empty() ? "" : GetFunctionName(to.frames[0].symbol);
+  diff.scope_changed = diff.thread_changed || from_function != to_function;
+
+  // Locals are matched by name. Shadowed names in nested scopes keep
+  // their order so the n-th occurrence of a name is matched.
+  std::map<std::string, std::vector<const Variable*>> old_locals;
+  for (const Variable& variable : from.locals) {
+    old_locals[variable.name].push_back(&variable);
+  }
+
+  std::map<std::string, size_t> occurrences;
+  for (const Variable& variable : to.locals) {
+    size_t occurrence = occurrences[variable.name]++;
+    auto it = old_locals.find(variable.name);
+    if (it == old_locals.end() || occurrence >= it->second.size()) {
+      diff.added_locals.push_back(variable);
+      continue;
+    }
+
+    const Variable* old_variable = it->second[occurrence];
+    if (old_variable->value != variable.value ||
+        old_variable->type != variable.type) {
+      diff.changed_locals.push_back(
+          {variable.name, variable.type, old_variable->value, variable.value});
+    }
+  }
+
+  for (const auto& [name, variables] : old_locals) {
+    size_t count = occurrences.count(name) ? occurrences[name] : 0;
+    for (size_t i = count; i < variables.size(); i++) {
+      diff.removed_locals.push_back(name);
+    }
+  }
+
+  return diff;
+}
+
+SnapshotStore::SnapshotStore(size_t capacity, size_t keyframe_interval)
+    : capacity_(std::max<size_t>(capacity, 1)),
+      keyframe_interval_(std::max<size_t>(keyframe_interval, 1)) {}
+
+template <typename T>
+SnapshotStore::VectorDelta<T> SnapshotStore::Encode(const std::vector<T>& from,
+                                                    const std::vector<T>& to) {
+  VectorDelta<T> delta;
+  delta.size = to.size();
+  for (size_t i = 0; i < to.size(); i++) {
+    if (i >= from.size() || from[i] != to[i]) {
+      delta.changes.emplace_back(i, to[i]);
+    }
+  }
+  return delta;
+}
+
+template <typename T>
+void SnapshotStore::Apply(const VectorDelta<T>& delta, std::vector<T>& values) {
+  values.resize(delta.size);
+  for (const auto& [index, value] : delta.changes) {
+    values[index] = value;
+  }
+}
+
+size_t SnapshotStore::GetValueCount(const Entry& entry) {
+  if (entry.is_keyframe) {
+    return entry.snapshot.registers.size() + entry.snapshot.frames.size() +
+           entry.snapshot.locals.size();
+  }
+  return entry.registers.changes.size() + entry.frames.changes.size() +
+         entry.locals.changes.size();
+}
+
+ULONG SnapshotStore::Add(Snapshot snapshot) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  snapshot.id = next_id_++;
+
+  Entry entry;
+  entry.id = snapshot.id;
+  if (entries_.empty() || entries_since_keyframe_ + 1 >= keyframe_interval_) {
+    entry.is_keyframe = true;
+    entry.snapshot = snapshot;
+    entries_since_keyframe_ = 0;
+  } else {
+    entry.thread_id = snapshot.thread_id;
+    entry.registers = Encode(latest_.registers, snapshot.registers);
+    entry.frames = Encode(latest_.frames, snapshot.frames);
+    entry.locals = Encode(latest_.locals, snapshot.locals);
+    entries_since_keyframe_++;
+  }
+
+  stored_value_count_ += GetValueCount(entry);
+  entries_.push_back(std::move(entry));
+  latest_ = std::move(snapshot);
+
+  if (entries_.size() > capacity_) {
+    // The next entry may depend on the one which is dropped.
+    if (!entries_[1].is_keyframe) {
+      Snapshot next = Decode(1);
+      stored_value_count_ -= GetValueCount(entries_[1]);
+      entries_[1] = Entry();
+      entries_[1].id = next.id;
+      entries_[1].is_keyframe = true;
+      entries_[1].snapshot = std::move(next);
+      stored_value_count_ += GetValueCount(entries_[1]);
+    }
+    stored_value_count_ -= GetValueCount(entries_.front());
+    entries_.pop_front();
+  }
+
+  return latest_.id;
+}
+
+Snapshot SnapshotStore::Decode(size_t index) const {
+  size_t keyframe = index;
+  while (!entries_[keyframe].is_keyframe) {
+    keyframe--;
+  }
+
+  Snapshot snapshot = entries_[keyframe].snapshot;
+  for (size_t i = keyframe + 1; i <= index; i++) {
+    const Entry& entry = entries_[i];
+    snapshot.id = entry.id;
+    snapshot.thread_id = entry.thread_id;
+    Apply(entry.registers, snapshot.registers);
+    Apply(entry.frames, snapshot.frames);
+    Apply(entry.locals, snapshot.locals);
+  }
+  return snapshot;
+}
+
+bool SnapshotStore::Get(ULONG id, Snapshot& snapshot) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (entries_.empty() || id < entries_.front().id ||
+      id > entries_.back().id) {
+    return false;
+  }
+
+  // The ids of the entries are consecutive.
+  if (id == entries_.back().id) {
+    snapshot = latest_;
+  } else {
+    snapshot = Decode(id - entries_.front().id);
+  }
+  return true;
+}
+
+ULONG SnapshotStore::GetLatestId() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.empty() ? 0 : entries_.back().id;
+}
+
+ULONG SnapshotStore::GetOldestId() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.empty() ? 0 : entries_.front().id;
+}
+
+size_t SnapshotStore::GetCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return entries_.size();
+}
+
+size_t SnapshotStore::GetStoredValueCount() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stored_value_count_;
+}
+
+void SnapshotStore::Clear() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  entries_.clear();
+  entries_since_keyframe_ = 0;
+  latest_ = Snapshot();
+  stored_value_count_ = 0;
+}
+
+}  // namespace state_snapshot
@@ -0,0 +1,220 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef STATE_SNAPSHOT_H_
+#define STATE_SNAPSHOT_H_
+
+#include <dbgeng.h>
+#include <windows.h>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utils.h"
+
+namespace state_snapshot {
+
+struct Frame {
+  ULONG64 instruction_offset = 0;
+  ULONG64 stack_offset = 0;
+  // "chrome!Foo::Bar+0x12"
+  std::string symbol;
+
+  bool operator==(const Frame& other) const {
+    return instruction_offset == other.instruction_offset &&
+           stack_offset == other.stack_offset && symbol == other.symbol;
+  }
+  bool operator!=(const Frame& other) const { return !(*this == other); }
+};
+
+// A top level local variable or argument of the top frame.
+struct Variable {
+  std::string name;
+  std::string type;
+  std::string value;
+  bool is_argument = false;
+
+  bool operator==(const Variable& other) const {
+    return name == other.name && type == other.type && value == other.value &&
+           is_argument == other.is_argument;
+  }
+  bool operator!=(const Variable& other) const { return !(*this == other); }
+};
+
+using Register = std::pair<std::string, ULONG64>;
+
+// The state of the current thread at a break.
+struct Snapshot {
+  ULONG id = 0;
+  // The system id of the current thread.
+  ULONG thread_id = 0;
+  // The integer registers in the order of the engine's register table.
+  std::vector<Register> registers;
+  // The executing frame first.
+  std::vector<Frame> frames;
+  std::vector<Variable> locals;
+};
+
+struct CaptureOptions {
+  size_t max_frames = 8;
+  size_t max_locals = 64;
+  // Longer local values are truncated.
+  size_t max_value_length = 256;
+};
+
+// Captures snapshots with a fixed number of engine calls: one GetValues
+// for all of the registers, one GetStackTrace and a scope symbol group
+// for the locals. The table of integer registers is only read once.
+//
+// Must be used on the thread which owns the debugger engine while the
+// target is broken in.
+class SnapshotCapturer {
+ public:
+  // The symbolizer turns the frame addresses into names.
+  SnapshotCapturer(const utils::DebugInterfaces* interfaces,
+                   std::function<std::string(ULONG64)> symbolizer);
+
+  bool Capture(const CaptureOptions& options,
+               Snapshot& snapshot,
+               std::string& error);
+
+  // Forget the register table (e.g. after the target changed).
+  void Reset() { register_indices_.clear(); }
+
+ private:
+  bool LoadRegisterTable(std::string& error);
+  bool CaptureRegisters(Snapshot& snapshot, std::string& error);
+  bool CaptureFrames(const CaptureOptions& options,
+                     Snapshot& snapshot,
+                     std::string& error);
+  // Locals are optional. A frame without symbols has no locals.
+  void CaptureLocals(const CaptureOptions& options, Snapshot& snapshot);
+
+  const utils::DebugInterfaces* interfaces_;
+  std::function<std::string(ULONG64)> symbolizer_;
+
+  ULONG register_count_ = 0;
+  std::vector<ULONG> register_indices_;
+  std::vector<std::string> register_names_;
+};
+
+// The differences between two snapshots.
+struct StateDiff {
+  ULONG from_id = 0;
+  ULONG to_id = 0;
+
+  bool thread_changed = false;
+  ULONG from_thread_id = 0;
+  ULONG to_thread_id = 0;
+
+  struct RegisterChange {
+    std::string name;
+    ULONG64 old_value = 0;
+    ULONG64 new_value = 0;
+  };
+  std::vector<RegisterChange> registers;
+
+  // The frames of the newer snapshot if any of them changed.
+  bool frames_changed = false;
+  std::vector<Frame> frames;
+
+  // The function of the top frame changed so the locals of the
+  // two snapshots are from different scopes.
+  bool scope_changed = false;
+
+  struct VariableChange {
+    std::string name;
+    std::string type;
+    std::string old_value;
+    std::string new_value;
+  };
+  std::vector<VariableChange> changed_locals;
+  std::vector<Variable> added_locals;
+  std::vector<std::string> removed_locals;
+
+  bool IsEmpty() const;
+};
+
+StateDiff Diff(const Snapshot& from, const Snapshot& to);
+
+// "chrome!Foo::Bar+0x12" -> "chrome!Foo::Bar"
+std::string GetFunctionName(const std::string& symbol);
+
+// Keeps the most recent snapshots in a bounded ring. Consecutive
+// snapshots usually differ in a few registers, the top frame and a few
+// locals so each snapshot is stored as the changes from the previous
+// one. A full snapshot (keyframe) is stored every keyframe_interval
+// snapshots to bound the cost of Get. When the oldest snapshot is
+// dropped the next one is turned into a keyframe.
+class SnapshotStore {
+ public:
+  explicit SnapshotStore(size_t capacity, size_t keyframe_interval = 16);
+
+  // Assigns the id of the snapshot and returns it.
+  ULONG Add(Snapshot snapshot);
+
+  // Returns false if the id is unknown or has been dropped.
+  bool Get(ULONG id, Snapshot& snapshot) const;
+
+  // 0 if the store is empty.
+  ULONG GetLatestId() const;
+  ULONG GetOldestId() const;
+  size_t GetCount() const;
+
+  // The number of stored registers, frames and locals. Used to
+  // measure the savings of the delta encoding.
+  size_t GetStoredValueCount() const;
+
+  void Clear();
+
+ private:
+  // The elements at the indexes which differ from the previous
+  // snapshot plus the new size.
+  template <typename T>
+  struct VectorDelta {
+    size_t size = 0;
+    std::vector<std::pair<size_t, T>> changes;
+  };
+
+  struct Entry {
+    ULONG id = 0;
+    bool is_keyframe = false;
+    // Only valid for keyframes.
+    Snapshot snapshot;
+    // Only valid for deltas.
+    ULONG thread_id = 0;
+    VectorDelta<Register> registers;
+    VectorDelta<Frame> frames;
+    VectorDelta<Variable> locals;
+  };
+
+  template <typename T>
+  static VectorDelta<T> Encode(const std::vector<T>& from,
+                               const std::vector<T>& to);
+  template <typename T>
+  static void Apply(const VectorDelta<T>& delta, std::vector<T>& values);
+
+  static size_t GetValueCount(const Entry& entry);
+
+  // Reconstructs the snapshot at index.
+  Snapshot Decode(size_t index) const;
+
+  size_t capacity_;
+  size_t keyframe_interval_;
+  ULONG next_id_ = 1;
+  std::deque<Entry> entries_;
+  // The number of entries since the last keyframe.
+  size_t entries_since_keyframe_ = 0;
+  // A decoded copy of the latest snapshot to encode the next one.
+  Snapshot latest_;
+  size_t stored_value_count_ = 0;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace state_snapshot
+
+#endif  // STATE_SNAPSHOT_H_
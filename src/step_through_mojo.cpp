@@ -71,6 +71,11 @@
 
 utils::DebugInterfaces g_debug;
 
+// The hook signature checks read small pieces of the same functions
+// several times. Reads go through this cache which is invalidated by
+// the event callbacks whenever the target runs or its memory changes.
+utils::MemoryReadCache g_memory_cache(&g_debug);
+
 // The names of the modules that should be patched.
 static std::vector<std::string> g_modules;
 static const std::string kHandleValidatedMessageSymbol =
@@ -106,7 +111,7 @@ class HookDefinition {
     // Read the current bytes at the target address
     std::vector<BYTE> current_bytes(expected_bytes.size());
     ULONG bytes_read;
-    HRESULT hr = g_debug.data_spaces->ReadVirtual(
+    HRESULT hr = g_memory_cache.ReadVirtual(
         target_address, current_bytes.data(),
         static_cast<ULONG>(current_bytes.size()), &bytes_read);
 
@@ -225,7 +230,7 @@ class HookReleaseNoConfigChanges : public HookDefinition {
       hook_bytes[jump_target_offset + i] = (jump_target >> (i * 8)) & 0xFF;
     }
     ULONG bytes_written;
-    g_debug.data_spaces->WriteVirtual(
+    g_memory_cache.WriteVirtual(
         hook_instance.hook_address, hook_bytes.data(),
         static_cast<ULONG>(hook_bytes.size()), &bytes_written);
 
@@ -233,7 +238,7 @@ class HookReleaseNoConfigChanges : public HookDefinition {
     std::vector<BYTE> patch_bytes =
         GetPatchBytes(hook_instance.hook_address, original_code_.size());
 
-    g_debug.data_spaces->WriteVirtual(
+    g_memory_cache.WriteVirtual(
         hook_instance.target_address, patch_bytes.data(),
         static_cast<ULONG>(patch_bytes.size()), &bytes_written);
     return true;
@@ -334,7 +339,7 @@ class HookReleaseWithConfigNoOptimize : public HookDefinition {
     const size_t bytes_to_read = 17;  // Covers up to the xor instruction
     std::vector<BYTE> actual_bytes(bytes_to_read);
     ULONG bytes_read;
-    HRESULT hr = g_debug.data_spaces->ReadVirtual(
+    HRESULT hr = g_memory_cache.ReadVirtual(
         target_address, actual_bytes.data(),
         static_cast<ULONG>(actual_bytes.size()), &bytes_read);
 
@@ -372,7 +377,7 @@ class HookReleaseWithConfigNoOptimize : public HookDefinition {
     // Read the original bytes we're going to replace (17 bytes)
     std::vector<BYTE> original_bytes(original_code_size_);
     ULONG bytes_read;
-    HRESULT hr = g_debug.data_spaces->ReadVirtual(
+    HRESULT hr = g_memory_cache.ReadVirtual(
         hook_instance.target_address, original_bytes.data(),
         static_cast<ULONG>(original_bytes.size()), &bytes_read);
 
@@ -425,7 +430,7 @@ class HookReleaseWithConfigNoOptimize : public HookDefinition {
 
     // Write the hook code to the allocated memory
     ULONG bytes_written;
-    hr = g_debug.data_spaces->WriteVirtual(
+    hr = g_memory_cache.WriteVirtual(
         hook_instance.hook_address, hook_bytes.data(),
         static_cast<ULONG>(hook_bytes.size()), &bytes_written);
 
@@ -438,7 +443,7 @@ class HookReleaseWithConfigNoOptimize : public HookDefinition {
     std::vector<BYTE> patch_bytes =
         GetPatchBytes(hook_instance.hook_address, original_code_size_);
 
-    hr = g_debug.data_spaces->WriteVirtual(
+    hr = g_memory_cache.WriteVirtual(
         hook_instance.target_address, patch_bytes.data(),
         static_cast<ULONG>(patch_bytes.size()), &bytes_written);
 
@@ -535,9 +540,17 @@ class EventCallbacks : public DebugEventCallbacks {
  public:
   EventCallbacks()
       : DebugEventCallbacks(DEBUG_EVENT_CHANGE_ENGINE_STATE |
+                            DEBUG_EVENT_CHANGE_DEBUGGEE_STATE |
                             DEBUG_EVENT_LOAD_MODULE) {}
 
+  STDMETHOD(ChangeDebuggeeState)(ULONG flags, ULONG64 argument) {
+    g_memory_cache.OnChangeDebuggeeState(flags, argument);
+    return S_OK;
+  }
+
   STDMETHOD(ChangeEngineState)(ULONG flags, ULONG64 argument) {
+    g_memory_cache.OnChangeEngineState(flags, argument);
+
     if (flags & DEBUG_CES_EXECUTION_STATUS) {
       // Check if the target was suspended.
       // DEBUG_STATUS_BREAK indicates that the target is suspended
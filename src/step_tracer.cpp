@@ -0,0 +1,287 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "step_tracer.h"
+
+#include <algorithm>
+#include <unordered_set>
+
+namespace step_tracer {
+
+namespace {
+
+constexpr uint8_t kKindMask = 0x03;
+constexpr uint8_t kThreadChangedFlag = 0x04;
+constexpr uint8_t kSmallDeltaFlag = 0x08;
+constexpr int kSmallDeltaShift = 4;
+constexpr ULONG64 kMaxSmallDelta = 0x0F;
+
+void WriteVarint(std::vector<uint8_t>& bytes, ULONG64 value) {
+  while (value >= 0x80) {
+    bytes.push_back(static_cast<uint8_t>(value | 0x80));
+    value >>= 7;
+  }
+  bytes.push_back(static_cast<uint8_t>(value));
+}
+
+ULONG64 ReadVarint(const std::vector<uint8_t>& bytes, size_t& offset) {
+  ULONG64 value = 0;
+  for (int shift = 0; offset < bytes.size() && shift < 64; shift += 7) {
+    uint8_t byte = bytes[offset++];
+    value |= static_cast<ULONG64>(byte & 0x7F) << shift;
+    if ((byte & 0x80) == 0) {
+      break;
+    }
+  }
+  return value;
+}
+
+ULONG64 ZigzagEncode(int64_t value) {
+  return (static_cast<ULONG64>(value) << 1) ^
+         static_cast<ULONG64>(value >> 63);
+}
+
+int64_t ZigzagDecode(ULONG64 value) {
+  return static_cast<int64_t>(value >> 1) ^ -static_cast<int64_t>(value & 1);
+}
+
+ULONG GetExecutionStatusForKind(StepKind kind) {
+  switch (kind) {
+    case StepKind::kInto:
+      return DEBUG_STATUS_STEP_INTO;
+    case StepKind::kBranch:
+      return DEBUG_STATUS_STEP_BRANCH;
+    case StepKind::kOver:
+    default:
+      return DEBUG_STATUS_STEP_OVER;
+  }
+}
+
+}  // namespace
+
+bool ParseStepKind(const std::string& name, StepKind& kind) {
+  if (name.empty() || name == "over" || name == "p") {
+    kind = StepKind::kOver;
+  } else if (name == "into" || name == "t") {
+    kind = StepKind::kInto;
+  } else if (name == "branch" || name == "tb") {
+    kind = StepKind::kBranch;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+const char* GetStepKindName(StepKind kind) {
+  switch (kind) {
+    case StepKind::kInto:
+      return "into";
+    case StepKind::kBranch:
+      return "branch";
+    case StepKind::kOver:
+    default:
+      return "over";
+  }
+}
+
+void TraceBuffer::Append(const TraceEntry& entry) {
+  if (count_ % kCheckpointInterval == 0) {
+    checkpoints_.push_back({bytes_.size(), last_ip_, last_thread_id_});
+  }
+
+  uint8_t tag = static_cast<uint8_t>(entry.kind) & kKindMask;
+  bool thread_changed = entry.thread_id != last_thread_id_;
+  if (thread_changed) {
+    tag |= kThreadChangedFlag;
+  }
+
+  bool small_delta =
+      entry.ip >= last_ip_ && entry.ip - last_ip_ <= kMaxSmallDelta;
+  if (small_delta) {
+    tag |= kSmallDeltaFlag |
+           static_cast<uint8_t>((entry.ip - last_ip_) << kSmallDeltaShift);
+  }
+
+  bytes_.push_back(tag);
+  if (!small_delta) {
+    WriteVarint(bytes_,
+                ZigzagEncode(static_cast<int64_t>(entry.ip - last_ip_)));
+  }
+  if (thread_changed) {
+    WriteVarint(bytes_, entry.thread_id);
+  }
+
+  last_ip_ = entry.ip;
+  last_thread_id_ = entry.thread_id;
+  count_++;
+}
+
+std::vector<TraceEntry> TraceBuffer::Decode(size_t start, size_t count) const {
+  std::vector<TraceEntry> entries;
+  if (start >= count_) {
+    return entries;
+  }
+
+  count = std::min(count, count_ - start);
+  entries.reserve(count);
+
+  // Start from the closest checkpoint at or before start.
+  size_t index = (start / kCheckpointInterval) * kCheckpointInterval;
+  const Checkpoint& checkpoint = checkpoints_[index / kCheckpointInterval];
+  size_t offset = checkpoint.offset;
+  ULONG64 ip = checkpoint.ip;
+  ULONG thread_id = checkpoint.thread_id;
+
+  for (; index < start + count; index++) {
+    uint8_t tag = bytes_[offset++];
+    if (tag & kSmallDeltaFlag) {
+      ip += tag >> kSmallDeltaShift;
+    } else {
+      ip += static_cast<ULONG64>(ZigzagDecode(ReadVarint(bytes_, offset)));
+    }
+    if (tag & kThreadChangedFlag) {
+      thread_id = static_cast<ULONG>(ReadVarint(bytes_, offset));
+    }
+
+    if (index >= start) {
+      entries.push_back({ip, thread_id, static_cast<StepKind>(tag & kKindMask)});
+    }
+  }
+
+  return entries;
+}
+
+TraceSummary Summarize(const TraceBuffer& buffer) {
+  TraceSummary summary;
+  summary.steps = buffer.GetCount();
+  summary.size_bytes = buffer.GetSizeBytes();
+  if (summary.steps == 0) {
+    return summary;
+  }
+
+  std::unordered_set<ULONG64> addresses;
+  std::vector<TraceEntry> entries = buffer.Decode(0, buffer.GetCount());
+  summary.first_ip = entries.front().ip;
+  summary.last_ip = entries.back().ip;
+  summary.min_ip = entries.front().ip;
+  summary.max_ip = entries.front().ip;
+
+  for (const TraceEntry& entry : entries) {
+    addresses.insert(entry.ip);
+    summary.min_ip = std::min(summary.min_ip, entry.ip);
+    summary.max_ip = std::max(summary.max_ip, entry.ip);
+    summary.thread_steps[entry.thread_id]++;
+  }
+
+  summary.unique_addresses = addresses.size();
+  return summary;
+}
+
+StepTracer::StepTracer(const utils::DebugInterfaces* interfaces)
+    : interfaces_(interfaces) {}
+
+std::unique_ptr<StepTrace> StepTracer::Run(
+    const TraceOptions& options,
+    const std::function<bool()>& should_stop) {
+  auto trace = std::make_unique<StepTrace>();
+
+  ULONG status = 0;
+  HRESULT hr = interfaces_->control->GetExecutionStatus(&status);
+  if (FAILED(hr) || status != DEBUG_STATUS_BREAK) {
+    trace->error = "The target must be broken in to trace";
+    return trace;
+  }
+
+  // Make sure the condition is valid before starting
+  // so that a typo doesn't result in max_steps steps.
+  bool met = false;
+  if (!options.until.empty() && !EvaluateCondition(options.until, met)) {
+    trace->error = "Unable to evaluate condition: " + options.until;
+    return trace;
+  }
+
+  ULONG thread_id = 0;
+  interfaces_->system_objects->GetCurrentThreadSystemId(&thread_id);
+
+  const ULONG execution_status = GetExecutionStatusForKind(options.kind);
+  for (ULONG step = 0; step < options.max_steps; step++) {
+    if (should_stop && should_stop()) {
+      trace->stop_reason = "Interrupted";
+      break;
+    }
+
+    hr = interfaces_->control->SetExecutionStatus(execution_status);
+    if (SUCCEEDED(hr)) {
+      hr = interfaces_->control->WaitForEvent(DEBUG_WAIT_DEFAULT, INFINITE);
+    }
+    if (hr != S_OK) {
+      trace->stop_reason = "The target is no longer available";
+      break;
+    }
+
+    TraceEntry entry;
+    entry.kind = options.kind;
+    if (FAILED(interfaces_->registers->GetInstructionOffset(&entry.ip)) ||
+        FAILED(interfaces_->system_objects->GetCurrentThreadSystemId(
+            &entry.thread_id))) {
+      trace->stop_reason = "Unable to read the instruction pointer";
+      break;
+    }
+    trace->buffer.Append(entry);
+
+    // The engine switches to the thread which reported an event. If
+    // that isn't the thread being stepped then something else (a
+    // breakpoint, an exception) interrupted the step.
+    if (entry.thread_id != thread_id) {
+      trace->stop_reason = "Execution stopped on another thread";
+      break;
+    }
+
+    if (!options.until.empty()) {
+      if (!EvaluateCondition(options.until, met)) {
+        trace->stop_reason = "Unable to evaluate condition: " + options.until;
+        break;
+      }
+      if (met) {
+        trace->condition_met = true;
+        trace->stop_reason = "The condition was met";
+        break;
+      }
+    }
+  }
+
+  trace->success = true;
+  return trace;
+}
+
+bool StepTracer::EvaluateCondition(const std::string& condition, bool& met) {
+  DEBUG_VALUE value = {};
+  HRESULT hr = interfaces_->control->Evaluate(
+      condition.c_str(), DEBUG_VALUE_INT64, &value, nullptr);
+  if (FAILED(hr)) {
+    return false;
+  }
+
+  met = value.I64 != 0;
+  return true;
+}
+
+ULONG TraceStore::Add(std::unique_ptr<StepTrace> trace) {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  ULONG id = next_id_++;
+  traces_.emplace(id, std::move(trace));
+  while (traces_.size() > capacity_) {
+    traces_.erase(traces_.begin());
+  }
+  return id;
+}
+
+std::shared_ptr<const StepTrace> TraceStore::Get(ULONG id) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+
+  auto it = traces_.find(id);
+  return it != traces_.end() ? it->second : nullptr;
+}
+
+}  // namespace step_tracer
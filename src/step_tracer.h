@@ -0,0 +1,165 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef STEP_TRACER_H_
+#define STEP_TRACER_H_
+
+#include <dbgeng.h>
+#include <windows.h>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "utils.h"
+
+namespace step_tracer {
+
+enum class StepKind : uint8_t {
+  // p
+  kOver = 0,
+  // t
+  kInto = 1,
+  // tb (step to the next branch)
+  kBranch = 2,
+};
+
+// Parse the step kind names used by the traceSteps
+// MCP tool ("over", "into" or "branch").
+bool ParseStepKind(const std::string& name, StepKind& kind);
+const char* GetStepKindName(StepKind kind);
+
+struct TraceEntry {
+  ULONG64 ip = 0;
+  // The system id of the thread which was current after the step.
+  ULONG thread_id = 0;
+  StepKind kind = StepKind::kOver;
+};
+
+// An append only, delta encoded buffer of trace entries. Each entry
+// starts with a tag byte:
+//
+//   bits 0-1  the step kind
+//   bit  2    the thread changed. The new thread id follows the IP
+//             delta as a LEB128 varint.
+//   bit  3    the IP delta is a small forward delta which is stored
+//             in bits 4-7 of the tag.
+//
+// Unless the small delta bit is set the tag is followed by the IP
+// delta from the previous entry as a zigzag LEB128 varint. Most steps
+// only move forward a few bytes within the same thread so they take a
+// single byte. A checkpoint of the decoder state is kept every
+// kCheckpointInterval entries so that a range of entries can be
+// decoded without decoding the whole trace.
+class TraceBuffer {
+ public:
+  static constexpr size_t kCheckpointInterval = 256;
+
+  void Append(const TraceEntry& entry);
+
+  // Decodes up to count entries starting at index start.
+  std::vector<TraceEntry> Decode(size_t start, size_t count) const;
+
+  size_t GetCount() const { return count_; }
+  size_t GetSizeBytes() const { return bytes_.size(); }
+  const std::vector<uint8_t>& GetBytes() const { return bytes_; }
+
+ private:
+  struct Checkpoint {
+    size_t offset = 0;
+    ULONG64 ip = 0;
+    ULONG thread_id = 0;
+  };
+
+  std::vector<uint8_t> bytes_;
+  std::vector<Checkpoint> checkpoints_;
+  size_t count_ = 0;
+  ULONG64 last_ip_ = 0;
+  ULONG last_thread_id_ = 0;
+};
+
+struct TraceOptions {
+  StepKind kind = StepKind::kOver;
+
+  // The maximum number of steps to execute.
+  ULONG max_steps = 100;
+
+  // A MASM expression which is evaluated after every step. Tracing
+  // stops when it evaluates to a non zero value. Empty to disable.
+  std::string until;
+};
+
+struct StepTrace {
+  bool success = false;
+  std::string error;
+
+  // Why tracing stopped before max_steps (e.g. the condition was met).
+  std::string stop_reason;
+  bool condition_met = false;
+
+  TraceBuffer buffer;
+};
+
+// A compact description of a trace which is returned instead of the
+// individual steps.
+struct TraceSummary {
+  size_t steps = 0;
+  size_t size_bytes = 0;
+  size_t unique_addresses = 0;
+  ULONG64 first_ip = 0;
+  ULONG64 last_ip = 0;
+  ULONG64 min_ip = 0;
+  ULONG64 max_ip = 0;
+  // The number of steps which ended on each thread (by system id).
+  std::map<ULONG, size_t> thread_steps;
+};
+
+TraceSummary Summarize(const TraceBuffer& buffer);
+
+class StepTracer {
+ public:
+  explicit StepTracer(const utils::DebugInterfaces* interfaces);
+
+  // Executes steps with SetExecutionStatus and WaitForEvent and records
+  // the instruction pointer and thread after each one. Must be called on
+  // the thread which owns the debugger engine while the target is broken
+  // in. Tracing stops after options.max_steps, when the until condition
+  // is met, when the current thread changes (another thread hit a
+  // breakpoint or an exception), when the target is no longer available
+  // or when should_stop returns true.
+  std::unique_ptr<StepTrace> Run(
+      const TraceOptions& options,
+      const std::function<bool()>& should_stop = nullptr);
+
+ private:
+  // Returns false if the condition could not be evaluated.
+  bool EvaluateCondition(const std::string& condition, bool& met);
+
+  const utils::DebugInterfaces* interfaces_;
+};
+
+// Keeps the most recent traces so that they can be retrieved by id.
+class TraceStore {
+ public:
+  explicit TraceStore(size_t capacity) : capacity_(capacity) {}
+
+  // Takes ownership of the trace and returns its id. The
+  // oldest trace is discarded when the store is full.
+  ULONG Add(std::unique_ptr<StepTrace> trace);
+
+  // Returns null if the id is unknown or has been discarded.
+  std::shared_ptr<const StepTrace> Get(ULONG id) const;
+
+ private:
+  size_t capacity_;
+  ULONG next_id_ = 1;
+  std::map<ULONG, std::shared_ptr<const StepTrace>> traces_;
+  mutable std::mutex mutex_;
+};
+
+}  // namespace step_tracer
+
+#endif  // STEP_TRACER_H_
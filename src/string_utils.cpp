@@ -0,0 +1,361 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "string_utils.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <filesystem>
+
+namespace utils {
+
+namespace {
+
+bool IsPathSeparator(char c) {
+  return c == '\\' || c == '/';
+}
+
+}  // namespace
+
+std::string Trim(const std::string& str) {
+  size_t start = str.find_first_not_of(" \t\n\r\f\v");
+  size_t end = str.find_last_not_of(" \t\n\r\f\v");
+  return (start == std::string::npos) ? "" : str.substr(start, end - start + 1);
+}
+
+bool ContainsCI(const std::string& string, const std::string& substr) {
+  auto it = std::search(
+      string.begin(), string.end(), substr.begin(), substr.end(),
+      [](char a, char b) { return std::tolower(a) == std::tolower(b); });
+  return it != string.end();
+}
+
+bool IsWholeNumber(const std::string& input_str) {
+  if (input_str.empty()) {
+    return false;
+  }
+  return std::all_of(input_str.begin(), input_str.end(), ::isdigit);
+}
+
+bool ParseUInt32(const std::string& input_str, uint32_t& value) {
+  if (!IsWholeNumber(input_str)) {
+    return false;
+  }
+  const char* end = input_str.data() + input_str.size();
+  std::from_chars_result result =
+      std::from_chars(input_str.data(), end, value);
+  return result.ec == std::errc() && result.ptr == end;
+}
+
+std::string RemoveFileExtension(const std::string& filename) {
+  // Find the last dot in the filename
+  size_t last_dot = filename.find_last_of(".");
+
+  // If no dot is found or it's at the beginning of the string
+  // (hidden file in Unix), return the original string
+  if (last_dot == std::string::npos || last_dot == 0) {
+    return filename;
+  }
+
+  // Check if there's a directory separator after the last dot
+  // If so, this is not an extension but part of a directory name
+  size_t last_separator = filename.find_last_of("/\\");
+  if (last_separator != std::string::npos && last_separator > last_dot) {
+    return filename;
+  }
+
+  // Return the substring before the last dot
+  return filename.substr(0, last_dot);
+}
+
+std::string EscapeQuotes(const std::string& input) {
+  std::string escaped;
+  size_t backslash_count = 0;
+
+  for (size_t i = 0; i < input.length(); ++i) {
+    if (input[i] == '\\') {
+      // Count consecutive backslashes
+      backslash_count++;
+      escaped += '\\';
+    } else if (input[i] == '"') {
+      // If even number of backslashes (including 0), the quote is not escaped
+      if (backslash_count % 2 == 0) {
+        escaped += "\\\"";
+      } else {
+        // Odd number of backslashes means the quote is already escaped
+        escaped += '"';
+      }
+      backslash_count = 0;  // Reset after encountering a quote
+    } else {
+      // Any other character resets the backslash count
+      backslash_count = 0;
+      escaped += input[i];
+    }
+  }
+  return escaped;
+}
+
+std::vector<std::string> SplitString(const std::string& input,
+                                     const std::string& delimiter,
+                                     bool combine_consecutive_delimiters) {
+  std::vector<std::string> tokens;
+  if (input.empty()) {
+    return tokens;
+  }
+
+  size_t start = 0;
+  size_t end = input.find(delimiter);
+
+  while (end != std::string::npos) {
+    if (!combine_consecutive_delimiters || end > start) {
+      tokens.push_back(input.substr(start, end - start));
+    }
+    start = end + delimiter.length();
+    end = input.find(delimiter, start);
+  }
+
+  // Add the last token
+  if (start < input.length()) {
+    tokens.push_back(input.substr(start));
+  }
+
+  return tokens;
+}
+
+std::vector<size_t> GetIndicesFromString(const std::string& input_str) {
+  std::vector<size_t> indices;
+  std::vector<std::string> tokens;
+
+  // First split by spaces
+  std::vector<std::string> space_tokens =
+      utils::SplitString(utils::Trim(input_str), " ");
+
+  for (const auto& token : space_tokens) {
+    // Check if token contains a range (has a hyphen)
+    if (token.find('-') != std::string::npos) {
+      std::vector<std::string> range_parts = utils::SplitString(token, "-");
+      if (range_parts.size() == 2) {
+        int start = std::stoi(range_parts[0]);
+        int end = std::stoi(range_parts[1]);
+
+        // Handle both ascending and descending ranges
+        if (start <= end) {
+          for (int i = start; i <= end; i++) {
+            indices.push_back(i);
+          }
+        } else {
+          for (int i = start; i >= end; i--) {
+            indices.push_back(i);
+          }
+        }
+      } else {
+        // Invalid range format
+        continue;
+      }
+    } else {
+      // Regular number
+      indices.push_back(std::stoi(token));
+    }
+  }
+
+  // Sort and remove duplicates
+  std::sort(indices.begin(), indices.end());
+  indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
+  return indices;
+}
+
+bool ParseNumberOrDottedPair(const std::string& input,
+                             size_t& first_number,
+                             std::optional<size_t>& second_number) {
+  second_number.reset();
+
+  if (input.empty()) {
+    return false;
+  }
+
+  size_t dot_pos = input.find('.');
+  bool has_dot = (dot_pos != std::string::npos);
+
+  if (has_dot) {
+    // Format: "number1.number2"
+    std::string first_part = input.substr(0, dot_pos);
+    std::string second_part = input.substr(dot_pos + 1);
+
+    if (IsWholeNumber(first_part) && IsWholeNumber(second_part)) {
+      first_number = std::stoul(first_part);
+      second_number = std::stoul(second_part);
+      return true;
+    }
+  } else {
+    // Single number format
+    if (IsWholeNumber(input)) {
+      first_number = std::stoul(input);
+      return true;
+    }
+  }
+
+  return false;
+}
+
+std::vector<std::string> ParseCommandLine(const char* cmd_line) {
+  std::vector<std::string> args;
+  if (!cmd_line || !*cmd_line) {
+    return args;
+  }
+
+  bool in_single_quotes = false;
+  std::string current_arg;
+
+  for (const char* p = cmd_line; *p; p++) {
+    if (*p == '\\') {
+      // Count consecutive backslashes
+      int backslash_count = 0;
+      while (p[backslash_count] == '\\') {
+        backslash_count++;
+      }
+
+      // Check what follows the backslashes
+      if (p[backslash_count] == '\'') {
+        // Any backslashes beyond 3 are
+        // treated as regular backslashes
+        while (backslash_count >= 4) {
+          current_arg += '\\';
+          backslash_count--;
+          p++;
+        }
+
+        if (backslash_count == 1) {
+          // p = \'
+          // One backslash followed by a quote escapes
+          // the quote so insert a single quote.
+          current_arg += '\'';
+          p++;  // Move the pointer to the quote character
+        } else if (backslash_count == 2) {
+          // p = \\'
+          // The first backslash escapes the second backslash and
+          // the quote should be seen as an arg delimiter like normal.
+          current_arg += "\\";
+          // Only move the pointer forward by one backslash so that
+          // the quote is processed normally on the next iteration.
+          p++;
+        } else if (backslash_count == 3) {
+          // p = \\\'
+          // The first backlash escapes the second backslash.
+          // The third backslash escapes the single quote.
+          current_arg += "\\'";
+          p += 3;  // Skip the backslashes and the quote
+        }
+      } else {
+        // Backslashes not followed by quote are
+        // treated as regular backslashes
+        for (int i = 0; i < backslash_count; i++) {
+          current_arg += "\\";
+        }
+        p += backslash_count - 1;
+      }
+      continue;
+    }
+
+    if (*p == '\'') {
+      if (!current_arg.empty() || in_single_quotes) {
+        args.push_back(current_arg);
+        current_arg.clear();
+      }
+      in_single_quotes = !in_single_quotes;
+      continue;
+    }
+
+    if (isspace(*p) && !in_single_quotes) {
+      // End of argument
+      if (!current_arg.empty()) {
+        args.push_back(current_arg);
+        current_arg.clear();
+      }
+      continue;
+    }
+
+    // Regular character
+    current_arg += *p;
+  }
+
+  // Add the last argument if exists
+  if (!current_arg.empty()) {
+    args.push_back(current_arg);
+  }
+
+  return args;
+}
+
+std::string ConvertToBreakpointFilePath(const std::string& input_path,
+                                        bool check_exists) {
+  if (input_path.empty()) {
+    return "";
+  }
+
+  // UNC paths (including \\?\ and \\.\ device paths) are not supported
+  if (input_path.size() >= 2 && IsPathSeparator(input_path[0]) &&
+      IsPathSeparator(input_path[1])) {
+    return "";
+  }
+
+  // Only absolute paths with a drive letter are supported
+  if (input_path.size() < 3 ||
+      !std::isalpha(static_cast<unsigned char>(input_path[0])) ||
+      input_path[1] != ':' || !IsPathSeparator(input_path[2])) {
+    return "";
+  }
+
+  // Lexically normalize the path components after the drive
+  std::vector<std::string> components;
+  std::string component;
+  for (size_t i = 3; i <= input_path.size(); i++) {
+    if (i < input_path.size() && !IsPathSeparator(input_path[i])) {
+      component += input_path[i];
+      continue;
+    }
+
+    if (component == "..") {
+      if (!components.empty()) {
+        components.pop_back();
+      }
+    } else if (!component.empty() && component != ".") {
+      components.push_back(component);
+    }
+    component.clear();
+  }
+
+  std::string normalized = input_path.substr(0, 2) + "\\";
+  for (size_t i = 0; i < components.size(); i++) {
+    if (i > 0) {
+      normalized += "\\";
+    }
+    normalized += components[i];
+  }
+
+  try {
+    if (std::filesystem::is_directory(normalized)) {
+      return "";
+    }
+
+    if (check_exists && (!std::filesystem::exists(normalized))) {
+      return "";
+    }
+  } catch (...) {
+    return "";
+  }
+
+  // Double the backslashes
+  std::string doubled_path;
+  for (char c : normalized) {
+    if (c == '\\') {
+      doubled_path += "\\\\";
+    } else {
+      doubled_path += c;
+    }
+  }
+
+  return doubled_path;
+}
+
+}  // namespace utils
@@ -0,0 +1,89 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef STRING_UTILS_H_
+#define STRING_UTILS_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+// String and path helpers which don't depend on the debugger engine.
+// These are part of the portable core library (windbg_ext_core).
+
+namespace utils {
+
+// Remove leading and trailing whitespace from a string
+std::string Trim(const std::string& str);
+
+// Case-insensitive string comparison
+bool ContainsCI(const std::string& string, const std::string& substr);
+
+// Check if a string represents a whole number.
+bool IsWholeNumber(const std::string& input_str);
+
+// Parses a whole number (see IsWholeNumber) which fits in 32 bits.
+// Returns false for anything else, including larger numbers.
+bool ParseUInt32(const std::string& input_str, uint32_t& value);
+
+// Remove the file extension from a filename.
+std::string RemoveFileExtension(const std::string& filename);
+
+// Escape quotes in a string by replacing " with \"
+std::string EscapeQuotes(const std::string& input);
+
+// Splits a string into tokens based on a delimiter.
+// If combine_consecutive_delimiters is true,
+// consecutive delimiters are treated as a single delimiter.
+// For example, "a,,b" with delimiter "," will yield ["a", "b"] if true,
+// and ["a", "", "b"] if false.
+std::vector<std::string> SplitString(
+    const std::string& input,
+    const std::string& delimiter,
+    bool combine_consecutive_delimiters = true);
+
+// Parses a string containing indices and returns a vector of size_t values.
+// Supports multiple formats:
+//  - Individual numbers: "1", "42"
+//  - Space-separated numbers: "1 2 3"
+//  - Ranges with hyphens: "1-5" (expands to 1,2,3,4,5)
+//  - Mixed formats: "1 3-5 7" (expands to 1,3,4,5,7)
+// Handles both ascending (1-5) and descending (5-1) ranges.
+// Returns a vector with all parsed indices, sorted and with duplicates removed.
+std::vector<size_t> GetIndicesFromString(const std::string& input_str);
+
+// Parses a string containing numbers or dotted pairs (e.g., "1", "2.3").
+// Returns true if the input is a valid number or dotted pair.
+// If a dotted pair is found, first_number will contain the first part,
+// and second_number will contain the second part as an optional size_t.
+// If the input is a single number, second_number will be std::nullopt.
+bool ParseNumberOrDottedPair(const std::string& input,
+                             size_t& first_number,
+                             std::optional<size_t>& second_number);
+
+// Parse command-line arguments. Due to the way that WinDbg
+// parses command arguments this implementation uses single
+// quotes to delimit text with spaces that should be considered
+// a single argument. For example:
+//   !myext.cmd 'arg1 arg2' arg3
+// will yield ["arg1 arg2", "arg3"].
+// Double quotes could not be used because if a double quote
+// is present in the command line as the first non-whitespace
+// character, WinDbg will not pass it to the extension.
+// Note: Backslashes are only used for escaping when they
+// are immediately followed by a single quote. A backslash
+// not before a single quote will be treated as a regular character.
+std::vector<std::string> ParseCommandLine(const char* cmdLine);
+
+// Converts a file path to a breakpoint file path which is a path that
+// uses double backslashes for the path separators. The path is treated
+// as a Windows path on every platform: it must start with a drive
+// letter, UNC paths are rejected and "." and ".." are resolved. Paths
+// which are directories on disk are rejected as well.
+std::string ConvertToBreakpointFilePath(const std::string& input_path,
+                                        bool check_exists = false);
+
+}  // namespace utils
+
+#endif  // STRING_UTILS_H_
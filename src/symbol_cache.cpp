@@ -0,0 +1,290 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "symbol_cache.h"
+
+#include <algorithm>
+#include <numeric>
+
+namespace symbol_cache {
+
+namespace {
+
+std::string FormatHex(ULONG64 value) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "0x%llx", value);
+  return buffer;
+}
+
+}  // namespace
+
+std::string SymbolInfo::ToString() const {
+  if (found) {
+    return displacement != 0 ? name + "+" + FormatHex(displacement) : name;
+  }
+  if (!module.empty()) {
+    return module + "+" + FormatHex(displacement);
+  }
+  return FormatHex(address);
+}
+
+SymbolCache::SymbolCache(const utils::DebugInterfaces* interfaces)
+    : interfaces_(interfaces) {}
+
+std::vector<SymbolInfo> SymbolCache::Symbolize(
+    const std::vector<ULONG64>& addresses) {
+  std::vector<SymbolInfo> results(addresses.size());
+  if (addresses.empty()) {
+    return results;
+  }
+
+  DropReloadedSymbols();
+  RefreshModules(false);
+
+  std::vector<size_t> order(addresses.size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return addresses[a] < addresses[b];
+  });
+
+  // The module table is reloaded at most once per batch
+  // for addresses which aren't in any known module.
+  bool refreshed = false;
+  for (size_t index : order) {
+    Resolve(addresses[index], results[index], refreshed);
+  }
+
+  return results;
+}
+
+SymbolInfo SymbolCache::Symbolize(ULONG64 address) {
+  return Symbolize(std::vector<ULONG64>{address})[0];
+}
+
+void SymbolCache::Clear() {
+  modules_.clear();
+  modules_loaded_ = false;
+  module_count_ = 0;
+  process_id_ = 0;
+}
+
+void SymbolCache::OnChangeSymbolState(ULONG flags, ULONG64 argument) {
+  if ((flags & (DEBUG_CSS_LOADS | DEBUG_CSS_UNLOADS)) == 0) {
+    return;
+  }
+  std::lock_guard<std::mutex> lock(reloaded_mutex_);
+  reloaded_bases_.push_back(argument);
+  symbols_reloaded_ = true;
+}
+
+void SymbolCache::DropReloadedSymbols() {
+  if (!symbols_reloaded_.exchange(false)) {
+    return;
+  }
+
+  std::vector<ULONG64> bases;
+  {
+    std::lock_guard<std::mutex> lock(reloaded_mutex_);
+    bases.swap(reloaded_bases_);
+  }
+
+  bool all = std::find(bases.begin(), bases.end(), 0) != bases.end();
+  for (Module& module : modules_) {
+    if (!module.symbols.empty() &&
+        (all || std::find(bases.begin(), bases.end(), module.base) !=
+                    bases.end())) {
+      module.symbols.clear();
+      stats_.symbol_reloads++;
+    }
+  }
+}
+
+void SymbolCache::RefreshModules(bool force) {
+  ULONG loaded = 0;
+  ULONG unloaded = 0;
+  if (FAILED(interfaces_->symbols->GetNumberModules(&loaded, &unloaded))) {
+    loaded = 0;
+  }
+
+  ULONG process_id = 0;
+  interfaces_->system_objects->GetCurrentProcessSystemId(&process_id);
+
+  if (!force && modules_loaded_ && loaded == module_count_ &&
+      process_id == process_id_) {
+    return;
+  }
+
+  stats_.module_refreshes++;
+  modules_loaded_ = true;
+  module_count_ = loaded;
+  process_id_ = process_id;
+
+  std::vector<Module> old_modules = std::move(modules_);
+  modules_.clear();
+  if (loaded == 0) {
+    return;
+  }
+
+  std::vector<DEBUG_MODULE_PARAMETERS> params(loaded);
+  if (FAILED(interfaces_->symbols->GetModuleParameters(loaded, nullptr, 0,
+                                                       params.data()))) {
+    return;
+  }
+
+  for (const DEBUG_MODULE_PARAMETERS& param : params) {
+    if (param.Base == DEBUG_INVALID_OFFSET || param.Size == 0) {
+      continue;
+    }
+
+    Module module;
+    module.base = param.Base;
+    module.size = param.Size;
+
+    char name[MAX_PATH] = {};
+    ULONG name_size = 0;
+    if (SUCCEEDED(interfaces_->symbols->GetModuleNames(
+            DEBUG_ANY_ID, param.Base, nullptr, 0, nullptr, name, sizeof(name),
+            &name_size, nullptr, 0, nullptr))) {
+      module.name = name;
+    } else {
+      module.name = FormatHex(param.Base);
+    }
+
+    // Keep the symbols of modules which didn't change.
+    auto it = std::lower_bound(
+        old_modules.begin(), old_modules.end(), module.base,
+        [](const Module& m, ULONG64 base) { return m.base < base; });
+    if (it != old_modules.end() && it->base == module.base &&
+        it->size == module.size && it->name == module.name) {
+      module.symbols = std::move(it->symbols);
+    }
+
+    modules_.push_back(std::move(module));
+  }
+
+  std::sort(modules_.begin(), modules_.end(),
+            [](const Module& a, const Module& b) { return a.base < b.base; });
+}
+
+SymbolCache::Module* SymbolCache::FindModule(ULONG64 address) {
+  auto it = std::upper_bound(
+      modules_.begin(), modules_.end(), address,
+      [](ULONG64 value, const Module& m) { return value < m.base; });
+  if (it == modules_.begin()) {
+    return nullptr;
+  }
+
+  --it;
+  return address - it->base < it->size ? &*it : nullptr;
+}
+
+const SymbolCache::SymbolRange* SymbolCache::FindSymbol(const Module& module,
+                                                        ULONG64 address) const {
+  auto it = std::upper_bound(
+      module.symbols.begin(), module.symbols.end(), address,
+      [](ULONG64 value, const SymbolRange& range) {
+        return value < range.start;
+      });
+  if (it == module.symbols.begin()) {
+    return nullptr;
+  }
+
+  --it;
+  return address < it->end ? &*it : nullptr;
+}
+
+const SymbolCache::SymbolRange* SymbolCache::LookupSymbol(Module& module,
+                                                          ULONG64 address) {
+  char buffer[1024];
+  ULONG name_size = 0;
+  ULONG64 displacement = 0;
+
+  stats_.engine_calls++;
+  HRESULT hr = interfaces_->symbols->GetNameByOffset(
+      address, buffer, sizeof(buffer), &name_size, &displacement);
+  if (FAILED(hr)) {
+    return nullptr;
+  }
+
+  const ULONG64 module_end = module.base + module.size;
+
+  SymbolRange range;
+  range.name = buffer;
+  range.start = std::max(address - displacement, module.base);
+  range.end = module_end;
+
+  // The symbol ends where the next one starts. If there is no next symbol
+  // in the module this is the last symbol in the module. If the result
+  // doesn't make sense (e.g. aliases at the same address) only cache the
+  // address.
+  char next_buffer[1024];
+  ULONG64 next_displacement = 0;
+  stats_.engine_calls++;
+  hr = interfaces_->symbols->GetNearNameByOffset(
+      address, 1, next_buffer, sizeof(next_buffer), &name_size,
+      &next_displacement);
+  if (SUCCEEDED(hr)) {
+    ULONG64 next_start = address - next_displacement;
+    if (next_start <= address) {
+      range.end = address + 1;
+    } else if (next_start < module_end) {
+      range.end = next_start;
+    }
+  }
+
+  auto it = std::upper_bound(
+      module.symbols.begin(), module.symbols.end(), range.start,
+      [](ULONG64 value, const SymbolRange& r) { return value < r.start; });
+  if (it != module.symbols.end()) {
+    range.end = std::min(range.end, it->start);
+  }
+
+  if (it != module.symbols.begin()) {
+    SymbolRange& previous = *std::prev(it);
+    if (previous.start == range.start && previous.name == range.name) {
+      // Another address of an already cached symbol.
+      previous.end = std::max(previous.end, range.end);
+      return &previous;
+    }
+
+    // The start reported by the engine is authoritative.
+    previous.end = std::min(previous.end, range.start);
+  }
+
+  return &*module.symbols.insert(it, std::move(range));
+}
+
+void SymbolCache::Resolve(ULONG64 address, SymbolInfo& info, bool& refreshed) {
+  info.address = address;
+  stats_.lookups++;
+
+  Module* module = FindModule(address);
+  if (!module && !refreshed) {
+    RefreshModules(true);
+    refreshed = true;
+    module = FindModule(address);
+  }
+  if (!module) {
+    return;
+  }
+
+  info.module = module->name;
+
+  const SymbolRange* range = FindSymbol(*module, address);
+  if (range) {
+    stats_.hits++;
+  } else {
+    stats_.misses++;
+    range = LookupSymbol(*module, address);
+  }
+
+  if (range) {
+    info.found = true;
+    info.name = range->name;
+    info.displacement = address - range->start;
+  } else {
+    info.displacement = address - module->base;
+  }
+}
+
+}  // namespace symbol_cache
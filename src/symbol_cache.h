@@ -0,0 +1,136 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef SYMBOL_CACHE_H_
+#define SYMBOL_CACHE_H_
+
+#include <dbgeng.h>
+#include <windows.h>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "utils.h"
+
+namespace symbol_cache {
+
+struct SymbolInfo {
+  ULONG64 address = 0;
+
+  // The module which contains the address. Empty if the
+  // address is not in any of the loaded modules.
+  std::string module;
+
+  // The symbol name including the module ("chrome!Foo::Bar") and the
+  // offset of the address from the start of the symbol. If there is no
+  // symbol (found is false) the displacement is from the module base.
+  std::string name;
+  ULONG64 displacement = 0;
+  bool found = false;
+
+  // "chrome!Foo::Bar+0x12", "chrome+0x1234" or "0x7ff812340000".
+  std::string ToString() const;
+};
+
+struct SymbolCacheStats {
+  ULONG64 lookups = 0;
+  ULONG64 hits = 0;
+  ULONG64 misses = 0;
+  // The number of calls to IDebugSymbols name lookup methods.
+  ULONG64 engine_calls = 0;
+  ULONG64 module_refreshes = 0;
+  // The number of times the symbols of a module were dropped because
+  // its symbols were reloaded.
+  ULONG64 symbol_reloads = 0;
+};
+
+// Resolves addresses to symbols with a cache of symbol ranges for each
+// module. A lookup finds the module of the address with a binary search
+// of the module table and then the symbol with a binary search of the
+// module's sorted symbol ranges. Only when the address isn't in any of
+// the cached ranges is the engine queried. The range of a symbol spans
+// from its start (found with GetNameByOffset) to the start of the next
+// symbol (found with GetNearNameByOffset) so that every other address in
+// the same function is answered from the cache.
+//
+// The cache does not register any event callbacks itself. The owner
+// must forward ChangeSymbolState notifications to OnChangeSymbolState
+// so that the symbols of a module are dropped when its symbols are
+// loaded or unloaded (e.g. by .reload after fixing the symbol path).
+//
+// Must be used on the thread which owns the debugger engine, except
+// for OnChangeSymbolState which can be called from any thread.
+class SymbolCache {
+ public:
+  explicit SymbolCache(const utils::DebugInterfaces* interfaces);
+
+  // Symbolizes a batch of addresses. The results are in the same order
+  // as the addresses. The addresses are processed sorted so that the
+  // addresses of each module are resolved together.
+  std::vector<SymbolInfo> Symbolize(const std::vector<ULONG64>& addresses);
+  SymbolInfo Symbolize(ULONG64 address);
+
+  // Drops all of the cached modules and symbols.
+  void Clear();
+
+  // Forward IDebugEventCallbacks::ChangeSymbolState here. The symbols
+  // of the module at argument (or of every module if it is 0) are
+  // dropped before the next lookup.
+  void OnChangeSymbolState(ULONG flags, ULONG64 argument);
+
+  const SymbolCacheStats& GetStats() const { return stats_; }
+
+ private:
+  struct SymbolRange {
+    ULONG64 start = 0;
+    // Exclusive.
+    ULONG64 end = 0;
+    std::string name;
+  };
+
+  struct Module {
+    ULONG64 base = 0;
+    ULONG64 size = 0;
+    std::string name;
+    // Sorted by start. The ranges don't overlap.
+    std::vector<SymbolRange> symbols;
+  };
+
+  // Reloads the module table if modules were loaded or unloaded (or
+  // force is true). The symbol ranges of modules which are still loaded
+  // at the same base are kept.
+  void RefreshModules(bool force);
+
+  Module* FindModule(ULONG64 address);
+  const SymbolRange* FindSymbol(const Module& module, ULONG64 address) const;
+
+  // Queries the engine for the symbol which contains the address and
+  // adds its range to the module. Returns null if there is no symbol.
+  const SymbolRange* LookupSymbol(Module& module, ULONG64 address);
+
+  void Resolve(ULONG64 address, SymbolInfo& info, bool& refreshed);
+
+  // Drops the symbols of the modules passed to OnChangeSymbolState.
+  void DropReloadedSymbols();
+
+  const utils::DebugInterfaces* interfaces_;
+
+  // Sorted by base.
+  std::vector<Module> modules_;
+  bool modules_loaded_ = false;
+  ULONG module_count_ = 0;
+  ULONG process_id_ = 0;
+
+  // The bases of the modules whose symbols changed since the last
+  // lookup. 0 stands for all of the modules.
+  std::mutex reloaded_mutex_;
+  std::vector<ULONG64> reloaded_bases_;
+  std::atomic<bool> symbols_reloaded_{false};
+
+  SymbolCacheStats stats_;
+};
+
+}  // namespace symbol_cache
+
+#endif  // SYMBOL_CACHE_H_
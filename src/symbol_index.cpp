@@ -0,0 +1,533 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "symbol_index.h"
+
+#include <dbghelp.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+
+namespace symbol_index {
+
+namespace {
+
+constexpr char kFileMagic[4] = {'W', 'S', 'I', 'X'};
+constexpr uint32_t kFileVersion = 1;
+
+char ToLower(char c) {
+  return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+}
+
+std::string ToLower(const std::string& text) {
+  std::string lower = text;
+  std::transform(lower.begin(), lower.end(), lower.begin(),
+                 [](char c) { return ToLower(c); });
+  return lower;
+}
+
+uint32_t MakeTrigram(const char* text) {
+  return (static_cast<uint32_t>(static_cast<uint8_t>(ToLower(text[0]))) << 16) |
+         (static_cast<uint32_t>(static_cast<uint8_t>(ToLower(text[1]))) << 8) |
+         static_cast<uint32_t>(static_cast<uint8_t>(ToLower(text[2])));
+}
+
+// Returns the unique trigrams of text (sorted).
+std::vector<uint32_t> GetTrigrams(const std::string& text) {
+  std::vector<uint32_t> trigrams;
+  for (size_t i = 0; i + 3 <= text.size(); i++) {
+    trigrams.push_back(MakeTrigram(text.c_str() + i));
+  }
+  std::sort(trigrams.begin(), trigrams.end());
+  trigrams.erase(std::unique(trigrams.begin(), trigrams.end()),
+                 trigrams.end());
+  return trigrams;
+}
+
+// Case insensitive match of a name against a lower case
+// pattern with '*' (any sequence) and '?' (any character).
+bool GlobMatch(const char* name, const char* pattern) {
+  const char* star = nullptr;
+  const char* star_name = nullptr;
+
+  while (*name) {
+    if (*pattern == '*') {
+      star = pattern++;
+      star_name = name;
+    } else if (*pattern == '?' || *pattern == ToLower(*name)) {
+      pattern++;
+      name++;
+    } else if (star) {
+      pattern = star + 1;
+      name = ++star_name;
+    } else {
+      return false;
+    }
+  }
+
+  while (*pattern == '*') {
+    pattern++;
+  }
+  return *pattern == '\0';
+}
+
+// Case insensitive search for a lower case needle.
+size_t FindNoCase(const std::string& haystack, const std::string& needle) {
+  auto it = std::search(haystack.begin(), haystack.end(), needle.begin(),
+                        needle.end(),
+                        [](char a, char b) { return ToLower(a) == b; });
+  return it == haystack.end() && !needle.empty()
+             ? std::string::npos
+             : static_cast<size_t>(it - haystack.begin());
+}
+
+template <typename T>
+void WriteValue(std::ofstream& file, const T& value) {
+  file.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+template <typename T>
+bool ReadValue(std::ifstream& file, T& value) {
+  return static_cast<bool>(
+      file.read(reinterpret_cast<char*>(&value), sizeof(T)));
+}
+
+template <typename T>
+void WriteVector(std::ofstream& file, const std::vector<T>& values) {
+  WriteValue(file, static_cast<uint64_t>(values.size()));
+  file.write(reinterpret_cast<const char*>(values.data()),
+             values.size() * sizeof(T));
+}
+
+template <typename T>
+bool ReadVector(std::ifstream& file, std::vector<T>& values) {
+  uint64_t size = 0;
+  if (!ReadValue(file, size) || size > (1ULL << 32)) {
+    return false;
+  }
+  values.resize(static_cast<size_t>(size));
+  return static_cast<bool>(file.read(reinterpret_cast<char*>(values.data()),
+                                     values.size() * sizeof(T)));
+}
+
+}  // namespace
+
+void SymbolIndex::Add(const std::string& name, ULONG rva) {
+  offsets_.push_back(static_cast<uint32_t>(names_.size()));
+  names_.append(name);
+  names_.push_back('\0');
+  rvas_.push_back(rva);
+}
+
+void SymbolIndex::Finalize() {
+  trigrams_.clear();
+  for (uint32_t id = 0; id < offsets_.size(); id++) {
+    for (uint32_t trigram : GetTrigrams(GetName(id))) {
+      trigrams_[trigram].push_back(id);
+    }
+  }
+}
+
+std::string SymbolIndex::GetName(uint32_t id) const {
+  return std::string(names_.c_str() + offsets_[id]);
+}
+
+bool SymbolIndex::Matches(uint32_t id,
+                          const std::string& pattern,
+                          bool wildcards) const {
+  if (wildcards) {
+    return GlobMatch(names_.c_str() + offsets_[id], pattern.c_str());
+  }
+  return FindNoCase(GetName(id), pattern) != std::string::npos;
+}
+
+int SymbolIndex::Rank(uint32_t id, const std::string& literal) const {
+  std::string name = ToLower(GetName(id));
+  if (name == literal) {
+    return 0;
+  }
+
+  size_t separator = name.rfind("::");
+  std::string last =
+      separator == std::string::npos ? name : name.substr(separator + 2);
+  if (last == literal) {
+    return 1;
+  }
+  if (last.compare(0, literal.size(), literal) == 0) {
+    return 2;
+  }
+  if (last.find(literal) != std::string::npos) {
+    return 3;
+  }
+  return 4;
+}
+
+FindResult SymbolIndex::Find(const std::string& pattern, size_t limit) const {
+  FindResult result;
+  std::string lower = ToLower(pattern);
+  bool wildcards = lower.find_first_of("*?") != std::string::npos;
+
+  // Split the pattern into the literal parts between the wildcards.
+  std::vector<std::string> literals;
+  size_t start = 0;
+  while (start <= lower.size()) {
+    size_t end = lower.find_first_of("*?", start);
+    if (end == std::string::npos) {
+      end = lower.size();
+    }
+    if (end > start) {
+      literals.push_back(lower.substr(start, end - start));
+    }
+    start = end + 1;
+  }
+
+  // Intersect the posting lists starting with the shortest one.
+  std::vector<const std::vector<uint32_t>*> postings;
+  for (const std::string& literal : literals) {
+    for (uint32_t trigram : GetTrigrams(literal)) {
+      auto it = trigrams_.find(trigram);
+      if (it == trigrams_.end()) {
+        return result;
+      }
+      postings.push_back(&it->second);
+    }
+  }
+  std::sort(postings.begin(), postings.end(),
+            [](const auto* a, const auto* b) { return a->size() < b->size(); });
+
+  std::vector<uint32_t> candidates;
+  if (postings.empty()) {
+    // The literals are too short for trigrams so check every name.
+    candidates.resize(offsets_.size());
+    for (uint32_t id = 0; id < candidates.size(); id++) {
+      candidates[id] = id;
+    }
+  } else {
+    candidates = *postings[0];
+    std::vector<uint32_t> intersection;
+    for (size_t i = 1; i < postings.size() && !candidates.empty(); i++) {
+      intersection.clear();
+      std::set_intersection(candidates.begin(), candidates.end(),
+                            postings[i]->begin(), postings[i]->end(),
+                            std::back_inserter(intersection));
+      candidates.swap(intersection);
+    }
+  }
+  result.candidates = candidates.size();
+
+  // Rank by the longest literal part of the pattern.
+  std::string rank_literal;
+  for (const std::string& literal : literals) {
+    if (literal.size() > rank_literal.size()) {
+      rank_literal = literal;
+    }
+  }
+
+  struct RankedId {
+    int rank;
+    uint32_t length;
+    uint32_t id;
+  };
+  std::vector<RankedId> matches;
+  for (uint32_t id : candidates) {
+    if (Matches(id, lower, wildcards)) {
+      uint32_t next = id + 1 < offsets_.size()
+                          ? offsets_[id + 1]
+                          : static_cast<uint32_t>(names_.size());
+      matches.push_back({Rank(id, rank_literal), next - offsets_[id] - 1, id});
+    }
+  }
+  result.total_matches = matches.size();
+
+  auto compare = [this](const RankedId& a, const RankedId& b) {
+    if (a.rank != b.rank) {
+      return a.rank < b.rank;
+    }
+    if (a.length != b.length) {
+      return a.length < b.length;
+    }
+    return strcmp(names_.c_str() + offsets_[a.id],
+                  names_.c_str() + offsets_[b.id]) < 0;
+  };
+  size_t count = std::min(limit, matches.size());
+  std::partial_sort(matches.begin(), matches.begin() + count, matches.end(),
+                    compare);
+
+  for (size_t i = 0; i < count; i++) {
+    result.matches.push_back(
+        {GetName(matches[i].id), rvas_[matches[i].id], matches[i].rank});
+  }
+  return result;
+}
+
+bool SymbolIndex::Save(const std::string& path, const std::string& key) const {
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    return false;
+  }
+
+  file.write(kFileMagic, sizeof(kFileMagic));
+  WriteValue(file, kFileVersion);
+  WriteValue(file, static_cast<uint32_t>(key.size()));
+  file.write(key.data(), key.size());
+
+  WriteValue(file, static_cast<uint64_t>(names_.size()));
+  file.write(names_.data(), names_.size());
+  WriteVector(file, offsets_);
+  WriteVector(file, rvas_);
+
+  WriteValue(file, static_cast<uint64_t>(trigrams_.size()));
+  for (const auto& [trigram, ids] : trigrams_) {
+    WriteValue(file, trigram);
+    WriteVector(file, ids);
+  }
+
+  return static_cast<bool>(file);
+}
+
+bool SymbolIndex::Load(const std::string& path, const std::string& key) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) {
+    return false;
+  }
+
+  char magic[sizeof(kFileMagic)] = {};
+  uint32_t version = 0;
+  uint32_t key_size = 0;
+  if (!file.read(magic, sizeof(magic)) ||
+      !std::equal(magic, magic + sizeof(magic), kFileMagic) ||
+      !ReadValue(file, version) || version != kFileVersion ||
+      !ReadValue(file, key_size) || key_size != key.size()) {
+    return false;
+  }
+
+  std::string file_key(key_size, '\0');
+  if (!file.read(file_key.data(), key_size) || file_key != key) {
+    return false;
+  }
+
+  SymbolIndex loaded;
+  uint64_t names_size = 0;
+  if (!ReadValue(file, names_size) || names_size > (1ULL << 32)) {
+    return false;
+  }
+  loaded.names_.resize(static_cast<size_t>(names_size));
+  if (!file.read(loaded.names_.data(), loaded.names_.size()) ||
+      !ReadVector(file, loaded.offsets_) || !ReadVector(file, loaded.rvas_) ||
+      loaded.offsets_.size() != loaded.rvas_.size()) {
+    return false;
+  }
+  for (uint32_t offset : loaded.offsets_) {
+    if (offset >= loaded.names_.size()) {
+      return false;
+    }
+  }
+  if (!loaded.names_.empty() && loaded.names_.back() != '\0') {
+    return false;
+  }
+
+  uint64_t trigram_count = 0;
+  if (!ReadValue(file, trigram_count)) {
+    return false;
+  }
+  for (uint64_t i = 0; i < trigram_count; i++) {
+    uint32_t trigram = 0;
+    std::vector<uint32_t> ids;
+    if (!ReadValue(file, trigram) || !ReadVector(file, ids)) {
+      return false;
+    }
+    for (uint32_t id : ids) {
+      if (id >= loaded.offsets_.size()) {
+        return false;
+      }
+    }
+    loaded.trigrams_.emplace(trigram, std::move(ids));
+  }
+
+  *this = std::move(loaded);
+  return true;
+}
+
+std::string ModuleKey::ToString() const {
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "_%08x_%08x_%08x", time_date_stamp,
+           checksum, size);
+  std::string key = ToLower(module) + buffer;
+  if (HasPdb()) {
+    key += "_" + pdb;
+  }
+  return key;
+}
+
+namespace {
+
+// Formats the PDB identity like the directories of a symbol server.
+std::string FormatPdbIdentity(const GUID& signature, DWORD age) {
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer),
+           "%08lX%04X%04X%02X%02X%02X%02X%02X%02X%02X%02X%lX",
+           static_cast<unsigned long>(signature.Data1), signature.Data2,
+           signature.Data3, signature.Data4[0], signature.Data4[1],
+           signature.Data4[2], signature.Data4[3], signature.Data4[4],
+           signature.Data4[5], signature.Data4[6], signature.Data4[7],
+           static_cast<unsigned long>(age));
+  return buffer;
+}
+
+// Returns the identity of the PDB the symbols of the module were
+// loaded from or an empty string if it isn't available.
+std::string GetPdbIdentity(const utils::DebugInterfaces* interfaces,
+                           ULONG64 base) {
+  IDebugAdvanced2* advanced = nullptr;
+  if (FAILED(interfaces->client->QueryInterface(
+          __uuidof(IDebugAdvanced2), reinterpret_cast<void**>(&advanced))) ||
+      !advanced) {
+    return "";
+  }
+
+  IMAGEHLP_MODULEW64 info = {};
+  info.SizeOfStruct = sizeof(info);
+  HRESULT hr = advanced->GetSymbolInformation(
+      DEBUG_SYMINFO_IMAGEHLP_MODULEW64, base, 0, &info, sizeof(info), nullptr,
+      nullptr, 0, nullptr);
+  advanced->Release();
+
+  const GUID kNoSignature = {};
+  if (FAILED(hr) || (info.PdbSig70 == kNoSignature && info.PdbSig == 0)) {
+    return "";
+  }
+  if (info.PdbSig70 == kNoSignature) {
+    // Older PDBs only have a 32-bit signature.
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%08lX%lX",
+             static_cast<unsigned long>(info.PdbSig),
+             static_cast<unsigned long>(info.PdbAge));
+    return buffer;
+  }
+  return FormatPdbIdentity(info.PdbSig70, info.PdbAge);
+}
+
+}  // namespace
+
+bool GetModuleKey(const utils::DebugInterfaces* interfaces,
+                  const std::string& module,
+                  ULONG64& base,
+                  ModuleKey& key) {
+  ULONG index = 0;
+  if (FAILED(interfaces->symbols->GetModuleByModuleName(module.c_str(), 0,
+                                                         &index, &base))) {
+    return false;
+  }
+
+  DEBUG_MODULE_PARAMETERS params = {};
+  if (FAILED(interfaces->symbols->GetModuleParameters(1, &base, 0, &params))) {
+    return false;
+  }
+
+  key.module = module;
+  key.time_date_stamp = params.TimeDateStamp;
+  key.checksum = params.Checksum;
+  key.size = params.Size;
+  key.pdb = (params.SymbolType == DEBUG_SYMTYPE_PDB)
+                ? GetPdbIdentity(interfaces, base)
+                : "";
+  return true;
+}
+
+HRESULT BuildFromEngine(const utils::DebugInterfaces* interfaces,
+                        const std::string& module,
+                        ULONG64 base,
+                        SymbolIndex& index) {
+  ULONG64 handle = 0;
+  std::string pattern = module + "!*";
+  HRESULT hr = interfaces->symbols->StartSymbolMatch(pattern.c_str(), &handle);
+  if (FAILED(hr)) {
+    return hr;
+  }
+
+  // Names which don't fit in the buffer are truncated (S_FALSE).
+  char buffer[4096];
+  ULONG match_size = 0;
+  ULONG64 offset = 0;
+  while (SUCCEEDED(interfaces->symbols->GetNextSymbolMatch(
+      handle, buffer, sizeof(buffer), &match_size, &offset))) {
+    const char* name = strchr(buffer, '!');
+    name = name ? name + 1 : buffer;
+    index.Add(name, static_cast<ULONG>(offset - base));
+  }
+
+  interfaces->symbols->EndSymbolMatch(handle);
+  index.Finalize();
+  return S_OK;
+}
+
+SymbolIndexStore::SymbolIndexStore(const utils::DebugInterfaces* interfaces,
+                                   const std::string& directory)
+    : interfaces_(interfaces), directory_(directory) {}
+
+SymbolIndexStore::Lookup SymbolIndexStore::GetIndex(const std::string& module) {
+  Lookup lookup;
+
+  ModuleKey key;
+  if (!GetModuleKey(interfaces_, module, lookup.base, key)) {
+    lookup.error = "Module not found: " + module;
+    return lookup;
+  }
+
+  if (key.HasPdb()) {
+    std::string key_string = key.ToString();
+    auto it = indexes_.find(key_string);
+    if (it != indexes_.end()) {
+      lookup.index = it->second.get();
+      lookup.source = "memory";
+      return lookup;
+    }
+
+    auto index = std::make_unique<SymbolIndex>();
+    std::filesystem::path path =
+        std::filesystem::path(directory_) / (key_string + ".symidx");
+    if (index->Load(path.string(), key_string)) {
+      lookup.index = index.get();
+      lookup.source = "disk";
+      indexes_.emplace(key_string, std::move(index));
+      return lookup;
+    }
+  }
+
+  auto index = std::make_unique<SymbolIndex>();
+  HRESULT hr = BuildFromEngine(interfaces_, module, lookup.base, *index);
+  if (FAILED(hr) || index->GetSymbolCount() == 0) {
+    lookup.error = "No symbols found for module " + module +
+                   ". Make sure the symbols are loaded (ld " + module + ").";
+    return lookup;
+  }
+  lookup.index = index.get();
+  lookup.source = "built";
+
+  // Enumerating the symbols loads deferred symbols, after which the
+  // symbol type and the PDB are known.
+  if (!key.HasPdb()) {
+    GetModuleKey(interfaces_, module, lookup.base, key);
+  }
+  if (!key.HasPdb()) {
+    lookup.warning = "The symbols of " + module +
+                     " weren't loaded from a PDB so the results may be "
+                     "incomplete. Fix the symbol path and run .reload.";
+    uncached_index_ = std::move(index);
+    return lookup;
+  }
+
+  // Failing to save only means that the index is rebuilt next session.
+  std::string key_string = key.ToString();
+  std::filesystem::path path =
+      std::filesystem::path(directory_) / (key_string + ".symidx");
+  std::error_code ec;
+  std::filesystem::create_directories(directory_, ec);
+  index->Save(path.string(), key_string);
+  indexes_[key_string] = std::move(index);
+  return lookup;
+}
+
+}  // namespace symbol_index
@@ -0,0 +1,156 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef SYMBOL_INDEX_H_
+#define SYMBOL_INDEX_H_
+
+#include <dbgeng.h>
+#include <windows.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "utils.h"
+
+namespace symbol_index {
+
+struct SymbolMatch {
+  // The symbol name without the module ("Foo::Bar").
+  std::string name;
+
+  // The offset of the symbol from the module base.
+  ULONG rva = 0;
+
+  // Lower is better. See SymbolIndex::Find.
+  int rank = 0;
+};
+
+struct FindResult {
+  // The best matches sorted by rank, then by length and then by name.
+  std::vector<SymbolMatch> matches;
+
+  // The total number of matching symbols (may be more than matches).
+  size_t total_matches = 0;
+
+  // The number of symbols which had to be compared with the pattern
+  // after the trigram filter.
+  size_t candidates = 0;
+};
+
+// An in memory index of the symbol names of a module. Names are found
+// by intersecting the posting lists of the trigrams (three consecutive
+// lower case characters) of the literal parts of the pattern and then
+// comparing only the remaining candidates with the pattern. All
+// comparisons are case insensitive.
+class SymbolIndex {
+ public:
+  // Adds a symbol. Call Finalize after adding all of the symbols.
+  void Add(const std::string& name, ULONG rva);
+
+  // Builds the trigram posting lists.
+  void Finalize();
+
+  // Finds the symbols matching pattern. The pattern can contain the
+  // wildcards '*' and '?' (as with the x command). A pattern without
+  // wildcards matches any name which contains it. Matches are ranked:
+  //   0 - the whole name matches the pattern
+  //   1 - the last component of the name ("Bar" of "Foo::Bar") is
+  //       the pattern
+  //   2 - the last component starts with the pattern
+  //   3 - the last component contains the pattern
+  //   4 - the pattern only matches the rest of the name
+  FindResult Find(const std::string& pattern, size_t limit) const;
+
+  size_t GetSymbolCount() const { return rvas_.size(); }
+
+  // The index is saved with the key of the module that it was built
+  // from and Load fails if the key doesn't match.
+  bool Save(const std::string& path, const std::string& key) const;
+  bool Load(const std::string& path, const std::string& key);
+
+ private:
+  std::string GetName(uint32_t id) const;
+  bool Matches(uint32_t id, const std::string& pattern, bool wildcards) const;
+  int Rank(uint32_t id, const std::string& literal) const;
+
+  // The names separated by '\0'. offsets_[i] is the start of name i.
+  std::string names_;
+  std::vector<uint32_t> offsets_;
+  std::vector<ULONG> rvas_;
+
+  // Trigram to the sorted ids of the names which contain it.
+  std::unordered_map<uint32_t, std::vector<uint32_t>> trigrams_;
+};
+
+// Identifies a specific build of a module and of its PDB. Used as the
+// name of the file the index is saved in so that the index is only
+// reused for exactly the same binary and symbols.
+struct ModuleKey {
+  std::string module;
+  ULONG time_date_stamp = 0;
+  ULONG checksum = 0;
+  ULONG size = 0;
+
+  // The signature GUID and age of the PDB as used by symbol servers
+  // (e.g. "1E2F3A4B5C6D7E8F90A1B2C3D4E5F6071"). Empty unless the
+  // symbols of the module were loaded from a PDB.
+  std::string pdb;
+
+  bool HasPdb() const { return !pdb.empty(); }
+
+  // e.g. "chrome_65f1a2b3_00000000_1c2d3000_1E2F...F6071"
+  std::string ToString() const;
+};
+
+// Looks up the base and key of a loaded module by name. The PDB
+// identity is read with IDebugAdvanced2::GetSymbolInformation.
+bool GetModuleKey(const utils::DebugInterfaces* interfaces,
+                  const std::string& module,
+                  ULONG64& base,
+                  ModuleKey& key);
+
+// Enumerates all of the symbols of the module with StartSymbolMatch
+// and GetNextSymbolMatch. Must be run on the engine thread.
+HRESULT BuildFromEngine(const utils::DebugInterfaces* interfaces,
+                        const std::string& module,
+                        ULONG64 base,
+                        SymbolIndex& index);
+
+// Returns the index of a module, loading it from the directory or
+// building (and saving) it the first time a module is used. Only the
+// indexes of modules with PDB symbols are kept. The symbols found
+// without a PDB (e.g. only the exports) are incomplete and would hide
+// the full symbols after the symbol path is fixed and the module is
+// reloaded, so their index is rebuilt each time.
+class SymbolIndexStore {
+ public:
+  SymbolIndexStore(const utils::DebugInterfaces* interfaces,
+                   const std::string& directory);
+
+  struct Lookup {
+    const SymbolIndex* index = nullptr;
+    ULONG64 base = 0;
+    // "memory", "disk" or "built".
+    std::string source;
+    // Set when the module has no PDB symbols.
+    std::string warning;
+    std::string error;
+  };
+
+  Lookup GetIndex(const std::string& module);
+
+ private:
+  const utils::DebugInterfaces* interfaces_;
+  std::string directory_;
+  std::map<std::string, std::unique_ptr<SymbolIndex>> indexes_;
+
+  // The last index of a module without PDB symbols.
+  std::unique_ptr<SymbolIndex> uncached_index_;
+};
+
+}  // namespace symbol_index
+
+#endif  // SYMBOL_INDEX_H_
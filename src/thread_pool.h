@@ -0,0 +1,55 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef THREAD_POOL_H_
+#define THREAD_POOL_H_
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+namespace thread_pool {
+
+// A fixed number of worker threads which run tasks in the order that
+// they were submitted. The destructor runs the tasks which are still
+// queued and then joins the workers.
+class ThreadPool {
+ public:
+  // 0 uses the number of hardware threads.
+  explicit ThreadPool(size_t thread_count = 0);
+  ThreadPool(const ThreadPool&) = delete;
+  ThreadPool& operator=(const ThreadPool&) = delete;
+  ~ThreadPool();
+
+  // Queues function and returns a future for its result.
+  template <typename Function>
+  auto Submit(Function function) -> std::future<decltype(function())> {
+    using Result = decltype(function());
+    auto task =
+        std::make_shared<std::packaged_task<Result()>>(std::move(function));
+    std::future<Result> result = task->get_future();
+    Post([task]() { (*task)(); });
+    return result;
+  }
+
+  size_t GetThreadCount() const { return workers_.size(); }
+
+ private:
+  void Post(std::function<void()> task);
+  void RunWorker();
+
+  std::vector<std::thread> workers_;
+  std::queue<std::function<void()>> tasks_;
+  std::mutex mutex_;
+  std::condition_variable tasks_available_;
+  bool stopping_ = false;
+};
+
+}  // namespace thread_pool
+
+#endif  // THREAD_POOL_H_
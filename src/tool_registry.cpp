@@ -0,0 +1,136 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "tool_registry.h"
+
+#include <utility>
+
+#include "json_writer.h"
+
+namespace tool_registry {
+
+bool ToolRegistry::Register(JSON definition) {
+  if (!definition.is_object() || !definition.contains("name") ||
+      !definition["name"].is_string()) {
+    return false;
+  }
+
+  Tool tool;
+  tool.schema =
+      tool_schema::ToolSchema(definition.value("inputSchema", JSON::object()));
+  tool.definition = std::move(definition);
+  const std::string& name = tool.definition["name"].get_ref<const std::string&>();
+
+  std::unique_lock<std::mutex> lock(mutex_);
+  Tool* existing = Find(name);
+  if (existing) {
+    // A replaced tool keeps its position and whether it is enabled.
+    tool.enabled = existing->enabled;
+    *existing = std::move(tool);
+  } else {
+    tools_.push_back(std::move(tool));
+  }
+  OnChanged(lock);
+  return true;
+}
+
+bool ToolRegistry::Unregister(const std::string& name) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (auto it = tools_.begin(); it != tools_.end(); ++it) {
+    if (it->definition["name"] == name) {
+      tools_.erase(it);
+      OnChanged(lock);
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ToolRegistry::SetEnabled(const std::string& name, bool enabled) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  Tool* tool = Find(name);
+  if (!tool) {
+    return false;
+  }
+  if (tool->enabled != enabled) {
+    tool->enabled = enabled;
+    OnChanged(lock);
+  }
+  return true;
+}
+
+bool ToolRegistry::IsAvailable(const std::string& name) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const Tool* tool = Find(name);
+  return tool && tool->enabled;
+}
+
+std::string ToolRegistry::Validate(const std::string& name,
+                                   const JSON& arguments) const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  const Tool* tool = Find(name);
+  return tool ? tool->schema.Validate(arguments) : "";
+}
+
+std::shared_ptr<const std::string> ToolRegistry::GetToolsList() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!tools_list_) {
+    JSON tools = JSON::array();
+    for (const Tool& tool : tools_) {
+      if (tool.enabled) {
+        tools.push_back(tool.definition);
+      }
+    }
+
+    auto tools_list = std::make_shared<std::string>();
+    json_writer::AppendJson(*tools_list, JSON{{"tools", std::move(tools)}});
+    tools_list_ = std::move(tools_list);
+  }
+  return tools_list_;
+}
+
+uint64_t ToolRegistry::GetVersion() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return version_;
+}
+
+std::vector<ToolInfo> ToolRegistry::GetTools() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::vector<ToolInfo> tools;
+  for (const Tool& tool : tools_) {
+    tools.push_back({tool.definition["name"].get<std::string>(), tool.enabled});
+  }
+  return tools;
+}
+
+void ToolRegistry::SetChangedCallback(ChangedCallback callback) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  on_changed_ = std::move(callback);
+}
+
+ToolRegistry::Tool* ToolRegistry::Find(const std::string& name) {
+  for (Tool& tool : tools_) {
+    if (tool.definition["name"].get_ref<const std::string&>() == name) {
+      return &tool;
+    }
+  }
+  return nullptr;
+}
+
+const ToolRegistry::Tool* ToolRegistry::Find(const std::string& name) const {
+  return const_cast<ToolRegistry*>(this)->Find(name);
+}
+
+void ToolRegistry::OnChanged(std::unique_lock<std::mutex>& lock) {
+  version_++;
+  tools_list_.reset();
+  uint64_t version = version_;
+  ChangedCallback on_changed = on_changed_;
+  lock.unlock();
+
+  if (on_changed) {
+    on_changed(version);
+  }
+}
+
+}  // namespace tool_registry
@@ -0,0 +1,96 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef TOOL_REGISTRY_H_
+#define TOOL_REGISTRY_H_
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+#include "tool_schema.h"
+
+using JSON = nlohmann::json;
+
+// The tools of the MCP server. Each tool is registered with its
+// tools/list definition and its input schema is compiled when it is
+// registered. The serialized tools/list result is built on the first
+// request after a change and shared by every request until the next
+// change, so clients which list the tools on every turn don't rebuild
+// and reserialize the definitions. Every change increments the
+// version and calls the changed callback, which the server uses to
+// send notifications/tools/list_changed. Thread-safe.
+namespace tool_registry {
+
+struct ToolInfo {
+  std::string name;
+  bool enabled = true;
+};
+
+class ToolRegistry {
+ public:
+  using ChangedCallback = std::function<void(uint64_t version)>;
+
+  // Adds a tool or replaces the tool with the same name. definition
+  // is an entry of the tools/list result (name, description and
+  // inputSchema). Returns false if it doesn't have a string name.
+  bool Register(JSON definition);
+
+  // Returns false if there is no tool with this name.
+  bool Unregister(const std::string& name);
+
+  // Disabled tools are left out of tools/list and can't be called.
+  // Returns false if there is no tool with this name.
+  bool SetEnabled(const std::string& name, bool enabled);
+
+  // Returns true if the tool is registered and enabled.
+  bool IsAvailable(const std::string& name) const;
+
+  // Returns an empty string if the arguments of a call to the tool
+  // are valid or a description of the first problem. Tools which
+  // aren't registered aren't validated.
+  std::string Validate(const std::string& name, const JSON& arguments) const;
+
+  // The serialized tools/list result ({"tools": [...]}) with the
+  // enabled tools in the order they were registered.
+  std::shared_ptr<const std::string> GetToolsList();
+
+  // Incremented by every change to the tools.
+  uint64_t GetVersion() const;
+
+  std::vector<ToolInfo> GetTools() const;
+
+  // Called after each change, without the lock held.
+  void SetChangedCallback(ChangedCallback callback);
+
+ private:
+  struct Tool {
+    JSON definition;
+    tool_schema::ToolSchema schema;
+    bool enabled = true;
+  };
+
+  // Must be called with mutex_ held.
+  Tool* Find(const std::string& name);
+  const Tool* Find(const std::string& name) const;
+
+  // Increments the version, drops the cached tools/list and calls the
+  // changed callback. lock must hold mutex_ and is released before
+  // the callback is called.
+  void OnChanged(std::unique_lock<std::mutex>& lock);
+
+  mutable std::mutex mutex_;
+  std::vector<Tool> tools_;
+  uint64_t version_ = 0;
+  // Null until the first GetToolsList after a change.
+  std::shared_ptr<const std::string> tools_list_;
+  ChangedCallback on_changed_;
+};
+
+}  // namespace tool_registry
+
+#endif  // TOOL_REGISTRY_H_
@@ -0,0 +1,162 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "tool_schema.h"
+
+#include <algorithm>
+
+namespace tool_schema {
+
+namespace {
+
+ValueType ParseType(const JSON& schema) {
+  if (!schema.is_object() || !schema.contains("type") ||
+      !schema["type"].is_string()) {
+    return ValueType::kAny;
+  }
+
+  const std::string& type = schema["type"].get_ref<const std::string&>();
+  if (type == "string") {
+    return ValueType::kString;
+  } else if (type == "integer") {
+    return ValueType::kInteger;
+  } else if (type == "number") {
+    return ValueType::kNumber;
+  } else if (type == "boolean") {
+    return ValueType::kBoolean;
+  } else if (type == "array") {
+    return ValueType::kArray;
+  } else if (type == "object") {
+    return ValueType::kObject;
+  }
+  return ValueType::kAny;
+}
+
+const char* GetTypeName(ValueType type) {
+  switch (type) {
+    case ValueType::kString:
+      return "a string";
+    case ValueType::kInteger:
+      return "an integer";
+    case ValueType::kNumber:
+      return "a number";
+    case ValueType::kBoolean:
+      return "a boolean";
+    case ValueType::kArray:
+      return "an array";
+    case ValueType::kObject:
+      return "an object";
+    default:
+      return "any value";
+  }
+}
+
+bool HasType(const JSON& value, ValueType type) {
+  switch (type) {
+    case ValueType::kString:
+      return value.is_string();
+    case ValueType::kInteger:
+      // Unlike JSON Schema, 10.0 isn't an integer because the tool
+      // handlers read integer arguments as JSON integers.
+      return value.is_number_integer();
+    case ValueType::kNumber:
+      return value.is_number();
+    case ValueType::kBoolean:
+      return value.is_boolean();
+    case ValueType::kArray:
+      return value.is_array();
+    case ValueType::kObject:
+      return value.is_object();
+    default:
+      return true;
+  }
+}
+
+}  // namespace
+
+ToolSchema::ToolSchema(const JSON& input_schema) {
+  if (!input_schema.is_object()) {
+    return;
+  }
+
+  if (input_schema.contains("properties") &&
+      input_schema["properties"].is_object()) {
+    const JSON& properties = input_schema["properties"];
+    for (auto it = properties.begin(); it != properties.end(); ++it) {
+      const JSON& schema = it.value();
+      Property property;
+      property.name = it.key();
+      property.type = ParseType(schema);
+      if (property.type == ValueType::kArray && schema.contains("items")) {
+        property.item_type = ParseType(schema["items"]);
+      }
+      if (property.type == ValueType::kString && schema.contains("enum") &&
+          schema["enum"].is_array()) {
+        for (const JSON& value : schema["enum"]) {
+          if (value.is_string()) {
+            property.allowed_values.push_back(value.get<std::string>());
+          }
+        }
+      }
+      properties_.push_back(std::move(property));
+    }
+  }
+
+  if (input_schema.contains("required") &&
+      input_schema["required"].is_array()) {
+    for (const JSON& name : input_schema["required"]) {
+      if (name.is_string()) {
+        required_.push_back(name.get<std::string>());
+      }
+    }
+  }
+}
+
+std::string ToolSchema::Validate(const JSON& arguments) const {
+  if (!arguments.is_object()) {
+    return "The arguments must be an object";
+  }
+
+  for (const std::string& name : required_) {
+    if (!arguments.contains(name)) {
+      return "Missing required argument: " + name;
+    }
+  }
+
+  for (const Property& property : properties_) {
+    auto it = arguments.find(property.name);
+    if (it == arguments.end()) {
+      continue;
+    }
+
+    if (!HasType(*it, property.type)) {
+      return property.name + " must be " + GetTypeName(property.type);
+    }
+
+    if (!property.allowed_values.empty() &&
+        std::find(property.allowed_values.begin(),
+                  property.allowed_values.end(),
+                  it->get_ref<const std::string&>()) ==
+            property.allowed_values.end()) {
+      std::string values;
+      for (const std::string& value : property.allowed_values) {
+        values += (values.empty() ? "" : ", ") + value;
+      }
+      return property.name + " must be one of: " + values;
+    }
+
+    if (property.type == ValueType::kArray &&
+        property.item_type != ValueType::kAny) {
+      for (const JSON& item : *it) {
+        if (!HasType(item, property.item_type)) {
+          return "Each item of " + property.name + " must be " +
+                 GetTypeName(property.item_type);
+        }
+      }
+    }
+  }
+
+  return "";
+}
+
+}  // namespace tool_schema
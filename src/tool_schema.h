@@ -0,0 +1,59 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef TOOL_SCHEMA_H_
+#define TOOL_SCHEMA_H_
+
+#include <string>
+#include <vector>
+
+#include "json.hpp"
+
+using JSON = nlohmann::json;
+
+// Validation of the arguments of MCP tool calls. The inputSchema of
+// each tool is compiled once into a list of checks so that a call
+// doesn't walk the schema JSON. Only the subset of JSON Schema which
+// the tool definitions use is supported: the type of each property,
+// string enums, the type of array items and required properties.
+// Anything else in a schema (e.g. anyOf) accepts any value, and
+// arguments which aren't in the schema are allowed. Integral floats
+// (e.g. 10.0) aren't integers.
+namespace tool_schema {
+
+enum class ValueType {
+  kAny,
+  kString,
+  kInteger,
+  kNumber,
+  kBoolean,
+  kArray,
+  kObject,
+};
+
+class ToolSchema {
+ public:
+  ToolSchema() = default;
+  explicit ToolSchema(const JSON& input_schema);
+
+  // Returns an empty string if arguments are valid or a description
+  // of the first problem.
+  std::string Validate(const JSON& arguments) const;
+
+ private:
+  struct Property {
+    std::string name;
+    ValueType type = ValueType::kAny;
+    // The type of the items of an array.
+    ValueType item_type = ValueType::kAny;
+    // The values of a string enum.
+    std::vector<std::string> allowed_values;
+  };
+
+  std::vector<Property> properties_;
+  std::vector<std::string> required_;
+};
+
+}  // namespace tool_schema
+
+#endif  // TOOL_SCHEMA_H_
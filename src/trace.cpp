@@ -0,0 +1,409 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "trace.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace trace {
+
+std::atomic<bool> g_enabled{false};
+
+namespace {
+
+// The buffers of threads which have exited are kept (so their events
+// can still be exported) until there are more than this many buffers.
+constexpr size_t kMaxThreadBuffers = 64;
+
+struct Event {
+  const char* name;
+  char detail[kMaxDetailLength + 1];
+  uint64_t start_ns;
+  uint64_t duration_ns;
+};
+
+struct ThreadBuffer {
+  std::mutex mutex;
+  // Allocated on the first recorded event.
+  std::vector<Event> events;
+  // The total number of events recorded into this buffer. The next
+  // event goes into events[next % kEventsPerThread].
+  uint64_t next = 0;
+  uint64_t thread_id = 0;
+  std::string name;
+  bool alive = true;
+};
+
+struct Registry {
+  std::mutex mutex;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+};
+
+Registry& GetRegistry() {
+  static Registry registry;
+  return registry;
+}
+
+uint64_t GetCurrentThreadIdForTrace() {
+#ifdef _WIN32
+  return GetCurrentThreadId();
+#elif defined(__linux__)
+  return static_cast<uint64_t>(syscall(SYS_gettid));
+#else
+  return std::hash<std::thread::id>{}(std::this_thread::get_id());
+#endif
+}
+
+uint64_t GetCurrentProcessIdForTrace() {
+#ifdef _WIN32
+  return GetCurrentProcessId();
+#else
+  return static_cast<uint64_t>(getpid());
+#endif
+}
+
+// Registers the buffer of the current thread on first use and marks
+// it as dead when the thread exits.
+struct ThreadBufferOwner {
+  std::shared_ptr<ThreadBuffer> buffer;
+
+  ~ThreadBufferOwner() {
+    if (buffer) {
+      std::lock_guard<std::mutex> lock(buffer->mutex);
+      buffer->alive = false;
+    }
+  }
+};
+
+ThreadBuffer& GetThreadBuffer() {
+  thread_local ThreadBufferOwner owner;
+  if (owner.buffer) {
+    return *owner.buffer;
+  }
+
+  auto buffer = std::make_shared<ThreadBuffer>();
+  buffer->thread_id = GetCurrentThreadIdForTrace();
+
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  if (registry.buffers.size() >= kMaxThreadBuffers) {
+    auto dead = std::find_if(registry.buffers.begin(), registry.buffers.end(),
+                             [](const std::shared_ptr<ThreadBuffer>& b) {
+                               std::lock_guard<std::mutex> lock(b->mutex);
+                               return !b->alive;
+                             });
+    if (dead != registry.buffers.end()) {
+      registry.buffers.erase(dead);
+    }
+  }
+  registry.buffers.push_back(buffer);
+
+  owner.buffer = std::move(buffer);
+  return *owner.buffer;
+}
+
+void CopyDetail(char* destination, const char* detail, size_t length) {
+  // A cut detail ends before the UTF-8 character which doesn't fit.
+  if (length > kMaxDetailLength) {
+    length = kMaxDetailLength;
+    while (length > 0 && (static_cast<unsigned char>(detail[length]) & 0xC0) ==
+                             0x80) {
+      length--;
+    }
+  }
+  std::memcpy(destination, detail, length);
+  destination[length] = '\0';
+}
+
+}  // namespace
+
+void SetEnabled(bool enabled) {
+  g_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+void Clear() {
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+
+  auto& buffers = registry.buffers;
+  buffers.erase(std::remove_if(buffers.begin(), buffers.end(),
+                               [](const std::shared_ptr<ThreadBuffer>& b) {
+                                 std::lock_guard<std::mutex> lock(b->mutex);
+                                 b->next = 0;
+                                 return !b->alive;
+                               }),
+                buffers.end());
+}
+
+uint64_t NowNs() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now().time_since_epoch())
+      .count();
+}
+
+void Record(const char* name,
+            const char* detail,
+            uint64_t start_ns,
+            uint64_t end_ns) {
+  if (!IsEnabled()) {
+    return;
+  }
+
+  ThreadBuffer& buffer = GetThreadBuffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  if (buffer.events.empty()) {
+    buffer.events.resize(kEventsPerThread);
+  }
+
+  Event& event = buffer.events[buffer.next % kEventsPerThread];
+  event.name = name;
+  CopyDetail(event.detail, detail ? detail : "",
+             detail ? std::strlen(detail) : 0);
+  event.start_ns = start_ns;
+  event.duration_ns = end_ns > start_ns ? end_ns - start_ns : 0;
+  buffer.next++;
+}
+
+void SetThreadName(const std::string& name) {
+  ThreadBuffer& buffer = GetThreadBuffer();
+  std::lock_guard<std::mutex> lock(buffer.mutex);
+  buffer.name = name;
+}
+
+void Span::SetDetail(const char* detail, size_t length) {
+  CopyDetail(detail_, detail, length);
+}
+
+TraceStats GetStats() {
+  TraceStats stats;
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (const auto& buffer : registry.buffers) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    stats.threads++;
+    stats.events += std::min<uint64_t>(buffer->next, kEventsPerThread);
+    if (buffer->next > kEventsPerThread) {
+      stats.dropped += buffer->next - kEventsPerThread;
+    }
+  }
+  return stats;
+}
+
+JSON GetEvents(const std::string& category) {
+  JSON events = JSON::array();
+  uint64_t pid = GetCurrentProcessIdForTrace();
+
+  Registry& registry = GetRegistry();
+  std::lock_guard<std::mutex> lock(registry.mutex);
+  for (const auto& buffer : registry.buffers) {
+    std::lock_guard<std::mutex> buffer_lock(buffer->mutex);
+    if (!buffer->name.empty()) {
+      events.push_back({{"name", "thread_name"},
+                        {"ph", "M"},
+                        {"pid", pid},
+                        {"tid", buffer->thread_id},
+                        {"args", {{"name", buffer->name}}}});
+    }
+
+    // Oldest event first.
+    uint64_t count = std::min<uint64_t>(buffer->next, kEventsPerThread);
+    for (uint64_t i = buffer->next - count; i < buffer->next; i++) {
+      const Event& event = buffer->events[i % kEventsPerThread];
+      JSON trace_event = {{"name", event.name},
+                          {"cat", category},
+                          {"ph", "X"},
+                          {"ts", event.start_ns / 1000.0},
+                          {"dur", event.duration_ns / 1000.0},
+                          {"pid", pid},
+                          {"tid", buffer->thread_id}};
+      if (event.detail[0] != '\0') {
+        trace_event["args"] = {{"detail", event.detail}};
+      }
+      events.push_back(std::move(trace_event));
+    }
+  }
+
+  return events;
+}
+
+JSON ToChromeTrace(const JSON& events) {
+  return {{"traceEvents", events}, {"displayTimeUnit", "ms"}};
+}
+
+#ifdef _WIN32
+
+// Each extension DLL exports these so that the trace of all of the
+// extensions can be controlled and exported from any one of them.
+extern "C" __declspec(dllexport) void WindbgExtTraceSetEnabled(int enabled) {
+  SetEnabled(enabled != 0);
+}
+
+extern "C" __declspec(dllexport) void WindbgExtTraceClear() {
+  Clear();
+}
+
+extern "C" __declspec(dllexport) void WindbgExtTraceGetStats(
+    uint64_t* threads,
+    uint64_t* events,
+    uint64_t* dropped) {
+  TraceStats stats = GetStats();
+  *threads = stats.threads;
+  *events = stats.events;
+  *dropped = stats.dropped;
+}
+
+// The events are passed as a JSON array string because every DLL
+// has its own copy of the JSON library.
+extern "C" __declspec(dllexport) void WindbgExtTraceCollect(
+    const char* category,
+    void (*sink)(const char* events, void* context),
+    void* context) {
+  // ANSI details which aren't UTF-8 are replaced rather than thrown
+  // across the DLL boundary.
+  sink(GetEvents(category)
+           .dump(-1, ' ', false, JSON::error_handler_t::replace)
+           .c_str(),
+       context);
+}
+
+namespace {
+
+using SetEnabledFunction = void (*)(int);
+using ClearFunction = void (*)();
+using GetStatsFunction = void (*)(uint64_t*, uint64_t*, uint64_t*);
+using CollectFunction = void (*)(const char*,
+                                 void (*)(const char*, void*),
+                                 void*);
+
+// Calls callback with the handle and name (without the extension) of
+// every module in the process.
+void ForEachModule(
+    const std::function<void(HMODULE, const std::string&)>& callback) {
+  HANDLE process = GetCurrentProcess();
+  std::vector<HMODULE> modules(256);
+  DWORD needed = 0;
+  while (true) {
+    DWORD size = static_cast<DWORD>(modules.size() * sizeof(HMODULE));
+    if (!EnumProcessModules(process, modules.data(), size, &needed)) {
+      return;
+    }
+    if (needed <= size) {
+      break;
+    }
+    modules.resize(needed / sizeof(HMODULE));
+  }
+  modules.resize(needed / sizeof(HMODULE));
+
+  for (HMODULE module : modules) {
+    char name[MAX_PATH] = {};
+    if (GetModuleBaseNameA(process, module, name, MAX_PATH) == 0) {
+      continue;
+    }
+    std::string module_name = name;
+    size_t dot = module_name.find_last_of('.');
+    if (dot != std::string::npos) {
+      module_name = module_name.substr(0, dot);
+    }
+    callback(module, module_name);
+  }
+}
+
+}  // namespace
+
+void SetEnabledInAllModules(bool enabled) {
+  ForEachModule([enabled](HMODULE module, const std::string&) {
+    auto set_enabled = reinterpret_cast<SetEnabledFunction>(
+        GetProcAddress(module, "WindbgExtTraceSetEnabled"));
+    if (set_enabled) {
+      set_enabled(enabled ? 1 : 0);
+    }
+  });
+}
+
+void ClearAllModules() {
+  ForEachModule([](HMODULE module, const std::string&) {
+    auto clear = reinterpret_cast<ClearFunction>(
+        GetProcAddress(module, "WindbgExtTraceClear"));
+    if (clear) {
+      clear();
+    }
+  });
+}
+
+JSON GetEventsOfAllModules() {
+  JSON events = JSON::array();
+  ForEachModule([&events](HMODULE module, const std::string& name) {
+    auto collect = reinterpret_cast<CollectFunction>(
+        GetProcAddress(module, "WindbgExtTraceCollect"));
+    if (!collect) {
+      return;
+    }
+
+    auto sink = [](const char* module_events, void* context) {
+      JSON* all_events = static_cast<JSON*>(context);
+      for (JSON& event : JSON::parse(module_events)) {
+        all_events->push_back(std::move(event));
+      }
+    };
+    collect(name.c_str(), sink, &events);
+  });
+  return events;
+}
+
+TraceStats GetStatsOfAllModules() {
+  TraceStats stats;
+  ForEachModule([&stats](HMODULE module, const std::string&) {
+    auto get_stats = reinterpret_cast<GetStatsFunction>(
+        GetProcAddress(module, "WindbgExtTraceGetStats"));
+    if (!get_stats) {
+      return;
+    }
+
+    uint64_t threads = 0, events = 0, dropped = 0;
+    get_stats(&threads, &events, &dropped);
+    stats.threads += threads;
+    stats.events += events;
+    stats.dropped += dropped;
+  });
+  return stats;
+}
+
+#else
+
+void SetEnabledInAllModules(bool enabled) {
+  SetEnabled(enabled);
+}
+
+void ClearAllModules() {
+  Clear();
+}
+
+JSON GetEventsOfAllModules() {
+  return GetEvents("windbg_ext");
+}
+
+TraceStats GetStatsOfAllModules() {
+  return GetStats();
+}
+
+#endif
+
+}  // namespace trace
@@ -0,0 +1,133 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+#include "json.hpp"
+
+using JSON = nlohmann::json;
+
+// Scoped trace spans which are recorded into a ring buffer per thread
+// and exported in the Chrome trace event format (chrome://tracing and
+// https://ui.perfetto.dev).
+//
+//    void RunCommandList(const CommandList* list) {
+//      TRACE_SPAN("RunCommandList", list->GetName());
+//      ...
+//    }
+//
+// Recording is off by default. A span which is created while recording
+// is off only loads an atomic flag. The names of the spans must be
+// string literals. The optional detail is copied when the span starts
+// (truncated to kMaxDetailLength bytes on a UTF-8 character boundary)
+// and exported as args.detail.
+//
+// Every extension DLL links its own copy of this code so each DLL has
+// its own buffers. The *AllModules functions reach the buffers of all
+// of the extensions which are loaded in the process.
+namespace trace {
+
+constexpr size_t kEventsPerThread = 4096;
+constexpr size_t kMaxDetailLength = 63;
+
+extern std::atomic<bool> g_enabled;
+
+inline bool IsEnabled() {
+  return g_enabled.load(std::memory_order_relaxed);
+}
+
+void SetEnabled(bool enabled);
+
+// Drops the recorded events of all threads.
+void Clear();
+
+// Steady clock time in nanoseconds.
+uint64_t NowNs();
+
+// Records a span which started at start_ns and ended at end_ns on the
+// current thread. Used for intervals which aren't a scope (e.g. the
+// time a command waited in a queue). Does nothing if recording is off.
+void Record(const char* name,
+            const char* detail,
+            uint64_t start_ns,
+            uint64_t end_ns);
+
+// Names the current thread in the exported trace.
+void SetThreadName(const std::string& name);
+
+class Span {
+ public:
+  explicit Span(const char* name) : name_(name) {
+    if (IsEnabled()) {
+      detail_[0] = '\0';
+      start_ns_ = NowNs();
+    }
+  }
+
+  Span(const char* name, const std::string& detail) : name_(name) {
+    if (IsEnabled()) {
+      SetDetail(detail.data(), detail.size());
+      start_ns_ = NowNs();
+    }
+  }
+
+  ~Span() {
+    if (start_ns_ != 0) {
+      Record(name_, detail_, start_ns_, NowNs());
+    }
+  }
+
+  Span(const Span&) = delete;
+  Span& operator=(const Span&) = delete;
+
+ private:
+  void SetDetail(const char* detail, size_t length);
+
+  const char* name_;
+  uint64_t start_ns_ = 0;
+  // Only set while recording.
+  char detail_[kMaxDetailLength + 1];
+};
+
+struct TraceStats {
+  size_t threads = 0;
+  // Events which are in the buffers and events which were
+  // overwritten because a buffer was full.
+  uint64_t events = 0;
+  uint64_t dropped = 0;
+};
+
+TraceStats GetStats();
+
+// The trace events of this module (an array of Chrome trace event
+// objects including the thread name metadata events). category is
+// used as the "cat" of the events.
+JSON GetEvents(const std::string& category);
+
+// Wraps events in a Chrome trace object.
+JSON ToChromeTrace(const JSON& events);
+
+// The same as SetEnabled, Clear and GetEvents for all of the
+// extensions which are loaded in the process. The category of the
+// events is the name of the extension they were recorded in.
+void SetEnabledInAllModules(bool enabled);
+void ClearAllModules();
+JSON GetEventsOfAllModules();
+TraceStats GetStatsOfAllModules();
+
+}  // namespace trace
+
+#define TRACE_CONCAT_INNER(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+
+// Records a span from here to the end of the enclosing scope.
+// Usage: TRACE_SPAN("name") or TRACE_SPAN("name", detail_string)
+#define TRACE_SPAN(...) \
+  trace::Span TRACE_CONCAT(trace_span_, __LINE__)(__VA_ARGS__)
+
+#endif  // TRACE_H_
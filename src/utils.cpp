@@ -4,7 +4,9 @@
 #include "utils.h"
 
 #include <algorithm>
-#include <filesystem>
+#include <cstring>
+
+#include "trace.h"
 
 namespace utils {
 
@@ -64,6 +66,8 @@ class CommandOutputCapture : public IDebugOutputCallbacks {
 // If an error occurs while waiting or retrieving the status
 // then the method will return early.
 void WaitForBreakStatus(const DebugInterfaces* interfaces) {
+  TRACE_SPAN("WaitForBreakStatus");
+
   HRESULT hr;
   ULONG status;
   int retries = 0;
@@ -100,74 +104,6 @@ void WaitForBreakStatus(const DebugInterfaces* interfaces) {
 
 }  // namespace
 
-std::string Trim(const std::string& str) {
-  size_t start = str.find_first_not_of(" \t\n\r\f\v");
-  size_t end = str.find_last_not_of(" \t\n\r\f\v");
-  return (start == std::string::npos) ? "" : str.substr(start, end - start + 1);
-}
-
-bool ContainsCI(const std::string& string, const std::string& substr) {
-  auto it = std::search(
-      string.begin(), string.end(), substr.begin(), substr.end(),
-      [](char a, char b) { return std::tolower(a) == std::tolower(b); });
-  return it != string.end();
-}
-
-bool IsWholeNumber(const std::string& input_str) {
-  if (input_str.empty()) {
-    return false;
-  }
-  return std::all_of(input_str.begin(), input_str.end(), ::isdigit);
-}
-
-std::string RemoveFileExtension(const std::string& filename) {
-  // Find the last dot in the filename
-  size_t last_dot = filename.find_last_of(".");
-
-  // If no dot is found or it's at the beginning of the string
-  // (hidden file in Unix), return the original string
-  if (last_dot == std::string::npos || last_dot == 0) {
-    return filename;
-  }
-
-  // Check if there's a directory separator after the last dot
-  // If so, this is not an extension but part of a directory name
-  size_t last_separator = filename.find_last_of("/\\");
-  if (last_separator != std::string::npos && last_separator > last_dot) {
-    return filename;
-  }
-
-  // Return the substring before the last dot
-  return filename.substr(0, last_dot);
-}
-
-std::string EscapeQuotes(const std::string& input) {
-  std::string escaped;
-  size_t backslash_count = 0;
-
-  for (size_t i = 0; i < input.length(); ++i) {
-    if (input[i] == '\\') {
-      // Count consecutive backslashes
-      backslash_count++;
-      escaped += '\\';
-    } else if (input[i] == '"') {
-      // If even number of backslashes (including 0), the quote is not escaped
-      if (backslash_count % 2 == 0) {
-        escaped += "\\\"";
-      } else {
-        // Odd number of backslashes means the quote is already escaped
-        escaped += '"';
-      }
-      backslash_count = 0;  // Reset after encountering a quote
-    } else {
-      // Any other character resets the backslash count
-      backslash_count = 0;
-      escaped += input[i];
-    }
-  }
-  return escaped;
-}
-
 std::string GetCurrentExtensionDir() {
   HMODULE hModule = NULL;
 
@@ -194,198 +130,8 @@ std::string GetCurrentExtensionDir() {
   return "";
 }
 
-std::vector<std::string> SplitString(const std::string& input,
-                                     const std::string& delimiter,
-                                     bool combine_consecutive_delimiters) {
-  std::vector<std::string> tokens;
-  if (input.empty()) {
-    return tokens;
-  }
-
-  size_t start = 0;
-  size_t end = input.find(delimiter);
-
-  while (end != std::string::npos) {
-    if (!combine_consecutive_delimiters || end > start) {
-      tokens.push_back(input.substr(start, end - start));
-    }
-    start = end + delimiter.length();
-    end = input.find(delimiter, start);
-  }
-
-  // Add the last token
-  if (start < input.length()) {
-    tokens.push_back(input.substr(start));
-  }
-
-  return tokens;
-}
-
-std::vector<size_t> GetIndicesFromString(const std::string& input_str) {
-  std::vector<size_t> indices;
-  std::vector<std::string> tokens;
-
-  // First split by spaces
-  std::vector<std::string> space_tokens =
-      utils::SplitString(utils::Trim(input_str), " ");
-
-  for (const auto& token : space_tokens) {
-    // Check if token contains a range (has a hyphen)
-    if (token.find('-') != std::string::npos) {
-      std::vector<std::string> range_parts = utils::SplitString(token, "-");
-      if (range_parts.size() == 2) {
-        int start = std::stoi(range_parts[0]);
-        int end = std::stoi(range_parts[1]);
-
-        // Handle both ascending and descending ranges
-        if (start <= end) {
-          for (int i = start; i <= end; i++) {
-            indices.push_back(i);
-          }
-        } else {
-          for (int i = start; i >= end; i--) {
-            indices.push_back(i);
-          }
-        }
-      } else {
-        // Invalid range format
-        continue;
-      }
-    } else {
-      // Regular number
-      indices.push_back(std::stoi(token));
-    }
-  }
-
-  // Sort and remove duplicates
-  std::sort(indices.begin(), indices.end());
-  indices.erase(std::unique(indices.begin(), indices.end()), indices.end());
-  return indices;
-}
-
-bool ParseNumberOrDottedPair(const std::string& input,
-                             size_t& first_number,
-                             std::optional<size_t>& second_number) {
-  second_number.reset();
-
-  if (input.empty()) {
-    return false;
-  }
-
-  size_t dot_pos = input.find('.');
-  bool has_dot = (dot_pos != std::string::npos);
-
-  if (has_dot) {
-    // Format: "number1.number2"
-    std::string first_part = input.substr(0, dot_pos);
-    std::string second_part = input.substr(dot_pos + 1);
-
-    if (IsWholeNumber(first_part) && IsWholeNumber(second_part)) {
-      first_number = std::stoul(first_part);
-      second_number = std::stoul(second_part);
-      return true;
-    }
-  } else {
-    // Single number format
-    if (IsWholeNumber(input)) {
-      first_number = std::stoul(input);
-      return true;
-    }
-  }
-
-  return false;
-}
-
-std::vector<std::string> ParseCommandLine(const char* cmd_line) {
-  std::vector<std::string> args;
-  if (!cmd_line || !*cmd_line) {
-    return args;
-  }
-
-  bool in_single_quotes = false;
-  std::string current_arg;
-
-  for (const char* p = cmd_line; *p; p++) {
-    if (*p == '\\') {
-      // Count consecutive backslashes
-      int backslash_count = 0;
-      while (p[backslash_count] == '\\') {
-        backslash_count++;
-      }
-
-      // Check what follows the backslashes
-      if (p[backslash_count] == '\'') {
-        // Any backslashes beyond 3 are
-        // treated as regular backslashes
-        while (backslash_count >= 4) {
-          current_arg += '\\';
-          backslash_count--;
-          p++;
-        }
-
-        if (backslash_count == 1) {
-          // p = \'
-          // One backslash followed by a quote escapes
-          // the quote so insert a single quote.
-          current_arg += '\'';
-          p++;  // Move the pointer to the quote character
-        } else if (backslash_count == 2) {
-          // p = \\'
-          // The first backslash escapes the second backslash and
-          // the quote should be seen as an arg delimiter like normal.
-          current_arg += "\\";
-          // Only move the pointer forward by one backslash so that
-          // the quote is processed normally on the next iteration.
-          p++;
-        } else if (backslash_count == 3) {
-          // p = \\\'
-          // The first backlash escapes the second backslash.
-          // The third backslash escapes the single quote.
-          current_arg += "\\'";
-          p += 3;  // Skip the backslashes and the quote
-        }
-      } else {
-        // Backslashes not followed by quote are
-        // treated as regular backslashes
-        for (int i = 0; i < backslash_count; i++) {
-          current_arg += "\\";
-        }
-        p += backslash_count - 1;
-      }
-      continue;
-    }
-
-    if (*p == '\'') {
-      if (!current_arg.empty() || in_single_quotes) {
-        args.push_back(current_arg);
-        current_arg.clear();
-      }
-      in_single_quotes = !in_single_quotes;
-      continue;
-    }
-
-    if (isspace(*p) && !in_single_quotes) {
-      // End of argument
-      if (!current_arg.empty()) {
-        args.push_back(current_arg);
-        current_arg.clear();
-      }
-      continue;
-    }
-
-    // Regular character
-    current_arg += *p;
-  }
-
-  // Add the last argument if exists
-  if (!current_arg.empty()) {
-    args.push_back(current_arg);
-  }
-
-  return args;
-}
-
 SourceInfo GetCurrentSourceInfo(const DebugInterfaces* interfaces) {
+  TRACE_SPAN("GetCurrentSourceInfo");
   SourceInfo info;
 
   if (!interfaces || !interfaces->control || !interfaces->symbols) {
@@ -555,6 +301,8 @@ std::string ExecuteCommand(const DebugInterfaces* interfaces,
     return "";
   }
 
+  TRACE_SPAN("ExecuteCommand", command);
+
   if (wait_for_break_status) {
     WaitForBreakStatus(interfaces);
   }
@@ -591,51 +339,6 @@ std::string ExecuteCommand(const DebugInterfaces* interfaces,
   return output;
 }
 
-std::string ConvertToBreakpointFilePath(const std::string& input_path,
-                                        bool check_exists) {
-  if (input_path.empty()) {
-    return "";
-  }
-
-  try {
-    std::filesystem::path p(input_path);
-
-    // Check if it's a UNC path
-    if (p.has_root_name() && p.root_name().string().substr(0, 2) == "\\\\") {
-      return "";
-    }
-
-    if (p.is_relative()) {
-      return "";
-    }
-
-    p = p.lexically_normal();
-
-    if (std::filesystem::is_directory(p)) {
-      return "";
-    }
-
-    if (check_exists && (!std::filesystem::exists(p))) {
-      return "";
-    }
-
-    // Get the native path and double the backslashes
-    std::string native = p.string();
-    std::string doubled_path;
-    for (char c : native) {
-      if (c == '\\') {
-        doubled_path += "\\\\";
-      } else {
-        doubled_path += c;
-      }
-    }
-
-    return doubled_path;
-  } catch (...) {
-    return "";
-  }
-}
-
 DebugContextGuard::DebugContextGuard(const DebugInterfaces* interfaces)
     : interfaces_(interfaces),
       original_process_id_(0),
@@ -727,6 +430,7 @@ bool DebugContextGuard::RestoreIfChanged() {
 std::vector<std::string> GetTopOfCallStack(const DebugInterfaces* interfaces,
                                            size_t max_depth,
                                            bool symbol_only) {
+  TRACE_SPAN("GetTopOfCallStack");
   std::vector<std::string> symbols;
 
   if (!interfaces || !interfaces->control || !interfaces->symbols ||
@@ -770,4 +474,199 @@ std::vector<std::string> GetTopOfCallStack(const DebugInterfaces* interfaces,
   return symbols;
 }
 
+MemoryReadCache::MemoryReadCache(const DebugInterfaces* interfaces,
+                                 size_t max_pages,
+                                 ULONG prefetch_pages)
+    : interfaces_(interfaces),
+      max_pages_(max_pages),
+      prefetch_pages_(prefetch_pages) {
+  // The cache must at least be able to hold all of
+  // the pages needed for the largest cached read.
+  size_t min_pages = kMaxCachedReadSize / kPageSize + 1 + prefetch_pages_;
+  max_pages_ = std::max(max_pages_, min_pages);
+}
+
+HRESULT MemoryReadCache::ReadVirtual(ULONG64 address,
+                                     PVOID buffer,
+                                     ULONG size,
+                                     PULONG bytes_read) {
+  if (bytes_read) {
+    *bytes_read = 0;
+  }
+
+  if (size == 0) {
+    return S_OK;
+  }
+
+  const ULONG64 page_mask = ~static_cast<ULONG64>(kPageSize - 1);
+  const ULONG64 first_page = address & page_mask;
+  const ULONG64 last_page = (address + size - 1) & page_mask;
+
+  // Large reads and reads which wrap around or touch
+  // the last page of the address space are not cached.
+  ULONG process_id = 0;
+  if (size > kMaxCachedReadSize || last_page < first_page ||
+      last_page == page_mask ||
+      FAILED(interfaces_->system_objects->GetCurrentProcessSystemId(
+          &process_id))) {
+    statistics_.uncached_reads++;
+    statistics_.target_reads++;
+    return interfaces_->data_spaces->ReadVirtual(address, buffer, size,
+                                                 bytes_read);
+  }
+
+  // Make sure that pages which are part of this read
+  // are not evicted while the missing pages are read.
+  size_t page_count = static_cast<size_t>((last_page - first_page) / kPageSize);
+  if (pages_.size() + page_count + 1 + prefetch_pages_ > max_pages_) {
+    pages_.clear();
+  }
+
+  // Read the missing pages. Each run of adjacent missing
+  // pages is read from the target with a single read.
+  ULONG64 page_address = first_page;
+  while (page_address <= last_page) {
+    if (pages_.count({process_id, page_address})) {
+      statistics_.hits++;
+      page_address += kPageSize;
+      continue;
+    }
+
+    ULONG64 run_start = page_address;
+    ULONG run_count = 0;
+    while (page_address <= last_page &&
+           !pages_.count({process_id, page_address})) {
+      run_count++;
+      page_address += kPageSize;
+    }
+    statistics_.misses += run_count;
+
+    // Prefetch the pages which follow the end of the requested range.
+    ULONG prefetch_count = 0;
+    if (page_address > last_page) {
+      ULONG64 prefetch_address = page_address;
+      while (prefetch_count < prefetch_pages_ &&
+             prefetch_address > last_page &&
+             !pages_.count({process_id, prefetch_address})) {
+        prefetch_count++;
+        prefetch_address += kPageSize;
+      }
+    }
+
+    ReadPages(process_id, run_start, run_count, prefetch_count);
+  }
+
+  // Copy the requested bytes out of the cached pages. Stop
+  // at the first byte which could not be read from the target.
+  BYTE* output = static_cast<BYTE*>(buffer);
+  ULONG total = 0;
+  while (total < size) {
+    ULONG64 current = address + total;
+    ULONG64 current_page = current & page_mask;
+    ULONG offset = static_cast<ULONG>(current - current_page);
+
+    auto it = pages_.find({process_id, current_page});
+    if (it == pages_.end() || offset >= it->second.valid_size) {
+      break;
+    }
+
+    const Page& page = it->second;
+    ULONG count = std::min(page.valid_size - offset, size - total);
+    memcpy(output + total, page.data.data() + offset, count);
+    total += count;
+
+    if (page.valid_size < kPageSize) {
+      break;
+    }
+  }
+
+  if (bytes_read) {
+    *bytes_read = total;
+  }
+  return total > 0 ? S_OK : E_FAIL;
+}
+
+void MemoryReadCache::ReadPages(ULONG process_id,
+                                ULONG64 page_address,
+                                ULONG count,
+                                ULONG prefetch_count) {
+  std::vector<BYTE> buffer(static_cast<size_t>(count + prefetch_count) *
+                           kPageSize);
+  ULONG bytes_read = 0;
+
+  statistics_.target_reads++;
+  HRESULT hr = interfaces_->data_spaces->ReadVirtual(
+      page_address, buffer.data(), static_cast<ULONG>(buffer.size()),
+      &bytes_read);
+  if (FAILED(hr)) {
+    // The whole read can fail because of a single unreadable page, so
+    // the requested pages are read again before any of them is cached
+    // as unreadable. First without the prefetched pages and then one
+    // page at a time, up to the first page which can't be read.
+    if (prefetch_count > 0) {
+      ReadPages(process_id, page_address, count, 0);
+      return;
+    }
+    if (count > 1) {
+      for (ULONG i = 0; i < count; i++) {
+        ULONG64 address = page_address + static_cast<ULONG64>(i) * kPageSize;
+        ReadPages(process_id, address, 1, 0);
+        if (pages_[{process_id, address}].valid_size < kPageSize) {
+          break;
+        }
+      }
+      return;
+    }
+    bytes_read = 0;
+  }
+  statistics_.prefetched_pages += prefetch_count;
+  count += prefetch_count;
+
+  for (ULONG i = 0; i < count; i++) {
+    ULONG page_start = i * kPageSize;
+    ULONG valid_size = 0;
+    if (bytes_read > page_start) {
+      valid_size = std::min(kPageSize, bytes_read - page_start);
+    }
+
+    Page& page = pages_[{process_id, page_address + page_start}];
+    page.data.assign(buffer.begin() + page_start,
+                     buffer.begin() + page_start + valid_size);
+    page.valid_size = valid_size;
+
+    // Nothing is known about the pages after the first unreadable byte.
+    if (valid_size < kPageSize) {
+      break;
+    }
+  }
+}
+
+HRESULT MemoryReadCache::WriteVirtual(ULONG64 address,
+                                      PVOID buffer,
+                                      ULONG size,
+                                      PULONG bytes_written) {
+  HRESULT hr = interfaces_->data_spaces->WriteVirtual(address, buffer, size,
+                                                      bytes_written);
+  Invalidate();
+  return hr;
+}
+
+void MemoryReadCache::Invalidate() {
+  pages_.clear();
+  generation_++;
+  statistics_.invalidations++;
+}
+
+void MemoryReadCache::OnChangeEngineState(ULONG flags, ULONG64 argument) {
+  if (flags & DEBUG_CES_EXECUTION_STATUS) {
+    Invalidate();
+  }
+}
+
+void MemoryReadCache::OnChangeDebuggeeState(ULONG flags, ULONG64 argument) {
+  if (flags & DEBUG_CDS_DATA) {
+    Invalidate();
+  }
+}
+
 }  // namespace utils
@@ -4,12 +4,14 @@
 #ifndef UTILS_H_
 #define UTILS_H_
 
-#include <dbgeng.h>
-#include <windows.h>
 #include <optional>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
+#include "dbgeng_shim.h"
+#include "string_utils.h"
+
 // Macros for debug output to make code less verbose
 #define DOUT(format, ...) \
   g_debug.control->Output(DEBUG_OUTPUT_NORMAL, format, ##__VA_ARGS__)
@@ -18,21 +20,6 @@
 
 namespace utils {
 
-// Remove leading and trailing whitespace from a string
-std::string Trim(const std::string& str);
-
-// Case-insensitive string comparison
-bool ContainsCI(const std::string& string, const std::string& substr);
-
-// Check if a string represents a whole number.
-bool IsWholeNumber(const std::string& input_str);
-
-// Remove the file extension from a filename.
-std::string RemoveFileExtension(const std::string& filename);
-
-// Escape quotes in a string by replacing " with \"
-std::string EscapeQuotes(const std::string& input);
-
 // Get the directory of the current extension dll.
 std::string GetCurrentExtensionDir();
 
@@ -60,49 +47,6 @@ struct SourceInfo {
 // Get current source file and line information from the debugger
 SourceInfo GetCurrentSourceInfo(const DebugInterfaces* interfaces);
 
-// Splits a string into tokens based on a delimiter.
-// If combine_consecutive_delimiters is true,
-// consecutive delimiters are treated as a single delimiter.
-// For example, "a,,b" with delimiter "," will yield ["a", "b"] if true,
-// and ["a", "", "b"] if false.
-std::vector<std::string> SplitString(
-    const std::string& input,
-    const std::string& delimiter,
-    bool combine_consecutive_delimiters = true);
-
-// Parses a string containing indices and returns a vector of size_t values.
-// Supports multiple formats:
-//  - Individual numbers: "1", "42"
-//  - Space-separated numbers: "1 2 3"
-//  - Ranges with hyphens: "1-5" (expands to 1,2,3,4,5)
-//  - Mixed formats: "1 3-5 7" (expands to 1,3,4,5,7)
-// Handles both ascending (1-5) and descending (5-1) ranges.
-// Returns a vector with all parsed indices, sorted and with duplicates removed.
-std::vector<size_t> GetIndicesFromString(const std::string& input_str);
-
-// Parses a string containing numbers or dotted pairs (e.g., "1", "2.3").
-// Returns true if the input is a valid number or dotted pair.
-// If a dotted pair is found, first_number will contain the first part,
-// and second_number will contain the second part as an optional size_t.
-// If the input is a single number, second_number will be std::nullopt.
-bool ParseNumberOrDottedPair(const std::string& input,
-                             size_t& first_number,
-                             std::optional<size_t>& second_number);
-
-// Parse command-line arguments. Due to the way that WinDbg
-// parses command arguments this implementation uses single
-// quotes to delimit text with spaces that should be considered
-// a single argument. For example:
-//   !myext.cmd 'arg1 arg2' arg3
-// will yield ["arg1 arg2", "arg3"].
-// Double quotes could not be used because if a double quote
-// is present in the command line as the first non-whitespace
-// character, WinDbg will not pass it to the extension.
-// Note: Backslashes are only used for escaping when they
-// are immediately followed by a single quote. A backslash
-// not before a single quote will be treated as a regular character.
-std::vector<std::string> ParseCommandLine(const char* cmdLine);
-
 // Execute a command and capture its output.
 // Note, this function is a little bit of a hack and should only be used
 // when there is no other direct way to achieve the desired result using
@@ -114,11 +58,6 @@ std::string ExecuteCommand(const DebugInterfaces* interfaces,
                            const std::string& command,
                            bool wait_for_break_status = false);
 
-// Converts a file path to a breakpoint file path which is a path that
-// uses double backslashes for the path separators.
-std::string ConvertToBreakpointFilePath(const std::string& input_path,
-                                        bool check_exists = false);
-
 // A class to manage debugger context switching.
 // Saves the current process and thread context on construction
 // and can restore it when RestoreIfChanged() is called if the
@@ -151,6 +90,117 @@ std::vector<std::string> GetTopOfCallStack(const DebugInterfaces* interfaces,
                                            size_t max_depth = 5,
                                            bool symbol_only = true);
 
+// A page granular cache for reading target memory. Each call to
+// IDebugDataSpaces::ReadVirtual is a full round trip to the target,
+// which adds up quickly for code that reads many small pieces of memory
+// (signature checks, visualizers, memory tools, etc.).
+//
+// Pages are keyed by (process, page address). Adjacent missing pages
+// are read from the target with a single ReadVirtual call and the pages
+// following a read are prefetched. Reads which are larger than
+// kMaxCachedReadSize bypass the cache.
+//
+// The cache does not register any event callbacks itself because each
+// client can only have one set of event callbacks. Instead, the owning
+// extension must forward ChangeEngineState and ChangeDebuggeeState
+// notifications to OnChangeEngineState and OnChangeDebuggeeState so that
+// the cache is invalidated whenever the target runs or its memory is
+// modified. Every invalidation advances the execution generation.
+class MemoryReadCache {
+ public:
+  static constexpr ULONG kPageSize = 0x1000;
+  static constexpr ULONG kMaxCachedReadSize = 64 * 1024;
+
+  struct Statistics {
+    // Number of pages that were served from the cache.
+    size_t hits = 0;
+    // Number of pages that had to be read from the target.
+    size_t misses = 0;
+    // Number of pages that were read ahead of being requested.
+    size_t prefetched_pages = 0;
+    // Number of ReadVirtual calls made on the target.
+    size_t target_reads = 0;
+    // Number of reads which were too large to be cached.
+    size_t uncached_reads = 0;
+    size_t invalidations = 0;
+  };
+
+  explicit MemoryReadCache(const DebugInterfaces* interfaces,
+                           size_t max_pages = 4096,
+                           ULONG prefetch_pages = 1);
+
+  // Same semantics as IDebugDataSpaces::ReadVirtual. If only the
+  // beginning of the range is readable then S_OK is returned and
+  // bytes_read is set to the number of bytes which could be read.
+  HRESULT ReadVirtual(ULONG64 address,
+                      PVOID buffer,
+                      ULONG size,
+                      PULONG bytes_read);
+
+  // Writes through to the target and invalidates the cache.
+  HRESULT WriteVirtual(ULONG64 address,
+                       PVOID buffer,
+                       ULONG size,
+                       PULONG bytes_written);
+
+  // Drop all cached pages and advance the execution generation.
+  void Invalidate();
+
+  // Forward the matching IDebugEventCallbacks notifications here.
+  void OnChangeEngineState(ULONG flags, ULONG64 argument);
+  void OnChangeDebuggeeState(ULONG flags, ULONG64 argument);
+
+  // The generation is advanced every time the cache is invalidated.
+  // Callers can use it to check whether data that was derived from
+  // target memory is still valid.
+  ULONG64 GetGeneration() const { return generation_; }
+
+  size_t GetCachedPageCount() const { return pages_.size(); }
+  const Statistics& GetStatistics() const { return statistics_; }
+  void ResetStatistics() { statistics_ = Statistics(); }
+
+ private:
+  struct PageKey {
+    ULONG process_id;
+    ULONG64 page_address;
+
+    bool operator==(const PageKey& other) const {
+      return process_id == other.process_id &&
+             page_address == other.page_address;
+    }
+  };
+
+  struct PageKeyHash {
+    size_t operator()(const PageKey& key) const {
+      return std::hash<ULONG64>()(key.page_address) ^
+             (static_cast<size_t>(key.process_id) << 1);
+    }
+  };
+
+  struct Page {
+    std::vector<BYTE> data;
+    // Number of readable bytes from the start of the page.
+    // Zero if the page could not be read at all.
+    ULONG valid_size = 0;
+  };
+
+  // Reads count pages starting at page_address, followed by
+  // prefetch_count pages, with a single target read and adds them to
+  // the cache. Pages past the first unreadable byte are not cached
+  // unless they are the first page of the read.
+  void ReadPages(ULONG process_id,
+                 ULONG64 page_address,
+                 ULONG count,
+                 ULONG prefetch_count);
+
+  const DebugInterfaces* interfaces_;
+  size_t max_pages_;
+  ULONG prefetch_pages_;
+  ULONG64 generation_ = 0;
+  std::unordered_map<PageKey, Page, PageKeyHash> pages_;
+  Statistics statistics_;
+};
+
 }  // namespace utils
 
 #endif  // UTILS_H_
@@ -0,0 +1,406 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include "visualizer_engine.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace visualizers {
+
+namespace {
+
+// Size of a libc++ std::string and std::vector on x64.
+constexpr ULONG kStdStringSize = 24;
+constexpr ULONG kStdVectorSize = 24;
+
+// Short strings can hold at most 22 characters plus the null terminator.
+constexpr size_t kMaxShortStringLength = 22;
+
+// Upper limit on how much of the element array is read at once.
+constexpr ULONG kMaxVectorReadChunkSize = 1024 * 1024;
+
+// Upper limit on how many characters of a long string are displayed.
+constexpr size_t kMaxDisplayedStringLength = 1024;
+
+ULONG64 ReadUInt64(const BYTE* bytes) {
+  ULONG64 value = 0;
+  memcpy(&value, bytes, sizeof(value));
+  return value;
+}
+
+ULONG ReadUInt32(const BYTE* bytes) {
+  ULONG value = 0;
+  memcpy(&value, bytes, sizeof(value));
+  return value;
+}
+
+std::string ToHexString(ULONG64 value) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "0x%llx", value);
+  return buffer;
+}
+
+std::string BoolToIntString(const FieldValue& value) {
+  return value.number ? "1" : "0";
+}
+
+std::string QuoteString(const FieldValue& value) {
+  return "\"" + value.text + "\"";
+}
+
+// Returns the name of the enum value or the numeric value
+// if it is out of range for the known enum names.
+std::string EnumToString(const FieldValue& value,
+                         const std::vector<std::string>& names) {
+  if (value.number < names.size()) {
+    return names[value.number];
+  }
+  return std::to_string(value.number);
+}
+
+std::string StripModuleName(const std::string& type_name) {
+  size_t bang = type_name.find('!');
+  if (bang == std::string::npos) {
+    return type_name;
+  }
+  return type_name.substr(bang + 1);
+}
+
+}  // namespace
+
+ULONG GetFieldKindSize(FieldKind kind) {
+  switch (kind) {
+    case FieldKind::kBool:
+      return 1;
+    case FieldKind::kUInt32:
+    case FieldKind::kEnum32:
+      return 4;
+    case FieldKind::kUInt64:
+      return 8;
+    case FieldKind::kUInt64Pair:
+      return 16;
+    case FieldKind::kStdString:
+      return kStdStringSize;
+  }
+  return 0;
+}
+
+const std::vector<VisualizerDefinition>& GetBuiltInVisualizers() {
+  static const std::vector<VisualizerDefinition> visualizers = {
+      {"base::FilePath",
+       {{"path_", FieldKind::kStdString}},
+       [](const FieldValues& values) { return QuoteString(values[0]); }},
+
+      {"base::UnguessableToken",
+       {{"token_", FieldKind::kUInt64Pair}},
+       [](const FieldValues& values) {
+         return "{" + ToHexString(values[0].number) + ", " +
+                ToHexString(values[0].number2) + "}";
+       }},
+
+      {"content::CdmInfo",
+       {{"key_system", FieldKind::kStdString},
+        {"robustness", FieldKind::kEnum32},
+        {"status", FieldKind::kEnum32},
+        {"supports_sub_key_systems", FieldKind::kBool}},
+       [](const FieldValues& values) {
+         static const std::vector<std::string> robustness_names = {
+             "kHardwareSecure", "kSoftwareSecure"};
+         static const std::vector<std::string> status_names = {
+             "kUninitialized",
+             "kEnabled",
+             "kCommandLineOverridden",
+             "kHardwareSecureDecryptionDisabled",
+             "kAcceleratedVideoDecodeDisabled",
+             "kGpuFeatureDisabled",
+             "kGpuCompositionDisabled",
+             "kDisabledByPref",
+             "kDisabledOnError",
+             "kDisabledBySoftwareEmulatedGpu"};
+
+         return "{" + QuoteString(values[0]) + ", " +
+                EnumToString(values[1], robustness_names) +
+                ", Status: " + EnumToString(values[2], status_names) +
+                ", SupportsSubKeySystems: " + BoolToIntString(values[3]) +
+                "}";
+       }},
+
+      {"media::CdmConfig",
+       {{"key_system", FieldKind::kStdString},
+        {"allow_distinctive_identifier", FieldKind::kBool},
+        {"allow_persistent_state", FieldKind::kBool},
+        {"use_hw_secure_codecs", FieldKind::kBool}},
+       [](const FieldValues& values) {
+         return QuoteString(values[0]) +
+                " AllowDI: " + BoolToIntString(values[1]) +
+                " AllowPS: " + BoolToIntString(values[2]) +
+                " UseHwSecureCodecs: " + BoolToIntString(values[3]);
+       }},
+  };
+
+  return visualizers;
+}
+
+const VisualizerDefinition* FindVisualizer(const std::string& type_name) {
+  std::string bare_type_name = StripModuleName(type_name);
+  for (const auto& visualizer : GetBuiltInVisualizers()) {
+    if (visualizer.type_name == bare_type_name) {
+      return &visualizer;
+    }
+  }
+  return nullptr;
+}
+
+std::string DecodeStdString(
+    const BYTE* bytes,
+    size_t max_length,
+    const std::function<bool(ULONG64, BYTE*, ULONG)>& read_memory) {
+  // Chromium builds libc++ with the alternate string layout (ABI v2).
+  //
+  //   long:  [0] char* data, [8] size_t size, [16] size_t cap:63 is_long:1
+  //   short: [0] char data[23], [23] size:7 is_long:1
+  //
+  // The is_long flag is the high bit of the last byte in both cases.
+  BYTE last_byte = bytes[kStdStringSize - 1];
+  bool is_long = (last_byte & 0x80) != 0;
+
+  if (!is_long) {
+    size_t size = last_byte & 0x7F;
+    if (size > kMaxShortStringLength) {
+      return "<invalid string>";
+    }
+    return std::string(reinterpret_cast<const char*>(bytes),
+                       std::min(size, max_length));
+  }
+
+  ULONG64 data = ReadUInt64(bytes);
+  ULONG64 size = ReadUInt64(bytes + 8);
+  if (size == 0) {
+    return "";
+  }
+
+  size_t read_size = static_cast<size_t>(std::min<ULONG64>(size, max_length));
+  std::string text(read_size, '\0');
+  if (!read_memory(data, reinterpret_cast<BYTE*>(text.data()),
+                   static_cast<ULONG>(read_size))) {
+    return "<unreadable string at " + ToHexString(data) + ">";
+  }
+
+  if (read_size < size) {
+    text += "...";
+  }
+  return text;
+}
+
+VisualizerEngine::VisualizerEngine(const utils::DebugInterfaces* interfaces,
+                                   utils::MemoryReadCache* memory_cache)
+    : interfaces_(interfaces), memory_cache_(memory_cache) {}
+
+void VisualizerEngine::ClearCache() {
+  layouts_.clear();
+  type_modules_.clear();
+  layout_cache_hits_ = 0;
+  layout_cache_misses_ = 0;
+}
+
+bool VisualizerEngine::ReadMemory(ULONG64 address, BYTE* buffer, ULONG size) {
+  if (size == 0) {
+    return true;
+  }
+
+  ULONG bytes_read = 0;
+  HRESULT hr = memory_cache_
+                   ? memory_cache_->ReadVirtual(address, buffer, size,
+                                                &bytes_read)
+                   : interfaces_->data_spaces->ReadVirtual(address, buffer,
+                                                           size, &bytes_read);
+  return SUCCEEDED(hr) && bytes_read == size;
+}
+
+const TypeLayout* VisualizerEngine::GetLayout(
+    const std::string& type_name,
+    const VisualizerDefinition& visualizer,
+    std::string& error) {
+  auto module_it = type_modules_.find(type_name);
+  if (module_it != type_modules_.end()) {
+    auto layout_it = layouts_.find({module_it->second, visualizer.type_name});
+    if (layout_it != layouts_.end()) {
+      layout_cache_hits_++;
+      return &layout_it->second;
+    }
+  }
+
+  layout_cache_misses_++;
+
+  TypeLayout layout;
+  HRESULT hr = interfaces_->symbols->GetSymbolTypeId(
+      type_name.c_str(), &layout.type_id, &layout.module);
+  if (FAILED(hr)) {
+    error = "Unable to find type " + type_name;
+    return nullptr;
+  }
+
+  hr = interfaces_->symbols->GetTypeSize(layout.module, layout.type_id,
+                                         &layout.size);
+  if (FAILED(hr) || layout.size == 0) {
+    error = "Unable to get the size of type " + type_name;
+    return nullptr;
+  }
+
+  for (const auto& field : visualizer.fields) {
+    ULONG offset = 0;
+    hr = interfaces_->symbols->GetFieldOffset(layout.module, layout.type_id,
+                                              field.name.c_str(), &offset);
+    if (FAILED(hr)) {
+      error = "Unable to find field " + field.name + " in type " + type_name;
+      return nullptr;
+    }
+
+    if (offset + GetFieldKindSize(field.kind) > layout.size) {
+      error = "Field " + field.name + " does not fit inside type " + type_name;
+      return nullptr;
+    }
+
+    layout.field_offsets.push_back(offset);
+  }
+
+  type_modules_[type_name] = layout.module;
+  auto& cached = layouts_[{layout.module, visualizer.type_name}];
+  cached = std::move(layout);
+  return &cached;
+}
+
+std::string VisualizerEngine::FormatElement(
+    const VisualizerDefinition& visualizer,
+    const TypeLayout& layout,
+    const BYTE* element_bytes) {
+  auto read_memory = [this](ULONG64 address, BYTE* buffer, ULONG size) {
+    return ReadMemory(address, buffer, size);
+  };
+
+  FieldValues values(visualizer.fields.size());
+  for (size_t i = 0; i < visualizer.fields.size(); i++) {
+    const BYTE* field_bytes = element_bytes + layout.field_offsets[i];
+    FieldValue& value = values[i];
+    value.kind = visualizer.fields[i].kind;
+
+    switch (value.kind) {
+      case FieldKind::kBool:
+        value.number = field_bytes[0] != 0;
+        break;
+      case FieldKind::kUInt32:
+      case FieldKind::kEnum32:
+        value.number = ReadUInt32(field_bytes);
+        break;
+      case FieldKind::kUInt64:
+        value.number = ReadUInt64(field_bytes);
+        break;
+      case FieldKind::kUInt64Pair:
+        value.number = ReadUInt64(field_bytes);
+        value.number2 = ReadUInt64(field_bytes + 8);
+        break;
+      case FieldKind::kStdString:
+        value.text = DecodeStdString(field_bytes, kMaxDisplayedStringLength,
+                                     read_memory);
+        break;
+    }
+  }
+
+  return visualizer.format(values);
+}
+
+bool VisualizerEngine::RenderValue(const std::string& type_name,
+                                   ULONG64 address,
+                                   std::string& output,
+                                   std::string& error) {
+  const VisualizerDefinition* visualizer = FindVisualizer(type_name);
+  if (!visualizer) {
+    error = "No native visualizer for type " + type_name;
+    return false;
+  }
+
+  const TypeLayout* layout = GetLayout(type_name, *visualizer, error);
+  if (!layout) {
+    return false;
+  }
+
+  std::vector<BYTE> bytes(layout->size);
+  if (!ReadMemory(address, bytes.data(), layout->size)) {
+    error = "Unable to read memory at " + ToHexString(address);
+    return false;
+  }
+
+  output = FormatElement(*visualizer, *layout, bytes.data());
+  return true;
+}
+
+bool VisualizerEngine::RenderVector(const std::string& type_name,
+                                    ULONG64 vector_address,
+                                    size_t max_count,
+                                    std::vector<std::string>& output,
+                                    size_t& total_count,
+                                    std::string& error) {
+  output.clear();
+  total_count = 0;
+
+  const VisualizerDefinition* visualizer = FindVisualizer(type_name);
+  if (!visualizer) {
+    error = "No native visualizer for type " + type_name;
+    return false;
+  }
+
+  const TypeLayout* layout = GetLayout(type_name, *visualizer, error);
+  if (!layout) {
+    return false;
+  }
+
+  // libc++ std::vector layout: [0] begin, [8] end, [16] end of capacity
+  BYTE vector_bytes[kStdVectorSize];
+  if (!ReadMemory(vector_address, vector_bytes, kStdVectorSize)) {
+    error = "Unable to read the vector at " + ToHexString(vector_address);
+    return false;
+  }
+
+  ULONG64 begin = ReadUInt64(vector_bytes);
+  ULONG64 end = ReadUInt64(vector_bytes + 8);
+  if (end < begin || (end - begin) % layout->size != 0) {
+    error = "The vector at " + ToHexString(vector_address) +
+            " does not look like a std::vector<" + visualizer->type_name + ">";
+    return false;
+  }
+
+  total_count = static_cast<size_t>((end - begin) / layout->size);
+  size_t count = total_count;
+  if (max_count > 0 && count > max_count) {
+    count = max_count;
+  }
+  output.reserve(count);
+
+  // Read whole chunks of elements at a time and decode each
+  // element directly out of the chunk buffer.
+  size_t elements_per_chunk =
+      std::max<size_t>(1, kMaxVectorReadChunkSize / layout->size);
+  std::vector<BYTE> chunk;
+
+  for (size_t first = 0; first < count; first += elements_per_chunk) {
+    size_t chunk_count = std::min(elements_per_chunk, count - first);
+    ULONG chunk_size = static_cast<ULONG>(chunk_count * layout->size);
+    ULONG64 chunk_address = begin + first * layout->size;
+
+    chunk.resize(chunk_size);
+    if (!ReadMemory(chunk_address, chunk.data(), chunk_size)) {
+      error = "Unable to read vector elements at " + ToHexString(chunk_address);
+      return false;
+    }
+
+    for (size_t i = 0; i < chunk_count; i++) {
+      output.push_back(FormatElement(*visualizer, *layout,
+                                     chunk.data() + i * layout->size));
+    }
+  }
+
+  return true;
+}
+
+}  // namespace visualizers
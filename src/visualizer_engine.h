@@ -0,0 +1,153 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef VISUALIZER_ENGINE_H_
+#define VISUALIZER_ENGINE_H_
+
+#include <dbgeng.h>
+#include <windows.h>
+#include <functional>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utils.h"
+
+namespace visualizers {
+
+// The kinds of fields that a native visualizer knows how to decode.
+// The size of each kind is fixed so that values can be decoded
+// straight out of a bulk read of the containing type.
+enum class FieldKind {
+  kBool,
+  kUInt32,
+  kUInt64,
+  kEnum32,
+  kUInt64Pair,
+  // A libc++ std::string (std::__Cr::basic_string in Chromium).
+  kStdString,
+};
+
+// Returns the number of bytes that a field of the given kind occupies.
+ULONG GetFieldKindSize(FieldKind kind);
+
+struct FieldSpec {
+  std::string name;
+  FieldKind kind;
+};
+
+// A decoded field value. Only the members that
+// match the field kind are filled in.
+struct FieldValue {
+  FieldKind kind = FieldKind::kUInt64;
+  ULONG64 number = 0;
+  ULONG64 number2 = 0;
+  std::string text;
+};
+
+using FieldValues = std::vector<FieldValue>;
+
+struct VisualizerDefinition {
+  // The type name without the module (e.g. "media::CdmConfig").
+  std::string type_name;
+
+  // The fields which are read from the type. The values passed to the
+  // formatter are in the same order as these specs.
+  std::vector<FieldSpec> fields;
+
+  std::function<std::string(const FieldValues& values)> format;
+};
+
+// The resolved layout of a type in a specific module. This
+// is computed once per (module, type) and then reused for
+// every value of that type which is rendered.
+struct TypeLayout {
+  ULONG64 module = 0;
+  ULONG type_id = 0;
+  ULONG size = 0;
+
+  // Field offsets in the same order as the visualizer field specs.
+  std::vector<ULONG> field_offsets;
+};
+
+// Returns the native visualizers that mirror the JavaScript
+// visualizers in type_signatures.js.
+const std::vector<VisualizerDefinition>& GetBuiltInVisualizers();
+
+// Returns the visualizer for type_name or nullptr if there is none.
+// The module prefix (e.g. "chrome!") is ignored when matching.
+const VisualizerDefinition* FindVisualizer(const std::string& type_name);
+
+// Decodes a libc++ std::string from its 24 byte in-memory
+// representation. Short strings are decoded directly from the bytes.
+// Long strings are read from the target through read_memory.
+// max_length limits how many characters of a long string are read.
+std::string DecodeStdString(
+    const BYTE* bytes,
+    size_t max_length,
+    const std::function<bool(ULONG64, BYTE*, ULONG)>& read_memory);
+
+class VisualizerEngine {
+ public:
+  // If memory_cache is not null then all target memory reads go
+  // through it. The owner of the cache is responsible for forwarding
+  // the engine and debuggee state notifications to it.
+  explicit VisualizerEngine(const utils::DebugInterfaces* interfaces,
+                            utils::MemoryReadCache* memory_cache = nullptr);
+
+  // Render a single value of type_name located at address.
+  // type_name can optionally include a module prefix (e.g. "chrome!").
+  // Returns false and sets error if the value could not be rendered.
+  bool RenderValue(const std::string& type_name,
+                   ULONG64 address,
+                   std::string& output,
+                   std::string& error);
+
+  // Render the elements of a libc++ std::vector<type_name> located at
+  // vector_address. At most max_count elements are rendered (0 means
+  // all of them). The element array is read in large chunks instead of
+  // one read per element or per field.
+  bool RenderVector(const std::string& type_name,
+                    ULONG64 vector_address,
+                    size_t max_count,
+                    std::vector<std::string>& output,
+                    size_t& total_count,
+                    std::string& error);
+
+  // Forget all resolved layouts. This should be called
+  // when symbols are reloaded or modules are unloaded.
+  void ClearCache();
+
+  size_t GetCachedLayoutCount() const { return layouts_.size(); }
+  size_t GetLayoutCacheHits() const { return layout_cache_hits_; }
+  size_t GetLayoutCacheMisses() const { return layout_cache_misses_; }
+
+ private:
+  const TypeLayout* GetLayout(const std::string& type_name,
+                              const VisualizerDefinition& visualizer,
+                              std::string& error);
+
+  bool ReadMemory(ULONG64 address, BYTE* buffer, ULONG size);
+
+  std::string FormatElement(const VisualizerDefinition& visualizer,
+                            const TypeLayout& layout,
+                            const BYTE* element_bytes);
+
+  const utils::DebugInterfaces* interfaces_;
+  utils::MemoryReadCache* memory_cache_;
+
+  // Keyed by (module base, type name without module).
+  std::map<std::pair<ULONG64, std::string>, TypeLayout> layouts_;
+
+  // Maps the type name as passed in by the caller to
+  // the module base that the type was resolved in.
+  std::map<std::string, ULONG64> type_modules_;
+
+  size_t layout_cache_hits_ = 0;
+  size_t layout_cache_misses_ = 0;
+};
+
+}  // namespace visualizers
+
+#endif  // VISUALIZER_ENGINE_H_
@@ -0,0 +1,123 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+// Benchmarks for parsing breakpoints and for the BreakpointList
+// operations which !SetBreakpoints and !ListBreakpoints run over the
+// whole breakpoint history.
+//
+// Usage: bench_breakpoints [benchmark options] (see benchmark_runner.h)
+
+#include <string>
+#include <vector>
+
+#include "../src/breakpoint.h"
+#include "../src/breakpoint_list.h"
+#include "../src/utils.h"
+#include "benchmark_runner.h"
+
+utils::DebugInterfaces g_debug;
+
+namespace {
+
+constexpr size_t kHistorySize = 200;
+
+const std::string kSourceLineBreakpoint =
+    "`chrome!D:\\cs\\src\\media\\mojo\\services\\media_foundation_service.cc:"
+    "520`";
+
+// Only function breakpoints so that the lists are also valid on hosts
+// where the Windows path of a source line breakpoint is rejected.
+const std::string kBreakpointsText =
+    "chrome!media::MediaFoundationService::IsKeySystemSupported, "
+    "media::CdmAdapter::Initialize+0x1c, chrome!media::CdmAdapter::Run, "
+    "ntdll!NtCreateFile, kernel32!ReadFile, kernel32!WriteFile";
+
+// A history where every list has a few breakpoints in a different
+// class and only the last list matches the search terms below.
+std::vector<BreakpointList> MakeHistory() {
+  std::vector<BreakpointList> history;
+  for (size_t i = 0; i < kHistorySize; i++) {
+    std::string name = i + 1 == kHistorySize ? "CdmAdapter" : "Class";
+    std::string prefix = "chrome!media::" + name + std::to_string(i);
+    history.emplace_back(prefix + "::Initialize, " + prefix + "::Run, " +
+                             prefix + "::OnError",
+                         "", "tag_" + std::to_string(i));
+  }
+  return history;
+}
+
+const std::vector<BreakpointList>& GetHistory() {
+  static const std::vector<BreakpointList> history = MakeHistory();
+  return history;
+}
+
+}  // namespace
+
+DECLARE_BENCHMARK_RUNNER()
+
+BENCHMARK(Breakpoint_ParseFunction) {
+  BenchmarkKeep(
+      Breakpoint("chrome!media::MediaFoundationService::IsKeySystemSupported"));
+}
+
+BENCHMARK(Breakpoint_ParseSourceLine) {
+  BenchmarkKeep(Breakpoint(kSourceLineBreakpoint));
+}
+
+BENCHMARK(Breakpoint_GetFullString) {
+  static const Breakpoint breakpoint(kSourceLineBreakpoint);
+  BenchmarkKeep(breakpoint.GetFullString());
+}
+
+BENCHMARK(BreakpointList_ParseDelimited) {
+  BenchmarkKeep(BreakpointList(kBreakpointsText, "chrome", "media"));
+}
+
+BENCHMARK(BreakpointList_GetCombinedCommandString) {
+  static const BreakpointList list(kBreakpointsText, "chrome");
+  BenchmarkKeep(list.GetCombinedCommandString());
+}
+
+BENCHMARK(BreakpointList_IsEqualTo) {
+  static const BreakpointList list(kBreakpointsText, "chrome");
+  static const BreakpointList other(kBreakpointsText, "chrome");
+  BenchmarkKeep(list.IsEqualTo(other));
+}
+
+BENCHMARK(BreakpointList_Combine) {
+  static const BreakpointList list(kBreakpointsText, "chrome");
+  static const BreakpointList other("chrome!media::Foo, chrome!media::Bar");
+  BenchmarkKeep(BreakpointList::CombineBreakpointLists(list, other));
+}
+
+BENCHMARK(History_SearchText) {
+  size_t matches = 0;
+  for (const BreakpointList& list : GetHistory()) {
+    matches += list.HasTextMatch("cdmadapter") ? 1 : 0;
+  }
+  BenchmarkKeep(matches);
+}
+
+BENCHMARK(History_SearchTag) {
+  size_t matches = 0;
+  for (const BreakpointList& list : GetHistory()) {
+    matches += list.HasTagMatch("TAG_199") ? 1 : 0;
+  }
+  BenchmarkKeep(matches);
+}
+
+BENCHMARK(History_FindDuplicate) {
+  static const BreakpointList list = GetHistory().back();
+  size_t index = 0;
+  for (const BreakpointList& other : GetHistory()) {
+    if (other.IsEqualTo(list)) {
+      break;
+    }
+    index++;
+  }
+  BenchmarkKeep(index);
+}
+
+int main(int argc, char* argv[]) {
+  return RUN_ALL_BENCHMARKS(argc, argv);
+}
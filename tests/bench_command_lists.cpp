@@ -0,0 +1,135 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+// Benchmarks for the command list lookups which run on every break
+// (finding the closest command lists to the current source line) and
+// for the lookups of !RunCommandList by index, line and name. The
+// current source line comes from the mock debug interfaces.
+//
+// Usage: bench_command_lists [benchmark options] (see benchmark_runner.h)
+
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../src/command_list.h"
+#include "../src/utils.h"
+#include "benchmark_runner.h"
+#include "debug_interfaces_test_base.h"
+
+// Globals and functions from command_lists.cpp
+extern utils::DebugInterfaces g_debug;
+extern std::vector<CommandList> g_command_lists;
+
+extern std::vector<std::pair<size_t, CommandList*>> GetClosestCommandLists(
+    int source_line,
+    const std::string& source_file);
+extern CommandList* FindCommandList(const std::string& name_or_line);
+
+namespace {
+
+constexpr size_t kFileCount = 20;
+constexpr size_t kListsPerFile = 25;
+
+const char kCurrentFile[] = "D:\\cs\\src\\media\\base\\file_10.cc";
+constexpr int kCurrentLine = 520;
+
+std::string GetFileName(size_t index) {
+  return "D:\\cs\\src\\media\\base\\file_" + std::to_string(index) + ".cc";
+}
+
+// The mock engine is stopped at kCurrentFile:kCurrentLine.
+class BenchmarkSetup : public DebugInterfacesTestBase {
+ public:
+  BenchmarkSetup() : DebugInterfacesTestBase(g_debug) {
+    mock_symbols->SetMethodOverride(
+        "GetScope",
+        [](PULONG64 offset, PDEBUG_STACK_FRAME frame, PVOID scope_context,
+           ULONG scope_context_size) -> HRESULT {
+          *offset = 0x7ff9a5b1e2c0;
+          return S_OK;
+        });
+    mock_symbols->SetMethodOverride(
+        "GetLineByOffset",
+        [](ULONG64 offset, PULONG line, PSTR file_buffer,
+           ULONG file_buffer_size, PULONG file_size,
+           PULONG64 displacement) -> HRESULT {
+          *line = kCurrentLine;
+          strncpy(file_buffer, kCurrentFile, file_buffer_size);
+          return S_OK;
+        });
+    mock_client->SetMethodOverride(
+        "GetOutputCallbacks",
+        [](PDEBUG_OUTPUT_CALLBACKS* callbacks) -> HRESULT {
+          *callbacks = nullptr;
+          return S_OK;
+        });
+    mock_client->SetMethodOverride(
+        "SetOutputCallbacks",
+        [](PDEBUG_OUTPUT_CALLBACKS callbacks) -> HRESULT { return S_OK; });
+    mock_control->SetMethodOverride(
+        "Execute",
+        [](ULONG output_control, PCSTR command, ULONG flags) -> HRESULT {
+          return S_OK;
+        });
+
+    // Command lists spread over a number of files with
+    // one list every 40 lines in each of the files.
+    g_command_lists.clear();
+    for (size_t i = 0; i < kFileCount * kListsPerFile; i++) {
+      int line = static_cast<int>((i / kFileCount) * 40 + 10);
+      g_command_lists.emplace_back(
+          std::vector<std::string>{"dv", "k", "dx this"}, line,
+          GetFileName(i % kFileCount), "list_" + std::to_string(i),
+          "Inspect the state");
+    }
+  }
+};
+
+BenchmarkSetup& GetSetup() {
+  static BenchmarkSetup setup;
+  return setup;
+}
+
+}  // namespace
+
+DECLARE_BENCHMARK_RUNNER()
+
+BENCHMARK(GetClosestCommandLists) {
+  GetSetup();
+  BenchmarkKeep(GetClosestCommandLists(kCurrentLine, kCurrentFile));
+}
+
+BENCHMARK(FindCommandList_Closest) {
+  GetSetup().ClearCallHistory();
+  BenchmarkKeep(FindCommandList(""));
+}
+
+BENCHMARK(FindCommandList_Line) {
+  GetSetup().ClearCallHistory();
+  BenchmarkKeep(FindCommandList(".:" + std::to_string(kCurrentLine - 10)));
+}
+
+BENCHMARK(FindCommandList_Index) {
+  GetSetup();
+  BenchmarkKeep(FindCommandList("321"));
+}
+
+BENCHMARK(FindCommandList_Name) {
+  GetSetup();
+  BenchmarkKeep(FindCommandList("LIST_499"));
+}
+
+BENCHMARK(CommandList_HasTextMatch) {
+  GetSetup();
+  size_t matches = 0;
+  for (const CommandList& list : g_command_lists) {
+    matches += list.HasTextMatch("dx this") ? 1 : 0;
+  }
+  BenchmarkKeep(matches);
+}
+
+int main(int argc, char* argv[]) {
+  return RUN_ALL_BENCHMARKS(argc, argv);
+}
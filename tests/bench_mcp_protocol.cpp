@@ -0,0 +1,346 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+// Benchmarks for the MCP message framing and for handling requests up
+// to the tool handler: parsing a message, building the response and
+// serializing it. The handler returns canned results with the size of
+// typical executeCommand output so that the cost of the protocol layer
+// can be measured without a debugger engine or sockets.
+//
+// The *_Dump benchmarks are the serialization with JSON::dump() which
+// was used before json_writer, for comparison.
+//
+// Usage: bench_mcp_protocol [benchmark options] (see benchmark_runner.h)
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+
+#include "../src/json_writer.h"
+#include "../src/mcp_protocol.h"
+#include "../src/tool_registry.h"
+#include "../src/utils.h"
+#include "benchmark_runner.h"
+
+utils::DebugInterfaces g_debug;
+
+namespace {
+
+constexpr size_t kPipelinedRequests = 100;
+constexpr size_t kReceiveSize = 4096;
+constexpr size_t kToolCount = 24;
+
+std::string MakeToolsCall(size_t id) {
+  return JSON{{"jsonrpc", "2.0"},
+              {"id", id},
+              {"method", "tools/call"},
+              {"params",
+               {{"name", "executeCommand"},
+                {"arguments", {{"command", "dv /t /v"}, {"raw", false}}}}}}
+             .dump();
+}
+
+// The output of "k" with 40 frames (roughly 4 KB).
+std::string MakeCommandOutput() {
+  std::string output = " # Child-SP          RetAddr               Call Site\n";
+  for (int i = 0; i < 40; i++) {
+    char frame[128];
+    snprintf(frame, sizeof(frame),
+             "%02x 00000031`0b3ff%03x 00007ff9`a5b1e%03x     "
+             "chrome!media::Foo::Bar%d+0x%x\n",
+             i, i * 16, i * 32, i, i * 4);
+    output += frame;
+  }
+  return output;
+}
+
+// The output of "k" and "lm" repeated to about 4 MB, which is
+// what dumping a large structure or a module list returns.
+std::string MakeLargeCommandOutput() {
+  std::string frames = MakeCommandOutput();
+  std::string modules;
+  for (int i = 0; i < 20; i++) {
+    char module[160];
+    snprintf(module, sizeof(module),
+             "00007ff9`a5b%02x000 00007ff9`a5c%02x000   module%d   "
+             "(private pdb symbols)  D:\\cs\\src\\out\\Default\\"
+             "module%d.dll.pdb\n",
+             i, i, i, i);
+    modules += module;
+  }
+
+  std::string output;
+  while (output.size() < 4 * 1024 * 1024) {
+    output += frames;
+    output += modules;
+  }
+  return output;
+}
+
+const std::string& GetLargeCommandOutput() {
+  static const std::string output = MakeLargeCommandOutput();
+  return output;
+}
+
+JSON MakeToolsList() {
+  JSON tools = JSON::array();
+  for (size_t i = 0; i < kToolCount; i++) {
+    tools.push_back(
+        {{"name", "tool" + std::to_string(i)},
+         {"description",
+          "Runs an operation against the current debugging session and "
+          "returns the output as text."},
+         {"inputSchema",
+          {{"type", "object"},
+           {"properties",
+            {{"command",
+              {{"type", "string"}, {"description", "The command to run"}}},
+             {"limit",
+              {{"type", "integer"},
+               {"description", "The maximum number of results"}}}}},
+           {"required", JSON::array({"command"})}}}});
+  }
+  return JSON{{"tools", tools}};
+}
+
+tool_registry::ToolRegistry& GetToolRegistry() {
+  static tool_registry::ToolRegistry* registry = [] {
+    auto* tools = new tool_registry::ToolRegistry();
+    JSON tools_list = MakeToolsList();
+    for (JSON& tool : tools_list["tools"]) {
+      tools->Register(std::move(tool));
+    }
+    return tools;
+  }();
+  return *registry;
+}
+
+// A handler with the dispatch of MCPServer::HandleRequest.
+JSON HandleRequest(const mcp_protocol::Request& request) {
+  static const std::string output = MakeCommandOutput();
+
+  const std::string& method = request.method;
+  const JSON& id = request.id;
+
+  if (method == "tools/list") {
+    return mcp_protocol::CreateResponse(
+        id, json_writer::MakeRaw(*GetToolRegistry().GetToolsList()));
+  } else if (method == "tools/call") {
+    std::string command = request.arguments.value("command", "");
+    return mcp_protocol::CreateResponse(
+        id, mcp_protocol::CreateToolResult(command + "\n" + output));
+  }
+  return mcp_protocol::CreateError(id, mcp_protocol::kMethodNotFound,
+                                   "Method not found: " + method);
+}
+
+// A symbolize call with 200 addresses.
+std::string MakeSymbolizeCall() {
+  JSON addresses = JSON::array();
+  for (int i = 0; i < 200; i++) {
+    addresses.push_back("0x7ff9a5b1" + std::to_string(1000 + i * 16));
+  }
+  return JSON{{"jsonrpc", "2.0"},
+              {"id", 7},
+              {"method", "tools/call"},
+              {"params",
+               {{"name", "symbolize"},
+                {"arguments", {{"addresses", addresses}}},
+                {"_meta", {{"progressToken", "p1"}}}}}}
+      .dump();
+}
+
+// The decoding which MCPServer::HandleRequest and HandleToolsCall did
+// before DecodeRequest: the whole message is parsed and then params
+// and arguments are copied out of it.
+JSON DecodeWithDom(const std::string& message) {
+  JSON request = JSON::parse(message);
+  std::string method = request.value("method", "");
+  JSON params = request.value("params", JSON::object());
+  JSON id = request.contains("id") ? request["id"] : JSON();
+  std::string tool_name = params.value("name", "");
+  JSON arguments = params.value("arguments", JSON::object());
+  return arguments;
+}
+
+// kPipelinedRequests requests sent back to back.
+const std::string& GetPipelinedStream() {
+  static const std::string stream = [] {
+    std::string text;
+    for (size_t i = 0; i < kPipelinedRequests; i++) {
+      text += MakeToolsCall(i) + "\n";
+    }
+    return text;
+  }();
+  return stream;
+}
+
+}  // namespace
+
+DECLARE_BENCHMARK_RUNNER()
+
+// Frames the pipelined stream as it arrives in receives of kReceiveSize.
+BENCHMARK(MessageFramer_Pipelined) {
+  const std::string& stream = GetPipelinedStream();
+  mcp_protocol::MessageFramer framer;
+  std::string message;
+  size_t count = 0;
+  for (size_t offset = 0; offset < stream.size(); offset += kReceiveSize) {
+    framer.Append(stream.data() + offset,
+                  std::min(kReceiveSize, stream.size() - offset));
+    while (framer.Next(message)) {
+      count++;
+    }
+  }
+  BenchmarkKeep(count);
+}
+
+// The framing which the server used before MessageFramer.
+BENCHMARK(MessageFramer_EraseBaseline) {
+  const std::string& stream = GetPipelinedStream();
+  std::string buffer;
+  size_t count = 0;
+  for (size_t offset = 0; offset < stream.size(); offset += kReceiveSize) {
+    buffer.append(stream.data() + offset,
+                  std::min(kReceiveSize, stream.size() - offset));
+    size_t pos;
+    while ((pos = buffer.find('\n')) != std::string::npos) {
+      std::string message = buffer.substr(0, pos);
+      buffer.erase(0, pos + 1);
+      BenchmarkKeep(message);
+      count++;
+    }
+  }
+  BenchmarkKeep(count);
+}
+
+BENCHMARK(ProcessMessage_ToolsCall) {
+  static const std::string request = MakeToolsCall(42);
+  BenchmarkKeep(mcp_protocol::ProcessMessage(request, HandleRequest));
+}
+
+BENCHMARK(ProcessMessage_ToolsList) {
+  static const std::string request =
+      "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"tools/list\"}";
+  BenchmarkKeep(mcp_protocol::ProcessMessage(request, HandleRequest));
+}
+
+// tools/list as it was handled before the tool registry: the
+// definitions are built for every request.
+BENCHMARK(ProcessMessage_ToolsList_Rebuild) {
+  static const std::string request =
+      "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"tools/list\"}";
+  auto handler = [](const mcp_protocol::Request& request) {
+    return mcp_protocol::CreateResponse(request.id, MakeToolsList());
+  };
+  BenchmarkKeep(mcp_protocol::ProcessMessage(request, handler));
+}
+
+BENCHMARK(ProcessMessage_ParseError) {
+  BenchmarkKeep(mcp_protocol::ProcessMessage("{\"jsonrpc\":\"2.0\",\"id\":",
+                                             HandleRequest));
+}
+
+BENCHMARK(ProcessMessage_Pipelined) {
+  const std::string& stream = GetPipelinedStream();
+  mcp_protocol::MessageFramer framer;
+  framer.Append(stream.data(), stream.size());
+  std::string message;
+  size_t response_size = 0;
+  while (framer.Next(message)) {
+    response_size += mcp_protocol::ProcessMessage(message, HandleRequest).size();
+  }
+  BenchmarkKeep(response_size);
+}
+
+BENCHMARK(DecodeRequest_ToolsCall) {
+  static const std::string request = MakeToolsCall(42);
+  BenchmarkKeep(mcp_protocol::DecodeRequest(request));
+}
+
+BENCHMARK(DecodeRequest_ToolsCall_Dom) {
+  static const std::string request = MakeToolsCall(42);
+  BenchmarkKeep(DecodeWithDom(request));
+}
+
+BENCHMARK(DecodeRequest_Symbolize) {
+  static const std::string request = MakeSymbolizeCall();
+  BenchmarkKeep(mcp_protocol::DecodeRequest(request));
+}
+
+BENCHMARK(DecodeRequest_Symbolize_Dom) {
+  static const std::string request = MakeSymbolizeCall();
+  BenchmarkKeep(DecodeWithDom(request));
+}
+
+BENCHMARK(ToolRegistry_Validate) {
+  static const JSON arguments = {{"command", "dv /t /v"}, {"limit", 10}};
+  BenchmarkKeep(GetToolRegistry().Validate("tool3", arguments));
+}
+
+BENCHMARK(Serialize_LargeToolResult) {
+  static const JSON response = mcp_protocol::CreateResponse(
+      42, mcp_protocol::CreateToolResult(GetLargeCommandOutput()));
+  static std::string output;
+  output.clear();
+  json_writer::AppendJson(output, response);
+  output += '\n';
+  BenchmarkKeep(output);
+}
+
+BENCHMARK(Serialize_LargeToolResult_Dump) {
+  static const JSON response = mcp_protocol::CreateResponse(
+      42, mcp_protocol::CreateToolResult(GetLargeCommandOutput()));
+  BenchmarkKeep(response.dump() + "\n");
+}
+
+BENCHMARK(Serialize_ToolsList) {
+  static const JSON response =
+      mcp_protocol::CreateResponse(1, MakeToolsList());
+  static std::string output;
+  output.clear();
+  json_writer::AppendJson(output, response);
+  BenchmarkKeep(output);
+}
+
+BENCHMARK(Serialize_ToolsList_Dump) {
+  static const JSON response =
+      mcp_protocol::CreateResponse(1, MakeToolsList());
+  BenchmarkKeep(response.dump());
+}
+
+// A tools/call request whose handler returns 4 MB of output, from the
+// output string of the engine to the bytes which are sent.
+BENCHMARK(ProcessMessage_LargeToolsCall) {
+  static const std::string request = MakeToolsCall(42);
+  static std::string output;
+  auto handler = [](const mcp_protocol::Request& request) {
+    std::string command_output = GetLargeCommandOutput();
+    return mcp_protocol::CreateResponse(
+        request.id,
+        mcp_protocol::CreateToolResult(JSON(std::move(command_output))));
+  };
+  output.clear();
+  mcp_protocol::ProcessMessage(request, handler, output);
+  BenchmarkKeep(output);
+}
+
+// The same request handled the way it was before json_writer: the
+// output is copied into each of the nested JSON objects and the
+// response is serialized with dump() and copied to add the newline.
+BENCHMARK(ProcessMessage_LargeToolsCall_Dump) {
+  static const std::string request = MakeToolsCall(42);
+  JSON parsed = JSON::parse(request);
+  std::string command_output = GetLargeCommandOutput();
+  JSON result = JSON(command_output);
+  JSON tool_result = {
+      {"content",
+       JSON::array({{{"type", "text"}, {"text", result.get<std::string>()}}})}};
+  JSON response = {{"jsonrpc", "2.0"}, {"result", tool_result}};
+  response["id"] = parsed["id"];
+  BenchmarkKeep(response.dump() + "\n");
+}
+
+int main(int argc, char* argv[]) {
+  return RUN_ALL_BENCHMARKS(argc, argv);
+}
@@ -0,0 +1,244 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+// Benchmark for the native visualizers. Renders a std::vector of 10,000
+// media::CdmConfig elements through the mock data spaces and compares
+// the cached layout / bulk read path of the VisualizerEngine with a
+// naive path that resolves the field offsets and reads each field
+// separately for every element (which is roughly what evaluating the
+// JavaScript visualizer for every element costs).
+//
+// Every call into the mock engine interfaces is charged a fixed
+// simulated latency so that the results reflect the cost of the engine
+// round trips instead of just the cost of the mock bookkeeping.
+
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../src/utils.h"
+#include "../src/visualizer_engine.h"
+#include "debug_interfaces_test_base.h"
+#include "mocks/fake_target_memory.h"
+
+namespace {
+
+constexpr ULONG64 kModuleBase = 0x7ff600000000;
+constexpr ULONG kCdmConfigTypeId = 10;
+constexpr ULONG kCdmConfigSize = 32;
+constexpr size_t kElementCount = 10000;
+constexpr ULONG64 kVectorAddress = 0x2000;
+constexpr ULONG64 kElementsAddress = 0x100000;
+constexpr ULONG64 kStringDataAddress = 0x10000000;
+
+// Simulated cost of a single call into the debugger engine.
+constexpr auto kSimulatedCallLatency = std::chrono::microseconds(2);
+
+utils::DebugInterfaces g_debug;
+
+size_t g_engine_calls = 0;
+
+void SimulateEngineCall() {
+  g_engine_calls++;
+  auto end = std::chrono::steady_clock::now() + kSimulatedCallLatency;
+  while (std::chrono::steady_clock::now() < end) {
+  }
+}
+
+class BenchmarkSetup : public DebugInterfacesTestBase {
+ public:
+  FakeTargetMemory memory;
+
+  BenchmarkSetup() : DebugInterfacesTestBase(g_debug) {
+    SetupSymbols();
+    SetupMemory();
+
+    mock_data_spaces->SetMethodOverride(
+        "ReadVirtual", [this](ULONG64 offset, PVOID buffer, ULONG buffer_size,
+                              PULONG bytes_read) -> HRESULT {
+          SimulateEngineCall();
+          return memory.Read(offset, buffer, buffer_size, bytes_read);
+        });
+  }
+
+ private:
+  void SetupSymbols() {
+    mock_symbols->SetMethodOverride(
+        "GetSymbolTypeId",
+        [](PCSTR symbol, PULONG type_id, PULONG64 module) -> HRESULT {
+          SimulateEngineCall();
+          *type_id = kCdmConfigTypeId;
+          *module = kModuleBase;
+          return S_OK;
+        });
+
+    mock_symbols->SetMethodOverride(
+        "GetTypeSize",
+        [](ULONG64 module, ULONG type_id, PULONG size) -> HRESULT {
+          SimulateEngineCall();
+          *size = kCdmConfigSize;
+          return S_OK;
+        });
+
+    mock_symbols->SetMethodOverride(
+        "GetFieldOffset",
+        [](ULONG64 module, ULONG type_id, PCSTR field,
+           PULONG offset) -> HRESULT {
+          static const std::map<std::string, ULONG> fields = {
+              {"key_system", 0},
+              {"allow_distinctive_identifier", 24},
+              {"allow_persistent_state", 25},
+              {"use_hw_secure_codecs", 26}};
+
+          SimulateEngineCall();
+          auto it = fields.find(field);
+          if (it == fields.end()) {
+            return E_FAIL;
+          }
+          *offset = it->second;
+          return S_OK;
+        });
+  }
+
+  // Every tenth element uses a long (heap allocated) key system
+  // string so that both string representations are exercised.
+  void SetupMemory() {
+    std::string long_text = "com.example.a.very.long.key.system.name";
+    std::vector<BYTE> string_data(long_text.begin(), long_text.end());
+    memory.AddRegion(kStringDataAddress, string_data);
+
+    std::vector<BYTE> elements(kElementCount * kCdmConfigSize, 0);
+    for (size_t i = 0; i < kElementCount; i++) {
+      BYTE* element = elements.data() + i * kCdmConfigSize;
+      if (i % 10 == 0) {
+        ULONG64 data = kStringDataAddress;
+        ULONG64 size = long_text.size();
+        memcpy(element, &data, 8);
+        memcpy(element + 8, &size, 8);
+        element[23] |= 0x80;
+      } else {
+        std::string text = "org.w3.clearkey";
+        memcpy(element, text.data(), text.size());
+        element[23] = static_cast<BYTE>(text.size());
+      }
+      element[24] = i % 2;
+      element[25] = i % 3 == 0;
+      element[26] = 1;
+    }
+    memory.AddRegion(kElementsAddress, elements);
+
+    std::vector<BYTE> vector_bytes(24, 0);
+    ULONG64 begin = kElementsAddress;
+    ULONG64 end = kElementsAddress + elements.size();
+    memcpy(vector_bytes.data(), &begin, 8);
+    memcpy(vector_bytes.data() + 8, &end, 8);
+    memcpy(vector_bytes.data() + 16, &end, 8);
+    memory.AddRegion(kVectorAddress, vector_bytes);
+  }
+};
+
+bool ReadTarget(ULONG64 address, BYTE* buffer, ULONG size) {
+  ULONG bytes_read = 0;
+  HRESULT hr = g_debug.data_spaces->ReadVirtual(address, buffer, size,
+                                                &bytes_read);
+  return SUCCEEDED(hr) && bytes_read == size;
+}
+
+// Resolves the type and every field offset for each element
+// and then reads each field with a separate memory read.
+size_t RenderNaive() {
+  BYTE vector_bytes[24];
+  ReadTarget(kVectorAddress, vector_bytes, sizeof(vector_bytes));
+  ULONG64 begin = 0;
+  ULONG64 end = 0;
+  memcpy(&begin, vector_bytes, 8);
+  memcpy(&end, vector_bytes + 8, 8);
+
+  const visualizers::VisualizerDefinition* visualizer =
+      visualizers::FindVisualizer("media::CdmConfig");
+  auto read_memory = [](ULONG64 address, BYTE* buffer, ULONG size) {
+    return ReadTarget(address, buffer, size);
+  };
+
+  size_t total_length = 0;
+  for (ULONG64 address = begin; address < end; address += kCdmConfigSize) {
+    ULONG type_id = 0;
+    ULONG64 module = 0;
+    g_debug.symbols->GetSymbolTypeId("media::CdmConfig", &type_id, &module);
+
+    visualizers::FieldValues values(visualizer->fields.size());
+    for (size_t i = 0; i < visualizer->fields.size(); i++) {
+      const auto& field = visualizer->fields[i];
+      ULONG offset = 0;
+      g_debug.symbols->GetFieldOffset(module, type_id, field.name.c_str(),
+                                      &offset);
+
+      BYTE field_bytes[24] = {};
+      ULONG field_size = visualizers::GetFieldKindSize(field.kind);
+      ReadTarget(address + offset, field_bytes, field_size);
+
+      values[i].kind = field.kind;
+      if (field.kind == visualizers::FieldKind::kStdString) {
+        values[i].text =
+            visualizers::DecodeStdString(field_bytes, 1024, read_memory);
+      } else {
+        values[i].number = field_bytes[0];
+      }
+    }
+
+    total_length += visualizer->format(values).size();
+  }
+
+  return total_length;
+}
+
+size_t RenderWithEngine(visualizers::VisualizerEngine& engine) {
+  std::vector<std::string> output;
+  size_t total_count = 0;
+  std::string error;
+  if (!engine.RenderVector("media::CdmConfig", kVectorAddress, 0, output,
+                           total_count, error)) {
+    printf("Error: %s\n", error.c_str());
+    return 0;
+  }
+
+  size_t total_length = 0;
+  for (const auto& element : output) {
+    total_length += element.size();
+  }
+  return total_length;
+}
+
+template <typename Function>
+void RunBenchmark(const char* name, Function function) {
+  g_engine_calls = 0;
+  auto start = std::chrono::steady_clock::now();
+  size_t total_length = function();
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  double ms = std::chrono::duration<double, std::milli>(elapsed).count();
+  printf("%-28s %10.2f ms %10zu engine calls %10zu chars\n", name, ms,
+         g_engine_calls, total_length);
+}
+
+}  // namespace
+
+int main() {
+  BenchmarkSetup setup;
+
+  printf("Rendering std::vector<media::CdmConfig> with %zu elements\n\n",
+         kElementCount);
+
+  RunBenchmark("Naive (per element)", [] { return RenderNaive(); });
+
+  visualizers::VisualizerEngine engine(&g_debug);
+  RunBenchmark("Engine (cold layout cache)",
+               [&engine] { return RenderWithEngine(engine); });
+  RunBenchmark("Engine (warm layout cache)",
+               [&engine] { return RenderWithEngine(engine); });
+
+  return 0;
+}
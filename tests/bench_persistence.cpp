@@ -0,0 +1,132 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+// Benchmarks for the JSON persistence of the breakpoint history and of
+// command lists. The history is written and read back with
+// BreakpointList::WriteToFile and ReadFromFile, which the extension
+// runs after every !SetBreakpoints and on load. Command lists are
+// converted with CommandList::ToJson and FromJson.
+//
+// Usage: bench_persistence [benchmark options] (see benchmark_runner.h)
+
+#include <filesystem>
+#include <string>
+#include <vector>
+
+#include "../src/breakpoint_list.h"
+#include "../src/command_list.h"
+#include "benchmark_runner.h"
+
+namespace {
+
+constexpr size_t kHistorySize = 200;
+constexpr size_t kCommandListCount = 200;
+
+std::vector<BreakpointList> MakeHistory() {
+  std::vector<BreakpointList> history;
+  for (size_t i = 0; i < kHistorySize; i++) {
+    std::string prefix = "chrome!media::Class" + std::to_string(i);
+    history.emplace_back(prefix + "::Initialize, " + prefix + "::Run, " +
+                             prefix + "::OnError",
+                         "", "tag_" + std::to_string(i));
+  }
+  return history;
+}
+
+std::vector<CommandList> MakeCommandLists() {
+  std::vector<CommandList> lists;
+  for (size_t i = 0; i < kCommandListCount; i++) {
+    lists.emplace_back(
+        std::vector<std::string>{"dv", "k", "dx this->state_", "g"},
+        static_cast<int>(i * 10),
+        "D:\\cs\\src\\media\\base\\file_" + std::to_string(i % 20) + ".cc",
+        "list_" + std::to_string(i), "Inspect the state of the decoder",
+        "   518:   if (!initialized_)\n>  519:     return;\n");
+  }
+  return lists;
+}
+
+// The history file in the temp directory. The history
+// is written once so that it can be read back.
+const std::string& GetHistoryFile() {
+  static const std::string path = [] {
+    std::string path =
+        (std::filesystem::temp_directory_path() / "bench_persistence.json")
+            .string();
+    BreakpointList::WriteToFile(MakeHistory(), path);
+    return path;
+  }();
+  return path;
+}
+
+const std::string& GetHistoryText() {
+  static const std::string text = [] {
+    JSON json = JSON::array();
+    for (const BreakpointList& list : MakeHistory()) {
+      json.push_back(list.ToJson());
+    }
+    return json.dump(4);
+  }();
+  return text;
+}
+
+}  // namespace
+
+DECLARE_BENCHMARK_RUNNER()
+
+BENCHMARK(History_ToJson) {
+  static const std::vector<BreakpointList> history = MakeHistory();
+  JSON json = JSON::array();
+  for (const BreakpointList& list : history) {
+    json.push_back(list.ToJson());
+  }
+  BenchmarkKeep(json.dump(4));
+}
+
+BENCHMARK(History_FromJson) {
+  JSON json = JSON::parse(GetHistoryText());
+  std::vector<BreakpointList> history;
+  for (const auto& item : json) {
+    history.push_back(BreakpointList::FromJson(item));
+  }
+  BenchmarkKeep(history);
+}
+
+BENCHMARK(History_WriteFile) {
+  static const std::vector<BreakpointList> history = MakeHistory();
+  BenchmarkKeep(BreakpointList::WriteToFile(history, GetHistoryFile()));
+}
+
+BENCHMARK(History_ReadFile) {
+  BenchmarkKeep(BreakpointList::ReadFromFile(GetHistoryFile()));
+}
+
+BENCHMARK(CommandLists_ToJson) {
+  static const std::vector<CommandList> lists = MakeCommandLists();
+  JSON json = JSON::array();
+  for (const CommandList& list : lists) {
+    json.push_back(list.ToJson());
+  }
+  BenchmarkKeep(json.dump(4));
+}
+
+BENCHMARK(CommandLists_FromJson) {
+  static const std::string text = [] {
+    JSON json = JSON::array();
+    for (const CommandList& list : MakeCommandLists()) {
+      json.push_back(list.ToJson());
+    }
+    return json.dump(4);
+  }();
+
+  JSON json = JSON::parse(text);
+  std::vector<CommandList> lists;
+  for (const auto& item : json) {
+    lists.push_back(CommandList::FromJson(item));
+  }
+  BenchmarkKeep(lists);
+}
+
+int main(int argc, char* argv[]) {
+  return RUN_ALL_BENCHMARKS(argc, argv);
+}
@@ -0,0 +1,149 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+// Benchmark for source_search::Search (used by !BreakOnPattern). Compares
+// running the regex on every line with a single thread against the
+// literal prefilter on a single thread and on all hardware threads.
+//
+// Usage: bench_source_search [directory [regex]]
+//
+// Without a directory a synthetic tree with roughly the shape of a
+// Chromium sub tree (many directories of small C++ files where only a
+// few lines match) is generated in the temp directory. Pass the root of
+// a real checkout (e.g. ~/chromium/src) to measure a full tree. The
+// first run also includes the cost of reading the files from disk.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+
+#include "../src/source_search.h"
+#include "../src/utils.h"
+
+utils::DebugInterfaces g_debug;
+
+namespace {
+
+constexpr size_t kDirectoryCount = 250;
+constexpr size_t kFilesPerDirectory = 40;
+constexpr size_t kLinesPerFile = 150;
+
+// One in this many files contains a matching definition.
+constexpr size_t kMatchingFileInterval = 50;
+
+const char kDefaultPattern[] = R"(void\s+\w+::OnDataReceived\()";
+
+std::filesystem::path GenerateSourceTree() {
+  std::filesystem::path root =
+      std::filesystem::temp_directory_path() / "bench_source_search";
+  std::filesystem::remove_all(root);
+
+  size_t file_index = 0;
+  for (size_t d = 0; d < kDirectoryCount; d++) {
+    std::filesystem::path directory =
+        root / ("component_" + std::to_string(d % 25)) /
+        ("module_" + std::to_string(d));
+    std::filesystem::create_directories(directory);
+
+    for (size_t f = 0; f < kFilesPerDirectory; f++, file_index++) {
+      std::string name = "source_file_" + std::to_string(f);
+      std::ofstream file(directory / (name + (f % 2 ? ".h" : ".cc")));
+
+      file << "// Copyright 2025 The Chromium Authors\n\n";
+      file << "#include \"" << name << ".h\"\n\n";
+      for (size_t line = 0; line < kLinesPerFile; line++) {
+        switch (line % 5) {
+          case 0:
+            file << "void Handler" << line << "::OnDataSent(int size) {\n";
+            break;
+          case 1:
+            file << "  DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);\n";
+            break;
+          case 2:
+            file << "  // OnDataReceived is called once the data arrives.\n";
+            break;
+          case 3:
+            file << "  weak_factory_.GetWeakPtr()->Process(size, "
+                    "base::BindOnce(&Handler::Done));\n";
+            break;
+          default:
+            file << "}\n";
+        }
+      }
+
+      if (file_index % kMatchingFileInterval == 0) {
+        file << "void Handler::OnDataReceived(int size) {\n}\n";
+      }
+    }
+  }
+
+  return root;
+}
+
+void RunBenchmark(const char* name,
+                  const std::string& directory,
+                  const std::string& pattern,
+                  const source_search::SearchOptions& options) {
+  auto start = std::chrono::steady_clock::now();
+  source_search::SearchResult result =
+      source_search::Search(directory, pattern, options);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  if (!result.error.empty()) {
+    printf("Error: %s\n", result.error.c_str());
+    return;
+  }
+
+  double ms = std::chrono::duration<double, std::milli>(elapsed).count();
+  double mb = result.bytes_searched / (1024.0 * 1024.0);
+  printf("%-28s %10.2f ms %10.1f MB/s %12zu lines checked %8zu matches\n",
+         name, ms, mb / (ms / 1000.0), result.lines_checked,
+         result.matches.size());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  std::string directory;
+  bool generated = false;
+  if (argc > 1) {
+    directory = argv[1];
+  } else {
+    printf("Generating %zu files...\n", kDirectoryCount * kFilesPerDirectory);
+    directory = GenerateSourceTree().string();
+    generated = true;
+  }
+  std::string pattern = argc > 2 ? argv[2] : kDefaultPattern;
+
+  source_search::SearchOptions options;
+  options.max_matches = ~size_t{0};
+
+  printf("Searching %s for '%s' (literal \"%s\")\n\n", directory.c_str(),
+         pattern.c_str(), source_search::ExtractRequiredLiteral(pattern).c_str());
+
+  // The first run also warms the file cache for the runs that follow.
+  options.threads = 0;
+  RunBenchmark("Prefilter (cold)", directory, pattern, options);
+
+  options.threads = 1;
+  options.use_prefilter = false;
+  RunBenchmark("Regex per line (1 thread)", directory, pattern, options);
+
+  options.use_prefilter = true;
+  RunBenchmark("Prefilter (1 thread)", directory, pattern, options);
+
+  options.threads = 0;
+  char name[64];
+  snprintf(name, sizeof(name), "Prefilter (pool of %u)",
+           std::max(1u, std::thread::hardware_concurrency()));
+  RunBenchmark(name, directory, pattern, options);
+
+  if (generated) {
+    std::filesystem::remove_all(directory);
+  }
+  return 0;
+}
@@ -0,0 +1,79 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+// Benchmarks for the string functions in utils which are used to parse
+// the arguments of every extension command and to search the histories.
+//
+// Usage: bench_utils [benchmark options] (see benchmark_runner.h)
+
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "../src/utils.h"
+#include "benchmark_runner.h"
+
+utils::DebugInterfaces g_debug;
+
+namespace {
+
+const std::string kPaddedText =
+    "   \t chrome!media::MediaFoundationService::IsKeySystemSupported  \t ";
+
+const std::string kBreakpointsText =
+    "chrome!media::MediaFoundationService::IsKeySystemSupported, "
+    "`chrome!D:\\cs\\src\\media\\mojo\\services\\media_foundation_service.cc:"
+    "520`, chrome!media::CdmAdapter::Initialize+0x1c, "
+    "ntdll!NtCreateFile, kernel32!ReadFile, kernel32!WriteFile";
+
+const char kCommandLine[] =
+    "'chrome!media::Foo, chrome!media::Bar' +chrome 'media init' /t 5 "
+    "/m chrome.dll 'it\\'s quoted' 12 3-7";
+
+}  // namespace
+
+DECLARE_BENCHMARK_RUNNER()
+
+BENCHMARK(Trim) {
+  BenchmarkKeep(utils::Trim(kPaddedText));
+}
+
+BENCHMARK(ContainsCI_Match) {
+  BenchmarkKeep(utils::ContainsCI(kBreakpointsText, "CDMADAPTER"));
+}
+
+BENCHMARK(ContainsCI_NoMatch) {
+  BenchmarkKeep(utils::ContainsCI(kBreakpointsText, "VideoDecoder"));
+}
+
+BENCHMARK(SplitString_Breakpoints) {
+  BenchmarkKeep(utils::SplitString(kBreakpointsText, ","));
+}
+
+BENCHMARK(ParseCommandLine) {
+  BenchmarkKeep(utils::ParseCommandLine(kCommandLine));
+}
+
+BENCHMARK(GetIndicesFromString) {
+  BenchmarkKeep(utils::GetIndicesFromString("1 3-9 12 20-15 42"));
+}
+
+BENCHMARK(ParseNumberOrDottedPair) {
+  size_t first = 0;
+  std::optional<size_t> second;
+  BenchmarkKeep(utils::ParseNumberOrDottedPair("12.3", first, second));
+  BenchmarkKeep(second);
+}
+
+BENCHMARK(IsWholeNumber) {
+  BenchmarkKeep(utils::IsWholeNumber("1234567"));
+}
+
+BENCHMARK(EscapeQuotes) {
+  BenchmarkKeep(
+      utils::EscapeQuotes("dx -r0 \"media::Foo\" \"bar\" \"baz\" \"qux\""));
+}
+
+int main(int argc, char* argv[]) {
+  return RUN_ALL_BENCHMARKS(argc, argv);
+}
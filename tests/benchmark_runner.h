@@ -0,0 +1,337 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef BENCHMARK_RUNNER_H
+#define BENCHMARK_RUNNER_H
+
+// A small benchmark harness in the style of unit_test_runner.h.
+//
+//    DECLARE_BENCHMARK_RUNNER()
+//
+//    BENCHMARK(Trim_Short) {
+//      BenchmarkKeep(utils::Trim("  value  "));
+//    }
+//
+//    int main(int argc, char* argv[]) {
+//      return RUN_ALL_BENCHMARKS(argc, argv);
+//    }
+//
+// The body of a benchmark is a single iteration. Each benchmark is
+// run for a number of warmup repetitions followed by the measured
+// repetitions. The number of iterations per repetition is calibrated
+// so that a repetition takes at least --min-time-ms. The percentiles
+// are taken over the time per iteration of the repetitions.
+//
+// Options:
+//   --filter <text>        Only run benchmarks whose name contains text
+//   --warmup <n>           Warmup repetitions (default 2)
+//   --repetitions <n>      Measured repetitions (default 20)
+//   --min-time-ms <n>      Minimum time of a repetition (default 10)
+//   --json <file>          Write the results to a JSON file
+//   --baseline <file>      Compare the medians with a previous JSON file
+//   --threshold <percent>  Slowdown which counts as a regression (default 10)
+//
+// When a baseline is given the exit code is 1 if any benchmark
+// regressed by more than the threshold.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../src/json.hpp"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// Prevents the compiler from optimizing away the computation of value.
+template <typename T>
+inline void BenchmarkKeep(const T& value) {
+#if defined(_MSC_VER)
+  static const volatile void* sink;
+  sink = &value;
+  _ReadWriteBarrier();
+#else
+  asm volatile("" : : "r"(&value) : "memory");
+#endif
+}
+
+struct BenchmarkOptions {
+  std::string filter;
+  int warmup = 2;
+  int repetitions = 20;
+  double min_time_ms = 10;
+  std::string json_file;
+  std::string baseline_file;
+  double threshold_percent = 10;
+};
+
+struct BenchmarkResult {
+  std::string name;
+  size_t iterations = 0;  // Per repetition
+  // Nanoseconds per iteration.
+  double min_ns = 0;
+  double mean_ns = 0;
+  double p50_ns = 0;
+  double p90_ns = 0;
+  double p99_ns = 0;
+  double max_ns = 0;
+};
+
+class BenchmarkRunner {
+ private:
+  struct Benchmark {
+    std::string name;
+    std::function<void()> body;
+  };
+
+  std::vector<Benchmark> benchmarks_;
+
+  static double Percentile(const std::vector<double>& sorted, double percent) {
+    if (sorted.empty()) {
+      return 0;
+    }
+    // Nearest rank
+    size_t rank = static_cast<size_t>(percent / 100.0 * sorted.size() + 0.5);
+    rank = std::min(std::max<size_t>(rank, 1), sorted.size());
+    return sorted[rank - 1];
+  }
+
+  static double RunIterations(const std::function<void()>& body,
+                              size_t iterations) {
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+      body();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count();
+  }
+
+  // Doubles the number of iterations until a
+  // repetition takes at least min_time_ms.
+  static size_t Calibrate(const std::function<void()>& body,
+                          double min_time_ms) {
+    size_t iterations = 1;
+    while (true) {
+      double ns = RunIterations(body, iterations);
+      if (ns >= min_time_ms * 1e6 || iterations >= (size_t(1) << 30)) {
+        return iterations;
+      }
+      if (ns <= 0) {
+        iterations *= 10;
+        continue;
+      }
+      double scale = (min_time_ms * 1e6) / ns * 1.2;
+      iterations = static_cast<size_t>(
+          std::max(iterations * 2.0, std::min(iterations * scale, 1e9)));
+    }
+  }
+
+  static BenchmarkResult Run(const Benchmark& benchmark,
+                             const BenchmarkOptions& options) {
+    BenchmarkResult result;
+    result.name = benchmark.name;
+
+    // The first call also includes the setup of static fixtures.
+    benchmark.body();
+    result.iterations = Calibrate(benchmark.body, options.min_time_ms);
+
+    for (int i = 0; i < options.warmup; i++) {
+      RunIterations(benchmark.body, result.iterations);
+    }
+
+    std::vector<double> samples;
+    for (int i = 0; i < std::max(options.repetitions, 1); i++) {
+      samples.push_back(RunIterations(benchmark.body, result.iterations) /
+                        result.iterations);
+    }
+
+    std::sort(samples.begin(), samples.end());
+    double total = 0;
+    for (double sample : samples) {
+      total += sample;
+    }
+    result.min_ns = samples.front();
+    result.mean_ns = total / samples.size();
+    result.p50_ns = Percentile(samples, 50);
+    result.p90_ns = Percentile(samples, 90);
+    result.p99_ns = Percentile(samples, 99);
+    result.max_ns = samples.back();
+    return result;
+  }
+
+  static std::string FormatTime(double ns) {
+    char buffer[32];
+    if (ns < 1e3) {
+      snprintf(buffer, sizeof(buffer), "%.1f ns", ns);
+    } else if (ns < 1e6) {
+      snprintf(buffer, sizeof(buffer), "%.2f us", ns / 1e3);
+    } else {
+      snprintf(buffer, sizeof(buffer), "%.2f ms", ns / 1e6);
+    }
+    return buffer;
+  }
+
+  static bool ParseOptions(int argc, char* argv[], BenchmarkOptions& options) {
+    for (int i = 1; i < argc; i++) {
+      std::string arg = argv[i];
+      if (i + 1 >= argc) {
+        fprintf(stderr, "Missing value for %s\n", arg.c_str());
+        return false;
+      }
+      std::string value = argv[++i];
+      if (arg == "--filter") {
+        options.filter = value;
+      } else if (arg == "--warmup") {
+        options.warmup = atoi(value.c_str());
+      } else if (arg == "--repetitions") {
+        options.repetitions = atoi(value.c_str());
+      } else if (arg == "--min-time-ms") {
+        options.min_time_ms = atof(value.c_str());
+      } else if (arg == "--json") {
+        options.json_file = value;
+      } else if (arg == "--baseline") {
+        options.baseline_file = value;
+      } else if (arg == "--threshold") {
+        options.threshold_percent = atof(value.c_str());
+      } else {
+        fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+        return false;
+      }
+    }
+    return true;
+  }
+
+  static bool WriteJson(const std::string& file_name,
+                        const std::vector<BenchmarkResult>& results) {
+    nlohmann::json benchmarks = nlohmann::json::array();
+    for (const BenchmarkResult& result : results) {
+      benchmarks.push_back({{"name", result.name},
+                            {"iterations", result.iterations},
+                            {"min_ns", result.min_ns},
+                            {"mean_ns", result.mean_ns},
+                            {"p50_ns", result.p50_ns},
+                            {"p90_ns", result.p90_ns},
+                            {"p99_ns", result.p99_ns},
+                            {"max_ns", result.max_ns}});
+    }
+
+    std::ofstream file(file_name);
+    if (!file.is_open()) {
+      return false;
+    }
+    file << nlohmann::json{{"benchmarks", benchmarks}}.dump(2) << "\n";
+    return true;
+  }
+
+  // Returns the medians of the baseline keyed by benchmark name.
+  static bool ReadBaseline(const std::string& file_name,
+                           std::map<std::string, double>& medians) {
+    std::ifstream file(file_name);
+    if (!file.is_open()) {
+      return false;
+    }
+    try {
+      nlohmann::json json;
+      file >> json;
+      for (const auto& benchmark : json.at("benchmarks")) {
+        medians[benchmark.at("name").get<std::string>()] =
+            benchmark.at("p50_ns").get<double>();
+      }
+    } catch (const std::exception&) {
+      return false;
+    }
+    return true;
+  }
+
+ public:
+  void RegisterBenchmark(const std::string& name, std::function<void()> body) {
+    benchmarks_.push_back({name, body});
+  }
+
+  int RunBenchmarks(int argc, char* argv[]) {
+    BenchmarkOptions options;
+    if (!ParseOptions(argc, argv, options)) {
+      return 2;
+    }
+
+    std::map<std::string, double> baseline;
+    if (!options.baseline_file.empty() &&
+        !ReadBaseline(options.baseline_file, baseline)) {
+      fprintf(stderr, "Unable to read baseline: %s\n",
+              options.baseline_file.c_str());
+      return 2;
+    }
+
+    printf("%-44s %12s %12s %12s %12s %12s\n", "Benchmark", "Iterations",
+           "Min", "Median", "P90", "P99");
+
+    std::vector<BenchmarkResult> results;
+    int regressions = 0;
+    for (const Benchmark& benchmark : benchmarks_) {
+      if (benchmark.name.find(options.filter) == std::string::npos) {
+        continue;
+      }
+
+      BenchmarkResult result = Run(benchmark, options);
+      printf("%-44s %12zu %12s %12s %12s %12s", result.name.c_str(),
+             result.iterations, FormatTime(result.min_ns).c_str(),
+             FormatTime(result.p50_ns).c_str(),
+             FormatTime(result.p90_ns).c_str(),
+             FormatTime(result.p99_ns).c_str());
+
+      auto it = baseline.find(result.name);
+      if (it != baseline.end() && it->second > 0) {
+        double change = (result.p50_ns / it->second - 1) * 100;
+        bool regressed = change > options.threshold_percent;
+        printf(" %+7.1f%%%s", change, regressed ? " REGRESSION" : "");
+        regressions += regressed ? 1 : 0;
+      }
+      printf("\n");
+      fflush(stdout);
+
+      results.push_back(result);
+    }
+
+    if (!options.json_file.empty() && !WriteJson(options.json_file, results)) {
+      fprintf(stderr, "Unable to write: %s\n", options.json_file.c_str());
+      return 2;
+    }
+
+    if (!baseline.empty()) {
+      printf("\n%d of %zu benchmarks regressed by more than %.1f%%\n",
+             regressions, results.size(), options.threshold_percent);
+    }
+    return regressions > 0 ? 1 : 0;
+  }
+};
+
+#define DECLARE_BENCHMARK_RUNNER()            \
+  namespace {                                 \
+  BenchmarkRunner& GetBenchmarkRunner() {     \
+    static BenchmarkRunner runner;            \
+    return runner;                            \
+  }                                           \
+  }
+
+#define BENCHMARK(benchmark_name)                                  \
+  static struct Benchmark_##benchmark_name##_##__LINE__ {          \
+    Benchmark_##benchmark_name##_##__LINE__() {                    \
+      GetBenchmarkRunner().RegisterBenchmark(                      \
+          #benchmark_name, [this]() { this->Run(); });             \
+    }                                                              \
+    void Run();                                                    \
+  } benchmark_##benchmark_name##_##__LINE__;                       \
+                                                                   \
+  void Benchmark_##benchmark_name##_##__LINE__::Run()
+
+#define RUN_ALL_BENCHMARKS(argc, argv) \
+  GetBenchmarkRunner().RunBenchmarks(argc, argv)
+
+#endif  // BENCHMARK_RUNNER_H
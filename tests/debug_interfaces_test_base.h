@@ -4,6 +4,8 @@
 #ifndef DEBUG_INTERFACES_TEST_BASE_H
 #define DEBUG_INTERFACES_TEST_BASE_H
 
+#include <chrono>
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -27,6 +29,10 @@ class DebugInterfacesTestBase {
   std::vector<std::string> output_normal;
   std::vector<std::string> output_error;
 
+  // The calls to all of the mocks in order.
+  std::shared_ptr<MockCallSequence> call_sequence =
+      std::make_shared<MockCallSequence>();
+
   explicit DebugInterfacesTestBase(utils::DebugInterfaces& interfaces) {
     mock_client = new MockDebugClient();
     mock_control = new MockDebugControl();
@@ -37,6 +43,7 @@ class DebugInterfacesTestBase {
 
     SetupDebugInterfaces(interfaces);
     SetupOutputCapture();
+    SetupCallSequence();
   }
 
   // Don't allow calling any other constructors
@@ -69,6 +76,42 @@ class DebugInterfacesTestBase {
     return false;
   }
 
+  // The number of calls to all of the mocks not including the output
+  // methods. Used to assert the number of engine calls of an operation:
+  //
+  //    test.ClearCallHistory();
+  //    RunOperation();
+  //    TEST_ASSERT(test.GetEngineCallCount() <= 12);
+  //
+  size_t GetEngineCallCount() const {
+    const std::vector<std::string> output_methods = {"Output",
+                                                     "ControlledOutput"};
+    return mock_client->GetTotalCallCount() +
+           mock_control->GetTotalCallCount(output_methods) +
+           mock_symbols->GetTotalCallCount() +
+           mock_data_spaces->GetTotalCallCount() +
+           mock_system_objects->GetTotalCallCount() +
+           mock_registers->GetTotalCallCount();
+  }
+
+  // The sum of the virtual latencies of all of the calls.
+  std::chrono::microseconds GetVirtualTime() const {
+    return mock_client->GetVirtualTime() + mock_control->GetVirtualTime() +
+           mock_symbols->GetVirtualTime() + mock_data_spaces->GetVirtualTime() +
+           mock_system_objects->GetVirtualTime() +
+           mock_registers->GetVirtualTime();
+  }
+
+  void ClearCallHistory() {
+    mock_client->ClearCallHistory();
+    mock_control->ClearCallHistory();
+    mock_symbols->ClearCallHistory();
+    mock_data_spaces->ClearCallHistory();
+    mock_system_objects->ClearCallHistory();
+    mock_registers->ClearCallHistory();
+    call_sequence->clear();
+  }
+
   bool HasErrorContaining(const std::string& text) {
     for (const auto& output : output_error) {
       if (output.find(text) != std::string::npos) {
@@ -88,6 +131,15 @@ class DebugInterfacesTestBase {
     interfaces.registers = mock_registers;
   }
 
+  virtual void SetupCallSequence() {
+    mock_client->SetCallSequence(call_sequence, "Client");
+    mock_control->SetCallSequence(call_sequence, "Control");
+    mock_symbols->SetCallSequence(call_sequence, "Symbols");
+    mock_data_spaces->SetCallSequence(call_sequence, "DataSpaces");
+    mock_system_objects->SetCallSequence(call_sequence, "SystemObjects");
+    mock_registers->SetCallSequence(call_sequence, "Registers");
+  }
+
   virtual void SetupOutputCapture() {
     mock_control->SetMethodOverride(
         "Output", [this](ULONG Mask, PCSTR Format, va_list args) -> HRESULT {
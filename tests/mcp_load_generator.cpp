@@ -0,0 +1,463 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+// Load generator for the MCP server. Opens a number of connections and
+// replays a weighted mix of tools/call requests on each of them with a
+// fixed number of requests in flight (pipelining).
+//
+// By default the requests go to an in-process server built from the
+// same transport (mcp_transport::SocketServer) and command queue
+// (command_queue::CommandQueue) as MCPServer. The server is wired to
+// a mock engine which keeps the command thread busy for a configurable
+// time per tool, so it runs anywhere without a debugger. With --connect
+// the requests go to a running server instead (e.g. !StartMCPServer).
+//
+// Options:
+//   --connections <n>      Number of connections (default 8)
+//   --requests <n>         Requests per connection (default 500)
+//   --pipeline <n>         Requests in flight per connection (default 4)
+//   --mix <tool=weight,..> Tools to call (default executeCommand=6,
+//                          getDebuggerState=3,evaluate=1)
+//   --latency <tool=us,..> Time the mock engine spends on each tool
+//                          (default 100 us for every tool)
+//   --connect <host:port>  Use a running server instead of the mock
+//   --json <file>          Write the results to a JSON file
+//
+// Reports the throughput, the latency percentiles of the requests, the
+// time the requests waited in the command queue (mock engine only) and
+// the peak memory of the process.
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/command_queue.h"
+#include "../src/mcp_protocol.h"
+#include "../src/mcp_transport.h"
+#include "mcp_test_client.h"
+
+using Clock = std::chrono::steady_clock;
+using mcp_transport::ClientId;
+
+namespace {
+
+struct LoadOptions {
+  int connections = 8;
+  int requests = 500;
+  int pipeline = 4;
+  std::vector<std::pair<std::string, int>> mix = {
+      {"executeCommand", 6}, {"getDebuggerState", 3}, {"evaluate", 1}};
+  std::map<std::string, int> latency_us;
+  int default_latency_us = 100;
+  std::string host;
+  int port = 0;
+  std::string json_file;
+};
+
+struct ConnectionResult {
+  std::vector<double> latencies_us;
+  uint64_t errors = 0;
+  bool connected = false;
+};
+
+double Percentile(const std::vector<double>& sorted, double percent) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  // Nearest rank
+  size_t rank = static_cast<size_t>(percent / 100.0 * sorted.size() + 0.5);
+  rank = std::min(std::max<size_t>(rank, 1), sorted.size());
+  return sorted[rank - 1];
+}
+
+double ElapsedUs(Clock::time_point start, Clock::time_point end) {
+  return std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+uint64_t GetPeakMemoryBytes() {
+#ifdef _WIN32
+  PROCESS_MEMORY_COUNTERS counters = {};
+  if (GetProcessMemoryInfo(GetCurrentProcess(), &counters,
+                           sizeof(counters))) {
+    return counters.PeakWorkingSetSize;
+  }
+  return 0;
+#else
+  rusage usage = {};
+  getrusage(RUSAGE_SELF, &usage);
+  // Kilobytes on Linux
+  return static_cast<uint64_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+// Parses "name=value,name=value".
+bool ParsePairs(const std::string& text,
+                std::vector<std::pair<std::string, int>>& pairs) {
+  pairs.clear();
+  size_t start = 0;
+  while (start < text.size()) {
+    size_t end = text.find(',', start);
+    if (end == std::string::npos) {
+      end = text.size();
+    }
+    std::string item = text.substr(start, end - start);
+    size_t equals = item.find('=');
+    if (equals == std::string::npos || equals == 0) {
+      return false;
+    }
+    pairs.push_back({item.substr(0, equals), atoi(item.c_str() + equals + 1)});
+    start = end + 1;
+  }
+  return !pairs.empty();
+}
+
+bool ParseOptions(int argc, char* argv[], LoadOptions& options) {
+  for (int i = 1; i < argc; i++) {
+    std::string arg = argv[i];
+    if (i + 1 >= argc) {
+      fprintf(stderr, "Missing value for %s\n", arg.c_str());
+      return false;
+    }
+    std::string value = argv[++i];
+    if (arg == "--connections") {
+      options.connections = std::max(1, atoi(value.c_str()));
+    } else if (arg == "--requests") {
+      options.requests = std::max(1, atoi(value.c_str()));
+    } else if (arg == "--pipeline") {
+      options.pipeline = std::max(1, atoi(value.c_str()));
+    } else if (arg == "--mix") {
+      if (!ParsePairs(value, options.mix)) {
+        fprintf(stderr, "Invalid mix: %s\n", value.c_str());
+        return false;
+      }
+    } else if (arg == "--latency") {
+      std::vector<std::pair<std::string, int>> latencies;
+      if (!ParsePairs(value, latencies)) {
+        fprintf(stderr, "Invalid latency: %s\n", value.c_str());
+        return false;
+      }
+      for (const auto& [tool, latency_us] : latencies) {
+        options.latency_us[tool] = latency_us;
+      }
+    } else if (arg == "--connect") {
+      size_t colon = value.rfind(':');
+      if (colon == std::string::npos) {
+        fprintf(stderr, "Expected host:port: %s\n", value.c_str());
+        return false;
+      }
+      options.host = value.substr(0, colon);
+      options.port = atoi(value.c_str() + colon + 1);
+    } else if (arg == "--json") {
+      options.json_file = value;
+    } else {
+      fprintf(stderr, "Unknown option: %s\n", arg.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+// The arguments which are sent with each tool.
+JSON GetToolArguments(const std::string& tool) {
+  if (tool == "executeCommand") {
+    return {{"command", "r"}};
+  } else if (tool == "evaluate") {
+    return {{"expressions", JSON::array({"@$ip", "@$csp"})}};
+  }
+  return JSON::object();
+}
+
+// An MCP server which uses the same transport and command queue as
+// MCPServer. Each tool call spins on the command thread for the
+// latency of the tool, which stands in for the time spent in the
+// debugger engine.
+class MockEngineServer {
+ public:
+  explicit MockEngineServer(const LoadOptions& options) : options_(options) {}
+
+  bool Start() {
+    queue_.Start();
+    return transport_.Start(
+        0, [this](const mcp_protocol::Request& request, ClientId client) {
+          return Handle(request, client);
+        },
+        [this](ClientId client) { queue_.RemoveSession(client); });
+  }
+
+  void Stop() {
+    queue_.Stop();
+    transport_.Stop();
+  }
+
+  int GetPort() const { return transport_.GetPort(); }
+
+  std::vector<double> TakeQueueWaits() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return std::move(queue_waits_us_);
+  }
+
+  command_queue::QueueStats GetQueueStats() const {
+    return queue_.GetStats();
+  }
+
+ private:
+  // Like MCPServer, each connection has its own session in the queue.
+  JSON Handle(const mcp_protocol::Request& request, ClientId client) {
+    const std::string& method = request.method;
+    const JSON& id = request.id;
+    if (method == "initialize") {
+      return mcp_protocol::CreateResponse(
+          id, {{"protocolVersion", "2024-11-05"},
+               {"serverInfo", {{"name", "mock-engine"}}}});
+    } else if (method != "tools/call") {
+      return mcp_protocol::CreateError(id, mcp_protocol::kMethodNotFound,
+                                       "Method not found: " + method);
+    }
+
+    const std::string& tool = request.tool_name;
+    auto it = options_.latency_us.find(tool);
+    auto latency = std::chrono::microseconds(
+        it != options_.latency_us.end() ? it->second
+                                        : options_.default_latency_us);
+
+    Clock::time_point queued = Clock::now();
+    JSON result = queue_.Execute(
+        [&]() {
+          Clock::time_point start = Clock::now();
+          {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_waits_us_.push_back(ElapsedUs(queued, start));
+          }
+
+          // Spin rather than sleep so that short latencies are accurate
+          // and the command thread is busy like it is in the engine.
+          while (Clock::now() - start < latency) {
+          }
+          return JSON(tool + " output");
+        },
+        client);
+    return mcp_protocol::CreateResponse(
+        id, mcp_protocol::CreateToolResult(result));
+  }
+
+  const LoadOptions& options_;
+  mcp_transport::SocketServer transport_;
+  command_queue::CommandQueue queue_;
+  std::mutex mutex_;
+  std::vector<double> queue_waits_us_;
+};
+
+void RunConnection(const LoadOptions& options,
+                   int index,
+                   ConnectionResult& result) {
+  McpTestClient client;
+  if (!client.Connect(options.host, options.port)) {
+    return;
+  }
+
+  std::string message;
+  JSON initialize = {{"jsonrpc", "2.0"},
+                     {"id", 0},
+                     {"method", "initialize"},
+                     {"params", JSON::object()}};
+  if (!client.Send(initialize.dump() + "\n") || !client.Receive(message)) {
+    return;
+  }
+  result.connected = true;
+
+  int total_weight = 0;
+  for (const auto& [tool, weight] : options.mix) {
+    total_weight += std::max(weight, 0);
+  }
+  std::mt19937 random(index + 1);
+  auto pick_tool = [&]() {
+    int value = static_cast<int>(random() % std::max(total_weight, 1));
+    for (const auto& [tool, weight] : options.mix) {
+      value -= std::max(weight, 0);
+      if (value < 0) {
+        return tool;
+      }
+    }
+    return options.mix.front().first;
+  };
+
+  // Request ids are 1..requests so the send times are indexed by id.
+  std::vector<Clock::time_point> send_times(options.requests + 1);
+  result.latencies_us.reserve(options.requests);
+  int sent = 0;
+  int received = 0;
+  while (received < options.requests) {
+    std::string batch;
+    while (sent < options.requests && sent - received < options.pipeline) {
+      sent++;
+      std::string tool = pick_tool();
+      JSON request = {
+          {"jsonrpc", "2.0"},
+          {"id", sent},
+          {"method", "tools/call"},
+          {"params", {{"name", tool}, {"arguments", GetToolArguments(tool)}}}};
+      batch += request.dump() + "\n";
+      send_times[sent] = Clock::now();
+    }
+    if (!batch.empty() && !client.Send(batch)) {
+      break;
+    }
+
+    if (!client.Receive(message)) {
+      break;
+    }
+    Clock::time_point now = Clock::now();
+
+    JSON response = JSON::parse(message, nullptr, false);
+    if (response.is_discarded() || !response.contains("id")) {
+      // Notifications (e.g. progress) don't complete a request
+      if (response.is_discarded()) {
+        result.errors++;
+      }
+      continue;
+    }
+
+    int id = response["id"].is_number_integer() ? response["id"].get<int>() : 0;
+    if (id < 1 || id > sent) {
+      result.errors++;
+      continue;
+    }
+    received++;
+    result.latencies_us.push_back(ElapsedUs(send_times[id], now));
+    if (response.contains("error") ||
+        response["result"].value("isError", false)) {
+      result.errors++;
+    }
+  }
+}
+
+JSON Summarize(std::vector<double> samples_us) {
+  std::sort(samples_us.begin(), samples_us.end());
+  double total = 0;
+  for (double sample : samples_us) {
+    total += sample;
+  }
+  return {{"count", samples_us.size()},
+          {"mean_us", samples_us.empty() ? 0 : total / samples_us.size()},
+          {"p50_us", Percentile(samples_us, 50)},
+          {"p99_us", Percentile(samples_us, 99)},
+          {"p999_us", Percentile(samples_us, 99.9)},
+          {"max_us", samples_us.empty() ? 0 : samples_us.back()}};
+}
+
+void PrintSummary(const char* name, const JSON& summary) {
+  printf("%-12s p50 %10.1f us   p99 %10.1f us   p999 %10.1f us   max %10.1f us\n",
+         name, summary["p50_us"].get<double>(),
+         summary["p99_us"].get<double>(), summary["p999_us"].get<double>(),
+         summary["max_us"].get<double>());
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  LoadOptions options;
+  if (!ParseOptions(argc, argv, options)) {
+    return 2;
+  }
+
+  std::unique_ptr<MockEngineServer> server;
+  if (options.host.empty()) {
+    server = std::make_unique<MockEngineServer>(options);
+    if (!server->Start()) {
+      fprintf(stderr, "Unable to start the mock engine server\n");
+      return 1;
+    }
+    options.host = "127.0.0.1";
+    options.port = server->GetPort();
+  }
+
+  std::vector<ConnectionResult> results(options.connections);
+  std::vector<std::thread> threads;
+  Clock::time_point start = Clock::now();
+  for (int i = 0; i < options.connections; i++) {
+    threads.emplace_back(RunConnection, std::cref(options), i,
+                         std::ref(results[i]));
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  double elapsed_s = ElapsedUs(start, Clock::now()) / 1e6;
+
+  std::vector<double> latencies_us;
+  uint64_t errors = 0;
+  int connected = 0;
+  for (const ConnectionResult& result : results) {
+    latencies_us.insert(latencies_us.end(), result.latencies_us.begin(),
+                        result.latencies_us.end());
+    errors += result.errors;
+    connected += result.connected ? 1 : 0;
+  }
+
+  JSON output = {
+      {"server", server ? "mock" : options.host + ":" +
+                                       std::to_string(options.port)},
+      {"connections", options.connections},
+      {"connected", connected},
+      {"pipeline", options.pipeline},
+      {"requests", latencies_us.size()},
+      {"errors", errors},
+      {"seconds", elapsed_s},
+      {"throughput", elapsed_s > 0 ? latencies_us.size() / elapsed_s : 0},
+      {"latency", Summarize(latencies_us)},
+      {"peak_memory_bytes", GetPeakMemoryBytes()}};
+
+  if (server) {
+    command_queue::QueueStats stats = server->GetQueueStats();
+    output["queue_wait"] = Summarize(server->TakeQueueWaits());
+    output["queue_max_depth"] = stats.max_depth;
+    server->Stop();
+  }
+
+  printf("Server:      %s\n", output["server"].get<std::string>().c_str());
+  printf("Connections: %d (%d connected), pipeline %d\n", options.connections,
+         connected, options.pipeline);
+  printf("Requests:    %zu in %.3f s, %llu errors\n", latencies_us.size(),
+         elapsed_s, static_cast<unsigned long long>(errors));
+  printf("Throughput:  %.1f requests/s\n", output["throughput"].get<double>());
+  PrintSummary("Latency:", output["latency"]);
+  if (output.contains("queue_wait")) {
+    PrintSummary("Queue wait:", output["queue_wait"]);
+    printf("Queue depth: %llu max\n",
+           static_cast<unsigned long long>(
+               output["queue_max_depth"].get<uint64_t>()));
+  }
+  printf("Memory:      %.1f MB peak\n",
+         output["peak_memory_bytes"].get<uint64_t>() / (1024.0 * 1024.0));
+
+  if (!options.json_file.empty()) {
+    std::ofstream file(options.json_file);
+    if (!file.is_open()) {
+      fprintf(stderr, "Unable to write: %s\n", options.json_file.c_str());
+      return 2;
+    }
+    file << output.dump(2) << "\n";
+  }
+
+  return connected == options.connections && errors == 0 ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef MCP_TEST_CLIENT_H
+#define MCP_TEST_CLIENT_H
+
+// A blocking TCP client for the MCP server which sends raw
+// newline terminated messages and reads the messages which
+// come back. Used by the transport tests and the load generator.
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "Ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+#include <string>
+
+#include "../src/mcp_protocol.h"
+
+class McpTestClient {
+ public:
+#ifdef _WIN32
+  using Socket = SOCKET;
+  static constexpr Socket kInvalidSocket = INVALID_SOCKET;
+#else
+  using Socket = int;
+  static constexpr Socket kInvalidSocket = -1;
+#endif
+
+  McpTestClient() {
+#ifdef _WIN32
+    WSADATA wsa_data;
+    WSAStartup(MAKEWORD(2, 2), &wsa_data);
+#endif
+  }
+
+  ~McpTestClient() {
+    Close();
+#ifdef _WIN32
+    WSACleanup();
+#endif
+  }
+
+  McpTestClient(const McpTestClient&) = delete;
+  McpTestClient& operator=(const McpTestClient&) = delete;
+
+  bool Connect(const std::string& host, int port) {
+    addrinfo hints = {};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* address = nullptr;
+    if (getaddrinfo(host.c_str(), std::to_string(port).c_str(), &hints,
+                    &address) != 0) {
+      return false;
+    }
+
+    socket_ = socket(address->ai_family, address->ai_socktype,
+                     address->ai_protocol);
+    bool connected =
+        socket_ != kInvalidSocket &&
+        connect(socket_, address->ai_addr, (int)address->ai_addrlen) == 0;
+    freeaddrinfo(address);
+    if (!connected) {
+      Close();
+      return false;
+    }
+
+    // Pipelined requests are sent as soon as they are written.
+    int no_delay = 1;
+    setsockopt(socket_, IPPROTO_TCP, TCP_NODELAY, (const char*)&no_delay,
+               sizeof(no_delay));
+    return true;
+  }
+
+  void Close() {
+    if (socket_ != kInvalidSocket) {
+#ifdef _WIN32
+      closesocket(socket_);
+#else
+      close(socket_);
+#endif
+      socket_ = kInvalidSocket;
+    }
+  }
+
+  bool Send(const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+      int result = send(socket_, data.data() + sent,
+                        (int)(data.size() - sent), kSendFlags);
+      if (result <= 0) {
+        return false;
+      }
+      sent += result;
+    }
+    return true;
+  }
+
+  // Blocks until a complete message has been received. Returns
+  // false if the connection was closed.
+  bool Receive(std::string& message) {
+    char buffer[16384];
+    while (!framer_.Next(message)) {
+      int bytes_received = recv(socket_, buffer, sizeof(buffer), 0);
+      if (bytes_received <= 0) {
+        return false;
+      }
+      framer_.Append(buffer, bytes_received);
+    }
+    return true;
+  }
+
+ private:
+#ifdef _WIN32
+  static constexpr int kSendFlags = 0;
+#else
+  static constexpr int kSendFlags = MSG_NOSIGNAL;
+#endif
+
+  Socket socket_ = kInvalidSocket;
+  mcp_protocol::MessageFramer framer_;
+};
+
+#endif  // MCP_TEST_CLIENT_H
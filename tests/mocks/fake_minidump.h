@@ -0,0 +1,330 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef FAKE_MINIDUMP_H
+#define FAKE_MINIDUMP_H
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+// Generates minidump files for the tests of the minidump reader.
+// Only the streams used by the reader are written and thread contexts
+// are x64 CONTEXT records with just the integer registers set.
+//
+//    FakeMinidump dump;
+//    dump.AddModule(0x140000000, 0x100000, "C:\\out\\chrome.dll");
+//    dump.AddThread(0x1234, 0x7ff000, {{"rip", 0x140001000}});
+//    dump.AddMemory(0x1000, {0x01, 0x02, 0x03});
+//    dump.Write(path);
+//
+class FakeMinidump {
+ public:
+  using Registers = std::map<std::string, uint64_t>;
+
+  void AddModule(uint64_t base,
+                 uint32_t size,
+                 const std::string& name,
+                 const std::string& pdb_name = "",
+                 uint32_t time_date_stamp = 0x65f1a2b3) {
+    modules_.push_back({base, size, name, pdb_name, time_date_stamp});
+  }
+
+  // The stack memory itself has to be added with AddMemory.
+  void AddThread(uint32_t id,
+                 uint64_t teb,
+                 const Registers& registers,
+                 uint64_t stack_start = 0,
+                 uint32_t stack_size = 0) {
+    threads_.push_back({id, teb, registers, stack_start, stack_size});
+  }
+
+  void AddMemory(uint64_t start, std::vector<uint8_t> bytes) {
+    memory_.push_back({start, std::move(bytes)});
+  }
+
+  void SetException(uint32_t thread_id,
+                    uint32_t code,
+                    uint64_t address,
+                    const Registers& registers,
+                    std::vector<uint64_t> parameters = {}) {
+    has_exception_ = true;
+    exception_ = {thread_id, code, address, registers, std::move(parameters)};
+  }
+
+  // Use a MemoryListStream instead of a Memory64ListStream.
+  void UseMemoryList() { use_memory64_ = false; }
+
+  std::vector<uint8_t> Build() const {
+    data_.clear();
+    directory_.clear();
+
+    // Header. The directory is written at the end.
+    Append32(0x504d444d);
+    Append32(0xa793);
+    Append32(0);  // Stream count
+    Append32(0);  // Directory RVA
+    Append32(0);
+    Append32(0x5f000000);  // TimeDateStamp
+    Append64(0);
+
+    WriteSystemInfo();
+    WriteModuleList();
+    WriteThreadList();
+    if (use_memory64_) {
+      WriteMemory64List();
+    } else {
+      WriteMemoryList();
+    }
+    if (has_exception_) {
+      WriteException();
+    }
+
+    uint32_t directory_rva = static_cast<uint32_t>(data_.size());
+    for (const auto& entry : directory_) {
+      Append32(entry.type);
+      Append32(entry.size);
+      Append32(entry.rva);
+    }
+    Patch32(8, static_cast<uint32_t>(directory_.size()));
+    Patch32(12, directory_rva);
+    return data_;
+  }
+
+  void Write(const std::string& path) const {
+    std::vector<uint8_t> bytes = Build();
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(bytes.data()), bytes.size());
+  }
+
+ private:
+  struct Module {
+    uint64_t base;
+    uint32_t size;
+    std::string name;
+    std::string pdb_name;
+    uint32_t time_date_stamp;
+  };
+
+  struct Thread {
+    uint32_t id;
+    uint64_t teb;
+    Registers registers;
+    uint64_t stack_start;
+    uint32_t stack_size;
+  };
+
+  struct Memory {
+    uint64_t start;
+    std::vector<uint8_t> bytes;
+  };
+
+  struct Exception {
+    uint32_t thread_id;
+    uint32_t code;
+    uint64_t address;
+    Registers registers;
+    std::vector<uint64_t> parameters;
+  };
+
+  struct DirectoryEntry {
+    uint32_t type;
+    uint32_t size;
+    uint32_t rva;
+  };
+
+  void Append32(uint32_t value) const { AppendBytes(&value, 4); }
+  void Append64(uint64_t value) const { AppendBytes(&value, 8); }
+  void AppendBytes(const void* bytes, size_t size) const {
+    const uint8_t* begin = static_cast<const uint8_t*>(bytes);
+    data_.insert(data_.end(), begin, begin + size);
+  }
+  void Patch32(size_t offset, uint32_t value) const {
+    memcpy(&data_[offset], &value, 4);
+  }
+  uint32_t Position() const { return static_cast<uint32_t>(data_.size()); }
+
+  void AddStream(uint32_t type, uint32_t rva) const {
+    directory_.push_back({type, Position() - rva, rva});
+  }
+
+  uint32_t WriteString(const std::string& value) const {
+    uint32_t rva = Position();
+    Append32(static_cast<uint32_t>(value.size() * 2));
+    for (char c : value) {
+      uint16_t character = static_cast<uint8_t>(c);
+      AppendBytes(&character, 2);
+    }
+    uint16_t terminator = 0;
+    AppendBytes(&terminator, 2);
+    return rva;
+  }
+
+  // Writes an x64 CONTEXT and returns its RVA.
+  uint32_t WriteContext(const Registers& registers) const {
+    static const std::map<std::string, uint32_t> kOffsets = {
+        {"rax", 0x78}, {"rcx", 0x80}, {"rdx", 0x88}, {"rbx", 0x90},
+        {"rsp", 0x98}, {"rbp", 0xa0}, {"rsi", 0xa8}, {"rdi", 0xb0},
+        {"r8", 0xb8},  {"r9", 0xc0},  {"r10", 0xc8}, {"r11", 0xd0},
+        {"r12", 0xd8}, {"r13", 0xe0}, {"r14", 0xe8}, {"r15", 0xf0},
+        {"rip", 0xf8}};
+
+    std::vector<uint8_t> context(kContextSize, 0);
+    for (const auto& [name, value] : registers) {
+      if (name == "efl") {
+        uint32_t flags = static_cast<uint32_t>(value);
+        memcpy(&context[0x44], &flags, 4);
+      } else {
+        memcpy(&context[kOffsets.at(name)], &value, 8);
+      }
+    }
+
+    uint32_t rva = Position();
+    AppendBytes(context.data(), context.size());
+    return rva;
+  }
+
+  void WriteSystemInfo() const {
+    uint32_t rva = Position();
+    uint16_t architecture = 9;  // PROCESSOR_ARCHITECTURE_AMD64
+    AppendBytes(&architecture, 2);
+    Append32(0);         // Level and revision
+    data_.push_back(8);  // NumberOfProcessors
+    data_.push_back(1);  // ProductType
+    Append32(10);        // MajorVersion
+    Append32(0);         // MinorVersion
+    Append32(22631);     // BuildNumber
+    data_.resize(rva + 56, 0);
+    AddStream(7, rva);
+  }
+
+  void WriteModuleList() const {
+    std::vector<uint32_t> name_rvas;
+    std::vector<std::pair<uint32_t, uint32_t>> cv_records;
+    for (const Module& module : modules_) {
+      name_rvas.push_back(WriteString(module.name));
+
+      uint32_t cv_rva = Position();
+      if (!module.pdb_name.empty()) {
+        Append32(0x53445352);  // "RSDS"
+        data_.resize(data_.size() + 20, 0xab);  // GUID and age
+        AppendBytes(module.pdb_name.c_str(), module.pdb_name.size() + 1);
+      }
+      cv_records.emplace_back(Position() - cv_rva, cv_rva);
+    }
+
+    uint32_t rva = Position();
+    Append32(static_cast<uint32_t>(modules_.size()));
+    for (size_t i = 0; i < modules_.size(); i++) {
+      const Module& module = modules_[i];
+      size_t start = data_.size();
+      Append64(module.base);
+      Append32(module.size);
+      Append32(0x1234);  // CheckSum
+      Append32(module.time_date_stamp);
+      Append32(name_rvas[i]);
+      data_.resize(start + 76, 0);  // VS_FIXEDFILEINFO
+      Append32(cv_records[i].first);
+      Append32(cv_records[i].second);
+      data_.resize(start + 108, 0);
+    }
+    AddStream(4, rva);
+  }
+
+  void WriteThreadList() const {
+    std::vector<uint32_t> context_rvas;
+    for (const Thread& thread : threads_) {
+      context_rvas.push_back(WriteContext(thread.registers));
+    }
+
+    uint32_t rva = Position();
+    Append32(static_cast<uint32_t>(threads_.size()));
+    for (size_t i = 0; i < threads_.size(); i++) {
+      const Thread& thread = threads_[i];
+      Append32(thread.id);
+      Append32(0);  // SuspendCount
+      Append32(0x20);  // PriorityClass
+      Append32(0);  // Priority
+      Append64(thread.teb);
+      Append64(thread.stack_start);
+      // The stack memory is only in the memory list.
+      Append32(thread.stack_size);
+      Append32(0);
+      Append32(kContextSize);
+      Append32(context_rvas[i]);
+    }
+    AddStream(3, rva);
+  }
+
+  void WriteMemoryList() const {
+    std::vector<uint32_t> rvas;
+    for (const Memory& memory : memory_) {
+      rvas.push_back(Position());
+      AppendBytes(memory.bytes.data(), memory.bytes.size());
+    }
+
+    uint32_t rva = Position();
+    Append32(static_cast<uint32_t>(memory_.size()));
+    for (size_t i = 0; i < memory_.size(); i++) {
+      Append64(memory_[i].start);
+      Append32(static_cast<uint32_t>(memory_[i].bytes.size()));
+      Append32(rvas[i]);
+    }
+    AddStream(5, rva);
+  }
+
+  void WriteMemory64List() const {
+    uint32_t rva = Position();
+    Append64(memory_.size());
+    size_t base_rva_offset = data_.size();
+    Append64(0);
+    for (const Memory& memory : memory_) {
+      Append64(memory.start);
+      Append64(memory.bytes.size());
+    }
+    AddStream(9, rva);
+
+    uint64_t base_rva = Position();
+    memcpy(&data_[base_rva_offset], &base_rva, 8);
+    for (const Memory& memory : memory_) {
+      AppendBytes(memory.bytes.data(), memory.bytes.size());
+    }
+  }
+
+  void WriteException() const {
+    uint32_t context_rva = WriteContext(exception_.registers);
+
+    uint32_t rva = Position();
+    Append32(exception_.thread_id);
+    Append32(0);
+    Append32(exception_.code);
+    Append32(1);  // ExceptionFlags
+    Append64(0);  // ExceptionRecord
+    Append64(exception_.address);
+    Append32(static_cast<uint32_t>(exception_.parameters.size()));
+    Append32(0);
+    for (size_t i = 0; i < 15; i++) {
+      Append64(i < exception_.parameters.size() ? exception_.parameters[i] : 0);
+    }
+    Append32(kContextSize);
+    Append32(context_rva);
+    AddStream(6, rva);
+  }
+
+  static constexpr uint32_t kContextSize = 0x4d0;
+
+  std::vector<Module> modules_;
+  std::vector<Thread> threads_;
+  std::vector<Memory> memory_;
+  bool has_exception_ = false;
+  Exception exception_;
+  bool use_memory64_ = true;
+
+  mutable std::vector<uint8_t> data_;
+  mutable std::vector<DirectoryEntry> directory_;
+};
+
+#endif  // FAKE_MINIDUMP_H
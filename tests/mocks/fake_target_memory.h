@@ -0,0 +1,171 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef FAKE_TARGET_MEMORY_H
+#define FAKE_TARGET_MEMORY_H
+
+#include <cstring>
+#include <iterator>
+#include <map>
+#include <vector>
+
+#include "mock_debug_data_spaces.h"
+
+// A sparse fake address space which can be installed as the
+// ReadVirtual implementation of a MockDebugDataSpaces instance.
+//
+//    FakeTargetMemory memory;
+//    memory.AddRegion(0x1000, {0x01, 0x02, 0x03});
+//    memory.Install(mock_data_spaces);
+//
+class FakeTargetMemory {
+ public:
+  // Adds a region of committed memory. Regions must not overlap.
+  // Regions with PAGE_NOACCESS or PAGE_GUARD protection can not be read.
+  void AddRegion(ULONG64 base,
+                 std::vector<BYTE> bytes,
+                 ULONG protect = PAGE_READWRITE) {
+    regions_[base] = std::move(bytes);
+    protections_[base] = protect;
+  }
+
+  // Adds a zero filled region of committed memory.
+  void AddZeroRegion(ULONG64 base,
+                     size_t size,
+                     ULONG protect = PAGE_READWRITE) {
+    AddRegion(base, std::vector<BYTE>(size, 0), protect);
+  }
+
+  // Writes to memory that is inside an existing region.
+  // Returns false if the write is not fully inside a region.
+  bool Write(ULONG64 address, const void* data, size_t size) {
+    std::vector<BYTE>* region = nullptr;
+    size_t offset = 0;
+    if (!FindRegion(address, region, offset) ||
+        offset + size > region->size()) {
+      return false;
+    }
+    memcpy(region->data() + offset, data, size);
+    return true;
+  }
+
+  template <typename T>
+  bool WriteValue(ULONG64 address, const T& value) {
+    return Write(address, &value, sizeof(value));
+  }
+
+  // Makes a read which is only partially readable fail without reading
+  // anything, like some targets do, instead of returning the bytes up
+  // to the first unreadable one.
+  void SetFailPartialReads(bool fail) { fail_partial_reads_ = fail; }
+
+  // Reads as many contiguous bytes as are available starting at address.
+  // Fails if the first byte is not readable.
+  HRESULT Read(ULONG64 address, PVOID buffer, ULONG size, PULONG bytes_read) {
+    read_count_++;
+
+    ULONG total = 0;
+    BYTE* out = static_cast<BYTE*>(buffer);
+    while (total < size) {
+      std::vector<BYTE>* region = nullptr;
+      size_t offset = 0;
+      if (!FindRegion(address + total, region, offset) ||
+          !IsReadable(address + total - offset)) {
+        break;
+      }
+
+      size_t available = region->size() - offset;
+      size_t count = std::min<size_t>(available, size - total);
+      memcpy(out + total, region->data() + offset, count);
+      total += static_cast<ULONG>(count);
+    }
+
+    if (fail_partial_reads_ && total < size) {
+      total = 0;
+    }
+
+    if (bytes_read) {
+      *bytes_read = total;
+    }
+    return (total == 0 && size > 0) ? E_FAIL : S_OK;
+  }
+
+  // Describes the region containing address in the same way as
+  // IDebugDataSpaces2::QueryVirtual. The gaps between regions are
+  // reported as free memory. Fails past the end of the last region.
+  HRESULT Query(ULONG64 address, PMEMORY_BASIC_INFORMATION64 info) {
+    *info = {};
+
+    std::vector<BYTE>* region = nullptr;
+    size_t offset = 0;
+    if (FindRegion(address, region, offset)) {
+      ULONG64 base = address - offset;
+      info->BaseAddress = base;
+      info->AllocationBase = base;
+      info->RegionSize = region->size();
+      info->State = MEM_COMMIT;
+      info->Protect = protections_[base];
+      info->AllocationProtect = info->Protect;
+      info->Type = MEM_PRIVATE;
+      return S_OK;
+    }
+
+    auto next = regions_.upper_bound(address);
+    if (next == regions_.end()) {
+      return E_FAIL;
+    }
+
+    info->BaseAddress = address;
+    info->RegionSize = next->first - address;
+    info->State = MEM_FREE;
+    info->Protect = PAGE_NOACCESS;
+    return S_OK;
+  }
+
+  void Install(MockDebugDataSpaces* data_spaces) {
+    data_spaces->SetMethodOverride(
+        "ReadVirtual", [this](ULONG64 offset, PVOID buffer, ULONG buffer_size,
+                              PULONG bytes_read) -> HRESULT {
+          return Read(offset, buffer, buffer_size, bytes_read);
+        });
+
+    data_spaces->SetMethodOverride(
+        "QueryVirtual",
+        [this](ULONG64 offset, PMEMORY_BASIC_INFORMATION64 info) -> HRESULT {
+          return Query(offset, info);
+        });
+  }
+
+  size_t GetReadCount() const { return read_count_; }
+  void ResetReadCount() { read_count_ = 0; }
+
+ private:
+  bool FindRegion(ULONG64 address,
+                  std::vector<BYTE>*& region,
+                  size_t& offset) {
+    auto it = regions_.upper_bound(address);
+    if (it == regions_.begin()) {
+      return false;
+    }
+    --it;
+
+    if (address - it->first >= it->second.size()) {
+      return false;
+    }
+
+    region = &it->second;
+    offset = static_cast<size_t>(address - it->first);
+    return true;
+  }
+
+  bool IsReadable(ULONG64 base) {
+    return (protections_[base] & (PAGE_NOACCESS | PAGE_GUARD)) == 0;
+  }
+
+  std::map<ULONG64, std::vector<BYTE>> regions_;
+  std::map<ULONG64, ULONG> protections_;
+  size_t read_count_ = 0;
+  bool fail_partial_reads_ = false;
+};
+
+#endif  // FAKE_TARGET_MEMORY_H
@@ -0,0 +1,82 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef MOCK_DEBUG_ADVANCED_H
+#define MOCK_DEBUG_ADVANCED_H
+
+#include "mock_debug_interface_base.h"
+
+// Returned by the QueryInterface override of a MockDebugClient since
+// IDebugAdvanced2 isn't part of utils::DebugInterfaces.
+class MockDebugAdvanced : public MockDebugInterfaceBase<IDebugAdvanced2> {
+ public:
+  STDMETHOD(GetThreadContext)(PVOID Context, ULONG ContextSize) override {
+    return MockMethod<HRESULT>("GetThreadContext", Context, ContextSize);
+  }
+
+  STDMETHOD(SetThreadContext)(PVOID Context, ULONG ContextSize) override {
+    return MockMethod<HRESULT>("SetThreadContext", Context, ContextSize);
+  }
+
+  STDMETHOD(Request)(ULONG Request,
+                     PVOID InBuffer,
+                     ULONG InBufferSize,
+                     PVOID OutBuffer,
+                     ULONG OutBufferSize,
+                     PULONG OutSize) override {
+    return MockMethod<HRESULT>("Request", Request, InBuffer, InBufferSize,
+                               OutBuffer, OutBufferSize, OutSize);
+  }
+
+  STDMETHOD(GetSourceFileInformation)(ULONG Which,
+                                      PSTR SourceFile,
+                                      ULONG64 Arg64,
+                                      ULONG Arg32,
+                                      PVOID Buffer,
+                                      ULONG BufferSize,
+                                      PULONG InfoSize) override {
+    return MockMethod<HRESULT>("GetSourceFileInformation", Which, SourceFile,
+                               Arg64, Arg32, Buffer, BufferSize, InfoSize);
+  }
+
+  STDMETHOD(FindSourceFileAndToken)(ULONG StartElement,
+                                    ULONG64 ModAddr,
+                                    PCSTR File,
+                                    ULONG Flags,
+                                    PVOID FileToken,
+                                    ULONG FileTokenSize,
+                                    PULONG FoundElement,
+                                    PSTR Buffer,
+                                    ULONG BufferSize,
+                                    PULONG FoundSize) override {
+    return MockMethod<HRESULT>("FindSourceFileAndToken", StartElement, ModAddr,
+                               File, Flags, FileToken, FileTokenSize,
+                               FoundElement, Buffer, BufferSize, FoundSize);
+  }
+
+  STDMETHOD(GetSymbolInformation)(ULONG Which,
+                                  ULONG64 Arg64,
+                                  ULONG Arg32,
+                                  PVOID Buffer,
+                                  ULONG BufferSize,
+                                  PULONG InfoSize,
+                                  PSTR StringBuffer,
+                                  ULONG StringBufferSize,
+                                  PULONG StringSize) override {
+    return MockMethod<HRESULT>("GetSymbolInformation", Which, Arg64, Arg32,
+                               Buffer, BufferSize, InfoSize, StringBuffer,
+                               StringBufferSize, StringSize);
+  }
+
+  STDMETHOD(GetSystemObjectInformation)(ULONG Which,
+                                        ULONG64 Arg64,
+                                        ULONG Arg32,
+                                        PVOID Buffer,
+                                        ULONG BufferSize,
+                                        PULONG InfoSize) override {
+    return MockMethod<HRESULT>("GetSystemObjectInformation", Which, Arg64,
+                               Arg32, Buffer, BufferSize, InfoSize);
+  }
+};
+
+#endif  // MOCK_DEBUG_ADVANCED_H
@@ -6,15 +6,28 @@
 
 #include <dbgeng.h>
 #include <windows.h>
+#include <algorithm>
 #include <any>
+#include <chrono>
 #include <functional>
 #include <iostream>
 #include <memory>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
+// The calls of several mocks in the order in which they were made
+// (e.g. "Control::Execute", "Symbols::GetScope"). Shared between the
+// mocks with SetCallSequence.
+using MockCallSequence = std::vector<std::string>;
+
+// How the latency of a method is applied. Virtual latency only
+// advances the mock's virtual time so that tests which measure the
+// cost of engine calls stay fast. Real latency sleeps.
+enum class MockLatencyMode { kVirtual, kReal };
+
 template <typename TInterface>
 class MockDebugInterfaceBase : public TInterface {
  public:
@@ -51,9 +64,42 @@ class MockDebugInterfaceBase : public TInterface {
 
   void ClearOverrides() { methodOverrides.clear(); }
 
-  // IUnknown methods
+  // Adds latency to every call of a method.
+  //
+  //    mock->SetMethodLatency("Execute", std::chrono::milliseconds(5));
+  //
+  void SetMethodLatency(const std::string& methodName,
+                        std::chrono::microseconds latency,
+                        MockLatencyMode mode = MockLatencyMode::kVirtual) {
+    m_latencies[methodName] = {latency, mode};
+  }
+
+  void ClearLatencies() { m_latencies.clear(); }
+
+  // The sum of the virtual latencies of the calls so far.
+  std::chrono::microseconds GetVirtualTime() const { return m_virtual_time; }
+
+  // Appends interfaceName + "::" + method name to sequence on every call.
+  void SetCallSequence(std::shared_ptr<MockCallSequence> sequence,
+                       const std::string& interfaceName) {
+    m_call_sequence = std::move(sequence);
+    m_interface_name = interfaceName;
+  }
+
+  // IUnknown methods. QueryInterface fails unless it is overridden:
+  //
+  //    mock_client->SetMethodOverride(
+  //        "QueryInterface", [&](REFIID id, PVOID* object) -> HRESULT {
+  //          *object = &mock_advanced;
+  //          return S_OK;
+  //        });
+  //
   STDMETHOD(QueryInterface)(REFIID InterfaceId, PVOID* Interface) override {
-    return E_NOINTERFACE;
+    if (methodOverrides.find("QueryInterface") == methodOverrides.end()) {
+      return E_NOINTERFACE;
+    }
+    return MockMethod<HRESULT, REFIID, PVOID*>("QueryInterface", InterfaceId,
+                                               Interface);
   }
   STDMETHOD_(ULONG, AddRef)() override { return 1; }
   STDMETHOD_(ULONG, Release)() override { return 1; }
@@ -73,7 +119,20 @@ class MockDebugInterfaceBase : public TInterface {
     return std::count(m_call_history.begin(), m_call_history.end(), methodName);
   }
 
-  void ClearCallHistory() { m_call_history.clear(); }
+  // The number of calls to all methods except the ones in excluded.
+  size_t GetTotalCallCount(
+      const std::vector<std::string>& excluded = {}) const {
+    return std::count_if(m_call_history.begin(), m_call_history.end(),
+                         [&excluded](const std::string& name) {
+                           return std::find(excluded.begin(), excluded.end(),
+                                            name) == excluded.end();
+                         });
+  }
+
+  void ClearCallHistory() {
+    m_call_history.clear();
+    m_virtual_time = std::chrono::microseconds(0);
+  }
 
  protected:
   std::unordered_map<std::string, std::any> methodOverrides;
@@ -81,7 +140,7 @@ class MockDebugInterfaceBase : public TInterface {
   // Template helper for regular methods
   template <typename TReturn, typename... TArgs>
   TReturn MockMethod(const char* methodName, TArgs... args) {
-    m_call_history.push_back(methodName);
+    RecordCall(methodName);
 
     auto it = methodOverrides.find(methodName);
     if (it != methodOverrides.end()) {
@@ -100,7 +159,7 @@ class MockDebugInterfaceBase : public TInterface {
   // don't appear to work well with va_start
   template <typename TFunc>
   TFunc* GetOverride(const std::string& methodName) {
-    m_call_history.push_back(methodName);
+    RecordCall(methodName);
 
     auto it = methodOverrides.find(methodName);
     if (it != methodOverrides.end()) {
@@ -115,7 +174,32 @@ class MockDebugInterfaceBase : public TInterface {
   }
 
  private:
+  struct Latency {
+    std::chrono::microseconds latency;
+    MockLatencyMode mode;
+  };
+
+  void RecordCall(const std::string& methodName) {
+    m_call_history.push_back(methodName);
+    if (m_call_sequence) {
+      m_call_sequence->push_back(m_interface_name + "::" + methodName);
+    }
+
+    auto it = m_latencies.find(methodName);
+    if (it != m_latencies.end()) {
+      if (it->second.mode == MockLatencyMode::kReal) {
+        std::this_thread::sleep_for(it->second.latency);
+      } else {
+        m_virtual_time += it->second.latency;
+      }
+    }
+  }
+
   std::vector<std::string> m_call_history;
+  std::unordered_map<std::string, Latency> m_latencies;
+  std::chrono::microseconds m_virtual_time{0};
+  std::shared_ptr<MockCallSequence> m_call_sequence;
+  std::string m_interface_name;
 };
 
 #endif  // MOCK_DEBUG_INTERFACE_BASE_H
@@ -0,0 +1,145 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#ifndef MOCK_DEBUG_SYMBOL_GROUP_H
+#define MOCK_DEBUG_SYMBOL_GROUP_H
+
+#include "mock_debug_interface_base.h"
+
+// Symbol groups are returned by IDebugSymbols::GetScopeSymbolGroup as
+// IDebugSymbolGroup and queried for IDebugSymbolGroup2 so the mock
+// implements both and QueryInterface returns the mock itself.
+class MockDebugSymbolGroup : public MockDebugInterfaceBase<IDebugSymbolGroup2> {
+ public:
+  STDMETHOD(QueryInterface)(REFIID InterfaceId, PVOID* Interface) override {
+    *Interface = static_cast<IDebugSymbolGroup2*>(this);
+    return S_OK;
+  }
+
+  // IDebugSymbolGroup
+  STDMETHOD(GetNumberSymbols)(PULONG Number) override {
+    return MockMethod<HRESULT>("GetNumberSymbols", Number);
+  }
+
+  STDMETHOD(AddSymbol)(PCSTR Name, PULONG Index) override {
+    return MockMethod<HRESULT>("AddSymbol", Name, Index);
+  }
+
+  STDMETHOD(RemoveSymbolByName)(PCSTR Name) override {
+    return MockMethod<HRESULT>("RemoveSymbolByName", Name);
+  }
+
+  STDMETHOD(RemoveSymbolByIndex)(ULONG Index) override {
+    return MockMethod<HRESULT>("RemoveSymbolByIndex", Index);
+  }
+
+  STDMETHOD(GetSymbolName)(ULONG Index,
+                           PSTR Buffer,
+                           ULONG BufferSize,
+                           PULONG NameSize) override {
+    return MockMethod<HRESULT>("GetSymbolName", Index, Buffer, BufferSize,
+                               NameSize);
+  }
+
+  STDMETHOD(GetSymbolParameters)(ULONG Start,
+                                 ULONG Count,
+                                 PDEBUG_SYMBOL_PARAMETERS Params) override {
+    return MockMethod<HRESULT>("GetSymbolParameters", Start, Count, Params);
+  }
+
+  STDMETHOD(ExpandSymbol)(ULONG Index, BOOL Expand) override {
+    return MockMethod<HRESULT>("ExpandSymbol", Index, Expand);
+  }
+
+  STDMETHOD(OutputSymbols)(ULONG OutputControl,
+                           ULONG Flags,
+                           ULONG Start,
+                           ULONG Count) override {
+    return MockMethod<HRESULT>("OutputSymbols", OutputControl, Flags, Start,
+                               Count);
+  }
+
+  STDMETHOD(WriteSymbol)(ULONG Index, PCSTR Value) override {
+    return MockMethod<HRESULT>("WriteSymbol", Index, Value);
+  }
+
+  STDMETHOD(OutputAsType)(ULONG Index, PCSTR Type) override {
+    return MockMethod<HRESULT>("OutputAsType", Index, Type);
+  }
+
+  // IDebugSymbolGroup2
+  STDMETHOD(AddSymbolWide)(PCWSTR Name, PULONG Index) override {
+    return MockMethod<HRESULT>("AddSymbolWide", Name, Index);
+  }
+
+  STDMETHOD(RemoveSymbolByNameWide)(PCWSTR Name) override {
+    return MockMethod<HRESULT>("RemoveSymbolByNameWide", Name);
+  }
+
+  STDMETHOD(GetSymbolNameWide)(ULONG Index,
+                               PWSTR Buffer,
+                               ULONG BufferSize,
+                               PULONG NameSize) override {
+    return MockMethod<HRESULT>("GetSymbolNameWide", Index, Buffer, BufferSize,
+                               NameSize);
+  }
+
+  STDMETHOD(WriteSymbolWide)(ULONG Index, PCWSTR Value) override {
+    return MockMethod<HRESULT>("WriteSymbolWide", Index, Value);
+  }
+
+  STDMETHOD(OutputAsTypeWide)(ULONG Index, PCWSTR Type) override {
+    return MockMethod<HRESULT>("OutputAsTypeWide", Index, Type);
+  }
+
+  STDMETHOD(GetSymbolTypeName)(ULONG Index,
+                               PSTR Buffer,
+                               ULONG BufferSize,
+                               PULONG NameSize) override {
+    return MockMethod<HRESULT>("GetSymbolTypeName", Index, Buffer, BufferSize,
+                               NameSize);
+  }
+
+  STDMETHOD(GetSymbolTypeNameWide)(ULONG Index,
+                                   PWSTR Buffer,
+                                   ULONG BufferSize,
+                                   PULONG NameSize) override {
+    return MockMethod<HRESULT>("GetSymbolTypeNameWide", Index, Buffer,
+                               BufferSize, NameSize);
+  }
+
+  STDMETHOD(GetSymbolSize)(ULONG Index, PULONG Size) override {
+    return MockMethod<HRESULT>("GetSymbolSize", Index, Size);
+  }
+
+  STDMETHOD(GetSymbolOffset)(ULONG Index, PULONG64 Offset) override {
+    return MockMethod<HRESULT>("GetSymbolOffset", Index, Offset);
+  }
+
+  STDMETHOD(GetSymbolRegister)(ULONG Index, PULONG Register) override {
+    return MockMethod<HRESULT>("GetSymbolRegister", Index, Register);
+  }
+
+  STDMETHOD(GetSymbolValueText)(ULONG Index,
+                                PSTR Buffer,
+                                ULONG BufferSize,
+                                PULONG NameSize) override {
+    return MockMethod<HRESULT>("GetSymbolValueText", Index, Buffer,
+                               BufferSize, NameSize);
+  }
+
+  STDMETHOD(GetSymbolValueTextWide)(ULONG Index,
+                                    PWSTR Buffer,
+                                    ULONG BufferSize,
+                                    PULONG NameSize) override {
+    return MockMethod<HRESULT>("GetSymbolValueTextWide", Index, Buffer,
+                               BufferSize, NameSize);
+  }
+
+  STDMETHOD(GetSymbolEntryInformation)(ULONG Index,
+                                       PDEBUG_SYMBOL_ENTRY Entry) override {
+    return MockMethod<HRESULT>("GetSymbolEntryInformation", Index, Entry);
+  }
+};
+
+#endif  // MOCK_DEBUG_SYMBOL_GROUP_H
@@ -1,6 +1,9 @@
 // Copyright (c) 2025 Piet Hein Schouten
 // SPDX-License-Identifier: MIT
 
+#include <filesystem>
+#include <fstream>
+
 #include "../src/breakpoint.h"
 #include "../src/breakpoint_list.h"
 #include "../src/utils.h"
@@ -463,6 +466,35 @@ TEST(FromJson_NonArrayBreakpoints) {
                      list.GetBreakpointsCount());  // Should have no breakpoints
 }
 
+TEST(RoundTrip_WriteToFileReadFromFile) {
+  std::string path =
+      (std::filesystem::temp_directory_path() / "test_breakpoint_list.json")
+          .string();
+  std::vector<BreakpointList> lists = {
+      BreakpointList("kernel32!CreateFileW,chrome!C:\\test\\file.cpp:123", "",
+                     "first"),
+      BreakpointList("ntdll!NtCreateFile", "", "second")};
+
+  TEST_ASSERT(BreakpointList::WriteToFile(lists, path));
+  std::vector<BreakpointList> restored = BreakpointList::ReadFromFile(path);
+  TEST_ASSERT_EQUALS(2, restored.size());
+  TEST_ASSERT(lists[0].IsEqualTo(restored[0]));
+  TEST_ASSERT_EQUALS("second", restored[1].GetTag());
+
+  // Invalid JSON throws and a missing file has no lists.
+  std::ofstream(path) << "[{";
+  bool threw = false;
+  try {
+    BreakpointList::ReadFromFile(path);
+  } catch (const std::exception&) {
+    threw = true;
+  }
+  TEST_ASSERT(threw);
+
+  std::filesystem::remove(path);
+  TEST_ASSERT_EQUALS(0, BreakpointList::ReadFromFile(path).size());
+}
+
 int main() {
   return RUN_ALL_TESTS();
 }
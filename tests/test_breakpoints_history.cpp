@@ -1,6 +1,7 @@
 // Copyright (c) 2025 Piet Hein Schouten
 // SPDX-License-Identifier: MIT
 
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -732,6 +733,74 @@ TEST(SetBreakpointsInternal_CurrentLocation) {
   TEST_ASSERT_EQUALS(initial_history_size + 1, g_breakpoint_lists.size());
 }
 
+// Returns "chrome!Function0, chrome!Function1, ..."
+std::string MakeBreakpoints(size_t count) {
+  std::string breakpoints;
+  for (size_t i = 0; i < count; i++) {
+    breakpoints += (i == 0 ? "" : ", ") + std::string("chrome!Function") +
+                   std::to_string(i);
+  }
+  return breakpoints;
+}
+
+// Setting many breakpoints must not cost one engine call per breakpoint
+TEST(SetBreakpointsInternal_CallBudget) {
+  BreakpointsHistoryTest test;
+  std::string command;
+  test.mock_control->SetMethodOverride(
+      "Execute", [&command](ULONG OutputControl, PCSTR Command, ULONG Flags) {
+        command = Command;
+        return S_OK;
+      });
+
+  SetBreakpointsInternal(MakeBreakpoints(50), "", "", false, true);
+
+  TEST_ASSERT_EQUALS(1, test.mock_control->GetCallCount("Execute"));
+  TEST_ASSERT_STRING_CONTAINS(command, "bp chrome!Function0; ");
+  TEST_ASSERT_STRING_CONTAINS(command, "bp chrome!Function49; ");
+}
+
+TEST(SetAllProcessesBreakpointsInternal_CallBudget) {
+  BreakpointsHistoryTest test;
+  std::vector<std::string> commands;
+  test.mock_control->SetMethodOverride(
+      "Execute", [&commands](ULONG OutputControl, PCSTR Command, ULONG Flags) {
+        commands.push_back(Command);
+        // A function which no longer exists in the loaded module
+        return strcmp(Command, "bp chrome!Function10") == 0 ? E_FAIL : S_OK;
+      });
+  PDEBUG_EVENT_CALLBACKS callbacks = nullptr;
+  test.mock_client->SetMethodOverride(
+      "SetEventCallbacks", [&callbacks](PDEBUG_EVENT_CALLBACKS Callbacks) {
+        callbacks = Callbacks;
+        return S_OK;
+      });
+
+  std::string args = "'" + MakeBreakpoints(50) + "'";
+  HRESULT hr = SetAllProcessesBreakpointsInternal(test.mock_client, args.c_str());
+  TEST_ASSERT_EQUALS(S_OK, hr);
+  TEST_ASSERT_EQUALS(3, commands.size());
+  TEST_ASSERT_EQUALS(std::string(".childdbg 1"), commands[0]);
+  TEST_ASSERT(callbacks != nullptr);
+
+  // Each breakpoint of a loaded module is set with its own command so
+  // that one which can't be resolved doesn't stop the others. Nothing
+  // else calls the engine.
+  commands.clear();
+  test.ClearCallHistory();
+  callbacks->LoadModule(0, 0x7ff9a2f00000, 0x98a1000, "chrome",
+                        "D:\\cs\\src\\out\\release_x64\\chrome.dll", 0, 0);
+  TEST_ASSERT_EQUALS(50, commands.size());
+  TEST_ASSERT_EQUALS(50, test.GetEngineCallCount());
+  TEST_ASSERT_EQUALS(std::string("bp chrome!Function11"), commands[11]);
+  TEST_ASSERT_EQUALS(std::string("bp chrome!Function49"), commands[49]);
+
+  // Other modules don't call the engine
+  callbacks->LoadModule(0, 0x7ffec7d00000, 0x268000, "ntdll",
+                        "C:\\Windows\\System32\\ntdll.dll", 0, 0);
+  TEST_ASSERT_EQUALS(50, test.GetEngineCallCount());
+}
+
 // Test DebugExtensionInitialize
 TEST(DebugExtensionInitialize_Success) {
   BreakpointsHistoryTest test;
@@ -0,0 +1,156 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../src/call_tree.h"
+#include "../src/json.hpp"
+#include "unit_test_runner.h"
+
+using JSON = nlohmann::json;
+
+using stack_sampler::CallTree;
+
+namespace {
+
+// Names addresses by their upper bits so that addresses within the
+// same 0x100 byte "function" map to the same name.
+std::string FakeSymbolizer(ULONG64 address) {
+  static const std::map<ULONG64, std::string> names = {
+      {0x1000, "ntdll!RtlUserThreadStart"},
+      {0x2000, "kernel32!BaseThreadInitThunk"},
+      {0x3000, "chrome!MessageLoop::Run"},
+      {0x4000, "chrome!Task::Run"},
+      {0x5000, "chrome!Sleep"}};
+  auto it = names.find(address & ~0xFFULL);
+  if (it != names.end()) {
+    return it->second;
+  }
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "0x%llx",
+           static_cast<unsigned long long>(address));
+  return buffer;
+}
+
+}  // namespace
+
+DECLARE_TEST_RUNNER()
+
+TEST(CallTree_SharesCommonPrefixes) {
+  CallTree tree;
+  tree.AddStack({0x1000, 0x2000, 0x3000});
+  tree.AddStack({0x1000, 0x2000, 0x3000});
+  tree.AddStack({0x1000, 0x2000, 0x4000});
+  tree.AddStack({0x1000, 0x5000}, 3);
+
+  TEST_ASSERT_EQUALS(6, tree.GetTotalCount());
+  // 0x1000 -> {0x2000 -> {0x3000, 0x4000}, 0x5000}
+  TEST_ASSERT_EQUALS(5, tree.GetNodeCount());
+
+  std::vector<ULONG64> addresses = tree.GetAddresses();
+  TEST_ASSERT_EQUALS(5, addresses.size());
+  TEST_ASSERT_EQUALS(0x1000, addresses.front());
+  TEST_ASSERT_EQUALS(0x5000, addresses.back());
+
+  tree.Clear();
+  TEST_ASSERT_EQUALS(0, tree.GetTotalCount());
+  TEST_ASSERT_EQUALS(0, tree.GetNodeCount());
+}
+
+TEST(CallTree_ForEachStackRoundTrips) {
+  CallTree tree;
+  tree.AddStack({0x1000, 0x2000, 0x3000}, 2);
+  tree.AddStack({0x1000, 0x2000}, 1);
+  tree.AddStack({0x1000, 0x2000, 0x4000}, 4);
+
+  std::map<std::vector<ULONG64>, ULONG64> stacks;
+  tree.ForEachStack([&](const std::vector<ULONG64>& frames, ULONG64 count) {
+    stacks[frames] += count;
+  });
+
+  // A stack which ends in the middle of another stack is kept separate.
+  TEST_ASSERT_EQUALS(3, stacks.size());
+  TEST_ASSERT_EQUALS(2, (stacks[{0x1000, 0x2000, 0x3000}]));
+  TEST_ASSERT_EQUALS(1, (stacks[{0x1000, 0x2000}]));
+  TEST_ASSERT_EQUALS(4, (stacks[{0x1000, 0x2000, 0x4000}]));
+}
+
+TEST(FormatFoldedStacks_MergesBySymbolName) {
+  CallTree tree;
+  // Different offsets within the same functions.
+  tree.AddStack({0x1010, 0x2020, 0x3030}, 2);
+  tree.AddStack({0x1040, 0x2050, 0x3060}, 3);
+  tree.AddStack({0x1010, 0x2020, 0x4010}, 1);
+
+  std::string folded =
+      stack_sampler::FormatFoldedStacks({{"", &tree}}, FakeSymbolizer);
+  TEST_ASSERT_EQUALS(
+      std::string("ntdll!RtlUserThreadStart;kernel32!BaseThreadInitThunk;"
+                  "chrome!MessageLoop::Run 5\n"
+                  "ntdll!RtlUserThreadStart;kernel32!BaseThreadInitThunk;"
+                  "chrome!Task::Run 1\n"),
+      folded);
+}
+
+TEST(FormatFoldedStacks_LabelsAreOutermostFrame) {
+  CallTree first;
+  first.AddStack({0x1000, 0x5000}, 2);
+  CallTree second;
+  second.AddStack({0x1000, 0x9000});
+
+  std::string folded = stack_sampler::FormatFoldedStacks(
+      {{"thread_10", &first}, {"thread_20", &second}}, FakeSymbolizer);
+  TEST_ASSERT_STRING_CONTAINS(
+      folded, "thread_10;ntdll!RtlUserThreadStart;chrome!Sleep 2\n");
+  TEST_ASSERT_STRING_CONTAINS(
+      folded, "thread_20;ntdll!RtlUserThreadStart;0x9000 1\n");
+}
+
+TEST(FormatFlameGraphJson_Structure) {
+  CallTree tree;
+  tree.AddStack({0x1000, 0x3000}, 3);
+  tree.AddStack({0x1000, 0x3000, 0x4000}, 2);
+  tree.AddStack({0x1000, 0x5000}, 1);
+
+  JSON root = JSON::parse(
+      stack_sampler::FormatFlameGraphJson({{"", &tree}}, FakeSymbolizer));
+  TEST_ASSERT_EQUALS(std::string("all"), root["name"].get<std::string>());
+  TEST_ASSERT_EQUALS(6, root["value"].get<int>());
+  TEST_ASSERT_EQUALS(1, root["children"].size());
+
+  const JSON& start = root["children"][0];
+  TEST_ASSERT_EQUALS(std::string("ntdll!RtlUserThreadStart"),
+                     start["name"].get<std::string>());
+  TEST_ASSERT_EQUALS(6, start["value"].get<int>());
+  TEST_ASSERT_EQUALS(2, start["children"].size());
+
+  // The children are sorted by name.
+  const JSON& run = start["children"][0];
+  TEST_ASSERT_EQUALS(std::string("chrome!MessageLoop::Run"),
+                     run["name"].get<std::string>());
+  TEST_ASSERT_EQUALS(5, run["value"].get<int>());
+  TEST_ASSERT_EQUALS(2, run["children"][0]["value"].get<int>());
+  TEST_ASSERT_EQUALS(1, start["children"][1]["value"].get<int>());
+}
+
+TEST(GetTopFunctions_SortsBySelfCount) {
+  CallTree tree;
+  tree.AddStack({0x1000, 0x3000}, 2);
+  tree.AddStack({0x1000, 0x3000, 0x5000}, 7);
+  tree.AddStack({0x1000, 0x4000, 0x5010}, 1);
+  tree.AddStack({0x1000, 0x4000}, 4);
+
+  auto top = stack_sampler::GetTopFunctions({{"", &tree}}, FakeSymbolizer, 2);
+  TEST_ASSERT_EQUALS(2, top.size());
+  TEST_ASSERT_EQUALS(std::string("chrome!Sleep"), top[0].first);
+  TEST_ASSERT_EQUALS(8, top[0].second);
+  TEST_ASSERT_EQUALS(std::string("chrome!Task::Run"), top[1].first);
+  TEST_ASSERT_EQUALS(4, top[1].second);
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
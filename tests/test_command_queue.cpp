@@ -0,0 +1,369 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/command_queue.h"
+#include "../src/utils.h"
+#include "unit_test_runner.h"
+
+utils::DebugInterfaces g_debug;
+
+using command_queue::CommandQueue;
+using command_queue::Priority;
+using command_queue::QueueStats;
+using command_queue::SessionOptions;
+using command_queue::SessionStats;
+
+namespace {
+
+// Keeps the queue's thread busy until the returned promise is set so
+// that operations can be queued before any of them run.
+std::promise<void> BlockQueue(CommandQueue& queue) {
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  queue.Post([released]() {
+    released.wait();
+    return JSON();
+  });
+  return release;
+}
+
+const SessionStats* FindSession(const std::vector<SessionStats>& sessions,
+                                command_queue::SessionId id) {
+  for (const SessionStats& stats : sessions) {
+    if (stats.session == id) {
+      return &stats;
+    }
+  }
+  return nullptr;
+}
+
+}  // namespace
+
+DECLARE_TEST_RUNNER()
+
+TEST(Execute_RunsOnOneThreadInOrder) {
+  CommandQueue queue;
+  queue.Start();
+
+  std::thread::id processor_thread;
+  std::vector<int> order;
+  for (int i = 0; i < 3; i++) {
+    JSON result = queue.Execute([&, i]() {
+      processor_thread = std::this_thread::get_id();
+      order.push_back(i);
+      return JSON(i * 10);
+    });
+    TEST_ASSERT_EQUALS(i * 10, result.get<int>());
+  }
+
+  TEST_ASSERT(processor_thread != std::this_thread::get_id());
+  TEST_ASSERT_EQUALS(3, order.size());
+  TEST_ASSERT_EQUALS(2, order[2]);
+
+  QueueStats stats = queue.GetStats();
+  TEST_ASSERT_EQUALS(3, stats.executed);
+  TEST_ASSERT_EQUALS(0, stats.depth);
+}
+
+TEST(Execute_ConcurrentCallers) {
+  CommandQueue queue;
+  queue.Start();
+
+  // The operations must never overlap.
+  std::atomic<int> running{0};
+  std::atomic<int> overlaps{0};
+  std::vector<std::thread> callers;
+  for (int i = 0; i < 4; i++) {
+    callers.emplace_back([&]() {
+      for (int j = 0; j < 25; j++) {
+        queue.Execute([&]() {
+          if (running.fetch_add(1) != 0) {
+            overlaps++;
+          }
+          std::this_thread::sleep_for(std::chrono::microseconds(50));
+          running--;
+          return JSON();
+        });
+      }
+    });
+  }
+  for (std::thread& caller : callers) {
+    caller.join();
+  }
+
+  TEST_ASSERT_EQUALS(0, overlaps.load());
+  QueueStats stats = queue.GetStats();
+  TEST_ASSERT_EQUALS(100, stats.executed);
+  TEST_ASSERT(stats.max_depth >= 1);
+  TEST_ASSERT(stats.max_wait_us >= stats.total_wait_us / stats.executed);
+}
+
+TEST(Execute_PassesOnExceptions) {
+  CommandQueue queue;
+  queue.Start();
+
+  bool thrown = false;
+  try {
+    queue.Execute([]() -> JSON { throw std::runtime_error("engine error"); });
+  } catch (const std::runtime_error& e) {
+    thrown = std::string(e.what()) == "engine error";
+  }
+  TEST_ASSERT(thrown);
+
+  // The queue keeps working.
+  TEST_ASSERT_EQUALS(1, queue.Execute([]() { return JSON(1); }).get<int>());
+}
+
+TEST(Stop_RunsPostedOperations) {
+  CommandQueue queue;
+  queue.Start();
+
+  std::atomic<int> count{0};
+  for (int i = 0; i < 10; i++) {
+    queue.Post([&]() {
+      count++;
+      return JSON();
+    });
+  }
+  queue.Stop();
+  TEST_ASSERT_EQUALS(10, count.load());
+  TEST_ASSERT(!queue.IsRunning());
+
+  // Operations are rejected once the queue is stopped.
+  JSON result = queue.Execute([&]() {
+    count++;
+    return JSON();
+  });
+  TEST_ASSERT(result.contains("error"));
+  TEST_ASSERT_EQUALS(10, count.load());
+}
+
+TEST(Sessions_DeficitRoundRobin) {
+  CommandQueue queue;
+  queue.Start();
+
+  // Session 1 queues operations of 1.5 quanta before session 2 queues
+  // short ones. Session 1 goes into debt with each of its operations
+  // and skips turns, so session 2 gets more turns than it would with
+  // plain round robin (1 2 1 2 ...) instead of waiting behind all of
+  // the long operations.
+  std::vector<int> order;
+  std::promise<void> release = BlockQueue(queue);
+  for (int i = 0; i < 4; i++) {
+    queue.Post(
+        [&order]() {
+          std::this_thread::sleep_for(std::chrono::microseconds(
+              CommandQueue::kQuantumUs * 3 / 2));
+          order.push_back(1);
+          return JSON();
+        },
+        1);
+  }
+  for (int i = 0; i < 4; i++) {
+    queue.Post(
+        [&order]() {
+          order.push_back(2);
+          return JSON();
+        },
+        2);
+  }
+  release.set_value();
+  queue.Stop();
+
+  TEST_ASSERT_EQUALS(8, order.size());
+  TEST_ASSERT_EQUALS(1, order[0]);
+  TEST_ASSERT_EQUALS(2, order[1]);
+  TEST_ASSERT_EQUALS(2, order[2]);
+  TEST_ASSERT_EQUALS(1, order.back());
+  TEST_ASSERT_EQUALS(1, order[order.size() - 2]);
+
+  TEST_ASSERT_EQUALS(9, queue.GetStats().executed);
+}
+
+TEST(Sessions_InteractiveFirst) {
+  CommandQueue queue;
+  queue.Start();
+
+  SessionOptions interactive;
+  interactive.priority = Priority::kInteractive;
+  queue.SetSessionOptions(2, interactive);
+
+  std::vector<int> order;
+  std::promise<void> release = BlockQueue(queue);
+  for (int session = 1; session <= 2; session++) {
+    for (int i = 0; i < 3; i++) {
+      queue.Post(
+          [&order, session]() {
+            order.push_back(session);
+            return JSON();
+          },
+          session);
+    }
+  }
+  release.set_value();
+  queue.Stop();
+
+  TEST_ASSERT_EQUALS(6, order.size());
+  TEST_ASSERT_EQUALS(2, order[2]);
+  TEST_ASSERT_EQUALS(1, order[3]);
+}
+
+TEST(Sessions_Limits) {
+  CommandQueue queue;
+  queue.Start();
+
+  // One operation at a time.
+  SessionOptions options;
+  options.max_concurrent = 1;
+  queue.SetSessionOptions(1, options);
+
+  std::promise<void> release = BlockQueue(queue);
+  queue.Post([]() { return JSON(); }, 1);
+  JSON result = queue.Execute([]() { return JSON(1); }, 1);
+  TEST_ASSERT(result.contains("error"));
+  TEST_ASSERT_STRING_CONTAINS(result["error"].get<std::string>(), "limit 1");
+
+  // Other sessions aren't limited.
+  std::future<JSON> other = std::async(std::launch::async, [&queue]() {
+    return queue.Execute([]() { return JSON(2); }, 2);
+  });
+  release.set_value();
+  TEST_ASSERT_EQUALS(2, other.get().get<int>());
+  TEST_ASSERT_EQUALS(1, queue.Execute([]() { return JSON(1); }, 1).get<int>());
+
+  // Two operations and then one per second.
+  options = SessionOptions();
+  options.rate_limit = 1;
+  options.burst = 2;
+  queue.SetSessionOptions(3, options);
+  TEST_ASSERT_EQUALS(3, queue.Execute([]() { return JSON(3); }, 3).get<int>());
+  TEST_ASSERT_EQUALS(3, queue.Execute([]() { return JSON(3); }, 3).get<int>());
+  result = queue.Execute([]() { return JSON(3); }, 3);
+  TEST_ASSERT_STRING_CONTAINS(result["error"].get<std::string>(),
+                              "Rate limit");
+
+  std::vector<SessionStats> sessions = queue.GetSessionStats();
+  const SessionStats* stats = FindSession(sessions, 1);
+  TEST_ASSERT(stats != nullptr);
+  TEST_ASSERT_EQUALS(2, stats->executed);
+  TEST_ASSERT_EQUALS(1, stats->rejected);
+  stats = FindSession(sessions, 3);
+  TEST_ASSERT_EQUALS(2, stats->executed);
+  TEST_ASSERT_EQUALS(1, stats->rejected);
+  TEST_ASSERT_EQUALS(0, stats->depth);
+
+  // A removed session starts over with the default options.
+  queue.RemoveSession(3);
+  TEST_ASSERT(FindSession(queue.GetSessionStats(), 3) == nullptr);
+  TEST_ASSERT_EQUALS(0.0, queue.GetSessionOptions(3).rate_limit);
+  TEST_ASSERT_EQUALS(3, queue.Execute([]() { return JSON(3); }, 3).get<int>());
+}
+
+TEST(Sessions_ReusedIdStartsWithoutDebt) {
+  CommandQueue queue;
+  queue.Start();
+
+  // The first client runs up a debt.
+  queue.Execute(
+      []() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(30));
+        return JSON();
+      },
+      7);
+
+  // It disconnects while another long operation runs and a new client
+  // gets the same id before the operation finishes.
+  std::atomic<bool> started{false};
+  std::promise<void> release;
+  std::shared_future<void> released = release.get_future().share();
+  queue.Post(
+      [&started, released]() {
+        started = true;
+        released.wait();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        return JSON();
+      },
+      7);
+  while (!started) {
+    std::this_thread::yield();
+  }
+  queue.RemoveSession(7);
+
+  std::future<JSON> result = std::async(std::launch::async, [&queue]() {
+    return queue.Execute([]() { return JSON(7); }, 7);
+  });
+  while (queue.GetStats().depth == 0) {
+    std::this_thread::yield();
+  }
+
+  std::vector<SessionStats> reused = queue.GetSessionStats();
+  release.set_value();
+  TEST_ASSERT_EQUALS(7, result.get().get<int>());
+
+  const SessionStats* stats = FindSession(reused, 7);
+  TEST_ASSERT(stats != nullptr);
+  TEST_ASSERT_EQUALS(CommandQueue::kQuantumUs, stats->deficit_us);
+
+  // The old client's operation isn't charged to the new one either.
+  std::vector<SessionStats> sessions = queue.GetSessionStats();
+  stats = FindSession(sessions, 7);
+  TEST_ASSERT(stats != nullptr);
+  TEST_ASSERT_EQUALS(1, stats->executed);
+  TEST_ASSERT(stats->total_run_us < 50000);
+  queue.Stop();
+}
+
+TEST(Sessions_ReusedIdOfInteractiveSession) {
+  CommandQueue queue;
+  queue.Start();
+
+  SessionOptions interactive;
+  interactive.priority = Priority::kInteractive;
+  queue.SetSessionOptions(4, interactive);
+
+  std::vector<int> order;
+  auto record = [&order](int session) {
+    return [&order, session]() {
+      order.push_back(session);
+      return JSON();
+    };
+  };
+
+  // An interactive client disconnects with operations still queued and
+  // a new client with the same id asks for interactive priority again.
+  std::promise<void> release = BlockQueue(queue);
+  for (int i = 0; i < 3; i++) {
+    queue.Post(record(1), 1);
+  }
+  queue.Post(record(4), 4);
+  queue.Post(record(4), 4);
+  queue.RemoveSession(4);
+  queue.SetSessionOptions(4, interactive);
+  queue.Post(record(4), 4);
+
+  std::vector<SessionStats> sessions = queue.GetSessionStats();
+  const SessionStats* stats = FindSession(sessions, 4);
+  TEST_ASSERT(stats != nullptr);
+  TEST_ASSERT(stats->priority == Priority::kInteractive);
+  TEST_ASSERT_EQUALS(3, stats->depth);
+
+  release.set_value();
+  queue.Stop();
+
+  TEST_ASSERT_EQUALS(6, order.size());
+  TEST_ASSERT_EQUALS(4, order[0]);
+  TEST_ASSERT_EQUALS(4, order[2]);
+  TEST_ASSERT_EQUALS(1, order[3]);
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,223 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/event_journal.h"
+#include "../src/utils.h"
+#include "unit_test_runner.h"
+
+utils::DebugInterfaces g_debug;
+
+using event_journal::Event;
+using event_journal::EventJournal;
+using event_journal::EventType;
+using event_journal::JournalStats;
+using event_journal::Query;
+using event_journal::StringTable;
+
+namespace {
+
+uint32_t TypeBit(EventType type) {
+  return 1u << static_cast<uint32_t>(type);
+}
+
+// The events of starting a renderer and hitting a breakpoint.
+void AppendStartup(EventJournal& journal) {
+  journal.Append(EventType::kCreateProcess, 0x3c4, 0x1a30, 0x7ff612340000, 0,
+                 "chrome");
+  journal.Append(EventType::kLoadModule, 0x3c4, 0x1a30, 0x7ffec7d00000,
+                 0x268000, "ntdll");
+  journal.Append(EventType::kLoadModule, 0x3c4, 0x1a30, 0x7ffec6a10000,
+                 0xc9000, "KERNEL32");
+  journal.Append(EventType::kCreateThread, 0x3c4, 0x1b40, 0x7ffec7d4a2c0, 0);
+  journal.Append(EventType::kLoadModule, 0x3c4, 0x1b40, 0x7ff9a2f00000,
+                 0x98a1000, "chrome_elf");
+  journal.Append(EventType::kException, 0x3c4, 0x1b40, 0x7ff9a5b1e2c0,
+                 0xc0000005, "chrome_elf", true);
+  journal.Append(EventType::kLoadModule, 0x5f0, 0x2a8, 0x7ffec7d00000,
+                 0x268000, "ntdll");
+  journal.Append(EventType::kBreakpoint, 0x3c4, 0x1a30, 0x7ff9a5b1e2c0, 2,
+                 "chrome");
+  journal.Append(EventType::kExitThread, 0x3c4, 0x1b40, 0, 0);
+}
+
+}  // namespace
+
+DECLARE_TEST_RUNNER()
+
+TEST(EventType_Names) {
+  TEST_ASSERT_EQUALS(std::string("LoadModule"),
+                     event_journal::GetEventTypeName(EventType::kLoadModule));
+
+  EventType type = EventType::kBreakpoint;
+  TEST_ASSERT(event_journal::ParseEventType("exception", type));
+  TEST_ASSERT(type == EventType::kException);
+  TEST_ASSERT(event_journal::ParseEventType("UnloadModule", type));
+  TEST_ASSERT(type == EventType::kUnloadModule);
+  TEST_ASSERT(!event_journal::ParseEventType("module", type));
+}
+
+TEST(StringTable_Intern) {
+  StringTable strings;
+  TEST_ASSERT_EQUALS(0, strings.Intern(""));
+  uint32_t chrome = strings.Intern("chrome");
+  uint32_t ntdll = strings.Intern("ntdll");
+  TEST_ASSERT(chrome != ntdll);
+  TEST_ASSERT_EQUALS(chrome, strings.Intern("chrome"));
+  TEST_ASSERT_EQUALS(std::string("ntdll"), strings.Get(ntdll));
+  TEST_ASSERT_EQUALS(std::string(""), strings.Get(1000));
+  TEST_ASSERT_EQUALS(3, strings.GetSize());
+}
+
+TEST(Find_AllEvents) {
+  EventJournal journal(16);
+  AppendStartup(journal);
+
+  std::vector<Event> events = journal.Find(Query());
+  TEST_ASSERT_EQUALS(9, events.size());
+  TEST_ASSERT_EQUALS(1, events[0].sequence);
+  TEST_ASSERT(events[0].type == EventType::kCreateProcess);
+  TEST_ASSERT_EQUALS(std::string("chrome"), events[0].module);
+
+  const Event& exception = events[5];
+  TEST_ASSERT(exception.type == EventType::kException);
+  TEST_ASSERT(exception.first_chance);
+  TEST_ASSERT_EQUALS(0x3c4, exception.process_id);
+  TEST_ASSERT_EQUALS(0x1b40, exception.thread_id);
+  TEST_ASSERT_EQUALS(0x7ff9a5b1e2c0ULL, exception.address);
+  TEST_ASSERT_EQUALS(0xc0000005ULL, exception.argument);
+
+  TEST_ASSERT(events[8].module.empty());
+  TEST_ASSERT(events[7].time_us >= events[0].time_us);
+}
+
+TEST(Find_Filters) {
+  EventJournal journal(16);
+  AppendStartup(journal);
+
+  Query query;
+  query.type_mask = TypeBit(EventType::kLoadModule);
+  TEST_ASSERT_EQUALS(4, journal.Find(query).size());
+
+  query.has_process_id = true;
+  query.process_id = 0x5f0;
+  std::vector<Event> events = journal.Find(query);
+  TEST_ASSERT_EQUALS(1, events.size());
+  TEST_ASSERT_EQUALS(7, events[0].sequence);
+
+  // Module names match case insensitive substrings.
+  query = Query();
+  query.module = "CHROME";
+  events = journal.Find(query);
+  TEST_ASSERT_EQUALS(4, events.size());
+  TEST_ASSERT_EQUALS(std::string("chrome_elf"), events[1].module);
+
+  // The newest events are returned.
+  query = Query();
+  query.limit = 2;
+  events = journal.Find(query);
+  TEST_ASSERT_EQUALS(2, events.size());
+  TEST_ASSERT_EQUALS(8, events[0].sequence);
+  TEST_ASSERT_EQUALS(9, events[1].sequence);
+
+  query = Query();
+  query.after_sequence = 6;
+  events = journal.Find(query);
+  TEST_ASSERT_EQUALS(3, events.size());
+  TEST_ASSERT_EQUALS(7, events[0].sequence);
+
+  query = Query();
+  query.start_time_us = journal.GetTimeUs() + 1000000;
+  TEST_ASSERT_EQUALS(0, journal.Find(query).size());
+  query = Query();
+  query.end_time_us = events[2].time_us;
+  TEST_ASSERT_EQUALS(9, journal.Find(query).size());
+}
+
+TEST(Find_Overwritten) {
+  EventJournal journal(4);
+  for (uint32_t i = 0; i < 10; i++) {
+    journal.Append(EventType::kCreateThread, 1, i, 0x1000 + i, 0);
+  }
+
+  std::vector<Event> events = journal.Find(Query());
+  TEST_ASSERT_EQUALS(4, events.size());
+  TEST_ASSERT_EQUALS(7, events[0].sequence);
+  TEST_ASSERT_EQUALS(6, events[0].thread_id);
+  TEST_ASSERT_EQUALS(0x1009ULL, events[3].address);
+
+  JournalStats stats = journal.GetStats();
+  TEST_ASSERT_EQUALS(4, stats.capacity);
+  TEST_ASSERT_EQUALS(10, stats.appended);
+  TEST_ASSERT_EQUALS(6, stats.overwritten);
+  TEST_ASSERT_EQUALS(0, stats.interned_strings);
+}
+
+TEST(Find_WhileAppending) {
+  EventJournal journal(64);
+  std::atomic<bool> done{false};
+
+  std::thread writer([&]() {
+    for (uint32_t i = 1; i <= 20000; i++) {
+      // The address and argument are derived from the thread id so
+      // that a torn record would be detected.
+      journal.Append(EventType::kLoadModule, 1, i, i * 16ULL, i * 3ULL,
+                     i % 2 ? "odd" : "even");
+    }
+    done = true;
+  });
+
+  size_t checked = 0;
+  while (!done) {
+    for (const Event& event : journal.Find(Query())) {
+      TEST_ASSERT_EQUALS(event.thread_id * 16ULL, event.address);
+      TEST_ASSERT_EQUALS(event.thread_id * 3ULL, event.argument);
+      TEST_ASSERT_EQUALS(std::string(event.thread_id % 2 ? "odd" : "even"),
+                         event.module);
+      TEST_ASSERT_EQUALS(event.sequence, event.thread_id);
+      checked++;
+    }
+  }
+  writer.join();
+
+  TEST_ASSERT(checked > 0);
+  std::vector<Event> events = journal.Find(Query());
+  TEST_ASSERT_EQUALS(64, events.size());
+  TEST_ASSERT_EQUALS(20000, events.back().sequence);
+}
+
+TEST(FormatEvent_Lines) {
+  Event event;
+  event.sequence = 12;
+  event.time_us = 3512345;
+  event.type = EventType::kLoadModule;
+  event.process_id = 0x3c4;
+  event.thread_id = 0x1a30;
+  event.address = 0x7ff9a2f00000;
+  event.argument = 0x98a1000;
+  event.module = "chrome";
+  TEST_ASSERT_EQUALS(
+      std::string("#12       3.512s LoadModule    pid 0x3c4 tid 0x1a30 chrome "
+                  "0x7ff9a2f00000 size 0x98a1000"),
+      event_journal::FormatEvent(event));
+
+  event.type = EventType::kException;
+  event.argument = 0xc0000005;
+  event.first_chance = true;
+  TEST_ASSERT_STRING_CONTAINS(event_journal::FormatEvent(event),
+                              "code 0xc0000005 first chance");
+
+  event.type = EventType::kExitThread;
+  event.module.clear();
+  event.argument = 0;
+  TEST_ASSERT_STRING_CONTAINS(event_journal::FormatEvent(event),
+                              "tid 0x1a30 exit code 0x0");
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,358 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../src/execution_context.h"
+#include "../src/utils.h"
+#include "debug_interfaces_test_base.h"
+#include "unit_test_runner.h"
+
+utils::DebugInterfaces g_debug;
+
+using execution_context::ContextCache;
+using execution_context::ContextCacheStats;
+using execution_context::ExecutionContext;
+
+namespace {
+
+// The "lsa ." window for the given line (4 lines before, 5 after).
+std::string SourceWindow(uint32_t line) {
+  std::string window;
+  for (uint32_t i = line - 4; i <= line + 5; i++) {
+    window += (i == line ? ">" : " ") + std::to_string(i) + ": code" +
+              std::to_string(i) + "\n";
+  }
+  return window;
+}
+
+ExecutionContext MakeContext(uint32_t line) {
+  ExecutionContext context;
+  context.process_id = 6;
+  context.command_line = "\"D:\\cs\\src\\out\\release_x64\\chrome.exe\" --type=utility";
+  context.thread_id = 92;
+  context.source_file = "D:\\cs\\src\\media\\foo.cc";
+  context.source_line = line;
+  context.source_context = SourceWindow(line);
+  context.call_stack = {"chrome!media::Foo::Bar+0x10",
+                        "chrome!media::Foo::Run+0x20",
+                        "chrome!base::TaskRunner::Run+0x30"};
+  return context;
+}
+
+}  // namespace
+
+// A stopped target in process 6 with the output of the
+// commands which execution_context::Capture executes.
+class CaptureTest : public DebugInterfacesTestBase {
+ public:
+  std::vector<std::string> executed;
+
+  CaptureTest() : DebugInterfacesTestBase(g_debug) {
+    mock_system_objects->SetMethodOverride("GetCurrentProcessId",
+                                           [](PULONG id) -> HRESULT {
+                                             *id = 6;
+                                             return S_OK;
+                                           });
+    mock_system_objects->SetMethodOverride("GetCurrentThreadId",
+                                           [](PULONG id) -> HRESULT {
+                                             *id = 92;
+                                             return S_OK;
+                                           });
+    mock_system_objects->SetMethodOverride("GetNumberProcesses",
+                                           [](PULONG number) -> HRESULT {
+                                             *number = 3;
+                                             return S_OK;
+                                           });
+    mock_control->SetMethodOverride("GetExecutionStatus",
+                                    [](PULONG status) -> HRESULT {
+                                      *status = DEBUG_STATUS_BREAK;
+                                      return S_OK;
+                                    });
+    mock_symbols->SetMethodOverride(
+        "GetScope",
+        [](PULONG64 offset, PDEBUG_STACK_FRAME frame, PVOID scope_context,
+           ULONG scope_context_size) -> HRESULT {
+          *offset = 0x7ff9a5b1e2c0;
+          return S_OK;
+        });
+    mock_symbols->SetMethodOverride(
+        "GetLineByOffset",
+        [](ULONG64 offset, PULONG line, PSTR file_buffer,
+           ULONG file_buffer_size, PULONG file_size,
+           PULONG64 displacement) -> HRESULT {
+          *line = 520;
+          strncpy(file_buffer, "D:\\cs\\src\\media\\foo.cc",
+                  file_buffer_size);
+          return S_OK;
+        });
+
+    // Route the output of Execute to the capture callbacks
+    // which utils::ExecuteCommand installs.
+    mock_client->SetMethodOverride(
+        "GetOutputCallbacks",
+        [](PDEBUG_OUTPUT_CALLBACKS* callbacks) -> HRESULT {
+          *callbacks = nullptr;
+          return S_OK;
+        });
+    mock_client->SetMethodOverride(
+        "SetOutputCallbacks",
+        [this](PDEBUG_OUTPUT_CALLBACKS callbacks) -> HRESULT {
+          output_callbacks_ = callbacks;
+          return S_OK;
+        });
+    mock_control->SetMethodOverride(
+        "Execute",
+        [this](ULONG output_control, PCSTR command, ULONG flags) -> HRESULT {
+          executed.push_back(command);
+          std::string text = command;
+          std::string output;
+          if (text.rfind("dx ", 0) == 0) {
+            output = "CommandLine.Buffer : 0x1f2e3c40 : \"chrome.exe "
+                     "--type=utility\" [Type: wchar_t *]\n";
+          } else if (text == "lsa .") {
+            output = SourceWindow(520);
+          } else if (text.rfind("kc ", 0) == 0) {
+            output =
+                " # Call Site\n"
+                "00 chrome!media::Foo::Bar\n"
+                "01 chrome!media::Foo::Run\n";
+          }
+          if (output_callbacks_) {
+            output_callbacks_->Output(DEBUG_OUTPUT_NORMAL, output.c_str());
+          }
+          return S_OK;
+        });
+  }
+
+ private:
+  PDEBUG_OUTPUT_CALLBACKS output_callbacks_ = nullptr;
+};
+
+DECLARE_TEST_RUNNER()
+
+TEST(Format_FullContext) {
+  ExecutionContext context = MakeContext(520);
+  context.extra = "Extra Context:\n  Hint";
+  std::string result = execution_context::Format(context);
+
+  TEST_ASSERT_EQUALS(0, result.find("Current Execution Context:\n"
+                                    "  Process: 6\n"
+                                    "  Process Command Line: \"D:\\cs"));
+  TEST_ASSERT_STRING_CONTAINS(result, "  Thread: 92\n");
+  TEST_ASSERT_STRING_CONTAINS(result,
+                              "  Source File: D:\\cs\\src\\media\\foo.cc\n"
+                              "  Source Line: 520\n"
+                              "  Source Context (current line starts with "
+                              "\">\"):\n"
+                              "     516: code516\n");
+  TEST_ASSERT_STRING_CONTAINS(result, "    >520: code520\n");
+  TEST_ASSERT_STRING_CONTAINS(result,
+                              "  Call Stack (top 5):\n"
+                              "    [0] chrome!media::Foo::Bar+0x10\n");
+  TEST_ASSERT_STRING_CONTAINS(result, "\n\nExtra Context:\n  Hint");
+}
+
+TEST(Format_WithoutSourceInformation) {
+  ExecutionContext context = MakeContext(520);
+  context.source_file.clear();
+  context.source_context.clear();
+  std::string result = execution_context::Format(context);
+
+  TEST_ASSERT(result.find("Source") == std::string::npos);
+  TEST_ASSERT_STRING_CONTAINS(result, "  Thread: 92\n  Call Stack (top 5):\n");
+}
+
+TEST(FormatDelta_Unchanged) {
+  ExecutionContext context = MakeContext(520);
+  TEST_ASSERT_EQUALS(
+      std::string(
+          "Current Execution Context: unchanged since the last response\n"),
+      execution_context::FormatDelta(context, context));
+}
+
+TEST(FormatDelta_NextLine) {
+  ExecutionContext previous = MakeContext(520);
+  ExecutionContext context = MakeContext(521);
+  std::string result = execution_context::FormatDelta(context, previous);
+
+  TEST_ASSERT_STRING_CONTAINS(
+      result,
+      "Current Execution Context (changes since the last response):\n"
+      "  Source Line: 521\n"
+      "  Source Context (new lines only, current line starts with \">\"):\n"
+      "    >521: code521\n"
+      "     526: code526\n");
+  TEST_ASSERT_STRING_CONTAINS(result,
+                              "  Unchanged: Process, Process Command Line, "
+                              "Thread, Source File, Call Stack\n");
+  TEST_ASSERT(result.find("code520") == std::string::npos);
+  TEST_ASSERT(result.find("Process Command Line: ") == std::string::npos);
+  TEST_ASSERT(result.size() < execution_context::Format(context).size() / 2);
+}
+
+TEST(FormatDelta_ThreadAndStackChanged) {
+  ExecutionContext previous = MakeContext(520);
+  ExecutionContext context = previous;
+  context.thread_id = 17;
+  context.call_stack[0] = "chrome!media::Foo::Other+0x4";
+  std::string result = execution_context::FormatDelta(context, previous);
+
+  TEST_ASSERT_STRING_CONTAINS(result, "  Thread: 17\n");
+  TEST_ASSERT_STRING_CONTAINS(result, "    [0] chrome!media::Foo::Other+0x4\n");
+  TEST_ASSERT_STRING_CONTAINS(
+      result,
+      "  Unchanged: Process, Process Command Line, Source File, Source Line, "
+      "Source Context\n");
+}
+
+TEST(FormatDelta_OtherFile) {
+  ExecutionContext previous = MakeContext(520);
+  ExecutionContext context = MakeContext(40);
+  context.source_file = "D:\\cs\\src\\base\\bar.cc";
+  std::string result = execution_context::FormatDelta(context, previous);
+
+  // The whole window is sent for a different file.
+  TEST_ASSERT_STRING_CONTAINS(result,
+                              "  Source File: D:\\cs\\src\\base\\bar.cc\n"
+                              "  Source Line: 40\n"
+                              "  Source Context (current line starts with "
+                              "\">\"):\n"
+                              "     36: code36\n");
+}
+
+TEST(FormatDelta_ProcessChanged) {
+  ExecutionContext previous = MakeContext(520);
+  ExecutionContext context = previous;
+  context.process_id = 7;
+  TEST_ASSERT_EQUALS(execution_context::Format(context),
+                     execution_context::FormatDelta(context, previous));
+}
+
+TEST(ContextCache_PerClient) {
+  ContextCache cache;
+  ExecutionContext context = MakeContext(520);
+
+  // The first response to each client is the full context.
+  std::string full = execution_context::Format(context);
+  TEST_ASSERT_EQUALS(full, cache.FormatForClient(1, context));
+  TEST_ASSERT_EQUALS(full, cache.FormatForClient(2, context));
+
+  ExecutionContext next = MakeContext(521);
+  std::string delta = cache.FormatForClient(1, next);
+  TEST_ASSERT_STRING_CONTAINS(delta, "changes since the last response");
+
+  ExecutionContext last;
+  TEST_ASSERT(cache.GetLastContext(1, last));
+  TEST_ASSERT_EQUALS(521, last.source_line);
+  TEST_ASSERT(cache.GetLastContext(2, last));
+  TEST_ASSERT_EQUALS(520, last.source_line);
+
+  // A full response can always be requested.
+  TEST_ASSERT_EQUALS(execution_context::Format(next),
+                     cache.FormatForClient(1, next, true));
+
+  // Removed clients start over with the full context.
+  cache.RemoveClient(2);
+  TEST_ASSERT(!cache.GetLastContext(2, last));
+  TEST_ASSERT_EQUALS(execution_context::Format(next),
+                     cache.FormatForClient(2, next));
+
+  ContextCacheStats stats = cache.GetStats();
+  TEST_ASSERT_EQUALS(4, stats.full_responses);
+  TEST_ASSERT_EQUALS(1, stats.delta_responses);
+  TEST_ASSERT_EQUALS(execution_context::Format(next).size(), stats.full_bytes);
+  TEST_ASSERT_EQUALS(delta.size(), stats.sent_bytes);
+}
+
+TEST(ContextCache_StepSequenceSavings) {
+  ContextCache cache;
+  cache.FormatForClient(1, MakeContext(100));
+  for (uint32_t line = 101; line <= 120; line++) {
+    cache.FormatForClient(1, MakeContext(line));
+  }
+
+  ContextCacheStats stats = cache.GetStats();
+  TEST_ASSERT_EQUALS(20, stats.delta_responses);
+  TEST_ASSERT(stats.sent_bytes * 2 < stats.full_bytes);
+}
+
+TEST(Capture_Fields) {
+  CaptureTest test;
+  ExecutionContext context = execution_context::Capture(&g_debug);
+
+  TEST_ASSERT_EQUALS(6, context.process_id);
+  TEST_ASSERT_EQUALS(92, context.thread_id);
+  TEST_ASSERT_EQUALS(std::string("chrome.exe --type=utility"),
+                     context.command_line);
+  TEST_ASSERT_EQUALS(std::string("D:\\cs\\src\\media\\foo.cc"),
+                     context.source_file);
+  TEST_ASSERT_EQUALS(520, context.source_line);
+  TEST_ASSERT_EQUALS(SourceWindow(520), context.source_context);
+  TEST_ASSERT_EQUALS(2, context.call_stack.size());
+  TEST_ASSERT_EQUALS(std::string("chrome!media::Foo::Bar"),
+                     context.call_stack[0]);
+  TEST_ASSERT(context.extra.empty());
+}
+
+// Capturing the context is done for every continuation command so
+// the number of engine calls (and their order) is part of its cost.
+TEST(Capture_CallBudget) {
+  CaptureTest test;
+  ExecutionContext first = execution_context::Capture(&g_debug);
+  TEST_ASSERT(test.GetEngineCallCount() <= 19);
+  TEST_ASSERT_EQUALS(3, test.executed.size());
+
+  // The command line is not read again in the same process
+  test.ClearCallHistory();
+  test.executed.clear();
+  execution_context::Capture(&g_debug, &first);
+  TEST_ASSERT(test.GetEngineCallCount() <= 15);
+  TEST_ASSERT_EQUALS(2, test.executed.size());
+
+  const std::vector<std::string> expected_sequence = {
+      "SystemObjects::GetCurrentProcessId",
+      "SystemObjects::GetCurrentThreadId",
+      "Symbols::GetScope",
+      "Symbols::GetLineByOffset",
+  };
+  std::vector<std::string> sequence;
+  for (const std::string& call : *test.call_sequence) {
+    if (call.rfind("SystemObjects::", 0) == 0 ||
+        call.rfind("Symbols::", 0) == 0) {
+      sequence.push_back(call);
+    }
+  }
+  TEST_ASSERT_EQUALS(5, sequence.size());
+  for (size_t i = 0; i < expected_sequence.size(); i++) {
+    TEST_ASSERT_EQUALS(expected_sequence[i], sequence[i]);
+  }
+  TEST_ASSERT_EQUALS(std::string("SystemObjects::GetNumberProcesses"),
+                     sequence.back());
+}
+
+TEST(Capture_VirtualLatency) {
+  CaptureTest test;
+  test.mock_control->SetMethodLatency("Execute", std::chrono::milliseconds(5));
+  test.mock_symbols->SetMethodLatency("GetLineByOffset",
+                                      std::chrono::milliseconds(2));
+
+  auto start = std::chrono::steady_clock::now();
+  ExecutionContext first = execution_context::Capture(&g_debug);
+  TEST_ASSERT_EQUALS(17000, test.GetVirtualTime().count());
+
+  test.ClearCallHistory();
+  execution_context::Capture(&g_debug, &first);
+  TEST_ASSERT_EQUALS(12000, test.GetVirtualTime().count());
+
+  // Virtual latency doesn't slow down the test
+  TEST_ASSERT(std::chrono::steady_clock::now() - start <
+              std::chrono::milliseconds(500));
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,267 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../src/expression_evaluator.h"
+#include "../src/utils.h"
+#include "debug_interfaces_test_base.h"
+#include "unit_test_runner.h"
+
+utils::DebugInterfaces g_debug;
+
+using expression_evaluator::EvaluateExpression;
+using expression_evaluator::EvaluationResult;
+using expression_evaluator::ExpressionSyntax;
+
+class ExpressionEvaluatorTest : public DebugInterfacesTestBase {
+ public:
+  // Values returned by the mock Evaluate keyed by expression
+  std::map<std::string, DEBUG_VALUE> values;
+
+  // Output of the mock dx command keyed by expression
+  std::map<std::string, std::string> dx_output;
+
+  std::vector<std::string> evaluated;
+  std::vector<std::string> executed;
+
+  ExpressionEvaluatorTest() : DebugInterfacesTestBase(g_debug) {
+    mock_control->SetMethodOverride(
+        "Evaluate", [this](PCSTR expression, ULONG desired_type,
+                           PDEBUG_VALUE value, PULONG remainder) -> HRESULT {
+          evaluated.push_back(expression);
+          auto it = values.find(expression);
+          if (it == values.end()) {
+            return E_FAIL;
+          }
+          *value = it->second;
+          if (remainder) {
+            *remainder = static_cast<ULONG>(strlen(expression));
+          }
+          return S_OK;
+        });
+
+    // Route the output of Execute to the capture callbacks
+    // which utils::ExecuteCommand installs.
+    mock_client->SetMethodOverride(
+        "GetOutputCallbacks",
+        [](PDEBUG_OUTPUT_CALLBACKS* callbacks) -> HRESULT {
+          *callbacks = nullptr;
+          return S_OK;
+        });
+    mock_client->SetMethodOverride(
+        "SetOutputCallbacks",
+        [this](PDEBUG_OUTPUT_CALLBACKS callbacks) -> HRESULT {
+          output_callbacks_ = callbacks;
+          return S_OK;
+        });
+    mock_control->SetMethodOverride(
+        "Execute",
+        [this](ULONG output_control, PCSTR command, ULONG flags) -> HRESULT {
+          executed.push_back(command);
+          std::string text = command;
+          auto it = dx_output.find(text.substr(3));
+          std::string output = (it != dx_output.end())
+                                   ? it->second
+                                   : "Error: Unable to bind name 'x'\n";
+          if (output_callbacks_) {
+            output_callbacks_->Output(DEBUG_OUTPUT_NORMAL, output.c_str());
+          }
+          return S_OK;
+        });
+  }
+
+  static DEBUG_VALUE Int64(ULONG64 number) {
+    DEBUG_VALUE value = {};
+    value.Type = DEBUG_VALUE_INT64;
+    value.I64 = number;
+    return value;
+  }
+
+ private:
+  PDEBUG_OUTPUT_CALLBACKS output_callbacks_ = nullptr;
+};
+
+DECLARE_TEST_RUNNER()
+
+TEST(Evaluate_MasmIntegerValue) {
+  ExpressionEvaluatorTest test;
+  test.values["poi(rcx+8)"] = ExpressionEvaluatorTest::Int64(0x1234);
+
+  EvaluationResult result =
+      EvaluateExpression(&g_debug, "poi(rcx+8)", ExpressionSyntax::kAuto);
+  TEST_ASSERT(result.success);
+  TEST_ASSERT_EQUALS(std::string("masm"), result.source);
+  TEST_ASSERT_EQUALS(std::string("int64"), result.type);
+  TEST_ASSERT_EQUALS(std::string("0x1234"), result.value);
+  TEST_ASSERT_EQUALS(std::string("4660"), result.decimal);
+
+  // The data model is not used if Evaluate succeeds
+  TEST_ASSERT_EQUALS(0, test.executed.size());
+}
+
+TEST(Evaluate_NegativeAndSmallIntegers) {
+  ExpressionEvaluatorTest test;
+  test.values["-1"] = ExpressionEvaluatorTest::Int64(~0ULL);
+
+  DEBUG_VALUE byte_value = {};
+  byte_value.Type = DEBUG_VALUE_INT8;
+  byte_value.I8 = 0xFF;
+  test.values["by(rsp)"] = byte_value;
+
+  EvaluationResult result =
+      EvaluateExpression(&g_debug, "-1", ExpressionSyntax::kMasm);
+  TEST_ASSERT_EQUALS(std::string("0xffffffffffffffff"), result.value);
+  TEST_ASSERT_EQUALS(std::string("-1"), result.decimal);
+
+  result = EvaluateExpression(&g_debug, "by(rsp)", ExpressionSyntax::kMasm);
+  TEST_ASSERT_EQUALS(std::string("int8"), result.type);
+  TEST_ASSERT_EQUALS(std::string("0xff"), result.value);
+  TEST_ASSERT_EQUALS(std::string("-1"), result.decimal);
+}
+
+TEST(Evaluate_FloatValue) {
+  ExpressionEvaluatorTest test;
+  DEBUG_VALUE value = {};
+  value.Type = DEBUG_VALUE_FLOAT64;
+  value.F64 = 2.5;
+  test.values["@@c++(this->ratio_)"] = value;
+
+  EvaluationResult result =
+      EvaluateExpression(&g_debug, "this->ratio_", ExpressionSyntax::kCpp);
+  TEST_ASSERT(result.success);
+  TEST_ASSERT_EQUALS(std::string("c++"), result.source);
+  TEST_ASSERT_EQUALS(std::string("float64"), result.type);
+  TEST_ASSERT_EQUALS(std::string("2.5"), result.value);
+  TEST_ASSERT(result.decimal.empty());
+}
+
+TEST(Evaluate_AutoFallsBackToCppAndThenDx) {
+  ExpressionEvaluatorTest test;
+  test.values["@@c++(this->size_)"] = ExpressionEvaluatorTest::Int64(5);
+  test.dx_output["this->items_"] =
+      "this->items_                 : { size=2 } [Type: std::vector<int>]\n"
+      "    [0]              : 1 [Type: int]\n";
+
+  EvaluationResult result =
+      EvaluateExpression(&g_debug, "this->size_", ExpressionSyntax::kAuto);
+  TEST_ASSERT(result.success);
+  TEST_ASSERT_EQUALS(std::string("c++"), result.source);
+  TEST_ASSERT_EQUALS(std::string("0x5"), result.value);
+
+  result =
+      EvaluateExpression(&g_debug, "this->items_", ExpressionSyntax::kAuto);
+  TEST_ASSERT(result.success);
+  TEST_ASSERT_EQUALS(std::string("dx"), result.source);
+  TEST_ASSERT_EQUALS(std::string("std::vector<int>"), result.type);
+  TEST_ASSERT_EQUALS(std::string("{ size=2 }"), result.value);
+  TEST_ASSERT_EQUALS(1, test.executed.size());
+  TEST_ASSERT_EQUALS(std::string("dx this->items_"), test.executed[0]);
+}
+
+TEST(Evaluate_DxPrefixSkipsEvaluate) {
+  ExpressionEvaluatorTest test;
+  test.dx_output["@$curprocess.Name"] =
+      "@$curprocess.Name : chrome.exe\n";
+
+  EvaluationResult result = EvaluateExpression(
+      &g_debug, "dx @$curprocess.Name", ExpressionSyntax::kAuto);
+  TEST_ASSERT(result.success);
+  TEST_ASSERT_EQUALS(std::string("chrome.exe"), result.value);
+  TEST_ASSERT(result.type.empty());
+  TEST_ASSERT_EQUALS(0, test.evaluated.size());
+}
+
+TEST(Evaluate_ErrorsAreReported) {
+  ExpressionEvaluatorTest test;
+
+  EvaluationResult result =
+      EvaluateExpression(&g_debug, "missing", ExpressionSyntax::kAuto);
+  TEST_ASSERT(!result.success);
+  TEST_ASSERT_STRING_CONTAINS(result.error, "Unable to evaluate expression");
+  TEST_ASSERT_STRING_CONTAINS(result.error, "Unable to bind name");
+
+  // An explicit syntax does not fall back to dx
+  test.executed.clear();
+  result = EvaluateExpression(&g_debug, "missing", ExpressionSyntax::kMasm);
+  TEST_ASSERT(!result.success);
+  TEST_ASSERT_EQUALS(0, test.executed.size());
+
+  result = EvaluateExpression(&g_debug, "   ", ExpressionSyntax::kAuto);
+  TEST_ASSERT(!result.success);
+  TEST_ASSERT_STRING_CONTAINS(result.error, "Empty expression");
+}
+
+TEST(Evaluate_DxRejectsMultipleCommands) {
+  ExpressionEvaluatorTest test;
+
+  EvaluationResult result =
+      EvaluateExpression(&g_debug, "x; g", ExpressionSyntax::kAuto);
+  TEST_ASSERT(!result.success);
+  TEST_ASSERT_STRING_CONTAINS(result.error, "can't contain ';'");
+
+  result = EvaluateExpression(&g_debug, "x\n.kill", ExpressionSyntax::kDx);
+  TEST_ASSERT(!result.success);
+  TEST_ASSERT_STRING_CONTAINS(result.error, "line breaks");
+  TEST_ASSERT_EQUALS(0, test.executed.size());
+}
+
+TEST(Evaluate_TrailingTextIsAnError) {
+  ExpressionEvaluatorTest test;
+  test.mock_control->SetMethodOverride(
+      "Evaluate", [](PCSTR expression, ULONG desired_type, PDEBUG_VALUE value,
+                     PULONG remainder) -> HRESULT {
+        // Only "foo" of "foo bar" is consumed
+        *value = ExpressionEvaluatorTest::Int64(1);
+        *remainder = 3;
+        return S_OK;
+      });
+
+  EvaluationResult result =
+      EvaluateExpression(&g_debug, "foo bar", ExpressionSyntax::kMasm);
+  TEST_ASSERT(!result.success);
+  TEST_ASSERT_STRING_CONTAINS(result.error, "Unexpected text");
+}
+
+TEST(ParseDxOutput_Formats) {
+  EvaluationResult result;
+  TEST_ASSERT(expression_evaluator::ParseDxOutput(
+      "this->size_      : 0x5 [Type: unsigned __int64]\n", result));
+  TEST_ASSERT_EQUALS(std::string("0x5"), result.value);
+  TEST_ASSERT_EQUALS(std::string("unsigned __int64"), result.type);
+
+  // Objects display their members on the following lines
+  result = EvaluationResult();
+  TEST_ASSERT(expression_evaluator::ParseDxOutput(
+      "config                 [Type: media::CdmConfig]\n"
+      "    [+0x000] key_system_      : \"org.w3.clearkey\"\n",
+      result));
+  TEST_ASSERT_EQUALS(std::string("media::CdmConfig"), result.type);
+  TEST_ASSERT_STRING_CONTAINS(result.value, "key_system_");
+
+  result = EvaluationResult();
+  TEST_ASSERT(!expression_evaluator::ParseDxOutput(
+      "Error: Unable to bind name 'foo'\n", result));
+  TEST_ASSERT_EQUALS(std::string("Unable to bind name 'foo'"), result.error);
+
+  result = EvaluationResult();
+  TEST_ASSERT(!expression_evaluator::ParseDxOutput("", result));
+}
+
+TEST(ParseExpressionSyntax_Names) {
+  ExpressionSyntax syntax = ExpressionSyntax::kMasm;
+  TEST_ASSERT(expression_evaluator::ParseExpressionSyntax("", syntax));
+  TEST_ASSERT(syntax == ExpressionSyntax::kAuto);
+  TEST_ASSERT(expression_evaluator::ParseExpressionSyntax("c++", syntax));
+  TEST_ASSERT(syntax == ExpressionSyntax::kCpp);
+  TEST_ASSERT(expression_evaluator::ParseExpressionSyntax("dx", syntax));
+  TEST_ASSERT(syntax == ExpressionSyntax::kDx);
+  TEST_ASSERT(!expression_evaluator::ParseExpressionSyntax("python", syntax));
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,120 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <string>
+
+#include "../src/json_writer.h"
+#include "unit_test_runner.h"
+
+namespace {
+
+std::string Write(const JSON& value) {
+  std::string output;
+  json_writer::AppendJson(output, value);
+  return output;
+}
+
+std::string WriteString(const std::string& text) {
+  std::string output;
+  json_writer::AppendString(output, text);
+  return output;
+}
+
+}  // namespace
+
+DECLARE_TEST_RUNNER()
+
+TEST(AppendJson_SameAsDump) {
+  JSON values[] = {
+      nullptr,
+      true,
+      -42,
+      18446744073709551615ull,
+      0.5,
+      1e100,
+      "text",
+      JSON::array(),
+      JSON::object(),
+      {{"jsonrpc", "2.0"},
+       {"id", 7},
+       {"result",
+        {{"content", JSON::array({{{"type", "text"}, {"text", "k\n"}}})},
+         {"isError", false}}}},
+      {{"nested", {{"a", JSON::array({1, 2.25, nullptr, "b"})}}},
+       {"key \"quoted\"", "value"}},
+  };
+
+  for (const JSON& value : values) {
+    TEST_ASSERT_EQUALS(value.dump(), Write(value));
+  }
+}
+
+TEST(AppendString_EscapesLikeDump) {
+  // Every character below 0x80 at every position of a 16 byte block.
+  std::string ascii;
+  for (int c = 0; c < 0x80; c++) {
+    ascii += static_cast<char>(c);
+  }
+  for (size_t offset = 0; offset < 17; offset++) {
+    std::string text = std::string(offset, 'a') + ascii;
+    TEST_ASSERT_EQUALS(JSON(text).dump(), WriteString(text));
+  }
+
+  // Long runs which don't need escaping, with a tail which isn't a
+  // multiple of 16 bytes.
+  std::string path = "D:\\cs\\src\\out\\Default\\chrome.dll.pdb\n";
+  std::string long_text;
+  for (int i = 0; i < 1000; i++) {
+    long_text += std::string(i % 37, 'x') + path;
+  }
+  TEST_ASSERT_EQUALS(JSON(long_text).dump(), WriteString(long_text));
+}
+
+TEST(AppendString_Utf8) {
+  // Valid sequences of 2, 3 and 4 bytes are copied as is.
+  std::string text = "caf\xC3\xA9 \xE2\x82\xAC \xF0\x9F\x98\x80 end";
+  TEST_ASSERT_EQUALS(JSON(text).dump(), WriteString(text));
+  TEST_ASSERT_EQUALS(JSON(text + text + text).dump(),
+                     WriteString(text + text + text));
+
+  // Invalid bytes are replaced with U+FFFD: a lone continuation byte,
+  // an overlong encoding, a surrogate, a truncated sequence at the end.
+  const std::string kReplacement = "\xEF\xBF\xBD";
+  TEST_ASSERT_EQUALS("\"a" + kReplacement + "b\"", WriteString("a\x80" "b"));
+  TEST_ASSERT_EQUALS("\"" + kReplacement + kReplacement + "\"",
+                     WriteString("\xC0\xAF"));
+  TEST_ASSERT_EQUALS("\"" + kReplacement + kReplacement + kReplacement + "\"",
+                     WriteString("\xED\xA0\x80"));
+  TEST_ASSERT_EQUALS("\"abc" + kReplacement + kReplacement + "\"",
+                     WriteString("abc\xE2\x82"));
+
+  // The output is always valid JSON.
+  std::string binary;
+  for (int i = 0; i < 256; i++) {
+    binary += static_cast<char>(i);
+  }
+  JSON parsed = JSON::parse(WriteString(binary + binary));
+  TEST_ASSERT(parsed.is_string());
+}
+
+TEST(AppendJson_AppendsToOutput) {
+  std::string output = "prefix ";
+  json_writer::AppendJson(output, {{"a", 1}});
+  json_writer::AppendJson(output, JSON::array({"b"}));
+  TEST_ASSERT_EQUALS(std::string("prefix {\"a\":1}[\"b\"]"), output);
+}
+
+TEST(AppendJson_Raw) {
+  JSON response = {{"id", 1},
+                   {"result", json_writer::MakeRaw("{\"tools\":[]}")}};
+  TEST_ASSERT_EQUALS(std::string("{\"id\":1,\"result\":{\"tools\":[]}}"),
+                     Write(response));
+
+  // Other binary values are written like dump() writes them.
+  JSON binary = JSON::binary({1, 2}, 7);
+  TEST_ASSERT_EQUALS(binary.dump(), Write(binary));
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
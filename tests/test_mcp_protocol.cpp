@@ -0,0 +1,209 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../src/mcp_protocol.h"
+#include "../src/utils.h"
+#include "unit_test_runner.h"
+
+utils::DebugInterfaces g_debug;
+
+using mcp_protocol::MessageFramer;
+using mcp_protocol::Request;
+
+namespace {
+
+void Append(MessageFramer& framer, const std::string& data) {
+  framer.Append(data.data(), data.size());
+}
+
+std::vector<std::string> ReadAll(MessageFramer& framer) {
+  std::vector<std::string> messages;
+  std::string message;
+  while (framer.Next(message)) {
+    messages.push_back(message);
+  }
+  return messages;
+}
+
+}  // namespace
+
+DECLARE_TEST_RUNNER()
+
+TEST(MessageFramer_Pipelined) {
+  MessageFramer framer;
+  Append(framer, "{\"id\":1}\n{\"id\":2}\n{\"id\":");
+
+  std::vector<std::string> messages = ReadAll(framer);
+  TEST_ASSERT_EQUALS(2, messages.size());
+  TEST_ASSERT_EQUALS(std::string("{\"id\":1}"), messages[0]);
+  TEST_ASSERT_EQUALS(std::string("{\"id\":2}"), messages[1]);
+  TEST_ASSERT_EQUALS(6, framer.GetBufferedSize());
+
+  Append(framer, "3}\n");
+  messages = ReadAll(framer);
+  TEST_ASSERT_EQUALS(1, messages.size());
+  TEST_ASSERT_EQUALS(std::string("{\"id\":3}"), messages[0]);
+  TEST_ASSERT_EQUALS(0, framer.GetBufferedSize());
+}
+
+TEST(MessageFramer_SplitAcrossReceives) {
+  MessageFramer framer;
+  std::string request =
+      "{\"jsonrpc\":\"2.0\",\"id\":7,\"method\":\"tools/list\"}\n";
+  for (char c : request) {
+    framer.Append(&c, 1);
+  }
+
+  std::vector<std::string> messages = ReadAll(framer);
+  TEST_ASSERT_EQUALS(1, messages.size());
+  TEST_ASSERT_EQUALS(request.substr(0, request.size() - 1), messages[0]);
+
+  // Empty lines are empty messages
+  Append(framer, "\n");
+  messages = ReadAll(framer);
+  TEST_ASSERT_EQUALS(1, messages.size());
+  TEST_ASSERT(messages[0].empty());
+}
+
+TEST(DecodeRequest_ToolsCall) {
+  Request request = mcp_protocol::DecodeRequest(
+      "{\"jsonrpc\":\"2.0\",\"id\":\"a1\",\"method\":\"tools/call\","
+      "\"params\":{\"name\":\"symbolize\",\"_meta\":{\"progressToken\":5},"
+      "\"arguments\":{\"addresses\":[\"@rip\",\"0x10\"],\"limit\":2,"
+      "\"options\":{\"deep\":[true,null,{\"x\":1.5}]}}},\"extra\":[[1],{}]}");
+
+  TEST_ASSERT_EQUALS(std::string("a1"), request.id);
+  TEST_ASSERT_EQUALS(std::string("tools/call"), request.method);
+  TEST_ASSERT_EQUALS(std::string("symbolize"), request.tool_name);
+  TEST_ASSERT_EQUALS(
+      JSON::parse("{\"addresses\":[\"@rip\",\"0x10\"],\"limit\":2,"
+                  "\"options\":{\"deep\":[true,null,{\"x\":1.5}]}}"),
+      request.arguments);
+
+  // The arguments are taken out of params.
+  TEST_ASSERT_EQUALS(
+      JSON::parse("{\"name\":\"symbolize\",\"_meta\":{\"progressToken\":5}}"),
+      request.params);
+}
+
+TEST(DecodeRequest_SameAsDom) {
+  const char* messages[] = {
+      "{\"jsonrpc\":\"2.0\",\"id\":1,\"method\":\"tools/list\"}",
+      "{\"method\":\"initialized\",\"jsonrpc\":\"2.0\"}",
+      "{\"params\":{\"arguments\":{\"command\":\"k\"},\"name\":\"executeCommand\"},"
+      "\"id\":null,\"method\":\"tools/call\"}",
+      "{\"id\":18446744073709551615,\"method\":\"tools/call\","
+      "\"params\":{\"name\":7,\"arguments\":{}}}",
+  };
+
+  for (const char* message : messages) {
+    Request request = mcp_protocol::DecodeRequest(message);
+    Request expected = mcp_protocol::RequestFromJson(JSON::parse(message));
+      TEST_ASSERT_EQUALS(expected.id, request.id);
+    TEST_ASSERT_EQUALS(expected.method, request.method);
+    TEST_ASSERT_EQUALS(expected.params, request.params);
+    TEST_ASSERT_EQUALS(expected.tool_name, request.tool_name);
+    TEST_ASSERT_EQUALS(expected.arguments, request.arguments);
+  }
+}
+
+TEST(DecodeRequest_FallsBackToDom) {
+  // Arguments which aren't an object stay in params.
+  Request request = mcp_protocol::DecodeRequest(
+      "{\"id\":2,\"method\":\"tools/call\",\"params\":{\"name\":\"evaluate\","
+      "\"arguments\":\"1+1\"}}");
+  TEST_ASSERT_EQUALS(2, request.id.get<int>());
+  TEST_ASSERT_EQUALS(std::string("evaluate"), request.tool_name);
+  TEST_ASSERT_EQUALS(std::string("1+1"), request.params["arguments"]);
+  TEST_ASSERT(request.arguments.empty());
+
+  // Object ids, params which aren't an object and messages which
+  // aren't an object.
+  request = mcp_protocol::DecodeRequest("{\"id\":{\"a\":1},\"method\":\"x\"}");
+  TEST_ASSERT_EQUALS(1, request.id["a"].get<int>());
+
+  request = mcp_protocol::DecodeRequest("{\"method\":\"x\",\"params\":[1]}");
+  TEST_ASSERT_EQUALS(JSON::array({1}), request.params);
+
+  request = mcp_protocol::DecodeRequest("[{\"method\":\"x\"}]");
+  TEST_ASSERT(request.method.empty());
+
+  // Invalid JSON throws the parse error of JSON::parse.
+  bool thrown = false;
+  try {
+    mcp_protocol::DecodeRequest("{\"id\":1,\"method\":");
+  } catch (const JSON::parse_error&) {
+    thrown = true;
+  }
+  TEST_ASSERT(thrown);
+}
+
+TEST(ProcessMessage_Responses) {
+  auto handler = [](const Request& request) {
+    return mcp_protocol::CreateResponse(request.id,
+                                        {{"method", request.method}});
+  };
+
+  std::string response = mcp_protocol::ProcessMessage(
+      "{\"jsonrpc\":\"2.0\",\"id\":3,\"method\":\"ping\"}", handler);
+  TEST_ASSERT_EQUALS('\n', response.back());
+  JSON json = JSON::parse(response);
+  TEST_ASSERT_EQUALS(3, json["id"].get<int>());
+  TEST_ASSERT_EQUALS(std::string("ping"), json["result"]["method"]);
+
+  json = JSON::parse(mcp_protocol::ProcessMessage("{\"id\":", handler));
+  TEST_ASSERT_EQUALS(mcp_protocol::kParseError,
+                     json["error"]["code"].get<int>());
+  TEST_ASSERT_STRING_CONTAINS(json["error"]["message"].get<std::string>(),
+                              "Parse error: ");
+}
+
+TEST(ProcessMessage_AppendsToOutput) {
+  auto handler = [](const Request& request) {
+    if (request.method == "fail") {
+      throw std::runtime_error("handler error");
+    }
+    return mcp_protocol::CreateResponse(
+        request.id, mcp_protocol::CreateToolResult("a\tb"));
+  };
+
+  std::string output;
+  mcp_protocol::ProcessMessage("{\"id\":1,\"method\":\"run\"}", handler,
+                               output);
+  TEST_ASSERT_EQUALS(
+      std::string("{\"id\":1,\"jsonrpc\":\"2.0\",\"result\":{\"content\":"
+                  "[{\"text\":\"a\\tb\",\"type\":\"text\"}]}}\n"),
+      output);
+
+  // A handler which throws leaves only the error response.
+  size_t first_size = output.size();
+  mcp_protocol::ProcessMessage("{\"id\":2,\"method\":\"fail\"}", handler,
+                               output);
+  JSON json = JSON::parse(output.substr(first_size));
+  TEST_ASSERT_EQUALS(mcp_protocol::kParseError,
+                     json["error"]["code"].get<int>());
+  TEST_ASSERT_STRING_CONTAINS(json["error"]["message"].get<std::string>(),
+                              "handler error");
+}
+
+TEST(CreateToolResult_TextAndError) {
+  JSON result = mcp_protocol::CreateToolResult("output");
+  TEST_ASSERT_EQUALS(std::string("output"), result["content"][0]["text"]);
+  TEST_ASSERT(!result.contains("isError"));
+
+  result = mcp_protocol::CreateToolResult(JSON{{"error", "Invalid address"}});
+  TEST_ASSERT_EQUALS(std::string("Error: Invalid address"),
+                     result["content"][0]["text"]);
+  TEST_ASSERT(result["isError"].get<bool>());
+
+  JSON error = mcp_protocol::CreateError(nullptr, -32601, "Method not found");
+  TEST_ASSERT(!error.contains("id"));
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,179 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "../src/mcp_protocol.h"
+#include "../src/mcp_transport.h"
+#include "mcp_test_client.h"
+#include "unit_test_runner.h"
+
+using mcp_protocol::Request;
+using mcp_transport::ClientId;
+using mcp_transport::SocketServer;
+
+namespace {
+
+// Echoes the method and params of each request.
+JSON EchoRequest(const Request& request, ClientId) {
+  return mcp_protocol::CreateResponse(
+      request.id, {{"method", request.method}, {"params", request.params}});
+}
+
+std::string MakeRequest(int id, const std::string& method) {
+  return JSON{{"jsonrpc", "2.0"}, {"id", id}, {"method", method}}.dump() +
+         "\n";
+}
+
+bool WaitFor(const std::function<bool()>& condition) {
+  for (int i = 0; i < 200 && !condition(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return condition();
+}
+
+}  // namespace
+
+DECLARE_TEST_RUNNER()
+
+TEST(SocketServer_PipelinedRequests) {
+  SocketServer server;
+  TEST_ASSERT(server.Start(0, EchoRequest));
+  TEST_ASSERT(server.GetPort() > 0);
+
+  McpTestClient client;
+  TEST_ASSERT(client.Connect("127.0.0.1", server.GetPort()));
+
+  // Three requests in one write, the last one split in two.
+  std::string third = MakeRequest(3, "tools/call");
+  TEST_ASSERT(client.Send(MakeRequest(1, "initialize") +
+                          MakeRequest(2, "tools/list") + third.substr(0, 10)));
+  TEST_ASSERT(client.Send(third.substr(10)));
+
+  std::string message;
+  for (int id = 1; id <= 3; id++) {
+    TEST_ASSERT(client.Receive(message));
+    JSON response = JSON::parse(message);
+    TEST_ASSERT_EQUALS(id, response["id"].get<int>());
+  }
+
+  // Invalid messages get a parse error and don't close the connection.
+  TEST_ASSERT(client.Send("{\"id\":\n" + MakeRequest(4, "ping")));
+  TEST_ASSERT(client.Receive(message));
+  TEST_ASSERT_EQUALS(mcp_protocol::kParseError,
+                     JSON::parse(message)["error"]["code"].get<int>());
+  TEST_ASSERT(client.Receive(message));
+  TEST_ASSERT_EQUALS(4, JSON::parse(message)["id"].get<int>());
+
+  server.Stop();
+}
+
+TEST(SocketServer_SendAndDisconnect) {
+  std::atomic<int> disconnects{0};
+  SocketServer server;
+
+  // A notification is sent before the response of each request.
+  auto handler = [&server](const Request& request, ClientId client) {
+    server.Send(client, mcp_protocol::CreateNotification(
+                            "notifications/progress", {{"progress", 1}})
+                                .dump() +
+                            "\n");
+    return EchoRequest(request, client);
+  };
+  TEST_ASSERT(server.Start(0, handler, [&](ClientId) { disconnects++; }));
+
+  {
+    McpTestClient client;
+    TEST_ASSERT(client.Connect("127.0.0.1", server.GetPort()));
+    TEST_ASSERT(client.Send(MakeRequest(1, "tools/call")));
+
+    std::string message;
+    TEST_ASSERT(client.Receive(message));
+    TEST_ASSERT_EQUALS(std::string("notifications/progress"),
+                       JSON::parse(message)["method"]);
+    TEST_ASSERT(client.Receive(message));
+    TEST_ASSERT_EQUALS(1, JSON::parse(message)["id"].get<int>());
+    TEST_ASSERT_EQUALS(1, server.GetClientCount());
+  }
+
+  TEST_ASSERT(WaitFor([&]() { return disconnects == 1; }));
+  TEST_ASSERT_EQUALS(0, server.GetClientCount());
+  server.Stop();
+}
+
+TEST(SocketServer_Broadcast) {
+  SocketServer server;
+  TEST_ASSERT(server.Start(0, EchoRequest));
+
+  McpTestClient first;
+  McpTestClient second;
+  TEST_ASSERT(first.Connect("127.0.0.1", server.GetPort()));
+  TEST_ASSERT(second.Connect("127.0.0.1", server.GetPort()));
+  TEST_ASSERT(WaitFor([&]() { return server.GetClientCount() == 2; }));
+
+  // Broadcasts from another thread while the first client's responses
+  // are written. Every message must arrive whole.
+  const std::string notification =
+      mcp_protocol::CreateNotification("notifications/tools/list_changed",
+                                       JSON::object())
+          .dump() +
+      "\n";
+  constexpr int kCount = 200;
+  std::thread broadcaster([&]() {
+    for (int i = 0; i < kCount; i++) {
+      server.Broadcast(notification);
+    }
+  });
+  std::string requests;
+  for (int id = 1; id <= kCount; id++) {
+    requests += MakeRequest(id, "tools/list");
+  }
+  TEST_ASSERT(first.Send(requests));
+  broadcaster.join();
+
+  int responses = 0;
+  int notifications = 0;
+  std::string message;
+  while (responses + notifications < 2 * kCount && first.Receive(message)) {
+    JSON json = JSON::parse(message);
+    if (json.contains("id")) {
+      TEST_ASSERT_EQUALS(++responses, json["id"].get<int>());
+    } else {
+      notifications++;
+    }
+  }
+  TEST_ASSERT_EQUALS(kCount, responses);
+  TEST_ASSERT_EQUALS(kCount, notifications);
+
+  for (int i = 0; i < kCount; i++) {
+    TEST_ASSERT(second.Receive(message));
+    TEST_ASSERT_EQUALS(std::string("notifications/tools/list_changed"),
+                       JSON::parse(message)["method"]);
+  }
+
+  server.Stop();
+  TEST_ASSERT_EQUALS(0, server.Broadcast(notification));
+}
+
+TEST(SocketServer_StopClosesClients) {
+  SocketServer server;
+  TEST_ASSERT(server.Start(0, EchoRequest));
+
+  McpTestClient client;
+  TEST_ASSERT(client.Connect("127.0.0.1", server.GetPort()));
+  TEST_ASSERT(WaitFor([&]() { return server.GetClientCount() == 1; }));
+
+  server.Stop();
+  TEST_ASSERT(!server.IsRunning());
+  TEST_ASSERT_EQUALS(0, server.GetClientCount());
+
+  std::string message;
+  TEST_ASSERT(!client.Receive(message));
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,271 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../src/memory_dump.h"
+#include "../src/utils.h"
+#include "debug_interfaces_test_base.h"
+#include "mocks/fake_target_memory.h"
+#include "unit_test_runner.h"
+
+utils::DebugInterfaces g_debug;
+
+class MemoryDumpTest : public DebugInterfacesTestBase {
+ public:
+  FakeTargetMemory memory;
+  std::string file_path;
+
+  MemoryDumpTest() : DebugInterfacesTestBase(g_debug) {
+    memory.Install(mock_data_spaces);
+    file_path =
+        (std::filesystem::temp_directory_path() / "test_memory_dump.bin")
+            .string();
+    std::filesystem::remove(file_path);
+  }
+
+  ~MemoryDumpTest() { std::filesystem::remove(file_path); }
+
+  // Fill the region with a byte pattern which depends on the address.
+  void AddPatternRegion(ULONG64 base, size_t size) {
+    std::vector<BYTE> data(size);
+    for (size_t i = 0; i < size; i++) {
+      data[i] = static_cast<BYTE>(((base + i) * 31) >> 3);
+    }
+    memory.AddRegion(base, data);
+  }
+
+  std::vector<BYTE> ReadFile() {
+    std::ifstream file(file_path, std::ios::binary);
+    return std::vector<BYTE>(std::istreambuf_iterator<char>(file),
+                             std::istreambuf_iterator<char>());
+  }
+
+  std::vector<BYTE> ReadTarget(ULONG64 address, ULONG size) {
+    std::vector<BYTE> data(size);
+    ULONG bytes_read = 0;
+    memory.Read(address, data.data(), size, &bytes_read);
+    data.resize(bytes_read);
+    return data;
+  }
+};
+
+DECLARE_TEST_RUNNER()
+
+namespace {
+
+std::string Sha256Hex(const std::string& text) {
+  memory_dump::Sha256 sha256;
+  sha256.Update(reinterpret_cast<const BYTE*>(text.data()), text.size());
+  return sha256.FinalHex();
+}
+
+std::string Sha256Hex(const std::vector<BYTE>& data) {
+  memory_dump::Sha256 sha256;
+  sha256.Update(data.data(), data.size());
+  return sha256.FinalHex();
+}
+
+}  // namespace
+
+//
+// Sha256 tests
+//
+
+TEST(Sha256_KnownDigests) {
+  TEST_ASSERT_EQUALS(
+      std::string(
+          "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855"),
+      Sha256Hex(""));
+  TEST_ASSERT_EQUALS(
+      std::string(
+          "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad"),
+      Sha256Hex("abc"));
+
+  // 56 bytes so the length does not fit in the first padding block
+  TEST_ASSERT_EQUALS(
+      std::string(
+          "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1"),
+      Sha256Hex("abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq"));
+}
+
+TEST(Sha256_IncrementalUpdatesMatchSingleUpdate) {
+  std::vector<BYTE> data(1000);
+  for (size_t i = 0; i < data.size(); i++) {
+    data[i] = static_cast<BYTE>(i * 7);
+  }
+
+  memory_dump::Sha256 sha256;
+  size_t offset = 0;
+  for (size_t size : {1, 63, 64, 65, 3, 200, 604}) {
+    sha256.Update(data.data() + offset, size);
+    offset += size;
+  }
+  TEST_ASSERT_EQUALS(1000, offset);
+  TEST_ASSERT_EQUALS(Sha256Hex(data), sha256.FinalHex());
+}
+
+//
+// MemoryDumper tests
+//
+
+TEST(Dump_WritesRangeToFile) {
+  MemoryDumpTest test;
+  test.AddPatternRegion(0x10000, 0x5000);
+
+  memory_dump::DumpOptions options;
+  options.address = 0x10100;
+  options.size = 0x4000;
+  options.file_path = test.file_path;
+  options.chunk_size = 0x1000;
+  options.hash = true;
+
+  memory_dump::MemoryDumper dumper(&g_debug);
+  memory_dump::DumpResult result = dumper.Dump(options);
+
+  TEST_ASSERT(result.success);
+  TEST_ASSERT(result.complete);
+  TEST_ASSERT_EQUALS(0x4000ULL, result.bytes_written);
+  TEST_ASSERT_EQUALS(0x4000ULL, result.next_offset);
+  TEST_ASSERT_EQUALS(0ULL, result.unreadable_bytes);
+
+  std::vector<BYTE> expected = test.ReadTarget(0x10100, 0x4000);
+  TEST_ASSERT(test.ReadFile() == expected);
+  TEST_ASSERT_EQUALS(Sha256Hex(expected), result.sha256);
+}
+
+TEST(Dump_UnreadablePagesAreZeroFilled) {
+  MemoryDumpTest test;
+  test.AddPatternRegion(0x10000, 0x1000);
+  test.memory.AddZeroRegion(0x11000, 0x2000, PAGE_NOACCESS);
+  test.AddPatternRegion(0x13000, 0x1000);
+  // 0x14000 - 0x16000 is not mapped
+  test.AddPatternRegion(0x16000, 0x1000);
+
+  memory_dump::DumpOptions options;
+  options.address = 0x10800;
+  options.size = 0x6000;
+  options.file_path = test.file_path;
+
+  memory_dump::MemoryDumper dumper(&g_debug);
+  memory_dump::DumpResult result = dumper.Dump(options);
+
+  TEST_ASSERT(result.success);
+  TEST_ASSERT(result.complete);
+  TEST_ASSERT_EQUALS(0x4000ULL, result.unreadable_bytes);
+
+  std::vector<BYTE> file = test.ReadFile();
+  TEST_ASSERT_EQUALS(0x6000, file.size());
+
+  std::vector<BYTE> first = test.ReadTarget(0x10800, 0x800);
+  std::vector<BYTE> second = test.ReadTarget(0x13000, 0x1000);
+  std::vector<BYTE> third = test.ReadTarget(0x16000, 0x800);
+  TEST_ASSERT(std::equal(first.begin(), first.end(), file.begin()));
+  TEST_ASSERT(std::equal(second.begin(), second.end(), file.begin() + 0x2800));
+  TEST_ASSERT(std::equal(third.begin(), third.end(), file.begin() + 0x5800));
+  for (size_t i = 0x800; i < 0x2800; i++) {
+    TEST_ASSERT_EQUALS(0, file[i]);
+  }
+  for (size_t i = 0x3800; i < 0x5800; i++) {
+    TEST_ASSERT_EQUALS(0, file[i]);
+  }
+}
+
+TEST(Dump_MaxBytesAndResume) {
+  MemoryDumpTest test;
+  test.AddPatternRegion(0x10000, 0x8000);
+
+  memory_dump::DumpOptions options;
+  options.address = 0x10000;
+  options.size = 0x8000;
+  options.file_path = test.file_path;
+  options.chunk_size = 0x1000;
+  options.max_bytes = 0x3000;
+  options.hash = true;
+
+  memory_dump::MemoryDumper dumper(&g_debug);
+  memory_dump::DumpResult result = dumper.Dump(options);
+  TEST_ASSERT(result.success);
+  TEST_ASSERT(!result.complete);
+  TEST_ASSERT_EQUALS(0x3000ULL, result.next_offset);
+  TEST_ASSERT_EQUALS(0x3000, test.ReadFile().size());
+
+  // Resume with a smaller offset than the file size (as if the last
+  // chunk of the previous call had only been partially written).
+  options.offset = 0x2000;
+  options.max_bytes = ~0ULL;
+  result = dumper.Dump(options);
+  TEST_ASSERT(result.success);
+  TEST_ASSERT(result.complete);
+  TEST_ASSERT_EQUALS(0x6000ULL, result.bytes_written);
+  TEST_ASSERT_EQUALS(0x8000ULL, result.next_offset);
+
+  // The hash covers the part of the file written by the previous call
+  std::vector<BYTE> expected = test.ReadTarget(0x10000, 0x8000);
+  TEST_ASSERT(test.ReadFile() == expected);
+  TEST_ASSERT_EQUALS(Sha256Hex(expected), result.sha256);
+}
+
+TEST(Dump_ProgressCanStopTheDump) {
+  MemoryDumpTest test;
+  test.AddPatternRegion(0x10000, 0x8000);
+
+  memory_dump::DumpOptions options;
+  options.address = 0x10000;
+  options.size = 0x8000;
+  options.file_path = test.file_path;
+  options.chunk_size = 0x1000;
+
+  std::vector<ULONG64> offsets;
+  memory_dump::MemoryDumper dumper(&g_debug);
+  memory_dump::DumpResult result =
+      dumper.Dump(options, [&](ULONG64 offset, ULONG64 total_size) {
+        TEST_ASSERT_EQUALS(0x8000ULL, total_size);
+        offsets.push_back(offset);
+        return offsets.size() < 3;
+      });
+
+  TEST_ASSERT(result.success);
+  TEST_ASSERT(!result.complete);
+  TEST_ASSERT_EQUALS(3, offsets.size());
+  TEST_ASSERT_EQUALS(0x3000ULL, offsets.back());
+  TEST_ASSERT_EQUALS(0x3000ULL, result.next_offset);
+  TEST_ASSERT_EQUALS(0x3000, test.ReadFile().size());
+}
+
+TEST(Dump_InvalidOptions) {
+  MemoryDumpTest test;
+  test.AddPatternRegion(0x10000, 0x1000);
+  memory_dump::MemoryDumper dumper(&g_debug);
+
+  memory_dump::DumpOptions options;
+  options.address = 0x10000;
+  options.size = 0x1000;
+  memory_dump::DumpResult result = dumper.Dump(options);
+  TEST_ASSERT(!result.success);
+  TEST_ASSERT_STRING_CONTAINS(result.error, "No file");
+
+  // Resuming requires the file to contain at least offset bytes
+  options.file_path = test.file_path;
+  options.offset = 0x800;
+  result = dumper.Dump(options);
+  TEST_ASSERT(!result.success);
+  TEST_ASSERT_STRING_CONTAINS(result.error, "Unable to resume");
+
+  options.offset = 0x2000;
+  result = dumper.Dump(options);
+  TEST_ASSERT(!result.success);
+
+  options.offset = 0;
+  options.size = 0;
+  result = dumper.Dump(options);
+  TEST_ASSERT(!result.success);
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
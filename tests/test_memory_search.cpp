@@ -0,0 +1,380 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../src/memory_search.h"
+#include "../src/utils.h"
+#include "debug_interfaces_test_base.h"
+#include "mocks/fake_target_memory.h"
+#include "unit_test_runner.h"
+
+utils::DebugInterfaces g_debug;
+
+class MemorySearchTest : public DebugInterfacesTestBase {
+ public:
+  FakeTargetMemory memory;
+
+  MemorySearchTest() : DebugInterfacesTestBase(g_debug) {
+    memory.Install(mock_data_spaces);
+  }
+};
+
+DECLARE_TEST_RUNNER()
+
+namespace {
+
+std::vector<size_t> FindAll(const std::vector<BYTE>& data,
+                            const std::vector<BYTE>& pattern) {
+  std::vector<size_t> offsets;
+  memory_search::FindPattern(data.data(), data.size(), pattern.data(),
+                             pattern.size(), [&](size_t offset) {
+                               offsets.push_back(offset);
+                               return true;
+                             });
+  return offsets;
+}
+
+std::vector<size_t> FindAllNaive(const std::vector<BYTE>& data,
+                                 const std::vector<BYTE>& pattern) {
+  std::vector<size_t> offsets;
+  for (size_t i = 0; i + pattern.size() <= data.size(); i++) {
+    if (memcmp(data.data() + i, pattern.data(), pattern.size()) == 0) {
+      offsets.push_back(i);
+    }
+  }
+  return offsets;
+}
+
+std::vector<BYTE> ToBytes(const std::string& text) {
+  return std::vector<BYTE>(text.begin(), text.end());
+}
+
+}  // namespace
+
+//
+// FindPattern tests
+//
+
+TEST(FindPattern_SingleMatch) {
+  std::vector<BYTE> data = ToBytes("the quick brown fox jumps over the dog");
+  std::vector<size_t> offsets = FindAll(data, ToBytes("fox"));
+  TEST_ASSERT_EQUALS(1, offsets.size());
+  TEST_ASSERT_EQUALS(16, offsets[0]);
+}
+
+TEST(FindPattern_MatchesAtBlockBoundaries) {
+  // Matches at the start, across the 16 byte blocks and at the very end
+  std::vector<BYTE> data(100, 'x');
+  std::vector<BYTE> pattern = ToBytes("abc");
+  for (size_t offset : {0, 14, 30, 46, 63, 80, 97}) {
+    memcpy(data.data() + offset, pattern.data(), pattern.size());
+  }
+
+  TEST_ASSERT(FindAll(data, pattern) == FindAllNaive(data, pattern));
+  TEST_ASSERT_EQUALS(7, FindAll(data, pattern).size());
+}
+
+TEST(FindPattern_OverlappingMatches) {
+  std::vector<BYTE> data(40, 'a');
+  std::vector<BYTE> pattern = ToBytes("aaa");
+  TEST_ASSERT(FindAll(data, pattern) == FindAllNaive(data, pattern));
+  TEST_ASSERT_EQUALS(38, FindAll(data, pattern).size());
+}
+
+TEST(FindPattern_SingleAndTwoBytePatterns) {
+  std::vector<BYTE> data;
+  for (int i = 0; i < 1000; i++) {
+    data.push_back(static_cast<BYTE>((i * 7) & 0xFF));
+  }
+
+  std::vector<BYTE> one = {0x15};
+  std::vector<BYTE> two = {0x15, 0x1c};
+  TEST_ASSERT(FindAll(data, one) == FindAllNaive(data, one));
+  TEST_ASSERT(FindAll(data, two) == FindAllNaive(data, two));
+  TEST_ASSERT(!FindAll(data, two).empty());
+}
+
+TEST(FindPattern_FirstAndLastByteMatchButMiddleDoesNot) {
+  std::vector<BYTE> data = ToBytes("axxxb_ayyyb_axyzb_axyzb_________");
+  std::vector<size_t> offsets = FindAll(data, ToBytes("axyzb"));
+  TEST_ASSERT_EQUALS(2, offsets.size());
+  TEST_ASSERT_EQUALS(12, offsets[0]);
+  TEST_ASSERT_EQUALS(18, offsets[1]);
+}
+
+TEST(FindPattern_PatternLongerThanData) {
+  std::vector<BYTE> data = ToBytes("abc");
+  TEST_ASSERT_EQUALS(0, FindAll(data, ToBytes("abcd")).size());
+  TEST_ASSERT_EQUALS(0, FindAll(data, {}).size());
+}
+
+TEST(FindPattern_StopsWhenCallbackReturnsFalse) {
+  std::vector<BYTE> data(64, 'a');
+  size_t count = 0;
+  memory_search::FindPattern(data.data(), data.size(),
+                             reinterpret_cast<const BYTE*>("a"), 1,
+                             [&](size_t offset) { return ++count < 3; });
+  TEST_ASSERT_EQUALS(3, count);
+}
+
+//
+// FindPointers tests
+//
+
+TEST(FindPointers_FindsAlignedValuesInRange) {
+  std::vector<ULONG64> values = {0x10, 0x7ff600001000, 0x7ff6ffffffff,
+                                 0x7ff700000000, 0x7ff600000000};
+  std::vector<BYTE> data(values.size() * 8);
+  memcpy(data.data(), values.data(), data.size());
+
+  std::vector<size_t> offsets;
+  memory_search::FindPointers(data.data(), data.size(), 0x1000, 0x7ff600000000,
+                              0x7ff6ffffffff, [&](size_t offset) {
+                                offsets.push_back(offset);
+                                return true;
+                              });
+
+  TEST_ASSERT_EQUALS(3, offsets.size());
+  TEST_ASSERT_EQUALS(8, offsets[0]);
+  TEST_ASSERT_EQUALS(16, offsets[1]);
+  TEST_ASSERT_EQUALS(32, offsets[2]);
+}
+
+TEST(FindPointers_RespectsAbsoluteAlignment) {
+  std::vector<BYTE> data(24, 0);
+  ULONG64 value = 0x1234;
+  memcpy(data.data() + 4, &value, 8);
+
+  // data[4] is at address 0x1000 which is aligned
+  std::vector<size_t> offsets;
+  memory_search::FindPointers(data.data(), data.size(), 0xFFC, 0x1234, 0x1234,
+                              [&](size_t offset) {
+                                offsets.push_back(offset);
+                                return true;
+                              });
+  TEST_ASSERT_EQUALS(1, offsets.size());
+  TEST_ASSERT_EQUALS(4, offsets[0]);
+}
+
+//
+// Helper tests
+//
+
+TEST(ParseHexBytes_Formats) {
+  std::vector<BYTE> bytes;
+  TEST_ASSERT(memory_search::ParseHexBytes("48 8b 05", bytes));
+  TEST_ASSERT(bytes == std::vector<BYTE>({0x48, 0x8b, 0x05}));
+
+  TEST_ASSERT(memory_search::ParseHexBytes("488B05", bytes));
+  TEST_ASSERT(bytes == std::vector<BYTE>({0x48, 0x8b, 0x05}));
+
+  TEST_ASSERT(memory_search::ParseHexBytes("0x48, 0x8b,5", bytes));
+  TEST_ASSERT(bytes == std::vector<BYTE>({0x48, 0x8b, 0x05}));
+
+  TEST_ASSERT(!memory_search::ParseHexBytes("", bytes));
+  TEST_ASSERT(!memory_search::ParseHexBytes("48 zz", bytes));
+  TEST_ASSERT(!memory_search::ParseHexBytes("488", bytes));
+}
+
+TEST(EncodeUtf16_AsciiAndMultibyte) {
+  TEST_ASSERT(memory_search::EncodeUtf16("ab") ==
+              std::vector<BYTE>({'a', 0, 'b', 0}));
+
+  // U+00E9 (2 bytes in UTF-8) and U+1F600 (surrogate pair in UTF-16)
+  std::vector<BYTE> bytes = memory_search::EncodeUtf16("\xC3\xA9\xF0\x9F\x98\x80");
+  TEST_ASSERT(bytes ==
+              std::vector<BYTE>({0xE9, 0x00, 0x3D, 0xD8, 0x00, 0xDE}));
+}
+
+TEST(ContinuationToken_RoundTrip) {
+  ULONG64 address = 0;
+  std::string token = memory_search::EncodeContinuationToken(0x7ff612345678);
+  TEST_ASSERT(memory_search::DecodeContinuationToken(token, address));
+  TEST_ASSERT_EQUALS(0x7ff612345678ULL, address);
+
+  TEST_ASSERT(!memory_search::DecodeContinuationToken("", address));
+  TEST_ASSERT(!memory_search::DecodeContinuationToken("ms1:", address));
+  TEST_ASSERT(!memory_search::DecodeContinuationToken("1234", address));
+  TEST_ASSERT(!memory_search::DecodeContinuationToken("ms1:xyz", address));
+}
+
+//
+// MemorySearcher tests
+//
+
+TEST(MemorySearcher_FindsStringsInCommittedRegions) {
+  MemorySearchTest test;
+  test.memory.AddZeroRegion(0x10000, 0x3000);
+  test.memory.AddZeroRegion(0x20000, 0x1000);
+  test.memory.Write(0x10100, "needle", 6);
+  test.memory.Write(0x12FFE, "needle", 6);
+  test.memory.Write(0x20010, "needle", 6);
+
+  memory_search::SearchOptions options;
+  options.type = memory_search::PatternType::kAscii;
+  options.pattern = ToBytes("needle");
+  options.context_bytes = 8;
+
+  memory_search::MemorySearcher searcher(&g_debug);
+  memory_search::SearchResult result = searcher.Search(options);
+
+  TEST_ASSERT(result.complete);
+  TEST_ASSERT_EQUALS(2, result.regions_scanned);
+  TEST_ASSERT_EQUALS(2, result.hits.size());
+  TEST_ASSERT_EQUALS(0x10100ULL, result.hits[0].address);
+  TEST_ASSERT_EQUALS(0x10000ULL, result.hits[0].region_base);
+  TEST_ASSERT_EQUALS(0x20010ULL, result.hits[1].address);
+  TEST_ASSERT_EQUALS(std::string("needle"),
+                     std::string(result.hits[0].context.begin(),
+                                 result.hits[0].context.begin() + 6));
+  TEST_ASSERT_EQUALS(8, result.hits[0].context.size());
+}
+
+TEST(MemorySearcher_SkipsInaccessibleRegions) {
+  MemorySearchTest test;
+  test.memory.AddZeroRegion(0x10000, 0x1000, PAGE_NOACCESS);
+  test.memory.AddZeroRegion(0x20000, 0x1000);
+  test.memory.Write(0x10010, "abcd", 4);
+  test.memory.Write(0x20010, "abcd", 4);
+
+  memory_search::SearchOptions options;
+  options.pattern = ToBytes("abcd");
+
+  memory_search::MemorySearcher searcher(&g_debug);
+  memory_search::SearchResult result = searcher.Search(options);
+
+  TEST_ASSERT_EQUALS(1, result.hits.size());
+  TEST_ASSERT_EQUALS(0x20010ULL, result.hits[0].address);
+  TEST_ASSERT_EQUALS(1, result.regions_scanned);
+}
+
+TEST(MemorySearcher_MatchSpanningChunks) {
+  MemorySearchTest test;
+
+  // The pattern straddles the 1 MB chunk boundary
+  const ULONG64 base = 0x100000;
+  test.memory.AddZeroRegion(base, 0x200000);
+  test.memory.Write(base + 0x100000 - 3, "spanning", 8);
+
+  memory_search::SearchOptions options;
+  options.pattern = ToBytes("spanning");
+
+  memory_search::MemorySearcher searcher(&g_debug);
+  memory_search::SearchResult result = searcher.Search(options);
+
+  TEST_ASSERT_EQUALS(1, result.hits.size());
+  TEST_ASSERT_EQUALS(base + 0x100000 - 3, result.hits[0].address);
+}
+
+TEST(MemorySearcher_MaxHitsAndContinuation) {
+  MemorySearchTest test;
+  test.memory.AddZeroRegion(0x10000, 0x1000);
+  for (ULONG64 i = 0; i < 5; i++) {
+    test.memory.Write(0x10000 + i * 0x100, "hit", 3);
+  }
+
+  memory_search::SearchOptions options;
+  options.pattern = ToBytes("hit");
+  options.max_hits = 2;
+
+  memory_search::MemorySearcher searcher(&g_debug);
+  std::vector<ULONG64> addresses;
+  for (int i = 0; i < 10; i++) {
+    memory_search::SearchResult result = searcher.Search(options);
+    for (const auto& hit : result.hits) {
+      addresses.push_back(hit.address);
+    }
+    if (result.complete) {
+      break;
+    }
+    options.start = result.next_address;
+  }
+
+  TEST_ASSERT_EQUALS(5, addresses.size());
+  for (ULONG64 i = 0; i < 5; i++) {
+    TEST_ASSERT_EQUALS(0x10000 + i * 0x100, addresses[i]);
+  }
+}
+
+TEST(MemorySearcher_MaxBytesScanned) {
+  MemorySearchTest test;
+  test.memory.AddZeroRegion(0x100000, 0x300000);
+  test.memory.Write(0x380000, "late", 4);
+
+  memory_search::SearchOptions options;
+  options.pattern = ToBytes("late");
+  options.max_bytes_scanned = 0x100000;
+
+  memory_search::MemorySearcher searcher(&g_debug);
+  memory_search::SearchResult result = searcher.Search(options);
+  TEST_ASSERT(!result.complete);
+  TEST_ASSERT_EQUALS(0, result.hits.size());
+  TEST_ASSERT_EQUALS(0x200000ULL, result.next_address);
+
+  options.start = result.next_address;
+  options.max_bytes_scanned = 0x1000000;
+  result = searcher.Search(options);
+  TEST_ASSERT(result.complete);
+  TEST_ASSERT_EQUALS(1, result.hits.size());
+  TEST_ASSERT_EQUALS(0x380000ULL, result.hits[0].address);
+}
+
+TEST(MemorySearcher_RespectsRange) {
+  MemorySearchTest test;
+  test.memory.AddZeroRegion(0x10000, 0x1000);
+  test.memory.Write(0x10010, "x1", 2);
+  test.memory.Write(0x10800, "x1", 2);
+
+  memory_search::SearchOptions options;
+  options.pattern = ToBytes("x1");
+  options.start = 0x10020;
+  options.end = 0x10900;
+
+  memory_search::MemorySearcher searcher(&g_debug);
+  memory_search::SearchResult result = searcher.Search(options);
+  TEST_ASSERT_EQUALS(1, result.hits.size());
+  TEST_ASSERT_EQUALS(0x10800ULL, result.hits[0].address);
+}
+
+TEST(MemorySearcher_PointerSearch) {
+  MemorySearchTest test;
+  test.memory.AddZeroRegion(0x10000, 0x1000);
+  test.memory.WriteValue<ULONG64>(0x10008, 0x7ff612340000);
+  test.memory.WriteValue<ULONG64>(0x10100, 0x7ff5ffffffff);
+  test.memory.WriteValue<ULONG64>(0x10200, 0x7ff6ffff0000);
+
+  memory_search::SearchOptions options;
+  options.type = memory_search::PatternType::kPointer;
+  options.min_value = 0x7ff600000000;
+  options.max_value = 0x7ff6ffffffff;
+
+  memory_search::MemorySearcher searcher(&g_debug);
+  memory_search::SearchResult result = searcher.Search(options);
+  TEST_ASSERT_EQUALS(2, result.hits.size());
+  TEST_ASSERT_EQUALS(0x10008ULL, result.hits[0].address);
+  TEST_ASSERT_EQUALS(0x7ff612340000ULL, result.hits[0].value);
+  TEST_ASSERT_EQUALS(0x10200ULL, result.hits[1].address);
+}
+
+TEST(MemorySearcher_Utf16Search) {
+  MemorySearchTest test;
+  test.memory.AddZeroRegion(0x10000, 0x1000);
+  std::vector<BYTE> wide = memory_search::EncodeUtf16("chrome.dll");
+  test.memory.Write(0x10402, wide.data(), wide.size());
+
+  memory_search::SearchOptions options;
+  options.type = memory_search::PatternType::kUtf16;
+  options.pattern = memory_search::EncodeUtf16("chrome");
+
+  memory_search::MemorySearcher searcher(&g_debug);
+  memory_search::SearchResult result = searcher.Search(options);
+  TEST_ASSERT_EQUALS(1, result.hits.size());
+  TEST_ASSERT_EQUALS(0x10402ULL, result.hits[0].address);
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,394 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <atomic>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/minidump_reader.h"
+#include "../src/minidump_tools.h"
+#include "mocks/fake_minidump.h"
+#include "unit_test_runner.h"
+
+using minidump::MinidumpReader;
+using minidump::MinidumpTools;
+
+namespace {
+
+constexpr uint64_t kChromeBase = 0x7ff600000000;
+constexpr uint64_t kNtdllBase = 0x7ffa10000000;
+constexpr uint64_t kStackStart = 0x2000;
+
+std::string GetTempPath(const std::string& name) {
+  return (std::filesystem::temp_directory_path() /
+          ("test_minidump_reader_" + name + ".dmp"))
+      .string();
+}
+
+std::vector<uint8_t> ToBytes(const std::vector<uint64_t>& values) {
+  std::vector<uint8_t> bytes(values.size() * 8);
+  memcpy(bytes.data(), values.data(), bytes.size());
+  return bytes;
+}
+
+// Two modules, two threads and an access violation on the first thread.
+// The stack of the first thread has a return address into chrome.dll.
+FakeMinidump CreateCrashDump() {
+  FakeMinidump dump;
+  dump.AddModule(kNtdllBase, 0x200000, "C:\\Windows\\System32\\ntdll.dll",
+                 "ntdll.pdb");
+  dump.AddModule(kChromeBase, 0x1000000, "C:\\out\\chrome.dll", "chrome.dll.pdb",
+                 0x66000000);
+
+  dump.AddThread(0x1a2c, 0x100000,
+                 {{"rip", kChromeBase + 0x1234},
+                  {"rsp", kStackStart + 0x10},
+                  {"rax", 0x42},
+                  {"efl", 0x246}},
+                 kStackStart, 0x40);
+  dump.AddThread(0x2b3c, 0x102000,
+                 {{"rip", kNtdllBase + 0x9d0f4}, {"rsp", 0x3000}});
+
+  dump.AddMemory(kStackStart,
+                 ToBytes({0x1111, 0x2222, 0x3333, kChromeBase + 0x5678,
+                          0x4444, kNtdllBase + 0x10, 0x5555, 0x6666}));
+  dump.AddMemory(0x10000, {0x01, 0x02, 0x03, 0x04});
+  // Adjacent to the previous range.
+  dump.AddMemory(0x10004, {0x05, 0x06});
+
+  dump.SetException(0x1a2c, 0xc0000005, kChromeBase + 0x1234,
+                    {{"rip", kChromeBase + 0x1234}, {"rcx", 0xdead}},
+                    {0, 0xdead});
+  return dump;
+}
+
+std::string WriteCrashDump(const std::string& name) {
+  std::string path = GetTempPath(name);
+  CreateCrashDump().Write(path);
+  return path;
+}
+
+uint64_t GetRegister(const minidump::Registers& registers,
+                     const std::string& name) {
+  for (const auto& [register_name, value] : registers) {
+    if (register_name == name) {
+      return value;
+    }
+  }
+  return ~0ull;
+}
+
+// The tools return their output as a JSON string.
+JSON ParseOutput(const JSON& result) {
+  if (result.is_object() && result.contains("error")) {
+    return result;
+  }
+  return JSON::parse(result.get<std::string>());
+}
+
+}  // namespace
+
+DECLARE_TEST_RUNNER()
+
+TEST(Open_ModulesAndSystemInfo) {
+  std::string path = WriteCrashDump("modules");
+
+  MinidumpReader reader;
+  std::string error;
+  TEST_ASSERT(reader.Open(path, error));
+  TEST_ASSERT(error.empty());
+
+  TEST_ASSERT_EQUALS(0x5f000000u, reader.GetTimeDateStamp());
+  TEST_ASSERT_EQUALS(minidump::kProcessorArchitectureAmd64,
+                     reader.GetSystemInfo().processor_architecture);
+  TEST_ASSERT_EQUALS(8, reader.GetSystemInfo().processor_count);
+  TEST_ASSERT_EQUALS(22631u, reader.GetSystemInfo().build_number);
+
+  // The modules are sorted by base address.
+  const auto& modules = reader.GetModules();
+  TEST_ASSERT_EQUALS(2, modules.size());
+  TEST_ASSERT_EQUALS(std::string("C:\\out\\chrome.dll"), modules[0].name);
+  TEST_ASSERT_EQUALS(std::string("chrome.dll.pdb"), modules[0].pdb_name);
+  TEST_ASSERT_EQUALS(0x66000000u, modules[0].time_date_stamp);
+  TEST_ASSERT_EQUALS(std::string("ntdll.pdb"), modules[1].pdb_name);
+
+  TEST_ASSERT(reader.FindModule(kChromeBase) == &modules[0]);
+  TEST_ASSERT(reader.FindModule(kChromeBase + 0xffffff) == &modules[0]);
+  TEST_ASSERT(reader.FindModule(kChromeBase + 0x1000000) == nullptr);
+  TEST_ASSERT(reader.FindModule(kNtdllBase + 0x10) == &modules[1]);
+  TEST_ASSERT(reader.FindModule(0x1000) == nullptr);
+
+  std::filesystem::remove(path);
+}
+
+TEST(Open_ThreadsAndRegisters) {
+  std::string path = WriteCrashDump("threads");
+
+  MinidumpReader reader;
+  std::string error;
+  TEST_ASSERT(reader.Open(path, error));
+
+  TEST_ASSERT_EQUALS(2, reader.GetThreads().size());
+  const minidump::Thread* thread = reader.FindThread(0x1a2c);
+  TEST_ASSERT(thread != nullptr);
+  TEST_ASSERT_EQUALS(0x100000u, thread->teb);
+  TEST_ASSERT_EQUALS(kStackStart, thread->stack_start);
+  TEST_ASSERT_EQUALS(0x40u, thread->stack.size);
+  TEST_ASSERT(reader.FindThread(0x9999) == nullptr);
+
+  minidump::Registers registers;
+  TEST_ASSERT(reader.GetRegisters(thread->context, registers));
+  TEST_ASSERT_EQUALS(std::string("rax"), registers.front().first);
+  TEST_ASSERT_EQUALS(0x42u, GetRegister(registers, "rax"));
+  TEST_ASSERT_EQUALS(kChromeBase + 0x1234, GetRegister(registers, "rip"));
+  TEST_ASSERT_EQUALS(0x246u, GetRegister(registers, "efl"));
+  TEST_ASSERT_EQUALS(kChromeBase + 0x1234,
+                     reader.GetInstructionPointer(thread->context));
+  TEST_ASSERT_EQUALS(kStackStart + 0x10,
+                     reader.GetStackPointer(thread->context));
+
+  std::filesystem::remove(path);
+}
+
+TEST(Open_Exception) {
+  std::string path = WriteCrashDump("exception");
+
+  MinidumpReader reader;
+  std::string error;
+  TEST_ASSERT(reader.Open(path, error));
+
+  TEST_ASSERT(reader.HasException());
+  const minidump::ExceptionInfo& exception = reader.GetException();
+  TEST_ASSERT_EQUALS(0x1a2cu, exception.thread_id);
+  TEST_ASSERT_EQUALS(0xc0000005u, exception.code);
+  TEST_ASSERT_EQUALS(kChromeBase + 0x1234, exception.address);
+  TEST_ASSERT_EQUALS(2, exception.parameters.size());
+  TEST_ASSERT_EQUALS(0xdeadu, exception.parameters[1]);
+
+  minidump::Registers registers;
+  TEST_ASSERT(reader.GetRegisters(exception.context, registers));
+  TEST_ASSERT_EQUALS(0xdeadu, GetRegister(registers, "rcx"));
+
+  std::filesystem::remove(path);
+}
+
+TEST(ReadMemory_Memory64AndMemoryList) {
+  for (bool use_memory_list : {false, true}) {
+    FakeMinidump dump = CreateCrashDump();
+    if (use_memory_list) {
+      dump.UseMemoryList();
+    }
+    std::string path = GetTempPath("memory");
+    dump.Write(path);
+
+    MinidumpReader reader;
+    std::string error;
+    TEST_ASSERT(reader.Open(path, error));
+    TEST_ASSERT_EQUALS(3, reader.GetMemoryRanges().size());
+
+    uint8_t buffer[16] = {};
+    TEST_ASSERT_EQUALS(2, reader.ReadMemory(0x10001, buffer, 2));
+    TEST_ASSERT_EQUALS(0x02, buffer[0]);
+    TEST_ASSERT_EQUALS(0x03, buffer[1]);
+
+    // The read continues into the adjacent range and
+    // stops at the end of the saved memory.
+    TEST_ASSERT_EQUALS(4, reader.ReadMemory(0x10002, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUALS(0x03, buffer[0]);
+    TEST_ASSERT_EQUALS(0x06, buffer[3]);
+
+    TEST_ASSERT_EQUALS(0, reader.ReadMemory(0x20000, buffer, sizeof(buffer)));
+    TEST_ASSERT_EQUALS(0, reader.ReadMemory(0xffff, buffer, sizeof(buffer)));
+
+    uint64_t value = 0;
+    TEST_ASSERT_EQUALS(8, reader.ReadMemory(kStackStart + 0x18, &value, 8));
+    TEST_ASSERT_EQUALS(kChromeBase + 0x5678, value);
+
+    std::filesystem::remove(path);
+  }
+}
+
+TEST(Open_InvalidFiles) {
+  MinidumpReader reader;
+  std::string error;
+  TEST_ASSERT(!reader.Open(GetTempPath("missing"), error));
+  TEST_ASSERT(!error.empty());
+
+  std::string path = GetTempPath("invalid");
+  {
+    std::ofstream file(path, std::ios::binary);
+    file << "This is not a minidump file at all";
+  }
+  MinidumpReader invalid_reader;
+  error.clear();
+  TEST_ASSERT(!invalid_reader.Open(path, error));
+  TEST_ASSERT_STRING_CONTAINS(error, "Not a minidump");
+
+  // Every truncation of a valid dump either fails to open or opens
+  // without reading past the end of the file.
+  std::vector<uint8_t> bytes = CreateCrashDump().Build();
+  for (size_t size = 0; size < bytes.size(); size += 7) {
+    {
+      std::ofstream file(path, std::ios::binary | std::ios::trunc);
+      file.write(reinterpret_cast<const char*>(bytes.data()), size);
+    }
+
+    MinidumpReader truncated_reader;
+    if (truncated_reader.Open(path, error)) {
+      uint8_t buffer[64];
+      for (const auto& range : truncated_reader.GetMemoryRanges()) {
+        truncated_reader.ReadMemory(range.start, buffer, sizeof(buffer));
+      }
+      minidump::Registers registers;
+      for (const auto& thread : truncated_reader.GetThreads()) {
+        truncated_reader.GetRegisters(thread.context, registers);
+      }
+    }
+  }
+
+  std::filesystem::remove(path);
+}
+
+TEST(Tools_OpenAndQuery) {
+  std::string path = WriteCrashDump("tools");
+  MinidumpTools tools(2);
+
+  TEST_ASSERT(MinidumpTools::IsMinidumpTool("minidumpStack"));
+  TEST_ASSERT(!MinidumpTools::IsMinidumpTool("getCallStack"));
+  TEST_ASSERT_EQUALS(7, MinidumpTools::GetToolDefinitions().size());
+
+  JSON summary = ParseOutput(tools.CallTool("openMinidump", {{"path", path}}));
+  TEST_ASSERT_EQUALS(1, summary["dumpId"].get<int>());
+  TEST_ASSERT_EQUALS(std::string("x64"), summary["architecture"]);
+  TEST_ASSERT_EQUALS(2, summary["moduleCount"].get<int>());
+  TEST_ASSERT_EQUALS(std::string("0xc0000005"), summary["exception"]["code"]);
+  TEST_ASSERT_EQUALS(std::string("chrome+0x1234"),
+                     summary["exception"]["location"]);
+
+  // Opening the same file again returns the same dump.
+  JSON again = ParseOutput(tools.CallTool("openMinidump", {{"path", path}}));
+  TEST_ASSERT_EQUALS(1, again["dumpId"].get<int>());
+  TEST_ASSERT_EQUALS(1, tools.GetOpenDumpCount());
+
+  JSON modules = ParseOutput(
+      tools.CallTool("minidumpModules", {{"dumpId", 1}, {"filter", "CHROME"}}));
+  TEST_ASSERT_EQUALS(1, modules["modules"].size());
+  TEST_ASSERT_EQUALS(std::string("chrome"), modules["modules"][0]["name"]);
+  TEST_ASSERT_EQUALS(std::string("0x7ff600000000"),
+                     modules["modules"][0]["base"]);
+
+  JSON threads = ParseOutput(tools.CallTool("minidumpThreads", {{"dumpId", 1}}));
+  TEST_ASSERT_EQUALS(2, threads["threads"].size());
+  TEST_ASSERT(threads["threads"][0]["exception"].get<bool>());
+  TEST_ASSERT_EQUALS(std::string("ntdll+0x9d0f4"),
+                     threads["threads"][1]["location"]);
+
+  JSON context = ParseOutput(tools.CallTool(
+      "minidumpThreadContext", {{"dumpId", 1}, {"exception", true}}));
+  TEST_ASSERT_EQUALS(0x1a2c, context["threadId"].get<int>());
+  TEST_ASSERT_EQUALS(std::string("rax"), context["registers"][0][0]);
+
+  JSON memory = ParseOutput(tools.CallTool(
+      "minidumpReadMemory",
+      {{"dumpId", 1}, {"address", "00000000`00010001"}, {"size", 4}}));
+  TEST_ASSERT_EQUALS(std::string("02030405"), memory["data"]);
+
+  // The stack starts at rsp and the return address is annotated.
+  JSON stack = ParseOutput(
+      tools.CallTool("minidumpStack", {{"dumpId", 1}, {"threadId", 0x1a2c}}));
+  TEST_ASSERT_EQUALS(0x30, stack["bytesRead"].get<int>());
+  TEST_ASSERT_EQUALS(6, stack["values"].size());
+  TEST_ASSERT_EQUALS(std::string("0x2018"), stack["values"][1]["address"]);
+  TEST_ASSERT_EQUALS(std::string("chrome+0x5678"),
+                     stack["values"][1]["module"]);
+  TEST_ASSERT_EQUALS(std::string("ntdll+0x10"), stack["values"][3]["module"]);
+  TEST_ASSERT(!stack["values"][0].contains("module"));
+
+  TEST_ASSERT_STRING_CONTAINS(
+      tools.CallTool("closeMinidump", {{"dumpId", 1}}).get<std::string>(),
+      "Closed");
+  TEST_ASSERT_EQUALS(0, tools.GetOpenDumpCount());
+
+  std::filesystem::remove(path);
+}
+
+TEST(Tools_Errors) {
+  std::string path = WriteCrashDump("tool_errors");
+  MinidumpTools tools(1);
+
+  JSON result = tools.CallTool("openMinidump", {{"path", GetTempPath("none")}});
+  TEST_ASSERT(result.contains("error"));
+
+  result = tools.CallTool("minidumpThreads", {{"dumpId", 5}});
+  TEST_ASSERT_STRING_CONTAINS(result["error"].get<std::string>(),
+                              "Unknown dumpId");
+
+  tools.CallTool("openMinidump", {{"path", path}});
+  result = tools.CallTool("minidumpReadMemory",
+                          {{"dumpId", 1}, {"address", "0xnothex"}});
+  TEST_ASSERT_STRING_CONTAINS(result["error"].get<std::string>(), "address");
+
+  result = tools.CallTool("minidumpReadMemory",
+                          {{"dumpId", 1}, {"address", "0x50000"}});
+  TEST_ASSERT_STRING_CONTAINS(result["error"].get<std::string>(),
+                              "not in the dump");
+
+  result = tools.CallTool("minidumpStack", {{"dumpId", 1}, {"threadId", 7}});
+  TEST_ASSERT_STRING_CONTAINS(result["error"].get<std::string>(),
+                              "Unknown threadId");
+
+  result = tools.CallTool("minidumpThreadContext", {{"dumpId", "1"}});
+  TEST_ASSERT(result.contains("error"));
+
+  std::filesystem::remove(path);
+}
+
+TEST(Tools_ConcurrentCalls) {
+  std::string path = WriteCrashDump("concurrent");
+  MinidumpTools tools(4);
+  ParseOutput(tools.CallTool("openMinidump", {{"path", path}}));
+
+  // Reads from several client threads while another thread
+  // repeatedly opens and closes a second dump.
+  std::string other_path = WriteCrashDump("concurrent_other");
+  std::atomic<int> failures = 0;
+  std::atomic<bool> done = false;
+  std::vector<std::thread> clients;
+  for (int i = 0; i < 4; i++) {
+    clients.emplace_back([&]() {
+      for (int j = 0; j < 200; j++) {
+        JSON stack = tools.CallTool("minidumpStack",
+                                    {{"dumpId", 1}, {"threadId", 0x1a2c}});
+        if (!stack.is_string() ||
+            ParseOutput(stack)["values"].size() != 6) {
+          failures++;
+        }
+      }
+    });
+  }
+  std::thread reopen([&]() {
+    while (!done) {
+      JSON summary =
+          ParseOutput(tools.CallTool("openMinidump", {{"path", other_path}}));
+      tools.CallTool("closeMinidump", {{"dumpId", summary["dumpId"]}});
+    }
+  });
+
+  for (auto& client : clients) {
+    client.join();
+  }
+  done = true;
+  reopen.join();
+
+  TEST_ASSERT_EQUALS(0, failures.load());
+  TEST_ASSERT_EQUALS(1, tools.GetOpenDumpCount());
+  std::filesystem::remove(path);
+  std::filesystem::remove(other_path);
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
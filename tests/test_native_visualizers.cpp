@@ -0,0 +1,463 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/utils.h"
+#include "../src/visualizer_engine.h"
+#include "debug_interfaces_test_base.h"
+#include "mocks/fake_target_memory.h"
+#include "unit_test_runner.h"
+
+// Forward declarations of globals and functions from native_visualizers.cpp
+extern utils::DebugInterfaces g_debug;
+extern utils::MemoryReadCache g_memory_cache;
+extern std::unique_ptr<visualizers::VisualizerEngine> g_visualizer_engine;
+
+extern HRESULT CALLBACK VisualizeInternal(IDebugClient* client,
+                                          const char* args);
+extern HRESULT CALLBACK VisualizeVectorInternal(IDebugClient* client,
+                                                const char* args);
+extern HRESULT CALLBACK ClearVisualizerCacheInternal(IDebugClient* client,
+                                                     const char* args);
+extern HRESULT CALLBACK DebugExtensionUninitializeInternal();
+
+namespace {
+
+constexpr ULONG64 kModuleBase = 0x7ff600000000;
+
+// media::CdmConfig layout used by the tests.
+constexpr ULONG kCdmConfigTypeId = 10;
+constexpr ULONG kCdmConfigSize = 32;
+
+// base::UnguessableToken layout used by the tests.
+constexpr ULONG kTokenTypeId = 11;
+constexpr ULONG kTokenSize = 16;
+
+// Builds the 24 byte libc++ representation of a short string.
+std::vector<BYTE> MakeShortString(const std::string& text) {
+  std::vector<BYTE> bytes(24, 0);
+  memcpy(bytes.data(), text.data(), text.size());
+  bytes[23] = static_cast<BYTE>(text.size());
+  return bytes;
+}
+
+// Builds the 24 byte libc++ representation of a long string.
+std::vector<BYTE> MakeLongString(ULONG64 data, ULONG64 size) {
+  std::vector<BYTE> bytes(24, 0);
+  ULONG64 capacity = size + 1;
+  memcpy(bytes.data(), &data, 8);
+  memcpy(bytes.data() + 8, &size, 8);
+  memcpy(bytes.data() + 16, &capacity, 8);
+  bytes[23] |= 0x80;
+  return bytes;
+}
+
+// Builds a media::CdmConfig value.
+std::vector<BYTE> MakeCdmConfig(const std::vector<BYTE>& key_system,
+                                bool allow_di,
+                                bool allow_ps,
+                                bool use_hw) {
+  std::vector<BYTE> bytes(kCdmConfigSize, 0);
+  memcpy(bytes.data(), key_system.data(), key_system.size());
+  bytes[24] = allow_di;
+  bytes[25] = allow_ps;
+  bytes[26] = use_hw;
+  return bytes;
+}
+
+// Builds a libc++ std::vector header.
+std::vector<BYTE> MakeVector(ULONG64 begin, ULONG64 end) {
+  std::vector<BYTE> bytes(24, 0);
+  memcpy(bytes.data(), &begin, 8);
+  memcpy(bytes.data() + 8, &end, 8);
+  memcpy(bytes.data() + 16, &end, 8);
+  return bytes;
+}
+
+}  // namespace
+
+class NativeVisualizersTest : public DebugInterfacesTestBase {
+ public:
+  FakeTargetMemory memory;
+
+  explicit NativeVisualizersTest() : DebugInterfacesTestBase(g_debug) {
+    memory.Install(mock_data_spaces);
+    SetupSymbols();
+
+    g_memory_cache.Invalidate();
+    g_memory_cache.ResetStatistics();
+    g_visualizer_engine = std::make_unique<visualizers::VisualizerEngine>(
+        &g_debug, &g_memory_cache);
+  }
+
+  ~NativeVisualizersTest() { DebugExtensionUninitializeInternal(); }
+
+ private:
+  void SetupSymbols() {
+    mock_symbols->SetMethodOverride(
+        "GetSymbolTypeId",
+        [](PCSTR symbol, PULONG type_id, PULONG64 module) -> HRESULT {
+          std::string name = symbol;
+          size_t bang = name.find('!');
+          if (bang != std::string::npos) {
+            name = name.substr(bang + 1);
+          }
+
+          if (name == "media::CdmConfig") {
+            *type_id = kCdmConfigTypeId;
+          } else if (name == "base::UnguessableToken") {
+            *type_id = kTokenTypeId;
+          } else {
+            return E_FAIL;
+          }
+          *module = kModuleBase;
+          return S_OK;
+        });
+
+    mock_symbols->SetMethodOverride(
+        "GetTypeSize",
+        [](ULONG64 module, ULONG type_id, PULONG size) -> HRESULT {
+          if (type_id == kCdmConfigTypeId) {
+            *size = kCdmConfigSize;
+          } else if (type_id == kTokenTypeId) {
+            *size = kTokenSize;
+          } else {
+            return E_FAIL;
+          }
+          return S_OK;
+        });
+
+    mock_symbols->SetMethodOverride(
+        "GetFieldOffset",
+        [](ULONG64 module, ULONG type_id, PCSTR field,
+           PULONG offset) -> HRESULT {
+          static const std::map<std::string, ULONG> cdm_config_fields = {
+              {"key_system", 0},
+              {"allow_distinctive_identifier", 24},
+              {"allow_persistent_state", 25},
+              {"use_hw_secure_codecs", 26}};
+
+          if (type_id == kTokenTypeId && std::string(field) == "token_") {
+            *offset = 0;
+            return S_OK;
+          }
+
+          if (type_id == kCdmConfigTypeId) {
+            auto it = cdm_config_fields.find(field);
+            if (it != cdm_config_fields.end()) {
+              *offset = it->second;
+              return S_OK;
+            }
+          }
+          return E_FAIL;
+        });
+
+    mock_client->SetMethodOverride(
+        "SetEventCallbacks",
+        [](IDebugEventCallbacks* callbacks) -> HRESULT { return S_OK; });
+
+    mock_system_objects->SetMethodOverride(
+        "GetCurrentProcessSystemId", [](PULONG id) -> HRESULT {
+          *id = 1;
+          return S_OK;
+        });
+
+    mock_control->SetMethodOverride(
+        "Evaluate",
+        [](PCSTR expression, ULONG desired_type, PDEBUG_VALUE value,
+           PULONG remainder_index) -> HRESULT {
+          value->I64 = std::stoull(expression, nullptr, 0);
+          return S_OK;
+        });
+  }
+};
+
+DECLARE_TEST_RUNNER()
+
+TEST(DecodeStdString_ShortString) {
+  std::vector<BYTE> bytes = MakeShortString("com.widevine.alpha");
+  auto no_read = [](ULONG64, BYTE*, ULONG) { return false; };
+
+  std::string text = visualizers::DecodeStdString(bytes.data(), 100, no_read);
+  TEST_ASSERT_EQUALS(std::string("com.widevine.alpha"), text);
+}
+
+TEST(DecodeStdString_LongString) {
+  std::string long_text(40, 'x');
+  std::vector<BYTE> bytes = MakeLongString(0x1000, long_text.size());
+
+  auto read = [&](ULONG64 address, BYTE* buffer, ULONG size) {
+    if (address != 0x1000 || size > long_text.size()) {
+      return false;
+    }
+    memcpy(buffer, long_text.data(), size);
+    return true;
+  };
+
+  TEST_ASSERT_EQUALS(long_text,
+                     visualizers::DecodeStdString(bytes.data(), 100, read));
+
+  // Truncated to max_length
+  TEST_ASSERT_EQUALS(std::string(10, 'x') + "...",
+                     visualizers::DecodeStdString(bytes.data(), 10, read));
+}
+
+TEST(DecodeStdString_UnreadableLongString) {
+  std::vector<BYTE> bytes = MakeLongString(0x1000, 40);
+  auto no_read = [](ULONG64, BYTE*, ULONG) { return false; };
+
+  std::string text = visualizers::DecodeStdString(bytes.data(), 100, no_read);
+  TEST_ASSERT_STRING_CONTAINS(text, "unreadable string");
+}
+
+TEST(FindVisualizer_IgnoresModulePrefix) {
+  TEST_ASSERT(visualizers::FindVisualizer("chrome!media::CdmConfig") !=
+              nullptr);
+  TEST_ASSERT(visualizers::FindVisualizer("media::CdmConfig") != nullptr);
+  TEST_ASSERT(visualizers::FindVisualizer("media::Unknown") == nullptr);
+}
+
+TEST(RenderValue_CdmConfig) {
+  NativeVisualizersTest test;
+  test.memory.AddRegion(
+      0x2000,
+      MakeCdmConfig(MakeShortString("org.w3.clearkey"), true, false, true));
+
+  visualizers::VisualizerEngine engine(&g_debug);
+  std::string output;
+  std::string error;
+  TEST_ASSERT(engine.RenderValue("media::CdmConfig", 0x2000, output, error));
+  TEST_ASSERT_EQUALS(
+      std::string("\"org.w3.clearkey\" AllowDI: 1 AllowPS: 0 "
+                  "UseHwSecureCodecs: 1"),
+      output);
+}
+
+TEST(RenderValue_UnguessableToken) {
+  NativeVisualizersTest test;
+  test.memory.AddZeroRegion(0x2000, kTokenSize);
+  test.memory.WriteValue<ULONG64>(0x2000, 0x1234);
+  test.memory.WriteValue<ULONG64>(0x2008, 0xabcd);
+
+  visualizers::VisualizerEngine engine(&g_debug);
+  std::string output;
+  std::string error;
+  TEST_ASSERT(
+      engine.RenderValue("base::UnguessableToken", 0x2000, output, error));
+  TEST_ASSERT_EQUALS(std::string("{0x1234, 0xabcd}"), output);
+}
+
+TEST(RenderValue_LayoutResolvedOnce) {
+  NativeVisualizersTest test;
+  test.memory.AddRegion(
+      0x2000, MakeCdmConfig(MakeShortString("a"), false, false, false));
+
+  visualizers::VisualizerEngine engine(&g_debug);
+  std::string output;
+  std::string error;
+  for (int i = 0; i < 5; i++) {
+    TEST_ASSERT(engine.RenderValue("media::CdmConfig", 0x2000, output, error));
+  }
+
+  TEST_ASSERT_EQUALS(1, test.mock_symbols->GetCallCount("GetSymbolTypeId"));
+  TEST_ASSERT_EQUALS(1, test.mock_symbols->GetCallCount("GetTypeSize"));
+  TEST_ASSERT_EQUALS(4, test.mock_symbols->GetCallCount("GetFieldOffset"));
+  TEST_ASSERT_EQUALS(1, engine.GetCachedLayoutCount());
+  TEST_ASSERT_EQUALS(1, engine.GetLayoutCacheMisses());
+  TEST_ASSERT_EQUALS(4, engine.GetLayoutCacheHits());
+
+  // Clearing the cache resolves the layout again
+  engine.ClearCache();
+  TEST_ASSERT(engine.RenderValue("media::CdmConfig", 0x2000, output, error));
+  TEST_ASSERT_EQUALS(2, test.mock_symbols->GetCallCount("GetSymbolTypeId"));
+}
+
+TEST(RenderValue_UnknownType) {
+  NativeVisualizersTest test;
+  visualizers::VisualizerEngine engine(&g_debug);
+  std::string output;
+  std::string error;
+
+  TEST_ASSERT(!engine.RenderValue("media::Unknown", 0x2000, output, error));
+  TEST_ASSERT_STRING_CONTAINS(error, "No native visualizer");
+}
+
+TEST(RenderValue_MissingField) {
+  NativeVisualizersTest test;
+  test.mock_symbols->SetMethodOverride(
+      "GetFieldOffset",
+      [](ULONG64 module, ULONG type_id, PCSTR field, PULONG offset) -> HRESULT {
+        return E_FAIL;
+      });
+
+  visualizers::VisualizerEngine engine(&g_debug);
+  std::string output;
+  std::string error;
+  TEST_ASSERT(!engine.RenderValue("media::CdmConfig", 0x2000, output, error));
+  TEST_ASSERT_STRING_CONTAINS(error, "Unable to find field key_system");
+  TEST_ASSERT_EQUALS(0, engine.GetCachedLayoutCount());
+}
+
+TEST(RenderValue_UnreadableMemory) {
+  NativeVisualizersTest test;
+  visualizers::VisualizerEngine engine(&g_debug);
+  std::string output;
+  std::string error;
+
+  TEST_ASSERT(!engine.RenderValue("media::CdmConfig", 0x9000, output, error));
+  TEST_ASSERT_STRING_CONTAINS(error, "Unable to read memory");
+}
+
+TEST(RenderVector_ReadsElementsInBulk) {
+  NativeVisualizersTest test;
+
+  const ULONG64 elements = 0x10000;
+  const size_t count = 100;
+  std::vector<BYTE> element_bytes;
+  for (size_t i = 0; i < count; i++) {
+    auto config = MakeCdmConfig(MakeShortString("ks" + std::to_string(i)),
+                                i % 2 == 0, false, false);
+    element_bytes.insert(element_bytes.end(), config.begin(), config.end());
+  }
+  test.memory.AddRegion(elements, element_bytes);
+  test.memory.AddRegion(0x2000,
+                        MakeVector(elements, elements + element_bytes.size()));
+
+  visualizers::VisualizerEngine engine(&g_debug);
+  std::vector<std::string> output;
+  size_t total_count = 0;
+  std::string error;
+  test.memory.ResetReadCount();
+  TEST_ASSERT(engine.RenderVector("media::CdmConfig", 0x2000, 0, output,
+                                  total_count, error));
+
+  TEST_ASSERT_EQUALS(count, total_count);
+  TEST_ASSERT_EQUALS(count, output.size());
+  TEST_ASSERT_STRING_CONTAINS(output[0], "\"ks0\" AllowDI: 1");
+  TEST_ASSERT_STRING_CONTAINS(output[99], "\"ks99\" AllowDI: 0");
+
+  // One read for the vector header and one for the elements
+  TEST_ASSERT_EQUALS(2, test.memory.GetReadCount());
+}
+
+TEST(RenderVector_MaxCount) {
+  NativeVisualizersTest test;
+
+  const ULONG64 elements = 0x10000;
+  test.memory.AddZeroRegion(elements, kCdmConfigSize * 10);
+  test.memory.AddRegion(0x2000,
+                        MakeVector(elements, elements + kCdmConfigSize * 10));
+
+  visualizers::VisualizerEngine engine(&g_debug);
+  std::vector<std::string> output;
+  size_t total_count = 0;
+  std::string error;
+  TEST_ASSERT(engine.RenderVector("media::CdmConfig", 0x2000, 3, output,
+                                  total_count, error));
+  TEST_ASSERT_EQUALS(10, total_count);
+  TEST_ASSERT_EQUALS(3, output.size());
+}
+
+TEST(RenderVector_InvalidVector) {
+  NativeVisualizersTest test;
+
+  // The span is not a multiple of the element size
+  test.memory.AddRegion(0x2000, MakeVector(0x10000, 0x10000 + 10));
+
+  visualizers::VisualizerEngine engine(&g_debug);
+  std::vector<std::string> output;
+  size_t total_count = 0;
+  std::string error;
+  TEST_ASSERT(!engine.RenderVector("media::CdmConfig", 0x2000, 0, output,
+                                   total_count, error));
+  TEST_ASSERT_STRING_CONTAINS(error, "does not look like a std::vector");
+}
+
+TEST(Visualize_Command) {
+  NativeVisualizersTest test;
+  test.memory.AddRegion(
+      0x2000, MakeCdmConfig(MakeShortString("x"), false, true, false));
+
+  HRESULT hr =
+      VisualizeInternal(test.mock_client, "chrome!media::CdmConfig 0x2000");
+  TEST_ASSERT_EQUALS(S_OK, hr);
+  TEST_ASSERT(test.HasOutputContaining("\"x\" AllowDI: 0 AllowPS: 1"));
+}
+
+TEST(Visualize_Help) {
+  NativeVisualizersTest test;
+
+  HRESULT hr = VisualizeInternal(test.mock_client, "?");
+  TEST_ASSERT_EQUALS(S_OK, hr);
+  TEST_ASSERT(test.HasOutputContaining("Usage: !Visualize"));
+  TEST_ASSERT(test.HasOutputContaining("media::CdmConfig"));
+}
+
+TEST(Visualize_WrongArgumentCount) {
+  NativeVisualizersTest test;
+
+  HRESULT hr = VisualizeInternal(test.mock_client, "media::CdmConfig");
+  TEST_ASSERT_EQUALS(E_INVALIDARG, hr);
+  TEST_ASSERT(test.HasErrorContaining("Expected 2 arguments"));
+}
+
+TEST(VisualizeVector_Command) {
+  NativeVisualizersTest test;
+
+  const ULONG64 elements = 0x10000;
+  test.memory.AddZeroRegion(elements, kCdmConfigSize * 5);
+  test.memory.AddRegion(0x2000,
+                        MakeVector(elements, elements + kCdmConfigSize * 5));
+
+  HRESULT hr =
+      VisualizeVectorInternal(test.mock_client, "media::CdmConfig 0x2000 2");
+  TEST_ASSERT_EQUALS(S_OK, hr);
+  TEST_ASSERT(test.HasOutputContaining("{ size=5 }"));
+  TEST_ASSERT(test.HasOutputContaining("[1]"));
+  TEST_ASSERT(test.HasOutputContaining("... and 3 more"));
+}
+
+TEST(Visualize_LongStringsAreReadThroughTheMemoryCache) {
+  NativeVisualizersTest test;
+
+  std::string long_text(100, 'k');
+  test.memory.AddRegion(0x8000,
+                        std::vector<BYTE>(long_text.begin(), long_text.end()));
+  test.memory.AddRegion(
+      0x2000,
+      MakeCdmConfig(MakeLongString(0x8000, long_text.size()), 0, 0, 0));
+
+  VisualizeInternal(test.mock_client, "media::CdmConfig 0x2000");
+  VisualizeInternal(test.mock_client, "media::CdmConfig 0x2000");
+  TEST_ASSERT(test.HasOutputContaining(long_text));
+
+  // The value and the string are only read from the target once
+  TEST_ASSERT_EQUALS(2, g_memory_cache.GetStatistics().target_reads);
+  TEST_ASSERT_EQUALS(2, g_memory_cache.GetStatistics().hits);
+
+  // Running the target invalidates the cached memory
+  g_memory_cache.OnChangeEngineState(DEBUG_CES_EXECUTION_STATUS,
+                                     DEBUG_STATUS_GO);
+  VisualizeInternal(test.mock_client, "media::CdmConfig 0x2000");
+  TEST_ASSERT_EQUALS(4, g_memory_cache.GetStatistics().target_reads);
+}
+
+TEST(ClearVisualizerCache_Command) {
+  NativeVisualizersTest test;
+  test.memory.AddRegion(
+      0x2000, MakeCdmConfig(MakeShortString("x"), false, false, false));
+
+  VisualizeInternal(test.mock_client, "media::CdmConfig 0x2000");
+  HRESULT hr = ClearVisualizerCacheInternal(test.mock_client, "");
+  TEST_ASSERT_EQUALS(S_OK, hr);
+  TEST_ASSERT(test.HasOutputContaining("Cleared 1 cached type layout(s)"));
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
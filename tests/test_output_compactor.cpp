@@ -0,0 +1,362 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <string>
+#include <vector>
+
+#include "../src/output_compactor.h"
+#include "../src/utils.h"
+#include "unit_test_runner.h"
+
+utils::DebugInterfaces g_debug;
+
+using output_compactor::CompactionStats;
+using output_compactor::Compactor;
+using output_compactor::Lines;
+
+namespace {
+
+// Synthetic "~*k" output modeled on a browser process (8 threads). The
+// addresses are made up and don't match the modules or frames.
+const char kThreadStacks[] = R"(.  0  Id: 3c4.1b30 Suspend: 1 Teb: 00000031`0b100000 Unfrozen
+ # Child-SP          RetAddr               Call Site
+00 00000031`0b3ff5c8 00007ffe`c7d50d8f     win32u!NtUserMsgWaitForMultipleObjectsEx+0x14
+01 00000031`0b3ff648 00007ffe`c7e00c95     USER32!MsgWaitForMultipleObjectsEx+0x9e
+02 00000031`0b3ff688 00007ffe`c7d14d02     chrome!base::MessagePumpForUI::WaitForWork+0x10f
+03 00000031`0b3ff728 00007ffe`c7d92dc3     chrome!base::MessagePumpForUI::DoRunLoop+0xe1
+04 00000031`0b3ff7d8 00007ffe`c7d860c6     chrome!base::MessagePumpWin::Run+0x83
+05 00000031`0b3ff838 00007ffe`c7dfed89     chrome!base::RunLoop::Run+0x1d2
+06 00000031`0b3ff8e8 00007ffe`c7e01f6c     chrome!content::BrowserMainLoop::RunMainMessageLoop+0x8e
+07 00000031`0b3ff978 00007ffe`c7d5b2fc     chrome!content::BrowserMainRunnerImpl::Run+0x1a
+08 00000031`0b3ff9d8 00007ffe`c7d5bb3a     chrome!content::BrowserMain+0xb4
+09 00000031`0b3ffa88 00007ffe`c7dd5b7f     chrome!content::RunBrowserProcessMain+0x6f
+0a 00000031`0b3ffab8 00007ffe`c7d2edae     chrome!ChromeMain+0x1cc
+0b 00000031`0b3ffb08 00007ffe`c7d23faa     chrome_exe!wWinMain+0x6a6
+0c 00000031`0b3ffb78 00007ffe`c7d1df2f     KERNEL32!BaseThreadInitThunk+0x1d
+0d 00000031`0b3ffbe8 00007ffe`c7e001e5     ntdll!RtlUserThreadStart+0x28
+
+   1  Id: 3c4.1d34 Suspend: 1 Teb: 00000031`0b101000 Unfrozen
+ # Child-SP          RetAddr               Call Site
+00 00000031`0b4ff5c8 00007ffe`c7dd84ad     ntdll!NtRemoveIoCompletion+0x14
+01 00000031`0b4ff668 00007ffe`c7d52c16     KERNELBASE!GetQueuedCompletionStatus+0x4f
+02 00000031`0b4ff6e8 00007ffe`c7d3ff7b     chrome!base::MessagePumpForIO::GetIOItem+0x6e
+03 00000031`0b4ff718 00007ffe`c7d53afe     chrome!base::MessagePumpForIO::WaitForIOCompletion+0x33
+04 00000031`0b4ff7b8 00007ffe`c7d7d2b1     chrome!base::MessagePumpForIO::DoRunLoop+0x11d
+05 00000031`0b4ff828 00007ffe`c7ded62c     chrome!base::MessagePumpWin::Run+0x83
+06 00000031`0b4ff898 00007ffe`c7de5b2f     chrome!base::RunLoop::Run+0x1d2
+07 00000031`0b4ff948 00007ffe`c7dd3a27     chrome!base::Thread::Run+0x3b
+08 00000031`0b4ff9c8 00007ffe`c7ddebff     chrome!base::Thread::ThreadMain+0x1a9
+09 00000031`0b4ffa28 00007ffe`c7dba7ea     chrome!base::`anonymous namespace'::ThreadFunc+0x11b
+0a 00000031`0b4ffa58 00007ffe`c7d9d452     KERNEL32!BaseThreadInitThunk+0x1d
+0b 00000031`0b4ffaa8 00007ffe`c7db52ed     ntdll!RtlUserThreadStart+0x28
+
+   2  Id: 3c4.1a38 Suspend: 1 Teb: 00000031`0b102000 Unfrozen
+ # Child-SP          RetAddr               Call Site
+00 00000031`0b5ff5c8 00007ffe`c7d7a2ac     ntdll!NtWaitForMultipleObjects+0x14
+01 00000031`0b5ff638 00007ffe`c7d9ff82     KERNELBASE!WaitForMultipleObjectsEx+0xf0
+02 00000031`0b5ff678 00007ffe`c7d2e901     chrome!base::WaitableEvent::TimedWaitMultiple+0x1a3
+03 00000031`0b5ff718 00007ffe`c7e05a0a     chrome!base::internal::WorkerThread::Delegate::WaitForWork+0x7e
+04 00000031`0b5ff758 00007ffe`c7dbe3d7     chrome!base::internal::WorkerThread::RunWorker+0x3ca
+05 00000031`0b5ff798 00007ffe`c7de03a3     chrome!base::internal::WorkerThread::RunPooledWorker+0x1a
+06 00000031`0b5ff7e8 00007ffe`c7d18600     chrome!base::internal::WorkerThread::ThreadMain+0xbc
+07 00000031`0b5ff858 00007ffe`c7de8c48     chrome!base::`anonymous namespace'::ThreadFunc+0x11b
+08 00000031`0b5ff8e8 00007ffe`c7d4af4e     KERNEL32!BaseThreadInitThunk+0x1d
+09 00000031`0b5ff918 00007ffe`c7d25149     ntdll!RtlUserThreadStart+0x28
+
+   3  Id: 3c4.1c3c Suspend: 1 Teb: 00000031`0b103000 Unfrozen
+ # Child-SP          RetAddr               Call Site
+00 00000031`0b6ff5c8 00007ffe`c7d9cf4e     ntdll!NtWaitForMultipleObjects+0x14
+01 00000031`0b6ff678 00007ffe`c7d86e0d     KERNELBASE!WaitForMultipleObjectsEx+0xf0
+02 00000031`0b6ff6a8 00007ffe`c7dac9f4     chrome!base::WaitableEvent::TimedWaitMultiple+0x1a3
+03 00000031`0b6ff6d8 00007ffe`c7d357ae     chrome!base::internal::WorkerThread::Delegate::WaitForWork+0x7e
+04 00000031`0b6ff718 00007ffe`c7d1e22e     chrome!base::internal::WorkerThread::RunWorker+0x3ca
+05 00000031`0b6ff778 00007ffe`c7ddeef3     chrome!base::internal::WorkerThread::RunPooledWorker+0x1a
+06 00000031`0b6ff7e8 00007ffe`c7d94eb0     chrome!base::internal::WorkerThread::ThreadMain+0xbc
+07 00000031`0b6ff838 00007ffe`c7d23cc5     chrome!base::`anonymous namespace'::ThreadFunc+0x11b
+08 00000031`0b6ff8b8 00007ffe`c7daec09     KERNEL32!BaseThreadInitThunk+0x1d
+09 00000031`0b6ff938 00007ffe`c7d54e4d     ntdll!RtlUserThreadStart+0x28
+
+   4  Id: 3c4.1d40 Suspend: 1 Teb: 00000031`0b104000 Unfrozen
+ # Child-SP          RetAddr               Call Site
+00 00000031`0b7ff5c8 00007ffe`c7df9ccf     ntdll!NtWaitForWorkViaWorkerFactory+0x14
+01 00000031`0b7ff678 00007ffe`c7dd3cd4     ntdll!TppWorkerThread+0x2f4
+02 00000031`0b7ff728 00007ffe`c7d42969     KERNEL32!BaseThreadInitThunk+0x1d
+03 00000031`0b7ff7d8 00007ffe`c7d98fa1     ntdll!RtlUserThreadStart+0x28
+
+   5  Id: 3c4.1b44 Suspend: 1 Teb: 00000031`0b105000 Unfrozen
+ # Child-SP          RetAddr               Call Site
+00 00000031`0b8ff5c8 00007ffe`c7da83a3     ntdll!NtWaitForMultipleObjects+0x14
+01 00000031`0b8ff658 00007ffe`c7d92494     KERNELBASE!WaitForMultipleObjectsEx+0xf0
+02 00000031`0b8ff708 00007ffe`c7da9341     chrome!base::WaitableEvent::TimedWaitMultiple+0x1a3
+03 00000031`0b8ff7b8 00007ffe`c7dbb978     chrome!base::internal::WorkerThread::Delegate::WaitForWork+0x7e
+04 00000031`0b8ff7e8 00007ffe`c7de2a8a     chrome!base::internal::WorkerThread::RunWorker+0x3ca
+05 00000031`0b8ff868 00007ffe`c7d18568     chrome!base::internal::WorkerThread::RunPooledWorker+0x1a
+06 00000031`0b8ff8f8 00007ffe`c7d524df     chrome!base::internal::WorkerThread::ThreadMain+0xbc
+07 00000031`0b8ff928 00007ffe`c7db8492     chrome!base::`anonymous namespace'::ThreadFunc+0x11b
+08 00000031`0b8ff9c8 00007ffe`c7dc2c39     KERNEL32!BaseThreadInitThunk+0x1d
+09 00000031`0b8ffa48 00007ffe`c7d9ce15     ntdll!RtlUserThreadStart+0x28
+
+   6  Id: 3c4.1a48 Suspend: 1 Teb: 00000031`0b106000 Unfrozen
+ # Child-SP          RetAddr               Call Site
+00 00000031`0b9ff5c8 00007ffe`c7d2d161     ntdll!NtWaitForMultipleObjects+0x14
+01 00000031`0b9ff5f8 00007ffe`c7dcb155     KERNELBASE!WaitForMultipleObjectsEx+0xf0
+02 00000031`0b9ff668 00007ffe`c7df7b3e     chrome!base::WaitableEvent::TimedWaitMultiple+0x1a3
+03 00000031`0b9ff6d8 00007ffe`c7db1ec8     chrome!base::internal::WorkerThread::Delegate::WaitForWork+0x7e
+04 00000031`0b9ff728 00007ffe`c7dc86a8     chrome!base::internal::WorkerThread::RunWorker+0x3ca
+05 00000031`0b9ff778 00007ffe`c7dae288     chrome!base::internal::WorkerThread::RunPooledWorker+0x1a
+06 00000031`0b9ff7f8 00007ffe`c7d954f2     chrome!base::internal::WorkerThread::ThreadMain+0xbc
+07 00000031`0b9ff868 00007ffe`c7dcf2d5     chrome!base::`anonymous namespace'::ThreadFunc+0x11b
+08 00000031`0b9ff8a8 00007ffe`c7d1bdac     KERNEL32!BaseThreadInitThunk+0x1d
+09 00000031`0b9ff8f8 00007ffe`c7dacccb     ntdll!RtlUserThreadStart+0x28
+
+   7  Id: 3c4.1b4c Suspend: 1 Teb: 00000031`0b107000 Unfrozen
+ # Child-SP          RetAddr               Call Site
+00 00000031`0baff5c8 00007ffe`c7d97fe1     ntdll!NtWaitForWorkViaWorkerFactory+0x14
+01 00000031`0baff628 00007ffe`c7db5e5c     ntdll!TppWorkerThread+0x2f4
+02 00000031`0baff678 00007ffe`c7dece93     KERNEL32!BaseThreadInitThunk+0x1d
+03 00000031`0baff6b8 00007ffe`c7d4236c     ntdll!RtlUserThreadStart+0x28
+)";
+
+// Synthetic "db @rsp L100" output.
+const char kMemoryDump[] =
+    R"(00000031`0b3ff5c8  8f 0d d5 c7 fe 7f 00 00-10 00 00 00 00 00 00 00  ................
+00000031`0b3ff5d8  00 00 00 00 00 00 00 00-00 00 00 00 00 00 00 00  ................
+00000031`0b3ff5e8  00 00 00 00 00 00 00 00-00 00 00 00 00 00 00 00  ................
+00000031`0b3ff5f8  00 00 00 00 00 00 00 00-00 00 00 00 00 00 00 00  ................
+00000031`0b3ff608  00 00 00 00 00 00 00 00-00 00 00 00 00 00 00 00  ................
+00000031`0b3ff618  00 00 00 00 00 00 00 00-00 00 00 00 00 00 00 00  ................
+00000031`0b3ff628  00 00 00 00 00 00 00 00-00 00 00 00 00 00 00 00  ................
+00000031`0b3ff638  00 00 00 00 00 00 00 00-00 00 00 00 00 00 00 00  ................
+00000031`0b3ff648  95 0c e0 c7 fe 7f 00 00-00 00 00 00 00 00 00 00  ................
+00000031`0b3ff658  ff ff ff ff 00 00 00 00-30 f7 3f 0b 31 00 00 00  ........0.?.1...
+00000031`0b3ff668  00 00 00 00 00 00 00 00-00 00 00 00 00 00 00 00  ................
+00000031`0b3ff678  00 00 00 00 00 00 00 00-00 00 00 00 00 00 00 00  ................
+00000031`0b3ff688  02 4d d1 c7 fe 7f 00 00-00 00 00 00 00 00 00 00  .M..............
+00000031`0b3ff698  00 00 00 00 00 00 00 00-00 00 00 00 00 00 00 00  ................
+00000031`0b3ff6a8  00 00 00 00 00 00 00 00-00 00 00 00 00 00 00 00  ................
+00000031`0b3ff6b8  00 00 00 00 00 00 00 00-00 00 00 00 00 00 00 00  ................
+)";
+
+// Synthetic output of "g" until the first breakpoint in a renderer.
+const char kModuleLoads[] =
+    R"(ModLoad: 00007ff6`12340000 00007ff6`1249c000   D:\cs\src\out\release_x64\chrome.exe
+ModLoad: 00007ffe`c7d00000 00007ffe`c7f68000   C:\Windows\SYSTEM32\ntdll.dll
+ModLoad: 00007ffe`c6a10000 00007ffe`c6ad9000   C:\Windows\System32\KERNEL32.DLL
+ModLoad: 00007ffe`c4f70000 00007ffe`c5357000   C:\Windows\System32\KERNELBASE.dll
+ModLoad: 00007ffe`c5ce0000 00007ffe`c5e8b000   C:\Windows\System32\USER32.dll
+ModLoad: 00007ffe`c5700000 00007ffe`c5727000   C:\Windows\System32\win32u.dll
+ModLoad: 00007ffe`c6ae0000 00007ffe`c6b0b000   C:\Windows\System32\GDI32.dll
+ModLoad: 00007ffe`c5390000 00007ffe`c54bb000   C:\Windows\System32\gdi32full.dll
+ModLoad: 00007ffe`c5530000 00007ffe`c55d3000   C:\Windows\System32\msvcp_win.dll
+ModLoad: 00007ffe`c5590000 00007ffe`c56e1000   C:\Windows\System32\ucrtbase.dll
+ModLoad: 00007ffe`c3a80000 00007ffe`c3aa6000   D:\cs\src\out\release_x64\chrome_elf.dll
+ModLoad: 00007ffe`c6430000 00007ffe`c64e2000   C:\Windows\System32\ADVAPI32.dll
+ModLoad: 00007ffe`c6f20000 00007ffe`c6fc7000   C:\Windows\System32\msvcrt.dll
+ModLoad: 00007ffe`c6770000 00007ffe`c6816000   C:\Windows\System32\sechost.dll
+ModLoad: 00007ffe`c5ab0000 00007ffe`c5bc7000   C:\Windows\System32\RPCRT4.dll
+ModLoad: 00007ff9`a2f00000 00007ff9`b27a1000   D:\cs\src\out\release_x64\chrome.dll
+Breakpoint 0 hit
+chrome!content::RendererMain:
+00007ff9`a5b1e2c0 4055            push    rbp
+)";
+
+size_t CountLines(const std::string& text, const std::string& needle) {
+  size_t count = 0;
+  for (size_t pos = text.find(needle); pos != std::string::npos;
+       pos = text.find(needle, pos + 1)) {
+    count++;
+  }
+  return count;
+}
+
+}  // namespace
+
+DECLARE_TEST_RUNNER()
+
+TEST(FoldRepeatedLines_Runs) {
+  Lines lines = {"a", "b", "b", "b", "b", "c", "c", "", "", "", "d"};
+  Lines result = output_compactor::FoldRepeatedLines(lines);
+
+  // Runs of 2 and empty lines are not folded.
+  Lines expected = {"a", "b", "  (previous line repeated 3 more times)",
+                    "c", "c", "", "", "", "d"};
+  TEST_ASSERT(expected == result);
+}
+
+TEST(FoldModuleLoads_KeepsAddressRanges) {
+  Lines lines = output_compactor::FoldModuleLoads(
+      {"ModLoad: 00007ffe`c7d00000 00007ffe`c7f68000   C:\\Windows\\ntdll.dll",
+       "ModLoad: 00007ffe`c6a10000 00007ffe`c6ad9000   C:\\Windows\\KERNEL32.DLL",
+       "ModLoad: 00007ffe`c4f70000 00007ffe`c5357000   C:\\Windows\\USER32.dll",
+       "Breakpoint 0 hit"});
+  TEST_ASSERT_EQUALS(2, lines.size());
+  TEST_ASSERT_EQUALS(
+      std::string("ModLoad: 3 modules: "
+                  "ntdll.dll 00007ffe`c7d00000-00007ffe`c7f68000, "
+                  "KERNEL32.DLL 00007ffe`c6a10000-00007ffe`c6ad9000, "
+                  "USER32.dll 00007ffe`c4f70000-00007ffe`c5357000"),
+      lines[0]);
+
+  // File names with spaces are kept whole.
+  lines = output_compactor::FoldModuleLoads(
+      {"ModLoad: 00000000`10000000 00000000`10010000   C:\\a b\\c d.dll",
+       "ModLoad: 00000000`10010000 00000000`10020000   C:\\e.dll",
+       "ModLoad: 00000000`10020000 00000000`10030000   C:\\f.dll\r"});
+  TEST_ASSERT_EQUALS(
+      std::string("ModLoad: 3 modules: "
+                  "c d.dll 00000000`10000000-00000000`10010000, "
+                  "e.dll 00000000`10010000-00000000`10020000, "
+                  "f.dll 00000000`10020000-00000000`10030000"),
+      lines[0]);
+
+  // Short runs are left alone.
+  Lines short_run = {"ModLoad: 00007ffe`c7d00000 00007ffe`c7f68000   a.dll",
+                     "ModLoad: 00007ffe`c6a10000 00007ffe`c6ad9000   b.dll"};
+  TEST_ASSERT(short_run == output_compactor::FoldModuleLoads(short_run));
+}
+
+TEST(CollapseZeroRows_KeepsFirstAndLastRow) {
+  Lines lines = output_compactor::CollapseZeroRows(
+      {"00000031`0b3ff5c8  00000001 00000000 00000000 00000000",
+       "00000031`0b3ff5d8  00000000 00000000 00000000 00000000",
+       "00000031`0b3ff5e8  00000000 00000000 00000000 00000000",
+       "00000031`0b3ff5f8  00000000 00000000 00000000 00000000",
+       "00000031`0b3ff608  00000000 00000000 00000000 00000000",
+       "00000031`0b3ff618  00000000`00000000 00000000`00000000",
+       "00000031`0b3ff628  00000000 00000002 00000000 00000000"});
+
+  TEST_ASSERT_EQUALS(5, lines.size());
+  TEST_ASSERT_EQUALS(
+      std::string("00000031`0b3ff5d8  00000000 00000000 00000000 00000000"),
+      lines[1]);
+  TEST_ASSERT_EQUALS(std::string("                   ... 3 more zero rows ..."),
+                     lines[2]);
+  TEST_ASSERT_EQUALS(
+      std::string("00000031`0b3ff618  00000000`00000000 00000000`00000000"),
+      lines[3]);
+}
+
+TEST(CollapseZeroRows_IgnoresOtherOutput) {
+  // Stack frames and registers start with zeros but are not dump rows.
+  Lines lines = {"00 00000031`0b3ff5c8 00000000`00000000     ntdll!Foo",
+                 "00 00000031`0b3ff5c8 00000000`00000000     ntdll!Foo",
+                 "00 00000031`0b3ff5c8 00000000`00000000     ntdll!Foo",
+                 "rax=0000000000000000 rbx=0000000000000000",
+                 "rax=0000000000000000 rbx=0000000000000000",
+                 "rax=0000000000000000 rbx=0000000000000000"};
+  TEST_ASSERT(lines == output_compactor::CollapseZeroRows(lines));
+}
+
+TEST(CollapseZeroRows_VeryLongLines) {
+  // Rows of a few hundred KB, e.g. from a long db or string dump.
+  std::string zeros;
+  std::string values;
+  for (int i = 0; i < 100000; i++) {
+    zeros += " 00";
+    values += " 41";
+  }
+  Lines lines = {"00000031`0b3ff5c8 " + zeros, "00000031`0b3ff5d8 " + zeros,
+                 "00000031`0b3ff5e8 " + zeros, "00000031`0b3ff5f8 " + zeros,
+                 "00000031`0b3ff608 " + values};
+
+  Lines result = output_compactor::CollapseZeroRows(lines);
+  TEST_ASSERT_EQUALS(4, result.size());
+  TEST_ASSERT_EQUALS(std::string("                   ... 2 more zero rows ..."),
+                     result[1]);
+  TEST_ASSERT(lines.back() == result.back());
+}
+
+TEST(GroupThreadStacks_SyntheticOutput) {
+  std::string output = kThreadStacks;
+  Lines lines;
+  size_t start = 0;
+  for (size_t end = output.find('\n'); end != std::string::npos;
+       end = output.find('\n', start = end + 1)) {
+    lines.push_back(output.substr(start, end - start));
+  }
+
+  Lines result = output_compactor::GroupThreadStacks(lines);
+  std::string text;
+  for (const std::string& line : result) {
+    text += line + "\n";
+  }
+
+  // 4 distinct stacks.
+  TEST_ASSERT_EQUALS(4, CountLines(text, "Call Site"));
+  TEST_ASSERT_STRING_CONTAINS(text,
+                              "09 00000031`0b5ff918 00007ffe`c7d25149     "
+                              "ntdll!RtlUserThreadStart+0x28\n"
+                              "  (same call stack in 3 other threads: "
+                              "3 (3c4.1c3c), 5 (3c4.1b44), 6 (3c4.1a48))\n\n");
+  TEST_ASSERT_STRING_CONTAINS(
+      text, "  (same call stack in 1 other thread: 7 (3c4.1b4c))\n");
+  TEST_ASSERT(text.find("Id: 3c4.1c3c") == std::string::npos);
+
+  // Threads with different stacks are unchanged.
+  TEST_ASSERT_STRING_CONTAINS(
+      text, "   1  Id: 3c4.1d34 Suspend: 1 Teb: 00000031`0b101000 Unfrozen\n");
+}
+
+TEST(GroupThreadStacks_SingleThread) {
+  Lines lines = {"Child-SP          RetAddr               Call Site",
+                 "00 00000031`0b3ff5c8 00007ffe`c7d0e123     ntdll!Foo+0x14"};
+  TEST_ASSERT(lines == output_compactor::GroupThreadStacks(lines));
+}
+
+TEST(Compactor_Reductions) {
+  Compactor compactor;
+  compactor.AddDefaultPasses();
+
+  std::string stacks = compactor.Compact(kThreadStacks);
+  std::string memory = compactor.Compact(kMemoryDump);
+  std::string modules = compactor.Compact(kModuleLoads);
+
+  // The reductions of these synthetic outputs are 46% for the stacks,
+  // 31% for the memory dump and 35% for the module loads.
+  TEST_ASSERT(stacks.size() * 100 < sizeof(kThreadStacks) * 60);
+  TEST_ASSERT(memory.size() * 100 < sizeof(kMemoryDump) * 75);
+  TEST_ASSERT(modules.size() * 100 < sizeof(kModuleLoads) * 70);
+
+  TEST_ASSERT_STRING_CONTAINS(
+      modules,
+      "ModLoad: 16 modules: chrome.exe 00007ff6`12340000-00007ff6`1249c000, "
+      "ntdll.dll 00007ffe`c7d00000-00007ffe`c7f68000");
+  TEST_ASSERT_STRING_CONTAINS(
+      modules,
+      "chrome.dll 00007ff9`a2f00000-00007ff9`b27a1000\nBreakpoint 0 hit\n");
+  TEST_ASSERT_EQUALS('\n', memory.back());
+
+  CompactionStats stats = compactor.GetStats();
+  TEST_ASSERT_EQUALS(3, stats.outputs);
+  TEST_ASSERT_EQUALS(
+      sizeof(kThreadStacks) + sizeof(kMemoryDump) + sizeof(kModuleLoads) - 3,
+      stats.input_bytes);
+  TEST_ASSERT_EQUALS(stacks.size() + memory.size() + modules.size(),
+                     stats.output_bytes);
+  TEST_ASSERT_EQUALS(4, stats.passes.size());
+  TEST_ASSERT_EQUALS(std::string("module_loads"), stats.passes[0].name);
+  TEST_ASSERT_EQUALS(1, stats.passes[0].applied_count);
+  TEST_ASSERT_EQUALS(0, stats.passes[1].applied_count);
+  TEST_ASSERT_EQUALS(1, stats.passes[2].applied_count);
+  TEST_ASSERT_EQUALS(1, stats.passes[3].applied_count);
+}
+
+TEST(Compactor_CustomPass) {
+  Compactor compactor;
+  compactor.AddPass("drop_empty", [](const Lines& lines) {
+    Lines result;
+    for (const std::string& line : lines) {
+      if (!line.empty()) {
+        result.push_back(line);
+      }
+    }
+    return result;
+  });
+
+  TEST_ASSERT_EQUALS(std::string("a\nb"), compactor.Compact("a\n\n\nb"));
+  TEST_ASSERT_EQUALS(std::string(""), compactor.Compact(""));
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
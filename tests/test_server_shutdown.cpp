@@ -0,0 +1,241 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include "../src/command_queue.h"
+#include "../src/mcp_protocol.h"
+#include "../src/mcp_transport.h"
+#include "../src/server_shutdown.h"
+#include "mcp_test_client.h"
+#include "unit_test_runner.h"
+
+using command_queue::CommandQueue;
+using command_queue::Operation;
+using mcp_protocol::Request;
+using mcp_transport::ClientId;
+using mcp_transport::SocketServer;
+
+namespace {
+
+// Stands in for the debugger engine. "g" runs until the target is
+// interrupted (or released, for an engine which ignores interrupts)
+// and "k" returns right away. Both run on the command queue like the
+// tools of the MCP server.
+struct MockEngine {
+  std::atomic<bool> interrupted{false};
+  std::atomic<bool> released{false};
+  std::atomic<bool> running{false};
+  std::chrono::milliseconds go_time{0};
+
+  JSON Run(const std::string& command) {
+    if (command != "g") {
+      return {{"output", command}};
+    }
+
+    running = true;
+    auto start = std::chrono::steady_clock::now();
+    while (!interrupted && !released &&
+           (go_time.count() == 0 ||
+            std::chrono::steady_clock::now() - start < go_time)) {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return {{"output", interrupted ? "interrupted" : "break"}};
+  }
+};
+
+// Runs the method of each request as a command of the mock engine.
+struct MockServer {
+  SocketServer transport;
+  CommandQueue queue;
+  MockEngine engine;
+
+  bool Start() {
+    queue.Start();
+    return transport.Start(0, [this](const Request& request, ClientId client) {
+      Operation run = [this, method = request.method]() {
+        return engine.Run(method);
+      };
+      return mcp_protocol::CreateResponse(request.id,
+                                          queue.Execute(run, client));
+    });
+  }
+};
+
+std::string MakeRequest(int id, const std::string& method) {
+  return JSON{{"jsonrpc", "2.0"}, {"id", id}, {"method", method}}.dump() +
+         "\n";
+}
+
+bool WaitFor(const std::function<bool()>& condition) {
+  for (int i = 0; i < 200 && !condition(); i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  return condition();
+}
+
+// Receives the shutdown notification and then the response.
+bool ReceiveShutdown(McpTestClient& client, JSON& response) {
+  std::string message;
+  if (!client.Receive(message) ||
+      JSON::parse(message)["method"] != "notifications/message" ||
+      !client.Receive(message)) {
+    return false;
+  }
+  response = JSON::parse(message);
+  return true;
+}
+
+}  // namespace
+
+DECLARE_TEST_RUNNER()
+
+TEST(Shutdown_DrainsRequests) {
+  MockServer server;
+  server.engine.go_time = std::chrono::milliseconds(200);
+  TEST_ASSERT(server.Start());
+  int port = server.transport.GetPort();
+
+  McpTestClient first;
+  McpTestClient second;
+  TEST_ASSERT(first.Connect("127.0.0.1", port));
+  TEST_ASSERT(second.Connect("127.0.0.1", port));
+  TEST_ASSERT(
+      WaitFor([&]() { return server.transport.GetClientCount() == 2; }));
+
+  TEST_ASSERT(first.Send(MakeRequest(1, "g")));
+  TEST_ASSERT(WaitFor([&]() { return server.engine.running.load(); }));
+
+  server_shutdown::Result result;
+  std::thread shutdown([&]() {
+    result = server_shutdown::Shutdown(server.transport, server.queue, {});
+  });
+
+  // Requests which are sent while draining are refused.
+  std::string message;
+  TEST_ASSERT(second.Receive(message));
+  TEST_ASSERT_EQUALS(std::string(server_shutdown::kShutdownMessage),
+                     JSON::parse(message)["params"]["data"]);
+  TEST_ASSERT(second.Send(MakeRequest(2, "k")));
+  TEST_ASSERT(second.Receive(message));
+  TEST_ASSERT_EQUALS(std::string(server_shutdown::kShutdownMessage),
+                     JSON::parse(message)["result"]["error"]);
+
+  // The request in progress finishes.
+  JSON response;
+  TEST_ASSERT(ReceiveShutdown(first, response));
+  TEST_ASSERT_EQUALS(std::string("break"), response["result"]["output"]);
+
+  shutdown.join();
+  TEST_ASSERT(result.drained);
+  TEST_ASSERT(!result.interrupted);
+  TEST_ASSERT_EQUALS(0, result.cancelled);
+  TEST_ASSERT(result.completed);
+  TEST_ASSERT(!server.transport.IsRunning());
+  TEST_ASSERT(!first.Receive(message));
+
+  McpTestClient late;
+  TEST_ASSERT(!late.Connect("127.0.0.1", port));
+}
+
+// The queue thread has to be joined even when nothing is left to
+// drain, which mustn't be cut short by the drain taking no time.
+TEST(Shutdown_CompletedWhenDrained) {
+  for (int i = 0; i < 50; i++) {
+    MockServer server;
+    TEST_ASSERT(server.Start());
+
+    McpTestClient client;
+    TEST_ASSERT(client.Connect("127.0.0.1", server.transport.GetPort()));
+    TEST_ASSERT(client.Send(MakeRequest(1, "k")));
+    std::string message;
+    TEST_ASSERT(client.Receive(message));
+    TEST_ASSERT_EQUALS(std::string("k"),
+                       JSON::parse(message)["result"]["output"]);
+
+    server_shutdown::Result result =
+        server_shutdown::Shutdown(server.transport, server.queue, {});
+    TEST_ASSERT(result.drained);
+    TEST_ASSERT(result.completed);
+  }
+}
+
+TEST(Shutdown_InterruptsEngine) {
+  MockServer server;
+  TEST_ASSERT(server.Start());
+
+  McpTestClient first;
+  McpTestClient second;
+  TEST_ASSERT(first.Connect("127.0.0.1", server.transport.GetPort()));
+  TEST_ASSERT(second.Connect("127.0.0.1", server.transport.GetPort()));
+
+  // "k" is queued behind a "g" which doesn't return by itself.
+  TEST_ASSERT(first.Send(MakeRequest(1, "g")));
+  TEST_ASSERT(WaitFor([&]() { return server.engine.running.load(); }));
+  TEST_ASSERT(second.Send(MakeRequest(2, "k")));
+  TEST_ASSERT(WaitFor([&]() { return server.queue.GetStats().depth == 1; }));
+
+  server_shutdown::Options options;
+  options.drain_timeout = std::chrono::milliseconds(100);
+  options.interrupt = [&]() { server.engine.interrupted = true; };
+  server_shutdown::Result result =
+      server_shutdown::Shutdown(server.transport, server.queue, options);
+
+  TEST_ASSERT(!result.drained);
+  TEST_ASSERT(result.interrupted);
+  TEST_ASSERT_EQUALS(1, result.cancelled);
+  TEST_ASSERT(result.completed);
+
+  JSON response;
+  TEST_ASSERT(ReceiveShutdown(first, response));
+  TEST_ASSERT_EQUALS(std::string("interrupted"), response["result"]["output"]);
+  TEST_ASSERT(ReceiveShutdown(second, response));
+  TEST_ASSERT_EQUALS(2, response["id"].get<int>());
+  TEST_ASSERT_EQUALS(std::string(server_shutdown::kShutdownMessage),
+                     response["result"]["error"]);
+}
+
+TEST(Shutdown_BoundedWhenInterruptIgnored) {
+  // Leaked like the MCP server is when its threads don't stop.
+  MockServer* server = new MockServer();
+  TEST_ASSERT(server->Start());
+
+  McpTestClient client;
+  TEST_ASSERT(client.Connect("127.0.0.1", server->transport.GetPort()));
+  TEST_ASSERT(client.Send(MakeRequest(1, "g")));
+  TEST_ASSERT(WaitFor([&]() { return server->engine.running.load(); }));
+
+  server_shutdown::Options options;
+  options.drain_timeout = std::chrono::milliseconds(50);
+  options.interrupt_timeout = std::chrono::milliseconds(50);
+  options.close_timeout = std::chrono::milliseconds(50);
+  options.interrupt = []() {};
+
+  auto start = std::chrono::steady_clock::now();
+  server_shutdown::Result result =
+      server_shutdown::Shutdown(server->transport, server->queue, options);
+  auto elapsed = std::chrono::steady_clock::now() - start;
+
+  TEST_ASSERT(!result.drained);
+  TEST_ASSERT(result.interrupted);
+  TEST_ASSERT(!result.completed);
+  TEST_ASSERT(elapsed < std::chrono::seconds(1));
+  TEST_ASSERT(!server->transport.IsRunning());
+
+  // The connection was shut down even though its thread still runs.
+  std::string message;
+  TEST_ASSERT(client.Receive(message));
+  TEST_ASSERT(!client.Receive(message));
+
+  // Let the threads finish before the test exits.
+  server->engine.released = true;
+  TEST_ASSERT(
+      WaitFor([&]() { return server->transport.GetClientCount() == 0; }));
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,203 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "../src/source_search.h"
+#include "unit_test_runner.h"
+
+using source_search::ExtractRequiredLiteral;
+using source_search::SearchOptions;
+using source_search::SearchResult;
+
+namespace {
+
+std::filesystem::path CreateTempDirectory(const std::string& name) {
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / ("test_source_search_" + name);
+  std::filesystem::remove_all(path);
+  std::filesystem::create_directories(path);
+  return path;
+}
+
+void WriteFile(const std::filesystem::path& path, const std::string& contents) {
+  std::filesystem::create_directories(path.parent_path());
+  std::ofstream file(path, std::ios::binary);
+  file << contents;
+}
+
+// A small source tree:
+//   media/decoder.cc       - two matches
+//   media/decoder.h        - one match
+//   media/gpu/gpu_video.cc - one match with \r\n line endings
+//   media/notes.txt        - not a source file
+//   .git/objects.cc        - hidden directory
+std::filesystem::path CreateSourceTree(const std::string& name) {
+  std::filesystem::path root = CreateTempDirectory(name);
+
+  WriteFile(root / "media" / "decoder.cc",
+            "#include \"media/decoder.h\"\n"
+            "\n"
+            "void Decoder::OnDataReceived(int size) {\n"
+            "  // OnDataReceived is called by the demuxer.\n"
+            "}\n"
+            "\n"
+            "void Decoder::Reset() {}\n"
+            "void  Decoder::OnDataReceived() {}\n"
+            "  decoder.Decoder::OnDataReceived(0);\n");
+  WriteFile(root / "media" / "decoder.h",
+            "class Decoder {\n"
+            " public:\n"
+            "  void OnDataReceived(int size);\n"
+            "};\n");
+  WriteFile(root / "media" / "gpu" / "gpu_video.cc",
+            "// Copyright\r\n"
+            "void GpuVideo::OnDataReceived(int size) {\r\n"
+            "}\r\n");
+  WriteFile(root / "media" / "notes.txt",
+            "void Decoder::OnDataReceived(int size) {\n");
+  WriteFile(root / ".git" / "objects.cc",
+            "void Decoder::OnDataReceived(int size) {\n");
+
+  return root;
+}
+
+}  // namespace
+
+DECLARE_TEST_RUNNER()
+
+TEST(ExtractRequiredLiteral_LongestRun) {
+  TEST_ASSERT_EQUALS(std::string("::OnDataReceived("),
+                     ExtractRequiredLiteral(R"(void\s+\w+::OnDataReceived\()"));
+  TEST_ASSERT_EQUALS(std::string("Decoder"), ExtractRequiredLiteral("Decoder"));
+  TEST_ASSERT_EQUALS(std::string("Reset"),
+                     ExtractRequiredLiteral(R"(^\s*Reset\s*\(\)$)"));
+  TEST_ASSERT_EQUALS(std::string("media::Decoder"),
+                     ExtractRequiredLiteral(R"(media::Decoder)"));
+}
+
+TEST(ExtractRequiredLiteral_QuantifiersAndGroups) {
+  // The 's' is optional.
+  TEST_ASSERT_EQUALS(std::string("Buffer"),
+                     ExtractRequiredLiteral("Buffers?"));
+  // The last 'o' is required at least once.
+  TEST_ASSERT_EQUALS(std::string("Fooo"), ExtractRequiredLiteral("Fooo+ba"));
+  TEST_ASSERT_EQUALS(std::string("Frame"),
+                     ExtractRequiredLiteral("(Render|Child)Frame"));
+  TEST_ASSERT_EQUALS(std::string("Frame"),
+                     ExtractRequiredLiteral("[A-Z]+Frame[0-9]{2}"));
+  TEST_ASSERT_EQUALS(std::string("abc"), ExtractRequiredLiteral(R"(\x41abc)"));
+  TEST_ASSERT_EQUALS(std::string("a.b"), ExtractRequiredLiteral(R"(a\.b)"));
+
+  // Counts which don't fit in an int are still required.
+  TEST_ASSERT_EQUALS(std::string("Fooo"),
+                     ExtractRequiredLiteral("Fooo{3000000000,}"));
+  TEST_ASSERT_EQUALS(std::string("Fooo"),
+                     ExtractRequiredLiteral("Fooo{99999999999999999999}?x"));
+
+  // Nothing is required by every alternative.
+  TEST_ASSERT_EQUALS(std::string(""), ExtractRequiredLiteral("Decode|Encode"));
+  TEST_ASSERT_EQUALS(std::string(""), ExtractRequiredLiteral(R"(\w+\s*\d)"));
+}
+
+TEST(Search_FindsMatchingLines) {
+  std::filesystem::path root = CreateSourceTree("matches");
+
+  SearchResult result =
+      source_search::Search(root.string(), R"(void\s+\w+::OnDataReceived\()");
+  TEST_ASSERT(result.error.empty());
+  TEST_ASSERT_EQUALS(std::string("::OnDataReceived("), result.literal);
+  TEST_ASSERT(!result.truncated);
+
+  // Only the lines with the literal are checked and the call doesn't
+  // match the regex. notes.txt and .git are skipped.
+  TEST_ASSERT_EQUALS(3, result.matches.size());
+  TEST_ASSERT_EQUALS(3, result.files_searched);
+  TEST_ASSERT_EQUALS(4, result.lines_checked);
+
+  TEST_ASSERT_STRING_CONTAINS(result.matches[0].path, "decoder.cc");
+  TEST_ASSERT_EQUALS(3, result.matches[0].line);
+  TEST_ASSERT_EQUALS(std::string("void Decoder::OnDataReceived(int size) {"),
+                     result.matches[0].text);
+  TEST_ASSERT_STRING_CONTAINS(result.matches[1].path, "decoder.cc");
+  TEST_ASSERT_EQUALS(8, result.matches[1].line);
+  TEST_ASSERT_STRING_CONTAINS(result.matches[2].path, "gpu_video.cc");
+  TEST_ASSERT_EQUALS(2, result.matches[2].line);
+  TEST_ASSERT_EQUALS(std::string("void GpuVideo::OnDataReceived(int size) {"),
+                     result.matches[2].text);
+
+  // The paths are absolute so they can be used for breakpoints.
+  TEST_ASSERT(std::filesystem::path(result.matches[0].path).is_absolute());
+
+  std::filesystem::remove_all(root);
+}
+
+TEST(Search_SameResultsWithoutPrefilter) {
+  std::filesystem::path root = CreateSourceTree("no_prefilter");
+
+  SearchOptions options;
+  options.use_prefilter = false;
+  options.threads = 1;
+  SearchResult result =
+      source_search::Search(root.string(), R"(void\s+\w+::OnDataReceived\()",
+                            options);
+  TEST_ASSERT(result.literal.empty());
+  TEST_ASSERT_EQUALS(3, result.matches.size());
+  TEST_ASSERT_EQUALS(8, result.matches[1].line);
+
+  // Every line of the three source files is checked.
+  TEST_ASSERT_EQUALS(16, result.lines_checked);
+
+  std::filesystem::remove_all(root);
+}
+
+TEST(Search_ExtensionsAndLimit) {
+  std::filesystem::path root = CreateSourceTree("options");
+
+  SearchOptions options;
+  options.extensions = {".H", ".txt"};
+  SearchResult result =
+      source_search::Search(root.string(), "OnDataReceived", options);
+  TEST_ASSERT_EQUALS(2, result.matches.size());
+  TEST_ASSERT_STRING_CONTAINS(result.matches[0].path, "decoder.h");
+  TEST_ASSERT_STRING_CONTAINS(result.matches[1].path, "notes.txt");
+
+  options = SearchOptions();
+  options.max_matches = 2;
+  options.threads = 1;
+  result = source_search::Search(root.string(), "OnDataReceived", options);
+  TEST_ASSERT(result.truncated);
+  TEST_ASSERT_EQUALS(2, result.matches.size());
+
+  std::filesystem::remove_all(root);
+}
+
+TEST(Search_Errors) {
+  std::filesystem::path root = CreateSourceTree("errors");
+
+  SearchResult result = source_search::Search(root.string(), "Decoder(");
+  TEST_ASSERT_STRING_CONTAINS(result.error, "Invalid regular expression");
+
+  result = source_search::Search((root / "missing").string(), "Decoder");
+  TEST_ASSERT_STRING_CONTAINS(result.error, "Directory not found");
+
+#ifdef _MSC_VER
+  // MSVC's std::regex_search throws error_complexity when backtracking
+  // takes too long. The error is reported instead of ending the process.
+  WriteFile(root / "backtrack.cc", std::string(64, 'a') + "\n");
+  SearchOptions options;
+  options.use_prefilter = false;
+  result = source_search::Search(root.string(), "(a|aa)*c", options);
+  TEST_ASSERT_STRING_CONTAINS(result.error, "Regular expression error");
+  TEST_ASSERT(result.matches.empty());
+#endif
+
+  std::filesystem::remove_all(root);
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,218 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../src/stack_sampler.h"
+#include "../src/utils.h"
+#include "debug_interfaces_test_base.h"
+#include "unit_test_runner.h"
+
+utils::DebugInterfaces g_debug;
+
+using stack_sampler::LabeledTree;
+using stack_sampler::SamplerOptions;
+using stack_sampler::SamplerResult;
+
+class StackSamplerTest : public DebugInterfacesTestBase {
+ public:
+  struct FakeThread {
+    ULONG id;
+    ULONG system_id;
+    // The executing frame first as returned by GetStackTrace.
+    std::vector<ULONG64> frames;
+  };
+
+  std::vector<FakeThread> threads;
+  ULONG current_thread = 0;
+  ULONG event_thread = 0;
+  std::vector<HRESULT> wait_results;
+  std::vector<ULONG> interrupts;
+
+  StackSamplerTest() : DebugInterfacesTestBase(g_debug) {
+    mock_system_objects->SetMethodOverride(
+        "GetNumberThreads", [this](PULONG number) -> HRESULT {
+          *number = static_cast<ULONG>(threads.size());
+          return S_OK;
+        });
+    mock_system_objects->SetMethodOverride(
+        "GetThreadIdsByIndex",
+        [this](ULONG start, ULONG count, PULONG ids, PULONG sys_ids)
+            -> HRESULT {
+          for (ULONG i = 0; i < count; i++) {
+            ids[i] = threads[start + i].id;
+            sys_ids[i] = threads[start + i].system_id;
+          }
+          return S_OK;
+        });
+    mock_system_objects->SetMethodOverride(
+        "GetCurrentThreadId", [this](PULONG id) -> HRESULT {
+          *id = current_thread;
+          return S_OK;
+        });
+    mock_system_objects->SetMethodOverride(
+        "SetCurrentThreadId", [this](ULONG id) -> HRESULT {
+          current_thread = id;
+          return S_OK;
+        });
+    mock_system_objects->SetMethodOverride(
+        "GetEventThread", [this](PULONG id) -> HRESULT {
+          *id = event_thread;
+          return S_OK;
+        });
+
+    mock_control->SetMethodOverride(
+        "GetStackTrace",
+        [this](ULONG64 frame_offset, ULONG64 stack_offset,
+               ULONG64 instruction_offset, PDEBUG_STACK_FRAME frames,
+               ULONG frames_size, PULONG frames_filled) -> HRESULT {
+          for (const FakeThread& thread : threads) {
+            if (thread.id != current_thread) {
+              continue;
+            }
+            ULONG count = static_cast<ULONG>(thread.frames.size());
+            if (count > frames_size) {
+              count = frames_size;
+            }
+            for (ULONG i = 0; i < count; i++) {
+              frames[i] = {};
+              frames[i].InstructionOffset = thread.frames[i];
+            }
+            *frames_filled = count;
+            return S_OK;
+          }
+          return E_FAIL;
+        });
+    mock_control->SetMethodOverride(
+        "GetExecutionStatus", [](PULONG status) -> HRESULT {
+          *status = DEBUG_STATUS_BREAK;
+          return S_OK;
+        });
+    mock_control->SetMethodOverride(
+        "SetExecutionStatus",
+        [](ULONG status) -> HRESULT { return S_OK; });
+    mock_control->SetMethodOverride(
+        "SetInterrupt", [this](ULONG flags) -> HRESULT {
+          interrupts.push_back(flags);
+          return S_OK;
+        });
+    mock_control->SetMethodOverride(
+        "WaitForEvent", [this](ULONG flags, ULONG timeout) -> HRESULT {
+          if (wait_results.empty()) {
+            return S_OK;
+          }
+          HRESULT hr = wait_results.front();
+          wait_results.erase(wait_results.begin());
+          return hr;
+        });
+  }
+};
+
+DECLARE_TEST_RUNNER()
+
+TEST(CaptureStacks_AllThreads) {
+  StackSamplerTest test;
+  test.threads = {{0, 0x10, {0x3000, 0x2000, 0x1000}},
+                  {1, 0x20, {0x5000, 0x2000, 0x1000}},
+                  {2, 0x30, {0x7000}}};
+  test.current_thread = 1;
+
+  stack_sampler::StackSampler sampler(&g_debug);
+  SamplerOptions options;
+  SamplerResult result;
+  TEST_ASSERT_EQUALS(S_OK, sampler.CaptureStacks(options, 2, result));
+
+  // Thread 2 is the break in thread and is skipped.
+  TEST_ASSERT_EQUALS(2, result.stacks);
+  TEST_ASSERT_EQUALS(1, result.trees.size());
+  TEST_ASSERT_EQUALS(2, result.trees[0].GetTotalCount());
+
+  // The frames are stored outermost first.
+  std::map<std::vector<ULONG64>, ULONG64> stacks;
+  result.trees[0].ForEachStack(
+      [&](const std::vector<ULONG64>& frames, ULONG64 count) {
+        stacks[frames] += count;
+      });
+  TEST_ASSERT_EQUALS(1, (stacks[{0x1000, 0x2000, 0x3000}]));
+  TEST_ASSERT_EQUALS(1, (stacks[{0x1000, 0x2000, 0x5000}]));
+
+  // The original thread is restored.
+  TEST_ASSERT_EQUALS(1, test.current_thread);
+}
+
+TEST(CaptureStacks_ThreadFilterAndGrouping) {
+  StackSamplerTest test;
+  test.threads = {{0, 0x10, {0x3000, 0x1000}},
+                  {1, 0x20, {0x4000, 0x1000}},
+                  {2, 0x30, {0x5000, 0x1000}}};
+
+  stack_sampler::StackSampler sampler(&g_debug);
+  SamplerOptions options;
+  options.thread_ids = {0, 2};
+  options.group_by_thread = true;
+  options.max_depth = 1;
+
+  SamplerResult result;
+  sampler.CaptureStacks(options, static_cast<ULONG>(-1), result);
+  TEST_ASSERT_EQUALS(2, result.stacks);
+  TEST_ASSERT_EQUALS(2, result.trees.size());
+  TEST_ASSERT_EQUALS(1, result.trees.count(0x10));
+  TEST_ASSERT_EQUALS(1, result.trees.count(0x30));
+
+  // Only the executing frame fits within max_depth.
+  TEST_ASSERT_EQUALS(1, result.trees[0x30].GetNodeCount());
+  TEST_ASSERT_EQUALS(0x5000, result.trees[0x30].GetAddresses()[0]);
+
+  std::vector<LabeledTree> labeled = result.GetLabeledTrees();
+  TEST_ASSERT_EQUALS(std::string("thread_10"), labeled[0].first);
+  TEST_ASSERT_EQUALS(std::string("thread_30"), labeled[1].first);
+}
+
+TEST(Run_StopsWhenTargetStopsOnItsOwn) {
+  StackSamplerTest test;
+  test.threads = {{0, 0x10, {0x3000, 0x1000}}, {1, 0x20, {0x1000}}};
+  test.event_thread = 1;
+
+  // Two samples and then a breakpoint is hit while running.
+  test.wait_results = {S_FALSE, S_OK, S_FALSE, S_OK, S_OK};
+
+  stack_sampler::StackSampler sampler(&g_debug);
+  SamplerOptions options;
+  options.duration_ms = 60000;
+  SamplerResult result = sampler.Run(options);
+
+  TEST_ASSERT(result.success);
+  TEST_ASSERT_EQUALS(2, result.samples);
+  TEST_ASSERT_EQUALS(2, result.stacks);
+  TEST_ASSERT_EQUALS(2, test.interrupts.size());
+  TEST_ASSERT_EQUALS(DEBUG_INTERRUPT_ACTIVE, test.interrupts[0]);
+  TEST_ASSERT_STRING_CONTAINS(result.stop_reason, "debug event");
+}
+
+TEST(Run_ShouldStopAndErrors) {
+  StackSamplerTest test;
+  test.threads = {{0, 0x10, {0x1000}}};
+
+  stack_sampler::StackSampler sampler(&g_debug);
+  SamplerOptions options;
+  SamplerResult result = sampler.Run(options, [] { return true; });
+  TEST_ASSERT(result.success);
+  TEST_ASSERT_EQUALS(0, result.samples);
+  TEST_ASSERT_EQUALS(std::string("Interrupted"), result.stop_reason);
+
+  // The target must be broken in.
+  test.mock_control->SetMethodOverride(
+      "GetExecutionStatus", [](PULONG status) -> HRESULT {
+        *status = DEBUG_STATUS_GO;
+        return S_OK;
+      });
+  result = sampler.Run(options);
+  TEST_ASSERT(!result.success);
+  TEST_ASSERT_STRING_CONTAINS(result.error, "broken in");
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
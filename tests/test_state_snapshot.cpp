@@ -0,0 +1,389 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "../src/state_snapshot.h"
+#include "../src/utils.h"
+#include "debug_interfaces_test_base.h"
+#include "mocks/mock_debug_symbol_group.h"
+#include "unit_test_runner.h"
+
+utils::DebugInterfaces g_debug;
+
+using state_snapshot::CaptureOptions;
+using state_snapshot::Frame;
+using state_snapshot::Snapshot;
+using state_snapshot::SnapshotCapturer;
+using state_snapshot::SnapshotStore;
+using state_snapshot::StateDiff;
+using state_snapshot::Variable;
+
+namespace {
+
+std::string FakeSymbolizer(ULONG64 address) {
+  char buffer[64];
+  snprintf(buffer, sizeof(buffer), "chrome!Function%llx+0x%llx",
+           address >> 8, address & 0xff);
+  return buffer;
+}
+
+void CopyString(const std::string& value, PSTR buffer, ULONG buffer_size) {
+  strncpy(buffer, value.c_str(), buffer_size - 1);
+  buffer[buffer_size - 1] = '\0';
+}
+
+// A snapshot with 20 registers, 8 frames and 10 locals
+// where step changes a register, the top frame and a local.
+Snapshot CreateSnapshot(ULONG step) {
+  Snapshot snapshot;
+  snapshot.thread_id = 0x1a2c;
+  for (ULONG i = 0; i < 20; i++) {
+    snapshot.registers.emplace_back("r" + std::to_string(i), i);
+  }
+  snapshot.registers[0].second = step;
+  for (ULONG i = 0; i < 8; i++) {
+    snapshot.frames.push_back(
+        {0x1000u + i * 0x100, 0x5000u + i * 0x10, FakeSymbolizer(0x1000 + i * 0x100)});
+  }
+  snapshot.frames[0].instruction_offset += step;
+  snapshot.frames[0].symbol = FakeSymbolizer(0x1000 + step);
+  for (ULONG i = 0; i < 10; i++) {
+    snapshot.locals.push_back(
+        {"local" + std::to_string(i), "int", std::to_string(i), false});
+  }
+  snapshot.locals[step % 10].value = "changed" + std::to_string(step);
+  return snapshot;
+}
+
+}  // namespace
+
+class StateSnapshotTest : public DebugInterfacesTestBase {
+ public:
+  struct FakeRegister {
+    std::string name;
+    ULONG type;
+    ULONG flags;
+    ULONG64 value;
+  };
+
+  struct FakeSymbol {
+    std::string name;
+    std::string type;
+    std::string value;
+    ULONG parent;
+    ULONG flags;
+  };
+
+  std::vector<FakeRegister> registers = {
+      {"rax", DEBUG_VALUE_INT64, 0, 0x42},
+      {"eax", DEBUG_VALUE_INT32, DEBUG_REGISTER_SUB_REGISTER, 0x42},
+      {"rip", DEBUG_VALUE_INT64, 0, 0x7ff612341000},
+      {"xmm0", 8, 0, 0},
+      {"efl", DEBUG_VALUE_INT32, 0, 0x246}};
+  std::vector<ULONG64> frames = {0x1010, 0x2020, 0x3030};
+  std::vector<FakeSymbol> symbols = {
+      {"this", "Foo *", "0x00000000`12345678", DEBUG_ANY_ID,
+       DEBUG_SYMBOL_IS_ARGUMENT},
+      {"->member", "int", "7", 0, 0},
+      {"count", "int", "3", DEBUG_ANY_ID, DEBUG_SYMBOL_IS_LOCAL},
+      {"name", "std::string", std::string(300, 'x'), DEBUG_ANY_ID,
+       DEBUG_SYMBOL_IS_LOCAL}};
+  bool has_scope = true;
+
+  MockDebugSymbolGroup mock_group;
+
+  StateSnapshotTest() : DebugInterfacesTestBase(g_debug) {
+    mock_system_objects->SetMethodOverride(
+        "GetCurrentThreadSystemId", [](PULONG id) -> HRESULT {
+          *id = 0x1a2c;
+          return S_OK;
+        });
+
+    mock_registers->SetMethodOverride(
+        "GetNumberRegisters", [this](PULONG number) -> HRESULT {
+          *number = static_cast<ULONG>(registers.size());
+          return S_OK;
+        });
+    mock_registers->SetMethodOverride(
+        "GetDescription",
+        [this](ULONG index, PSTR name, ULONG name_size, PULONG actual_size,
+               PDEBUG_REGISTER_DESCRIPTION description) -> HRESULT {
+          CopyString(registers[index].name, name, name_size);
+          *description = {};
+          description->Type = registers[index].type;
+          description->Flags = registers[index].flags;
+          return S_OK;
+        });
+    mock_registers->SetMethodOverride(
+        "GetValues",
+        [this](ULONG count, PULONG indices, ULONG start,
+               PDEBUG_VALUE values) -> HRESULT {
+          for (ULONG i = 0; i < count; i++) {
+            const FakeRegister& fake = registers[indices[i]];
+            values[i] = {};
+            values[i].Type = fake.type;
+            if (fake.type == DEBUG_VALUE_INT32) {
+              values[i].I32 = static_cast<ULONG>(fake.value);
+            } else {
+              values[i].I64 = fake.value;
+            }
+          }
+          return S_OK;
+        });
+
+    mock_control->SetMethodOverride(
+        "GetStackTrace",
+        [this](ULONG64 frame_offset, ULONG64 stack_offset,
+               ULONG64 instruction_offset, PDEBUG_STACK_FRAME stack_frames,
+               ULONG frames_size, PULONG frames_filled) -> HRESULT {
+          ULONG count = static_cast<ULONG>(frames.size());
+          if (count > frames_size) {
+            count = frames_size;
+          }
+          for (ULONG i = 0; i < count; i++) {
+            stack_frames[i] = {};
+            stack_frames[i].InstructionOffset = frames[i];
+            stack_frames[i].StackOffset = 0x5000 + i * 0x40;
+          }
+          *frames_filled = count;
+          return S_OK;
+        });
+
+    mock_symbols->SetMethodOverride(
+        "GetScopeSymbolGroup",
+        [this](ULONG flags, PDEBUG_SYMBOL_GROUP update,
+               PDEBUG_SYMBOL_GROUP* group) -> HRESULT {
+          if (!has_scope) {
+            return E_FAIL;
+          }
+          *group = &mock_group;
+          return S_OK;
+        });
+
+    mock_group.SetMethodOverride("GetNumberSymbols",
+                                 [this](PULONG number) -> HRESULT {
+                                   *number =
+                                       static_cast<ULONG>(symbols.size());
+                                   return S_OK;
+                                 });
+    mock_group.SetMethodOverride(
+        "GetSymbolParameters",
+        [this](ULONG start, ULONG count,
+               PDEBUG_SYMBOL_PARAMETERS parameters) -> HRESULT {
+          for (ULONG i = 0; i < count; i++) {
+            parameters[i] = {};
+            parameters[i].ParentSymbol = symbols[start + i].parent;
+            parameters[i].Flags = symbols[start + i].flags;
+          }
+          return S_OK;
+        });
+    mock_group.SetMethodOverride(
+        "GetSymbolName",
+        [this](ULONG index, PSTR buffer, ULONG size, PULONG actual) -> HRESULT {
+          CopyString(symbols[index].name, buffer, size);
+          return S_OK;
+        });
+    mock_group.SetMethodOverride(
+        "GetSymbolTypeName",
+        [this](ULONG index, PSTR buffer, ULONG size, PULONG actual) -> HRESULT {
+          CopyString(symbols[index].type, buffer, size);
+          return S_OK;
+        });
+    mock_group.SetMethodOverride(
+        "GetSymbolValueText",
+        [this](ULONG index, PSTR buffer, ULONG size, PULONG actual) -> HRESULT {
+          CopyString(symbols[index].value, buffer, size);
+          return S_OK;
+        });
+  }
+};
+
+DECLARE_TEST_RUNNER()
+
+TEST(Capture_RegistersFramesAndLocals) {
+  StateSnapshotTest test;
+  SnapshotCapturer capturer(&g_debug, FakeSymbolizer);
+
+  CaptureOptions options;
+  options.max_frames = 2;
+  Snapshot snapshot;
+  std::string error;
+  TEST_ASSERT(capturer.Capture(options, snapshot, error));
+
+  // Sub registers and vector registers are skipped.
+  TEST_ASSERT_EQUALS(3, snapshot.registers.size());
+  TEST_ASSERT_EQUALS(std::string("rax"), snapshot.registers[0].first);
+  TEST_ASSERT_EQUALS(0x42, snapshot.registers[0].second);
+  TEST_ASSERT_EQUALS(std::string("rip"), snapshot.registers[1].first);
+  TEST_ASSERT_EQUALS(0x7ff612341000ULL, snapshot.registers[1].second);
+  TEST_ASSERT_EQUALS(std::string("efl"), snapshot.registers[2].first);
+  TEST_ASSERT_EQUALS(0x246, snapshot.registers[2].second);
+
+  TEST_ASSERT_EQUALS(0x1a2c, snapshot.thread_id);
+  TEST_ASSERT_EQUALS(2, snapshot.frames.size());
+  TEST_ASSERT_EQUALS(std::string("chrome!Function10+0x10"),
+                     snapshot.frames[0].symbol);
+  TEST_ASSERT_EQUALS(0x5040, snapshot.frames[1].stack_offset);
+
+  // Only the top level symbols and long values are truncated.
+  TEST_ASSERT_EQUALS(3, snapshot.locals.size());
+  TEST_ASSERT_EQUALS(std::string("this"), snapshot.locals[0].name);
+  TEST_ASSERT_EQUALS(std::string("Foo *"), snapshot.locals[0].type);
+  TEST_ASSERT(snapshot.locals[0].is_argument);
+  TEST_ASSERT_EQUALS(std::string("count"), snapshot.locals[1].name);
+  TEST_ASSERT(!snapshot.locals[1].is_argument);
+  TEST_ASSERT_EQUALS(259, snapshot.locals[2].value.size());
+}
+
+TEST(Capture_FixedNumberOfEngineCalls) {
+  StateSnapshotTest test;
+  SnapshotCapturer capturer(&g_debug, FakeSymbolizer);
+
+  Snapshot snapshot;
+  std::string error;
+  TEST_ASSERT(capturer.Capture(CaptureOptions(), snapshot, error));
+  TEST_ASSERT(capturer.Capture(CaptureOptions(), snapshot, error));
+
+  // The register table is only read once and all of the
+  // registers are read with a single call.
+  TEST_ASSERT_EQUALS(test.registers.size(),
+                     test.mock_registers->GetCallCount("GetDescription"));
+  TEST_ASSERT_EQUALS(2, test.mock_registers->GetCallCount("GetValues"));
+  TEST_ASSERT_EQUALS(2, test.mock_control->GetCallCount("GetStackTrace"));
+  TEST_ASSERT_EQUALS(2, test.mock_symbols->GetCallCount("GetScopeSymbolGroup"));
+
+  // The table is read again if the register set changes.
+  test.registers.push_back({"r8", DEBUG_VALUE_INT64, 0, 8});
+  TEST_ASSERT(capturer.Capture(CaptureOptions(), snapshot, error));
+  TEST_ASSERT_EQUALS(4, snapshot.registers.size());
+}
+
+TEST(Capture_WithoutLocals) {
+  StateSnapshotTest test;
+  test.has_scope = false;
+  SnapshotCapturer capturer(&g_debug, FakeSymbolizer);
+
+  Snapshot snapshot;
+  std::string error;
+  TEST_ASSERT(capturer.Capture(CaptureOptions(), snapshot, error));
+  TEST_ASSERT_EQUALS(3, snapshot.frames.size());
+  TEST_ASSERT(snapshot.locals.empty());
+}
+
+TEST(Diff_RegistersFramesAndLocals) {
+  Snapshot from = CreateSnapshot(1);
+  Snapshot to = CreateSnapshot(2);
+  from.id = 1;
+  to.id = 2;
+  to.locals.push_back({"added", "bool", "true", false});
+  to.locals.erase(to.locals.begin() + 9);
+
+  StateDiff diff = state_snapshot::Diff(from, to);
+  TEST_ASSERT(!diff.IsEmpty());
+  TEST_ASSERT(!diff.thread_changed);
+
+  TEST_ASSERT_EQUALS(1, diff.registers.size());
+  TEST_ASSERT_EQUALS(std::string("r0"), diff.registers[0].name);
+  TEST_ASSERT_EQUALS(1, diff.registers[0].old_value);
+  TEST_ASSERT_EQUALS(2, diff.registers[0].new_value);
+
+  // Still in the same function.
+  TEST_ASSERT(diff.frames_changed);
+  TEST_ASSERT(!diff.scope_changed);
+  TEST_ASSERT_EQUALS(8, diff.frames.size());
+
+  // local1 changed back and local2 changed.
+  TEST_ASSERT_EQUALS(2, diff.changed_locals.size());
+  TEST_ASSERT_EQUALS(std::string("local1"), diff.changed_locals[0].name);
+  TEST_ASSERT_EQUALS(std::string("changed1"), diff.changed_locals[0].old_value);
+  TEST_ASSERT_EQUALS(std::string("1"), diff.changed_locals[0].new_value);
+  TEST_ASSERT_EQUALS(std::string("changed2"), diff.changed_locals[1].new_value);
+  TEST_ASSERT_EQUALS(1, diff.added_locals.size());
+  TEST_ASSERT_EQUALS(std::string("added"), diff.added_locals[0].name);
+  TEST_ASSERT_EQUALS(1, diff.removed_locals.size());
+  TEST_ASSERT_EQUALS(std::string("local9"), diff.removed_locals[0]);
+
+  TEST_ASSERT(state_snapshot::Diff(to, to).IsEmpty());
+}
+
+TEST(Diff_ScopeChanged) {
+  Snapshot from = CreateSnapshot(1);
+  Snapshot to = CreateSnapshot(1);
+  to.frames[0].symbol = "chrome!Other+0x4";
+  TEST_ASSERT(state_snapshot::Diff(from, to).scope_changed);
+
+  TEST_ASSERT_EQUALS(std::string("chrome!Foo::operator+"),
+                     state_snapshot::GetFunctionName("chrome!Foo::operator++0x1a"));
+  TEST_ASSERT_EQUALS(std::string("chrome!Foo"),
+                     state_snapshot::GetFunctionName("chrome!Foo"));
+}
+
+TEST(Store_DeltaEncodedRing) {
+  SnapshotStore store(10, 4);
+  TEST_ASSERT_EQUALS(0, store.GetLatestId());
+
+  for (ULONG step = 0; step < 25; step++) {
+    TEST_ASSERT_EQUALS(step + 1, store.Add(CreateSnapshot(step)));
+  }
+  TEST_ASSERT_EQUALS(10, store.GetCount());
+  TEST_ASSERT_EQUALS(16, store.GetOldestId());
+  TEST_ASSERT_EQUALS(25, store.GetLatestId());
+
+  // Every snapshot in the ring decodes to the original
+  // including the oldest one which was a delta.
+  for (ULONG id = 16; id <= 25; id++) {
+    Snapshot expected = CreateSnapshot(id - 1);
+    Snapshot snapshot;
+    TEST_ASSERT(store.Get(id, snapshot));
+    TEST_ASSERT_EQUALS(id, snapshot.id);
+    TEST_ASSERT(snapshot.registers == expected.registers);
+    TEST_ASSERT(snapshot.frames == expected.frames);
+    TEST_ASSERT(snapshot.locals == expected.locals);
+  }
+
+  Snapshot snapshot;
+  TEST_ASSERT(!store.Get(15, snapshot));
+  TEST_ASSERT(!store.Get(26, snapshot));
+
+  // 38 values per snapshot. The deltas store 1 register, 1 frame
+  // and 2 locals (the previous and the new changed local).
+  size_t full_size = 10 * 38;
+  TEST_ASSERT(store.GetStoredValueCount() < full_size / 2);
+
+  store.Clear();
+  TEST_ASSERT_EQUALS(0, store.GetCount());
+  TEST_ASSERT_EQUALS(0, store.GetStoredValueCount());
+  TEST_ASSERT_EQUALS(26, store.Add(CreateSnapshot(0)));
+}
+
+TEST(Store_ChangingSizes) {
+  SnapshotStore store(4, 8);
+
+  Snapshot deep = CreateSnapshot(0);
+  Snapshot shallow = CreateSnapshot(0);
+  shallow.frames.resize(2);
+  shallow.locals.clear();
+  shallow.thread_id = 0x2b3c;
+
+  store.Add(deep);
+  store.Add(shallow);
+  store.Add(deep);
+
+  Snapshot snapshot;
+  TEST_ASSERT(store.Get(2, snapshot));
+  TEST_ASSERT_EQUALS(0x2b3c, snapshot.thread_id);
+  TEST_ASSERT_EQUALS(2, snapshot.frames.size());
+  TEST_ASSERT(snapshot.locals.empty());
+
+  TEST_ASSERT(store.Get(3, snapshot));
+  TEST_ASSERT(snapshot.frames == deep.frames);
+  TEST_ASSERT(snapshot.locals == deep.locals);
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
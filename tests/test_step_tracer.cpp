@@ -0,0 +1,283 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "../src/step_tracer.h"
+#include "../src/utils.h"
+#include "debug_interfaces_test_base.h"
+#include "unit_test_runner.h"
+
+utils::DebugInterfaces g_debug;
+
+using step_tracer::StepKind;
+using step_tracer::StepTrace;
+using step_tracer::TraceBuffer;
+using step_tracer::TraceEntry;
+using step_tracer::TraceOptions;
+
+class StepTracerTest : public DebugInterfacesTestBase {
+ public:
+  // The instruction pointer and thread after each step.
+  std::vector<TraceEntry> steps;
+  size_t step_index = 0;
+  bool stepped = false;
+  std::vector<ULONG> execution_statuses;
+
+  // Values returned by the mock Evaluate keyed by expression.
+  std::map<std::string, ULONG64> values;
+
+  StepTracerTest() : DebugInterfacesTestBase(g_debug) {
+    mock_control->SetMethodOverride(
+        "GetExecutionStatus", [](PULONG status) -> HRESULT {
+          *status = DEBUG_STATUS_BREAK;
+          return S_OK;
+        });
+    mock_control->SetMethodOverride(
+        "SetExecutionStatus", [this](ULONG status) -> HRESULT {
+          execution_statuses.push_back(status);
+          return S_OK;
+        });
+    mock_control->SetMethodOverride(
+        "WaitForEvent", [this](ULONG flags, ULONG timeout) -> HRESULT {
+          if (step_index >= steps.size()) {
+            return E_UNEXPECTED;
+          }
+          if (stepped) {
+            step_index++;
+          }
+          stepped = true;
+          return step_index < steps.size() ? S_OK : E_UNEXPECTED;
+        });
+    mock_registers->SetMethodOverride(
+        "GetInstructionOffset", [this](PULONG64 offset) -> HRESULT {
+          *offset = steps[step_index].ip;
+          return S_OK;
+        });
+    mock_system_objects->SetMethodOverride(
+        "GetCurrentThreadSystemId", [this](PULONG id) -> HRESULT {
+          // Before the first step the thread is the one of the first step.
+          *id = steps.empty() ? 0 : steps[step_index].thread_id;
+          return S_OK;
+        });
+    mock_control->SetMethodOverride(
+        "Evaluate", [this](PCSTR expression, ULONG desired_type,
+                           PDEBUG_VALUE value, PULONG remainder) -> HRESULT {
+          std::string text = expression;
+          if (text == "@rip == 0x1010") {
+            value->I64 = stepped && steps[step_index].ip == 0x1010;
+            return S_OK;
+          }
+          auto it = values.find(text);
+          if (it == values.end()) {
+            return E_FAIL;
+          }
+          value->I64 = it->second;
+          return S_OK;
+        });
+  }
+};
+
+DECLARE_TEST_RUNNER()
+
+TEST(TraceBuffer_RoundTrip) {
+  std::vector<TraceEntry> entries = {
+      {0x00007ff812340000, 0x1a2c, StepKind::kOver},
+      {0x00007ff812340005, 0x1a2c, StepKind::kOver},
+      {0x00007ff812340005, 0x1a2c, StepKind::kInto},
+      // A call into another module and back.
+      {0x00007ff899990000, 0x1a2c, StepKind::kInto},
+      {0x00007ff81234000a, 0x1a2c, StepKind::kBranch},
+      // A backwards jump and a thread switch.
+      {0x00007ff812330000, 0x2b3d, StepKind::kOver},
+      {0x0000000000000000, 0x0, StepKind::kOver},
+      {0xffffffffffffffff, 0xffffffff, StepKind::kOver}};
+
+  TraceBuffer buffer;
+  for (const TraceEntry& entry : entries) {
+    buffer.Append(entry);
+  }
+  TEST_ASSERT_EQUALS(entries.size(), buffer.GetCount());
+
+  std::vector<TraceEntry> decoded = buffer.Decode(0, 100);
+  TEST_ASSERT_EQUALS(entries.size(), decoded.size());
+  for (size_t i = 0; i < entries.size(); i++) {
+    TEST_ASSERT_EQUALS(entries[i].ip, decoded[i].ip);
+    TEST_ASSERT_EQUALS(entries[i].thread_id, decoded[i].thread_id);
+    TEST_ASSERT(entries[i].kind == decoded[i].kind);
+  }
+}
+
+TEST(TraceBuffer_ShortForwardStepsTakeOneByte) {
+  TraceBuffer buffer;
+  buffer.Append({0x00007ff812340000, 0x1a2c, StepKind::kOver});
+  size_t first_size = buffer.GetSizeBytes();
+
+  ULONG64 ip = 0x00007ff812340000;
+  for (int i = 0; i < 1000; i++) {
+    ip += 1 + (i % 15);
+    buffer.Append({ip, 0x1a2c, StepKind::kOver});
+  }
+  TEST_ASSERT_EQUALS(first_size + 1000, buffer.GetSizeBytes());
+
+  // Short backwards jumps take a varint byte.
+  buffer.Append({ip - 0x20, 0x1a2c, StepKind::kOver});
+  TEST_ASSERT_EQUALS(first_size + 1002, buffer.GetSizeBytes());
+}
+
+TEST(TraceBuffer_DecodeRangeUsesCheckpoints) {
+  TraceBuffer buffer;
+  std::vector<TraceEntry> entries;
+  for (ULONG i = 0; i < 1000; i++) {
+    // Mix in large jumps and thread changes.
+    ULONG64 ip = 0x140000000 + (i * 7) + ((i % 37 == 0) ? 0x100000 : 0);
+    TraceEntry entry = {ip, 100 + (i / 300), StepKind::kInto};
+    entries.push_back(entry);
+    buffer.Append(entry);
+  }
+
+  const size_t ranges[][2] = {{0, 1}, {255, 2}, {256, 1}, {300, 10},
+                              {700, 400}, {999, 5}};
+  for (const auto& range : ranges) {
+    std::vector<TraceEntry> decoded = buffer.Decode(range[0], range[1]);
+    size_t expected = std::min(range[1], entries.size() - range[0]);
+    TEST_ASSERT_EQUALS(expected, decoded.size());
+    for (size_t i = 0; i < decoded.size(); i++) {
+      TEST_ASSERT_EQUALS(entries[range[0] + i].ip, decoded[i].ip);
+      TEST_ASSERT_EQUALS(entries[range[0] + i].thread_id,
+                         decoded[i].thread_id);
+    }
+  }
+
+  TEST_ASSERT_EQUALS(0, buffer.Decode(1000, 10).size());
+}
+
+TEST(Summarize_Counts) {
+  TraceBuffer buffer;
+  buffer.Append({0x2000, 1, StepKind::kOver});
+  buffer.Append({0x2004, 1, StepKind::kOver});
+  buffer.Append({0x1000, 1, StepKind::kOver});
+  buffer.Append({0x2004, 2, StepKind::kOver});
+
+  step_tracer::TraceSummary summary = step_tracer::Summarize(buffer);
+  TEST_ASSERT_EQUALS(4, summary.steps);
+  TEST_ASSERT_EQUALS(buffer.GetSizeBytes(), summary.size_bytes);
+  TEST_ASSERT_EQUALS(3, summary.unique_addresses);
+  TEST_ASSERT_EQUALS(0x2000, summary.first_ip);
+  TEST_ASSERT_EQUALS(0x2004, summary.last_ip);
+  TEST_ASSERT_EQUALS(0x1000, summary.min_ip);
+  TEST_ASSERT_EQUALS(0x2004, summary.max_ip);
+  TEST_ASSERT_EQUALS(3, summary.thread_steps[1]);
+  TEST_ASSERT_EQUALS(1, summary.thread_steps[2]);
+}
+
+TEST(Run_StepsCount) {
+  StepTracerTest test;
+  for (ULONG64 i = 0; i < 20; i++) {
+    test.steps.push_back({0x1000 + i * 4, 7, StepKind::kInto});
+  }
+
+  step_tracer::StepTracer tracer(&g_debug);
+  TraceOptions options;
+  options.kind = StepKind::kInto;
+  options.max_steps = 5;
+  std::unique_ptr<StepTrace> trace = tracer.Run(options);
+
+  TEST_ASSERT(trace->success);
+  TEST_ASSERT(trace->stop_reason.empty());
+  TEST_ASSERT_EQUALS(5, trace->buffer.GetCount());
+  TEST_ASSERT_EQUALS(5, test.execution_statuses.size());
+  TEST_ASSERT_EQUALS(DEBUG_STATUS_STEP_INTO, test.execution_statuses[0]);
+
+  std::vector<TraceEntry> entries = trace->buffer.Decode(0, 5);
+  TEST_ASSERT_EQUALS(0x1000, entries[0].ip);
+  TEST_ASSERT_EQUALS(0x1010, entries[4].ip);
+  TEST_ASSERT_EQUALS(7, entries[4].thread_id);
+}
+
+TEST(Run_StopsWhenConditionIsMet) {
+  StepTracerTest test;
+  for (ULONG64 i = 0; i < 20; i++) {
+    test.steps.push_back({0x1000 + i * 4, 7, StepKind::kOver});
+  }
+
+  step_tracer::StepTracer tracer(&g_debug);
+  TraceOptions options;
+  options.max_steps = 100;
+  options.until = "@rip == 0x1010";
+  std::unique_ptr<StepTrace> trace = tracer.Run(options);
+
+  TEST_ASSERT(trace->success);
+  TEST_ASSERT(trace->condition_met);
+  TEST_ASSERT_EQUALS(5, trace->buffer.GetCount());
+  TEST_ASSERT_EQUALS(DEBUG_STATUS_STEP_OVER, test.execution_statuses[0]);
+}
+
+TEST(Run_StopsOnThreadChangeAndTargetExit) {
+  StepTracerTest test;
+  test.steps = {{0x1000, 7, StepKind::kOver},
+                {0x1004, 7, StepKind::kOver},
+                {0x5000, 9, StepKind::kOver},
+                {0x5004, 9, StepKind::kOver}};
+
+  step_tracer::StepTracer tracer(&g_debug);
+  TraceOptions options;
+  options.max_steps = 100;
+  std::unique_ptr<StepTrace> trace = tracer.Run(options);
+
+  // The step which ended on the other thread is recorded.
+  TEST_ASSERT(trace->success);
+  TEST_ASSERT_EQUALS(3, trace->buffer.GetCount());
+  TEST_ASSERT_STRING_CONTAINS(trace->stop_reason, "another thread");
+
+  // The target exits after the second step.
+  StepTracerTest exiting;
+  exiting.steps = {{0x1000, 7, StepKind::kOver}, {0x1004, 7, StepKind::kOver}};
+  trace = tracer.Run(options);
+  TEST_ASSERT(trace->success);
+  TEST_ASSERT_EQUALS(2, trace->buffer.GetCount());
+  TEST_ASSERT_STRING_CONTAINS(trace->stop_reason, "no longer available");
+}
+
+TEST(Run_Errors) {
+  StepTracerTest test;
+  test.steps = {{0x1000, 7, StepKind::kOver}};
+
+  step_tracer::StepTracer tracer(&g_debug);
+  TraceOptions options;
+  options.until = "bad expression";
+  std::unique_ptr<StepTrace> trace = tracer.Run(options);
+  TEST_ASSERT(!trace->success);
+  TEST_ASSERT_STRING_CONTAINS(trace->error, "Unable to evaluate condition");
+  TEST_ASSERT_EQUALS(0, test.execution_statuses.size());
+
+  test.mock_control->SetMethodOverride(
+      "GetExecutionStatus", [](PULONG status) -> HRESULT {
+        *status = DEBUG_STATUS_GO;
+        return S_OK;
+      });
+  trace = tracer.Run(TraceOptions());
+  TEST_ASSERT(!trace->success);
+  TEST_ASSERT_STRING_CONTAINS(trace->error, "broken in");
+}
+
+TEST(TraceStore_KeepsMostRecent) {
+  step_tracer::TraceStore store(2);
+  ULONG first = store.Add(std::make_unique<StepTrace>());
+  ULONG second = store.Add(std::make_unique<StepTrace>());
+  TEST_ASSERT(first != second);
+  TEST_ASSERT(store.Get(first) != nullptr);
+
+  ULONG third = store.Add(std::make_unique<StepTrace>());
+  TEST_ASSERT(store.Get(first) == nullptr);
+  TEST_ASSERT(store.Get(second) != nullptr);
+  TEST_ASSERT(store.Get(third) != nullptr);
+  TEST_ASSERT(store.Get(1234) == nullptr);
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
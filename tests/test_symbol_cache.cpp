@@ -0,0 +1,263 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "../src/symbol_cache.h"
+#include "../src/utils.h"
+#include "debug_interfaces_test_base.h"
+#include "unit_test_runner.h"
+
+utils::DebugInterfaces g_debug;
+
+using symbol_cache::SymbolCache;
+using symbol_cache::SymbolInfo;
+
+class SymbolCacheTest : public DebugInterfacesTestBase {
+ public:
+  struct FakeModule {
+    ULONG64 base;
+    ULONG size;
+    std::string name;
+  };
+
+  std::vector<FakeModule> modules = {{0x140000000, 0x100000, "chrome"},
+                                     {0x7ff800000000, 0x10000, "ntdll"}};
+
+  // Symbol start address to name.
+  std::map<ULONG64, std::string> symbols = {
+      {0x140001000, "chrome!WinMain"},
+      {0x140001200, "chrome!MessageLoop::Run"},
+      {0x140002000, "chrome!Task::Run"},
+      {0x7ff800001000, "ntdll!RtlUserThreadStart"}};
+
+  int name_lookups = 0;
+  int near_name_lookups = 0;
+  int module_table_reads = 0;
+
+  SymbolCacheTest() : DebugInterfacesTestBase(g_debug) {
+    mock_symbols->SetMethodOverride(
+        "GetNumberModules", [this](PULONG loaded, PULONG unloaded) -> HRESULT {
+          *loaded = static_cast<ULONG>(modules.size());
+          *unloaded = 0;
+          return S_OK;
+        });
+    mock_symbols->SetMethodOverride(
+        "GetModuleParameters",
+        [this](ULONG count, PULONG64 bases, ULONG start,
+               PDEBUG_MODULE_PARAMETERS params) -> HRESULT {
+          module_table_reads++;
+          for (ULONG i = 0; i < count; i++) {
+            params[i] = {};
+            params[i].Base = modules[start + i].base;
+            params[i].Size = modules[start + i].size;
+          }
+          return S_OK;
+        });
+    mock_symbols->SetMethodOverride(
+        "GetModuleNames",
+        [this](ULONG index, ULONG64 base, PSTR image_name,
+               ULONG image_name_size, PULONG image_name_length,
+               PSTR module_name, ULONG module_name_size,
+               PULONG module_name_length, PSTR loaded_image_name,
+               ULONG loaded_image_name_size,
+               PULONG loaded_image_name_length) -> HRESULT {
+          for (const FakeModule& module : modules) {
+            if (module.base == base) {
+              strncpy(module_name, module.name.c_str(), module_name_size);
+              return S_OK;
+            }
+          }
+          return E_INVALIDARG;
+        });
+    mock_system_objects->SetMethodOverride(
+        "GetCurrentProcessSystemId", [](PULONG id) -> HRESULT {
+          *id = 1234;
+          return S_OK;
+        });
+    mock_symbols->SetMethodOverride(
+        "GetNameByOffset",
+        [this](ULONG64 offset, PSTR name, ULONG name_size, PULONG name_length,
+               PULONG64 displacement) -> HRESULT {
+          name_lookups++;
+          auto it = symbols.upper_bound(offset);
+          if (it == symbols.begin() || !IsSameModule(std::prev(it)->first,
+                                                     offset)) {
+            return E_FAIL;
+          }
+          --it;
+          strncpy(name, it->second.c_str(), name_size);
+          *displacement = offset - it->first;
+          return S_OK;
+        });
+    mock_symbols->SetMethodOverride(
+        "GetNearNameByOffset",
+        [this](ULONG64 offset, LONG delta, PSTR name, ULONG name_size,
+               PULONG name_length, PULONG64 displacement) -> HRESULT {
+          near_name_lookups++;
+          auto it = symbols.upper_bound(offset);
+          if (delta != 1 || it == symbols.end()) {
+            return E_FAIL;
+          }
+          strncpy(name, it->second.c_str(), name_size);
+          *displacement = offset - it->first;
+          return S_OK;
+        });
+  }
+
+  bool IsSameModule(ULONG64 a, ULONG64 b) const {
+    for (const FakeModule& module : modules) {
+      bool a_in = a >= module.base && a < module.base + module.size;
+      bool b_in = b >= module.base && b < module.base + module.size;
+      if (a_in || b_in) {
+        return a_in && b_in;
+      }
+    }
+    return false;
+  }
+};
+
+DECLARE_TEST_RUNNER()
+
+TEST(Symbolize_BatchKeepsOrder) {
+  SymbolCacheTest test;
+  SymbolCache cache(&g_debug);
+
+  std::vector<SymbolInfo> results = cache.Symbolize(
+      {0x7ff800001010, 0x140001204, 0x140001000, 0x140002010});
+  TEST_ASSERT_EQUALS(4, results.size());
+  TEST_ASSERT_EQUALS(std::string("ntdll!RtlUserThreadStart+0x10"),
+                     results[0].ToString());
+  TEST_ASSERT_EQUALS(std::string("ntdll"), results[0].module);
+  TEST_ASSERT_EQUALS(std::string("chrome!MessageLoop::Run+0x4"),
+                     results[1].ToString());
+  TEST_ASSERT_EQUALS(std::string("chrome!WinMain"), results[2].ToString());
+  TEST_ASSERT_EQUALS(0, results[2].displacement);
+  TEST_ASSERT_EQUALS(std::string("chrome!Task::Run"), results[3].name);
+  TEST_ASSERT_EQUALS(0x10, results[3].displacement);
+  TEST_ASSERT(results[3].found);
+}
+
+TEST(Symbolize_AddressesInTheSameFunctionAreCached) {
+  SymbolCacheTest test;
+  SymbolCache cache(&g_debug);
+
+  std::vector<SymbolInfo> results =
+      cache.Symbolize({0x140001210, 0x140001208, 0x140001210, 0x1400011ff});
+  TEST_ASSERT_EQUALS(std::string("chrome!MessageLoop::Run+0x10"),
+                     results[0].ToString());
+  TEST_ASSERT_EQUALS(std::string("chrome!MessageLoop::Run+0x8"),
+                     results[1].ToString());
+  TEST_ASSERT_EQUALS(std::string("chrome!WinMain+0x1ff"),
+                     results[3].ToString());
+  TEST_ASSERT_EQUALS(2, test.name_lookups);
+
+  // Any address within the cached ranges doesn't call the engine.
+  results = cache.Symbolize({0x140001000, 0x1400011f0, 0x140001300});
+  TEST_ASSERT_EQUALS(std::string("chrome!WinMain+0x1f0"),
+                     results[1].ToString());
+  TEST_ASSERT_EQUALS(2, test.name_lookups);
+
+  const symbol_cache::SymbolCacheStats& stats = cache.GetStats();
+  TEST_ASSERT_EQUALS(7, stats.lookups);
+  TEST_ASSERT_EQUALS(5, stats.hits);
+  TEST_ASSERT_EQUALS(2, stats.misses);
+  TEST_ASSERT_EQUALS(1, stats.module_refreshes);
+}
+
+TEST(Symbolize_LastSymbolExtendsToModuleEnd) {
+  SymbolCacheTest test;
+  SymbolCache cache(&g_debug);
+
+  TEST_ASSERT_EQUALS(std::string("chrome!Task::Run+0x100"),
+                     cache.Symbolize(0x140002100).ToString());
+  TEST_ASSERT_EQUALS(std::string("chrome!Task::Run+0x5000"),
+                     cache.Symbolize(0x140007000).ToString());
+  TEST_ASSERT_EQUALS(1, test.name_lookups);
+}
+
+TEST(Symbolize_AddressesWithoutSymbols) {
+  SymbolCacheTest test;
+  SymbolCache cache(&g_debug);
+
+  std::vector<SymbolInfo> results =
+      cache.Symbolize({0x140000010, 0x1234, 0x5678});
+
+  // In a module but before the first symbol.
+  TEST_ASSERT(!results[0].found);
+  TEST_ASSERT_EQUALS(std::string("chrome+0x10"), results[0].ToString());
+
+  // Not in any module. The module table is only reloaded once.
+  TEST_ASSERT(!results[1].found);
+  TEST_ASSERT(results[1].module.empty());
+  TEST_ASSERT_EQUALS(std::string("0x1234"), results[1].ToString());
+  TEST_ASSERT_EQUALS(std::string("0x5678"), results[2].ToString());
+  TEST_ASSERT_EQUALS(2, test.module_table_reads);
+}
+
+TEST(Symbolize_NewModulesAreDetected) {
+  SymbolCacheTest test;
+  SymbolCache cache(&g_debug);
+
+  cache.Symbolize(0x140001000);
+  TEST_ASSERT_EQUALS(1, test.name_lookups);
+
+  test.modules.push_back({0x180000000, 0x1000, "media"});
+  test.symbols[0x180000100] = "media!Decode";
+
+  std::vector<SymbolInfo> results = cache.Symbolize({0x180000104, 0x140001004});
+  TEST_ASSERT_EQUALS(std::string("media!Decode+0x4"), results[0].ToString());
+  TEST_ASSERT_EQUALS(std::string("chrome!WinMain+0x4"), results[1].ToString());
+
+  // The symbols of chrome were kept when the module table was reloaded.
+  TEST_ASSERT_EQUALS(2, test.name_lookups);
+  TEST_ASSERT_EQUALS(2, test.module_table_reads);
+
+  cache.Clear();
+  cache.Symbolize(0x140001004);
+  TEST_ASSERT_EQUALS(3, test.name_lookups);
+}
+
+TEST(Symbolize_ReloadedSymbolsAreDropped) {
+  SymbolCacheTest test;
+  SymbolCache cache(&g_debug);
+
+  // Only the exports were loaded at first.
+  test.symbols = {{0x140001000, "chrome!ChromeMain"},
+                  {0x7ff800001000, "ntdll!RtlUserThreadStart"}};
+  TEST_ASSERT_EQUALS(std::string("chrome!ChromeMain+0x204"),
+                     cache.Symbolize(0x140001204).ToString());
+  TEST_ASSERT_EQUALS(std::string("ntdll!RtlUserThreadStart+0x10"),
+                     cache.Symbolize(0x7ff800001010).ToString());
+
+  // .reload after fixing the symbol path loads the PDB of chrome.
+  test.symbols = {{0x140001000, "chrome!WinMain"},
+                  {0x140001200, "chrome!MessageLoop::Run"},
+                  {0x7ff800001000, "ntdll!RtlUserThreadStart"}};
+  cache.OnChangeSymbolState(DEBUG_CSS_PATHS, 0);
+  TEST_ASSERT_EQUALS(std::string("chrome!ChromeMain+0x204"),
+                     cache.Symbolize(0x140001204).ToString());
+
+  cache.OnChangeSymbolState(DEBUG_CSS_LOADS, 0x140000000);
+  TEST_ASSERT_EQUALS(std::string("chrome!MessageLoop::Run+0x4"),
+                     cache.Symbolize(0x140001204).ToString());
+  TEST_ASSERT_EQUALS(1, cache.GetStats().symbol_reloads);
+
+  // The symbols of the other modules are kept.
+  int lookups = test.name_lookups;
+  cache.Symbolize(0x7ff800001020);
+  TEST_ASSERT_EQUALS(lookups, test.name_lookups);
+
+  // A notification without a module drops the symbols of all of them.
+  cache.OnChangeSymbolState(DEBUG_CSS_UNLOADS, 0);
+  cache.Symbolize(0x7ff800001020);
+  TEST_ASSERT_EQUALS(lookups + 1, test.name_lookups);
+  TEST_ASSERT_EQUALS(3, cache.GetStats().symbol_reloads);
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
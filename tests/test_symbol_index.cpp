@@ -0,0 +1,374 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <dbghelp.h>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "../src/symbol_index.h"
+#include "../src/utils.h"
+#include "debug_interfaces_test_base.h"
+#include "mocks/mock_debug_advanced.h"
+#include "unit_test_runner.h"
+
+utils::DebugInterfaces g_debug;
+
+using symbol_index::FindResult;
+using symbol_index::SymbolIndex;
+
+namespace {
+
+const std::vector<std::pair<std::string, ULONG>> kSymbols = {
+    {"media::MediaFoundationService::IsKeySystemSupported", 0x1000},
+    {"media::MediaFoundationService::MediaFoundationService", 0x1100},
+    {"media::KeySystemSupport", 0x1200},
+    {"content::RenderFrameHostImpl::IsKeySystemSupportedForFrame", 0x2000},
+    {"IsKeySystemSupported", 0x3000},
+    {"base::MessageLoop::Run", 0x4000},
+    {"base::RunLoop::Run", 0x4100},
+    {"mojo::Connector::Accept", 0x5000},
+    {"Foo", 0x6000}};
+
+SymbolIndex CreateIndex() {
+  SymbolIndex index;
+  for (const auto& [name, rva] : kSymbols) {
+    index.Add(name, rva);
+  }
+  index.Finalize();
+  return index;
+}
+
+std::vector<std::string> GetNames(const FindResult& result) {
+  std::vector<std::string> names;
+  for (const auto& match : result.matches) {
+    names.push_back(match.name);
+  }
+  return names;
+}
+
+std::string GetTempDirectory(const std::string& name) {
+  std::filesystem::path path =
+      std::filesystem::temp_directory_path() / ("test_symbol_index_" + name);
+  std::filesystem::remove_all(path);
+  std::filesystem::create_directories(path);
+  return path.string();
+}
+
+bool IsEmptyDirectory(const std::string& directory) {
+  return std::filesystem::is_empty(directory);
+}
+
+}  // namespace
+
+class SymbolIndexTest : public DebugInterfacesTestBase {
+ public:
+  size_t next_match = 0;
+  int symbol_matches_started = 0;
+  std::string last_pattern;
+
+  // The symbols of the module and the PDB they were loaded from.
+  ULONG symbol_type = DEBUG_SYMTYPE_PDB;
+  DWORD pdb_age = 1;
+  // The symbol type after the symbols are enumerated. Deferred
+  // symbols are loaded by the enumeration.
+  ULONG loaded_symbol_type = DEBUG_SYMTYPE_PDB;
+
+  MockDebugAdvanced mock_advanced;
+
+  SymbolIndexTest() : DebugInterfacesTestBase(g_debug) {
+    mock_client->SetMethodOverride(
+        "QueryInterface", [this](REFIID id, PVOID* object) -> HRESULT {
+          if (id != __uuidof(IDebugAdvanced2)) {
+            return E_NOINTERFACE;
+          }
+          *object = static_cast<IDebugAdvanced2*>(&mock_advanced);
+          return S_OK;
+        });
+    mock_advanced.SetMethodOverride(
+        "GetSymbolInformation",
+        [this](ULONG which, ULONG64 base, ULONG arg, PVOID buffer,
+               ULONG buffer_size, PULONG info_size, PSTR string_buffer,
+               ULONG string_buffer_size, PULONG string_size) -> HRESULT {
+          if (which != DEBUG_SYMINFO_IMAGEHLP_MODULEW64 ||
+              buffer_size < sizeof(IMAGEHLP_MODULEW64)) {
+            return E_INVALIDARG;
+          }
+          IMAGEHLP_MODULEW64* info = static_cast<IMAGEHLP_MODULEW64*>(buffer);
+          info->BaseOfImage = base;
+          info->PdbSig70 = {0x1e2f3a4b,
+                            0x5c6d,
+                            0x7e8f,
+                            {0x90, 0xa1, 0xb2, 0xc3, 0xd4, 0xe5, 0xf6, 0x07}};
+          info->PdbAge = pdb_age;
+          return S_OK;
+        });
+    mock_symbols->SetMethodOverride(
+        "GetModuleByModuleName",
+        [](PCSTR name, ULONG start_index, PULONG index,
+           PULONG64 base) -> HRESULT {
+          if (strcmp(name, "chrome") != 0) {
+            return E_INVALIDARG;
+          }
+          *index = 0;
+          *base = 0x140000000;
+          return S_OK;
+        });
+    mock_symbols->SetMethodOverride(
+        "GetModuleParameters",
+        [this](ULONG count, PULONG64 bases, ULONG start,
+               PDEBUG_MODULE_PARAMETERS params) -> HRESULT {
+          params[0] = {};
+          params[0].Base = bases[0];
+          params[0].Size = 0x100000;
+          params[0].TimeDateStamp = 0x65f1a2b3;
+          params[0].Checksum = 0x1234;
+          params[0].SymbolType = symbol_type;
+          return S_OK;
+        });
+    mock_symbols->SetMethodOverride(
+        "StartSymbolMatch", [this](PCSTR pattern, PULONG64 handle) -> HRESULT {
+          symbol_matches_started++;
+          symbol_type = loaded_symbol_type;
+          last_pattern = pattern;
+          next_match = 0;
+          *handle = 1;
+          return S_OK;
+        });
+    mock_symbols->SetMethodOverride(
+        "GetNextSymbolMatch",
+        [this](ULONG64 handle, PSTR buffer, ULONG buffer_size,
+               PULONG match_size, PULONG64 offset) -> HRESULT {
+          if (next_match >= kSymbols.size()) {
+            return E_NOINTERFACE;
+          }
+          std::string name = "chrome!" + kSymbols[next_match].first;
+          strncpy(buffer, name.c_str(), buffer_size);
+          *match_size = static_cast<ULONG>(name.size() + 1);
+          *offset = 0x140000000 + kSymbols[next_match].second;
+          next_match++;
+          return S_OK;
+        });
+    mock_symbols->SetMethodOverride(
+        "EndSymbolMatch", [](ULONG64 handle) -> HRESULT { return S_OK; });
+  }
+};
+
+DECLARE_TEST_RUNNER()
+
+TEST(Find_SubstringIsRankedAndCaseInsensitive) {
+  SymbolIndex index = CreateIndex();
+
+  FindResult result = index.Find("iskeysystemsupported", 10);
+  TEST_ASSERT_EQUALS(3, result.total_matches);
+  std::vector<std::string> names = GetNames(result);
+
+  // Exact name first, then exact last component, then the
+  // last component which only starts with the pattern.
+  TEST_ASSERT_EQUALS(std::string("IsKeySystemSupported"), names[0]);
+  TEST_ASSERT_EQUALS(
+      std::string("media::MediaFoundationService::IsKeySystemSupported"),
+      names[1]);
+  TEST_ASSERT_EQUALS(
+      std::string("content::RenderFrameHostImpl::IsKeySystemSupportedForFrame"),
+      names[2]);
+  TEST_ASSERT_EQUALS(0, result.matches[0].rank);
+  TEST_ASSERT_EQUALS(1, result.matches[1].rank);
+  TEST_ASSERT_EQUALS(2, result.matches[2].rank);
+  TEST_ASSERT_EQUALS(0x3000, result.matches[0].rva);
+}
+
+TEST(Find_Wildcards) {
+  SymbolIndex index = CreateIndex();
+
+  FindResult result = index.Find("base::*::Run", 10);
+  TEST_ASSERT_EQUALS(2, result.total_matches);
+  TEST_ASSERT_EQUALS(std::string("base::RunLoop::Run"), result.matches[0].name);
+
+  // A plain substring matches anywhere but wildcard
+  // patterns are anchored at both ends.
+  TEST_ASSERT_EQUALS(4, index.Find("Support", 10).total_matches);
+  TEST_ASSERT_EQUALS(1, index.Find("media::*Support", 10).total_matches);
+  TEST_ASSERT_EQUALS(1, index.Find("mojo::Connector::Accep?", 10).total_matches);
+  TEST_ASSERT_EQUALS(kSymbols.size(), index.Find("*", 100).total_matches);
+}
+
+TEST(Find_TrigramsLimitCandidates) {
+  SymbolIndex index = CreateIndex();
+
+  FindResult result = index.Find("Connector", 10);
+  TEST_ASSERT_EQUALS(1, result.total_matches);
+  TEST_ASSERT_EQUALS(1, result.candidates);
+
+  // A trigram which isn't in any name.
+  result = index.Find("xyzzy", 10);
+  TEST_ASSERT_EQUALS(0, result.total_matches);
+  TEST_ASSERT_EQUALS(0, result.candidates);
+
+  // Too short for a trigram so every name is checked.
+  result = index.Find("Fo", 10);
+  TEST_ASSERT_EQUALS(kSymbols.size(), result.candidates);
+  TEST_ASSERT_EQUALS(4, result.total_matches);
+  TEST_ASSERT_EQUALS(std::string("Foo"), result.matches[0].name);
+}
+
+TEST(Find_Limit) {
+  SymbolIndex index = CreateIndex();
+
+  FindResult result = index.Find("media", 2);
+  TEST_ASSERT_EQUALS(3, result.total_matches);
+  TEST_ASSERT_EQUALS(2, result.matches.size());
+  // The last component of the constructor starts with "media".
+  TEST_ASSERT_EQUALS(
+      std::string("media::MediaFoundationService::MediaFoundationService"),
+      result.matches[0].name);
+  TEST_ASSERT_EQUALS(std::string("media::KeySystemSupport"),
+                     result.matches[1].name);
+}
+
+TEST(SaveAndLoad) {
+  std::string directory = GetTempDirectory("save");
+  std::string path = directory + "/chrome.symidx";
+
+  SymbolIndex index = CreateIndex();
+  TEST_ASSERT(index.Save(path, "chrome_1"));
+
+  SymbolIndex loaded;
+  TEST_ASSERT(loaded.Load(path, "chrome_1"));
+  TEST_ASSERT_EQUALS(kSymbols.size(), loaded.GetSymbolCount());
+  FindResult result = loaded.Find("RunLoop", 10);
+  TEST_ASSERT_EQUALS(1, result.total_matches);
+  TEST_ASSERT_EQUALS(0x4100, result.matches[0].rva);
+
+  // A different build of the module.
+  SymbolIndex other;
+  TEST_ASSERT(!other.Load(path, "chrome_2"));
+  TEST_ASSERT_EQUALS(0, other.GetSymbolCount());
+
+  // A truncated file.
+  std::filesystem::resize_file(path, std::filesystem::file_size(path) / 2);
+  TEST_ASSERT(!other.Load(path, "chrome_1"));
+  TEST_ASSERT(!other.Load(directory + "/missing.symidx", "chrome_1"));
+
+  std::filesystem::remove_all(directory);
+}
+
+TEST(BuildFromEngine_StripsModule) {
+  SymbolIndexTest test;
+
+  SymbolIndex index;
+  TEST_ASSERT_EQUALS(S_OK, symbol_index::BuildFromEngine(&g_debug, "chrome",
+                                                         0x140000000, index));
+  TEST_ASSERT_EQUALS(std::string("chrome!*"), test.last_pattern);
+  TEST_ASSERT_EQUALS(kSymbols.size(), index.GetSymbolCount());
+
+  FindResult result = index.Find("Accept", 10);
+  TEST_ASSERT_EQUALS(std::string("mojo::Connector::Accept"),
+                     result.matches[0].name);
+  TEST_ASSERT_EQUALS(0x5000, result.matches[0].rva);
+}
+
+TEST(Store_BuildsOnceAndReusesSavedIndex) {
+  SymbolIndexTest test;
+  std::string directory = GetTempDirectory("store");
+
+  symbol_index::ModuleKey key;
+  ULONG64 base = 0;
+  TEST_ASSERT(symbol_index::GetModuleKey(&g_debug, "chrome", base, key));
+  TEST_ASSERT_EQUALS(
+      std::string("chrome_65f1a2b3_00001234_00100000_"
+                  "1E2F3A4B5C6D7E8F90A1B2C3D4E5F6071"),
+      key.ToString());
+
+  {
+    symbol_index::SymbolIndexStore store(&g_debug, directory);
+    auto lookup = store.GetIndex("chrome");
+    TEST_ASSERT(lookup.index != nullptr);
+    TEST_ASSERT_EQUALS(std::string("built"), lookup.source);
+    TEST_ASSERT_EQUALS(0x140000000, lookup.base);
+
+    lookup = store.GetIndex("chrome");
+    TEST_ASSERT_EQUALS(std::string("memory"), lookup.source);
+    TEST_ASSERT_EQUALS(1, test.symbol_matches_started);
+
+    lookup = store.GetIndex("missing");
+    TEST_ASSERT(lookup.index == nullptr);
+    TEST_ASSERT_STRING_CONTAINS(lookup.error, "Module not found");
+  }
+
+  // A new session loads the saved index instead of enumerating symbols.
+  symbol_index::SymbolIndexStore store(&g_debug, directory);
+  auto lookup = store.GetIndex("chrome");
+  TEST_ASSERT_EQUALS(std::string("disk"), lookup.source);
+  TEST_ASSERT_EQUALS(1, test.symbol_matches_started);
+  TEST_ASSERT_EQUALS(1, lookup.index->Find("KeySystemSupport", 1).matches.size());
+
+  std::filesystem::remove_all(directory);
+}
+
+TEST(Store_KeyIncludesPdb) {
+  SymbolIndexTest test;
+  std::string directory = GetTempDirectory("pdb");
+  symbol_index::SymbolIndexStore store(&g_debug, directory);
+
+  TEST_ASSERT_EQUALS(std::string("built"), store.GetIndex("chrome").source);
+
+  // Symbols from another PDB for the same binary are indexed again.
+  test.pdb_age = 2;
+  TEST_ASSERT_EQUALS(std::string("built"), store.GetIndex("chrome").source);
+  TEST_ASSERT_EQUALS(2, test.symbol_matches_started);
+
+  std::filesystem::remove_all(directory);
+}
+
+TEST(Store_IndexWithoutPdbIsNotKept) {
+  SymbolIndexTest test;
+  test.symbol_type = DEBUG_SYMTYPE_EXPORT;
+  test.loaded_symbol_type = DEBUG_SYMTYPE_EXPORT;
+  std::string directory = GetTempDirectory("exports");
+  symbol_index::SymbolIndexStore store(&g_debug, directory);
+
+  auto lookup = store.GetIndex("chrome");
+  TEST_ASSERT(lookup.index != nullptr);
+  TEST_ASSERT_EQUALS(std::string("built"), lookup.source);
+  TEST_ASSERT_STRING_CONTAINS(lookup.warning, "PDB");
+
+  // The export only index is neither kept in memory nor saved.
+  lookup = store.GetIndex("chrome");
+  TEST_ASSERT_EQUALS(std::string("built"), lookup.source);
+  TEST_ASSERT_EQUALS(2, test.symbol_matches_started);
+  TEST_ASSERT(IsEmptyDirectory(directory));
+
+  // After the PDB is found (.reload) the full index is built and kept.
+  test.symbol_type = DEBUG_SYMTYPE_PDB;
+  test.loaded_symbol_type = DEBUG_SYMTYPE_PDB;
+  lookup = store.GetIndex("chrome");
+  TEST_ASSERT_EQUALS(std::string("built"), lookup.source);
+  TEST_ASSERT(lookup.warning.empty());
+  TEST_ASSERT_EQUALS(std::string("memory"), store.GetIndex("chrome").source);
+  TEST_ASSERT(!IsEmptyDirectory(directory));
+
+  std::filesystem::remove_all(directory);
+}
+
+TEST(Store_DeferredSymbolsAreKeptOnceLoaded) {
+  SymbolIndexTest test;
+  test.symbol_type = DEBUG_SYMTYPE_DEFERRED;
+  std::string directory = GetTempDirectory("deferred");
+  symbol_index::SymbolIndexStore store(&g_debug, directory);
+
+  auto lookup = store.GetIndex("chrome");
+  TEST_ASSERT_EQUALS(std::string("built"), lookup.source);
+  TEST_ASSERT(lookup.warning.empty());
+  TEST_ASSERT_EQUALS(std::string("memory"), store.GetIndex("chrome").source);
+  TEST_ASSERT_EQUALS(1, test.symbol_matches_started);
+
+  std::filesystem::remove_all(directory);
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
@@ -0,0 +1,114 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <string>
+#include <vector>
+
+#include "../src/tool_registry.h"
+#include "unit_test_runner.h"
+
+using tool_registry::ToolRegistry;
+
+namespace {
+
+JSON MakeTool(const std::string& name, const std::string& description) {
+  return {{"name", name},
+          {"description", description},
+          {"inputSchema",
+           {{"type", "object"},
+            {"properties", {{"command", {{"type", "string"}}}}},
+            {"required", JSON::array({"command"})}}}};
+}
+
+std::vector<std::string> GetListedNames(ToolRegistry& tools) {
+  std::vector<std::string> names;
+  JSON list = JSON::parse(*tools.GetToolsList());
+  for (const JSON& tool : list["tools"]) {
+    names.push_back(tool["name"].get<std::string>());
+  }
+  return names;
+}
+
+}  // namespace
+
+DECLARE_TEST_RUNNER()
+
+TEST(GetToolsList_CachedUntilChanged) {
+  ToolRegistry tools;
+  TEST_ASSERT_EQUALS(std::string("{\"tools\":[]}"), *tools.GetToolsList());
+
+  TEST_ASSERT(tools.Register(MakeTool("executeCommand", "Run a command")));
+  TEST_ASSERT(tools.Register(MakeTool("evaluate", "Evaluate")));
+  TEST_ASSERT_EQUALS(2, tools.GetVersion());
+
+  std::shared_ptr<const std::string> list = tools.GetToolsList();
+  TEST_ASSERT(list == tools.GetToolsList());
+  JSON parsed = JSON::parse(*list);
+  TEST_ASSERT_EQUALS(MakeTool("executeCommand", "Run a command"),
+                     parsed["tools"][0]);
+
+  // Replacing a tool keeps its position and rebuilds the list. The
+  // list which was returned before isn't changed.
+  TEST_ASSERT(tools.Register(MakeTool("executeCommand", "Run it")));
+  TEST_ASSERT_EQUALS(3, tools.GetVersion());
+  TEST_ASSERT(list != tools.GetToolsList());
+  TEST_ASSERT_EQUALS(parsed, JSON::parse(*list));
+  TEST_ASSERT_EQUALS(
+      std::string("Run it"),
+      JSON::parse(*tools.GetToolsList())["tools"][0]["description"]);
+
+  // Definitions without a name aren't registered.
+  TEST_ASSERT(!tools.Register({{"description", "No name"}}));
+  TEST_ASSERT_EQUALS(3, tools.GetVersion());
+}
+
+TEST(SetEnabled_HidesTool) {
+  ToolRegistry tools;
+  std::vector<uint64_t> changes;
+  tools.SetChangedCallback(
+      [&changes](uint64_t version) { changes.push_back(version); });
+
+  tools.Register(MakeTool("a", "A"));
+  tools.Register(MakeTool("b", "B"));
+  tools.Register(MakeTool("c", "C"));
+
+  TEST_ASSERT(tools.SetEnabled("b", false));
+  TEST_ASSERT(!tools.IsAvailable("b"));
+  TEST_ASSERT(tools.IsAvailable("c"));
+  TEST_ASSERT_EQUALS(2, GetListedNames(tools).size());
+  TEST_ASSERT_EQUALS(std::string("c"), GetListedNames(tools)[1]);
+
+  // Setting the same state again isn't a change.
+  TEST_ASSERT(tools.SetEnabled("b", false));
+  TEST_ASSERT(!tools.SetEnabled("unknown", false));
+  TEST_ASSERT_EQUALS(4, changes.size());
+  TEST_ASSERT_EQUALS(4, changes.back());
+
+  // A disabled tool which is registered again stays disabled.
+  tools.Register(MakeTool("b", "B2"));
+  TEST_ASSERT(!tools.IsAvailable("b"));
+  TEST_ASSERT(tools.SetEnabled("b", true));
+  TEST_ASSERT_EQUALS(std::string("b"), GetListedNames(tools)[1]);
+
+  TEST_ASSERT(tools.Unregister("a"));
+  TEST_ASSERT(!tools.Unregister("a"));
+  TEST_ASSERT(!tools.IsAvailable("a"));
+  TEST_ASSERT_EQUALS(2, tools.GetTools().size());
+  TEST_ASSERT_EQUALS(7, changes.size());
+  TEST_ASSERT_EQUALS(tools.GetVersion(), changes.back());
+}
+
+TEST(Validate_UsesRegisteredSchema) {
+  ToolRegistry tools;
+  tools.Register(MakeTool("executeCommand", "Run a command"));
+
+  TEST_ASSERT_EQUALS(std::string(""),
+                     tools.Validate("executeCommand", {{"command", "k"}}));
+  TEST_ASSERT_EQUALS(std::string("command must be a string"),
+                     tools.Validate("executeCommand", {{"command", 1}}));
+  TEST_ASSERT_EQUALS(std::string(""), tools.Validate("unknown", {}));
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
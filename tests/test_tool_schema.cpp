@@ -0,0 +1,106 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <string>
+
+#include "../src/tool_schema.h"
+#include "unit_test_runner.h"
+
+using tool_schema::ToolSchema;
+
+namespace {
+
+// The input schemas of searchMemory and symbolize from the MCP server.
+ToolSchema MakeSearchMemorySchema() {
+  return ToolSchema(
+      {{"type", "object"},
+       {"properties",
+        {{"type",
+          {{"type", "string"},
+           {"enum", JSON::array({"bytes", "ascii", "utf16", "pointer"})}}},
+         {"pattern", {{"type", "string"}}},
+         {"maxHits", {{"type", "integer"}}},
+         {"startTime", {{"type", "number"}}},
+         {"hash", {{"type", "boolean"}}}}},
+       {"required", JSON::array({"type"})}});
+}
+
+ToolSchema MakeSymbolizeSchema() {
+  return ToolSchema(
+      {{"type", "object"},
+       {"properties",
+        {{"addresses", {{"type", "array"}, {"items", {{"type", "string"}}}}},
+         {"expressions",
+          {{"type", "array"},
+           {"items", {{"anyOf", JSON::array({{{"type", "string"}}})}}}}}}},
+       {"required", JSON::array({"addresses"})}});
+}
+
+}  // namespace
+
+DECLARE_TEST_RUNNER()
+
+TEST(Validate_ValidArguments) {
+  ToolSchema search_memory = MakeSearchMemorySchema();
+
+  TEST_ASSERT_EQUALS(std::string(""),
+                     search_memory.Validate({{"type", "ascii"},
+                                             {"pattern", "widevine"},
+                                             {"maxHits", 10},
+                                             {"startTime", 1.5},
+                                             {"hash", true}}));
+
+  // Integers are numbers.
+  TEST_ASSERT_EQUALS(
+      std::string(""),
+      search_memory.Validate({{"type", "bytes"}, {"startTime", 2}}));
+
+  // Arguments which aren't in the schema are allowed.
+  ToolSchema no_properties({{"type", "object"},
+                            {"properties", JSON::object()}});
+  TEST_ASSERT_EQUALS(std::string(""), no_properties.Validate({{"extra", 1}}));
+}
+
+TEST(Validate_InvalidArguments) {
+  ToolSchema search_memory = MakeSearchMemorySchema();
+  ToolSchema symbolize = MakeSymbolizeSchema();
+
+  TEST_ASSERT_EQUALS(std::string("Missing required argument: type"),
+                     search_memory.Validate(JSON::object()));
+  TEST_ASSERT_EQUALS(
+      std::string("maxHits must be an integer"),
+      search_memory.Validate({{"type", "bytes"}, {"maxHits", "10"}}));
+  TEST_ASSERT_EQUALS(
+      std::string("maxHits must be an integer"),
+      search_memory.Validate({{"type", "bytes"}, {"maxHits", 1.5}}));
+  TEST_ASSERT_EQUALS(
+      std::string("maxHits must be an integer"),
+      search_memory.Validate({{"type", "bytes"}, {"maxHits", 10.0}}));
+  TEST_ASSERT_EQUALS(std::string("hash must be a boolean"),
+                     search_memory.Validate({{"type", "bytes"}, {"hash", 1}}));
+  TEST_ASSERT_EQUALS(
+      std::string("type must be one of: bytes, ascii, utf16, pointer"),
+      search_memory.Validate({{"type", "words"}}));
+  TEST_ASSERT_EQUALS(
+      std::string("Each item of addresses must be a string"),
+      symbolize.Validate({{"addresses", JSON::array({"@rip", 0x1000})}}));
+  TEST_ASSERT_EQUALS(std::string("The arguments must be an object"),
+                     symbolize.Validate("@rip"));
+}
+
+TEST(Validate_UnsupportedKeywordsAcceptAnything) {
+  ToolSchema symbolize = MakeSymbolizeSchema();
+
+  TEST_ASSERT_EQUALS(
+      std::string(""),
+      symbolize.Validate({{"addresses", JSON::array()},
+                          {"expressions", JSON::array({1, "a", nullptr})}}));
+
+  // A schema without properties accepts any object.
+  ToolSchema schema(JSON::object());
+  TEST_ASSERT_EQUALS(std::string(""), schema.Validate({{"a", {1, 2}}}));
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
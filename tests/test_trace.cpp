@@ -0,0 +1,196 @@
+// Copyright (c) 2025 Piet Hein Schouten
+// SPDX-License-Identifier: MIT
+
+#include <algorithm>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../src/trace.h"
+#include "unit_test_runner.h"
+
+namespace {
+
+// The "X" events with the given name.
+std::vector<JSON> FindSpans(const JSON& events, const std::string& name) {
+  std::vector<JSON> spans;
+  for (const JSON& event : events) {
+    if (event["ph"] == "X" && event["name"] == name) {
+      spans.push_back(event);
+    }
+  }
+  return spans;
+}
+
+void Reset() {
+  trace::SetEnabled(false);
+  trace::Clear();
+}
+
+}  // namespace
+
+DECLARE_TEST_RUNNER()
+
+TEST(Span_NotRecordedWhenDisabled) {
+  Reset();
+  {
+    TRACE_SPAN("Disabled");
+    TRACE_SPAN("Disabled with detail", std::string("detail"));
+  }
+  trace::Record("Disabled record", nullptr, 1, 2);
+
+  TEST_ASSERT_EQUALS(0, trace::GetStats().events);
+  TEST_ASSERT(FindSpans(trace::GetEvents("test"), "Disabled").empty());
+}
+
+TEST(Span_RecordsNameDetailAndDuration) {
+  Reset();
+  trace::SetEnabled(true);
+  uint64_t before = trace::NowNs();
+  {
+    TRACE_SPAN("ExecuteCommand", std::string("kc 10"));
+    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+  }
+  {
+    TRACE_SPAN("No detail");
+  }
+  trace::SetEnabled(false);
+
+  JSON events = trace::GetEvents("test");
+  std::vector<JSON> spans = FindSpans(events, "ExecuteCommand");
+  TEST_ASSERT_EQUALS(1, spans.size());
+  TEST_ASSERT_EQUALS(std::string("test"), spans[0]["cat"]);
+  TEST_ASSERT_EQUALS(std::string("kc 10"), spans[0]["args"]["detail"]);
+  TEST_ASSERT(spans[0]["dur"].get<double>() >= 2000.0);
+  TEST_ASSERT(spans[0]["ts"].get<double>() >= before / 1000.0);
+  TEST_ASSERT(spans[0].contains("pid"));
+  TEST_ASSERT(spans[0].contains("tid"));
+
+  spans = FindSpans(events, "No detail");
+  TEST_ASSERT_EQUALS(1, spans.size());
+  TEST_ASSERT(!spans[0].contains("args"));
+}
+
+TEST(Span_TruncatesLongDetails) {
+  Reset();
+  trace::SetEnabled(true);
+  {
+    TRACE_SPAN("Long", std::string(200, 'x'));
+  }
+  trace::Record("Long record", std::string(100, 'y').c_str(), 10, 20);
+  trace::SetEnabled(false);
+
+  JSON events = trace::GetEvents("test");
+  TEST_ASSERT_EQUALS(
+      std::string(trace::kMaxDetailLength, 'x'),
+      FindSpans(events, "Long")[0]["args"]["detail"].get<std::string>());
+
+  JSON record = FindSpans(events, "Long record")[0];
+  TEST_ASSERT_EQUALS(trace::kMaxDetailLength,
+                     record["args"]["detail"].get<std::string>().size());
+  TEST_ASSERT_EQUALS(0.01, record["ts"].get<double>());
+  TEST_ASSERT_EQUALS(0.01, record["dur"].get<double>());
+}
+
+TEST(Span_TruncatesDetailsOnCharacterBoundaries) {
+  Reset();
+  trace::SetEnabled(true);
+  // The 2 byte "\xC3\xA9" (e acute) straddles the limit.
+  std::string detail = std::string(trace::kMaxDetailLength - 1, 'x') +
+                       "\xC3\xA9" + "yz";
+  {
+    TRACE_SPAN("Multibyte", detail);
+  }
+  trace::SetEnabled(false);
+
+  JSON events = trace::GetEvents("test");
+  TEST_ASSERT_EQUALS(
+      std::string(trace::kMaxDetailLength - 1, 'x'),
+      FindSpans(events, "Multibyte")[0]["args"]["detail"].get<std::string>());
+
+  // The events can be serialized.
+  bool thrown = false;
+  try {
+    events.dump();
+  } catch (const JSON::exception&) {
+    thrown = true;
+  }
+  TEST_ASSERT(!thrown);
+}
+
+TEST(Record_OverwritesOldestEventsWhenFull) {
+  Reset();
+  trace::SetEnabled(true);
+  for (uint64_t i = 0; i < trace::kEventsPerThread + 10; i++) {
+    trace::Record("Event", nullptr, i * 1000, i * 1000 + 1);
+  }
+  trace::SetEnabled(false);
+
+  trace::TraceStats stats = trace::GetStats();
+  TEST_ASSERT_EQUALS(trace::kEventsPerThread, stats.events);
+  TEST_ASSERT_EQUALS(10, stats.dropped);
+
+  // The oldest remaining event comes first.
+  std::vector<JSON> spans = FindSpans(trace::GetEvents("test"), "Event");
+  TEST_ASSERT_EQUALS(trace::kEventsPerThread, spans.size());
+  TEST_ASSERT_EQUALS(10.0, spans.front()["ts"].get<double>());
+
+  trace::Clear();
+  TEST_ASSERT_EQUALS(0, trace::GetStats().events);
+}
+
+TEST(GetEvents_SeparatesThreads) {
+  Reset();
+  trace::SetEnabled(true);
+
+  std::vector<std::thread> threads;
+  for (int i = 0; i < 4; i++) {
+    threads.emplace_back([i]() {
+      trace::SetThreadName("Worker " + std::to_string(i));
+      for (int j = 0; j < 100; j++) {
+        TRACE_SPAN("Work");
+      }
+    });
+  }
+  for (std::thread& thread : threads) {
+    thread.join();
+  }
+  trace::SetEnabled(false);
+
+  // The events of threads which have exited are kept.
+  JSON events = trace::GetEvents("test");
+  std::vector<JSON> spans = FindSpans(events, "Work");
+  TEST_ASSERT_EQUALS(400, spans.size());
+
+  std::vector<uint64_t> thread_ids;
+  int thread_names = 0;
+  for (const JSON& event : events) {
+    if (event["ph"] == "M" && event["name"] == "thread_name") {
+      TEST_ASSERT_STRING_CONTAINS(event["args"]["name"].get<std::string>(),
+                                  "Worker ");
+      thread_ids.push_back(event["tid"].get<uint64_t>());
+      thread_names++;
+    }
+  }
+  TEST_ASSERT_EQUALS(4, thread_names);
+  for (const JSON& span : spans) {
+    TEST_ASSERT(std::find(thread_ids.begin(), thread_ids.end(),
+                          span["tid"].get<uint64_t>()) != thread_ids.end());
+  }
+
+  // Clearing drops the buffers of the exited threads.
+  trace::Clear();
+  TEST_ASSERT(trace::GetStats().threads <= 1);
+}
+
+TEST(ToChromeTrace_WrapsEvents) {
+  JSON trace_object = trace::ToChromeTrace(JSON::array({{{"name", "a"}}}));
+  TEST_ASSERT(trace_object["traceEvents"].is_array());
+  TEST_ASSERT_EQUALS(1, trace_object["traceEvents"].size());
+  TEST_ASSERT_EQUALS(std::string("ms"), trace_object["displayTimeUnit"]);
+}
+
+int main() {
+  return RUN_ALL_TESTS();
+}
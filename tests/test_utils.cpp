@@ -1,7 +1,12 @@
 // Copyright (c) 2025 Piet Hein Schouten
 // SPDX-License-Identifier: MIT
 
+#include <cstring>
+#include <vector>
+
 #include "../src/utils.h"
+#include "debug_interfaces_test_base.h"
+#include "mocks/fake_target_memory.h"
 #include "unit_test_runner.h"
 
 // Forward declarations of globals and functions from utils.cpp
@@ -199,6 +204,28 @@ TEST(ParseCommandLine_ForwardSlashPathPassedThroughAsIs) {
   TEST_ASSERT_EQUALS("C:/path/to/file.txt", args[0]);
 }
 
+//
+// ParseUInt32 tests
+//
+
+TEST(ParseUInt32_ValidNumbers) {
+  uint32_t value = 1;
+  TEST_ASSERT(utils::ParseUInt32("0", value));
+  TEST_ASSERT_EQUALS(0, value);
+  TEST_ASSERT(utils::ParseUInt32("4294967295", value));
+  TEST_ASSERT_EQUALS(4294967295u, value);
+}
+
+TEST(ParseUInt32_RejectsNumbersWhichDontFit) {
+  uint32_t value = 7;
+  TEST_ASSERT(!utils::ParseUInt32("4294967296", value));
+  TEST_ASSERT(!utils::ParseUInt32("99999999999999999999999999", value));
+  TEST_ASSERT(!utils::ParseUInt32("", value));
+  TEST_ASSERT(!utils::ParseUInt32("-1", value));
+  TEST_ASSERT(!utils::ParseUInt32("10ms", value));
+  TEST_ASSERT_EQUALS(7, value);
+}
+
 //
 // ConvertToBreakpointFilePath tests
 //
@@ -306,6 +333,315 @@ TEST(ConvertToBreakpointFilePath_ExistingFileWithCheck) {
   TEST_ASSERT_EQUALS("C:\\\\Windows\\\\System32\\\\kernel32.dll", result);
 }
 
+//
+// MemoryReadCache tests
+//
+
+utils::DebugInterfaces g_debug;
+
+class MemoryReadCacheTest : public DebugInterfacesTestBase {
+ public:
+  static constexpr ULONG kPageSize = utils::MemoryReadCache::kPageSize;
+
+  FakeTargetMemory memory;
+  ULONG process_id = 100;
+
+  MemoryReadCacheTest() : DebugInterfacesTestBase(g_debug) {
+    memory.Install(mock_data_spaces);
+
+    mock_system_objects->SetMethodOverride(
+        "GetCurrentProcessSystemId", [this](PULONG id) -> HRESULT {
+          *id = process_id;
+          return S_OK;
+        });
+
+    mock_data_spaces->SetMethodOverride(
+        "WriteVirtual", [this](ULONG64 offset, PVOID buffer, ULONG buffer_size,
+                               PULONG bytes_written) -> HRESULT {
+          if (!memory.Write(offset, buffer, buffer_size)) {
+            return E_FAIL;
+          }
+          if (bytes_written) {
+            *bytes_written = buffer_size;
+          }
+          return S_OK;
+        });
+  }
+
+  // Adds pages whose bytes are (page index + offset) & 0xFF.
+  void AddPatternPages(ULONG64 base, size_t page_count) {
+    std::vector<BYTE> bytes(page_count * kPageSize);
+    for (size_t i = 0; i < bytes.size(); i++) {
+      bytes[i] = static_cast<BYTE>((i / kPageSize + i) & 0xFF);
+    }
+    memory.AddRegion(base, bytes);
+  }
+
+  static BYTE PatternByte(ULONG64 base, ULONG64 address) {
+    ULONG64 i = address - base;
+    return static_cast<BYTE>((i / kPageSize + i) & 0xFF);
+  }
+};
+
+TEST(MemoryReadCache_RepeatedReadsHitTheCache) {
+  MemoryReadCacheTest test;
+  test.AddPatternPages(0x10000, 4);
+  utils::MemoryReadCache cache(&g_debug);
+
+  BYTE buffer[16];
+  ULONG bytes_read = 0;
+  for (int i = 0; i < 10; i++) {
+    HRESULT hr = cache.ReadVirtual(0x10010 + i, buffer, sizeof(buffer),
+                                   &bytes_read);
+    TEST_ASSERT_EQUALS(S_OK, hr);
+    TEST_ASSERT_EQUALS(sizeof(buffer), bytes_read);
+    TEST_ASSERT_EQUALS(MemoryReadCacheTest::PatternByte(0x10000, 0x10010 + i),
+                       buffer[0]);
+  }
+
+  TEST_ASSERT_EQUALS(1, test.memory.GetReadCount());
+  TEST_ASSERT_EQUALS(1, cache.GetStatistics().misses);
+  TEST_ASSERT_EQUALS(9, cache.GetStatistics().hits);
+  TEST_ASSERT_EQUALS(1, cache.GetStatistics().target_reads);
+}
+
+TEST(MemoryReadCache_ReadSpanningPagesIsCoalesced) {
+  MemoryReadCacheTest test;
+  test.AddPatternPages(0x10000, 8);
+  utils::MemoryReadCache cache(&g_debug, 4096, 0);
+
+  // Spans three pages
+  std::vector<BYTE> buffer(2 * MemoryReadCacheTest::kPageSize + 8);
+  ULONG bytes_read = 0;
+  HRESULT hr = cache.ReadVirtual(0x10FF0, buffer.data(),
+                                 static_cast<ULONG>(buffer.size()),
+                                 &bytes_read);
+  TEST_ASSERT_EQUALS(S_OK, hr);
+  TEST_ASSERT_EQUALS(buffer.size(), bytes_read);
+  TEST_ASSERT_EQUALS(1, test.memory.GetReadCount());
+  TEST_ASSERT_EQUALS(3, cache.GetStatistics().misses);
+
+  for (size_t i = 0; i < buffer.size(); i++) {
+    TEST_ASSERT_EQUALS(MemoryReadCacheTest::PatternByte(0x10000, 0x10FF0 + i),
+                       buffer[i]);
+  }
+}
+
+TEST(MemoryReadCache_MissingPagesAroundCachedPageAreReadSeparately) {
+  MemoryReadCacheTest test;
+  test.AddPatternPages(0x10000, 8);
+  utils::MemoryReadCache cache(&g_debug, 4096, 0);
+
+  BYTE byte = 0;
+  cache.ReadVirtual(0x11000, &byte, 1, nullptr);
+  test.memory.ResetReadCount();
+
+  std::vector<BYTE> buffer(3 * MemoryReadCacheTest::kPageSize);
+  ULONG bytes_read = 0;
+  cache.ReadVirtual(0x10000, buffer.data(), static_cast<ULONG>(buffer.size()),
+                    &bytes_read);
+  TEST_ASSERT_EQUALS(buffer.size(), bytes_read);
+  TEST_ASSERT_EQUALS(2, test.memory.GetReadCount());
+  TEST_ASSERT_EQUALS(MemoryReadCacheTest::PatternByte(0x10000, 0x12FFF),
+                     buffer.back());
+}
+
+TEST(MemoryReadCache_PrefetchesAdjacentPages) {
+  MemoryReadCacheTest test;
+  test.AddPatternPages(0x10000, 4);
+  utils::MemoryReadCache cache(&g_debug, 4096, 2);
+
+  BYTE buffer[8];
+  ULONG bytes_read = 0;
+  cache.ReadVirtual(0x10000, buffer, sizeof(buffer), &bytes_read);
+  TEST_ASSERT_EQUALS(3, cache.GetCachedPageCount());
+  TEST_ASSERT_EQUALS(2, cache.GetStatistics().prefetched_pages);
+
+  // The prefetched pages are served from the cache
+  cache.ReadVirtual(0x11000, buffer, sizeof(buffer), &bytes_read);
+  cache.ReadVirtual(0x12FF8, buffer, sizeof(buffer), &bytes_read);
+  TEST_ASSERT_EQUALS(1, test.memory.GetReadCount());
+  TEST_ASSERT_EQUALS(MemoryReadCacheTest::PatternByte(0x10000, 0x12FF8),
+                     buffer[0]);
+}
+
+TEST(MemoryReadCache_PartialRead) {
+  MemoryReadCacheTest test;
+  test.AddPatternPages(0x10000, 1);
+  utils::MemoryReadCache cache(&g_debug);
+
+  // The second half of the read is not readable
+  BYTE buffer[32];
+  ULONG bytes_read = 0;
+  HRESULT hr = cache.ReadVirtual(0x10FF0, buffer, sizeof(buffer), &bytes_read);
+  TEST_ASSERT_EQUALS(S_OK, hr);
+  TEST_ASSERT_EQUALS(16, bytes_read);
+
+  // Reading again gives the same result without reading the target
+  test.memory.ResetReadCount();
+  hr = cache.ReadVirtual(0x10FF0, buffer, sizeof(buffer), &bytes_read);
+  TEST_ASSERT_EQUALS(S_OK, hr);
+  TEST_ASSERT_EQUALS(16, bytes_read);
+  TEST_ASSERT_EQUALS(0, test.memory.GetReadCount());
+}
+
+TEST(MemoryReadCache_FailedPrefetchIsReadAgainWithoutIt) {
+  MemoryReadCacheTest test;
+  test.AddPatternPages(0x10000, 1);
+  test.memory.SetFailPartialReads(true);
+  utils::MemoryReadCache cache(&g_debug, 4096, 2);
+
+  // The prefetched pages past the end of the region make the first
+  // read fail but the requested page is readable
+  BYTE buffer[8];
+  ULONG bytes_read = 0;
+  HRESULT hr = cache.ReadVirtual(0x10FF8, buffer, sizeof(buffer), &bytes_read);
+  TEST_ASSERT_EQUALS(S_OK, hr);
+  TEST_ASSERT_EQUALS(8, bytes_read);
+  TEST_ASSERT_EQUALS(MemoryReadCacheTest::PatternByte(0x10000, 0x10FF8),
+                     buffer[0]);
+  TEST_ASSERT_EQUALS(2, test.memory.GetReadCount());
+
+  // The page is cached as readable
+  hr = cache.ReadVirtual(0x10000, buffer, sizeof(buffer), &bytes_read);
+  TEST_ASSERT_EQUALS(S_OK, hr);
+  TEST_ASSERT_EQUALS(8, bytes_read);
+  TEST_ASSERT_EQUALS(2, test.memory.GetReadCount());
+}
+
+TEST(MemoryReadCache_FailedReadIsReadAgainPerPage) {
+  MemoryReadCacheTest test;
+  test.AddPatternPages(0x10000, 1);
+  test.memory.SetFailPartialReads(true);
+  utils::MemoryReadCache cache(&g_debug, 4096, 0);
+
+  // Only the first of the two requested pages is readable
+  BYTE buffer[32];
+  ULONG bytes_read = 0;
+  HRESULT hr = cache.ReadVirtual(0x10FF0, buffer, sizeof(buffer), &bytes_read);
+  TEST_ASSERT_EQUALS(S_OK, hr);
+  TEST_ASSERT_EQUALS(16, bytes_read);
+  TEST_ASSERT_EQUALS(MemoryReadCacheTest::PatternByte(0x10000, 0x10FF0),
+                     buffer[0]);
+}
+
+TEST(MemoryReadCache_UnreadableMemory) {
+  MemoryReadCacheTest test;
+  utils::MemoryReadCache cache(&g_debug);
+
+  BYTE buffer[8];
+  ULONG bytes_read = 123;
+  HRESULT hr = cache.ReadVirtual(0x50000, buffer, sizeof(buffer), &bytes_read);
+  TEST_ASSERT(FAILED(hr));
+  TEST_ASSERT_EQUALS(0, bytes_read);
+}
+
+TEST(MemoryReadCache_PagesAreKeyedByProcess) {
+  MemoryReadCacheTest test;
+  test.AddPatternPages(0x10000, 1);
+  utils::MemoryReadCache cache(&g_debug, 4096, 0);
+
+  BYTE buffer[8];
+  cache.ReadVirtual(0x10000, buffer, sizeof(buffer), nullptr);
+  test.process_id = 200;
+  cache.ReadVirtual(0x10000, buffer, sizeof(buffer), nullptr);
+  test.process_id = 100;
+  cache.ReadVirtual(0x10000, buffer, sizeof(buffer), nullptr);
+
+  TEST_ASSERT_EQUALS(2, test.memory.GetReadCount());
+  TEST_ASSERT_EQUALS(2, cache.GetCachedPageCount());
+}
+
+TEST(MemoryReadCache_LargeReadsBypassTheCache) {
+  MemoryReadCacheTest test;
+  test.AddPatternPages(0x100000, 32);
+  utils::MemoryReadCache cache(&g_debug);
+
+  std::vector<BYTE> buffer(utils::MemoryReadCache::kMaxCachedReadSize + 1);
+  ULONG bytes_read = 0;
+  HRESULT hr = cache.ReadVirtual(0x100000, buffer.data(),
+                                 static_cast<ULONG>(buffer.size()),
+                                 &bytes_read);
+  TEST_ASSERT_EQUALS(S_OK, hr);
+  TEST_ASSERT_EQUALS(buffer.size(), bytes_read);
+  TEST_ASSERT_EQUALS(0, cache.GetCachedPageCount());
+  TEST_ASSERT_EQUALS(1, cache.GetStatistics().uncached_reads);
+}
+
+TEST(MemoryReadCache_ExecutionStatusChangeInvalidates) {
+  MemoryReadCacheTest test;
+  test.AddPatternPages(0x10000, 1);
+  utils::MemoryReadCache cache(&g_debug);
+
+  BYTE value = 0;
+  cache.ReadVirtual(0x10000, &value, 1, nullptr);
+  TEST_ASSERT_EQUALS(0, value);
+
+  // The target runs and modifies its memory
+  BYTE new_value = 0x42;
+  test.memory.Write(0x10000, &new_value, 1);
+
+  ULONG64 generation = cache.GetGeneration();
+  cache.OnChangeEngineState(DEBUG_CES_EXECUTION_STATUS, DEBUG_STATUS_GO);
+  TEST_ASSERT(cache.GetGeneration() > generation);
+  TEST_ASSERT_EQUALS(0, cache.GetCachedPageCount());
+
+  cache.ReadVirtual(0x10000, &value, 1, nullptr);
+  TEST_ASSERT_EQUALS(0x42, value);
+}
+
+TEST(MemoryReadCache_OtherEngineStateChangesDoNotInvalidate) {
+  MemoryReadCacheTest test;
+  test.AddPatternPages(0x10000, 1);
+  utils::MemoryReadCache cache(&g_debug);
+
+  BYTE value = 0;
+  cache.ReadVirtual(0x10000, &value, 1, nullptr);
+  cache.OnChangeEngineState(DEBUG_CES_BREAKPOINTS, 0);
+  cache.OnChangeDebuggeeState(DEBUG_CDS_REGISTERS, 0);
+  TEST_ASSERT_EQUALS(0, cache.GetStatistics().invalidations);
+  TEST_ASSERT(cache.GetCachedPageCount() > 0);
+
+  cache.OnChangeDebuggeeState(DEBUG_CDS_DATA, DEBUG_DATA_SPACE_VIRTUAL);
+  TEST_ASSERT_EQUALS(1, cache.GetStatistics().invalidations);
+  TEST_ASSERT_EQUALS(0, cache.GetCachedPageCount());
+}
+
+TEST(MemoryReadCache_WriteVirtualInvalidates) {
+  MemoryReadCacheTest test;
+  test.AddPatternPages(0x10000, 1);
+  utils::MemoryReadCache cache(&g_debug);
+
+  BYTE value = 0;
+  cache.ReadVirtual(0x10004, &value, 1, nullptr);
+
+  BYTE new_value = 0xCC;
+  ULONG bytes_written = 0;
+  HRESULT hr = cache.WriteVirtual(0x10004, &new_value, 1, &bytes_written);
+  TEST_ASSERT_EQUALS(S_OK, hr);
+  TEST_ASSERT(test.mock_data_spaces->WasCalled("WriteVirtual"));
+
+  cache.ReadVirtual(0x10004, &value, 1, nullptr);
+  TEST_ASSERT_EQUALS(0xCC, value);
+}
+
+TEST(MemoryReadCache_EvictsWhenFull) {
+  MemoryReadCacheTest test;
+  test.AddPatternPages(0x10000, 64);
+  utils::MemoryReadCache cache(&g_debug, 20, 0);
+
+  BYTE buffer[8];
+  for (ULONG64 page = 0; page < 64; page++) {
+    ULONG bytes_read = 0;
+    ULONG64 address = 0x10000 + page * MemoryReadCacheTest::kPageSize;
+    cache.ReadVirtual(address, buffer, sizeof(buffer), &bytes_read);
+    TEST_ASSERT_EQUALS(sizeof(buffer), bytes_read);
+    TEST_ASSERT_EQUALS(MemoryReadCacheTest::PatternByte(0x10000, address),
+                       buffer[0]);
+    TEST_ASSERT(cache.GetCachedPageCount() <= 20);
+  }
+}
+
 int main() {
   return RUN_ALL_TESTS();
 }